@@ -13,6 +13,9 @@
 #if USE_WOLFSSL
 #include "azure_c_shared_utility/tlsio_wolfssl.h"
 #endif
+#ifdef USE_MBED_TLS
+#include "azure_c_shared_utility/tlsio_mbedtls.h"
+#endif
 
 #include <stdlib.h>
 #include <unistd.h>
@@ -25,6 +28,15 @@ int platform_init(void)
     result = tlsio_openssl_init();
 #else
     result = 0;
+#endif
+#ifdef USE_MBED_TLS
+    if ((result == 0) &&
+        ((result = tlsio_mbedtls_init()) != 0))
+    {
+#ifdef USE_OPENSSL
+        tlsio_openssl_deinit();
+#endif
+    }
 #endif
     return result;
 }
@@ -62,6 +74,9 @@ STRING_HANDLE platform_get_platform_info(void)
 
 void platform_deinit(void)
 {
+#ifdef USE_MBED_TLS
+    tlsio_mbedtls_deinit();
+#endif
 #ifdef USE_OPENSSL
     tlsio_openssl_deinit();
 #endif
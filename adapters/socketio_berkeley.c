@@ -18,6 +18,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
@@ -25,6 +26,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <poll.h>
 #ifdef TIZENRT
 #include <net/lwip/tcp.h>
 #else
@@ -85,6 +87,7 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     char* target_mac_address;
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
+    bool receive_handed_off;
     unsigned char recv_bytes[RECEIVE_BYTES_VALUE];
 } SOCKET_IO_INSTANCE;
 
@@ -176,6 +179,66 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
     return result;
 }
 
+static int socketio_wait(CONCRETE_IO_HANDLE socket_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: SOCKET_IO_INSTANCE is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if ((socket_io_instance->io_state != IO_STATE_OPEN) ||
+            (socket_io_instance->socket == INVALID_SOCKET))
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct pollfd poll_fd;
+            int poll_result;
+
+            poll_fd.fd = socket_io_instance->socket;
+            poll_fd.events = 0;
+            poll_fd.revents = 0;
+
+            if ((interest & IO_WAIT_READ) != 0)
+            {
+                poll_fd.events |= POLLIN;
+            }
+
+            /* queued sends are flushed by dowork, so wake up as soon as they can make progress */
+            if (((interest & IO_WAIT_WRITE) != 0) ||
+                (singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL))
+            {
+                poll_fd.events |= POLLOUT;
+            }
+
+            do
+            {
+                poll_result = poll(&poll_fd, 1, (int)timeout_ms);
+            } while ((poll_result < 0) && (errno == EINTR));
+
+            if (poll_result < 0)
+            {
+                LogError("Failure: poll failure. errno=%d (%s).", errno, strerror(errno));
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* readiness, hang-up and errors are all picked up by the next socketio_dowork */
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION socket_io_interface_description = 
 {
     socketio_retrieveoptions,
@@ -185,7 +248,8 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_wait
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -516,6 +580,7 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
                     result->on_bytes_received_context = NULL;
                     result->on_io_error_context = NULL;
                     result->io_state = IO_STATE_CLOSED;
+                    result->receive_handed_off = false;
                 }
             }
         }
@@ -583,6 +648,7 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
         else if (socket_io_instance->socket != INVALID_SOCKET)
         {
             // Opening an accepted socket
+            socket_io_instance->receive_handed_off = false;
             socket_io_instance->on_bytes_received_context = on_bytes_received_context;
             socket_io_instance->on_bytes_received = on_bytes_received;
             socket_io_instance->on_io_error = on_io_error;
@@ -710,6 +776,7 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
                                 socket_io_instance->on_io_error_context = on_io_error_context;
 
                                 socket_io_instance->io_state = IO_STATE_OPEN;
+                                socket_io_instance->receive_handed_off = false;
 
                                 result = 0;
                             }
@@ -913,7 +980,9 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
             first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
         }
 
-        if (socket_io_instance->io_state == IO_STATE_OPEN)
+        /* once the descriptor was handed off, the layer above reads from it directly */
+        if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+            !socket_io_instance->receive_handed_off)
         {
             int received = 0;
             do
@@ -991,6 +1060,29 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
             result = setsockopt(socket_io_instance->socket, SOL_TCP, TCP_KEEPINTVL, value, sizeof(int));
             if (result == -1) result = errno;
         }
+        else if (strcmp(optionName, OPTION_SOCKET_DESCRIPTOR_HANDOFF) == 0)
+        {
+            if (socket_io_instance->io_state != IO_STATE_OPEN)
+            {
+                LogError("Failure: socket descriptor can only be handed off while open.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* value is where the descriptor is returned; from now on socketio_dowork does not recv */
+#ifdef SO_NOSIGPIPE
+                /* the new owner writes without MSG_NOSIGNAL where only SO_NOSIGPIPE exists, so a peer reset must not raise SIGPIPE */
+                int no_sigpipe = 1;
+                if (setsockopt(socket_io_instance->socket, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe)) != 0)
+                {
+                    LogError("Failure: setting SO_NOSIGPIPE on the handed off socket failed. errno=%d (%s).", errno, strerror(errno));
+                }
+#endif
+                *(int*)value = socket_io_instance->socket;
+                socket_io_instance->receive_handed_off = true;
+                result = 0;
+            }
+        }
         else if (strcmp(optionName, OPTION_NET_INT_MAC_ADDRESS) == 0)
         {
 #ifdef __APPLE__
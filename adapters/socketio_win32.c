@@ -78,6 +78,68 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
     return result;
 }
 
+static int socketio_wait(CONCRETE_IO_HANDLE socket_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: socket_io is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if ((socket_io_instance->io_state != IO_STATE_OPEN) ||
+            (socket_io_instance->socket == INVALID_SOCKET))
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            fd_set read_fds;
+            fd_set write_fds;
+            fd_set error_fds;
+            struct timeval tv;
+
+            FD_ZERO(&read_fds);
+            FD_ZERO(&write_fds);
+            FD_ZERO(&error_fds);
+
+            if ((interest & IO_WAIT_READ) != 0)
+            {
+                FD_SET(socket_io_instance->socket, &read_fds);
+            }
+
+            /* queued sends are flushed by dowork, so wake up as soon as they can make progress */
+            if (((interest & IO_WAIT_WRITE) != 0) ||
+                (singlylinkedlist_get_head_item(socket_io_instance->pending_io_list) != NULL))
+            {
+                FD_SET(socket_io_instance->socket, &write_fds);
+            }
+
+            FD_SET(socket_io_instance->socket, &error_fds);
+
+            tv.tv_sec = (long)(timeout_ms / 1000);
+            tv.tv_usec = (long)((timeout_ms % 1000) * 1000);
+
+            if (select(0, &read_fds, &write_fds, &error_fds, &tv) == SOCKET_ERROR)
+            {
+                LogError("Failure: select failure %d.", WSAGetLastError());
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* readiness and errors are all picked up by the next socketio_dowork */
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
 {
     socketio_retrieveoptions,
@@ -87,7 +149,8 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_wait
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -29,3 +29,9 @@ void ThreadAPI_Sleep(unsigned int milliseconds)
 {
 	vTaskDelay(milliseconds);
 }
+
+THREADAPI_RESULT ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+    LogError("ESP8266 RTOS does not support per-thread processor time.");
+    return THREADAPI_ERROR;
+}
@@ -135,3 +135,36 @@ void ThreadAPI_Sleep(unsigned int milliseconds)
     (void)nanosleep(&timeToSleep, NULL);
 #endif
 }
+
+THREADAPI_RESULT ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+    THREADAPI_RESULT result;
+
+    if (cpu_time_us == NULL)
+    {
+        result = THREADAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+    }
+    else
+    {
+#if defined(TI_RTOS) || !defined(CLOCK_THREAD_CPUTIME_ID)
+        result = THREADAPI_ERROR;
+        LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+#else
+        struct timespec cpu_time;
+
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_time) != 0)
+        {
+            result = THREADAPI_ERROR;
+            LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+        }
+        else
+        {
+            *cpu_time_us = ((uint64_t)cpu_time.tv_sec * 1000000) + ((uint64_t)cpu_time.tv_nsec / 1000);
+            result = THREADAPI_OK;
+        }
+#endif
+    }
+
+    return result;
+}
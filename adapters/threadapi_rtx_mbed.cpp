@@ -138,3 +138,10 @@ void ThreadAPI_Sleep(unsigned int millisec)
     }
     Thread::wait(remainderOfThirtySeconds);
 }
+
+THREADAPI_RESULT ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+    (void)cpu_time_us;
+    LogError("mbed does not support per-thread processor time.");
+    return THREADAPI_ERROR;
+}
@@ -83,3 +83,33 @@ void ThreadAPI_Sleep(unsigned int milliseconds)
 {
     Sleep(milliseconds);
 }
+
+THREADAPI_RESULT ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+    THREADAPI_RESULT result;
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+
+    if (cpu_time_us == NULL)
+    {
+        result = THREADAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+    }
+    else if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time))
+    {
+        result = THREADAPI_ERROR;
+        LogError("GetThreadTimes failed, GetLastError=%lu", (unsigned long)GetLastError());
+    }
+    else
+    {
+        /* FILETIME counts 100 ns intervals */
+        uint64_t kernel_100ns = ((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+        uint64_t user_100ns = ((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+        *cpu_time_us = (kernel_100ns + user_100ns) / 10;
+        result = THREADAPI_OK;
+    }
+
+    return result;
+}
@@ -12,20 +12,22 @@
 
 typedef struct TICK_COUNTER_INSTANCE_TAG
 {
-    time_t init_time_value;
+    struct timespec init_time_value;
     tickcounter_ms_t current_ms;
 } TICK_COUNTER_INSTANCE;
 
 TICK_COUNTER_HANDLE tickcounter_create(void)
 {
+    /* Codes_SRS_TICKCOUNTER_LINUX_11_001: [ `tickcounter_create` shall allocate a TICK_COUNTER_INSTANCE and record the current time obtained by calling `get_time_ns`. ]*/
     TICK_COUNTER_INSTANCE* result = (TICK_COUNTER_INSTANCE*)malloc(sizeof(TICK_COUNTER_INSTANCE));
+    /* Codes_SRS_TICKCOUNTER_LINUX_11_002: [ If allocating the instance fails, `tickcounter_create` shall return NULL. ]*/
     if (result != NULL)
     {
         set_time_basis();
 
-        result->init_time_value = get_time_s();
-        if (result->init_time_value == INVALID_TIME_VALUE)
+        if (get_time_ns(&result->init_time_value) != 0)
         {
+            /* Codes_SRS_TICKCOUNTER_LINUX_11_003: [ If `get_time_ns` fails, `tickcounter_create` shall free the instance and return NULL. ]*/
             LogError("tickcounter failed: time return INVALID_TIME.");
             free(result);
             result = NULL;
@@ -40,8 +42,10 @@ TICK_COUNTER_HANDLE tickcounter_create(void)
 
 void tickcounter_destroy(TICK_COUNTER_HANDLE tick_counter)
 {
+    /* Codes_SRS_TICKCOUNTER_LINUX_11_005: [ If the `tick_counter` parameter is NULL, `tickcounter_destroy` shall do nothing. ]*/
     if (tick_counter != NULL)
     {
+        /* Codes_SRS_TICKCOUNTER_LINUX_11_004: [ `tickcounter_destroy` shall free the instance. ]*/
         free(tick_counter);
     }
 }
@@ -50,6 +54,8 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
 {
     int result;
 
+    /* Codes_SRS_TICKCOUNTER_LINUX_11_006: [ If the `tick_counter` parameter is NULL, `tickcounter_get_current_ms` shall return a non-zero value. ]*/
+    /* Codes_SRS_TICKCOUNTER_LINUX_11_007: [ If the `current_ms` parameter is NULL, `tickcounter_get_current_ms` shall return a non-zero value. ]*/
     if (tick_counter == NULL || current_ms == NULL)
     {
         LogError("tickcounter failed: Invalid Arguments.");
@@ -57,15 +63,22 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
     }
     else
     {
-        time_t time_value = get_time_s();
-        if (time_value == INVALID_TIME_VALUE)
+        struct timespec time_value;
+        if (get_time_ns(&time_value) != 0)
         {
+            /* Codes_SRS_TICKCOUNTER_LINUX_11_008: [ If `get_time_ns` fails, `tickcounter_get_current_ms` shall return a non-zero value. ]*/
+            LogError("tickcounter failed: unable to get the current time.");
             result = __FAILURE__;
         }
         else
         {
+            /* Codes_SRS_TICKCOUNTER_LINUX_11_009: [ `tickcounter_get_current_ms` shall set `*current_ms` to the number of whole milliseconds elapsed since `tickcounter_create`, computed from both the seconds and the nanoseconds of the two times, and return 0. ]*/
+            /* Codes_SRS_TICKCOUNTER_LINUX_11_010: [ The elapsed time shall be correct when the nanoseconds of the current time are smaller than those recorded by `tickcounter_create`. ]*/
+            /* Codes_SRS_TICKCOUNTER_LINUX_11_011: [ The elapsed milliseconds shall be truncated to `tickcounter_ms_t`, so that the counter wraps around to 0 and the unsigned difference of two readings stays correct across a wrap. ]*/
             TICK_COUNTER_INSTANCE* tick_counter_instance = (TICK_COUNTER_INSTANCE*)tick_counter;
-            tick_counter_instance->current_ms = (tickcounter_ms_t)(difftime(time_value, tick_counter_instance->init_time_value) * 1000);
+            int64_t elapsed_ms = ((int64_t)(time_value.tv_sec - tick_counter_instance->init_time_value.tv_sec) * MILLISECONDS_IN_1_SECOND) +
+                ((int64_t)(time_value.tv_nsec - tick_counter_instance->init_time_value.tv_nsec) / NANOSECONDS_IN_1_MILLISECOND);
+            tick_counter_instance->current_ms = (tickcounter_ms_t)elapsed_ms;
             *current_ms = tick_counter_instance->current_ms;
             result = 0;
         }
@@ -5,6 +5,7 @@
 #ifdef USE_MBED_TLS
 
 #include <stdlib.h>
+#include <limits.h>
 
 #ifdef TIZENRT
 #include "tls/config.h"
@@ -35,6 +36,8 @@
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/lock.h"
 
 #define OPTION_UNDERLYING_IO_OPTIONS        "underlying_io_options"
 
@@ -51,6 +54,23 @@ typedef enum TLSIO_STATE_ENUM_TAG
     TLSIO_STATE_ERROR
 } TLSIO_STATE_ENUM;
 
+/* Plaintext is read in chunks of up to one TLS record and handed to the upper layer in a single callback per batch,
+   the tls_receive_buffer_size option overrides the default size of a batch */
+#ifndef TLSIO_MBEDTLS_RECEIVE_BUFFER_SIZE
+#define TLSIO_MBEDTLS_RECEIVE_BUFFER_SIZE MBEDTLS_SSL_MAX_CONTENT_LEN
+#endif
+
+/* sessions of closed connections, so that a new tlsio to the same server can resume instead of doing a full handshake */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    char* trusted_certificates;
+    mbedtls_ssl_session session;
+} TLS_SESSION_CACHE_ENTRY;
+
+#define TLS_SESSION_CACHE_MAX_ENTRIES       16
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE socket_io;
@@ -63,8 +83,11 @@ typedef struct TLS_IO_INSTANCE_TAG
     void* on_io_close_complete_context;
     void* on_io_error_context;
     TLSIO_STATE_ENUM tlsio_state;
+    /* ciphertext from the underlying IO, mbedTLS consumes it from socket_io_read_offset on */
     unsigned char* socket_io_read_bytes;
     size_t socket_io_read_byte_count;
+    size_t socket_io_read_offset;
+    size_t socket_io_read_capacity;
     ON_SEND_COMPLETE on_send_complete;
     void* on_send_complete_callback_context;
     mbedtls_entropy_context    entropy;
@@ -74,8 +97,17 @@ typedef struct TLS_IO_INSTANCE_TAG
     mbedtls_x509_crt           trusted_certificates_parsed;
     mbedtls_ssl_session        ssn;
     char*                      trusted_certificates;
+    char*                      hostname;
+    int                        port;
+    bool                       tls_session_resumption;
+    /* ssn holds the session of the last successful handshake of this instance */
+    bool                       has_session;
+    unsigned char*             receive_buffer;
+    size_t                     receive_buffer_size;
 } TLS_IO_INSTANCE;
 
+static int tlsio_mbedtls_wait(CONCRETE_IO_HANDLE tls_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest);
+
 static const IO_INTERFACE_DESCRIPTION tlsio_mbedtls_interface_description =
 {
     tlsio_mbedtls_retrieveoptions,
@@ -85,9 +117,15 @@ static const IO_INTERFACE_DESCRIPTION tlsio_mbedtls_interface_description =
     tlsio_mbedtls_close,
     tlsio_mbedtls_send,
     tlsio_mbedtls_dowork,
-    tlsio_mbedtls_setoption
+    tlsio_mbedtls_setoption,
+    tlsio_mbedtls_wait
 };
 
+/* tlsio_mbedtls_init creates the lock, without it instances only resume their own sessions on reopen */
+static LOCK_HANDLE tls_session_cache_lock = NULL;
+static SINGLYLINKEDLIST_HANDLE tls_session_cache = NULL;
+static size_t tls_session_cache_count = 0;
+
 // DEPRECATED: debug functions do not belong in the tree.
 #if defined (MBED_TLS_DEBUG_ENABLE)
 void mbedtls_debug(void *ctx, int level, const char *file, int line, const char *str)
@@ -116,24 +154,239 @@ static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RES
 static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result = 0;
-    unsigned char buffer[64];
     int rcv_bytes = 1;
 
+    if ((tls_io_instance->receive_buffer == NULL) &&
+        ((tls_io_instance->receive_buffer = (unsigned char*)malloc(tls_io_instance->receive_buffer_size)) == NULL))
+    {
+        LogError("Failed allocating the receive buffer.");
+        result = __FAILURE__;
+        rcv_bytes = 0;
+    }
+
     while (rcv_bytes > 0)
     {
-        rcv_bytes = mbedtls_ssl_read(&tls_io_instance->ssl, buffer, sizeof(buffer));
-        if (rcv_bytes > 0)
+        size_t batch_size = 0;
+
+        /* gather as many decrypted records as fit in the buffer so that the upper layer sees one callback per batch */
+        while (batch_size < tls_io_instance->receive_buffer_size)
         {
-            if (tls_io_instance->on_bytes_received != NULL)
+            rcv_bytes = mbedtls_ssl_read(&tls_io_instance->ssl, tls_io_instance->receive_buffer + batch_size, (tls_io_instance->receive_buffer_size - batch_size));
+            if (rcv_bytes <= 0)
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                break;
             }
+
+            batch_size += rcv_bytes;
+        }
+
+        if ((batch_size > 0) &&
+            (tls_io_instance->on_bytes_received != NULL))
+        {
+            tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->receive_buffer, batch_size);
         }
     }
 
     return result;
 }
 
+static void free_tls_session_cache_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+    mbedtls_ssl_session_free(&entry->session);
+    free(entry->hostname);
+    free(entry->trusted_certificates);
+    free(entry);
+}
+
+static bool are_optional_strings_equal(const char* left, const char* right)
+{
+    return ((left == NULL) && (right == NULL)) ||
+        ((left != NULL) && (right != NULL) && (strcmp(left, right) == 0));
+}
+
+static bool is_tls_session_matching(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const TLS_SESSION_CACHE_ENTRY* entry = (const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+    const TLS_IO_INSTANCE* tls_io_instance = (const TLS_IO_INSTANCE*)match_context;
+
+    /* resuming skips the certificate check, so a session is only reused with the trust anchors it was verified against */
+    return (entry->port == tls_io_instance->port) &&
+        (strcmp(entry->hostname, tls_io_instance->hostname) == 0) &&
+        are_optional_strings_equal(entry->trusted_certificates, tls_io_instance->trusted_certificates);
+}
+
+static bool can_use_tls_session_cache(const TLS_IO_INSTANCE* tls_io_instance)
+{
+    return tls_io_instance->tls_session_resumption &&
+        (tls_io_instance->hostname != NULL) &&
+        (tls_session_cache_lock != NULL);
+}
+
+static TLS_SESSION_CACHE_ENTRY* create_tls_session_cache_entry(TLS_IO_INSTANCE* tls_io_instance)
+{
+    TLS_SESSION_CACHE_ENTRY* result = malloc(sizeof(TLS_SESSION_CACHE_ENTRY));
+    if (result == NULL)
+    {
+        LogError("Failed allocating TLS session cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(TLS_SESSION_CACHE_ENTRY));
+        mbedtls_ssl_session_init(&result->session);
+        result->port = tls_io_instance->port;
+
+        if ((mallocAndStrcpy_s(&result->hostname, tls_io_instance->hostname) != 0) ||
+            ((tls_io_instance->trusted_certificates != NULL) &&
+             (mallocAndStrcpy_s(&result->trusted_certificates, tls_io_instance->trusted_certificates) != 0)))
+        {
+            LogError("Failed copying the TLS session key.");
+            free_tls_session_cache_entry(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void cache_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->tls_session_resumption)
+    {
+        /* mbedtls_ssl_get_session makes a deep copy, the instance and the cache each keep their own */
+        mbedtls_ssl_session_free(&tls_io_instance->ssn);
+        mbedtls_ssl_session_init(&tls_io_instance->ssn);
+        tls_io_instance->has_session = (mbedtls_ssl_get_session(&tls_io_instance->ssl, &tls_io_instance->ssn) == 0);
+
+        if (!tls_io_instance->has_session)
+        {
+            LogInfo("Failed saving the TLS session, the next open does a full handshake.");
+        }
+        else if (can_use_tls_session_cache(tls_io_instance))
+        {
+            if (Lock(tls_session_cache_lock) != LOCK_OK)
+            {
+                LogError("Failed locking the TLS session cache.");
+            }
+            else
+            {
+                LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+                TLS_SESSION_CACHE_ENTRY* entry;
+
+                if (list_item != NULL)
+                {
+                    entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+                    mbedtls_ssl_session_free(&entry->session);
+                    mbedtls_ssl_session_init(&entry->session);
+                }
+                else if ((entry = create_tls_session_cache_entry(tls_io_instance)) == NULL)
+                {
+                    /* already logged */
+                }
+                else if (singlylinkedlist_add(tls_session_cache, entry) == NULL)
+                {
+                    LogError("Failed adding the TLS session to the cache.");
+                    free_tls_session_cache_entry(entry);
+                    entry = NULL;
+                }
+                else
+                {
+                    tls_session_cache_count++;
+                    if (tls_session_cache_count > TLS_SESSION_CACHE_MAX_ENTRIES)
+                    {
+                        /* sessions are appended, so the head is the oldest one */
+                        LIST_ITEM_HANDLE oldest = singlylinkedlist_get_head_item(tls_session_cache);
+                        TLS_SESSION_CACHE_ENTRY* oldest_entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(oldest);
+                        (void)singlylinkedlist_remove(tls_session_cache, oldest);
+                        free_tls_session_cache_entry(oldest_entry);
+                        tls_session_cache_count--;
+                    }
+                }
+
+                if ((entry != NULL) &&
+                    (mbedtls_ssl_get_session(&tls_io_instance->ssl, &entry->session) != 0))
+                {
+                    LogError("Failed copying the TLS session to the cache.");
+                }
+
+                (void)Unlock(tls_session_cache_lock);
+            }
+        }
+    }
+}
+
+static void restore_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->tls_session_resumption)
+    {
+        if (tls_io_instance->has_session)
+        {
+            /* mbedtls_ssl_set_session copies the session, the instance keeps it for the next reopen */
+            if (mbedtls_ssl_set_session(&tls_io_instance->ssl, &tls_io_instance->ssn) != 0)
+            {
+                LogInfo("Failed restoring the TLS session, doing a full handshake.");
+            }
+        }
+        else if (can_use_tls_session_cache(tls_io_instance))
+        {
+            if (Lock(tls_session_cache_lock) != LOCK_OK)
+            {
+                LogError("Failed locking the TLS session cache, doing a full handshake.");
+            }
+            else
+            {
+                LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+                if (list_item != NULL)
+                {
+                    const TLS_SESSION_CACHE_ENTRY* entry = (const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+
+                    if (mbedtls_ssl_set_session(&tls_io_instance->ssl, &entry->session) != 0)
+                    {
+                        LogInfo("Failed restoring the TLS session, doing a full handshake.");
+                    }
+                }
+
+                (void)Unlock(tls_session_cache_lock);
+            }
+        }
+    }
+}
+
+static void forget_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->has_session)
+    {
+        mbedtls_ssl_session_free(&tls_io_instance->ssn);
+        mbedtls_ssl_session_init(&tls_io_instance->ssn);
+        tls_io_instance->has_session = false;
+    }
+}
+
+static void remove_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    forget_tls_session(tls_io_instance);
+
+    if (can_use_tls_session_cache(tls_io_instance))
+    {
+        if (Lock(tls_session_cache_lock) != LOCK_OK)
+        {
+            LogError("Failed locking the TLS session cache.");
+        }
+        else
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+            if (list_item != NULL)
+            {
+                TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+                (void)singlylinkedlist_remove(tls_session_cache, list_item);
+                free_tls_session_cache_entry(entry);
+                tls_session_cache_count--;
+            }
+
+            (void)Unlock(tls_session_cache_lock);
+        }
+    }
+}
+
 static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
@@ -155,11 +408,14 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
 
         if (result == 0)
         {
+            cache_tls_session(tls_io_instance);
             tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
             indicate_open_complete(tls_io_instance, IO_OPEN_OK);
         }
         else
         {
+            /* a session the server no longer accepts would fail the next open the same way */
+            remove_tls_session(tls_io_instance);
             xio_close(tls_io_instance->socket_io, NULL, NULL);
             tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
             indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
@@ -167,21 +423,64 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
     }
 }
 
+/* makes room for size more bytes after the ones mbedTLS has not consumed yet */
+static int reserve_socket_io_read_bytes(TLS_IO_INSTANCE* tls_io_instance, size_t size)
+{
+    int result;
+    size_t needed = tls_io_instance->socket_io_read_byte_count + size;
+
+    if (tls_io_instance->socket_io_read_offset + needed <= tls_io_instance->socket_io_read_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        /* reclaim what mbedTLS already consumed before growing */
+        if (tls_io_instance->socket_io_read_offset > 0)
+        {
+            (void)memmove(tls_io_instance->socket_io_read_bytes, tls_io_instance->socket_io_read_bytes + tls_io_instance->socket_io_read_offset, tls_io_instance->socket_io_read_byte_count);
+            tls_io_instance->socket_io_read_offset = 0;
+        }
+
+        if (needed <= tls_io_instance->socket_io_read_capacity)
+        {
+            result = 0;
+        }
+        else
+        {
+            /* the underlying IO hands bytes up in small pieces, growing geometrically keeps the copies linear */
+            size_t new_capacity = ((tls_io_instance->socket_io_read_capacity * 2) > needed) ? (tls_io_instance->socket_io_read_capacity * 2) : needed;
+            unsigned char* new_socket_io_read_bytes = (unsigned char*)realloc(tls_io_instance->socket_io_read_bytes, new_capacity);
+
+            if (new_socket_io_read_bytes == NULL)
+            {
+                LogError("Failed growing the received bytes buffer.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->socket_io_read_bytes = new_socket_io_read_bytes;
+                tls_io_instance->socket_io_read_capacity = new_capacity;
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
 
-    unsigned char* new_socket_io_read_bytes = (unsigned char*)realloc(tls_io_instance->socket_io_read_bytes, tls_io_instance->socket_io_read_byte_count + size);
-
-    if (new_socket_io_read_bytes == NULL)
+    if (reserve_socket_io_read_bytes(tls_io_instance, size) != 0)
     {
         tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
         indicate_error(tls_io_instance);
     }
     else
     {
-        tls_io_instance->socket_io_read_bytes = new_socket_io_read_bytes;
-        (void)memcpy(tls_io_instance->socket_io_read_bytes + tls_io_instance->socket_io_read_byte_count, buffer, size);
+        (void)memcpy(tls_io_instance->socket_io_read_bytes + tls_io_instance->socket_io_read_offset + tls_io_instance->socket_io_read_byte_count, buffer, size);
         tls_io_instance->socket_io_read_byte_count += size;
     }
 }
@@ -229,7 +528,6 @@ static int on_io_recv(void *context, unsigned char *buf, size_t sz)
 {
     int result;
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
-    unsigned char* new_socket_io_read_bytes;
 
     while (tls_io_instance->socket_io_read_byte_count == 0)
     {
@@ -248,22 +546,10 @@ static int on_io_recv(void *context, unsigned char *buf, size_t sz)
 
     if (result > 0)
     {
-        (void)memcpy((void *)buf, tls_io_instance->socket_io_read_bytes, result);
-        (void)memmove(tls_io_instance->socket_io_read_bytes, tls_io_instance->socket_io_read_bytes + result, tls_io_instance->socket_io_read_byte_count - result);
+        /* the buffer is kept for the next bytes, consuming only moves the offset */
+        (void)memcpy((void *)buf, tls_io_instance->socket_io_read_bytes + tls_io_instance->socket_io_read_offset, result);
         tls_io_instance->socket_io_read_byte_count -= result;
-        if (tls_io_instance->socket_io_read_byte_count > 0)
-        {
-            new_socket_io_read_bytes = (unsigned char*)realloc(tls_io_instance->socket_io_read_bytes, tls_io_instance->socket_io_read_byte_count);
-            if (new_socket_io_read_bytes != NULL)
-            {
-                tls_io_instance->socket_io_read_bytes = new_socket_io_read_bytes;
-            }
-        }
-        else
-        {
-            free(tls_io_instance->socket_io_read_bytes);
-            tls_io_instance->socket_io_read_bytes = NULL;
-        }
+        tls_io_instance->socket_io_read_offset = (tls_io_instance->socket_io_read_byte_count == 0) ? 0 : (tls_io_instance->socket_io_read_offset + result);
     }
 
 
@@ -328,7 +614,6 @@ static void mbedtls_init(void *instance, const char *host) {
     mbedtls_ssl_conf_min_version(&result->config, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);          // v1.2
     mbedtls_ssl_set_bio(&result->ssl, instance, on_io_send, on_io_recv, NULL);
     mbedtls_ssl_set_hostname(&result->ssl, host);
-    mbedtls_ssl_set_session(&result->ssl, &result->ssn);
 
     // DEPRECATED: debug functions do not belong in the tree.
 #if defined (MBED_TLS_DEBUG_ENABLE)
@@ -394,11 +679,24 @@ CONCRETE_IO_HANDLE tlsio_mbedtls_create(void* io_create_parameters)
                 result->on_io_error_context = NULL;
 
                 result->trusted_certificates = NULL;
-
-                result->socket_io = xio_create(underlying_io_interface, io_interface_parameters);
-                if (result->socket_io == NULL)
+                result->hostname = NULL;
+                result->port = tls_io_config->port;
+                result->tls_session_resumption = false;
+                result->has_session = false;
+                result->receive_buffer = NULL;
+                result->receive_buffer_size = TLSIO_MBEDTLS_RECEIVE_BUFFER_SIZE;
+
+                if ((tls_io_config->hostname != NULL) &&
+                    (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+                {
+                    LogError("Failed copying the hostname.");
+                    free(result);
+                    result = NULL;
+                }
+                else if ((result->socket_io = xio_create(underlying_io_interface, io_interface_parameters)) == NULL)
                 {
                     LogError("socket xio create failed");
+                    free(result->hostname);
                     free(result);
                     result = NULL;
                 }
@@ -406,6 +704,8 @@ CONCRETE_IO_HANDLE tlsio_mbedtls_create(void* io_create_parameters)
                 {
                     result->socket_io_read_bytes = NULL;
                     result->socket_io_read_byte_count = 0;
+                    result->socket_io_read_offset = 0;
+                    result->socket_io_read_capacity = 0;
                     result->on_send_complete = NULL;
                     result->on_send_complete_callback_context = NULL;
 
@@ -429,6 +729,7 @@ void tlsio_mbedtls_destroy(CONCRETE_IO_HANDLE tls_io)
         // mbedTLS cleanup...
         mbedtls_ssl_close_notify(&tls_io_instance->ssl);
         mbedtls_ssl_free(&tls_io_instance->ssl);
+        mbedtls_ssl_session_free(&tls_io_instance->ssn);
         mbedtls_ssl_config_free(&tls_io_instance->config);
         mbedtls_x509_crt_free(&tls_io_instance->trusted_certificates_parsed);
         mbedtls_ctr_drbg_free(&tls_io_instance->ctr_drbg);
@@ -446,6 +747,8 @@ void tlsio_mbedtls_destroy(CONCRETE_IO_HANDLE tls_io)
         {
             free(tls_io_instance->trusted_certificates);
         }
+        free(tls_io_instance->hostname);
+        free(tls_io_instance->receive_buffer);
         free(tls_io);
     }
 }
@@ -479,17 +782,32 @@ int tlsio_mbedtls_open(CONCRETE_IO_HANDLE tls_io, ON_IO_OPEN_COMPLETE on_io_open
             tls_io_instance->on_io_error = on_io_error;
             tls_io_instance->on_io_error_context = on_io_error_context;
 
+            /* a reopen starts over on the same SSL context, bytes left from the previous connection are dropped */
+            tls_io_instance->socket_io_read_byte_count = 0;
+            tls_io_instance->socket_io_read_offset = 0;
+
             tls_io_instance->tlsio_state = TLSIO_STATE_OPENING_UNDERLYING_IO;
 
-            if (xio_open(tls_io_instance->socket_io, on_underlying_io_open_complete, tls_io_instance, on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
+            if (mbedtls_ssl_session_reset(&tls_io_instance->ssl) != 0)
             {
-                LogError("Underlying IO open failed");
+                LogError("Failed resetting the SSL context");
                 tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
                 result = __FAILURE__;
             }
             else
             {
-                result = 0;
+                restore_tls_session(tls_io_instance);
+
+                if (xio_open(tls_io_instance->socket_io, on_underlying_io_open_complete, tls_io_instance, on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
+                {
+                    LogError("Underlying IO open failed");
+                    tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
             }
         }
     }
@@ -580,17 +898,115 @@ void tlsio_mbedtls_dowork(CONCRETE_IO_HANDLE tls_io)
         if ((tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN) &&
             (tls_io_instance->tlsio_state != TLSIO_STATE_ERROR))
         {
-            decode_ssl_received_bytes(tls_io_instance);
-            xio_dowork(tls_io_instance->socket_io);
+            if (decode_ssl_received_bytes(tls_io_instance) != 0)
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+            }
+            else
+            {
+                xio_dowork(tls_io_instance->socket_io);
+            }
         }
     }
 }
 
+static int tlsio_mbedtls_wait(CONCRETE_IO_HANDLE tls_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_NOT_OPEN) ||
+            (tls_io_instance->tlsio_state == TLSIO_STATE_ERROR))
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN or an opening state.");
+            result = __FAILURE__;
+        }
+        else if ((tls_io_instance->socket_io_read_byte_count > 0) ||
+            (mbedtls_ssl_get_bytes_avail(&tls_io_instance->ssl) > 0))
+        {
+            /* received bytes are waiting to be decrypted or handed up, the next dowork has work to do */
+            result = 0;
+        }
+        else if (xio_wait(tls_io_instance->socket_io, timeout_ms, interest) != 0)
+        {
+            LogError("Failed waiting on the underlying I/O.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 const IO_INTERFACE_DESCRIPTION* tlsio_mbedtls_get_interface_description(void)
 {
     return &tlsio_mbedtls_interface_description;
 }
 
+int tlsio_mbedtls_init(void)
+{
+    int result;
+
+    if (tls_session_cache_lock != NULL)
+    {
+        /* already initialized */
+        result = 0;
+    }
+    else if ((tls_session_cache = singlylinkedlist_create()) == NULL)
+    {
+        LogError("Failed creating the TLS session cache.");
+        result = __FAILURE__;
+    }
+    else if ((tls_session_cache_lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed creating the TLS session cache lock.");
+        singlylinkedlist_destroy(tls_session_cache);
+        tls_session_cache = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        tls_session_cache_count = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+void tlsio_mbedtls_deinit(void)
+{
+    if (tls_session_cache_lock != NULL)
+    {
+        LIST_ITEM_HANDLE list_item;
+
+        while ((list_item = singlylinkedlist_get_head_item(tls_session_cache)) != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+            (void)singlylinkedlist_remove(tls_session_cache, list_item);
+            free_tls_session_cache_entry(entry);
+        }
+
+        singlylinkedlist_destroy(tls_session_cache);
+        tls_session_cache = NULL;
+        tls_session_cache_count = 0;
+
+        (void)Lock_Deinit(tls_session_cache_lock);
+        tls_session_cache_lock = NULL;
+    }
+}
+
 /*this function will clone an option given by name and value*/
 static void* tlsio_mbedtls_CloneOption(const char* name, const void* value)
 {
@@ -620,6 +1036,36 @@ static void* tlsio_mbedtls_CloneOption(const char* name, const void* value)
                 /*return as is*/
             }
         }
+        else if (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning tls_session_resumption option");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning tls_receive_buffer_size option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -639,7 +1085,11 @@ static void tlsio_mbedtls_DestroyOption(const char* name, const void* value)
     }
     else
     {
-        if (strcmp(name, OPTION_TRUSTED_CERT) == 0)
+        if (
+            (strcmp(name, OPTION_TRUSTED_CERT) == 0) ||
+            (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0) ||
+            (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+            )
         {
             free((void*)value);
         }
@@ -691,6 +1141,24 @@ OPTIONHANDLER_HANDLE tlsio_mbedtls_retrieveoptions(CONCRETE_IO_HANDLE handle)
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (
+                (tls_io_instance->tls_session_resumption) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SESSION_RESUMPTION, &tls_io_instance->tls_session_resumption) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_session_resumption option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->receive_buffer_size != TLSIO_MBEDTLS_RECEIVE_BUFFER_SIZE) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_RECEIVE_BUFFER_SIZE, &tls_io_instance->receive_buffer_size) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_receive_buffer_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else
             {
                 /*all is fine, all interesting options have been saved*/
@@ -715,12 +1183,19 @@ int tlsio_mbedtls_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
 
         if (strcmp(OPTION_TRUSTED_CERT, optionName) == 0)
         {
+            /* the saved session was verified against the previous trust anchors, resuming it would skip the check against the new ones */
+            if (!are_optional_strings_equal(tls_io_instance->trusted_certificates, (const char*)value))
+            {
+                forget_tls_session(tls_io_instance);
+            }
+
             if (tls_io_instance->trusted_certificates != NULL)
             {
                 // Free the memory if it has been previously allocated
                 free(tls_io_instance->trusted_certificates);
                 tls_io_instance->trusted_certificates = NULL;
             }
+
             if (mallocAndStrcpy_s(&tls_io_instance->trusted_certificates, (const char*)value) != 0)
             {
                 LogError("unable to mallocAndStrcpy_s");
@@ -728,7 +1203,12 @@ int tlsio_mbedtls_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             }
             else
             {
-                int parse_result = mbedtls_x509_crt_parse(&tls_io_instance->trusted_certificates_parsed, (const unsigned char *)value, (int)(strlen(value) + 1));
+                int parse_result;
+
+                /* the new certificates replace the previous ones, so that the trust matches the key sessions are cached under */
+                mbedtls_x509_crt_free(&tls_io_instance->trusted_certificates_parsed);
+                mbedtls_x509_crt_init(&tls_io_instance->trusted_certificates_parsed);
+                parse_result = mbedtls_x509_crt_parse(&tls_io_instance->trusted_certificates_parsed, (const unsigned char *)value, (int)(strlen(value) + 1));
                 if (parse_result != 0)
                 {
                     LogInfo("Malformed pem certificate");
@@ -741,6 +1221,32 @@ int tlsio_mbedtls_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 }
             }
         }
+        else if (strcmp(OPTION_TLS_SESSION_RESUMPTION, optionName) == 0)
+        {
+            tls_io_instance->tls_session_resumption = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_RECEIVE_BUFFER_SIZE, optionName) == 0)
+        {
+            size_t receive_buffer_size = *(const size_t*)value;
+
+            if ((receive_buffer_size == 0) || (receive_buffer_size > INT_MAX))
+            {
+                LogError("Invalid tls_receive_buffer_size %lu.", (unsigned long)receive_buffer_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* the buffer is (re)allocated with the new size on the next decode */
+                if (receive_buffer_size != tls_io_instance->receive_buffer_size)
+                {
+                    free(tls_io_instance->receive_buffer);
+                    tls_io_instance->receive_buffer = NULL;
+                    tls_io_instance->receive_buffer_size = receive_buffer_size;
+                }
+                result = 0;
+            }
+        }
         else
         {
             // tls_io_instance->socket_io is never NULL
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef LOOPBACKIO_H
+#define LOOPBACKIO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+typedef struct LOOPBACKIO_PAIR_INSTANCE_TAG* LOOPBACKIO_PAIR_HANDLE;
+
+typedef enum LOOPBACKIO_ENDPOINT_TAG
+{
+    LOOPBACKIO_ENDPOINT_A,
+    LOOPBACKIO_ENDPOINT_B
+} LOOPBACKIO_ENDPOINT;
+
+/* Link characteristics shared by both directions of a pair. Zero means "no limit" for every field. */
+typedef struct LOOPBACKIO_LINK_OPTIONS_TAG
+{
+    unsigned int latency_ms;
+    size_t bytes_per_second;
+    size_t max_chunk_size;
+} LOOPBACKIO_LINK_OPTIONS;
+
+typedef struct LOOPBACKIO_CONFIG_TAG
+{
+    LOOPBACKIO_PAIR_HANDLE pair;
+    LOOPBACKIO_ENDPOINT endpoint;
+} LOOPBACKIO_CONFIG;
+
+MOCKABLE_FUNCTION(, LOOPBACKIO_PAIR_HANDLE, loopbackio_pair_create, const LOOPBACKIO_LINK_OPTIONS*, link_options);
+MOCKABLE_FUNCTION(, void, loopbackio_pair_destroy, LOOPBACKIO_PAIR_HANDLE, pair);
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, loopbackio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LOOPBACKIO_H */
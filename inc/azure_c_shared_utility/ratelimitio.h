@@ -0,0 +1,51 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef RATELIMITIO_H
+#define RATELIMITIO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+typedef struct RATELIMITIO_LINK_INSTANCE_TAG* RATELIMITIO_LINK_HANDLE;
+
+typedef enum RATELIMITIO_PRIORITY_TAG
+{
+    RATELIMITIO_PRIORITY_HIGH,
+    RATELIMITIO_PRIORITY_NORMAL,
+    RATELIMITIO_PRIORITY_LOW
+} RATELIMITIO_PRIORITY;
+
+#define RATELIMITIO_PRIORITY_COUNT  3
+
+typedef struct RATELIMITIO_LINK_OPTIONS_TAG
+{
+    size_t bytes_per_second;
+    size_t burst_size;
+} RATELIMITIO_LINK_OPTIONS;
+
+typedef struct RATELIMITIO_CONFIG_TAG
+{
+    const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+    void* underlying_io_parameters;
+    RATELIMITIO_LINK_HANDLE link;
+    RATELIMITIO_PRIORITY priority;
+} RATELIMITIO_CONFIG;
+
+MOCKABLE_FUNCTION(, RATELIMITIO_LINK_HANDLE, ratelimitio_link_create, const RATELIMITIO_LINK_OPTIONS*, link_options);
+MOCKABLE_FUNCTION(, void, ratelimitio_link_destroy, RATELIMITIO_LINK_HANDLE, link);
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, ratelimitio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* RATELIMITIO_H */
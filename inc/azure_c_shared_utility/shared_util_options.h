@@ -7,6 +7,8 @@
 #ifdef __cplusplus
 extern "C"
 {
+#else
+#include <stdbool.h>
 #endif
 
     typedef struct HTTP_PROXY_OPTIONS_TAG
@@ -28,6 +30,35 @@ extern "C"
     static const char* OPTION_X509_ECC_CERT = "x509EccCertificate";
     static const char* OPTION_X509_ECC_KEY = "x509EccAliasKey";
 
+    static const char* OPTION_TLS_SESSION_RESUMPTION = "tls_session_resumption";
+    static const char* OPTION_TLS_RECEIVE_BUFFER_SIZE = "tls_receive_buffer_size";
+    static const char* OPTION_TLS_SOCKET_FAST_PATH = "tls_socket_fast_path";
+    static const char* OPTION_TLS_KERNEL_TLS = "tls_kernel_tls";
+    /* tlsio_openssl: handshake steps, and with them tls_validation_callback, run on a process-wide pool of worker threads */
+    static const char* OPTION_TLS_HANDSHAKE_WORKER_THREADS = "tls_handshake_worker_threads";
+    static const char* OPTION_TLS_EARLY_DATA = "tls_early_data";
+
+    static const char* OPTION_WS_MAX_MESSAGE_SIZE = "ws_max_message_size";
+
+    /* permessage-deflate (RFC 7692) parameters offered by uws_client in the upgrade request */
+    typedef struct WS_PERMESSAGE_DEFLATE_OPTIONS_TAG
+    {
+        int client_max_window_bits;     /* 9 to 15, window the client compresses with */
+        int server_max_window_bits;     /* 8 to 15, window requested from the server, not offered when 15 */
+        bool client_no_context_takeover;
+        bool server_no_context_takeover;
+        int compression_level;          /* 0 (fastest) to 9 (smallest), -1 for the zlib default */
+    } WS_PERMESSAGE_DEFLATE_OPTIONS;
+
+    static const char* OPTION_WS_PERMESSAGE_DEFLATE = "ws_permessage_deflate";
+
+    /* both are unsigned int values in milliseconds, 0 turns the keepalive PINGs (or the PONG timeout) off */
+    static const char* OPTION_WS_PING_INTERVAL_MS = "ws_ping_interval_ms";
+    static const char* OPTION_WS_PONG_TIMEOUT_MS = "ws_pong_timeout_ms";
+
+    /* bool value, when true small frames sent between two uws_client_dowork calls are sent together with a single xio_send */
+    static const char* OPTION_WS_COALESCE_SENDS = "ws_coalesce_sends";
+
     static const char* OPTION_CURL_LOW_SPEED_LIMIT = "CURLOPT_LOW_SPEED_LIMIT";
     static const char* OPTION_CURL_LOW_SPEED_TIME = "CURLOPT_LOW_SPEED_TIME";
     static const char* OPTION_CURL_FRESH_CONNECT = "CURLOPT_FRESH_CONNECT";
@@ -35,6 +66,7 @@ extern "C"
     static const char* OPTION_CURL_VERBOSE = "CURLOPT_VERBOSE";
 
     static const char* OPTION_NET_INT_MAC_ADDRESS = "net_interface_mac_address";
+    static const char* OPTION_SOCKET_DESCRIPTOR_HANDOFF = "socket_descriptor_handoff";
 #ifdef __cplusplus
 }
 #endif
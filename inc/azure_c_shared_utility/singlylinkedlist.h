@@ -5,9 +5,11 @@
 #define SINGLYLINKEDLIST_H
 
 #ifdef __cplusplus
+#include <cstddef>
 extern "C" {
 #else
 #include "stdbool.h"
+#include <stddef.h>
 #endif /* __cplusplus */
 
 #include "azure_c_shared_utility/umock_c_prod.h"
@@ -48,6 +50,13 @@ MOCKABLE_FUNCTION(, LIST_ITEM_HANDLE, singlylinkedlist_find, SINGLYLINKEDLIST_HA
 MOCKABLE_FUNCTION(, const void*, singlylinkedlist_item_get_value, LIST_ITEM_HANDLE, item_handle);
 MOCKABLE_FUNCTION(, int, singlylinkedlist_remove_if, SINGLYLINKEDLIST_HANDLE, list, LIST_CONDITION_FUNCTION, condition_function, const void*, match_context);
 MOCKABLE_FUNCTION(, int, singlylinkedlist_foreach, SINGLYLINKEDLIST_HANDLE, list, LIST_ACTION_FUNCTION, action_function, const void*, action_context);
+/**
+* @brief						Lets the list keep up to max_cached_items removed nodes and reuse them in singlylinkedlist_add, so that a list whose length stays within that bound adds and removes items without allocating.
+* @param list					The list.
+* @param max_cached_items		Most removed nodes kept for reuse, 0 (the default) frees every removed node.
+* @returns						0 on success, a non-zero value otherwise.
+*/
+MOCKABLE_FUNCTION(, int, singlylinkedlist_set_item_cache_size, SINGLYLINKEDLIST_HANDLE, list, size_t, max_cached_items);
 
 #ifdef __cplusplus
 }
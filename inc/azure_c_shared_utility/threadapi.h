@@ -9,6 +9,7 @@
 #ifndef THREADAPI_H
 #define THREADAPI_H
 
+#include <stdint.h>
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -83,6 +84,18 @@ MOCKABLE_FUNCTION(, void, ThreadAPI_Exit, int, res);
  */
 MOCKABLE_FUNCTION(, void, ThreadAPI_Sleep, unsigned int, milliseconds);
 
+/**
+ * @brief	Gets the processor time used so far by the calling thread.
+ *
+ * @param	cpu_time_us		The processor time of the calling thread, in
+ * 							microseconds, is returned in this pointer.
+ *
+ * @return	@c THREADAPI_OK if the API call is successful or an error
+ * 			code in case it fails, which includes platforms that cannot
+ * 			measure the processor time of a single thread.
+ */
+MOCKABLE_FUNCTION(, THREADAPI_RESULT, ThreadAPI_GetCurrentThreadCpuTime, uint64_t*, cpu_time_us);
+
 #ifdef __cplusplus
 }
 #endif
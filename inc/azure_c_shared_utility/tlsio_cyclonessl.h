@@ -14,6 +14,11 @@ extern "C" {
 #include <stddef.h>
 #endif /* __cplusplus */
 
+/* Size of the plaintext chunk requested from tlsRead on each dowork, one TLS record by default */
+#ifndef TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE
+#define TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE    16384
+#endif
+
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, tlsio_cyclonessl_get_interface_description);
 
 #ifdef __cplusplus
@@ -34,6 +34,10 @@ extern OPTIONHANDLER_HANDLE tlsio_mbedtls_retrieveoptions(CONCRETE_IO_HANDLE han
 
 extern const IO_INTERFACE_DESCRIPTION* tlsio_mbedtls_get_interface_description(void);
 
+/* creates the process wide TLS session cache, without it only a reopened instance resumes its own session */
+extern int tlsio_mbedtls_init(void);
+extern void tlsio_mbedtls_deinit(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef TRACINGIO_H
+#define TRACINGIO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif /* __cplusplus */
+
+/* Values below 16 get one bucket each, larger values get 8 buckets per power of two (12.5% precision) up to 2^40 */
+#define TRACINGIO_HISTOGRAM_LINEAR_BUCKETS      16
+#define TRACINGIO_HISTOGRAM_SUB_BUCKETS         8
+#define TRACINGIO_HISTOGRAM_MAX_EXPONENT        40
+#define TRACINGIO_HISTOGRAM_BUCKET_COUNT        (TRACINGIO_HISTOGRAM_LINEAR_BUCKETS + ((TRACINGIO_HISTOGRAM_MAX_EXPONENT - 4) * TRACINGIO_HISTOGRAM_SUB_BUCKETS))
+
+typedef struct TRACINGIO_STATS_INSTANCE_TAG* TRACINGIO_STATS_HANDLE;
+
+typedef uint64_t(*TRACINGIO_GET_TIME_US)(void);
+
+typedef struct TRACINGIO_HISTOGRAM_TAG
+{
+    uint64_t count;
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t buckets[TRACINGIO_HISTOGRAM_BUCKET_COUNT];
+} TRACINGIO_HISTOGRAM;
+
+typedef struct TRACINGIO_STATS_SNAPSHOT_TAG
+{
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t send_errors;
+    TRACINGIO_HISTOGRAM send_size;
+    TRACINGIO_HISTOGRAM receive_size;
+    TRACINGIO_HISTOGRAM send_complete_latency_us;
+    TRACINGIO_HISTOGRAM callback_duration_us;
+    TRACINGIO_HISTOGRAM dowork_duration_us;
+} TRACINGIO_STATS_SNAPSHOT;
+
+typedef struct TRACINGIO_CONFIG_TAG
+{
+    const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+    void* underlying_io_parameters;
+    TRACINGIO_STATS_HANDLE stats;
+} TRACINGIO_CONFIG;
+
+MOCKABLE_FUNCTION(, TRACINGIO_STATS_HANDLE, tracingio_stats_create, TRACINGIO_GET_TIME_US, get_time_us);
+MOCKABLE_FUNCTION(, void, tracingio_stats_destroy, TRACINGIO_STATS_HANDLE, stats);
+MOCKABLE_FUNCTION(, int, tracingio_stats_get_snapshot, TRACINGIO_STATS_HANDLE, stats, TRACINGIO_STATS_SNAPSHOT*, snapshot);
+MOCKABLE_FUNCTION(, int, tracingio_stats_reset, TRACINGIO_STATS_HANDLE, stats);
+MOCKABLE_FUNCTION(, uint64_t, tracingio_histogram_get_percentile, const TRACINGIO_HISTOGRAM*, histogram, double, percentile);
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, tracingio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* TRACINGIO_H */
@@ -51,7 +51,9 @@ DEFINE_ENUM(WS_OPEN_RESULT, WS_OPEN_RESULT_VALUES);
     WS_ERROR_BAD_FRAME_RECEIVED, \
     WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST, \
     WS_ERROR_UNDERLYING_IO_ERROR, \
-    WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO
+    WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO, \
+    WS_ERROR_MESSAGE_TOO_BIG, \
+    WS_ERROR_PONG_TIMEOUT
 
 DEFINE_ENUM(WS_ERROR, WS_ERROR_VALUES);
 
@@ -87,6 +89,8 @@ DEFINE_ENUM(WS_ERROR, WS_ERROR_VALUES);
 #define CLOSE_RESERVED_1015                 1015
 
 typedef void(*ON_WS_FRAME_RECEIVED)(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size);
+typedef void(*ON_WS_FRAME_FRAGMENT_RECEIVED)(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final);
+typedef void(*ON_WS_UPGRADE_RESPONSE_HEADER)(void* context, const char* name, size_t name_length, const char* value, size_t value_length);
 typedef void(*ON_WS_SEND_FRAME_COMPLETE)(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result);
 typedef void(*ON_WS_OPEN_COMPLETE)(void* context, WS_OPEN_RESULT ws_open_result);
 typedef void(*ON_WS_CLOSE_COMPLETE)(void* context);
@@ -98,6 +102,36 @@ typedef struct WS_PROTOCOL_TAG
     const char* protocol;
 } WS_PROTOCOL;
 
+/* payload byte counts before and after permessage-deflate and the CPU time spent compressing, for the current connection;
+   the compression ratio of each direction is the uncompressed count divided by the compressed one. The CPU times are those
+   of the calling thread, as reported by ThreadAPI_GetCurrentThreadCpuTime, and stay 0 on platforms that cannot measure them */
+typedef struct UWS_CLIENT_COMPRESSION_STATISTICS_TAG
+{
+    bool is_negotiated;
+    uint64_t messages_compressed;
+    uint64_t uncompressed_bytes_sent;
+    uint64_t compressed_bytes_sent;
+    uint64_t messages_decompressed;
+    uint64_t compressed_bytes_received;
+    uint64_t uncompressed_bytes_received;
+    uint64_t compress_cpu_time_us;
+    uint64_t decompress_cpu_time_us;
+} UWS_CLIENT_COMPRESSION_STATISTICS;
+
+#define UWS_CLIENT_RTT_HISTOGRAM_BUCKET_COUNT   16
+
+/* round trip times of the keepalive PINGs sent on the current connection, in milliseconds; bucket 0 of the histogram counts
+   round trips under 1 ms, bucket i counts round trips from 2^(i-1) up to 2^i ms and the last bucket also counts all longer ones */
+typedef struct UWS_CLIENT_PING_STATISTICS_TAG
+{
+    uint64_t pings_sent;
+    uint64_t pongs_received;
+    uint64_t rtt_min_ms;
+    uint64_t rtt_avg_ms;
+    uint64_t rtt_max_ms;
+    uint64_t rtt_histogram[UWS_CLIENT_RTT_HISTOGRAM_BUCKET_COUNT];
+} UWS_CLIENT_PING_STATISTICS;
+
 MOCKABLE_FUNCTION(, UWS_CLIENT_HANDLE, uws_client_create, const char*, hostname, unsigned int, port, const char*, resource_name, bool, use_ssl, const WS_PROTOCOL*, protocols, size_t, protocol_count);
 MOCKABLE_FUNCTION(, UWS_CLIENT_HANDLE, uws_client_create_with_io, const IO_INTERFACE_DESCRIPTION*, io_interface, void*, io_create_parameters, const char*, hostname, unsigned int, port, const char*, resource_name, const WS_PROTOCOL*, protocols, size_t, protocol_count)
 MOCKABLE_FUNCTION(, void, uws_client_destroy, UWS_CLIENT_HANDLE, uws_client);
@@ -105,7 +139,18 @@ MOCKABLE_FUNCTION(, int, uws_client_open_async, UWS_CLIENT_HANDLE, uws_client, O
 MOCKABLE_FUNCTION(, int, uws_client_close_async, UWS_CLIENT_HANDLE, uws_client, ON_WS_CLOSE_COMPLETE, on_ws_close_complete, void*, on_ws_close_complete_context);
 MOCKABLE_FUNCTION(, int, uws_client_close_handshake_async, UWS_CLIENT_HANDLE, uws_client, uint16_t, close_code, const char*, close_reason, ON_WS_CLOSE_COMPLETE, on_ws_close_complete, void*, on_ws_close_complete_context);
 MOCKABLE_FUNCTION(, int, uws_client_send_frame_async, UWS_CLIENT_HANDLE, uws_client, unsigned char, frame_type, const unsigned char*, buffer, size_t, size, bool, is_final, ON_WS_SEND_FRAME_COMPLETE, on_ws_send_frame_complete, void*, callback_context);
+/* like uws_client_send_frame_async, but masks the payload in place in buffer instead of copying it, buffer holds the masked payload afterwards */
+MOCKABLE_FUNCTION(, int, uws_client_send_frame_in_place_async, UWS_CLIENT_HANDLE, uws_client, unsigned char, frame_type, unsigned char*, buffer, size_t, size, bool, is_final, ON_WS_SEND_FRAME_COMPLETE, on_ws_send_frame_complete, void*, callback_context);
+/* when set, fragmented messages are passed to on_ws_frame_fragment_received one fragment at a time instead of being reassembled for on_ws_frame_received */
+MOCKABLE_FUNCTION(, int, uws_client_set_on_ws_frame_fragment_received, UWS_CLIENT_HANDLE, uws_client, ON_WS_FRAME_FRAGMENT_RECEIVED, on_ws_frame_fragment_received, void*, on_ws_frame_fragment_received_context);
+/* when set, each header of the upgrade response is passed to on_ws_upgrade_response_header as it is parsed, before the open completes;
+   name and value are not zero terminated and are only valid for the duration of the call */
+MOCKABLE_FUNCTION(, int, uws_client_set_on_ws_upgrade_response_header, UWS_CLIENT_HANDLE, uws_client, ON_WS_UPGRADE_RESPONSE_HEADER, on_ws_upgrade_response_header, void*, on_ws_upgrade_response_header_context);
+MOCKABLE_FUNCTION(, int, uws_client_get_compression_statistics, UWS_CLIENT_HANDLE, uws_client, UWS_CLIENT_COMPRESSION_STATISTICS*, statistics);
+MOCKABLE_FUNCTION(, int, uws_client_get_ping_statistics, UWS_CLIENT_HANDLE, uws_client, UWS_CLIENT_PING_STATISTICS*, statistics);
 MOCKABLE_FUNCTION(, void, uws_client_dowork, UWS_CLIENT_HANDLE, uws_client);
+/* blocks until the underlying IO is ready for interest, or for at most timeout_ms, so that the next uws_client_dowork has work to do */
+MOCKABLE_FUNCTION(, int, uws_client_wait, UWS_CLIENT_HANDLE, uws_client, unsigned int, timeout_ms, IO_WAIT_INTEREST, interest);
 
 MOCKABLE_FUNCTION(, int, uws_client_set_option, UWS_CLIENT_HANDLE, uws_client, const char*, option_name, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, uws_client_retrieve_options, UWS_CLIENT_HANDLE, uws_client);
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UWS_DEFLATE_H
+#define UWS_DEFLATE_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#endif
+
+/* compressor and decompressor for the payload of permessage-deflate (RFC 7692) messages, one instance per WebSocket connection */
+typedef struct UWS_DEFLATE_INSTANCE_TAG* UWS_DEFLATE_HANDLE;
+
+MOCKABLE_FUNCTION(, UWS_DEFLATE_HANDLE, uws_deflate_create, int, compress_window_bits, int, compression_level, bool, no_compress_context_takeover);
+MOCKABLE_FUNCTION(, void, uws_deflate_destroy, UWS_DEFLATE_HANDLE, uws_deflate);
+/* compresses a whole message, the output is owned by the instance and stays valid until the next call */
+MOCKABLE_FUNCTION(, int, uws_deflate_compress, UWS_DEFLATE_HANDLE, uws_deflate, const unsigned char*, payload, size_t, size, const unsigned char**, compressed_payload, size_t*, compressed_size);
+/* decompresses one fragment of a message, the output is owned by the instance and stays valid until the next call;
+   decompression stops once more than max_size bytes were produced, which is reported as a decompressed_size above max_size */
+MOCKABLE_FUNCTION(, int, uws_deflate_decompress, UWS_DEFLATE_HANDLE, uws_deflate, const unsigned char*, payload, size_t, size, bool, is_final, size_t, max_size, const unsigned char**, decompressed_payload, size_t*, decompressed_size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UWS_DEFLATE_H */
@@ -20,6 +20,9 @@ extern "C" {
 #define RESERVED_2  0x02
 #define RESERVED_3  0x01
 
+/* 2 bytes of opcode and length, 8 bytes of extended length and 4 bytes of masking key */
+#define UWS_FRAME_ENCODER_MAX_HEADER_SIZE   14
+
 #define WS_FRAME_TYPE_VALUES \
     WS_CONTINUATION_FRAME, \
     WS_TEXT_FRAME, \
@@ -41,6 +44,10 @@ extern "C" {
 DEFINE_ENUM(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
 
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, uws_frame_encoder_encode, WS_FRAME_TYPE, opcode, const unsigned char*, payload, size_t, length, bool, is_masked, bool, is_final, unsigned char, reserved);
+/* writes only the frame header (masking key included) into header, the payload is left to the caller */
+MOCKABLE_FUNCTION(, int, uws_frame_encoder_encode_header, unsigned char*, header, size_t, header_size, WS_FRAME_TYPE, opcode, size_t, length, bool, is_masked, bool, is_final, unsigned char, reserved, size_t*, header_length);
+/* masks or unmasks length bytes with the 4 byte mask_key, offset is the position of source[0] within the frame payload */
+MOCKABLE_FUNCTION(, void, uws_frame_encoder_mask, unsigned char*, destination, const unsigned char*, source, size_t, length, const unsigned char*, mask_key, size_t, offset);
 
 #ifdef __cplusplus
 }
@@ -16,6 +16,12 @@ MOCKABLE_FUNCTION(,int, x509_openssl_add_certificates, SSL_CTX*, ssl_ctx, const
 MOCKABLE_FUNCTION(,int, x509_openssl_add_credentials, SSL_CTX*, ssl_ctx, const char*, x509certificate, const char*, x509privatekey);
 MOCKABLE_FUNCTION(,int, x509_openssl_add_ecc_credentials, SSL_CTX*, ssl_ctx, const char*, ecc_alias_cert, const char*, ecc_alias_key);
 
+/* Once x509_openssl_cache_init is called, the functions above parse each PEM string once and reuse the parsed objects */
+MOCKABLE_FUNCTION(,int, x509_openssl_cache_init);
+MOCKABLE_FUNCTION(,void, x509_openssl_cache_deinit);
+/* The store set on ssl_ctx is shared with every context using the same certificates and must not be modified; it also holds the default CA locations */
+MOCKABLE_FUNCTION(,int, x509_openssl_use_shared_certificates, SSL_CTX*, ssl_ctx, const char*, certificates);
+
 #ifdef __cplusplus
 }
 #endif 
@@ -33,6 +33,13 @@ DEFINE_ENUM(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
 
 DEFINE_ENUM(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
 
+typedef enum IO_WAIT_INTEREST_TAG
+{
+    IO_WAIT_READ = 1,
+    IO_WAIT_WRITE = 2,
+    IO_WAIT_READ_WRITE = 3
+} IO_WAIT_INTEREST;
+
 typedef void(*ON_BYTES_RECEIVED)(void* context, const unsigned char* buffer, size_t size);
 typedef void(*ON_SEND_COMPLETE)(void* context, IO_SEND_RESULT send_result);
 typedef void(*ON_IO_OPEN_COMPLETE)(void* context, IO_OPEN_RESULT open_result);
@@ -47,6 +54,7 @@ typedef int(*IO_CLOSE)(CONCRETE_IO_HANDLE concrete_io, ON_IO_CLOSE_COMPLETE on_i
 typedef int(*IO_SEND)(CONCRETE_IO_HANDLE concrete_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context);
 typedef void(*IO_DOWORK)(CONCRETE_IO_HANDLE concrete_io);
 typedef int(*IO_SETOPTION)(CONCRETE_IO_HANDLE concrete_io, const char* optionName, const void* value);
+typedef int(*IO_WAIT)(CONCRETE_IO_HANDLE concrete_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest);
 
 
 typedef struct IO_INTERFACE_DESCRIPTION_TAG
@@ -59,6 +67,8 @@ typedef struct IO_INTERFACE_DESCRIPTION_TAG
     IO_SEND concrete_io_send;
     IO_DOWORK concrete_io_dowork;
     IO_SETOPTION concrete_io_setoption;
+    /* optional, can be left NULL by IO implementations that cannot block on their transport */
+    IO_WAIT concrete_io_wait;
 } IO_INTERFACE_DESCRIPTION;
 
 MOCKABLE_FUNCTION(, XIO_HANDLE, xio_create, const IO_INTERFACE_DESCRIPTION*, io_interface_description, const void*, io_create_parameters);
@@ -69,6 +79,7 @@ MOCKABLE_FUNCTION(, int, xio_send, XIO_HANDLE, xio, const void*, buffer, size_t,
 MOCKABLE_FUNCTION(, void, xio_dowork, XIO_HANDLE, xio);
 MOCKABLE_FUNCTION(, int, xio_setoption, XIO_HANDLE, xio, const char*, optionName, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, xio_retrieveoptions, XIO_HANDLE, xio);
+MOCKABLE_FUNCTION(, int, xio_wait, XIO_HANDLE, xio, unsigned int, timeout_ms, IO_WAIT_INTEREST, interest);
 
 #ifdef __cplusplus
 }
@@ -41,3 +41,11 @@ void ThreadAPI_Exit(int res)
 	(void)res;
     LogError("FreeRTOS does not support multi-threading.");
 }
+
+/*Codes_SRS_THREADAPI_FREERTOS_30_007: [ FreeRTOS does not track the processor time of a single thread, so ThreadAPI_GetCurrentThreadCpuTime shall return THREADAPI_ERROR. ]*/
+THREADAPI_RESULT ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+	(void)cpu_time_us;
+    LogError("FreeRTOS does not support per-thread processor time.");
+    return THREADAPI_ERROR;
+}
@@ -0,0 +1,736 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Compares tlsio_mbedtls with tlsio_openssl against an in-process OpenSSL server on localhost.
+   For each tlsio it reports the rate and the p50/p99 open latency of full and resumed TLS 1.2
+   handshakes, and then the download throughput and the client side MB/s per CPU core for each
+   tls_receive_buffer_size. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/pem.h"
+#include "openssl/x509.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/tlsio_mbedtls.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+
+#define SERVER_WORKERS              4
+#define SERVER_RECORD_SIZE          16384
+#define DEFAULT_TOTAL_MB            64
+#define DEFAULT_OPENS               256
+#define WAIT_TIMEOUT_MS             100
+#define HANDSHAKE_RECEIVE_BUFFER_SIZE   16384
+
+typedef struct BENCHMARK_SERVER_TAG
+{
+    SSL_CTX* ssl_context;
+    /* the self-signed server certificate, handed to the clients as TrustedCerts */
+    char* certificate_pem;
+    int listen_socket;
+    int port;
+    THREAD_HANDLE worker_threads[SERVER_WORKERS];
+    size_t worker_count;
+    LOCK_HANDLE stats_lock;
+    size_t handshakes;
+    size_t resumed_handshakes;
+} BENCHMARK_SERVER;
+
+typedef struct BENCHMARK_TLSIO_TAG
+{
+    const char* name;
+    const IO_INTERFACE_DESCRIPTION* (*get_interface_description)(void);
+    /* tlsio_openssl starts from TLS 1.0 unless told otherwise, tlsio_mbedtls always asks for TLS 1.2 */
+    bool set_tls_version;
+} BENCHMARK_TLSIO;
+
+typedef struct BENCHMARK_CLIENT_TAG
+{
+    XIO_HANDLE tlsio;
+    int open_result;
+    bool failed;
+    size_t received;
+    size_t receive_callbacks;
+    struct timespec open_start;
+    struct timespec open_end;
+} BENCHMARK_CLIENT;
+
+typedef struct HANDSHAKE_RESULTS_TAG
+{
+    double handshakes_per_second;
+    double p50_ms;
+    double p99_ms;
+    double resumed_percent;
+} HANDSHAKE_RESULTS;
+
+static const BENCHMARK_TLSIO benchmark_tlsios[] =
+{
+    { "tlsio_mbedtls", tlsio_mbedtls_get_interface_description, false },
+    { "tlsio_openssl", tlsio_openssl_get_interface_description, true }
+};
+
+static const size_t benchmark_receive_buffer_sizes[] = { 1024, 4096, 16384, 65536 };
+
+static EVP_PKEY* create_server_key(void)
+{
+    EVP_PKEY* result = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+
+    if (key_context != NULL)
+    {
+        if ((EVP_PKEY_keygen_init(key_context) <= 0) ||
+            (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) <= 0) ||
+            (EVP_PKEY_keygen(key_context, &result) <= 0))
+        {
+            result = NULL;
+        }
+
+        EVP_PKEY_CTX_free(key_context);
+    }
+
+    return result;
+}
+
+static X509* create_server_certificate(EVP_PKEY* key)
+{
+    X509* result = X509_new();
+
+    if (result != NULL)
+    {
+        X509_NAME* name = X509_get_subject_name(result);
+
+        /* mbedTLS checks the name against the hostname the client connects to */
+        if ((X509_set_version(result, 2) != 1) ||
+            (ASN1_INTEGER_set(X509_get_serialNumber(result), 1) != 1) ||
+            (X509_gmtime_adj(X509_get_notBefore(result), 0) == NULL) ||
+            (X509_gmtime_adj(X509_get_notAfter(result), 24 * 3600) == NULL) ||
+            (X509_set_pubkey(result, key) != 1) ||
+            (X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0) != 1) ||
+            (X509_set_issuer_name(result, name) != 1) ||
+            (X509_sign(result, key, EVP_sha256()) == 0))
+        {
+            X509_free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static char* get_certificate_pem(X509* certificate)
+{
+    char* result = NULL;
+    BIO* pem_bio = BIO_new(BIO_s_mem());
+
+    if (pem_bio != NULL)
+    {
+        char* pem;
+        long pem_length;
+
+        if ((PEM_write_bio_X509(pem_bio, certificate) == 1) &&
+            ((pem_length = BIO_get_mem_data(pem_bio, &pem)) > 0) &&
+            ((result = (char*)malloc((size_t)pem_length + 1)) != NULL))
+        {
+            (void)memcpy(result, pem, (size_t)pem_length);
+            result[pem_length] = '\0';
+        }
+
+        BIO_free(pem_bio);
+    }
+
+    return result;
+}
+
+static int create_server_ssl_context(BENCHMARK_SERVER* server)
+{
+    int result;
+
+    if ((server->ssl_context = SSL_CTX_new(SSLv23_server_method())) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        EVP_PKEY* key = create_server_key();
+        X509* certificate = (key == NULL) ? NULL : create_server_certificate(key);
+
+        /* tlsio_mbedtls speaks TLS 1.2, both clients get the same protocol so the numbers compare */
+        if ((certificate == NULL) ||
+            (SSL_CTX_use_certificate(server->ssl_context, certificate) != 1) ||
+            (SSL_CTX_use_PrivateKey(server->ssl_context, key) != 1) ||
+            (SSL_CTX_set_cipher_list(server->ssl_context, "ECDHE-ECDSA-AES128-GCM-SHA256") != 1) ||
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+            (SSL_CTX_set_max_proto_version(server->ssl_context, TLS1_2_VERSION) != 1) ||
+#endif
+            ((server->certificate_pem = get_certificate_pem(certificate)) == NULL))
+        {
+            SSL_CTX_free(server->ssl_context);
+            server->ssl_context = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    return result;
+}
+
+static void serve_connection(BENCHMARK_SERVER* server, int socket)
+{
+    SSL* ssl = SSL_new(server->ssl_context);
+    int no_delay = 1;
+
+    if (ssl != NULL)
+    {
+        unsigned char request[4];
+
+        /* the last handshake flight and the reply must not wait for the client's delayed ACK */
+        if ((setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == 0) &&
+            (SSL_set_fd(ssl, socket) == 1) &&
+            (SSL_accept(ssl) == 1) &&
+            (SSL_read(ssl, request, sizeof(request)) == (int)sizeof(request)))
+        {
+            unsigned char record[SERVER_RECORD_SIZE];
+            /* the client asks for as many bytes as it wants to download */
+            size_t remaining = ((size_t)request[0] << 24) | ((size_t)request[1] << 16) | ((size_t)request[2] << 8) | (size_t)request[3];
+
+            if (Lock(server->stats_lock) == LOCK_OK)
+            {
+                server->handshakes++;
+                if (SSL_session_reused(ssl))
+                {
+                    server->resumed_handshakes++;
+                }
+                (void)Unlock(server->stats_lock);
+            }
+
+            (void)memset(record, 'x', sizeof(record));
+            while (remaining > 0)
+            {
+                int to_write = (int)((remaining < sizeof(record)) ? remaining : sizeof(record));
+
+                if (SSL_write(ssl, record, to_write) != to_write)
+                {
+                    break;
+                }
+                remaining -= (size_t)to_write;
+            }
+
+            while (SSL_read(ssl, request, sizeof(request)) > 0)
+            {
+                /* wait for the client to go away */
+            }
+        }
+
+        SSL_free(ssl);
+    }
+
+    (void)close(socket);
+}
+
+static int server_worker_thread(void* context)
+{
+    BENCHMARK_SERVER* server = (BENCHMARK_SERVER*)context;
+    int socket;
+
+    while ((socket = accept(server->listen_socket, NULL, NULL)) >= 0)
+    {
+        serve_connection(server, socket);
+    }
+
+    return 0;
+}
+
+static void reset_server_stats(BENCHMARK_SERVER* server)
+{
+    if (Lock(server->stats_lock) == LOCK_OK)
+    {
+        server->handshakes = 0;
+        server->resumed_handshakes = 0;
+        (void)Unlock(server->stats_lock);
+    }
+}
+
+static void stop_server_workers(BENCHMARK_SERVER* server)
+{
+    size_t i;
+    int thread_result;
+
+    /* unblocks accept in every worker */
+    (void)shutdown(server->listen_socket, SHUT_RDWR);
+
+    for (i = 0; i < server->worker_count; i++)
+    {
+        (void)ThreadAPI_Join(server->worker_threads[i], &thread_result);
+    }
+}
+
+static void free_server_ssl_context(BENCHMARK_SERVER* server)
+{
+    SSL_CTX_free(server->ssl_context);
+    free(server->certificate_pem);
+}
+
+static int start_server(BENCHMARK_SERVER* server)
+{
+    int result;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    server->worker_count = 0;
+    server->handshakes = 0;
+    server->resumed_handshakes = 0;
+
+    if (create_server_ssl_context(server) != 0)
+    {
+        (void)printf("Cannot create the server SSL context.\r\n");
+        result = __FAILURE__;
+    }
+    else if ((server->stats_lock = Lock_Init()) == NULL)
+    {
+        (void)printf("Cannot create the server statistics lock.\r\n");
+        free_server_ssl_context(server);
+        result = __FAILURE__;
+    }
+    else if ((server->listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        (void)printf("Cannot create the server socket.\r\n");
+        (void)Lock_Deinit(server->stats_lock);
+        free_server_ssl_context(server);
+        result = __FAILURE__;
+    }
+    else if ((bind(server->listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listen_socket, SOMAXCONN) != 0) ||
+        (getsockname(server->listen_socket, (struct sockaddr*)&address, &address_length) != 0))
+    {
+        (void)printf("Cannot listen on localhost.\r\n");
+        (void)close(server->listen_socket);
+        (void)Lock_Deinit(server->stats_lock);
+        free_server_ssl_context(server);
+        result = __FAILURE__;
+    }
+    else
+    {
+        while ((server->worker_count < SERVER_WORKERS) &&
+            (ThreadAPI_Create(&server->worker_threads[server->worker_count], server_worker_thread, server) == THREADAPI_OK))
+        {
+            server->worker_count++;
+        }
+
+        if (server->worker_count < SERVER_WORKERS)
+        {
+            (void)printf("Cannot start the server threads.\r\n");
+            stop_server_workers(server);
+            (void)close(server->listen_socket);
+            (void)Lock_Deinit(server->stats_lock);
+            free_server_ssl_context(server);
+            result = __FAILURE__;
+        }
+        else
+        {
+            server->port = ntohs(address.sin_port);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void stop_server(BENCHMARK_SERVER* server)
+{
+    stop_server_workers(server);
+    (void)close(server->listen_socket);
+    (void)Lock_Deinit(server->stats_lock);
+    free_server_ssl_context(server);
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    (void)clock_gettime(CLOCK_MONOTONIC, &client->open_end);
+    client->open_result = (open_result == IO_OPEN_OK) ? 1 : -1;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    (void)buffer;
+    client->received += size;
+    client->receive_callbacks++;
+}
+
+static void on_io_error(void* context)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    client->failed = true;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+
+    if (send_result != IO_SEND_OK)
+    {
+        client->failed = true;
+    }
+}
+
+static double get_elapsed_seconds(const struct timespec* start, const struct timespec* end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + ((double)(end->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+/* values must be sorted */
+static double get_percentile(const double* values, size_t count, double percentile)
+{
+    return values[(size_t)(((double)(count - 1) * percentile) + 0.5)];
+}
+
+static void pump_client(BENCHMARK_CLIENT* client)
+{
+    (void)xio_wait(client->tlsio, WAIT_TIMEOUT_MS, IO_WAIT_READ);
+    xio_dowork(client->tlsio);
+}
+
+/* Opens a connection, asks the server for download_size bytes and waits until they all arrived. */
+static int open_client(BENCHMARK_CLIENT* client, const BENCHMARK_SERVER* server, const BENCHMARK_TLSIO* benchmark_tlsio,
+    bool session_resumption, size_t receive_buffer_size, size_t download_size)
+{
+    int result;
+    TLSIO_CONFIG tlsio_config;
+    int tls_version = 12;
+
+    tlsio_config.hostname = "localhost";
+    tlsio_config.port = server->port;
+    tlsio_config.underlying_io_interface = NULL;
+    tlsio_config.underlying_io_parameters = NULL;
+
+    client->open_result = 0;
+    client->failed = false;
+    client->received = 0;
+    client->receive_callbacks = 0;
+
+    if ((client->tlsio = xio_create(benchmark_tlsio->get_interface_description(), &tlsio_config)) == NULL)
+    {
+        (void)printf("Error creating %s.\r\n", benchmark_tlsio->name);
+        result = __FAILURE__;
+    }
+    else if ((benchmark_tlsio->set_tls_version && (xio_setoption(client->tlsio, "tls_version", &tls_version) != 0)) ||
+        (xio_setoption(client->tlsio, OPTION_TRUSTED_CERT, server->certificate_pem) != 0) ||
+        (xio_setoption(client->tlsio, OPTION_TLS_SESSION_RESUMPTION, &session_resumption) != 0) ||
+        (xio_setoption(client->tlsio, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size) != 0))
+    {
+        (void)printf("Error setting %s options.\r\n", benchmark_tlsio->name);
+        xio_destroy(client->tlsio);
+        client->tlsio = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)clock_gettime(CLOCK_MONOTONIC, &client->open_start);
+
+        if (xio_open(client->tlsio, on_io_open_complete, client, on_io_bytes_received, client, on_io_error, client) != 0)
+        {
+            (void)printf("Error opening %s.\r\n", benchmark_tlsio->name);
+            xio_destroy(client->tlsio);
+            client->tlsio = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* the ClientHello goes out from the first dowork */
+            xio_dowork(client->tlsio);
+
+            while ((client->open_result == 0) && !client->failed)
+            {
+                pump_client(client);
+            }
+
+            if (client->open_result != 1)
+            {
+                (void)printf("%s open failed.\r\n", benchmark_tlsio->name);
+                xio_destroy(client->tlsio);
+                client->tlsio = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                unsigned char request[4];
+
+                request[0] = (unsigned char)(download_size >> 24);
+                request[1] = (unsigned char)(download_size >> 16);
+                request[2] = (unsigned char)(download_size >> 8);
+                request[3] = (unsigned char)download_size;
+
+                if (xio_send(client->tlsio, request, sizeof(request), on_send_complete, client) != 0)
+                {
+                    (void)printf("%s send failed.\r\n", benchmark_tlsio->name);
+                    client->failed = true;
+                }
+
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void close_client(BENCHMARK_CLIENT* client)
+{
+    (void)xio_close(client->tlsio, NULL, NULL);
+    xio_destroy(client->tlsio);
+    client->tlsio = NULL;
+}
+
+static int run_handshakes(BENCHMARK_SERVER* server, const BENCHMARK_TLSIO* benchmark_tlsio, bool session_resumption,
+    size_t opens, double* latencies, HANDSHAKE_RESULTS* results)
+{
+    int result = 0;
+    size_t i;
+    struct timespec wall_start;
+    struct timespec wall_end;
+
+    reset_server_stats(server);
+    (void)clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    for (i = 0; (result == 0) && (i < opens); i++)
+    {
+        BENCHMARK_CLIENT client;
+
+        /* one byte back proves the connection carries data, not only that the handshake finished */
+        if (open_client(&client, server, benchmark_tlsio, session_resumption, HANDSHAKE_RECEIVE_BUFFER_SIZE, 1) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            while (!client.failed && (client.received == 0))
+            {
+                pump_client(&client);
+            }
+
+            if (client.failed)
+            {
+                (void)printf("%s connection failed.\r\n", benchmark_tlsio->name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                latencies[i] = get_elapsed_seconds(&client.open_start, &client.open_end) * 1000.0;
+            }
+
+            close_client(&client);
+        }
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+    if (result == 0)
+    {
+        qsort(latencies, opens, sizeof(double), compare_doubles);
+
+        results->handshakes_per_second = (double)opens / get_elapsed_seconds(&wall_start, &wall_end);
+        results->p50_ms = get_percentile(latencies, opens, 0.50);
+        results->p99_ms = get_percentile(latencies, opens, 0.99);
+
+        /* the server counts a connection before replying, so they are all counted by now */
+        if (Lock(server->stats_lock) == LOCK_OK)
+        {
+            results->resumed_percent = (server->handshakes == 0) ? 0.0 : (100.0 * (double)server->resumed_handshakes / (double)server->handshakes);
+            (void)Unlock(server->stats_lock);
+        }
+    }
+
+    return result;
+}
+
+static int run_handshake_benchmark(BENCHMARK_SERVER* server, const BENCHMARK_TLSIO* benchmark_tlsio, size_t opens)
+{
+    int result;
+    double* latencies = (double*)malloc(opens * sizeof(double));
+
+    if (latencies == NULL)
+    {
+        (void)printf("Cannot allocate the handshake latencies.\r\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        HANDSHAKE_RESULTS full;
+        HANDSHAKE_RESULTS resumed;
+
+        if ((run_handshakes(server, benchmark_tlsio, false, opens, latencies, &full) != 0) ||
+            (run_handshakes(server, benchmark_tlsio, true, opens, latencies, &resumed) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)printf("%-14s full    %8.1f hs/s p50 %7.3f ms p99 %7.3f ms\r\n", benchmark_tlsio->name,
+                full.handshakes_per_second, full.p50_ms, full.p99_ms);
+            (void)printf("%-14s resumed %8.1f hs/s p50 %7.3f ms p99 %7.3f ms %5.1f%% resumed\r\n", benchmark_tlsio->name,
+                resumed.handshakes_per_second, resumed.p50_ms, resumed.p99_ms, resumed.resumed_percent);
+            result = 0;
+        }
+
+        free(latencies);
+    }
+
+    return result;
+}
+
+static int run_download(const BENCHMARK_SERVER* server, const BENCHMARK_TLSIO* benchmark_tlsio, size_t total_bytes, size_t receive_buffer_size)
+{
+    int result;
+    BENCHMARK_CLIENT client;
+
+    if (open_client(&client, server, benchmark_tlsio, false, receive_buffer_size, total_bytes) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        struct timespec wall_start;
+        struct timespec wall_end;
+        struct timespec cpu_start;
+        struct timespec cpu_end;
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+        while (!client.failed && (client.received < total_bytes))
+        {
+            pump_client(&client);
+        }
+
+        (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+        if (client.failed)
+        {
+            (void)printf("%-14s download failed\r\n", benchmark_tlsio->name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            double wall_seconds = get_elapsed_seconds(&wall_start, &wall_end);
+            double cpu_seconds = get_elapsed_seconds(&cpu_start, &cpu_end);
+            double megabytes = (double)total_bytes / 1e6;
+
+            (void)printf("%-14s %6lu B reads %10.1f MB/s %10.1f MB/s per core %8.0f B per callback\r\n", benchmark_tlsio->name,
+                (unsigned long)receive_buffer_size, megabytes / wall_seconds, megabytes / cpu_seconds,
+                (double)client.received / (double)client.receive_callbacks);
+            result = 0;
+        }
+
+        close_client(&client);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t total_bytes = (size_t)((argc > 1) ? atoi(argv[1]) : DEFAULT_TOTAL_MB) * 1024 * 1024;
+    /* 0 runs every size in benchmark_receive_buffer_sizes */
+    size_t receive_buffer_size = (size_t)((argc > 2) ? atoi(argv[2]) : 0);
+    size_t opens = (size_t)((argc > 3) ? atoi(argv[3]) : DEFAULT_OPENS);
+    const size_t* receive_buffer_sizes = (receive_buffer_size == 0) ? benchmark_receive_buffer_sizes : &receive_buffer_size;
+    size_t receive_buffer_size_count = (receive_buffer_size == 0) ? sizeof(benchmark_receive_buffer_sizes) / sizeof(benchmark_receive_buffer_sizes[0]) : 1;
+
+    /* the download request carries the size in 4 bytes */
+    if ((total_bytes == 0) || (total_bytes > UINT32_MAX) || (opens == 0))
+    {
+        (void)printf("usage: %s [MB per download, below 4096] [receive buffer size in bytes, 0 for all] [opens]\r\n", argv[0]);
+        result = __FAILURE__;
+    }
+    else if (platform_init() != 0)
+    {
+        (void)printf("Cannot initialize platform.\r\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BENCHMARK_SERVER server;
+
+        if (start_server(&server) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+            size_t j;
+
+            (void)printf("%lu opens per tlsio, then %lu MB downloads from localhost over TLS 1.2 ECDHE-ECDSA-AES128-GCM-SHA256\r\n",
+                (unsigned long)opens, (unsigned long)(total_bytes / (1024 * 1024)));
+
+            result = 0;
+            for (i = 0; i < sizeof(benchmark_tlsios) / sizeof(benchmark_tlsios[0]); i++)
+            {
+                if (run_handshake_benchmark(&server, &benchmark_tlsios[i], opens) != 0)
+                {
+                    result = __FAILURE__;
+                }
+            }
+
+            for (j = 0; j < receive_buffer_size_count; j++)
+            {
+                for (i = 0; i < sizeof(benchmark_tlsios) / sizeof(benchmark_tlsios[0]); i++)
+                {
+                    if (run_download(&server, &benchmark_tlsios[i], total_bytes, receive_buffer_sizes[j]) != 0)
+                    {
+                        result = __FAILURE__;
+                    }
+                }
+            }
+
+            stop_server(&server);
+        }
+
+        platform_deinit();
+    }
+
+    return result;
+}
@@ -0,0 +1,805 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Handshake and bulk upload benchmark for tlsio_openssl. An in-process OpenSSL server on localhost
+   accepts the connections. For each cipher suite it reports the rate and the p50/p99 open latency of
+   full and resumed handshakes made by N concurrent clients, and then the upload throughput and the
+   client side MB/s per CPU core for each chunk size and each of the tlsio_openssl I/O modes. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/x509.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+
+/* also the most concurrent clients, every server worker serves one connection at a time */
+#define MAX_SERVER_WORKERS          64
+#define MAX_OUTSTANDING_SENDS       8
+#define DEFAULT_TOTAL_MB            128
+#define DEFAULT_CLIENT_COUNT        16
+#define DEFAULT_OPENS_PER_CLIENT    64
+#define WAIT_TIMEOUT_MS             100
+
+typedef struct BENCHMARK_CIPHER_SUITE_TAG
+{
+    const char* name;
+    int tls_version;
+    /* the server only accepts this suite, the clients offer their defaults */
+    const char* cipher_list;
+    const char* ciphersuites;
+} BENCHMARK_CIPHER_SUITE;
+
+typedef struct BENCHMARK_SERVER_TAG
+{
+    SSL_CTX* ssl_context;
+    int listen_socket;
+    int port;
+    THREAD_HANDLE worker_threads[MAX_SERVER_WORKERS];
+    size_t worker_count;
+    LOCK_HANDLE stats_lock;
+    size_t handshakes;
+    size_t resumed_handshakes;
+} BENCHMARK_SERVER;
+
+typedef struct BENCHMARK_MODE_TAG
+{
+    const char* name;
+    bool socket_fast_path;
+    bool kernel_tls;
+} BENCHMARK_MODE;
+
+typedef struct BENCHMARK_CLIENT_TAG
+{
+    XIO_HANDLE tlsio;
+    int open_result;
+    size_t outstanding_sends;
+    bool failed;
+    /* the server greets every connection, which also brings in the TLS 1.3 session tickets */
+    bool greeted;
+    struct timespec open_start;
+    struct timespec open_end;
+} BENCHMARK_CLIENT;
+
+typedef struct HANDSHAKE_CLIENT_TAG
+{
+    BENCHMARK_CLIENT client;
+    THREAD_HANDLE thread;
+    int port;
+    const BENCHMARK_CIPHER_SUITE* cipher_suite;
+    bool session_resumption;
+    size_t opens;
+    /* one open latency in ms per open */
+    double* latencies;
+    int result;
+} HANDSHAKE_CLIENT;
+
+typedef struct HANDSHAKE_RESULTS_TAG
+{
+    double handshakes_per_second;
+    double p50_ms;
+    double p99_ms;
+    double resumed_percent;
+} HANDSHAKE_RESULTS;
+
+static const BENCHMARK_MODE benchmark_modes[] =
+{
+    { "memory BIOs", false, false },
+    { "socket BIO", true, false },
+    { "kTLS", false, true }
+};
+
+static const BENCHMARK_CIPHER_SUITE benchmark_cipher_suites[] =
+{
+    { "TLS 1.2 ECDHE-ECDSA-AES128-GCM-SHA256", 12, "ECDHE-ECDSA-AES128-GCM-SHA256", NULL },
+    { "TLS 1.2 ECDHE-ECDSA-AES256-GCM-SHA384", 12, "ECDHE-ECDSA-AES256-GCM-SHA384", NULL },
+    { "TLS 1.2 ECDHE-ECDSA-CHACHA20-POLY1305", 12, "ECDHE-ECDSA-CHACHA20-POLY1305", NULL },
+#if defined(TLS1_3_VERSION) && !defined(LIBRESSL_VERSION_NUMBER)
+    { "TLS 1.3 TLS_AES_128_GCM_SHA256", 13, NULL, "TLS_AES_128_GCM_SHA256" },
+    { "TLS 1.3 TLS_CHACHA20_POLY1305_SHA256", 13, NULL, "TLS_CHACHA20_POLY1305_SHA256" },
+#endif
+};
+
+static const size_t benchmark_chunk_sizes[] = { 1024, 4096, 16384, 65536 };
+
+static EVP_PKEY* create_server_key(void)
+{
+    EVP_PKEY* result = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+
+    if (key_context != NULL)
+    {
+        if ((EVP_PKEY_keygen_init(key_context) <= 0) ||
+            (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) <= 0) ||
+            (EVP_PKEY_keygen(key_context, &result) <= 0))
+        {
+            result = NULL;
+        }
+
+        EVP_PKEY_CTX_free(key_context);
+    }
+
+    return result;
+}
+
+static X509* create_server_certificate(EVP_PKEY* key)
+{
+    X509* result = X509_new();
+
+    if (result != NULL)
+    {
+        X509_NAME* name = X509_get_subject_name(result);
+
+        if ((X509_set_version(result, 2) != 1) ||
+            (ASN1_INTEGER_set(X509_get_serialNumber(result), 1) != 1) ||
+            (X509_gmtime_adj(X509_get_notBefore(result), 0) == NULL) ||
+            (X509_gmtime_adj(X509_get_notAfter(result), 24 * 3600) == NULL) ||
+            (X509_set_pubkey(result, key) != 1) ||
+            (X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0) != 1) ||
+            (X509_set_issuer_name(result, name) != 1) ||
+            (X509_sign(result, key, EVP_sha256()) == 0))
+        {
+            X509_free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static SSL_CTX* create_server_ssl_context(const BENCHMARK_CIPHER_SUITE* cipher_suite)
+{
+    SSL_CTX* result = SSL_CTX_new(SSLv23_server_method());
+
+    if (result != NULL)
+    {
+        EVP_PKEY* key = create_server_key();
+        X509* certificate = (key == NULL) ? NULL : create_server_certificate(key);
+
+        if ((certificate == NULL) ||
+            (SSL_CTX_use_certificate(result, certificate) != 1) ||
+            (SSL_CTX_use_PrivateKey(result, key) != 1) ||
+            ((cipher_suite->cipher_list != NULL) && (SSL_CTX_set_cipher_list(result, cipher_suite->cipher_list) != 1))
+#if defined(TLS1_3_VERSION) && !defined(LIBRESSL_VERSION_NUMBER)
+            || ((cipher_suite->ciphersuites != NULL) && (SSL_CTX_set_ciphersuites(result, cipher_suite->ciphersuites) != 1))
+#endif
+            )
+        {
+            SSL_CTX_free(result);
+            result = NULL;
+        }
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    return result;
+}
+
+static void serve_connection(BENCHMARK_SERVER* server, int socket)
+{
+    SSL* ssl = SSL_new(server->ssl_context);
+    int no_delay = 1;
+
+    if (ssl != NULL)
+    {
+        /* the last handshake flight and the greeting must not wait for the client's delayed ACK */
+        if ((setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == 0) &&
+            (SSL_set_fd(ssl, socket) == 1) &&
+            (SSL_accept(ssl) == 1))
+        {
+            unsigned char buffer[65536];
+
+            if (Lock(server->stats_lock) == LOCK_OK)
+            {
+                server->handshakes++;
+                if (SSL_session_reused(ssl))
+                {
+                    server->resumed_handshakes++;
+                }
+                (void)Unlock(server->stats_lock);
+            }
+
+            buffer[0] = '!';
+            if (SSL_write(ssl, buffer, 1) == 1)
+            {
+                while (SSL_read(ssl, buffer, sizeof(buffer)) > 0)
+                {
+                    /* the uploaded bytes are only decrypted and dropped */
+                }
+            }
+        }
+
+        SSL_free(ssl);
+    }
+
+    (void)close(socket);
+}
+
+static int server_worker_thread(void* context)
+{
+    BENCHMARK_SERVER* server = (BENCHMARK_SERVER*)context;
+    int socket;
+
+    while ((socket = accept(server->listen_socket, NULL, NULL)) >= 0)
+    {
+        serve_connection(server, socket);
+    }
+
+    return 0;
+}
+
+static void reset_server_stats(BENCHMARK_SERVER* server)
+{
+    if (Lock(server->stats_lock) == LOCK_OK)
+    {
+        server->handshakes = 0;
+        server->resumed_handshakes = 0;
+        (void)Unlock(server->stats_lock);
+    }
+}
+
+static void stop_server_workers(BENCHMARK_SERVER* server)
+{
+    size_t i;
+    int thread_result;
+
+    /* unblocks accept in every worker */
+    (void)shutdown(server->listen_socket, SHUT_RDWR);
+
+    for (i = 0; i < server->worker_count; i++)
+    {
+        (void)ThreadAPI_Join(server->worker_threads[i], &thread_result);
+    }
+}
+
+static int start_server(BENCHMARK_SERVER* server, const BENCHMARK_CIPHER_SUITE* cipher_suite)
+{
+    int result;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    server->worker_count = 0;
+    server->handshakes = 0;
+    server->resumed_handshakes = 0;
+
+    if ((server->ssl_context = create_server_ssl_context(cipher_suite)) == NULL)
+    {
+        (void)printf("Cannot create the server SSL context for %s.\r\n", cipher_suite->name);
+        result = __FAILURE__;
+    }
+    else if ((server->stats_lock = Lock_Init()) == NULL)
+    {
+        (void)printf("Cannot create the server statistics lock.\r\n");
+        SSL_CTX_free(server->ssl_context);
+        result = __FAILURE__;
+    }
+    else if ((server->listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        (void)printf("Cannot create the server socket.\r\n");
+        (void)Lock_Deinit(server->stats_lock);
+        SSL_CTX_free(server->ssl_context);
+        result = __FAILURE__;
+    }
+    else if ((bind(server->listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listen_socket, SOMAXCONN) != 0) ||
+        (getsockname(server->listen_socket, (struct sockaddr*)&address, &address_length) != 0))
+    {
+        (void)printf("Cannot listen on localhost.\r\n");
+        (void)close(server->listen_socket);
+        (void)Lock_Deinit(server->stats_lock);
+        SSL_CTX_free(server->ssl_context);
+        result = __FAILURE__;
+    }
+    else
+    {
+        while ((server->worker_count < MAX_SERVER_WORKERS) &&
+            (ThreadAPI_Create(&server->worker_threads[server->worker_count], server_worker_thread, server) == THREADAPI_OK))
+        {
+            server->worker_count++;
+        }
+
+        if (server->worker_count < MAX_SERVER_WORKERS)
+        {
+            (void)printf("Cannot start the server threads.\r\n");
+            stop_server_workers(server);
+            (void)close(server->listen_socket);
+            (void)Lock_Deinit(server->stats_lock);
+            SSL_CTX_free(server->ssl_context);
+            result = __FAILURE__;
+        }
+        else
+        {
+            server->port = ntohs(address.sin_port);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void stop_server(BENCHMARK_SERVER* server)
+{
+    stop_server_workers(server);
+    (void)close(server->listen_socket);
+    (void)Lock_Deinit(server->stats_lock);
+    SSL_CTX_free(server->ssl_context);
+}
+
+static int accept_any_certificate(X509_STORE_CTX* store_context, void* data)
+{
+    (void)store_context, (void)data;
+    return 1;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    (void)clock_gettime(CLOCK_MONOTONIC, &client->open_end);
+    client->open_result = (open_result == IO_OPEN_OK) ? 1 : -1;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    (void)buffer, (void)size;
+    client->greeted = true;
+}
+
+static void on_io_error(void* context)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    client->failed = true;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+
+    client->outstanding_sends--;
+    if (send_result != IO_SEND_OK)
+    {
+        client->failed = true;
+    }
+}
+
+static double get_elapsed_seconds(const struct timespec* start, const struct timespec* end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + ((double)(end->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+/* values must be sorted */
+static double get_percentile(const double* values, size_t count, double percentile)
+{
+    return values[(size_t)(((double)(count - 1) * percentile) + 0.5)];
+}
+
+static int start_client_open(BENCHMARK_CLIENT* client, int port, const BENCHMARK_CIPHER_SUITE* cipher_suite, const BENCHMARK_MODE* mode, bool session_resumption)
+{
+    int result;
+    TLSIO_CONFIG tlsio_config;
+
+    tlsio_config.hostname = "127.0.0.1";
+    tlsio_config.port = port;
+    tlsio_config.underlying_io_interface = NULL;
+    tlsio_config.underlying_io_parameters = NULL;
+
+    client->open_result = 0;
+    client->outstanding_sends = 0;
+    client->failed = false;
+    client->greeted = false;
+
+    if ((client->tlsio = xio_create(tlsio_openssl_get_interface_description(), &tlsio_config)) == NULL)
+    {
+        (void)printf("Error creating TLS IO.\r\n");
+        result = __FAILURE__;
+    }
+    else if ((xio_setoption(client->tlsio, "tls_version", &cipher_suite->tls_version) != 0) ||
+        (xio_setoption(client->tlsio, "tls_validation_callback", (const void*)accept_any_certificate) != 0) ||
+        (xio_setoption(client->tlsio, OPTION_TLS_SESSION_RESUMPTION, &session_resumption) != 0) ||
+        (xio_setoption(client->tlsio, OPTION_TLS_SOCKET_FAST_PATH, &mode->socket_fast_path) != 0) ||
+        (xio_setoption(client->tlsio, OPTION_TLS_KERNEL_TLS, &mode->kernel_tls) != 0))
+    {
+        (void)printf("Error setting TLS IO options.\r\n");
+        xio_destroy(client->tlsio);
+        client->tlsio = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)clock_gettime(CLOCK_MONOTONIC, &client->open_start);
+
+        if (xio_open(client->tlsio, on_io_open_complete, client, on_io_bytes_received, client, on_io_error, client) != 0)
+        {
+            (void)printf("Error opening TLS IO.\r\n");
+            xio_destroy(client->tlsio);
+            client->tlsio = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int open_client(BENCHMARK_CLIENT* client, int port, const BENCHMARK_CIPHER_SUITE* cipher_suite, const BENCHMARK_MODE* mode)
+{
+    int result;
+
+    if (start_client_open(client, port, cipher_suite, mode, false) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        while (client->open_result == 0)
+        {
+            (void)xio_wait(client->tlsio, WAIT_TIMEOUT_MS, IO_WAIT_READ);
+            xio_dowork(client->tlsio);
+        }
+
+        if (client->open_result != 1)
+        {
+            (void)printf("TLS IO open failed.\r\n");
+            xio_destroy(client->tlsio);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void close_client(BENCHMARK_CLIENT* client)
+{
+    (void)xio_close(client->tlsio, NULL, NULL);
+    xio_destroy(client->tlsio);
+    client->tlsio = NULL;
+}
+
+/* Opens, waits for the server greeting and closes again, as many times as asked. */
+static int handshake_client_thread(void* context)
+{
+    HANDSHAKE_CLIENT* handshake_client = (HANDSHAKE_CLIENT*)context;
+    BENCHMARK_CLIENT* client = &handshake_client->client;
+    size_t i;
+
+    handshake_client->result = 0;
+
+    for (i = 0; (handshake_client->result == 0) && (i < handshake_client->opens); i++)
+    {
+        if (start_client_open(client, handshake_client->port, handshake_client->cipher_suite, &benchmark_modes[0], handshake_client->session_resumption) != 0)
+        {
+            handshake_client->result = __FAILURE__;
+        }
+        else
+        {
+            /* the ClientHello goes out from the first dowork */
+            xio_dowork(client->tlsio);
+
+            while (!client->greeted && !client->failed && (client->open_result != -1))
+            {
+                (void)xio_wait(client->tlsio, WAIT_TIMEOUT_MS, IO_WAIT_READ);
+                xio_dowork(client->tlsio);
+            }
+
+            if (!client->greeted)
+            {
+                (void)printf("%-40s handshake failed\r\n", handshake_client->cipher_suite->name);
+                handshake_client->result = __FAILURE__;
+            }
+            else
+            {
+                handshake_client->latencies[i] = get_elapsed_seconds(&client->open_start, &client->open_end) * 1000.0;
+            }
+
+            close_client(client);
+        }
+    }
+
+    return 0;
+}
+
+/* client_count clients, each on its own thread, open opens_per_client connections one after the other. */
+static int run_handshakes(BENCHMARK_SERVER* server, const BENCHMARK_CIPHER_SUITE* cipher_suite, bool session_resumption,
+    HANDSHAKE_CLIENT* clients, size_t client_count, size_t opens_per_client, double* latencies, HANDSHAKE_RESULTS* results)
+{
+    int result = 0;
+    size_t started_count;
+    size_t i;
+    int thread_result;
+    struct timespec wall_start;
+    struct timespec wall_end;
+
+    reset_server_stats(server);
+    (void)clock_gettime(CLOCK_MONOTONIC, &wall_start);
+
+    for (started_count = 0; started_count < client_count; started_count++)
+    {
+        HANDSHAKE_CLIENT* handshake_client = &clients[started_count];
+
+        handshake_client->port = server->port;
+        handshake_client->cipher_suite = cipher_suite;
+        handshake_client->session_resumption = session_resumption;
+        handshake_client->opens = opens_per_client;
+        handshake_client->latencies = &latencies[started_count * opens_per_client];
+
+        if (ThreadAPI_Create(&handshake_client->thread, handshake_client_thread, handshake_client) != THREADAPI_OK)
+        {
+            (void)printf("Cannot start the client threads.\r\n");
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    for (i = 0; i < started_count; i++)
+    {
+        (void)ThreadAPI_Join(clients[i].thread, &thread_result);
+        if (clients[i].result != 0)
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+    if (result == 0)
+    {
+        size_t latency_count = client_count * opens_per_client;
+
+        qsort(latencies, latency_count, sizeof(double), compare_doubles);
+
+        results->handshakes_per_second = (double)latency_count / get_elapsed_seconds(&wall_start, &wall_end);
+        results->p50_ms = get_percentile(latencies, latency_count, 0.50);
+        results->p99_ms = get_percentile(latencies, latency_count, 0.99);
+
+        /* the workers count a connection before greeting the client, so they are all counted by now */
+        if (Lock(server->stats_lock) == LOCK_OK)
+        {
+            results->resumed_percent = (server->handshakes == 0) ? 0.0 : (100.0 * (double)server->resumed_handshakes / (double)server->handshakes);
+            (void)Unlock(server->stats_lock);
+        }
+    }
+
+    return result;
+}
+
+static int run_handshake_benchmark(BENCHMARK_SERVER* server, const BENCHMARK_CIPHER_SUITE* cipher_suite, size_t client_count, size_t opens_per_client)
+{
+    int result;
+    HANDSHAKE_CLIENT* clients = (HANDSHAKE_CLIENT*)malloc(client_count * sizeof(HANDSHAKE_CLIENT));
+    double* latencies = (double*)malloc(client_count * opens_per_client * sizeof(double));
+
+    if ((clients == NULL) || (latencies == NULL))
+    {
+        (void)printf("Cannot allocate the handshake clients.\r\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        HANDSHAKE_RESULTS full;
+        HANDSHAKE_RESULTS resumed;
+
+        if ((run_handshakes(server, cipher_suite, false, clients, client_count, opens_per_client, latencies, &full) != 0) ||
+            (run_handshakes(server, cipher_suite, true, clients, client_count, opens_per_client, latencies, &resumed) != 0))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)printf("%-40s full    %8.1f hs/s p50 %7.3f ms p99 %7.3f ms\r\n", cipher_suite->name,
+                full.handshakes_per_second, full.p50_ms, full.p99_ms);
+            (void)printf("%-40s resumed %8.1f hs/s p50 %7.3f ms p99 %7.3f ms %5.1f%% resumed\r\n", cipher_suite->name,
+                resumed.handshakes_per_second, resumed.p50_ms, resumed.p99_ms, resumed.resumed_percent);
+            result = 0;
+        }
+    }
+
+    free(latencies);
+    free(clients);
+
+    return result;
+}
+
+static int run_bulk_upload(int port, const BENCHMARK_CIPHER_SUITE* cipher_suite, const BENCHMARK_MODE* mode, size_t total_bytes, const unsigned char* chunk, size_t chunk_size)
+{
+    int result;
+    BENCHMARK_CLIENT client;
+
+    if (open_client(&client, port, cipher_suite, mode) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        struct timespec wall_start;
+        struct timespec wall_end;
+        struct timespec cpu_start;
+        struct timespec cpu_end;
+        size_t sent = 0;
+
+        /* the thread CPU clock also accounts for encryption the kernel does on behalf of send when kTLS is on */
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+
+        while (!client.failed &&
+            ((sent < total_bytes) || (client.outstanding_sends > 0)))
+        {
+            if ((sent < total_bytes) &&
+                (client.outstanding_sends < MAX_OUTSTANDING_SENDS))
+            {
+                size_t to_send = ((total_bytes - sent) < chunk_size) ? (total_bytes - sent) : chunk_size;
+
+                client.outstanding_sends++;
+                if (xio_send(client.tlsio, chunk, to_send, on_send_complete, &client) != 0)
+                {
+                    client.outstanding_sends--;
+                    client.failed = true;
+                }
+                else
+                {
+                    sent += to_send;
+                }
+            }
+            else
+            {
+                (void)xio_wait(client.tlsio, WAIT_TIMEOUT_MS, IO_WAIT_WRITE);
+                xio_dowork(client.tlsio);
+            }
+        }
+
+        (void)clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+        if (client.failed)
+        {
+            (void)printf("%-40s %-12s upload failed\r\n", cipher_suite->name, mode->name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            double wall_seconds = get_elapsed_seconds(&wall_start, &wall_end);
+            double cpu_seconds = get_elapsed_seconds(&cpu_start, &cpu_end);
+            double megabytes = (double)total_bytes / 1e6;
+
+            (void)printf("%-40s %-12s %6lu B chunks %10.1f MB/s %10.1f MB/s per core\r\n", cipher_suite->name, mode->name,
+                (unsigned long)chunk_size, megabytes / wall_seconds, megabytes / cpu_seconds);
+            result = 0;
+        }
+
+        close_client(&client);
+    }
+
+    return result;
+}
+
+static int run_cipher_suite(const BENCHMARK_CIPHER_SUITE* cipher_suite, size_t client_count, size_t opens_per_client,
+    size_t total_bytes, const unsigned char* chunk, const size_t* chunk_sizes, size_t chunk_size_count)
+{
+    int result;
+    BENCHMARK_SERVER server;
+
+    if (start_server(&server, cipher_suite) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+        size_t j;
+
+        result = run_handshake_benchmark(&server, cipher_suite, client_count, opens_per_client);
+
+        for (i = 0; i < chunk_size_count; i++)
+        {
+            for (j = 0; j < sizeof(benchmark_modes) / sizeof(benchmark_modes[0]); j++)
+            {
+                if (run_bulk_upload(server.port, cipher_suite, &benchmark_modes[j], total_bytes, chunk, chunk_sizes[i]) != 0)
+                {
+                    result = __FAILURE__;
+                }
+            }
+        }
+
+        stop_server(&server);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t total_bytes = (size_t)((argc > 1) ? atoi(argv[1]) : DEFAULT_TOTAL_MB) * 1024 * 1024;
+    /* 0 runs every size in benchmark_chunk_sizes */
+    size_t chunk_size = (size_t)((argc > 2) ? atoi(argv[2]) : 0);
+    size_t client_count = (size_t)((argc > 3) ? atoi(argv[3]) : DEFAULT_CLIENT_COUNT);
+    size_t opens_per_client = (size_t)((argc > 4) ? atoi(argv[4]) : DEFAULT_OPENS_PER_CLIENT);
+    const size_t* chunk_sizes = (chunk_size == 0) ? benchmark_chunk_sizes : &chunk_size;
+    size_t chunk_size_count = (chunk_size == 0) ? sizeof(benchmark_chunk_sizes) / sizeof(benchmark_chunk_sizes[0]) : 1;
+    size_t largest_chunk_size = chunk_sizes[chunk_size_count - 1];
+    unsigned char* chunk;
+
+    if ((total_bytes == 0) || (client_count == 0) || (client_count > MAX_SERVER_WORKERS) || (opens_per_client == 0))
+    {
+        (void)printf("usage: %s [MB per upload] [chunk size in bytes, 0 for all] [concurrent clients, at most %d] [opens per client]\r\n",
+            argv[0], MAX_SERVER_WORKERS);
+        result = __FAILURE__;
+    }
+    else if ((chunk = (unsigned char*)malloc(largest_chunk_size)) == NULL)
+    {
+        (void)printf("Cannot allocate the send chunk.\r\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memset(chunk, 'x', largest_chunk_size);
+
+        if (platform_init() != 0)
+        {
+            (void)printf("Cannot initialize platform.\r\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+
+            (void)printf("%lu clients x %lu opens per cipher suite, then %lu MB uploads to localhost\r\n",
+                (unsigned long)client_count, (unsigned long)opens_per_client, (unsigned long)(total_bytes / (1024 * 1024)));
+
+            result = 0;
+            for (i = 0; i < sizeof(benchmark_cipher_suites) / sizeof(benchmark_cipher_suites[0]); i++)
+            {
+                if (run_cipher_suite(&benchmark_cipher_suites[i], client_count, opens_per_client, total_bytes, chunk, chunk_sizes, chunk_size_count) != 0)
+                {
+                    result = __FAILURE__;
+                }
+            }
+
+            platform_deinit();
+        }
+
+        free(chunk);
+    }
+
+    return result;
+}
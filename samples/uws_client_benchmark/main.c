@@ -0,0 +1,1112 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Echo benchmark for uws_client and wsio. An in-process WebSocket echo server on localhost, over
+   plain TCP and over an OpenSSL server with a throwaway certificate, sends every message back.
+   For each driver (uws_client directly or wsio on top of it), transport, message size and
+   connection count it reports the echoed messages per second and the p50/p99/p999 round trip
+   latency. Every connection keeps one message in flight and all connections are driven
+   round-robin from the main thread, the way applications using this library call dowork.
+   When the library is built with memory_trace it also reports the heap allocations per echoed
+   message after one warm-up message per connection; the tracking makes every allocation slower,
+   so the rates of such a build are not comparable with a regular one. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/evp.h"
+#include "openssl/x509.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/wsio.h"
+#include "azure_c_shared_utility/uws_client.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/strings.h"
+
+/* also the most connections, every server worker serves one connection at a time */
+#define MAX_SERVER_WORKERS          64
+#define DEFAULT_MESSAGES_PER_RUN    20000
+#define DEFAULT_MB_PER_RUN          64
+/* so that the percentiles of the large message sizes still have some samples */
+#define MIN_MESSAGES_PER_RUN        100
+#define MAX_UPGRADE_REQUEST_SIZE    4096
+#define MAX_FRAME_HEADER_SIZE       10
+#define BENCHMARK_RESOURCE_NAME     "/echo"
+#define BENCHMARK_PROTOCOL          "echo"
+/* the tlsio_openssl default of TLS 1.0 is refused by current OpenSSL servers */
+#define BENCHMARK_TLS_VERSION       12
+
+typedef enum BENCHMARK_DRIVER_TAG
+{
+    BENCHMARK_DRIVER_UWS_CLIENT,
+    BENCHMARK_DRIVER_WSIO
+} BENCHMARK_DRIVER;
+
+typedef struct BENCHMARK_SERVER_TAG
+{
+    /* NULL for plain TCP */
+    SSL_CTX* ssl_context;
+    int listen_socket;
+    int port;
+    THREAD_HANDLE worker_threads[MAX_SERVER_WORKERS];
+    size_t worker_count;
+} BENCHMARK_SERVER;
+
+typedef struct SERVER_CONNECTION_TAG
+{
+    int socket;
+    SSL* ssl;
+} SERVER_CONNECTION;
+
+typedef struct BENCHMARK_CONNECTION_TAG
+{
+    BENCHMARK_DRIVER driver;
+    UWS_CLIENT_HANDLE uws_client;
+    XIO_HANDLE wsio;
+    int open_result;
+    bool failed;
+    bool message_in_flight;
+    size_t message_size;
+    /* wsio hands over the bytes of a message, which are counted until the whole echo is back */
+    size_t received_size;
+    size_t messages_left;
+    struct timespec send_time;
+    /* one round trip latency in us per echoed message */
+    double* latencies;
+    size_t latency_count;
+} BENCHMARK_CONNECTION;
+
+typedef struct RUN_RESULTS_TAG
+{
+    double messages_per_second;
+    double p50_us;
+    double p99_us;
+    double p999_us;
+    /* SIZE_MAX when the library does not track its allocations */
+    size_t allocation_count;
+} RUN_RESULTS;
+
+static const size_t benchmark_message_sizes[] = { 16, 128, 1024, 16384, 65536, 1024 * 1024 };
+static const size_t benchmark_connection_counts[] = { 1, 4, 16 };
+
+static EVP_PKEY* create_server_key(void)
+{
+    EVP_PKEY* result = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+
+    if (key_context != NULL)
+    {
+        if ((EVP_PKEY_keygen_init(key_context) <= 0) ||
+            (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) <= 0) ||
+            (EVP_PKEY_keygen(key_context, &result) <= 0))
+        {
+            result = NULL;
+        }
+
+        EVP_PKEY_CTX_free(key_context);
+    }
+
+    return result;
+}
+
+static X509* create_server_certificate(EVP_PKEY* key)
+{
+    X509* result = X509_new();
+
+    if (result != NULL)
+    {
+        X509_NAME* name = X509_get_subject_name(result);
+
+        if ((X509_set_version(result, 2) != 1) ||
+            (ASN1_INTEGER_set(X509_get_serialNumber(result), 1) != 1) ||
+            (X509_gmtime_adj(X509_get_notBefore(result), 0) == NULL) ||
+            (X509_gmtime_adj(X509_get_notAfter(result), 24 * 3600) == NULL) ||
+            (X509_set_pubkey(result, key) != 1) ||
+            (X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0) != 1) ||
+            (X509_set_issuer_name(result, name) != 1) ||
+            (X509_sign(result, key, EVP_sha256()) == 0))
+        {
+            X509_free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static SSL_CTX* create_server_ssl_context(void)
+{
+    SSL_CTX* result = SSL_CTX_new(SSLv23_server_method());
+
+    if (result != NULL)
+    {
+        EVP_PKEY* key = create_server_key();
+        X509* certificate = (key == NULL) ? NULL : create_server_certificate(key);
+
+        if ((certificate == NULL) ||
+            (SSL_CTX_use_certificate(result, certificate) != 1) ||
+            (SSL_CTX_use_PrivateKey(result, key) != 1))
+        {
+            SSL_CTX_free(result);
+            result = NULL;
+        }
+
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+    }
+
+    return result;
+}
+
+static int server_read(SERVER_CONNECTION* connection, unsigned char* buffer, size_t size)
+{
+    return (connection->ssl != NULL) ? SSL_read(connection->ssl, buffer, (int)size) : (int)recv(connection->socket, buffer, size, 0);
+}
+
+static int server_read_fully(SERVER_CONNECTION* connection, unsigned char* buffer, size_t size)
+{
+    int result = 0;
+    size_t read_size = 0;
+
+    while (read_size < size)
+    {
+        int read_result = server_read(connection, buffer + read_size, size - read_size);
+        if (read_result <= 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        read_size += (size_t)read_result;
+    }
+
+    return result;
+}
+
+static int server_write_fully(SERVER_CONNECTION* connection, const unsigned char* buffer, size_t size)
+{
+    int result = 0;
+    size_t written_size = 0;
+
+    while (written_size < size)
+    {
+        int write_result = (connection->ssl != NULL) ?
+            SSL_write(connection->ssl, buffer + written_size, (int)(size - written_size)) :
+            (int)send(connection->socket, buffer + written_size, size - written_size, MSG_NOSIGNAL);
+        if (write_result <= 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        written_size += (size_t)write_result;
+    }
+
+    return result;
+}
+
+/* answers the upgrade request with the Sec-WebSocket-Accept value uws_client checks */
+static int accept_upgrade(SERVER_CONNECTION* connection)
+{
+    static const char websocket_guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    int result;
+    char request[MAX_UPGRADE_REQUEST_SIZE + 1];
+    size_t request_length = 0;
+    const char* key;
+
+    request[0] = '\0';
+    while ((strstr(request, "\r\n\r\n") == NULL) && (request_length < MAX_UPGRADE_REQUEST_SIZE))
+    {
+        int read_result = server_read(connection, (unsigned char*)request + request_length, MAX_UPGRADE_REQUEST_SIZE - request_length);
+        if (read_result <= 0)
+        {
+            break;
+        }
+
+        request_length += (size_t)read_result;
+        request[request_length] = '\0';
+    }
+
+    if ((strstr(request, "\r\n\r\n") == NULL) ||
+        ((key = strstr(request, "Sec-WebSocket-Key: ")) == NULL))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        EVP_MD_CTX* digest_context = EVP_MD_CTX_new();
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int digest_length;
+        size_t key_length;
+        STRING_HANDLE accept_value = NULL;
+
+        key += sizeof("Sec-WebSocket-Key: ") - 1;
+        key_length = strcspn(key, "\r\n");
+
+        if ((digest_context == NULL) ||
+            (EVP_DigestInit_ex(digest_context, EVP_sha1(), NULL) != 1) ||
+            (EVP_DigestUpdate(digest_context, key, key_length) != 1) ||
+            (EVP_DigestUpdate(digest_context, websocket_guid, sizeof(websocket_guid) - 1) != 1) ||
+            (EVP_DigestFinal_ex(digest_context, digest, &digest_length) != 1) ||
+            ((accept_value = Base64_Encode_Bytes(digest, digest_length)) == NULL))
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            char response[256];
+            int response_length = snprintf(response, sizeof(response),
+                "HTTP/1.1 101 Switching Protocols\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Accept: %s\r\n"
+                "Sec-WebSocket-Protocol: " BENCHMARK_PROTOCOL "\r\n"
+                "\r\n", STRING_c_str(accept_value));
+
+            if ((response_length <= 0) ||
+                ((size_t)response_length >= sizeof(response)) ||
+                (server_write_fully(connection, (const unsigned char*)response, (size_t)response_length) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            STRING_delete(accept_value);
+        }
+
+        EVP_MD_CTX_free(digest_context);
+    }
+
+    return result;
+}
+
+/* Echoes every data frame until the client goes away. The payload is read MAX_FRAME_HEADER_SIZE bytes into
+   the frame buffer so the unmasked reply header can be put right in front of it and the reply is a single write. */
+static void echo_frames(SERVER_CONNECTION* connection)
+{
+    unsigned char* frame = NULL;
+    size_t frame_capacity = 0;
+    bool is_closed = false;
+
+    while (!is_closed)
+    {
+        unsigned char header[MAX_FRAME_HEADER_SIZE];
+        unsigned char mask_key[4];
+        uint64_t payload_length;
+        size_t i;
+
+        if (server_read_fully(connection, header, 2) != 0)
+        {
+            break;
+        }
+
+        payload_length = header[1] & 0x7F;
+        if (payload_length == 126)
+        {
+            if (server_read_fully(connection, header + 2, 2) != 0)
+            {
+                break;
+            }
+
+            payload_length = ((uint64_t)header[2] << 8) | header[3];
+        }
+        else if (payload_length == 127)
+        {
+            if (server_read_fully(connection, header + 2, 8) != 0)
+            {
+                break;
+            }
+
+            payload_length = 0;
+            for (i = 0; i < 8; i++)
+            {
+                payload_length = (payload_length << 8) | header[2 + i];
+            }
+        }
+
+        if (((header[1] & 0x80) == 0) ||
+            (server_read_fully(connection, mask_key, sizeof(mask_key)) != 0))
+        {
+            break;
+        }
+
+        if (MAX_FRAME_HEADER_SIZE + payload_length > frame_capacity)
+        {
+            unsigned char* new_frame = (unsigned char*)realloc(frame, (size_t)(MAX_FRAME_HEADER_SIZE + payload_length));
+            if (new_frame == NULL)
+            {
+                break;
+            }
+
+            frame = new_frame;
+            frame_capacity = (size_t)(MAX_FRAME_HEADER_SIZE + payload_length);
+        }
+
+        if (server_read_fully(connection, frame + MAX_FRAME_HEADER_SIZE, (size_t)payload_length) != 0)
+        {
+            break;
+        }
+        else
+        {
+            unsigned char opcode = header[0] & 0x0F;
+            unsigned char* payload = frame + MAX_FRAME_HEADER_SIZE;
+            size_t reply_header_length;
+
+            for (i = 0; i < payload_length; i++)
+            {
+                payload[i] ^= mask_key[i % 4];
+            }
+
+            if (opcode == 0x08)
+            {
+                /* the close frame goes back as it is, which completes the closing handshake */
+                is_closed = true;
+            }
+            else if (opcode == 0x09)
+            {
+                opcode = 0x0A;
+            }
+
+            if (payload_length < 126)
+            {
+                reply_header_length = 2;
+                payload[-1] = (unsigned char)payload_length;
+            }
+            else if (payload_length <= 0xFFFF)
+            {
+                reply_header_length = 4;
+                payload[-3] = 126;
+                payload[-2] = (unsigned char)(payload_length >> 8);
+                payload[-1] = (unsigned char)payload_length;
+            }
+            else
+            {
+                reply_header_length = 10;
+                payload[-9] = 127;
+                for (i = 0; i < 8; i++)
+                {
+                    payload[-8 + (int)i] = (unsigned char)(payload_length >> (56 - (8 * i)));
+                }
+            }
+
+            payload[-(int)reply_header_length] = (unsigned char)((header[0] & 0x80) | opcode);
+
+            if (server_write_fully(connection, payload - reply_header_length, reply_header_length + (size_t)payload_length) != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    free(frame);
+}
+
+static void serve_connection(BENCHMARK_SERVER* server, int socket)
+{
+    SERVER_CONNECTION connection;
+    int no_delay = 1;
+
+    connection.socket = socket;
+    connection.ssl = NULL;
+
+    /* small echoes must not wait for the client's delayed ACK */
+    if ((setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == 0) &&
+        ((server->ssl_context == NULL) ||
+         (((connection.ssl = SSL_new(server->ssl_context)) != NULL) &&
+          (SSL_set_fd(connection.ssl, socket) == 1) &&
+          (SSL_accept(connection.ssl) == 1))) &&
+        (accept_upgrade(&connection) == 0))
+    {
+        echo_frames(&connection);
+    }
+
+    if (connection.ssl != NULL)
+    {
+        SSL_free(connection.ssl);
+    }
+
+    (void)close(socket);
+}
+
+static int server_worker_thread(void* context)
+{
+    BENCHMARK_SERVER* server = (BENCHMARK_SERVER*)context;
+    int socket;
+
+    while ((socket = accept(server->listen_socket, NULL, NULL)) >= 0)
+    {
+        serve_connection(server, socket);
+    }
+
+    return 0;
+}
+
+static void stop_server_workers(BENCHMARK_SERVER* server)
+{
+    size_t i;
+    int thread_result;
+
+    /* unblocks accept in every worker */
+    (void)shutdown(server->listen_socket, SHUT_RDWR);
+
+    for (i = 0; i < server->worker_count; i++)
+    {
+        (void)ThreadAPI_Join(server->worker_threads[i], &thread_result);
+    }
+}
+
+static int start_server(BENCHMARK_SERVER* server, bool use_tls)
+{
+    int result;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    server->worker_count = 0;
+    server->ssl_context = NULL;
+
+    if (use_tls &&
+        ((server->ssl_context = create_server_ssl_context()) == NULL))
+    {
+        (void)printf("Cannot create the server SSL context.\r\n");
+        result = __FAILURE__;
+    }
+    else if ((server->listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        (void)printf("Cannot create the server socket.\r\n");
+        SSL_CTX_free(server->ssl_context);
+        result = __FAILURE__;
+    }
+    else if ((bind(server->listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listen_socket, SOMAXCONN) != 0) ||
+        (getsockname(server->listen_socket, (struct sockaddr*)&address, &address_length) != 0))
+    {
+        (void)printf("Cannot listen on localhost.\r\n");
+        (void)close(server->listen_socket);
+        SSL_CTX_free(server->ssl_context);
+        result = __FAILURE__;
+    }
+    else
+    {
+        while ((server->worker_count < MAX_SERVER_WORKERS) &&
+            (ThreadAPI_Create(&server->worker_threads[server->worker_count], server_worker_thread, server) == THREADAPI_OK))
+        {
+            server->worker_count++;
+        }
+
+        if (server->worker_count < MAX_SERVER_WORKERS)
+        {
+            (void)printf("Cannot start the server threads.\r\n");
+            stop_server_workers(server);
+            (void)close(server->listen_socket);
+            SSL_CTX_free(server->ssl_context);
+            result = __FAILURE__;
+        }
+        else
+        {
+            server->port = ntohs(address.sin_port);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void stop_server(BENCHMARK_SERVER* server)
+{
+    stop_server_workers(server);
+    (void)close(server->listen_socket);
+    SSL_CTX_free(server->ssl_context);
+}
+
+static int accept_any_certificate(X509_STORE_CTX* store_context, void* data)
+{
+    (void)store_context, (void)data;
+    return 1;
+}
+
+static double get_elapsed_seconds(const struct timespec* start, const struct timespec* end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + ((double)(end->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static int compare_doubles(const void* left, const void* right)
+{
+    double left_value = *(const double*)left;
+    double right_value = *(const double*)right;
+
+    return (left_value < right_value) ? -1 : ((left_value > right_value) ? 1 : 0);
+}
+
+/* values must be sorted */
+static double get_percentile(const double* values, size_t count, double percentile)
+{
+    return values[(size_t)(((double)(count - 1) * percentile) + 0.5)];
+}
+
+static void complete_message(BENCHMARK_CONNECTION* connection)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    connection->latencies[connection->latency_count++] = get_elapsed_seconds(&connection->send_time, &now) * 1e6;
+    connection->message_in_flight = false;
+}
+
+static void on_ws_open_complete(void* context, WS_OPEN_RESULT open_result)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    connection->open_result = (open_result == WS_OPEN_OK) ? 1 : -1;
+}
+
+static void on_ws_frame_received(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    (void)buffer;
+
+    if ((frame_type != WS_FRAME_TYPE_BINARY) ||
+        !connection->message_in_flight ||
+        (size != connection->message_size))
+    {
+        connection->failed = true;
+    }
+    else
+    {
+        complete_message(connection);
+    }
+}
+
+static void on_ws_peer_closed(void* context, uint16_t* close_code, const unsigned char* extra_data, size_t extra_data_length)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    (void)close_code, (void)extra_data, (void)extra_data_length;
+    connection->failed = true;
+}
+
+static void on_ws_error(void* context, WS_ERROR error_code)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    (void)error_code;
+    connection->failed = true;
+}
+
+static void on_ws_send_frame_complete(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+
+    if (ws_send_frame_result != WS_SEND_FRAME_OK)
+    {
+        connection->failed = true;
+    }
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    connection->open_result = (open_result == IO_OPEN_OK) ? 1 : -1;
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    (void)buffer;
+
+    connection->received_size += size;
+    if (!connection->message_in_flight ||
+        (connection->received_size > connection->message_size))
+    {
+        connection->failed = true;
+    }
+    else if (connection->received_size == connection->message_size)
+    {
+        connection->received_size = 0;
+        complete_message(connection);
+    }
+}
+
+static void on_io_error(void* context)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+    connection->failed = true;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    BENCHMARK_CONNECTION* connection = (BENCHMARK_CONNECTION*)context;
+
+    if (send_result != IO_SEND_OK)
+    {
+        connection->failed = true;
+    }
+}
+
+static void connection_dowork(BENCHMARK_CONNECTION* connection)
+{
+    if (connection->driver == BENCHMARK_DRIVER_UWS_CLIENT)
+    {
+        uws_client_dowork(connection->uws_client);
+    }
+    else
+    {
+        xio_dowork(connection->wsio);
+    }
+}
+
+static void destroy_connection(BENCHMARK_CONNECTION* connection)
+{
+    if (connection->driver == BENCHMARK_DRIVER_UWS_CLIENT)
+    {
+        uws_client_destroy(connection->uws_client);
+        connection->uws_client = NULL;
+    }
+    else
+    {
+        xio_destroy(connection->wsio);
+        connection->wsio = NULL;
+    }
+}
+
+static int create_connection(BENCHMARK_CONNECTION* connection, BENCHMARK_DRIVER driver, int port, bool use_tls)
+{
+    int result;
+    int tls_version = BENCHMARK_TLS_VERSION;
+
+    connection->driver = driver;
+    connection->uws_client = NULL;
+    connection->wsio = NULL;
+    connection->open_result = 0;
+    connection->failed = false;
+    connection->message_in_flight = false;
+    connection->received_size = 0;
+
+    if (driver == BENCHMARK_DRIVER_UWS_CLIENT)
+    {
+        WS_PROTOCOL protocol;
+
+        protocol.protocol = BENCHMARK_PROTOCOL;
+
+        if ((connection->uws_client = uws_client_create("127.0.0.1", (unsigned int)port, BENCHMARK_RESOURCE_NAME, use_tls, &protocol, 1)) == NULL)
+        {
+            (void)printf("Error creating uws_client.\r\n");
+            result = __FAILURE__;
+        }
+        else if (use_tls &&
+            ((uws_client_set_option(connection->uws_client, "tls_version", &tls_version) != 0) ||
+             (uws_client_set_option(connection->uws_client, "tls_validation_callback", (const void*)accept_any_certificate) != 0)))
+        {
+            (void)printf("Error setting uws_client options.\r\n");
+            destroy_connection(connection);
+            result = __FAILURE__;
+        }
+        else if (uws_client_open_async(connection->uws_client, on_ws_open_complete, connection, on_ws_frame_received, connection,
+            on_ws_peer_closed, connection, on_ws_error, connection) != 0)
+        {
+            (void)printf("Error opening uws_client.\r\n");
+            destroy_connection(connection);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    else
+    {
+        SOCKETIO_CONFIG socketio_config;
+        TLSIO_CONFIG tlsio_config;
+        WSIO_CONFIG wsio_config;
+
+        socketio_config.hostname = "127.0.0.1";
+        socketio_config.port = port;
+        socketio_config.accepted_socket = NULL;
+
+        tlsio_config.hostname = "127.0.0.1";
+        tlsio_config.port = port;
+        tlsio_config.underlying_io_interface = NULL;
+        tlsio_config.underlying_io_parameters = NULL;
+
+        wsio_config.underlying_io_interface = use_tls ? platform_get_default_tlsio() : socketio_get_interface_description();
+        wsio_config.underlying_io_parameters = use_tls ? (void*)&tlsio_config : (void*)&socketio_config;
+        wsio_config.hostname = "127.0.0.1";
+        wsio_config.port = port;
+        wsio_config.resource_name = BENCHMARK_RESOURCE_NAME;
+        wsio_config.protocol = BENCHMARK_PROTOCOL;
+
+        if ((connection->wsio = xio_create(wsio_get_interface_description(), &wsio_config)) == NULL)
+        {
+            (void)printf("Error creating wsio.\r\n");
+            result = __FAILURE__;
+        }
+        else if (use_tls &&
+            ((xio_setoption(connection->wsio, "tls_version", &tls_version) != 0) ||
+             (xio_setoption(connection->wsio, "tls_validation_callback", (const void*)accept_any_certificate) != 0)))
+        {
+            (void)printf("Error setting wsio options.\r\n");
+            destroy_connection(connection);
+            result = __FAILURE__;
+        }
+        else if (xio_open(connection->wsio, on_io_open_complete, connection, on_io_bytes_received, connection, on_io_error, connection) != 0)
+        {
+            (void)printf("Error opening wsio.\r\n");
+            destroy_connection(connection);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int send_message(BENCHMARK_CONNECTION* connection, const unsigned char* message)
+{
+    int result;
+
+    connection->message_in_flight = true;
+    (void)clock_gettime(CLOCK_MONOTONIC, &connection->send_time);
+
+    if (connection->driver == BENCHMARK_DRIVER_UWS_CLIENT)
+    {
+        result = uws_client_send_frame_async(connection->uws_client, WS_FRAME_TYPE_BINARY, message, connection->message_size, true, on_ws_send_frame_complete, connection);
+    }
+    else
+    {
+        result = xio_send(connection->wsio, message, connection->message_size, on_send_complete, connection);
+    }
+
+    if (result != 0)
+    {
+        connection->message_in_flight = false;
+        connection->failed = true;
+    }
+    else
+    {
+        connection->messages_left--;
+    }
+
+    return result;
+}
+
+/* Keeps one message in flight on every connection until all of them have echoed their messages_left messages. */
+static void echo_messages(BENCHMARK_CONNECTION* connections, size_t connection_count, const unsigned char* message)
+{
+    size_t i;
+    bool is_running;
+
+    do
+    {
+        is_running = false;
+        for (i = 0; i < connection_count; i++)
+        {
+            BENCHMARK_CONNECTION* connection = &connections[i];
+
+            if (!connection->failed)
+            {
+                if (!connection->message_in_flight &&
+                    (connection->messages_left > 0))
+                {
+                    (void)send_message(connection, message);
+                }
+
+                connection_dowork(connection);
+
+                if (connection->message_in_flight ||
+                    (connection->messages_left > 0))
+                {
+                    is_running = true;
+                }
+            }
+        }
+    } while (is_running);
+}
+
+/* Opens connection_count connections, then echoes messages_per_connection messages of message_size bytes over each of them. */
+static int run_echoes(BENCHMARK_DRIVER driver, int port, bool use_tls, BENCHMARK_CONNECTION* connections, size_t connection_count,
+    const unsigned char* message, size_t message_size, size_t messages_per_connection, double* latencies, RUN_RESULTS* results)
+{
+    int result = 0;
+    size_t created_count;
+    size_t i;
+    bool is_running;
+
+    for (created_count = 0; created_count < connection_count; created_count++)
+    {
+        if (create_connection(&connections[created_count], driver, port, use_tls) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    do
+    {
+        is_running = false;
+        for (i = 0; i < created_count; i++)
+        {
+            if (connections[i].open_result == 0)
+            {
+                connection_dowork(&connections[i]);
+                is_running = true;
+            }
+        }
+    } while (is_running);
+
+    for (i = 0; i < created_count; i++)
+    {
+        if (connections[i].open_result != 1)
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    if (result == 0)
+    {
+        struct timespec wall_start;
+        struct timespec wall_end;
+
+        /* the warm-up message lets the pending send records and list nodes reach their steady state */
+        for (i = 0; i < connection_count; i++)
+        {
+            connections[i].message_size = message_size;
+            connections[i].messages_left = 1;
+            connections[i].latencies = &latencies[i * messages_per_connection];
+            connections[i].latency_count = 0;
+        }
+
+        echo_messages(connections, connection_count, message);
+
+        for (i = 0; i < connection_count; i++)
+        {
+            connections[i].messages_left = messages_per_connection;
+            connections[i].latency_count = 0;
+        }
+
+        gballoc_resetMetrics();
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        echo_messages(connections, connection_count, message);
+        (void)clock_gettime(CLOCK_MONOTONIC, &wall_end);
+        results->allocation_count = gballoc_getAllocationCount();
+
+        for (i = 0; i < connection_count; i++)
+        {
+            if (connections[i].failed)
+            {
+                result = __FAILURE__;
+            }
+        }
+
+        if (result == 0)
+        {
+            size_t latency_count = connection_count * messages_per_connection;
+
+            qsort(latencies, latency_count, sizeof(double), compare_doubles);
+
+            results->messages_per_second = (double)latency_count / get_elapsed_seconds(&wall_start, &wall_end);
+            results->p50_us = get_percentile(latencies, latency_count, 0.50);
+            results->p99_us = get_percentile(latencies, latency_count, 0.99);
+            results->p999_us = get_percentile(latencies, latency_count, 0.999);
+        }
+    }
+
+    for (i = 0; i < created_count; i++)
+    {
+        /* closing only closes the underlying IO, which ends the connection on the server */
+        if (driver == BENCHMARK_DRIVER_UWS_CLIENT)
+        {
+            (void)uws_client_close_async(connections[i].uws_client, NULL, NULL);
+        }
+        else
+        {
+            (void)xio_close(connections[i].wsio, NULL, NULL);
+        }
+
+        destroy_connection(&connections[i]);
+    }
+
+    return result;
+}
+
+static int run_transport(bool use_tls, size_t messages_per_run, size_t bytes_per_run, const unsigned char* message,
+    const size_t* message_sizes, size_t message_size_count, const size_t* connection_counts, size_t connection_count_count)
+{
+    static const BENCHMARK_DRIVER drivers[] = { BENCHMARK_DRIVER_UWS_CLIENT, BENCHMARK_DRIVER_WSIO };
+    int result;
+    BENCHMARK_SERVER server;
+
+    if (start_server(&server, use_tls) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+        size_t j;
+        size_t k;
+
+        result = 0;
+        for (i = 0; i < sizeof(drivers) / sizeof(drivers[0]); i++)
+        {
+            const char* driver_name = (drivers[i] == BENCHMARK_DRIVER_UWS_CLIENT) ? "uws_client" : "wsio";
+
+            for (j = 0; j < message_size_count; j++)
+            {
+                for (k = 0; k < connection_count_count; k++)
+                {
+                    size_t connection_count = connection_counts[k];
+                    size_t message_count = (bytes_per_run / message_sizes[j] < messages_per_run) ? (bytes_per_run / message_sizes[j]) : messages_per_run;
+                    size_t messages_per_connection;
+                    BENCHMARK_CONNECTION* connections;
+                    double* latencies;
+
+                    if (message_count < MIN_MESSAGES_PER_RUN)
+                    {
+                        message_count = MIN_MESSAGES_PER_RUN;
+                    }
+
+                    messages_per_connection = (message_count + connection_count - 1) / connection_count;
+                    connections = (BENCHMARK_CONNECTION*)malloc(connection_count * sizeof(BENCHMARK_CONNECTION));
+                    latencies = (double*)malloc(connection_count * messages_per_connection * sizeof(double));
+
+                    if ((connections == NULL) || (latencies == NULL))
+                    {
+                        (void)printf("Cannot allocate the connections.\r\n");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        RUN_RESULTS results;
+
+                        if (run_echoes(drivers[i], server.port, use_tls, connections, connection_count, message, message_sizes[j],
+                            messages_per_connection, latencies, &results) != 0)
+                        {
+                            (void)printf("%-10s %-5s %8lu B %3lu conn echo failed\r\n", driver_name, use_tls ? "tls" : "plain",
+                                (unsigned long)message_sizes[j], (unsigned long)connection_count);
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            char allocations_per_message[16];
+
+                            if (results.allocation_count == SIZE_MAX)
+                            {
+                                (void)strcpy(allocations_per_message, "n/a");
+                            }
+                            else
+                            {
+                                (void)snprintf(allocations_per_message, sizeof(allocations_per_message), "%.2f",
+                                    (double)results.allocation_count / (double)(connection_count * messages_per_connection));
+                            }
+
+                            (void)printf("%-10s %-5s %8lu B %3lu conn %10.1f msg/s p50 %9.1f us p99 %9.1f us p999 %9.1f us allocs/msg %s\r\n", driver_name, use_tls ? "tls" : "plain",
+                                (unsigned long)message_sizes[j], (unsigned long)connection_count,
+                                results.messages_per_second, results.p50_us, results.p99_us, results.p999_us, allocations_per_message);
+                        }
+                    }
+
+                    free(latencies);
+                    free(connections);
+                }
+            }
+        }
+
+        stop_server(&server);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t messages_per_run = (size_t)((argc > 1) ? atoi(argv[1]) : DEFAULT_MESSAGES_PER_RUN);
+    size_t bytes_per_run = (size_t)((argc > 2) ? atoi(argv[2]) : DEFAULT_MB_PER_RUN) * 1024 * 1024;
+    /* 0 runs every size in benchmark_message_sizes */
+    size_t message_size = (size_t)((argc > 3) ? atoi(argv[3]) : 0);
+    /* 0 runs every count in benchmark_connection_counts */
+    size_t connection_count = (size_t)((argc > 4) ? atoi(argv[4]) : 0);
+    const size_t* message_sizes = (message_size == 0) ? benchmark_message_sizes : &message_size;
+    size_t message_size_count = (message_size == 0) ? sizeof(benchmark_message_sizes) / sizeof(benchmark_message_sizes[0]) : 1;
+    const size_t* connection_counts = (connection_count == 0) ? benchmark_connection_counts : &connection_count;
+    size_t connection_count_count = (connection_count == 0) ? sizeof(benchmark_connection_counts) / sizeof(benchmark_connection_counts[0]) : 1;
+    size_t largest_message_size = message_sizes[message_size_count - 1];
+    unsigned char* message;
+
+    if ((messages_per_run == 0) || (bytes_per_run == 0) || (connection_count > MAX_SERVER_WORKERS))
+    {
+        (void)printf("usage: %s [messages per run] [MB per run] [message size in bytes, 0 for all] [connections, at most %d, 0 for all]\r\n",
+            argv[0], MAX_SERVER_WORKERS);
+        result = __FAILURE__;
+    }
+    else if (gballoc_init() != 0)
+    {
+        (void)printf("Cannot initialize the allocation tracking.\r\n");
+        result = __FAILURE__;
+    }
+    else if ((message = (unsigned char*)malloc(largest_message_size)) == NULL)
+    {
+        (void)printf("Cannot allocate the message.\r\n");
+        gballoc_deinit();
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memset(message, 'x', largest_message_size);
+
+        if (platform_init() != 0)
+        {
+            (void)printf("Cannot initialize platform.\r\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)printf("at most %lu messages or %lu MB per run, at least %d messages, echoed by localhost\r\n",
+                (unsigned long)messages_per_run, (unsigned long)(bytes_per_run / (1024 * 1024)), MIN_MESSAGES_PER_RUN);
+
+            result = 0;
+            if (run_transport(false, messages_per_run, bytes_per_run, message, message_sizes, message_size_count, connection_counts, connection_count_count) != 0)
+            {
+                result = __FAILURE__;
+            }
+
+            if (run_transport(true, messages_per_run, bytes_per_run, message, message_sizes, message_size_count, connection_counts, connection_count_count) != 0)
+            {
+                result = __FAILURE__;
+            }
+
+            platform_deinit();
+        }
+
+        free(message);
+        gballoc_deinit();
+    }
+
+    return result;
+}
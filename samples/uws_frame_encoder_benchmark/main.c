@@ -0,0 +1,202 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Masking benchmark for uws_frame_encoder. For each payload size it reports the MB/s of the
+   byte by byte masking loop the encoder used to have, of uws_frame_encoder_mask, of a whole
+   masked uws_frame_encoder_encode including the frame buffer allocation, and of
+   uws_frame_encoder_encode_header followed by masking into a reused buffer, which is what
+   uws_client does for large frames. */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/uws_frame_encoder.h"
+
+#define DEFAULT_TOTAL_MB            256
+
+static const size_t benchmark_payload_sizes[] = { 16, 125, 1024, 16384, 65536, 1024 * 1024, 16 * 1024 * 1024 };
+
+/* keeps the compiler from dropping work whose result is never looked at */
+static volatile unsigned char sink;
+
+static double get_elapsed_seconds(const struct timespec* start, const struct timespec* end)
+{
+    return (double)(end->tv_sec - start->tv_sec) + ((double)(end->tv_nsec - start->tv_nsec) / 1e9);
+}
+
+static void mask_byte_by_byte(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* mask_key)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        destination[i] = source[i] ^ mask_key[i % 4];
+    }
+}
+
+static double run_byte_by_byte(unsigned char* destination, const unsigned char* source, size_t payload_size, size_t iterations, const unsigned char* mask_key)
+{
+    struct timespec start;
+    struct timespec end;
+    size_t i;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        mask_byte_by_byte(destination, source, payload_size, mask_key);
+        sink = destination[i % payload_size];
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return get_elapsed_seconds(&start, &end);
+}
+
+static double run_mask(unsigned char* destination, const unsigned char* source, size_t payload_size, size_t iterations, const unsigned char* mask_key)
+{
+    struct timespec start;
+    struct timespec end;
+    size_t i;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        uws_frame_encoder_mask(destination, source, payload_size, mask_key, 0);
+        sink = destination[i % payload_size];
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return get_elapsed_seconds(&start, &end);
+}
+
+static double run_encode(const unsigned char* source, size_t payload_size, size_t iterations)
+{
+    struct timespec start;
+    struct timespec end;
+    size_t i;
+    double result = 0.0;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        BUFFER_HANDLE frame = uws_frame_encoder_encode(WS_BINARY_FRAME, source, payload_size, true, true, 0);
+        if (frame == NULL)
+        {
+            (void)printf("uws_frame_encoder_encode failed.\r\n");
+            result = -1.0;
+            break;
+        }
+
+        sink = BUFFER_u_char(frame)[BUFFER_length(frame) - 1];
+        BUFFER_delete(frame);
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (result == 0.0)
+    {
+        result = get_elapsed_seconds(&start, &end);
+    }
+
+    return result;
+}
+
+static double run_encode_header(unsigned char* destination, const unsigned char* source, size_t payload_size, size_t iterations)
+{
+    struct timespec start;
+    struct timespec end;
+    size_t i;
+    double result = 0.0;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < iterations; i++)
+    {
+        unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+        size_t header_length;
+
+        if (uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, payload_size, true, true, 0, &header_length) != 0)
+        {
+            (void)printf("uws_frame_encoder_encode_header failed.\r\n");
+            result = -1.0;
+            break;
+        }
+
+        uws_frame_encoder_mask(destination, source, payload_size, header + header_length - 4, 0);
+        sink = destination[i % payload_size];
+    }
+    (void)clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (result == 0.0)
+    {
+        result = get_elapsed_seconds(&start, &end);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t total_bytes = (size_t)((argc > 1) ? atoi(argv[1]) : DEFAULT_TOTAL_MB) * 1024 * 1024;
+    size_t largest_payload_size = benchmark_payload_sizes[sizeof(benchmark_payload_sizes) / sizeof(benchmark_payload_sizes[0]) - 1];
+    unsigned char* source;
+    unsigned char* destination = NULL;
+
+    if (total_bytes == 0)
+    {
+        (void)printf("usage: %s [MB masked per payload size]\r\n", argv[0]);
+        result = __FAILURE__;
+    }
+    else if (((source = (unsigned char*)malloc(largest_payload_size)) == NULL) ||
+        ((destination = (unsigned char*)malloc(largest_payload_size)) == NULL))
+    {
+        (void)printf("Cannot allocate the payload buffers.\r\n");
+        free(source);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const unsigned char mask_key[] = { 0x37, 0xFA, 0x21, 0x3D };
+        size_t i;
+
+        for (i = 0; i < largest_payload_size; i++)
+        {
+            source[i] = (unsigned char)i;
+        }
+
+        (void)printf("%lu MB masked per payload size\r\n", (unsigned long)(total_bytes / (1024 * 1024)));
+        (void)printf("%10s %16s %16s %16s %16s\r\n", "payload", "byte by byte", "mask", "encode", "header + mask");
+
+        result = 0;
+        for (i = 0; i < sizeof(benchmark_payload_sizes) / sizeof(benchmark_payload_sizes[0]); i++)
+        {
+            size_t payload_size = benchmark_payload_sizes[i];
+            size_t iterations = (total_bytes / payload_size == 0) ? 1 : (total_bytes / payload_size);
+            double megabytes = ((double)payload_size * (double)iterations) / 1e6;
+            double byte_by_byte_seconds = run_byte_by_byte(destination, source, payload_size, iterations, mask_key);
+            double mask_seconds = run_mask(destination, source, payload_size, iterations, mask_key);
+            double encode_seconds = run_encode(source, payload_size, iterations);
+            double encode_header_seconds = run_encode_header(destination, source, payload_size, iterations);
+
+            if ((encode_seconds < 0.0) ||
+                (encode_header_seconds < 0.0))
+            {
+                result = __FAILURE__;
+                break;
+            }
+
+            (void)printf("%10lu %11.1f MB/s %11.1f MB/s %11.1f MB/s %11.1f MB/s\r\n", (unsigned long)payload_size,
+                megabytes / byte_by_byte_seconds, megabytes / mask_seconds, megabytes / encode_seconds, megabytes / encode_header_seconds);
+        }
+
+        free(destination);
+        free(source);
+    }
+
+    return result;
+}
@@ -940,6 +940,43 @@ static OPTIONHANDLER_HANDLE http_proxy_io_retrieve_options(CONCRETE_IO_HANDLE ht
     return result;
 }
 
+static int http_proxy_io_wait(CONCRETE_IO_HANDLE http_proxy_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (http_proxy_io == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_11_002: [ If the `http_proxy_io` argument is NULL, `http_proxy_io_wait` shall return a non-zero value. ]*/
+        LogError("NULL http_proxy_io.");
+        result = __LINE__;
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        if (http_proxy_io_instance->http_proxy_io_state == HTTP_PROXY_IO_STATE_CLOSED)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_11_003: [ If the IO is not open (no open has been called or the IO has been closed) then `http_proxy_io_wait` shall return a non-zero value. ]*/
+            LogError("http_proxy_io_wait called while closed.");
+            result = __LINE__;
+        }
+        /* Codes_SRS_HTTP_PROXY_IO_11_001: [ `http_proxy_io_wait` shall call `xio_wait` on the underlying IO created in `http_proxy_io_create`, passing `timeout_ms` and `interest` to it. ]*/
+        else if (xio_wait(http_proxy_io_instance->underlying_io, timeout_ms, interest) != 0)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_11_004: [ If `xio_wait` fails, `http_proxy_io_wait` shall return a non-zero value. ]*/
+            LogError("Failed waiting on the underlying IO.");
+            result = __LINE__;
+        }
+        else
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_11_005: [ On success, `http_proxy_io_wait` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION http_proxy_io_interface_description =
 {
     http_proxy_io_retrieve_options,
@@ -949,11 +986,13 @@ static const IO_INTERFACE_DESCRIPTION http_proxy_io_interface_description =
     http_proxy_io_close,
     http_proxy_io_send,
     http_proxy_io_dowork,
-    http_proxy_io_set_option
+    http_proxy_io_set_option,
+    http_proxy_io_wait
 };
 
 const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
 {
     /* Codes_SRS_HTTP_PROXY_IO_01_049: [ `http_proxy_io_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `http_proxy_io_retrieve_options`, `http_proxy_io_retrieve_create`, `http_proxy_io_destroy`, `http_proxy_io_open`, `http_proxy_io_close`, `http_proxy_io_send` and `http_proxy_io_dowork`. ]*/
+    /* Codes_SRS_HTTP_PROXY_IO_11_006: [ The `concrete_io_wait` member of the structure shall point to `http_proxy_io_wait`. ]*/
     return &http_proxy_io_interface_description;
 }
@@ -0,0 +1,817 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/loopbackio.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* the send budget is kept in thousandths of a byte so that low rates still accumulate between calls to dowork */
+#define BUDGET_UNITS_PER_BYTE   1000
+#define MAX_BURST_MS            100
+
+#define PEER_ENDPOINT(endpoint) (((endpoint) == LOOPBACKIO_ENDPOINT_A) ? LOOPBACKIO_ENDPOINT_B : LOOPBACKIO_ENDPOINT_A)
+
+typedef enum LOOPBACKIO_STATE_TAG
+{
+    LOOPBACKIO_STATE_CLOSED,
+    LOOPBACKIO_STATE_OPEN,
+    LOOPBACKIO_STATE_ERROR
+} LOOPBACKIO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    size_t bytes_transmitted;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+} PENDING_SEND;
+
+typedef struct IN_FLIGHT_CHUNK_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    /* kept instead of the delivery time, so that the elapsed time is compared and a wrapping tick counter is harmless */
+    tickcounter_ms_t transmitted_at;
+} IN_FLIGHT_CHUNK;
+
+typedef struct LOOPBACKIO_INSTANCE_TAG
+{
+    struct LOOPBACKIO_PAIR_INSTANCE_TAG* pair;
+    LOOPBACKIO_ENDPOINT endpoint;
+    LOOPBACKIO_STATE loopbackio_state;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    SINGLYLINKEDLIST_HANDLE pending_sends;
+    tickcounter_ms_t last_refill_ms;
+    uint64_t send_budget;
+    bool peer_closed;
+} LOOPBACKIO_INSTANCE;
+
+typedef struct LOOPBACKIO_PAIR_INSTANCE_TAG
+{
+    LOOPBACKIO_LINK_OPTIONS link_options;
+    TICK_COUNTER_HANDLE tick_counter;
+    /* both arrays are indexed by the endpoint that receives the data */
+    SINGLYLINKEDLIST_HANDLE in_flight[2];
+    LOOPBACKIO_INSTANCE* endpoints[2];
+} LOOPBACKIO_PAIR_INSTANCE;
+
+static void clear_in_flight_chunks(SINGLYLINKEDLIST_HANDLE in_flight)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while ((list_item = singlylinkedlist_get_head_item(in_flight)) != NULL)
+    {
+        IN_FLIGHT_CHUNK* chunk = (IN_FLIGHT_CHUNK*)singlylinkedlist_item_get_value(list_item);
+        (void)singlylinkedlist_remove(in_flight, list_item);
+        free(chunk);
+    }
+}
+
+static void complete_pending_sends(LOOPBACKIO_INSTANCE* loopbackio_instance, IO_SEND_RESULT send_result)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while ((list_item = singlylinkedlist_get_head_item(loopbackio_instance->pending_sends)) != NULL)
+    {
+        PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+        (void)singlylinkedlist_remove(loopbackio_instance->pending_sends, list_item);
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->on_send_complete_context, send_result);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void indicate_error(LOOPBACKIO_INSTANCE* loopbackio_instance)
+{
+    loopbackio_instance->loopbackio_state = LOOPBACKIO_STATE_ERROR;
+    complete_pending_sends(loopbackio_instance, IO_SEND_ERROR);
+
+    if (loopbackio_instance->on_io_error != NULL)
+    {
+        loopbackio_instance->on_io_error(loopbackio_instance->on_io_error_context);
+    }
+}
+
+static void close_endpoint(LOOPBACKIO_INSTANCE* loopbackio_instance)
+{
+    loopbackio_instance->loopbackio_state = LOOPBACKIO_STATE_CLOSED;
+
+    if (loopbackio_instance->pair != NULL)
+    {
+        LOOPBACKIO_INSTANCE* peer = loopbackio_instance->pair->endpoints[PEER_ENDPOINT(loopbackio_instance->endpoint)];
+
+        /* Codes_SRS_LOOPBACKIO_11_033: [ `loopbackio_close` shall discard all data that is in flight towards the endpoint. ]*/
+        clear_in_flight_chunks(loopbackio_instance->pair->in_flight[loopbackio_instance->endpoint]);
+
+        /* Codes_SRS_LOOPBACKIO_11_034: [ If the peer endpoint is open, it shall be marked as having lost its peer. ]*/
+        if ((peer != NULL) &&
+            (peer->loopbackio_state == LOOPBACKIO_STATE_OPEN))
+        {
+            peer->peer_closed = true;
+        }
+    }
+
+    /* Codes_SRS_LOOPBACKIO_11_032: [ `loopbackio_close` shall complete all pending sends with `IO_SEND_CANCELLED`. ]*/
+    complete_pending_sends(loopbackio_instance, IO_SEND_CANCELLED);
+}
+
+static void refill_send_budget(LOOPBACKIO_INSTANCE* loopbackio_instance, tickcounter_ms_t now)
+{
+    size_t bytes_per_second = loopbackio_instance->pair->link_options.bytes_per_second;
+    uint64_t max_budget = (uint64_t)bytes_per_second * MAX_BURST_MS;
+
+    /* a burst shall always be able to carry at least one byte, otherwise very low rates would never transmit */
+    if (max_budget < BUDGET_UNITS_PER_BYTE)
+    {
+        max_budget = BUDGET_UNITS_PER_BYTE;
+    }
+
+    loopbackio_instance->send_budget += (uint64_t)(now - loopbackio_instance->last_refill_ms) * bytes_per_second;
+    if (loopbackio_instance->send_budget > max_budget)
+    {
+        loopbackio_instance->send_budget = max_budget;
+    }
+
+    loopbackio_instance->last_refill_ms = now;
+}
+
+static void transmit_pending_sends(LOOPBACKIO_INSTANCE* loopbackio_instance, tickcounter_ms_t now)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    if (loopbackio_instance->pair->link_options.bytes_per_second != 0)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_045: [ If `bytes_per_second` is not 0, the endpoint shall accumulate a send budget of `bytes_per_second` bytes per second of elapsed time, capped at 100 ms worth of data (but never less than one byte). ]*/
+        refill_send_budget(loopbackio_instance, now);
+    }
+
+    /* the state is checked again after every callback, since the user may close the endpoint or destroy the pair from within it */
+    while ((loopbackio_instance->loopbackio_state == LOOPBACKIO_STATE_OPEN) &&
+        (loopbackio_instance->pair != NULL) &&
+        ((list_item = singlylinkedlist_get_head_item(loopbackio_instance->pending_sends)) != NULL))
+    {
+        const LOOPBACKIO_LINK_OPTIONS* link_options = &loopbackio_instance->pair->link_options;
+        PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+        size_t chunk_size = pending_send->size - pending_send->bytes_transmitted;
+        IN_FLIGHT_CHUNK* chunk;
+
+        /* Codes_SRS_LOOPBACKIO_11_044: [ If `max_chunk_size` is not 0, no chunk shall be larger than `max_chunk_size` bytes. ]*/
+        if ((link_options->max_chunk_size != 0) &&
+            (chunk_size > link_options->max_chunk_size))
+        {
+            chunk_size = link_options->max_chunk_size;
+        }
+
+        if (link_options->bytes_per_second != 0)
+        {
+            uint64_t budget_bytes = loopbackio_instance->send_budget / BUDGET_UNITS_PER_BYTE;
+
+            /* Codes_SRS_LOOPBACKIO_11_046: [ Transmission shall stop once the send budget is exhausted and resume on a later call to `loopbackio_dowork`. ]*/
+            if (budget_bytes == 0)
+            {
+                break;
+            }
+
+            if (chunk_size > budget_bytes)
+            {
+                chunk_size = (size_t)budget_bytes;
+            }
+        }
+
+        chunk = (IN_FLIGHT_CHUNK*)malloc(sizeof(IN_FLIGHT_CHUNK) + chunk_size);
+        if (chunk == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_047: [ If allocating a chunk fails, the endpoint shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+            LogError("Failed allocating in flight chunk");
+            indicate_error(loopbackio_instance);
+            break;
+        }
+
+        chunk->bytes = (unsigned char*)(chunk + 1);
+        chunk->size = chunk_size;
+        /* Codes_SRS_LOOPBACKIO_11_043: [ Each chunk shall become deliverable to the peer `latency_ms` milliseconds after it was transmitted. ]*/
+        chunk->transmitted_at = now;
+        (void)memcpy(chunk->bytes, pending_send->bytes + pending_send->bytes_transmitted, chunk_size);
+
+        if (singlylinkedlist_add(loopbackio_instance->pair->in_flight[PEER_ENDPOINT(loopbackio_instance->endpoint)], chunk) == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_047: [ If allocating a chunk fails, the endpoint shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+            LogError("Failed queueing in flight chunk");
+            free(chunk);
+            indicate_error(loopbackio_instance);
+            break;
+        }
+
+        pending_send->bytes_transmitted += chunk_size;
+        if (link_options->bytes_per_second != 0)
+        {
+            loopbackio_instance->send_budget -= (uint64_t)chunk_size * BUDGET_UNITS_PER_BYTE;
+        }
+
+        if (pending_send->bytes_transmitted == pending_send->size)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_048: [ When all the bytes of a send have been transmitted, its `on_send_complete` shall be called with `IO_SEND_OK`. ]*/
+            (void)singlylinkedlist_remove(loopbackio_instance->pending_sends, list_item);
+
+            if (pending_send->on_send_complete != NULL)
+            {
+                pending_send->on_send_complete(pending_send->on_send_complete_context, IO_SEND_OK);
+            }
+
+            free(pending_send);
+        }
+    }
+}
+
+static void deliver_in_flight_chunks(LOOPBACKIO_INSTANCE* loopbackio_instance, tickcounter_ms_t now)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while ((loopbackio_instance->loopbackio_state == LOOPBACKIO_STATE_OPEN) &&
+        (loopbackio_instance->pair != NULL) &&
+        ((list_item = singlylinkedlist_get_head_item(loopbackio_instance->pair->in_flight[loopbackio_instance->endpoint])) != NULL))
+    {
+        IN_FLIGHT_CHUNK* chunk = (IN_FLIGHT_CHUNK*)singlylinkedlist_item_get_value(list_item);
+
+        /* Codes_SRS_LOOPBACKIO_11_050: [ Chunks that are not yet deliverable shall be left in flight. ]*/
+        if ((tickcounter_ms_t)(now - chunk->transmitted_at) < loopbackio_instance->pair->link_options.latency_ms)
+        {
+            break;
+        }
+
+        (void)singlylinkedlist_remove(loopbackio_instance->pair->in_flight[loopbackio_instance->endpoint], list_item);
+
+        /* Codes_SRS_LOOPBACKIO_11_049: [ `loopbackio_dowork` shall call `on_bytes_received` once for each deliverable chunk in flight towards the endpoint, in the order the chunks were transmitted. ]*/
+        if (loopbackio_instance->on_bytes_received != NULL)
+        {
+            loopbackio_instance->on_bytes_received(loopbackio_instance->on_bytes_received_context, chunk->bytes, chunk->size);
+        }
+
+        free(chunk);
+    }
+}
+
+LOOPBACKIO_PAIR_HANDLE loopbackio_pair_create(const LOOPBACKIO_LINK_OPTIONS* link_options)
+{
+    LOOPBACKIO_PAIR_INSTANCE* result;
+
+    if (link_options == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_002: [ If `link_options` is NULL, `loopbackio_pair_create` shall fail and return NULL. ]*/
+        LogError("NULL link_options.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_001: [ `loopbackio_pair_create` shall create a new loopback pair whose two directions both use the characteristics in `link_options`. ]*/
+        result = (LOOPBACKIO_PAIR_INSTANCE*)malloc(sizeof(LOOPBACKIO_PAIR_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_003: [ If any error occurs, `loopbackio_pair_create` shall fail and return NULL. ]*/
+            LogError("Failed allocating loopback pair.");
+        }
+        else
+        {
+            /* Codes_SRS_LOOPBACKIO_11_004: [ `loopbackio_pair_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+            result->tick_counter = tickcounter_create();
+            if (result->tick_counter == NULL)
+            {
+                /* Codes_SRS_LOOPBACKIO_11_003: [ If any error occurs, `loopbackio_pair_create` shall fail and return NULL. ]*/
+                LogError("Failed creating tick counter.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_LOOPBACKIO_11_005: [ `loopbackio_pair_create` shall create one in flight list per direction by calling `singlylinkedlist_create`. ]*/
+                result->in_flight[LOOPBACKIO_ENDPOINT_A] = singlylinkedlist_create();
+                if (result->in_flight[LOOPBACKIO_ENDPOINT_A] == NULL)
+                {
+                    /* Codes_SRS_LOOPBACKIO_11_003: [ If any error occurs, `loopbackio_pair_create` shall fail and return NULL. ]*/
+                    LogError("Failed creating in flight list.");
+                    tickcounter_destroy(result->tick_counter);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->in_flight[LOOPBACKIO_ENDPOINT_B] = singlylinkedlist_create();
+                    if (result->in_flight[LOOPBACKIO_ENDPOINT_B] == NULL)
+                    {
+                        /* Codes_SRS_LOOPBACKIO_11_003: [ If any error occurs, `loopbackio_pair_create` shall fail and return NULL. ]*/
+                        LogError("Failed creating in flight list.");
+                        singlylinkedlist_destroy(result->in_flight[LOOPBACKIO_ENDPOINT_A]);
+                        tickcounter_destroy(result->tick_counter);
+                        free(result);
+                        result = NULL;
+                    }
+                    else
+                    {
+                        result->link_options = *link_options;
+                        result->endpoints[LOOPBACKIO_ENDPOINT_A] = NULL;
+                        result->endpoints[LOOPBACKIO_ENDPOINT_B] = NULL;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void loopbackio_pair_destroy(LOOPBACKIO_PAIR_HANDLE pair)
+{
+    if (pair == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_007: [ If `pair` is NULL, `loopbackio_pair_destroy` shall do nothing. ]*/
+        LogError("NULL pair.");
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < 2; i++)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_008: [ Endpoints that still exist shall be detached from the pair; afterwards they can only be closed and destroyed. ]*/
+            if (pair->endpoints[i] != NULL)
+            {
+                pair->endpoints[i]->pair = NULL;
+            }
+
+            /* Codes_SRS_LOOPBACKIO_11_006: [ `loopbackio_pair_destroy` shall free all data in flight, the in flight lists, the tick counter and the pair. ]*/
+            clear_in_flight_chunks(pair->in_flight[i]);
+            singlylinkedlist_destroy(pair->in_flight[i]);
+        }
+
+        tickcounter_destroy(pair->tick_counter);
+        free(pair);
+    }
+}
+
+static CONCRETE_IO_HANDLE loopbackio_create(void* io_create_parameters)
+{
+    LOOPBACKIO_INSTANCE* result;
+    LOOPBACKIO_CONFIG* loopbackio_config = (LOOPBACKIO_CONFIG*)io_create_parameters;
+
+    if (loopbackio_config == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_011: [ If `io_create_parameters` is NULL, `loopbackio_create` shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else if ((loopbackio_config->pair == NULL) ||
+        ((loopbackio_config->endpoint != LOOPBACKIO_ENDPOINT_A) && (loopbackio_config->endpoint != LOOPBACKIO_ENDPOINT_B)))
+    {
+        /* Codes_SRS_LOOPBACKIO_11_012: [ If the `pair` member is NULL or `endpoint` is neither `LOOPBACKIO_ENDPOINT_A` nor `LOOPBACKIO_ENDPOINT_B`, `loopbackio_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: pair = %p, endpoint = %d", loopbackio_config->pair, (int)loopbackio_config->endpoint);
+        result = NULL;
+    }
+    else if (loopbackio_config->pair->endpoints[loopbackio_config->endpoint] != NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_013: [ If an IO already exists for the requested endpoint of the pair, `loopbackio_create` shall fail and return NULL. ]*/
+        LogError("Endpoint %d of the pair is already in use", (int)loopbackio_config->endpoint);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_010: [ `loopbackio_create` shall create a new IO bound to the `endpoint` of `pair` given in the `LOOPBACKIO_CONFIG*` passed as `io_create_parameters`. ]*/
+        result = (LOOPBACKIO_INSTANCE*)malloc(sizeof(LOOPBACKIO_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_014: [ If any error occurs, `loopbackio_create` shall fail and return NULL. ]*/
+            LogError("Failed allocating loopback IO instance.");
+        }
+        else
+        {
+            /* Codes_SRS_LOOPBACKIO_11_015: [ `loopbackio_create` shall create the list of pending sends by calling `singlylinkedlist_create`. ]*/
+            result->pending_sends = singlylinkedlist_create();
+            if (result->pending_sends == NULL)
+            {
+                /* Codes_SRS_LOOPBACKIO_11_014: [ If any error occurs, `loopbackio_create` shall fail and return NULL. ]*/
+                LogError("Failed creating pending sends list.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->pair = loopbackio_config->pair;
+                result->endpoint = loopbackio_config->endpoint;
+                result->loopbackio_state = LOOPBACKIO_STATE_CLOSED;
+                result->on_bytes_received = NULL;
+                result->on_bytes_received_context = NULL;
+                result->on_io_error = NULL;
+                result->on_io_error_context = NULL;
+                result->last_refill_ms = 0;
+                result->send_budget = 0;
+                result->peer_closed = false;
+
+                loopbackio_config->pair->endpoints[loopbackio_config->endpoint] = result;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void loopbackio_destroy(CONCRETE_IO_HANDLE loopbackio)
+{
+    if (loopbackio == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_017: [ If `loopbackio` is NULL, `loopbackio_destroy` shall do nothing. ]*/
+        LogError("NULL loopbackio.");
+    }
+    else
+    {
+        LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+
+        /* Codes_SRS_LOOPBACKIO_11_018: [ If the IO is not closed, `loopbackio_destroy` shall close it without calling `on_io_close_complete`. ]*/
+        if (loopbackio_instance->loopbackio_state != LOOPBACKIO_STATE_CLOSED)
+        {
+            close_endpoint(loopbackio_instance);
+        }
+
+        /* Codes_SRS_LOOPBACKIO_11_016: [ `loopbackio_destroy` shall release the endpoint of the pair and free all resources associated with the IO. ]*/
+        if (loopbackio_instance->pair != NULL)
+        {
+            loopbackio_instance->pair->endpoints[loopbackio_instance->endpoint] = NULL;
+        }
+
+        singlylinkedlist_destroy(loopbackio_instance->pending_sends);
+        free(loopbackio_instance);
+    }
+}
+
+static int loopbackio_open(CONCRETE_IO_HANDLE loopbackio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+    tickcounter_ms_t now;
+
+    if (loopbackio_instance == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_021: [ If `loopbackio` is NULL, `loopbackio_open` shall fail and return a non-zero value. ]*/
+        LogError("NULL loopbackio.");
+        result = __FAILURE__;
+    }
+    else if (loopbackio_instance->loopbackio_state != LOOPBACKIO_STATE_CLOSED)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_022: [ If the IO is not closed, `loopbackio_open` shall fail and return a non-zero value. ]*/
+        LogError("Loopback IO is already open.");
+        result = __FAILURE__;
+    }
+    else if (loopbackio_instance->pair == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_023: [ If the pair has been destroyed, `loopbackio_open` shall fail and return a non-zero value. ]*/
+        LogError("Loopback pair was destroyed.");
+        result = __FAILURE__;
+    }
+    else if (tickcounter_get_current_ms(loopbackio_instance->pair->tick_counter, &now) != 0)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_024: [ If `tickcounter_get_current_ms` fails, `loopbackio_open` shall fail and return a non-zero value. ]*/
+        LogError("Failed getting the current time.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_020: [ `loopbackio_open` shall open the IO synchronously, call `on_io_open_complete` with `IO_OPEN_OK` and return 0. ]*/
+        loopbackio_instance->on_bytes_received = on_bytes_received;
+        loopbackio_instance->on_bytes_received_context = on_bytes_received_context;
+        loopbackio_instance->on_io_error = on_io_error;
+        loopbackio_instance->on_io_error_context = on_io_error_context;
+        loopbackio_instance->last_refill_ms = now;
+        loopbackio_instance->send_budget = 0;
+        loopbackio_instance->peer_closed = false;
+        loopbackio_instance->loopbackio_state = LOOPBACKIO_STATE_OPEN;
+
+        if (on_io_open_complete != NULL)
+        {
+            on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int loopbackio_close(CONCRETE_IO_HANDLE loopbackio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+
+    if (loopbackio_instance == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_031: [ If `loopbackio` is NULL, `loopbackio_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL loopbackio.");
+        result = __FAILURE__;
+    }
+    else if (loopbackio_instance->loopbackio_state == LOOPBACKIO_STATE_CLOSED)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_035: [ If the IO is already closed, `loopbackio_close` shall fail and return a non-zero value. ]*/
+        LogError("Loopback IO is not open.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_030: [ `loopbackio_close` shall close the IO synchronously, call `on_io_close_complete` and return 0. ]*/
+        close_endpoint(loopbackio_instance);
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(on_io_close_complete_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int loopbackio_send(CONCRETE_IO_HANDLE loopbackio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+
+    if ((loopbackio_instance == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Codes_SRS_LOOPBACKIO_11_041: [ If `loopbackio` or `buffer` is NULL or `size` is 0, `loopbackio_send` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: loopbackio = %p, buffer = %p, size = %lu", loopbackio, buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else if ((loopbackio_instance->loopbackio_state != LOOPBACKIO_STATE_OPEN) ||
+        (loopbackio_instance->pair == NULL))
+    {
+        /* Codes_SRS_LOOPBACKIO_11_042: [ If the IO is not open or the pair has been destroyed, `loopbackio_send` shall fail and return a non-zero value. ]*/
+        LogError("Loopback IO is not open.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_040: [ `loopbackio_send` shall copy the bytes into the pending sends of the endpoint and return 0; transmission happens in `loopbackio_dowork`. ]*/
+        PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+        if (pending_send == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_051: [ If queueing the send fails, `loopbackio_send` shall fail and return a non-zero value. ]*/
+            LogError("Failed allocating pending send.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            pending_send->bytes = (unsigned char*)(pending_send + 1);
+            pending_send->size = size;
+            pending_send->bytes_transmitted = 0;
+            pending_send->on_send_complete = on_send_complete;
+            pending_send->on_send_complete_context = on_send_complete_context;
+            (void)memcpy(pending_send->bytes, buffer, size);
+
+            if (singlylinkedlist_add(loopbackio_instance->pending_sends, pending_send) == NULL)
+            {
+                /* Codes_SRS_LOOPBACKIO_11_051: [ If queueing the send fails, `loopbackio_send` shall fail and return a non-zero value. ]*/
+                LogError("Failed queueing pending send.");
+                free(pending_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void loopbackio_dowork(CONCRETE_IO_HANDLE loopbackio)
+{
+    LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+
+    if (loopbackio_instance == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_061: [ If `loopbackio` is NULL, `loopbackio_dowork` shall do nothing. ]*/
+        LogError("NULL loopbackio.");
+    }
+    /* Codes_SRS_LOOPBACKIO_11_062: [ If the IO is not open or the pair has been destroyed, `loopbackio_dowork` shall do nothing. ]*/
+    else if ((loopbackio_instance->loopbackio_state == LOOPBACKIO_STATE_OPEN) &&
+        (loopbackio_instance->pair != NULL))
+    {
+        tickcounter_ms_t now;
+
+        if (tickcounter_get_current_ms(loopbackio_instance->pair->tick_counter, &now) != 0)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_063: [ If `tickcounter_get_current_ms` fails, the endpoint shall go to the error state and call `on_io_error`. ]*/
+            LogError("Failed getting the current time.");
+            indicate_error(loopbackio_instance);
+        }
+        else
+        {
+            /* Codes_SRS_LOOPBACKIO_11_060: [ `loopbackio_dowork` shall first transmit the pending sends of the endpoint towards its peer and then deliver the data in flight towards the endpoint. ]*/
+            if (!loopbackio_instance->peer_closed)
+            {
+                transmit_pending_sends(loopbackio_instance, now);
+            }
+
+            deliver_in_flight_chunks(loopbackio_instance, now);
+
+            /* Codes_SRS_LOOPBACKIO_11_064: [ Once the peer has closed and all data in flight towards the endpoint has been delivered, the endpoint shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+            if ((loopbackio_instance->loopbackio_state == LOOPBACKIO_STATE_OPEN) &&
+                (loopbackio_instance->pair != NULL) &&
+                loopbackio_instance->peer_closed &&
+                (singlylinkedlist_get_head_item(loopbackio_instance->pair->in_flight[loopbackio_instance->endpoint]) == NULL))
+            {
+                indicate_error(loopbackio_instance);
+            }
+        }
+    }
+}
+
+static int loopbackio_setoption(CONCRETE_IO_HANDLE loopbackio, const char* option_name, const void* value)
+{
+    int result;
+    (void)value;
+
+    if ((loopbackio == NULL) || (option_name == NULL))
+    {
+        /* Codes_SRS_LOOPBACKIO_11_071: [ If `loopbackio` or `option_name` is NULL, `loopbackio_setoption` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: loopbackio = %p, option_name = %p", loopbackio, option_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_070: [ `loopbackio_setoption` shall fail and return a non-zero value for any option, as there are no options supported. ]*/
+        LogError("Unrecognized option %s", option_name);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static void* loopbackio_clone_option(const char* name, const void* value)
+{
+    (void)value;
+    LogError("Cannot clone unknown option %s", name);
+    return NULL;
+}
+
+static void loopbackio_destroy_option(const char* name, const void* value)
+{
+    (void)value;
+    LogError("Cannot destroy unknown option %s", name);
+}
+
+static OPTIONHANDLER_HANDLE loopbackio_retrieveoptions(CONCRETE_IO_HANDLE loopbackio)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (loopbackio == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_073: [ If `loopbackio` is NULL, `loopbackio_retrieveoptions` shall fail and return NULL. ]*/
+        LogError("NULL loopbackio.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_LOOPBACKIO_11_072: [ `loopbackio_retrieveoptions` shall return an empty option handler created by calling `OptionHandler_Create`. ]*/
+        result = OptionHandler_Create(loopbackio_clone_option, loopbackio_destroy_option, loopbackio_setoption);
+        if (result == NULL)
+        {
+            /* Codes_SRS_LOOPBACKIO_11_074: [ If `OptionHandler_Create` fails, `loopbackio_retrieveoptions` shall return NULL. ]*/
+            LogError("unable to OptionHandler_Create");
+        }
+    }
+
+    return result;
+}
+
+static tickcounter_ms_t get_ms_until_work(LOOPBACKIO_INSTANCE* loopbackio_instance, tickcounter_ms_t now, tickcounter_ms_t wait_ms)
+{
+    LIST_ITEM_HANDLE in_flight_head = singlylinkedlist_get_head_item(loopbackio_instance->pair->in_flight[loopbackio_instance->endpoint]);
+    size_t bytes_per_second = loopbackio_instance->pair->link_options.bytes_per_second;
+
+    if (in_flight_head != NULL)
+    {
+        const IN_FLIGHT_CHUNK* chunk = (const IN_FLIGHT_CHUNK*)singlylinkedlist_item_get_value(in_flight_head);
+        tickcounter_ms_t elapsed_ms = (tickcounter_ms_t)(now - chunk->transmitted_at);
+        tickcounter_ms_t until_delivery = (elapsed_ms < loopbackio_instance->pair->link_options.latency_ms) ? (loopbackio_instance->pair->link_options.latency_ms - elapsed_ms) : 0;
+        if (until_delivery < wait_ms)
+        {
+            wait_ms = until_delivery;
+        }
+    }
+    else if (loopbackio_instance->peer_closed)
+    {
+        /* the next dowork reports the closed peer */
+        wait_ms = 0;
+    }
+
+    if ((!loopbackio_instance->peer_closed) &&
+        (singlylinkedlist_get_head_item(loopbackio_instance->pending_sends) != NULL))
+    {
+        tickcounter_ms_t until_transmit = 0;
+
+        if (bytes_per_second != 0)
+        {
+            uint64_t budget = loopbackio_instance->send_budget + (uint64_t)(now - loopbackio_instance->last_refill_ms) * bytes_per_second;
+            if (budget < BUDGET_UNITS_PER_BYTE)
+            {
+                until_transmit = (tickcounter_ms_t)((BUDGET_UNITS_PER_BYTE - budget + bytes_per_second - 1) / bytes_per_second);
+            }
+        }
+
+        if (until_transmit < wait_ms)
+        {
+            wait_ms = until_transmit;
+        }
+    }
+
+    return wait_ms;
+}
+
+static int loopbackio_wait(CONCRETE_IO_HANDLE loopbackio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+    LOOPBACKIO_INSTANCE* loopbackio_instance = (LOOPBACKIO_INSTANCE*)loopbackio;
+    tickcounter_ms_t now;
+
+    if (loopbackio_instance == NULL)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_081: [ If `loopbackio` is NULL, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+        LogError("NULL loopbackio.");
+        result = __FAILURE__;
+    }
+    else if ((loopbackio_instance->loopbackio_state != LOOPBACKIO_STATE_OPEN) ||
+        (loopbackio_instance->pair == NULL))
+    {
+        /* Codes_SRS_LOOPBACKIO_11_082: [ If the IO is not open or the pair has been destroyed, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+        LogError("Loopback IO is not open.");
+        result = __FAILURE__;
+    }
+    else if (tickcounter_get_current_ms(loopbackio_instance->pair->tick_counter, &now) != 0)
+    {
+        /* Codes_SRS_LOOPBACKIO_11_083: [ If `tickcounter_get_current_ms` fails, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+        LogError("Failed getting the current time.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        LOOPBACKIO_INSTANCE* peer = loopbackio_instance->pair->endpoints[PEER_ENDPOINT(loopbackio_instance->endpoint)];
+        /* Codes_SRS_LOOPBACKIO_11_084: [ Since sends are queued without limit, an `interest` including `IO_WAIT_WRITE` shall be satisfied immediately. ]*/
+        tickcounter_ms_t wait_ms = ((interest & IO_WAIT_WRITE) != 0) ? 0 : timeout_ms;
+
+        /* Codes_SRS_LOOPBACKIO_11_080: [ `loopbackio_wait` shall sleep by calling `ThreadAPI_Sleep` until the next call to `loopbackio_dowork` on either endpoint of the pair has work to do, or for at most `timeout_ms`, and return 0. ]*/
+        /* both endpoints are driven from the same thread, so the peer's pending work has to wake this endpoint too */
+        wait_ms = get_ms_until_work(loopbackio_instance, now, wait_ms);
+        if ((peer != NULL) &&
+            (peer->loopbackio_state == LOOPBACKIO_STATE_OPEN))
+        {
+            wait_ms = get_ms_until_work(peer, now, wait_ms);
+        }
+
+        if (wait_ms > 0)
+        {
+            ThreadAPI_Sleep((unsigned int)wait_ms);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION loopbackio_interface_description =
+{
+    loopbackio_retrieveoptions,
+    loopbackio_create,
+    loopbackio_destroy,
+    loopbackio_open,
+    loopbackio_close,
+    loopbackio_send,
+    loopbackio_dowork,
+    loopbackio_setoption,
+    loopbackio_wait
+};
+
+const IO_INTERFACE_DESCRIPTION* loopbackio_get_interface_description(void)
+{
+    /* Codes_SRS_LOOPBACKIO_11_090: [ `loopbackio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `loopbackio_retrieveoptions`, `loopbackio_create`, `loopbackio_destroy`, `loopbackio_open`, `loopbackio_close`, `loopbackio_send`, `loopbackio_dowork`, `loopbackio_setoption` and `loopbackio_wait`. ]*/
+    return &loopbackio_interface_description;
+}
@@ -0,0 +1,761 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/ratelimitio.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* tokens are kept in thousandths of a byte so that low rates still accumulate between calls to dowork */
+#define TOKEN_UNITS_PER_BYTE    1000
+
+typedef enum RATELIMITIO_STATE_TAG
+{
+    RATELIMITIO_STATE_CLOSED,
+    RATELIMITIO_STATE_OPENING,
+    RATELIMITIO_STATE_OPEN,
+    RATELIMITIO_STATE_CLOSING,
+    RATELIMITIO_STATE_ERROR
+} RATELIMITIO_STATE;
+
+typedef struct PENDING_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    size_t bytes_released;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+} PENDING_SEND;
+
+typedef struct RATELIMITIO_LINK_INSTANCE_TAG
+{
+    RATELIMITIO_LINK_OPTIONS link_options;
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t last_refill_ms;
+    uint64_t tokens;
+    /* bytes queued and not yet released, per priority lane, across all the IOs sharing the link */
+    size_t queued_bytes[RATELIMITIO_PRIORITY_COUNT];
+    size_t io_count;
+    bool destroy_requested;
+} RATELIMITIO_LINK_INSTANCE;
+
+typedef struct RATELIMITIO_INSTANCE_TAG
+{
+    XIO_HANDLE underlying_io;
+    RATELIMITIO_LINK_INSTANCE* link;
+    RATELIMITIO_PRIORITY priority;
+    RATELIMITIO_STATE ratelimitio_state;
+    SINGLYLINKEDLIST_HANDLE pending_sends;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    void* on_io_close_complete_context;
+} RATELIMITIO_INSTANCE;
+
+static void free_link(RATELIMITIO_LINK_INSTANCE* link)
+{
+    tickcounter_destroy(link->tick_counter);
+    free(link);
+}
+
+/* lanes are numbered from the highest priority, so this sums the `lane_count` highest priority lanes */
+static size_t get_queued_bytes_in_lanes(RATELIMITIO_LINK_INSTANCE* link, size_t lane_count)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < lane_count; i++)
+    {
+        result += link->queued_bytes[i];
+    }
+
+    return result;
+}
+
+static void refill_tokens(RATELIMITIO_LINK_INSTANCE* link)
+{
+    tickcounter_ms_t now;
+
+    if (tickcounter_get_current_ms(link->tick_counter, &now) != 0)
+    {
+        LogError("Failed getting the current time, tokens not refilled.");
+    }
+    else
+    {
+        uint64_t max_tokens = (uint64_t)link->link_options.burst_size * TOKEN_UNITS_PER_BYTE;
+
+        link->tokens += (uint64_t)(now - link->last_refill_ms) * link->link_options.bytes_per_second;
+        if (link->tokens > max_tokens)
+        {
+            link->tokens = max_tokens;
+        }
+
+        link->last_refill_ms = now;
+    }
+}
+
+static void complete_pending_sends(RATELIMITIO_INSTANCE* ratelimitio_instance, IO_SEND_RESULT send_result)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while ((list_item = singlylinkedlist_get_head_item(ratelimitio_instance->pending_sends)) != NULL)
+    {
+        PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+        (void)singlylinkedlist_remove(ratelimitio_instance->pending_sends, list_item);
+        ratelimitio_instance->link->queued_bytes[ratelimitio_instance->priority] -= pending_send->size - pending_send->bytes_released;
+
+        if (pending_send->on_send_complete != NULL)
+        {
+            pending_send->on_send_complete(pending_send->on_send_complete_context, send_result);
+        }
+
+        free(pending_send);
+    }
+}
+
+static void indicate_error(RATELIMITIO_INSTANCE* ratelimitio_instance)
+{
+    ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_ERROR;
+    complete_pending_sends(ratelimitio_instance, IO_SEND_ERROR);
+
+    if (ratelimitio_instance->on_io_error != NULL)
+    {
+        ratelimitio_instance->on_io_error(ratelimitio_instance->on_io_error_context);
+    }
+}
+
+static void release_pending_sends(RATELIMITIO_INSTANCE* ratelimitio_instance)
+{
+    RATELIMITIO_LINK_INSTANCE* link = ratelimitio_instance->link;
+    LIST_ITEM_HANDLE list_item;
+
+    /* the state is checked again after every send, since the underlying IO may complete sends (and call the user) synchronously */
+    while ((ratelimitio_instance->ratelimitio_state == RATELIMITIO_STATE_OPEN) &&
+        ((list_item = singlylinkedlist_get_head_item(ratelimitio_instance->pending_sends)) != NULL))
+    {
+        PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+        size_t chunk_size = pending_send->size - pending_send->bytes_released;
+        const unsigned char* chunk_bytes = pending_send->bytes + pending_send->bytes_released;
+
+        /* Codes_SRS_RATELIMITIO_11_052: [ Bytes shall only be released while no IO sharing the link with a higher priority has queued bytes. ]*/
+        if (get_queued_bytes_in_lanes(link, (size_t)ratelimitio_instance->priority) != 0)
+        {
+            break;
+        }
+
+        /* Codes_SRS_RATELIMITIO_11_051: [ `ratelimitio_dowork` shall release the queued bytes in order, in chunks of at most `burst_size` bytes, each chunk only once the link holds enough tokens for all of it. ]*/
+        if (chunk_size > link->link_options.burst_size)
+        {
+            chunk_size = link->link_options.burst_size;
+        }
+
+        if (link->tokens < (uint64_t)chunk_size * TOKEN_UNITS_PER_BYTE)
+        {
+            break;
+        }
+
+        link->tokens -= (uint64_t)chunk_size * TOKEN_UNITS_PER_BYTE;
+        link->queued_bytes[ratelimitio_instance->priority] -= chunk_size;
+        pending_send->bytes_released += chunk_size;
+
+        if (pending_send->bytes_released < pending_send->size)
+        {
+            if (xio_send(ratelimitio_instance->underlying_io, chunk_bytes, chunk_size, NULL, NULL) != 0)
+            {
+                /* Codes_SRS_RATELIMITIO_11_054: [ If `xio_send` fails, the IO shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+                LogError("Failed sending on the underlying IO.");
+                indicate_error(ratelimitio_instance);
+            }
+        }
+        else
+        {
+            /* the send is unlinked before the last chunk goes out, so that a synchronous completion finds the queue consistent */
+            (void)singlylinkedlist_remove(ratelimitio_instance->pending_sends, list_item);
+
+            /* Codes_SRS_RATELIMITIO_11_053: [ The `on_send_complete` callback of the user shall be passed to `xio_send` together with the last chunk of the send. ]*/
+            if (xio_send(ratelimitio_instance->underlying_io, chunk_bytes, chunk_size, pending_send->on_send_complete, pending_send->on_send_complete_context) != 0)
+            {
+                /* Codes_SRS_RATELIMITIO_11_054: [ If `xio_send` fails, the IO shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+                LogError("Failed sending on the underlying IO.");
+                if (pending_send->on_send_complete != NULL)
+                {
+                    pending_send->on_send_complete(pending_send->on_send_complete_context, IO_SEND_ERROR);
+                }
+
+                free(pending_send);
+                indicate_error(ratelimitio_instance);
+            }
+            else
+            {
+                free(pending_send);
+            }
+        }
+    }
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)context;
+
+    /* Codes_SRS_RATELIMITIO_11_025: [ When the underlying IO completes the open, the rate limiting IO shall be open if `open_result` is `IO_OPEN_OK` and `on_io_open_complete` shall be called with `open_result`. ]*/
+    ratelimitio_instance->ratelimitio_state = (open_result == IO_OPEN_OK) ? RATELIMITIO_STATE_OPEN : RATELIMITIO_STATE_CLOSED;
+
+    if (ratelimitio_instance->on_io_open_complete != NULL)
+    {
+        ratelimitio_instance->on_io_open_complete(ratelimitio_instance->on_io_open_complete_context, open_result);
+    }
+}
+
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)context;
+
+    /* Codes_SRS_RATELIMITIO_11_026: [ Bytes received from the underlying IO shall be passed unchanged to `on_bytes_received`. ]*/
+    if (ratelimitio_instance->on_bytes_received != NULL)
+    {
+        ratelimitio_instance->on_bytes_received(ratelimitio_instance->on_bytes_received_context, buffer, size);
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)context;
+
+    /* Codes_SRS_RATELIMITIO_11_027: [ When the underlying IO indicates an error, the IO shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+    indicate_error(ratelimitio_instance);
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)context;
+
+    /* Codes_SRS_RATELIMITIO_11_028: [ When the underlying IO completes the close, the rate limiting IO shall be closed and `on_io_close_complete` shall be called. ]*/
+    ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_CLOSED;
+
+    if (ratelimitio_instance->on_io_close_complete != NULL)
+    {
+        ratelimitio_instance->on_io_close_complete(ratelimitio_instance->on_io_close_complete_context);
+    }
+}
+
+RATELIMITIO_LINK_HANDLE ratelimitio_link_create(const RATELIMITIO_LINK_OPTIONS* link_options)
+{
+    RATELIMITIO_LINK_INSTANCE* result;
+
+    if (link_options == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_002: [ If `link_options` is NULL, `ratelimitio_link_create` shall fail and return NULL. ]*/
+        LogError("NULL link_options.");
+        result = NULL;
+    }
+    else if ((link_options->bytes_per_second == 0) ||
+        (link_options->burst_size == 0))
+    {
+        /* Codes_SRS_RATELIMITIO_11_003: [ If `bytes_per_second` or `burst_size` is 0, `ratelimitio_link_create` shall fail and return NULL. ]*/
+        LogError("Bad link options: bytes_per_second = %lu, burst_size = %lu", (unsigned long)link_options->bytes_per_second, (unsigned long)link_options->burst_size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_RATELIMITIO_11_001: [ `ratelimitio_link_create` shall create a new token bucket that is refilled with `bytes_per_second` bytes per second and holds at most `burst_size` bytes. ]*/
+        result = (RATELIMITIO_LINK_INSTANCE*)malloc(sizeof(RATELIMITIO_LINK_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_RATELIMITIO_11_006: [ If any error occurs, `ratelimitio_link_create` shall fail and return NULL. ]*/
+            LogError("Failed allocating rate limiting link.");
+        }
+        else
+        {
+            /* Codes_SRS_RATELIMITIO_11_004: [ `ratelimitio_link_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+            result->tick_counter = tickcounter_create();
+            if (result->tick_counter == NULL)
+            {
+                /* Codes_SRS_RATELIMITIO_11_006: [ If any error occurs, `ratelimitio_link_create` shall fail and return NULL. ]*/
+                LogError("Failed creating tick counter.");
+                free(result);
+                result = NULL;
+            }
+            /* Codes_SRS_RATELIMITIO_11_005: [ The token bucket shall start full, at the time obtained by calling `tickcounter_get_current_ms`. ]*/
+            else if (tickcounter_get_current_ms(result->tick_counter, &result->last_refill_ms) != 0)
+            {
+                /* Codes_SRS_RATELIMITIO_11_006: [ If any error occurs, `ratelimitio_link_create` shall fail and return NULL. ]*/
+                LogError("Failed getting the current time.");
+                tickcounter_destroy(result->tick_counter);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->link_options = *link_options;
+                result->tokens = (uint64_t)link_options->burst_size * TOKEN_UNITS_PER_BYTE;
+                (void)memset(result->queued_bytes, 0, sizeof(result->queued_bytes));
+                result->io_count = 0;
+                result->destroy_requested = false;
+            }
+        }
+    }
+
+    return result;
+}
+
+void ratelimitio_link_destroy(RATELIMITIO_LINK_HANDLE link)
+{
+    if (link == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_008: [ If `link` is NULL, `ratelimitio_link_destroy` shall do nothing. ]*/
+        LogError("NULL link.");
+    }
+    else if (link->io_count == 0)
+    {
+        /* Codes_SRS_RATELIMITIO_11_007: [ If no IO uses the link, `ratelimitio_link_destroy` shall free the tick counter and the link. ]*/
+        free_link(link);
+    }
+    else
+    {
+        /* Codes_SRS_RATELIMITIO_11_009: [ Otherwise the link shall be freed when the last IO using it is destroyed, and no new IO shall be created on it. ]*/
+        link->destroy_requested = true;
+    }
+}
+
+static CONCRETE_IO_HANDLE ratelimitio_create(void* io_create_parameters)
+{
+    RATELIMITIO_INSTANCE* result;
+    RATELIMITIO_CONFIG* ratelimitio_config = (RATELIMITIO_CONFIG*)io_create_parameters;
+
+    if (ratelimitio_config == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_011: [ If `io_create_parameters` is NULL, `ratelimitio_create` shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else if ((ratelimitio_config->underlying_io_interface == NULL) ||
+        (ratelimitio_config->link == NULL) ||
+        ((int)ratelimitio_config->priority < 0) ||
+        ((int)ratelimitio_config->priority >= RATELIMITIO_PRIORITY_COUNT))
+    {
+        /* Codes_SRS_RATELIMITIO_11_012: [ If the `underlying_io_interface` or `link` member is NULL or `priority` is not a valid `RATELIMITIO_PRIORITY`, `ratelimitio_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: underlying_io_interface = %p, link = %p, priority = %d", ratelimitio_config->underlying_io_interface, ratelimitio_config->link, (int)ratelimitio_config->priority);
+        result = NULL;
+    }
+    else if (ratelimitio_config->link->destroy_requested)
+    {
+        /* Codes_SRS_RATELIMITIO_11_009: [ Otherwise the link shall be freed when the last IO using it is destroyed, and no new IO shall be created on it. ]*/
+        LogError("The rate limiting link is being destroyed.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_RATELIMITIO_11_010: [ `ratelimitio_create` shall create a new rate limiting IO that draws its tokens from the `link` member of the `RATELIMITIO_CONFIG*` passed as `io_create_parameters`, in the lane given by `priority`. ]*/
+        result = (RATELIMITIO_INSTANCE*)malloc(sizeof(RATELIMITIO_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_RATELIMITIO_11_013: [ If any error occurs, `ratelimitio_create` shall fail and return NULL. ]*/
+            LogError("Failed allocating rate limiting IO instance.");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(RATELIMITIO_INSTANCE));
+
+            /* Codes_SRS_RATELIMITIO_11_014: [ `ratelimitio_create` shall create the list of pending sends by calling `singlylinkedlist_create`. ]*/
+            result->pending_sends = singlylinkedlist_create();
+            if (result->pending_sends == NULL)
+            {
+                /* Codes_SRS_RATELIMITIO_11_013: [ If any error occurs, `ratelimitio_create` shall fail and return NULL. ]*/
+                LogError("Failed creating pending sends list.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_RATELIMITIO_11_015: [ `ratelimitio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+                result->underlying_io = xio_create(ratelimitio_config->underlying_io_interface, ratelimitio_config->underlying_io_parameters);
+                if (result->underlying_io == NULL)
+                {
+                    /* Codes_SRS_RATELIMITIO_11_013: [ If any error occurs, `ratelimitio_create` shall fail and return NULL. ]*/
+                    LogError("Failed creating the underlying IO.");
+                    singlylinkedlist_destroy(result->pending_sends);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->link = ratelimitio_config->link;
+                    result->priority = ratelimitio_config->priority;
+                    result->ratelimitio_state = RATELIMITIO_STATE_CLOSED;
+                    result->link->io_count++;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void ratelimitio_destroy(CONCRETE_IO_HANDLE ratelimitio)
+{
+    if (ratelimitio == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_017: [ If `ratelimitio` is NULL, `ratelimitio_destroy` shall do nothing. ]*/
+        LogError("NULL ratelimitio.");
+    }
+    else
+    {
+        RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+        RATELIMITIO_LINK_INSTANCE* link = ratelimitio_instance->link;
+
+        /* Codes_SRS_RATELIMITIO_11_018: [ `ratelimitio_destroy` shall complete all pending sends with `IO_SEND_CANCELLED`. ]*/
+        complete_pending_sends(ratelimitio_instance, IO_SEND_CANCELLED);
+
+        /* Codes_SRS_RATELIMITIO_11_016: [ `ratelimitio_destroy` shall destroy the underlying IO by calling `xio_destroy` and free all resources associated with the IO. ]*/
+        xio_destroy(ratelimitio_instance->underlying_io);
+        singlylinkedlist_destroy(ratelimitio_instance->pending_sends);
+        free(ratelimitio_instance);
+
+        /* Codes_SRS_RATELIMITIO_11_019: [ If `ratelimitio_link_destroy` was already called and this was the last IO using the link, `ratelimitio_destroy` shall free the link. ]*/
+        link->io_count--;
+        if (link->destroy_requested &&
+            (link->io_count == 0))
+        {
+            free_link(link);
+        }
+    }
+}
+
+static int ratelimitio_open(CONCRETE_IO_HANDLE ratelimitio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+    if (ratelimitio_instance == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_021: [ If `ratelimitio` is NULL, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+        LogError("NULL ratelimitio.");
+        result = __FAILURE__;
+    }
+    else if (ratelimitio_instance->ratelimitio_state != RATELIMITIO_STATE_CLOSED)
+    {
+        /* Codes_SRS_RATELIMITIO_11_022: [ If the IO is not closed, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+        LogError("Rate limiting IO is already open.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        ratelimitio_instance->on_io_open_complete = on_io_open_complete;
+        ratelimitio_instance->on_io_open_complete_context = on_io_open_complete_context;
+        ratelimitio_instance->on_bytes_received = on_bytes_received;
+        ratelimitio_instance->on_bytes_received_context = on_bytes_received_context;
+        ratelimitio_instance->on_io_error = on_io_error;
+        ratelimitio_instance->on_io_error_context = on_io_error_context;
+        ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_OPENING;
+
+        /* Codes_SRS_RATELIMITIO_11_020: [ `ratelimitio_open` shall open the underlying IO by calling `xio_open`, passing its own callbacks. ]*/
+        if (xio_open(ratelimitio_instance->underlying_io, on_underlying_io_open_complete, ratelimitio_instance, on_underlying_io_bytes_received, ratelimitio_instance, on_underlying_io_error, ratelimitio_instance) != 0)
+        {
+            /* Codes_SRS_RATELIMITIO_11_023: [ If `xio_open` fails, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+            LogError("Failed opening the underlying IO.");
+            ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_CLOSED;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int ratelimitio_close(CONCRETE_IO_HANDLE ratelimitio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+    if (ratelimitio_instance == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_031: [ If `ratelimitio` is NULL, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL ratelimitio.");
+        result = __FAILURE__;
+    }
+    else if ((ratelimitio_instance->ratelimitio_state == RATELIMITIO_STATE_CLOSED) ||
+        (ratelimitio_instance->ratelimitio_state == RATELIMITIO_STATE_CLOSING))
+    {
+        /* Codes_SRS_RATELIMITIO_11_032: [ If the IO is already closed or closing, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+        LogError("Rate limiting IO is not open.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_RATELIMITIO_11_030: [ `ratelimitio_close` shall complete all pending sends with `IO_SEND_CANCELLED` and close the underlying IO by calling `xio_close`. ]*/
+        complete_pending_sends(ratelimitio_instance, IO_SEND_CANCELLED);
+
+        ratelimitio_instance->on_io_close_complete = on_io_close_complete;
+        ratelimitio_instance->on_io_close_complete_context = on_io_close_complete_context;
+        ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_CLOSING;
+
+        if (xio_close(ratelimitio_instance->underlying_io, on_underlying_io_close_complete, ratelimitio_instance) != 0)
+        {
+            /* Codes_SRS_RATELIMITIO_11_033: [ If `xio_close` fails, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+            LogError("Failed closing the underlying IO.");
+            ratelimitio_instance->ratelimitio_state = RATELIMITIO_STATE_ERROR;
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int ratelimitio_send(CONCRETE_IO_HANDLE ratelimitio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+    if ((ratelimitio_instance == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Codes_SRS_RATELIMITIO_11_041: [ If `ratelimitio` or `buffer` is NULL or `size` is 0, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ratelimitio = %p, buffer = %p, size = %lu", ratelimitio, buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else if (ratelimitio_instance->ratelimitio_state != RATELIMITIO_STATE_OPEN)
+    {
+        /* Codes_SRS_RATELIMITIO_11_042: [ If the IO is not open, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+        LogError("Rate limiting IO is not open.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        RATELIMITIO_LINK_INSTANCE* link = ratelimitio_instance->link;
+
+        refill_tokens(link);
+
+        if ((get_queued_bytes_in_lanes(link, (size_t)ratelimitio_instance->priority + 1) == 0) &&
+            (size <= link->link_options.burst_size) &&
+            (link->tokens >= (uint64_t)size * TOKEN_UNITS_PER_BYTE))
+        {
+            /* Codes_SRS_RATELIMITIO_11_040: [ If no bytes are queued in the lane of the IO or a higher priority lane, `size` is at most `burst_size` and the link holds enough tokens, `ratelimitio_send` shall consume the tokens and send the bytes immediately by calling `xio_send` with `on_send_complete` and `on_send_complete_context`. ]*/
+            /* the tokens are taken before the send, so that a send made from a synchronous completion does not spend them again */
+            link->tokens -= (uint64_t)size * TOKEN_UNITS_PER_BYTE;
+
+            if (xio_send(ratelimitio_instance->underlying_io, buffer, size, on_send_complete, on_send_complete_context) != 0)
+            {
+                /* Codes_SRS_RATELIMITIO_11_045: [ If `xio_send` fails, `ratelimitio_send` shall give the tokens back to the link, fail and return a non-zero value. ]*/
+                LogError("Failed sending on the underlying IO.");
+                link->tokens += (uint64_t)size * TOKEN_UNITS_PER_BYTE;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else
+        {
+            /* Codes_SRS_RATELIMITIO_11_043: [ Otherwise `ratelimitio_send` shall copy the bytes into the pending sends of the IO and return 0; they are released by `ratelimitio_dowork`. ]*/
+            PENDING_SEND* pending_send = (PENDING_SEND*)malloc(sizeof(PENDING_SEND) + size);
+            if (pending_send == NULL)
+            {
+                /* Codes_SRS_RATELIMITIO_11_044: [ If queueing the send fails, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+                LogError("Failed allocating pending send.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                pending_send->bytes = (unsigned char*)(pending_send + 1);
+                pending_send->size = size;
+                pending_send->bytes_released = 0;
+                pending_send->on_send_complete = on_send_complete;
+                pending_send->on_send_complete_context = on_send_complete_context;
+                (void)memcpy(pending_send->bytes, buffer, size);
+
+                if (singlylinkedlist_add(ratelimitio_instance->pending_sends, pending_send) == NULL)
+                {
+                    /* Codes_SRS_RATELIMITIO_11_044: [ If queueing the send fails, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+                    LogError("Failed queueing pending send.");
+                    free(pending_send);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    link->queued_bytes[ratelimitio_instance->priority] += size;
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void ratelimitio_dowork(CONCRETE_IO_HANDLE ratelimitio)
+{
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+    if (ratelimitio_instance == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_056: [ If `ratelimitio` is NULL, `ratelimitio_dowork` shall do nothing. ]*/
+        LogError("NULL ratelimitio.");
+    }
+    else
+    {
+        if ((ratelimitio_instance->ratelimitio_state == RATELIMITIO_STATE_OPEN) &&
+            (singlylinkedlist_get_head_item(ratelimitio_instance->pending_sends) != NULL))
+        {
+            /* Codes_SRS_RATELIMITIO_11_050: [ `ratelimitio_dowork` shall add `bytes_per_second` tokens per second of elapsed time to the link, capped at `burst_size`. ]*/
+            refill_tokens(ratelimitio_instance->link);
+            release_pending_sends(ratelimitio_instance);
+        }
+
+        /* Codes_SRS_RATELIMITIO_11_055: [ `ratelimitio_dowork` shall call `xio_dowork` on the underlying IO. ]*/
+        xio_dowork(ratelimitio_instance->underlying_io);
+    }
+}
+
+static int ratelimitio_setoption(CONCRETE_IO_HANDLE ratelimitio, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((ratelimitio == NULL) || (option_name == NULL))
+    {
+        /* Codes_SRS_RATELIMITIO_11_061: [ If `ratelimitio` or `option_name` is NULL, `ratelimitio_setoption` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ratelimitio = %p, option_name = %p", ratelimitio, option_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+        /* Codes_SRS_RATELIMITIO_11_060: [ `ratelimitio_setoption` shall pass all options to the underlying IO by calling `xio_setoption` and return its result. ]*/
+        if (xio_setoption(ratelimitio_instance->underlying_io, option_name, value) != 0)
+        {
+            LogError("Unrecognized option %s", option_name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE ratelimitio_retrieveoptions(CONCRETE_IO_HANDLE ratelimitio)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (ratelimitio == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_066: [ If `ratelimitio` is NULL, `ratelimitio_retrieveoptions` shall fail and return NULL. ]*/
+        LogError("NULL ratelimitio.");
+        result = NULL;
+    }
+    else
+    {
+        RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+        /* Codes_SRS_RATELIMITIO_11_065: [ `ratelimitio_retrieveoptions` shall return the result of calling `xio_retrieveoptions` on the underlying IO. ]*/
+        result = xio_retrieveoptions(ratelimitio_instance->underlying_io);
+        if (result == NULL)
+        {
+            LogError("unable to retrieve the underlying IO options");
+        }
+    }
+
+    return result;
+}
+
+static unsigned int get_ms_until_release(RATELIMITIO_INSTANCE* ratelimitio_instance, unsigned int wait_ms)
+{
+    LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(ratelimitio_instance->pending_sends);
+    RATELIMITIO_LINK_INSTANCE* link = ratelimitio_instance->link;
+    tickcounter_ms_t now;
+
+    if ((list_item != NULL) &&
+        (tickcounter_get_current_ms(link->tick_counter, &now) == 0))
+    {
+        const PENDING_SEND* pending_send = (const PENDING_SEND*)singlylinkedlist_item_get_value(list_item);
+        size_t chunk_size = pending_send->size - pending_send->bytes_released;
+        uint64_t needed_tokens;
+        uint64_t tokens = link->tokens + (uint64_t)(now - link->last_refill_ms) * link->link_options.bytes_per_second;
+        uint64_t until_release = 0;
+
+        if (chunk_size > link->link_options.burst_size)
+        {
+            chunk_size = link->link_options.burst_size;
+        }
+
+        needed_tokens = (uint64_t)chunk_size * TOKEN_UNITS_PER_BYTE;
+        if (tokens < needed_tokens)
+        {
+            until_release = (needed_tokens - tokens + link->link_options.bytes_per_second - 1) / link->link_options.bytes_per_second;
+        }
+
+        if (until_release < wait_ms)
+        {
+            wait_ms = (unsigned int)until_release;
+        }
+    }
+
+    return wait_ms;
+}
+
+static int ratelimitio_wait(CONCRETE_IO_HANDLE ratelimitio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+    RATELIMITIO_INSTANCE* ratelimitio_instance = (RATELIMITIO_INSTANCE*)ratelimitio;
+
+    if (ratelimitio_instance == NULL)
+    {
+        /* Codes_SRS_RATELIMITIO_11_071: [ If `ratelimitio` is NULL, `ratelimitio_wait` shall fail and return a non-zero value. ]*/
+        LogError("NULL ratelimitio.");
+        result = __FAILURE__;
+    }
+    else if ((ratelimitio_instance->ratelimitio_state == RATELIMITIO_STATE_OPEN) &&
+        ((interest & IO_WAIT_WRITE) != 0))
+    {
+        /* Codes_SRS_RATELIMITIO_11_072: [ Since sends are queued without limit while the IO is open, an `interest` including `IO_WAIT_WRITE` shall then be satisfied immediately. ]*/
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_RATELIMITIO_11_070: [ `ratelimitio_wait` shall call `xio_wait` on the underlying IO, with `timeout_ms` shortened to the time until the next queued chunk can be released, and return its result. ]*/
+        result = xio_wait(ratelimitio_instance->underlying_io, get_ms_until_release(ratelimitio_instance, timeout_ms), interest);
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION ratelimitio_interface_description =
+{
+    ratelimitio_retrieveoptions,
+    ratelimitio_create,
+    ratelimitio_destroy,
+    ratelimitio_open,
+    ratelimitio_close,
+    ratelimitio_send,
+    ratelimitio_dowork,
+    ratelimitio_setoption,
+    ratelimitio_wait
+};
+
+const IO_INTERFACE_DESCRIPTION* ratelimitio_get_interface_description(void)
+{
+    /* Codes_SRS_RATELIMITIO_11_080: [ `ratelimitio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `ratelimitio_retrieveoptions`, `ratelimitio_create`, `ratelimitio_destroy`, `ratelimitio_open`, `ratelimitio_close`, `ratelimitio_send`, `ratelimitio_dowork`, `ratelimitio_setoption` and `ratelimitio_wait`. ]*/
+    return &ratelimitio_interface_description;
+}
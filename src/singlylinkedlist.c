@@ -17,8 +17,37 @@ typedef struct SINGLYLINKEDLIST_INSTANCE_TAG
 {
     LIST_ITEM_INSTANCE* head;
     LIST_ITEM_INSTANCE* tail;
+    /* removed nodes kept for singlylinkedlist_add to reuse, chained through next */
+    LIST_ITEM_INSTANCE* cached_items;
+    size_t cached_item_count;
+    size_t max_cached_items;
 } LIST_INSTANCE;
 
+static void release_item(LIST_INSTANCE* list_instance, LIST_ITEM_INSTANCE* item)
+{
+    if (list_instance->cached_item_count < list_instance->max_cached_items)
+    {
+        item->next = list_instance->cached_items;
+        list_instance->cached_items = item;
+        list_instance->cached_item_count++;
+    }
+    else
+    {
+        free(item);
+    }
+}
+
+static void free_cached_items(LIST_INSTANCE* list_instance, size_t max_cached_items)
+{
+    while (list_instance->cached_item_count > max_cached_items)
+    {
+        LIST_ITEM_INSTANCE* cached_item = list_instance->cached_items;
+        list_instance->cached_items = (LIST_ITEM_INSTANCE*)cached_item->next;
+        list_instance->cached_item_count--;
+        free(cached_item);
+    }
+}
+
 SINGLYLINKEDLIST_HANDLE singlylinkedlist_create(void)
 {
     LIST_INSTANCE* result;
@@ -30,6 +59,10 @@ SINGLYLINKEDLIST_HANDLE singlylinkedlist_create(void)
         /* Codes_SRS_LIST_01_002: [If any error occurs during the list creation, singlylinkedlist_create shall return NULL.] */
         result->head = NULL;
         result->tail = NULL;
+        /* Codes_SRS_LIST_01_026: [A newly created list shall not cache any removed nodes.] */
+        result->cached_items = NULL;
+        result->cached_item_count = 0;
+        result->max_cached_items = 0;
     }
 
     return result;
@@ -49,6 +82,8 @@ void singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list)
             free(current_item);
         }
 
+        free_cached_items(list_instance, 0);
+
         /* Codes_SRS_LIST_01_003: [singlylinkedlist_destroy shall free all resources associated with the list identified by the handle argument.] */
         free(list_instance);
     }
@@ -68,7 +103,18 @@ LIST_ITEM_HANDLE singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void*
     else
     {
         LIST_INSTANCE* list_instance = (LIST_INSTANCE*)list;
-        result = (LIST_ITEM_INSTANCE*)malloc(sizeof(LIST_ITEM_INSTANCE));
+
+        if (list_instance->cached_items != NULL)
+        {
+            /* Codes_SRS_LIST_01_030: [If the list has cached nodes, singlylinkedlist_add shall reuse one of them instead of allocating a new node.] */
+            result = list_instance->cached_items;
+            list_instance->cached_items = (LIST_ITEM_INSTANCE*)result->next;
+            list_instance->cached_item_count--;
+        }
+        else
+        {
+            result = (LIST_ITEM_INSTANCE*)malloc(sizeof(LIST_ITEM_INSTANCE));
+        }
 
         if (result == NULL)
         {
@@ -132,7 +178,8 @@ int singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
                     list_instance->tail = previous_item;
                 }
 
-                free(current_item);
+                /* Codes_SRS_LIST_01_031: [singlylinkedlist_remove and singlylinkedlist_remove_if shall cache the removed node as long as fewer than max_cached_items nodes are cached, and free it otherwise.] */
+                release_item(list_instance, current_item);
 
                 break;
             }
@@ -303,7 +350,8 @@ int singlylinkedlist_remove_if(SINGLYLINKEDLIST_HANDLE list, LIST_CONDITION_FUNC
                     list_instance->tail = previous_item;
                 }
 
-                free(current_item);
+                /* Codes_SRS_LIST_01_031: [singlylinkedlist_remove and singlylinkedlist_remove_if shall cache the removed node as long as fewer than max_cached_items nodes are cached, and free it otherwise.] */
+                release_item(list_instance, current_item);
             }
             /* Codes_SRS_LIST_09_005: [ If the condition function returns false, singlylinkedlist_find shall consider that item as not to be removed. ] */
             else
@@ -364,4 +412,30 @@ int singlylinkedlist_foreach(SINGLYLINKEDLIST_HANDLE list, LIST_ACTION_FUNCTION
     }
 
     return result;
-}
\ No newline at end of file
+}
+
+int singlylinkedlist_set_item_cache_size(SINGLYLINKEDLIST_HANDLE list, size_t max_cached_items)
+{
+    int result;
+
+    if (list == NULL)
+    {
+        /* Codes_SRS_LIST_01_027: [If the list argument is NULL, singlylinkedlist_set_item_cache_size shall fail and return a non-zero value.] */
+        LogError("Invalid argument (list=NULL)");
+        result = __FAILURE__;
+    }
+    else
+    {
+        LIST_INSTANCE* list_instance = (LIST_INSTANCE*)list;
+
+        /* Codes_SRS_LIST_01_028: [singlylinkedlist_set_item_cache_size shall set the number of removed nodes the list keeps for reuse to max_cached_items and on success it shall return 0.] */
+        list_instance->max_cached_items = max_cached_items;
+
+        /* Codes_SRS_LIST_01_029: [Nodes already cached beyond max_cached_items shall be freed.] */
+        free_cached_items(list_instance, max_cached_items);
+
+        result = 0;
+    }
+
+    return result;
+}
@@ -51,6 +51,7 @@ typedef struct TLS_IO_INSTANCE_TAG
     YarrowContext yarrowContext;
     TlsContext *tlsContext;
     TlsSocket socket;
+    unsigned char receive_buffer[TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE];
 } TLS_IO_INSTANCE;
 
 static int tlsio_cyclonessl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context);
@@ -491,14 +492,12 @@ static void tlsio_cyclonessl_dowork(CONCRETE_IO_HANDLE tls_io)
         if ((tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN) &&
             (tls_io_instance->tlsio_state != TLSIO_STATE_ERROR))
         {
-            unsigned char buffer[64];
-
             size_t received;
 
             /* Codes_SRS_TLSIO_CYCLONESSL_01_050: [ tlsio_cyclonessl_dowork shall check if any bytes are available to be read from the CycloneSSL library and indicate those bytes as received. ]*/
-            /* Codes_SRS_TLSIO_CYCLONESSL_01_053: [ If the IO is open, tlsio_cyclonessl_dowork shall attempt to read 64 bytes from the TLS library by calling tlsRead. ]*/
+            /* Codes_SRS_TLSIO_CYCLONESSL_01_053: [ If the IO is open, tlsio_cyclonessl_dowork shall attempt to read up to TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE bytes from the TLS library by calling tlsRead. ]*/
             /* Codes_SRS_TLSIO_CYCLONESSL_01_054: [ The flags argument for tlsRead shall be 0. ]*/
-            if (tlsRead(tls_io_instance->tlsContext, buffer, sizeof(buffer), &received, 0) != 0)
+            if (tlsRead(tls_io_instance->tlsContext, tls_io_instance->receive_buffer, sizeof(tls_io_instance->receive_buffer), &received, 0) != 0)
             {
                 /* Codes_SRS_TLSIO_CYCLONESSL_01_055: [ If tlsRead fails, the error shall be indicated by calling the on_io_error callback passed in tlsio_cyclonessl_open, while passing the on_io_error_context to the callback. ]*/
                 LogError("Error received bytes");
@@ -512,7 +511,7 @@ static void tlsio_cyclonessl_dowork(CONCRETE_IO_HANDLE tls_io)
                 if (received > 0)
                 {
                     /* Codes_SRS_TLSIO_CYCLONESSL_01_080: [ If any bytes are read from CycloneSSL they should be indicated via the on_bytes_received callback passed to tlsio_cyclonessl_open. ]*/
-                    tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, received);
+                    tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->receive_buffer, received);
                 }
             }
         }
@@ -9,7 +9,16 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
+#ifndef WIN32
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
 #include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/tlsio_openssl.h"
 #include "azure_c_shared_utility/socketio.h"
@@ -40,6 +49,7 @@ typedef enum TLSIO_VERSION_TAG
     VERSION_1_0,
     VERSION_1_1,
     VERSION_1_2,
+    VERSION_1_3,
 } TLSIO_VERSION;
 
 static bool is_an_opening_state(TLSIO_STATE state)
@@ -49,8 +59,90 @@ static bool is_an_opening_state(TLSIO_STATE state)
         state == TLSIO_STATE_IN_HANDSHAKE;
 }
 
+/* called from SSL_do_handshake, so with handshake workers it runs on a pool worker thread instead of the thread calling dowork */
 typedef int(*TLS_CERTIFICATE_VALIDATION_CALLBACK)(X509_STORE_CTX*, void*);
 
+/* everything that goes into an SSL_CTX; connections with equal keys share the same SSL_CTX */
+typedef struct SSL_CONTEXT_KEY_TAG
+{
+    uint32_t hash;
+    const char* certificate;
+    const char* x509certificate;
+    const char* x509privatekey;
+    const char* x509_ecc_cert;
+    const char* x509_ecc_aliaskey;
+    TLSIO_VERSION tls_version;
+    TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
+    void* tls_validation_callback_data;
+} SSL_CONTEXT_KEY;
+
+typedef struct SSL_CONTEXT_CACHE_ENTRY_TAG
+{
+    SSL_CONTEXT_KEY key;
+    SSL_CTX* ssl_context;
+    size_t ref_count;
+    LIST_ITEM_HANDLE list_item;
+} SSL_CONTEXT_CACHE_ENTRY;
+
+/* a client session that a later connection to the same endpoint, with the same configuration, may resume */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    SSL_CONTEXT_KEY key;
+    SSL_SESSION* session;
+} TLS_SESSION_CACHE_ENTRY;
+
+#define TLS_SESSION_CACHE_MAX_ENTRIES       64
+/* SSL contexts no connection uses are kept for the next connection with the same configuration */
+#define SSL_CONTEXT_CACHE_MAX_IDLE_ENTRIES  16
+
+/* a send that the socket could not take right away while OpenSSL writes straight to it */
+typedef struct PENDING_TLS_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} PENDING_TLS_SEND;
+
+/* Plaintext is read in chunks of up to one TLS record (2^14 bytes) and handed to the upper layer in a single callback per batch */
+#ifndef TLSIO_OPENSSL_RECEIVE_BUFFER_SIZE
+#define TLSIO_OPENSSL_RECEIVE_BUFFER_SIZE   16384
+#endif
+
+/* Handshake steps can run on a process-wide pool of worker threads (tls_handshake_worker_threads option) */
+#ifndef TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS
+#define TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS 64
+#endif
+
+typedef enum HANDSHAKE_JOB_STATE_TAG
+{
+    HANDSHAKE_JOB_IDLE,
+    HANDSHAKE_JOB_QUEUED,
+    HANDSHAKE_JOB_RUNNING,
+    HANDSHAKE_JOB_DONE
+} HANDSHAKE_JOB_STATE;
+
+/* The socket BIO writes with MSG_NOSIGNAL, so that a peer reset fails the write instead of raising SIGPIPE; cloning the method needs OpenSSL 1.1.0 */
+#if defined(MSG_NOSIGNAL) && (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+#define TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+#endif
+
+/* TLS 1.3 0-RTT (tls_early_data option) needs SSL_write_early_data, which came with OpenSSL 1.1.1 */
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+#define TLSIO_OPENSSL_EARLY_DATA
+#endif
+
+typedef enum EARLY_DATA_STATE_TAG
+{
+    EARLY_DATA_NONE,
+    // the open is reported complete and sends go out as early data along with the ClientHello
+    EARLY_DATA_WRITING,
+    // the rest of the handshake is running, sends are queued until it is done
+    EARLY_DATA_FINISHING
+} EARLY_DATA_STATE;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE underlying_io;
@@ -64,6 +156,7 @@ typedef struct TLS_IO_INSTANCE_TAG
     void* on_io_error_context;
     SSL* ssl;
     SSL_CTX* ssl_context;
+    SSL_CONTEXT_CACHE_ENTRY* ssl_context_entry;
     BIO* in_bio;
     BIO* out_bio;
     TLSIO_STATE tlsio_state;
@@ -75,8 +168,37 @@ typedef struct TLS_IO_INSTANCE_TAG
     TLSIO_VERSION tls_version;
     TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
     void* tls_validation_callback_data;
+    char* hostname;
+    int port;
+    bool tls_session_resumption;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    unsigned char* send_buffer;
+    size_t send_buffer_size;
+    bool socket_fast_path;
+    bool kernel_tls;
+    bool underlying_is_socketio;
+    bool socket_bio_mode;
+    SINGLYLINKEDLIST_HANDLE pending_sends;
+    size_t handshake_worker_threads;
+    /* the fields below up to deferred_input belong to the handshake worker while a step is queued or running */
+    HANDSHAKE_JOB_STATE handshake_job_state;
+    int handshake_result;
+    int handshake_ssl_error;
+    unsigned long handshake_error_code;
+    unsigned char* deferred_input;
+    size_t deferred_input_size;
+    bool early_data;
+    EARLY_DATA_STATE early_data_state;
+    /* copy of everything sent as early data, written again if the server rejects it */
+    unsigned char* early_data_bytes;
+    size_t early_data_size;
+    size_t max_early_data;
 } TLS_IO_INSTANCE;
 
+static bool is_handshake_step_in_flight(TLS_IO_INSTANCE* tls_io_instance);
+static int wait_for_handshake_step_done(TLS_IO_INSTANCE* tls_io_instance, unsigned int timeout_ms);
+
 struct CRYPTO_dynlock_value
 {
     LOCK_HANDLE lock;
@@ -179,6 +301,10 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
             {
                 int_value = 12;
             }
+            else if (*(TLSIO_VERSION*)value == VERSION_1_3)
+            {
+                int_value = 13;
+            }
             else
             {
                 LogError("Unexpected TLS version value (%d)", *(int*)value);
@@ -212,6 +338,96 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
         {
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning tls_session_resumption option");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_SOCKET_FAST_PATH) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning tls_socket_fast_path option");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_KERNEL_TLS) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning tls_kernel_tls option");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_EARLY_DATA) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning tls_early_data option");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning tls_receive_buffer_size option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_HANDSHAKE_WORKER_THREADS) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning tls_handshake_worker_threads option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -239,7 +455,13 @@ static void tlsio_openssl_DestroyOption(const char* name, const void* value)
             (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
             (strcmp(name, OPTION_X509_ECC_CERT) == 0) ||
             (strcmp(name, OPTION_X509_ECC_KEY) == 0) ||
-            (strcmp(name, OPTION_TLS_VERSION) == 0)
+            (strcmp(name, OPTION_TLS_VERSION) == 0) ||
+            (strcmp(name, OPTION_TLS_SESSION_RESUMPTION) == 0) ||
+            (strcmp(name, OPTION_TLS_SOCKET_FAST_PATH) == 0) ||
+            (strcmp(name, OPTION_TLS_KERNEL_TLS) == 0) ||
+            (strcmp(name, OPTION_TLS_EARLY_DATA) == 0) ||
+            (strcmp(name, OPTION_TLS_RECEIVE_BUFFER_SIZE) == 0) ||
+            (strcmp(name, OPTION_TLS_HANDSHAKE_WORKER_THREADS) == 0)
             )
         {
             free((void*)value);
@@ -337,6 +559,60 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (
+                (tls_io_instance->tls_session_resumption) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SESSION_RESUMPTION, &tls_io_instance->tls_session_resumption) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_session_resumption option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->socket_fast_path) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SOCKET_FAST_PATH, &tls_io_instance->socket_fast_path) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_socket_fast_path option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->kernel_tls) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_KERNEL_TLS, &tls_io_instance->kernel_tls) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_kernel_tls option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->early_data) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_EARLY_DATA, &tls_io_instance->early_data) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_early_data option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->receive_buffer_size != TLSIO_OPENSSL_RECEIVE_BUFFER_SIZE) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_RECEIVE_BUFFER_SIZE, &tls_io_instance->receive_buffer_size) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_receive_buffer_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->handshake_worker_threads != 0) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_HANDSHAKE_WORKER_THREADS, &tls_io_instance->handshake_worker_threads) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save tls_handshake_worker_threads option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else if (tls_io_instance->tls_version != 0)
             {
                 if (OptionHandler_AddOption(result, OPTION_TLS_VERSION, &tls_io_instance->tls_version) != OPTIONHANDLER_OK)
@@ -377,6 +653,59 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
     return result;
 }
 
+static int tlsio_openssl_wait(CONCRETE_IO_HANDLE tls_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state != TLSIO_STATE_OPEN) &&
+            !is_an_opening_state(tls_io_instance->tlsio_state))
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN or an opening state.");
+            result = __FAILURE__;
+        }
+        else if (is_handshake_step_in_flight(tls_io_instance))
+        {
+            /* a worker owns the SSL object, only its completion can move the handshake along */
+            result = wait_for_handshake_step_done(tls_io_instance, timeout_ms);
+        }
+        else if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+            (tls_io_instance->early_data_state == EARLY_DATA_WRITING) &&
+            (tls_io_instance->early_data_size == 0))
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_046: [ While the open is complete but nothing has been sent as early data, tlsio_openssl_wait shall return 0 without waiting, since the ClientHello has not been generated yet and the next tlsio_openssl_dowork sends it. ]*/
+            result = 0;
+        }
+        else if (((tls_io_instance->ssl != NULL) && (SSL_pending(tls_io_instance->ssl) > 0)) ||
+            ((tls_io_instance->out_bio != NULL) && (BIO_ctrl_pending(tls_io_instance->out_bio) > 0)))
+        {
+            /* OpenSSL already holds decrypted bytes or records waiting to be pushed down,
+               the next dowork has work to do regardless of the state of the socket */
+            result = 0;
+        }
+        else if (xio_wait(tls_io_instance->underlying_io, timeout_ms,
+            (tls_io_instance->socket_bio_mode && (singlylinkedlist_get_head_item(tls_io_instance->pending_sends) != NULL)) ? (IO_WAIT_INTEREST)(interest | IO_WAIT_WRITE) : interest) != 0)
+        {
+            LogError("Failed waiting on the underlying I/O.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
 {
     tlsio_openssl_retrieveoptions,
@@ -386,10 +715,34 @@ static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
     tlsio_openssl_close,
     tlsio_openssl_send,
     tlsio_openssl_dowork,
-    tlsio_openssl_setoption
+    tlsio_openssl_setoption,
+    tlsio_openssl_wait
 };
 
 static LOCK_HANDLE * openssl_locks = NULL;
+/* guards both the SSL context cache and the TLS session cache */
+static LOCK_HANDLE ssl_cache_lock = NULL;
+static SINGLYLINKEDLIST_HANDLE ssl_context_cache = NULL;
+static size_t ssl_context_cache_idle_count = 0;
+static SINGLYLINKEDLIST_HANDLE tls_session_cache = NULL;
+static size_t tls_session_cache_count = 0;
+
+/* handshake worker pool, started lazily by the first instance that asks for workers */
+static LOCK_HANDLE handshake_pool_lock = NULL;
+static COND_HANDLE handshake_work_available = NULL;
+static COND_HANDLE handshake_job_done = NULL;
+static SINGLYLINKEDLIST_HANDLE handshake_job_queue = NULL;
+static THREAD_HANDLE handshake_workers[TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS];
+static size_t handshake_worker_count = 0;
+/* handshake steps are CPU bound, workers beyond the number of processors would only add threads */
+static size_t handshake_pool_max_workers = TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS;
+static bool handshake_pool_stopping = false;
+
+#ifdef TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+/* BIO_s_socket with its write replaced, created by tlsio_openssl_init */
+static BIO_METHOD* nosignal_socket_bio_method = NULL;
+static int (*socket_bio_write)(BIO*, const char*, int) = NULL;
+#endif
 
 
 static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const char* file, int line)
@@ -596,11 +949,31 @@ static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RES
     }
 }
 
+static int grow_send_buffer(TLS_IO_INSTANCE* tls_io_instance, size_t size)
+{
+    int result;
+    unsigned char* new_send_buffer = (unsigned char*)realloc(tls_io_instance->send_buffer, size);
+
+    if (new_send_buffer == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        tls_io_instance->send_buffer = new_send_buffer;
+        tls_io_instance->send_buffer_size = size;
+        result = 0;
+    }
+
+    return result;
+}
+
 static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
 
-    size_t pending = BIO_ctrl_pending(tls_io_instance->out_bio);
+    /* on the socket fast path OpenSSL has no output BIO to drain, it writes to the socket itself */
+    size_t pending = (tls_io_instance->out_bio == NULL) ? 0 : BIO_ctrl_pending(tls_io_instance->out_bio);
 
     if (pending == 0)
     {
@@ -608,22 +981,24 @@ static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLE
     }
     else
     {
-        unsigned char* bytes_to_send = malloc(pending);
-        if (bytes_to_send == NULL)
+        /* the send buffer only ever grows, so that a steady stream of sends does not allocate */
+        if ((pending > tls_io_instance->send_buffer_size) &&
+            (grow_send_buffer(tls_io_instance, pending) != 0))
         {
-            LogError("NULL bytes_to_send.");
+            LogError("Failed growing the send buffer to %lu bytes.", (unsigned long)pending);
             result = __FAILURE__;
         }
         else
         {
-            if (BIO_read(tls_io_instance->out_bio, bytes_to_send, (int)pending) != (int)pending)
+            /* the bytes are drained from the BIO before xio_send, since a send complete indicated from within xio_send may already queue more data */
+            if (BIO_read(tls_io_instance->out_bio, tls_io_instance->send_buffer, (int)pending) != (int)pending)
             {
                 log_ERR_get_error("BIO_read not in pending state.");
                 result = __FAILURE__;
             }
             else
             {
-                if (xio_send(tls_io_instance->underlying_io, bytes_to_send, pending, on_send_complete, callback_context) != 0)
+                if (xio_send(tls_io_instance->underlying_io, tls_io_instance->send_buffer, pending, on_send_complete, callback_context) != 0)
                 {
                     LogError("Error in xio_send.");
                     result = __FAILURE__;
@@ -633,359 +1008,1757 @@ static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLE
                     result = 0;
                 }
             }
-
-            free(bytes_to_send);
         }
     }
 
     return result;
 }
 
-// Non-NULL tls_io_instance is guaranteed by callers. 
-// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
-static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+#ifdef TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+static int nosignal_socket_bio_write(BIO* bio, const char* buffer, int size)
 {
-    int hsret;
-    // ERR_clear_error must be called before any call that might set an
-    // SSL_get_error result
-    ERR_clear_error();
-    hsret = SSL_do_handshake(tls_io_instance->ssl);
-    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    int result;
+
+#ifdef BIO_get_ktls_send
+    if (BIO_get_ktls_send(bio))
     {
-        int ssl_err = SSL_get_error(tls_io_instance->ssl, hsret);
-        if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE)
-        {
-            if (ssl_err == SSL_ERROR_SSL)
-            {
-                LogInfo(ERR_error_string(ERR_get_error(), NULL));
-            }
-            else
-            {
-                LogInfo("SSL handshake failed: %d", ssl_err);
-            }
-            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
-        }
-        else
+        // control records are sent by the socket BIO of OpenSSL once the kernel encrypts
+        result = socket_bio_write(bio, buffer, size);
+    }
+    else
+#endif
+    {
+        int socket_descriptor = -1;
+
+        (void)BIO_get_fd(bio, &socket_descriptor);
+        errno = 0;
+        result = (int)send(socket_descriptor, buffer, (size_t)size, MSG_NOSIGNAL);
+
+        BIO_clear_retry_flags(bio);
+        if ((result <= 0) && BIO_sock_should_retry(result))
         {
-            if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
-            {
-                LogError("Error in write_outgoing_bytes.");
-                tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
-            }
+            BIO_set_retry_write(bio);
         }
     }
+
+    return result;
+}
+
+static void create_nosignal_socket_bio_method(void)
+{
+    const BIO_METHOD* socket_method = BIO_s_socket();
+
+    if ((nosignal_socket_bio_method = BIO_meth_new(BIO_TYPE_SOCKET, "socket without SIGPIPE")) == NULL)
+    {
+        log_ERR_get_error("Failed BIO_meth_new, the socket BIO may raise SIGPIPE.");
+    }
+    else if ((BIO_meth_set_write(nosignal_socket_bio_method, nosignal_socket_bio_write) != 1) ||
+        (BIO_meth_set_read(nosignal_socket_bio_method, BIO_meth_get_read(socket_method)) != 1) ||
+        (BIO_meth_set_ctrl(nosignal_socket_bio_method, BIO_meth_get_ctrl(socket_method)) != 1) ||
+        (BIO_meth_set_create(nosignal_socket_bio_method, BIO_meth_get_create(socket_method)) != 1) ||
+        (BIO_meth_set_destroy(nosignal_socket_bio_method, BIO_meth_get_destroy(socket_method)) != 1))
+    {
+        log_ERR_get_error("Failed setting up the socket BIO method, the socket BIO may raise SIGPIPE.");
+        BIO_meth_free(nosignal_socket_bio_method);
+        nosignal_socket_bio_method = NULL;
+    }
     else
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+        socket_bio_write = BIO_meth_get_write(socket_method);
     }
 }
+#endif
 
-static void on_underlying_io_close_complete(void* context)
+static const BIO_METHOD* get_socket_bio_method(void)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    const BIO_METHOD* result;
 
-    switch (tls_io_instance->tlsio_state)
+#ifdef TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+    if (nosignal_socket_bio_method != NULL)
     {
-    default:
-    case TLSIO_STATE_NOT_OPEN:
-    case TLSIO_STATE_OPEN:
-    case TLSIO_STATE_IN_HANDSHAKE:
-    case TLSIO_STATE_HANDSHAKE_FAILED:
-    case TLSIO_STATE_ERROR:
-        break;
+        /* Codes_SRS_TLSIO_OPENSSL_11_036: [ Where MSG_NOSIGNAL is available the socket BIO shall write with send and MSG_NOSIGNAL, so that writing to a socket the peer has closed fails instead of raising SIGPIPE. ]*/
+        result = nosignal_socket_bio_method;
+    }
+    else
+#endif
+    {
+        result = BIO_s_socket();
+    }
 
-    case TLSIO_STATE_OPENING_UNDERLYING_IO:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-        break;
+    return result;
+}
 
-    case TLSIO_STATE_CLOSING:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+static void use_socket_bio_if_possible(TLS_IO_INSTANCE* tls_io_instance)
+{
+    // kTLS needs OpenSSL to own the socket, so it always goes through the socket BIO
+    if ((tls_io_instance->socket_fast_path || tls_io_instance->kernel_tls) &&
+        tls_io_instance->underlying_is_socketio)
+    {
+        int socket_descriptor;
+        BIO* socket_bio = BIO_new(get_socket_bio_method());
 
-        if (tls_io_instance->on_io_close_complete != NULL)
+        if (socket_bio == NULL)
         {
-            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+            log_ERR_get_error("Failed BIO_new for socket BIO, staying on memory BIOs.");
+        }
+        /* Codes_SRS_TLSIO_OPENSSL_11_032: [ If the socket BIO cannot be created or the underlying IO does not hand off its socket, the adapter shall keep using the memory BIOs. ]*/
+        else if (xio_setoption(tls_io_instance->underlying_io, OPTION_SOCKET_DESCRIPTOR_HANDOFF, &socket_descriptor) != 0)
+        {
+            LogInfo("The underlying I/O did not hand off its socket, staying on memory BIOs.");
+            (void)BIO_free(socket_bio);
+        }
+        else
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_030: [ When OPTION_TLS_SOCKET_FAST_PATH or OPTION_TLS_KERNEL_TLS is set and the underlying IO is socketio, once the underlying IO is open the adapter shall get the socket with OPTION_SOCKET_DESCRIPTOR_HANDOFF and replace the memory BIOs with a socket BIO that does not close the socket. ]*/
+            (void)BIO_set_fd(socket_bio, socket_descriptor, BIO_NOCLOSE);
+
+            // SSL_set_bio frees the memory BIOs, the socket itself stays owned by socketio
+            SSL_set_bio(tls_io_instance->ssl, socket_bio, socket_bio);
+            /* Codes_SRS_TLSIO_OPENSSL_11_031: [ The socket BIO shall be used with partial writes and moving write buffers enabled. ]*/
+            (void)SSL_set_mode(tls_io_instance->ssl, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+            tls_io_instance->in_bio = NULL;
+            tls_io_instance->out_bio = NULL;
+            tls_io_instance->socket_bio_mode = true;
+
+            if (tls_io_instance->kernel_tls)
+            {
+#ifdef SSL_OP_ENABLE_KTLS
+                /* Codes_SRS_TLSIO_OPENSSL_11_033: [ With OPTION_TLS_KERNEL_TLS set, SSL_OP_ENABLE_KTLS shall be set on the SSL object when OpenSSL supports it. ]*/
+                // OpenSSL installs the negotiated keys on the socket once the handshake is done, when the kernel and cipher allow it
+                (void)SSL_set_options(tls_io_instance->ssl, SSL_OP_ENABLE_KTLS);
+#else
+                LogInfo("This OpenSSL build has no kTLS support, encrypting in user space.");
+#endif
+            }
         }
-        break;
     }
 }
 
-static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+static void log_kernel_tls_status(TLS_IO_INSTANCE* tls_io_instance)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+    if (tls_io_instance->kernel_tls &&
+        tls_io_instance->socket_bio_mode)
+    {
+        LogInfo("kTLS send offload %s, receive offload %s.",
+            BIO_get_ktls_send(SSL_get_wbio(tls_io_instance->ssl)) ? "on" : "off",
+            BIO_get_ktls_recv(SSL_get_rbio(tls_io_instance->ssl)) ? "on" : "off");
+    }
+#else
+    (void)tls_io_instance;
+#endif
+}
 
-    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+// Writes as much of the bytes as the socket takes right now, the rest has to be written again with a later call
+static int write_to_socket_bio(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* bytes, size_t size, size_t* written)
+{
+    int result = 0;
+    bool would_block = false;
+
+    *written = 0;
+    while ((result == 0) && !would_block && (*written < size))
     {
-        if (open_result == IO_OPEN_OK)
-        {
-            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
+        int res;
 
-            // Begin the handshake process here. It continues in on_underlying_io_bytes_received
-            send_handshake_bytes(tls_io_instance);
+        ERR_clear_error();
+        res = SSL_write(tls_io_instance->ssl, bytes + *written, (int)(size - *written));
+        if (res > 0)
+        {
+            *written += res;
         }
         else
         {
-            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPENING_UNDERLYING_IO.");
+            int ssl_err = SSL_get_error(tls_io_instance->ssl, res);
+            if ((ssl_err == SSL_ERROR_WANT_WRITE) || (ssl_err == SSL_ERROR_WANT_READ))
+            {
+                would_block = true;
+            }
+            else
+            {
+                log_ERR_get_error("SSL_write error.");
+                result = __FAILURE__;
+            }
         }
     }
+
+    return result;
 }
 
-static void on_underlying_io_error(void* context)
+static int add_pending_send(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* bytes, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int result;
+    PENDING_TLS_SEND* pending_send = (PENDING_TLS_SEND*)malloc(sizeof(PENDING_TLS_SEND));
 
-    switch (tls_io_instance->tlsio_state)
+    if (pending_send == NULL)
     {
-    default:
-        break;
+        LogError("Failed allocating pending send.");
+        result = __FAILURE__;
+    }
+    else if ((pending_send->bytes = (unsigned char*)malloc(size)) == NULL)
+    {
+        LogError("Failed allocating pending send bytes.");
+        free(pending_send);
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(pending_send->bytes, bytes, size);
+        pending_send->size = size;
+        pending_send->on_send_complete = on_send_complete;
+        pending_send->callback_context = callback_context;
 
-    case TLSIO_STATE_OPENING_UNDERLYING_IO:
-    case TLSIO_STATE_IN_HANDSHAKE:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-        break;
+        if (singlylinkedlist_add(tls_io_instance->pending_sends, pending_send) == NULL)
+        {
+            LogError("Failed queueing pending send.");
+            free(pending_send->bytes);
+            free(pending_send);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
 
-    case TLSIO_STATE_OPEN:
-        indicate_error(tls_io_instance);
-        break;
+    return result;
+}
+
+/* Codes_SRS_TLSIO_OPENSSL_11_034: [ On the socket BIO, tlsio_openssl_send shall write to OpenSSL directly. Bytes the socket does not take shall be queued, and written by tlsio_openssl_dowork before on_send_complete is called. ]*/
+static int send_over_socket_bio(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* bytes, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    size_t written;
+
+    if (singlylinkedlist_get_head_item(tls_io_instance->pending_sends) != NULL)
+    {
+        // keep the order, this goes out after whatever is already waiting
+        result = add_pending_send(tls_io_instance, bytes, size, on_send_complete, callback_context);
+    }
+    else if (write_to_socket_bio(tls_io_instance, bytes, size, &written) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (written < size)
+    {
+        result = add_pending_send(tls_io_instance, bytes + written, size - written, on_send_complete, callback_context);
+    }
+    else
+    {
+        if (on_send_complete != NULL)
+        {
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
+
+        result = 0;
     }
+
+    return result;
 }
 
-static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+static void complete_pending_send(TLS_IO_INSTANCE* tls_io_instance, LIST_ITEM_HANDLE list_item, IO_SEND_RESULT send_result)
 {
-    int result = 0;
-    unsigned char buffer[64];
+    PENDING_TLS_SEND* pending_send = (PENDING_TLS_SEND*)singlylinkedlist_item_get_value(list_item);
 
-    int rcv_bytes = 1;
+    (void)singlylinkedlist_remove(tls_io_instance->pending_sends, list_item);
 
-    while (rcv_bytes > 0)
+    if (pending_send->on_send_complete != NULL)
     {
-        if (tls_io_instance->ssl == NULL)
+        pending_send->on_send_complete(pending_send->callback_context, send_result);
+    }
+
+    free(pending_send->bytes);
+    free(pending_send);
+}
+
+static void flush_pending_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    LIST_ITEM_HANDLE first_pending_send;
+
+    while ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+        ((first_pending_send = singlylinkedlist_get_head_item(tls_io_instance->pending_sends)) != NULL))
+    {
+        PENDING_TLS_SEND* pending_send = (PENDING_TLS_SEND*)singlylinkedlist_item_get_value(first_pending_send);
+        size_t written;
+
+        if (write_to_socket_bio(tls_io_instance, pending_send->bytes, pending_send->size, &written) != 0)
         {
-            LogError("SSL channel closed in decode_ssl_received_bytes.");
-            result = __FAILURE__;
-            return result;
+            complete_pending_send(tls_io_instance, first_pending_send, IO_SEND_ERROR);
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+        }
+        else if (written < pending_send->size)
+        {
+            // OpenSSL accepts the moved remainder on retry, since SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER is set
+            (void)memmove(pending_send->bytes, pending_send->bytes + written, pending_send->size - written);
+            pending_send->size -= written;
+            break;
+        }
+        else
+        {
+            complete_pending_send(tls_io_instance, first_pending_send, IO_SEND_OK);
         }
+    }
+}
+
+static void cancel_pending_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    LIST_ITEM_HANDLE first_pending_send;
+
+    while ((first_pending_send = singlylinkedlist_get_head_item(tls_io_instance->pending_sends)) != NULL)
+    {
+        complete_pending_send(tls_io_instance, first_pending_send, IO_SEND_CANCELLED);
+    }
+}
+
+static void remove_tls_session(TLS_IO_INSTANCE* tls_io_instance);
+static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance);
+static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance);
+
+// Runs one SSL_do_handshake step and records its outcome in the instance.
+// When handshake workers are used this runs on a worker thread, so it must not touch anything but the SSL object.
+/* Codes_SRS_TLSIO_OPENSSL_11_058: [ The certificate validation callback set with tls_validation_callback is called by OpenSSL during the handshake step, so with workers it shall run on the worker thread that runs the step. ]*/
+static void run_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    // ERR_clear_error must be called before any call that might set an
+    // SSL_get_error result
+    ERR_clear_error();
+    tls_io_instance->handshake_result = SSL_do_handshake(tls_io_instance->ssl);
+    if (tls_io_instance->handshake_result != SSL_DO_HANDSHAKE_SUCCESS)
+    {
+        tls_io_instance->handshake_ssl_error = SSL_get_error(tls_io_instance->ssl, tls_io_instance->handshake_result);
+        // the OpenSSL error queue is per thread, so the reason has to be picked up here
+        tls_io_instance->handshake_error_code = (tls_io_instance->handshake_ssl_error == SSL_ERROR_SSL) ? ERR_get_error() : 0;
+    }
+    else
+    {
+        tls_io_instance->handshake_ssl_error = SSL_ERROR_NONE;
+        tls_io_instance->handshake_error_code = 0;
+    }
+}
 
-        rcv_bytes = SSL_read(tls_io_instance->ssl, buffer, sizeof(buffer));
-        if (rcv_bytes > 0)
+// Acts on the outcome of the last handshake step, always on the thread calling dowork.
+static void complete_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->handshake_result != SSL_DO_HANDSHAKE_SUCCESS)
+    {
+        int ssl_err = tls_io_instance->handshake_ssl_error;
+        if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE)
         {
-            if (tls_io_instance->on_bytes_received == NULL)
+            if (ssl_err == SSL_ERROR_SSL)
             {
-                LogError("NULL on_bytes_received.");
+                LogInfo(ERR_error_string(tls_io_instance->handshake_error_code, NULL));
             }
             else
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                LogInfo("SSL handshake failed: %d", ssl_err);
+            }
+            /* Codes_SRS_TLSIO_OPENSSL_11_026: [ When a handshake fails, the cached session of the connection shall be removed, so that the next attempt does a full handshake. ]*/
+            remove_tls_session(tls_io_instance);
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+        }
+        else
+        {
+            if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
             }
         }
     }
+    else
+    {
+        log_kernel_tls_status(tls_io_instance);
+        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+
+        // application data that arrived together with the end of the handshake would otherwise wait for the next received bytes
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+            !tls_io_instance->socket_bio_mode &&
+            ((BIO_ctrl_pending(tls_io_instance->in_bio) > 0) || (SSL_pending(tls_io_instance->ssl) > 0)) &&
+            (decode_ssl_received_bytes(tls_io_instance) != 0))
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+            LogError("Error in decode_ssl_received_bytes.");
+        }
+    }
+}
+
+static bool is_handshake_step_in_flight(TLS_IO_INSTANCE* tls_io_instance)
+{
+    bool result;
+
+    if ((tls_io_instance->handshake_worker_threads == 0) ||
+        (handshake_pool_lock == NULL))
+    {
+        result = false;
+    }
+    else if (Lock(handshake_pool_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the handshake worker pool.");
+        result = false;
+    }
+    else
+    {
+        result = (tls_io_instance->handshake_job_state != HANDSHAKE_JOB_IDLE);
+        (void)Unlock(handshake_pool_lock);
+    }
 
     return result;
 }
 
-static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+// Blocks until the worker pool has finished the step of the instance, for at most timeout_ms.
+/* Codes_SRS_TLSIO_OPENSSL_11_059: [ While a worker runs a step of the connection, tlsio_openssl_wait shall wait for the step to finish, for at most timeout_ms, instead of waiting on the underlying IO. ]*/
+static int wait_for_handshake_step_done(TLS_IO_INSTANCE* tls_io_instance, unsigned int timeout_ms)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int result;
 
-    int written = BIO_write(tls_io_instance->in_bio, buffer, (int)size);
-    if (written != (int)size)
+    if (Lock(handshake_pool_lock) != LOCK_OK)
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-        indicate_error(tls_io_instance);
-        log_ERR_get_error("Error in BIO_write.");
+        LogError("Failed to lock the handshake worker pool.");
+        result = __FAILURE__;
     }
     else
     {
-        switch (tls_io_instance->tlsio_state)
+        unsigned int waited_ms = 0;
+
+        result = 0;
+
+        // several instances may be waiting on the same condition, so wake up periodically and check again
+        while (((tls_io_instance->handshake_job_state == HANDSHAKE_JOB_QUEUED) || (tls_io_instance->handshake_job_state == HANDSHAKE_JOB_RUNNING)) &&
+            (waited_ms < timeout_ms))
         {
-        default:
-            break;
+            unsigned int wait_ms = ((timeout_ms - waited_ms) < 10) ? (timeout_ms - waited_ms) : 10;
+            if (Condition_Wait(handshake_job_done, handshake_pool_lock, (int)wait_ms) == COND_ERROR)
+            {
+                LogError("Failed waiting for the handshake step.");
+                result = __FAILURE__;
+                break;
+            }
 
-        case TLSIO_STATE_IN_HANDSHAKE:
-            send_handshake_bytes(tls_io_instance);
-            break;
+            waited_ms += wait_ms;
+        }
 
-        case TLSIO_STATE_OPEN:
-            if (decode_ssl_received_bytes(tls_io_instance) != 0)
+        (void)Unlock(handshake_pool_lock);
+    }
+
+    return result;
+}
+
+static int handshake_worker(void* context)
+{
+    (void)context;
+
+    if (Lock(handshake_pool_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the handshake worker pool.");
+    }
+    else
+    {
+        while (!handshake_pool_stopping)
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(handshake_job_queue);
+            if (list_item == NULL)
             {
-                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-                indicate_error(tls_io_instance);
-                LogError("Error in decode_ssl_received_bytes.");
+                /* Codes_SRS_TLSIO_OPENSSL_11_057: [ If waiting for work fails, the worker shall log an error and exit. ]*/
+                if (Condition_Wait(handshake_work_available, handshake_pool_lock, 0) != COND_OK)
+                {
+                    LogError("Failed waiting for handshake work, stopping the worker.");
+                    break;
+                }
             }
+            else
+            {
+                TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)singlylinkedlist_item_get_value(list_item);
+                (void)singlylinkedlist_remove(handshake_job_queue, list_item);
+                tls_io_instance->handshake_job_state = HANDSHAKE_JOB_RUNNING;
+                (void)Unlock(handshake_pool_lock);
+
+                run_handshake_step(tls_io_instance);
+
+                if (Lock(handshake_pool_lock) != LOCK_OK)
+                {
+                    // cannot happen with a healthy lock, the instance would stay in flight forever
+                    LogError("Failed to lock the handshake worker pool.");
+                    return 0;
+                }
+                tls_io_instance->handshake_job_state = HANDSHAKE_JOB_DONE;
+                (void)Condition_Post(handshake_job_done);
+            }
+        }
+
+        (void)Unlock(handshake_pool_lock);
+    }
+
+    return 0;
+}
+
+// Must be called with handshake_pool_lock held. The pool only ever grows, up to the largest worker count any instance asked for.
+/* Codes_SRS_TLSIO_OPENSSL_11_051: [ Workers shall be started when first needed. The pool shall only grow, up to the largest worker count any connection asked for, and never beyond the number of online processors. ]*/
+static void start_handshake_workers(size_t worker_count)
+{
+    if (worker_count > handshake_pool_max_workers)
+    {
+        worker_count = handshake_pool_max_workers;
+    }
+
+    while (handshake_worker_count < worker_count)
+    {
+        if (ThreadAPI_Create(&handshake_workers[handshake_worker_count], handshake_worker, NULL) != THREADAPI_OK)
+        {
+            LogError("Failed starting a handshake worker thread.");
             break;
         }
+        handshake_worker_count++;
+    }
+}
+
+// Hands the next handshake step to the worker pool. Returns false when the step has to run inline.
+static bool queue_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    bool result;
+
+    if ((tls_io_instance->handshake_worker_threads == 0) ||
+        (handshake_pool_lock == NULL))
+    {
+        result = false;
+    }
+    else if (Lock(handshake_pool_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the handshake worker pool.");
+        result = false;
+    }
+    else
+    {
+        if (tls_io_instance->handshake_job_state != HANDSHAKE_JOB_IDLE)
+        {
+            // a step is already on its way, the dowork that collects it runs the next one
+            result = true;
+        }
+        else
+        {
+            start_handshake_workers(tls_io_instance->handshake_worker_threads);
+
+            /* Codes_SRS_TLSIO_OPENSSL_11_053: [ If no worker can be started or the step cannot be queued, the step shall run on the calling thread. ]*/
+            if (handshake_worker_count == 0)
+            {
+                result = false;
+            }
+            else if (singlylinkedlist_add(handshake_job_queue, tls_io_instance) == NULL)
+            {
+                LogError("Failed queueing the handshake step.");
+                result = false;
+            }
+            else
+            {
+                /* Codes_SRS_TLSIO_OPENSSL_11_050: [ When OPTION_TLS_HANDSHAKE_WORKER_THREADS is not 0, each handshake step shall be queued to a pool of worker threads, and a worker shall be woken with Condition_Post. ]*/
+                tls_io_instance->handshake_job_state = HANDSHAKE_JOB_QUEUED;
+                (void)Condition_Post(handshake_work_available);
+                result = true;
+            }
+        }
+
+        (void)Unlock(handshake_pool_lock);
     }
+
+    return result;
+}
+
+static bool is_tls_io_instance_matching(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    return (singlylinkedlist_item_get_value(list_item) == match_context);
+}
+
+// Takes the instance back from the worker pool, waiting for a running step to finish.
+// The outcome of that step is dropped, callers are tearing the SSL object down.
+/* Codes_SRS_TLSIO_OPENSSL_11_056: [ Closing or destroying a connection shall take it back from the pool: a queued step shall be removed from the queue, and a running step shall be waited for. ]*/
+static void wait_for_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if ((tls_io_instance->handshake_worker_threads != 0) &&
+        (handshake_pool_lock != NULL))
+    {
+        if (Lock(handshake_pool_lock) != LOCK_OK)
+        {
+            LogError("Failed to lock the handshake worker pool.");
+        }
+        else
+        {
+            if (tls_io_instance->handshake_job_state == HANDSHAKE_JOB_QUEUED)
+            {
+                LIST_ITEM_HANDLE list_item = singlylinkedlist_find(handshake_job_queue, is_tls_io_instance_matching, tls_io_instance);
+                if (list_item != NULL)
+                {
+                    (void)singlylinkedlist_remove(handshake_job_queue, list_item);
+                }
+            }
+            else
+            {
+                // several instances may be waiting on the same condition, so wake up periodically and check again
+                while (tls_io_instance->handshake_job_state == HANDSHAKE_JOB_RUNNING)
+                {
+                    (void)Condition_Wait(handshake_job_done, handshake_pool_lock, 10);
+                }
+            }
+
+            tls_io_instance->handshake_job_state = HANDSHAKE_JOB_IDLE;
+            (void)Unlock(handshake_pool_lock);
+        }
+    }
+
+    free(tls_io_instance->deferred_input);
+    tls_io_instance->deferred_input = NULL;
+    tls_io_instance->deferred_input_size = 0;
+}
+
+// Bytes that arrive while a worker owns the SSL object are kept aside and fed to the input BIO once the step is collected
+/* Codes_SRS_TLSIO_OPENSSL_11_054: [ Bytes received while a worker runs a step shall be kept, and written to the input BIO when the step is collected. ]*/
+static int defer_received_bytes(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* buffer, size_t size)
+{
+    int result;
+    unsigned char* new_deferred_input = (unsigned char*)realloc(tls_io_instance->deferred_input, tls_io_instance->deferred_input_size + size);
+
+    if (new_deferred_input == NULL)
+    {
+        LogError("Failed allocating memory for the deferred handshake bytes.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(new_deferred_input + tls_io_instance->deferred_input_size, buffer, size);
+        tls_io_instance->deferred_input = new_deferred_input;
+        tls_io_instance->deferred_input_size += size;
+        result = 0;
+    }
+
+    return result;
+}
+
+// Non-NULL tls_io_instance is guaranteed by callers. 
+// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
+static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (!queue_handshake_step(tls_io_instance))
+    {
+        run_handshake_step(tls_io_instance);
+        complete_handshake_step(tls_io_instance);
+    }
+}
+
+// Picks up a handshake step the worker pool has finished and carries on from the thread calling dowork
+/* Codes_SRS_TLSIO_OPENSSL_11_055: [ tlsio_openssl_dowork shall collect a finished step and act on its outcome on the calling thread, so that all callbacks are made from tlsio_openssl_dowork. ]*/
+static void collect_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    bool is_step_done;
+
+    if ((tls_io_instance->handshake_worker_threads == 0) ||
+        (handshake_pool_lock == NULL))
+    {
+        is_step_done = false;
+    }
+    else if (Lock(handshake_pool_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the handshake worker pool.");
+        is_step_done = false;
+    }
+    else
+    {
+        is_step_done = (tls_io_instance->handshake_job_state == HANDSHAKE_JOB_DONE);
+        if (is_step_done)
+        {
+            tls_io_instance->handshake_job_state = HANDSHAKE_JOB_IDLE;
+        }
+        (void)Unlock(handshake_pool_lock);
+    }
+
+    if (is_step_done)
+    {
+        bool has_new_input = (tls_io_instance->deferred_input_size > 0);
+
+        if (has_new_input &&
+            (BIO_write(tls_io_instance->in_bio, tls_io_instance->deferred_input, (int)tls_io_instance->deferred_input_size) != (int)tls_io_instance->deferred_input_size))
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+            log_ERR_get_error("Error in BIO_write.");
+        }
+        else if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+        {
+            complete_handshake_step(tls_io_instance);
+
+            if (has_new_input)
+            {
+                if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+                {
+                    send_handshake_bytes(tls_io_instance);
+                }
+                else if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+                    (decode_ssl_received_bytes(tls_io_instance) != 0))
+                {
+                    tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                    indicate_error(tls_io_instance);
+                    LogError("Error in decode_ssl_received_bytes.");
+                }
+            }
+        }
+        else
+        {
+            // the open was abandoned while the worker was busy, nothing left to do with the outcome
+        }
+
+        free(tls_io_instance->deferred_input);
+        tls_io_instance->deferred_input = NULL;
+        tls_io_instance->deferred_input_size = 0;
+    }
+}
+
+// On a resumed session that allows it, TLS 1.3 0-RTT lets the first sends travel with the ClientHello.
+// Early data is only used with memory BIOs, the socket BIO path always does the full handshake first.
+static bool start_early_data(TLS_IO_INSTANCE* tls_io_instance)
+{
+    bool result;
+#ifdef TLSIO_OPENSSL_EARLY_DATA
+    SSL_SESSION* session;
+
+    if (!tls_io_instance->early_data ||
+        tls_io_instance->socket_bio_mode ||
+        ((session = SSL_get0_session(tls_io_instance->ssl)) == NULL) ||
+        (SSL_SESSION_get_max_early_data(session) == 0))
+    {
+        result = false;
+    }
+    else
+    {
+        /* Codes_SRS_TLSIO_OPENSSL_11_040: [ When OPTION_TLS_EARLY_DATA is set on memory BIOs and the restored session allows early data, the open shall complete as soon as the underlying IO is open. ]*/
+        tls_io_instance->max_early_data = SSL_SESSION_get_max_early_data(session);
+        tls_io_instance->early_data_size = 0;
+        tls_io_instance->early_data_state = EARLY_DATA_WRITING;
+        result = true;
+    }
+#else
+    (void)tls_io_instance;
+    result = false;
+#endif
+
+    return result;
+}
+
+static void free_early_data(TLS_IO_INSTANCE* tls_io_instance)
+{
+    free(tls_io_instance->early_data_bytes);
+    tls_io_instance->early_data_bytes = NULL;
+    tls_io_instance->early_data_size = 0;
+    tls_io_instance->early_data_state = EARLY_DATA_NONE;
+}
+
+// Sends that came in after the early data budget are written once the handshake is done, in order
+static int send_queued_after_early_data(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result = 0;
+    LIST_ITEM_HANDLE first_pending_send;
+
+    while ((result == 0) &&
+        ((first_pending_send = singlylinkedlist_get_head_item(tls_io_instance->pending_sends)) != NULL))
+    {
+        PENDING_TLS_SEND* pending_send = (PENDING_TLS_SEND*)singlylinkedlist_item_get_value(first_pending_send);
+
+        if (SSL_write(tls_io_instance->ssl, pending_send->bytes, (int)pending_send->size) != (int)pending_send->size)
+        {
+            log_ERR_get_error("SSL_write error.");
+            complete_pending_send(tls_io_instance, first_pending_send, IO_SEND_ERROR);
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)singlylinkedlist_remove(tls_io_instance->pending_sends, first_pending_send);
+
+            if (write_outgoing_bytes(tls_io_instance, pending_send->on_send_complete, pending_send->callback_context) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                result = __FAILURE__;
+            }
+
+            free(pending_send->bytes);
+            free(pending_send);
+        }
+    }
+
+    return result;
+}
+
+// The open was already reported, so from here on a failure is an error on an open tlsio
+static void finish_early_data_handshake(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    int hsret;
+
+    tls_io_instance->early_data_state = EARLY_DATA_FINISHING;
+
+    ERR_clear_error();
+    hsret = SSL_do_handshake(tls_io_instance->ssl);
+    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    {
+        int ssl_err = SSL_get_error(tls_io_instance->ssl, hsret);
+        if ((ssl_err == SSL_ERROR_WANT_READ) || (ssl_err == SSL_ERROR_WANT_WRITE))
+        {
+            result = write_outgoing_bytes(tls_io_instance, NULL, NULL);
+        }
+        else
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_045: [ If finishing the handshake fails, the cached session shall be removed and the adapter shall indicate an error. ]*/
+            log_ERR_get_error("SSL handshake failed after sending early data.");
+            remove_tls_session(tls_io_instance);
+            result = __FAILURE__;
+        }
+    }
+    else if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
+    {
+        LogError("Error in write_outgoing_bytes.");
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef TLSIO_OPENSSL_EARLY_DATA
+        /* Codes_SRS_TLSIO_OPENSSL_11_043: [ When the server answers, the handshake shall be finished. If the server did not accept the early data, the copied bytes shall be written again with SSL_write before the queued sends. ]*/
+        if ((tls_io_instance->early_data_size > 0) &&
+            (SSL_get_early_data_status(tls_io_instance->ssl) != SSL_EARLY_DATA_ACCEPTED))
+        {
+            // the server dropped the early data, it goes out again as ordinary application data
+            LogInfo("The server did not accept the %lu bytes of early data, sending them again.", (unsigned long)tls_io_instance->early_data_size);
+
+            if (SSL_write(tls_io_instance->ssl, tls_io_instance->early_data_bytes, (int)tls_io_instance->early_data_size) != (int)tls_io_instance->early_data_size)
+            {
+                log_ERR_get_error("SSL_write error.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = write_outgoing_bytes(tls_io_instance, NULL, NULL);
+            }
+        }
+        else
+#endif
+        {
+            result = 0;
+        }
+
+        free_early_data(tls_io_instance);
+
+        if ((result == 0) &&
+            (send_queued_after_early_data(tls_io_instance) != 0))
+        {
+            LogError("Error in send_queued_after_early_data.");
+            result = __FAILURE__;
+        }
+    }
+
+    if (result != 0)
+    {
+        free_early_data(tls_io_instance);
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
+    }
+}
+
+static int send_early_data(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* bytes, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+#ifdef TLSIO_OPENSSL_EARLY_DATA
+    unsigned char* new_early_data_bytes;
+    size_t written;
+
+    if ((tls_io_instance->early_data_state != EARLY_DATA_WRITING) ||
+        (singlylinkedlist_get_head_item(tls_io_instance->pending_sends) != NULL) ||
+        (size > tls_io_instance->max_early_data - tls_io_instance->early_data_size))
+    {
+        /* Codes_SRS_TLSIO_OPENSSL_11_042: [ Sends that do not fit in the early data budget, and every send after them, shall be queued and written once the handshake is done, in order. ]*/
+        result = add_pending_send(tls_io_instance, bytes, size, on_send_complete, callback_context);
+    }
+    else if ((new_early_data_bytes = (unsigned char*)realloc(tls_io_instance->early_data_bytes, tls_io_instance->early_data_size + size)) == NULL)
+    {
+        LogError("Failed allocating memory for the early data copy.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        tls_io_instance->early_data_bytes = new_early_data_bytes;
+
+        /* Codes_SRS_TLSIO_OPENSSL_11_041: [ Sends that fit in the early data budget of the session shall be written with SSL_write_early_data, and a copy of the bytes shall be kept until the handshake is done. ]*/
+        ERR_clear_error();
+        if ((SSL_write_early_data(tls_io_instance->ssl, bytes, size, &written) != 1) ||
+            (written != size))
+        {
+            log_ERR_get_error("SSL_write_early_data error.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memcpy(tls_io_instance->early_data_bytes + tls_io_instance->early_data_size, bytes, size);
+            tls_io_instance->early_data_size += size;
+
+            if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+#else
+    result = add_pending_send(tls_io_instance, bytes, size, on_send_complete, callback_context);
+#endif
+
+    return result;
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+    case TLSIO_STATE_NOT_OPEN:
+    case TLSIO_STATE_OPEN:
+    case TLSIO_STATE_IN_HANDSHAKE:
+    case TLSIO_STATE_HANDSHAKE_FAILED:
+    case TLSIO_STATE_ERROR:
+        break;
+
+    case TLSIO_STATE_OPENING_UNDERLYING_IO:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+        break;
+
+    case TLSIO_STATE_CLOSING:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        // a closed connection must not keep the shared SSL_CTX referenced until it is opened again or destroyed
+        close_openssl_instance(tls_io_instance);
+
+        if (tls_io_instance->on_io_close_complete != NULL)
+        {
+            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+        }
+        break;
+    }
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+    {
+        if (open_result == IO_OPEN_OK)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
+
+            use_socket_bio_if_possible(tls_io_instance);
+
+            if (start_early_data(tls_io_instance))
+            {
+                // The ClientHello goes out with the first send, or on the next dowork if nothing is sent before that
+                tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+                indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+            }
+            else
+            {
+                // Begin the handshake process here. It continues in on_underlying_io_bytes_received,
+                // or in tlsio_openssl_dowork when OpenSSL reads the socket directly
+                send_handshake_bytes(tls_io_instance);
+            }
+        }
+        else
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPENING_UNDERLYING_IO.");
+        }
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+        break;
+
+    case TLSIO_STATE_OPENING_UNDERLYING_IO:
+    case TLSIO_STATE_IN_HANDSHAKE:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+        break;
+
+    case TLSIO_STATE_OPEN:
+        indicate_error(tls_io_instance);
+        break;
+    }
+}
+
+static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result = 0;
+    int rcv_bytes = 1;
+
+    ERR_clear_error();
+
+    while (rcv_bytes > 0)
+    {
+        size_t batch_size = 0;
+
+        if (tls_io_instance->ssl == NULL)
+        {
+            LogError("SSL channel closed in decode_ssl_received_bytes.");
+            result = __FAILURE__;
+            return result;
+        }
+
+        if ((tls_io_instance->receive_buffer == NULL) &&
+            ((tls_io_instance->receive_buffer = (unsigned char*)malloc(tls_io_instance->receive_buffer_size)) == NULL))
+        {
+            LogError("Failed allocating the receive buffer.");
+            result = __FAILURE__;
+            return result;
+        }
+
+        /* gather as many decrypted records as fit in the buffer so that the upper layer sees one callback per batch */
+        while (batch_size < tls_io_instance->receive_buffer_size)
+        {
+            rcv_bytes = SSL_read(tls_io_instance->ssl, tls_io_instance->receive_buffer + batch_size, (int)(tls_io_instance->receive_buffer_size - batch_size));
+            if (rcv_bytes <= 0)
+            {
+                break;
+            }
+
+            batch_size += rcv_bytes;
+        }
+
+        if (batch_size > 0)
+        {
+            if (tls_io_instance->on_bytes_received == NULL)
+            {
+                LogError("NULL on_bytes_received.");
+            }
+            else
+            {
+                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->receive_buffer, batch_size);
+            }
+        }
+    }
+
+    /* with memory BIOs running out of input is the only way out of the loop, with the socket BIO it can also be the peer going away */
+    if (tls_io_instance->socket_bio_mode &&
+        (tls_io_instance->ssl != NULL))
+    {
+        int ssl_err = SSL_get_error(tls_io_instance->ssl, rcv_bytes);
+        if ((ssl_err != SSL_ERROR_WANT_READ) && (ssl_err != SSL_ERROR_WANT_WRITE))
+        {
+            log_ERR_get_error("SSL_read error.");
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_TLSIO_OPENSSL_11_035: [ On the socket BIO, tlsio_openssl_dowork shall drive the handshake and read from OpenSSL after calling xio_dowork. ]*/
+static void pump_socket_bio(TLS_IO_INSTANCE* tls_io_instance)
+{
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+        break;
+
+    case TLSIO_STATE_IN_HANDSHAKE:
+        send_handshake_bytes(tls_io_instance);
+        break;
+
+    case TLSIO_STATE_OPEN:
+        flush_pending_sends(tls_io_instance);
+
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+            (decode_ssl_received_bytes(tls_io_instance) != 0))
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+            LogError("Error in decode_ssl_received_bytes.");
+        }
+        break;
+    }
+}
+
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    if (is_handshake_step_in_flight(tls_io_instance))
+    {
+        if (defer_received_bytes(tls_io_instance, buffer, size) != 0)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+            LogError("Error in defer_received_bytes.");
+        }
+    }
+    else if (BIO_write(tls_io_instance->in_bio, buffer, (int)size) != (int)size)
+    {
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
+        log_ERR_get_error("Error in BIO_write.");
+    }
+    else
+    {
+        switch (tls_io_instance->tlsio_state)
+        {
+        default:
+            break;
+
+        case TLSIO_STATE_IN_HANDSHAKE:
+            send_handshake_bytes(tls_io_instance);
+            break;
+
+        case TLSIO_STATE_OPEN:
+            if (tls_io_instance->early_data_state != EARLY_DATA_NONE)
+            {
+                // the server has answered the ClientHello, no more early data from here on
+                finish_early_data_handshake(tls_io_instance);
+            }
+
+            if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+                (tls_io_instance->early_data_state == EARLY_DATA_NONE) &&
+                (decode_ssl_received_bytes(tls_io_instance) != 0))
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+                LogError("Error in decode_ssl_received_bytes.");
+            }
+            break;
+        }
+    }
+}
+
+static uint32_t hash_bytes(uint32_t hash, const void* bytes, size_t size)
+{
+    const unsigned char* current = (const unsigned char*)bytes;
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < size; i++)
+    {
+        hash ^= current[i];
+        hash *= 16777619;
+    }
+
+    return hash;
+}
+
+static uint32_t hash_string(uint32_t hash, const char* value)
+{
+    uint32_t result;
+
+    if (value == NULL)
+    {
+        /* a NULL string hashes differently from an empty one */
+        unsigned char null_marker = 0xFF;
+        result = hash_bytes(hash, &null_marker, sizeof(null_marker));
+    }
+    else
+    {
+        result = hash_bytes(hash, value, strlen(value) + 1);
+    }
+
+    return result;
+}
+
+/* Codes_SRS_TLSIO_OPENSSL_11_010: [ When a connection is opened, the trusted certificates, the x509 certificate and key, the ECC certificate and key, the TLS version and the certificate validation callback and its data shall be combined into a key hashed with FNV-1a. ]*/
+static void get_ssl_context_key(TLS_IO_INSTANCE* tls_io_instance, SSL_CONTEXT_KEY* key)
+{
+    uint32_t hash = 2166136261u;
+
+    key->certificate = tls_io_instance->certificate;
+    key->x509certificate = tls_io_instance->x509certificate;
+    key->x509privatekey = tls_io_instance->x509privatekey;
+    key->x509_ecc_cert = tls_io_instance->x509_ecc_cert;
+    key->x509_ecc_aliaskey = tls_io_instance->x509_ecc_aliaskey;
+    key->tls_version = tls_io_instance->tls_version;
+    key->tls_validation_callback = tls_io_instance->tls_validation_callback;
+    key->tls_validation_callback_data = tls_io_instance->tls_validation_callback_data;
+
+    hash = hash_string(hash, key->certificate);
+    hash = hash_string(hash, key->x509certificate);
+    hash = hash_string(hash, key->x509privatekey);
+    hash = hash_string(hash, key->x509_ecc_cert);
+    hash = hash_string(hash, key->x509_ecc_aliaskey);
+    hash = hash_bytes(hash, &key->tls_version, sizeof(key->tls_version));
+    hash = hash_bytes(hash, &key->tls_validation_callback, sizeof(key->tls_validation_callback));
+    hash = hash_bytes(hash, &key->tls_validation_callback_data, sizeof(key->tls_validation_callback_data));
+    key->hash = hash;
+}
+
+static bool are_strings_equal(const char* left, const char* right)
+{
+    return (left == NULL || right == NULL) ? (left == right) : (strcmp(left, right) == 0);
+}
+
+static bool are_ssl_context_keys_equal(const SSL_CONTEXT_KEY* left, const SSL_CONTEXT_KEY* right)
+{
+    /* Codes_SRS_TLSIO_OPENSSL_11_012: [ Keys shall be compared field by field, the hash only saves the string compares. ]*/
+    /* the hash only saves the string compares, trust is never decided on a hash alone */
+    return (left->hash == right->hash) &&
+        (left->tls_version == right->tls_version) &&
+        (left->tls_validation_callback == right->tls_validation_callback) &&
+        (left->tls_validation_callback_data == right->tls_validation_callback_data) &&
+        are_strings_equal(left->certificate, right->certificate) &&
+        are_strings_equal(left->x509certificate, right->x509certificate) &&
+        are_strings_equal(left->x509privatekey, right->x509privatekey) &&
+        are_strings_equal(left->x509_ecc_cert, right->x509_ecc_cert) &&
+        are_strings_equal(left->x509_ecc_aliaskey, right->x509_ecc_aliaskey);
+}
+
+static bool is_ssl_context_key_matching(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const SSL_CONTEXT_CACHE_ENTRY* entry = (const SSL_CONTEXT_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+
+    return are_ssl_context_keys_equal(&entry->key, (const SSL_CONTEXT_KEY*)match_context);
+}
+
+static int copy_optional_string(const char** destination, const char* source)
+{
+    int result;
+
+    if (source == NULL)
+    {
+        *destination = NULL;
+        result = 0;
+    }
+    else if (mallocAndStrcpy_s((char**)destination, source) != 0)
+    {
+        *destination = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void free_ssl_context_key(SSL_CONTEXT_KEY* key)
+{
+    free((void*)key->certificate);
+    free((void*)key->x509certificate);
+    free((void*)key->x509privatekey);
+    free((void*)key->x509_ecc_cert);
+    free((void*)key->x509_ecc_aliaskey);
+}
+
+/* on failure the destination is left with the strings copied so far, to be released with free_ssl_context_key */
+static int copy_ssl_context_key(SSL_CONTEXT_KEY* destination, const SSL_CONTEXT_KEY* source)
+{
+    int result;
+
+    destination->hash = source->hash;
+    destination->tls_version = source->tls_version;
+    destination->tls_validation_callback = source->tls_validation_callback;
+    destination->tls_validation_callback_data = source->tls_validation_callback_data;
+    destination->certificate = NULL;
+    destination->x509certificate = NULL;
+    destination->x509privatekey = NULL;
+    destination->x509_ecc_cert = NULL;
+    destination->x509_ecc_aliaskey = NULL;
+
+    if ((copy_optional_string(&destination->certificate, source->certificate) != 0) ||
+        (copy_optional_string(&destination->x509certificate, source->x509certificate) != 0) ||
+        (copy_optional_string(&destination->x509privatekey, source->x509privatekey) != 0) ||
+        (copy_optional_string(&destination->x509_ecc_cert, source->x509_ecc_cert) != 0) ||
+        (copy_optional_string(&destination->x509_ecc_aliaskey, source->x509_ecc_aliaskey) != 0))
+    {
+        LogError("Failed copying the SSL context key.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void free_ssl_context_cache_entry(SSL_CONTEXT_CACHE_ENTRY* entry)
+{
+    if (entry->ssl_context != NULL)
+    {
+        SSL_CTX_free(entry->ssl_context);
+    }
+    free_ssl_context_key(&entry->key);
+    free(entry);
+}
+
+static void free_tls_session_cache_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+    if (entry->session != NULL)
+    {
+        SSL_SESSION_free(entry->session);
+    }
+    free(entry->hostname);
+    free_ssl_context_key(&entry->key);
+    free(entry);
+}
+
+static bool is_tls_session_matching(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const TLS_SESSION_CACHE_ENTRY* entry = (const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+    const TLS_IO_INSTANCE* tls_io_instance = (const TLS_IO_INSTANCE*)match_context;
+
+    /* a session is only resumed with the configuration (and so the client identity) it was established with */
+    return (entry->port == tls_io_instance->port) &&
+        (strcmp(entry->hostname, tls_io_instance->hostname) == 0) &&
+        are_ssl_context_keys_equal(&entry->key, &tls_io_instance->ssl_context_entry->key);
+}
+
+static bool can_use_tls_session_cache(const TLS_IO_INSTANCE* tls_io_instance)
+{
+    return tls_io_instance->tls_session_resumption &&
+        (tls_io_instance->hostname != NULL) &&
+        (tls_io_instance->ssl_context_entry != NULL) &&
+        (ssl_cache_lock != NULL);
+}
+
+static TLS_SESSION_CACHE_ENTRY* create_tls_session_cache_entry(TLS_IO_INSTANCE* tls_io_instance, SSL_SESSION* session)
+{
+    TLS_SESSION_CACHE_ENTRY* result = malloc(sizeof(TLS_SESSION_CACHE_ENTRY));
+    if (result == NULL)
+    {
+        LogError("Failed allocating TLS session cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(TLS_SESSION_CACHE_ENTRY));
+        result->port = tls_io_instance->port;
+
+        if ((mallocAndStrcpy_s(&result->hostname, tls_io_instance->hostname) != 0) ||
+            (copy_ssl_context_key(&result->key, &tls_io_instance->ssl_context_entry->key) != 0))
+        {
+            LogError("Failed copying the TLS session key.");
+            free_tls_session_cache_entry(result);
+            result = NULL;
+        }
+        else
+        {
+            result->session = session;
+        }
+    }
+
+    return result;
+}
+
+/* called by OpenSSL when the server issues a session; returning 1 takes ownership of the session */
+static int on_new_tls_session(SSL* ssl, SSL_SESSION* session)
+{
+    int result;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)SSL_get_app_data(ssl);
+
+    /* Codes_SRS_TLSIO_OPENSSL_11_023: [ Sessions issued on a connection without OPTION_TLS_SESSION_RESUMPTION or without a hostname shall not be cached, and their ownership shall stay with OpenSSL. ]*/
+    if ((tls_io_instance == NULL) ||
+        !can_use_tls_session_cache(tls_io_instance))
+    {
+        result = 0;
+    }
+    else if (Lock(ssl_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the TLS session cache.");
+        result = 0;
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+        if (list_item != NULL)
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_021: [ A session issued for a hostname, port and key that already have a cached session shall replace it, and the replaced session shall be freed. ]*/
+            TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+            SSL_SESSION_free(entry->session);
+            entry->session = session;
+            result = 1;
+        }
+        else
+        {
+            TLS_SESSION_CACHE_ENTRY* entry = create_tls_session_cache_entry(tls_io_instance, session);
+            if (entry == NULL)
+            {
+                result = 0;
+            }
+            /* Codes_SRS_TLSIO_OPENSSL_11_024: [ If the session cannot be added to the cache, ownership of the session shall stay with OpenSSL. ]*/
+            else if (singlylinkedlist_add(tls_session_cache, entry) == NULL)
+            {
+                LogError("Failed adding the TLS session to the cache.");
+                entry->session = NULL;
+                free_tls_session_cache_entry(entry);
+                result = 0;
+            }
+            else
+            {
+                /* Codes_SRS_TLSIO_OPENSSL_11_020: [ When the server issues a session on a connection with OPTION_TLS_SESSION_RESUMPTION set, the session shall be cached under the hostname, the port and the SSL context key of the connection, and the cache shall take ownership of it. ]*/
+                tls_session_cache_count++;
+                /* Codes_SRS_TLSIO_OPENSSL_11_022: [ The cache shall hold at most 64 sessions. When it is full, the oldest session shall be freed. ]*/
+                if (tls_session_cache_count > TLS_SESSION_CACHE_MAX_ENTRIES)
+                {
+                    /* sessions are appended, so the head is the oldest one */
+                    LIST_ITEM_HANDLE oldest = singlylinkedlist_get_head_item(tls_session_cache);
+                    TLS_SESSION_CACHE_ENTRY* oldest_entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(oldest);
+                    (void)singlylinkedlist_remove(tls_session_cache, oldest);
+                    free_tls_session_cache_entry(oldest_entry);
+                    tls_session_cache_count--;
+                }
+
+                result = 1;
+            }
+        }
+
+        (void)Unlock(ssl_cache_lock);
+    }
+
+    return result;
+}
+
+static void restore_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (can_use_tls_session_cache(tls_io_instance))
+    {
+        if (Lock(ssl_cache_lock) != LOCK_OK)
+        {
+            LogError("Failed locking the TLS session cache, doing a full handshake.");
+        }
+        else
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+            if (list_item != NULL)
+            {
+                const TLS_SESSION_CACHE_ENTRY* entry = (const TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+
+                /* Codes_SRS_TLSIO_OPENSSL_11_025: [ When a connection is opened, a cached session with the same hostname, port and key shall be set on the SSL object with SSL_set_session, before SSL_set_connect_state. ]*/
+                /* SSL_set_session takes its own reference, the cache keeps the session for the next connection */
+                if (SSL_set_session(tls_io_instance->ssl, entry->session) != 1)
+                {
+                    log_ERR_get_error("Failed restoring the TLS session, doing a full handshake.");
+                }
+            }
+
+            (void)Unlock(ssl_cache_lock);
+        }
+    }
+}
+
+static void remove_tls_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (can_use_tls_session_cache(tls_io_instance))
+    {
+        if (Lock(ssl_cache_lock) != LOCK_OK)
+        {
+            LogError("Failed locking the TLS session cache.");
+        }
+        else
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_find(tls_session_cache, is_tls_session_matching, tls_io_instance);
+            if (list_item != NULL)
+            {
+                TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+                (void)singlylinkedlist_remove(tls_session_cache, list_item);
+                free_tls_session_cache_entry(entry);
+                tls_session_cache_count--;
+            }
+
+            (void)Unlock(ssl_cache_lock);
+        }
+    }
+}
+
+static SSL_CTX* create_ssl_context(const SSL_CONTEXT_KEY* key)
+{
+    SSL_CTX* result;
+    const SSL_METHOD* method = NULL;
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
+#ifdef TLS1_3_VERSION
+    if (key->tls_version == VERSION_1_3)
+    {
+        // there is no TLS 1.3 only method, the minimum version is raised on the context below
+        method = TLS_method();
+    }
+    else
+#endif
+    if (key->tls_version == VERSION_1_2)
+    {
+        method = TLSv1_2_method();
+    }
+    else if (key->tls_version == VERSION_1_1)
+    {
+        method = TLSv1_1_method();
+    }
+    else
+    {
+        method = TLSv1_method();
+    }
+#else
+    {
+        method = TLS_method();
+    }
+#endif
+
+    result = SSL_CTX_new(method);
+    if (result == NULL)
+    {
+        log_ERR_get_error("Failed allocating OpenSSL context.");
+    }
+#ifdef TLS1_3_VERSION
+    else if (
+        (key->tls_version == VERSION_1_3) &&
+        (SSL_CTX_set_min_proto_version(result, TLS1_3_VERSION) != 1)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("Failed restricting the OpenSSL context to TLS 1.3.");
+    }
+#endif
+    /* contexts created for the same trusted certificates share one parsed X509_STORE */
+    else if (
+        (key->certificate != NULL) &&
+        (x509_openssl_use_shared_certificates(result, key->certificate) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to add the trusted certificates.");
+    }
+    /*x509 authentication can only be build before underlying connection is realized*/
+    else if (
+        (key->x509certificate != NULL) &&
+        (key->x509privatekey != NULL) &&
+        (x509_openssl_add_credentials(result, key->x509certificate, key->x509privatekey) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to use x509 authentication");
+    }
+    else if (
+        (key->x509_ecc_cert != NULL) &&
+        (key->x509_ecc_aliaskey != NULL) &&
+        (x509_openssl_add_ecc_credentials(result, key->x509_ecc_cert, key->x509_ecc_aliaskey) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        LogError("unable to use x509 authentication");
+    }
+    else
+    {
+        SSL_CTX_set_cert_verify_callback(result, key->tls_validation_callback, key->tls_validation_callback_data);
+        SSL_CTX_set_verify(result, SSL_VERIFY_PEER, NULL);
+
+        /* sessions are handed to on_new_tls_session, which keeps them only for the connections that enabled resumption */
+        (void)SSL_CTX_set_session_cache_mode(result, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(result, on_new_tls_session);
+
+        // Specifies that the default locations for which CA certificates are loaded should be used.
+        // x509_openssl_use_shared_certificates already loaded them, once per shared store.
+        if ((key->certificate == NULL) &&
+            (SSL_CTX_set_default_verify_paths(result) != 1))
+        {
+            // This is only a warning to the user. They can still specify the certificate via SetOption.
+            LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+        }
+    }
+
+    return result;
+}
+
+static SSL_CONTEXT_CACHE_ENTRY* create_ssl_context_cache_entry(const SSL_CONTEXT_KEY* key)
+{
+    SSL_CONTEXT_CACHE_ENTRY* result = malloc(sizeof(SSL_CONTEXT_CACHE_ENTRY));
+    if (result == NULL)
+    {
+        LogError("Failed allocating SSL context cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(SSL_CONTEXT_CACHE_ENTRY));
+
+        if (copy_ssl_context_key(&result->key, key) != 0)
+        {
+            LogError("Failed copying the SSL context key.");
+            free_ssl_context_cache_entry(result);
+            result = NULL;
+        }
+        else if ((result->ssl_context = create_ssl_context(key)) == NULL)
+        {
+            LogError("Failed creating the SSL context.");
+            free_ssl_context_cache_entry(result);
+            result = NULL;
+        }
+        else
+        {
+            result->ref_count = 1;
+        }
+    }
+
+    return result;
+}
+
+/* returns a referenced SSL_CTX entry for the configuration of the instance, creating the SSL_CTX only when the cache holds none for an equal configuration */
+static SSL_CONTEXT_CACHE_ENTRY* acquire_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    SSL_CONTEXT_CACHE_ENTRY* result;
+    SSL_CONTEXT_KEY key;
+
+    get_ssl_context_key(tls_io_instance, &key);
+
+    if (ssl_cache_lock == NULL)
+    {
+        /* Codes_SRS_TLSIO_OPENSSL_11_016: [ If tlsio_openssl_init was not called, every connection shall get its own SSL_CTX that is not cached. ]*/
+        result = create_ssl_context_cache_entry(&key);
+    }
+    /* Codes_SRS_TLSIO_OPENSSL_11_015: [ If locking the cache fails, tlsio_openssl_open shall fail. ]*/
+    else if (Lock(ssl_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the SSL context cache.");
+        result = NULL;
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(ssl_context_cache, is_ssl_context_key_matching, &key);
+        if (list_item != NULL)
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_011: [ If the cache holds an SSL_CTX with an equal key, the connection shall take a reference on it and no new SSL_CTX shall be created. ]*/
+            result = (SSL_CONTEXT_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+            if (result->ref_count == 0)
+            {
+                ssl_context_cache_idle_count--;
+            }
+            result->ref_count++;
+        }
+        else
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_013: [ Otherwise a new SSL_CTX shall be created for the key and added to the cache with one reference. ]*/
+            /* the context is built under the lock so that concurrent opens with the same configuration load the certificates only once */
+            result = create_ssl_context_cache_entry(&key);
+            /* Codes_SRS_TLSIO_OPENSSL_11_014: [ If the new SSL_CTX cannot be added to the cache, it shall be freed and tlsio_openssl_open shall fail. ]*/
+            if ((result != NULL) &&
+                ((result->list_item = singlylinkedlist_add(ssl_context_cache, result)) == NULL))
+            {
+                LogError("Failed adding the SSL context to the cache.");
+                free_ssl_context_cache_entry(result);
+                result = NULL;
+            }
+        }
+
+        (void)Unlock(ssl_cache_lock);
+    }
+
+    return result;
 }
 
-static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
+static bool is_ssl_context_idle(LIST_ITEM_HANDLE list_item, const void* match_context)
 {
-    if (tls_io_instance->ssl != NULL)
+    const SSL_CONTEXT_CACHE_ENTRY* entry = (const SSL_CONTEXT_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+    (void)match_context;
+
+    return (entry->ref_count == 0);
+}
+
+static void release_ssl_context(SSL_CONTEXT_CACHE_ENTRY* entry)
+{
+    if (entry->list_item == NULL)
     {
-        SSL_free(tls_io_instance->ssl);
-        tls_io_instance->ssl = NULL;
+        free_ssl_context_cache_entry(entry);
     }
-    if (tls_io_instance->ssl_context != NULL)
+    /* Codes_SRS_TLSIO_OPENSSL_11_018: [ If locking the cache fails while releasing a reference, the reference shall be kept, so that an SSL_CTX that another connection may still use is never freed. The SSL_CTX shall then be freed by tlsio_openssl_deinit. ]*/
+    else if (Lock(ssl_cache_lock) != LOCK_OK)
     {
-        SSL_CTX_free(tls_io_instance->ssl_context);
-        tls_io_instance->ssl_context = NULL;
+        LogError("Failed locking the SSL context cache, the SSL context is kept until tlsio_openssl_deinit.");
     }
-}
-
-static int add_certificate_to_store(TLS_IO_INSTANCE* tls_io_instance, const char* certValue)
-{
-    int result = 0;
-
-    if (certValue != NULL)
+    else
     {
-        X509_STORE* cert_store = SSL_CTX_get_cert_store(tls_io_instance->ssl_context);
-        if (cert_store == NULL)
+        /* Codes_SRS_TLSIO_OPENSSL_11_017: [ When a connection is closed or destroyed it shall release its reference. When the last reference is released, the SSL_CTX shall be kept in the cache for the next connection with an equal key. ]*/
+        entry->ref_count--;
+        if (entry->ref_count == 0)
         {
-            log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
-            result = __FAILURE__;
-        }
-        else
-        {
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-            const BIO_METHOD* bio_method;
-#else
-            BIO_METHOD* bio_method;
-#endif
-            bio_method = BIO_s_mem();
-            if (bio_method == NULL)
+            /* idle entries go to the tail, so the first idle entry from the head is the one that has been idle the longest */
+            (void)singlylinkedlist_remove(ssl_context_cache, entry->list_item);
+            if ((entry->list_item = singlylinkedlist_add(ssl_context_cache, entry)) == NULL)
             {
-                log_ERR_get_error("failure in BIO_s_mem");
-                result = __FAILURE__;
+                LogError("Failed keeping the idle SSL context in the cache.");
+                free_ssl_context_cache_entry(entry);
             }
             else
             {
-                BIO* cert_memory_bio = BIO_new(bio_method);
-
-                if (cert_memory_bio == NULL)
+                ssl_context_cache_idle_count++;
+                /* Codes_SRS_TLSIO_OPENSSL_11_019: [ The cache shall keep at most 16 SSL contexts that no connection uses. When there are more, the one that has been unused the longest shall be freed. ]*/
+                if (ssl_context_cache_idle_count > SSL_CONTEXT_CACHE_MAX_IDLE_ENTRIES)
                 {
-                    log_ERR_get_error("failure in BIO_new");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    int puts_result = BIO_puts(cert_memory_bio, certValue);
-                    if (puts_result < 0)
-                    {
-                        log_ERR_get_error("failure in BIO_puts");
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        if ((size_t)puts_result != strlen(certValue))
-                        {
-                            log_ERR_get_error("mismatching legths");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            X509* certificate;
-                            while ((certificate = PEM_read_bio_X509(cert_memory_bio, NULL, NULL, NULL)) != NULL)
-                            {
-                                if (!X509_STORE_add_cert(cert_store, certificate))
-                                {
-                                    X509_free(certificate);
-                                    log_ERR_get_error("failure in X509_STORE_add_cert");
-                                    break;
-                                }
-                                X509_free(certificate);
-                            }
-                            if (certificate == NULL)
-                            {
-                                result = 0;/*all is fine*/
-                            }
-                            else
-                            {
-                                /*previous while loop terminated unfortunately*/
-                                result = __FAILURE__;
-                            }
-                        }
-                    }
-                    BIO_free(cert_memory_bio);
+                    LIST_ITEM_HANDLE oldest = singlylinkedlist_find(ssl_context_cache, is_ssl_context_idle, NULL);
+                    SSL_CONTEXT_CACHE_ENTRY* oldest_entry = (SSL_CONTEXT_CACHE_ENTRY*)singlylinkedlist_item_get_value(oldest);
+                    (void)singlylinkedlist_remove(ssl_context_cache, oldest);
+                    free_ssl_context_cache_entry(oldest_entry);
+                    ssl_context_cache_idle_count--;
                 }
             }
         }
+
+        (void)Unlock(ssl_cache_lock);
     }
-    return result;
 }
 
-static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
+static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
 {
-    int result;
-
-    const SSL_METHOD* method = NULL;
+    wait_for_handshake_step(tls_io_instance);
+    free_early_data(tls_io_instance);
 
-#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
-    if (tlsInstance->tls_version == VERSION_1_2)
-    {
-        method = TLSv1_2_method();
-    }
-    else if (tlsInstance->tls_version == VERSION_1_1)
-    {
-        method = TLSv1_1_method();
-    }
-    else
+    if (tls_io_instance->ssl != NULL)
     {
-        method = TLSv1_method();
+        if (tls_io_instance->tls_session_resumption &&
+            SSL_is_init_finished(tls_io_instance->ssl))
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_027: [ When a connection with OPTION_TLS_SESSION_RESUMPTION set is closed after a finished handshake, it shall be marked as shut down before SSL_free, so that its session stays resumable. ]*/
+            // No close_notify is ever sent, and SSL_free would then mark the session as not resumable.
+            // Since TLS 1.1 a connection closed without close_notify does not prevent resuming its session.
+            SSL_set_shutdown(tls_io_instance->ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN);
+        }
+        SSL_free(tls_io_instance->ssl);
+        tls_io_instance->ssl = NULL;
+        tls_io_instance->socket_bio_mode = false;
     }
-#else
+    if (tls_io_instance->ssl_context_entry != NULL)
     {
-        method = TLS_method();
+        release_ssl_context(tls_io_instance->ssl_context_entry);
+        tls_io_instance->ssl_context_entry = NULL;
+        tls_io_instance->ssl_context = NULL;
     }
-#endif
+}
 
-    tlsInstance->ssl_context = SSL_CTX_new(method);
-    if (tlsInstance->ssl_context == NULL)
-    {
-        log_ERR_get_error("Failed allocating OpenSSL context.");
-        result = __FAILURE__;
-    }
-    else if (add_certificate_to_store(tlsInstance, tlsInstance->certificate) != 0)
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to add_certificate_to_store.");
-        result = __FAILURE__;
-    }
-    /*x509 authentication can only be build before underlying connection is realized*/
-    else if (
-        (tlsInstance->x509certificate != NULL) &&
-        (tlsInstance->x509privatekey != NULL) &&
-        (x509_openssl_add_credentials(tlsInstance->ssl_context, tlsInstance->x509certificate, tlsInstance->x509privatekey) != 0)
-        )
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to use x509 authentication");
-        result = __FAILURE__;
-    }
-    else if (
-        (tlsInstance->x509_ecc_cert != NULL) &&
-        (tlsInstance->x509_ecc_aliaskey != NULL) &&
-        (x509_openssl_add_ecc_credentials(tlsInstance->ssl_context, tlsInstance->x509_ecc_cert, tlsInstance->x509_ecc_aliaskey) != 0)
-        )
+static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
+{
+    int result;
+
+    tlsInstance->socket_bio_mode = false;
+    tlsInstance->ssl_context_entry = acquire_ssl_context(tlsInstance);
+    if (tlsInstance->ssl_context_entry == NULL)
     {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        LogError("unable to use x509 authentication");
+        LogError("Failed getting an OpenSSL context.");
         result = __FAILURE__;
     }
     else
     {
-        SSL_CTX_set_cert_verify_callback(tlsInstance->ssl_context, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
+        tlsInstance->ssl_context = tlsInstance->ssl_context_entry->ssl_context;
 
         tlsInstance->in_bio = BIO_new(BIO_s_mem());
         if (tlsInstance->in_bio == NULL)
         {
-            SSL_CTX_free(tlsInstance->ssl_context);
-            tlsInstance->ssl_context = NULL;
             log_ERR_get_error("Failed BIO_new for in BIO.");
             result = __FAILURE__;
         }
@@ -995,8 +2768,6 @@ static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
             if (tlsInstance->out_bio == NULL)
             {
                 (void)BIO_free(tlsInstance->in_bio);
-                SSL_CTX_free(tlsInstance->ssl_context);
-                tlsInstance->ssl_context = NULL;
                 log_ERR_get_error("Failed BIO_new for out BIO.");
                 result = __FAILURE__;
             }
@@ -1007,45 +2778,105 @@ static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
                 {
                     (void)BIO_free(tlsInstance->in_bio);
                     (void)BIO_free(tlsInstance->out_bio);
-                    SSL_CTX_free(tlsInstance->ssl_context);
-                    tlsInstance->ssl_context = NULL;
                     LogError("Failed BIO_set_mem_eof_return.");
                     result = __FAILURE__;
                 }
                 else
                 {
-                    SSL_CTX_set_verify(tlsInstance->ssl_context, SSL_VERIFY_PEER, NULL);
-
-                    // Specifies that the default locations for which CA certificates are loaded should be used.
-                    if (SSL_CTX_set_default_verify_paths(tlsInstance->ssl_context) != 1)
-                    {
-                        // This is only a warning to the user. They can still specify the certificate via SetOption.
-                        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
-                    }
-
                     tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
                     if (tlsInstance->ssl == NULL)
                     {
                         (void)BIO_free(tlsInstance->in_bio);
                         (void)BIO_free(tlsInstance->out_bio);
-                        SSL_CTX_free(tlsInstance->ssl_context);
-                        tlsInstance->ssl_context = NULL;
                         log_ERR_get_error("Failed creating OpenSSL instance.");
                         result = __FAILURE__;
                     }
                     else
                     {
                         SSL_set_bio(tlsInstance->ssl, tlsInstance->in_bio, tlsInstance->out_bio);
+                        (void)SSL_set_app_data(tlsInstance->ssl, tlsInstance);
+                        restore_tls_session(tlsInstance);
                         SSL_set_connect_state(tlsInstance->ssl);
                         result = 0;
                     }
                 }
             }
         }
+
+        if (result != 0)
+        {
+            release_ssl_context(tlsInstance->ssl_context_entry);
+            tlsInstance->ssl_context_entry = NULL;
+            tlsInstance->ssl_context = NULL;
+        }
+    }
+
+    return result;
+}
+
+static size_t get_handshake_pool_max_workers(void)
+{
+    size_t result = TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS;
+#if !defined(WIN32) && defined(_SC_NPROCESSORS_ONLN)
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if ((processor_count > 0) && ((unsigned long)processor_count < result))
+    {
+        result = (size_t)processor_count;
     }
+#endif
     return result;
 }
 
+static void destroy_handshake_pool(void)
+{
+    if ((handshake_pool_lock != NULL) &&
+        (Lock(handshake_pool_lock) == LOCK_OK))
+    {
+        size_t i;
+        size_t worker_count = handshake_worker_count;
+
+        handshake_pool_stopping = true;
+        for (i = 0; i < worker_count; i++)
+        {
+            (void)Condition_Post(handshake_work_available);
+        }
+        (void)Unlock(handshake_pool_lock);
+
+        for (i = 0; i < worker_count; i++)
+        {
+            int thread_result;
+            (void)ThreadAPI_Join(handshake_workers[i], &thread_result);
+        }
+        handshake_worker_count = 0;
+        handshake_pool_stopping = false;
+    }
+
+    /* connections must be destroyed before deinit, so no step is left in the queue */
+    if (handshake_job_queue != NULL)
+    {
+        singlylinkedlist_destroy(handshake_job_queue);
+        handshake_job_queue = NULL;
+    }
+    if (handshake_job_done != NULL)
+    {
+        Condition_Deinit(handshake_job_done);
+        handshake_job_done = NULL;
+    }
+    if (handshake_work_available != NULL)
+    {
+        Condition_Deinit(handshake_work_available);
+        handshake_work_available = NULL;
+    }
+    if (handshake_pool_lock != NULL)
+    {
+        (void)Lock_Deinit(handshake_pool_lock);
+        handshake_pool_lock = NULL;
+    }
+}
+
+/* Codes_SRS_TLSIO_OPENSSL_11_001: [ tlsio_openssl_init shall create the lock that guards the SSL context cache and the TLS session cache, both caches, and the lock, conditions and job queue of the handshake worker pool. ]*/
+/* Codes_SRS_TLSIO_OPENSSL_11_002: [ If any of these cannot be created, tlsio_openssl_init shall release what was created and return a non-zero value. ]*/
 int tlsio_openssl_init(void)
 {
     (void)SSL_library_init();
@@ -1060,12 +2891,125 @@ int tlsio_openssl_init(void)
         return __FAILURE__;
     }
 
+    if ((ssl_cache_lock = Lock_Init()) == NULL)
+    {
+        LogError("Failed to create the SSL context cache lock.");
+        openssl_static_locks_uninstall();
+        return __FAILURE__;
+    }
+
+    if ((ssl_context_cache = singlylinkedlist_create()) == NULL)
+    {
+        LogError("Failed to create the SSL context cache.");
+        (void)Lock_Deinit(ssl_cache_lock);
+        ssl_cache_lock = NULL;
+        openssl_static_locks_uninstall();
+        return __FAILURE__;
+    }
+
+    if ((tls_session_cache = singlylinkedlist_create()) == NULL)
+    {
+        LogError("Failed to create the TLS session cache.");
+        singlylinkedlist_destroy(ssl_context_cache);
+        ssl_context_cache = NULL;
+        (void)Lock_Deinit(ssl_cache_lock);
+        ssl_cache_lock = NULL;
+        openssl_static_locks_uninstall();
+        return __FAILURE__;
+    }
+
+    handshake_pool_max_workers = get_handshake_pool_max_workers();
+
+    if (((handshake_pool_lock = Lock_Init()) == NULL) ||
+        ((handshake_work_available = Condition_Init()) == NULL) ||
+        ((handshake_job_done = Condition_Init()) == NULL) ||
+        ((handshake_job_queue = singlylinkedlist_create()) == NULL))
+    {
+        LogError("Failed to create the handshake worker pool.");
+        destroy_handshake_pool();
+        singlylinkedlist_destroy(tls_session_cache);
+        tls_session_cache = NULL;
+        singlylinkedlist_destroy(ssl_context_cache);
+        ssl_context_cache = NULL;
+        (void)Lock_Deinit(ssl_cache_lock);
+        ssl_cache_lock = NULL;
+        openssl_static_locks_uninstall();
+        return __FAILURE__;
+    }
+
+    if (x509_openssl_cache_init() != 0)
+    {
+        LogError("Failed to create the certificate cache.");
+        destroy_handshake_pool();
+        singlylinkedlist_destroy(tls_session_cache);
+        tls_session_cache = NULL;
+        singlylinkedlist_destroy(ssl_context_cache);
+        ssl_context_cache = NULL;
+        (void)Lock_Deinit(ssl_cache_lock);
+        ssl_cache_lock = NULL;
+        openssl_static_locks_uninstall();
+        return __FAILURE__;
+    }
+
+#ifdef TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+    create_nosignal_socket_bio_method();
+#endif
+
     openssl_dynamic_locks_install();
     return 0;
 }
 
+/* Codes_SRS_TLSIO_OPENSSL_11_003: [ tlsio_openssl_deinit shall stop the handshake workers, join them, and free the cached TLS sessions and the cached SSL contexts. ]*/
 void tlsio_openssl_deinit(void)
 {
+    destroy_handshake_pool();
+    x509_openssl_cache_deinit();
+
+    if (tls_session_cache != NULL)
+    {
+        LIST_ITEM_HANDLE list_item;
+
+        while ((list_item = singlylinkedlist_get_head_item(tls_session_cache)) != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY* entry = (TLS_SESSION_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+            (void)singlylinkedlist_remove(tls_session_cache, list_item);
+            free_tls_session_cache_entry(entry);
+        }
+
+        singlylinkedlist_destroy(tls_session_cache);
+        tls_session_cache = NULL;
+        tls_session_cache_count = 0;
+    }
+    if (ssl_context_cache != NULL)
+    {
+        LIST_ITEM_HANDLE list_item;
+
+        /* connections must be destroyed before deinit, what is left is idle or was kept by a release that could not lock the cache */
+        while ((list_item = singlylinkedlist_get_head_item(ssl_context_cache)) != NULL)
+        {
+            SSL_CONTEXT_CACHE_ENTRY* entry = (SSL_CONTEXT_CACHE_ENTRY*)singlylinkedlist_item_get_value(list_item);
+            (void)singlylinkedlist_remove(ssl_context_cache, list_item);
+            free_ssl_context_cache_entry(entry);
+        }
+
+        singlylinkedlist_destroy(ssl_context_cache);
+        ssl_context_cache = NULL;
+        ssl_context_cache_idle_count = 0;
+    }
+    if (ssl_cache_lock != NULL)
+    {
+        (void)Lock_Deinit(ssl_cache_lock);
+        ssl_cache_lock = NULL;
+    }
+
+#ifdef TLSIO_OPENSSL_NOSIGNAL_SOCKET_BIO
+    if (nosignal_socket_bio_method != NULL)
+    {
+        BIO_meth_free(nosignal_socket_bio_method);
+        nosignal_socket_bio_method = NULL;
+    }
+#endif
+
     openssl_dynamic_locks_uninstall();
     openssl_static_locks_uninstall();
 #if  (OPENSSL_VERSION_NUMBER >= 0x00907000L) &&  (OPENSSL_VERSION_NUMBER < 0x20000000L)
@@ -1147,18 +3091,57 @@ CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
                 result->on_io_error_context = NULL;
                 result->ssl = NULL;
                 result->ssl_context = NULL;
+                result->ssl_context_entry = NULL;
                 result->tls_validation_callback = NULL;
                 result->tls_validation_callback_data = NULL;
                 result->x509certificate = NULL;
                 result->x509privatekey = NULL;
                 result->x509_ecc_cert = NULL;
                 result->x509_ecc_aliaskey = NULL;
+                result->hostname = NULL;
+                result->port = tls_io_config->port;
+                result->tls_session_resumption = false;
+                result->receive_buffer = NULL;
+                result->receive_buffer_size = TLSIO_OPENSSL_RECEIVE_BUFFER_SIZE;
+                result->send_buffer = NULL;
+                result->send_buffer_size = 0;
+                result->socket_fast_path = false;
+                result->kernel_tls = false;
+                result->early_data = false;
+                result->early_data_state = EARLY_DATA_NONE;
+                result->early_data_bytes = NULL;
+                result->early_data_size = 0;
+                result->max_early_data = 0;
+                result->underlying_is_socketio = (underlying_io_interface == socketio_get_interface_description());
+                result->socket_bio_mode = false;
+                result->handshake_worker_threads = 0;
+                result->handshake_job_state = HANDSHAKE_JOB_IDLE;
+                result->handshake_result = 0;
+                result->handshake_ssl_error = SSL_ERROR_NONE;
+                result->handshake_error_code = 0;
+                result->deferred_input = NULL;
+                result->deferred_input_size = 0;
 
                 result->tls_version = VERSION_1_0;
 
-                result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters);
-                if (result->underlying_io == NULL)
+                if ((tls_io_config->hostname != NULL) &&
+                    (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+                {
+                    free(result);
+                    result = NULL;
+                    LogError("Failed copying the hostname.");
+                }
+                else if ((result->pending_sends = singlylinkedlist_create()) == NULL)
+                {
+                    free(result->hostname);
+                    free(result);
+                    result = NULL;
+                    LogError("Failed creating the pending sends list.");
+                }
+                else if ((result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters)) == NULL)
                 {
+                    singlylinkedlist_destroy(result->pending_sends);
+                    free(result->hostname);
                     free(result);
                     result = NULL;
                     LogError("Failed xio_create.");
@@ -1192,6 +3175,11 @@ void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
         free((void*)tls_io_instance->x509privatekey);
         free((void*)tls_io_instance->x509_ecc_cert);
         free((void*)tls_io_instance->x509_ecc_aliaskey);
+        free(tls_io_instance->hostname);
+        free(tls_io_instance->receive_buffer);
+        free(tls_io_instance->send_buffer);
+        cancel_pending_sends(tls_io_instance);
+        singlylinkedlist_destroy(tls_io_instance->pending_sends);
         close_openssl_instance(tls_io_instance);
         if (tls_io_instance->underlying_io != NULL)
         {
@@ -1281,6 +3269,10 @@ int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_cl
             LogInfo("Closing tlsio from a state other than TLSIO_STATE_EXT_OPEN or TLSIO_STATE_EXT_ERROR");
         }
 
+        cancel_pending_sends(tls_io_instance);
+        // the socket must not go away under a handshake step running on a worker
+        wait_for_handshake_step(tls_io_instance);
+
         if (is_an_opening_state(tls_io_instance->tlsio_state))
         {
             /* Codes_SRS_TLSIO_30_057: [ On success, if the adapter is in TLSIO_STATE_EXT_OPENING, it shall call on_io_open_complete with the on_io_open_complete_context supplied in tlsio_open_async and IO_OPEN_CANCELLED. This callback shall be made before changing the internal state of the adapter. ]*/
@@ -1344,6 +3336,34 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
                 return result;
             }
 
+            if (tls_io_instance->early_data_state != EARLY_DATA_NONE)
+            {
+                if (send_early_data(tls_io_instance, (const unsigned char*)buffer, size, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Error in send_early_data.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+                return result;
+            }
+
+            if (tls_io_instance->socket_bio_mode)
+            {
+                if (send_over_socket_bio(tls_io_instance, (const unsigned char*)buffer, size, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Error in send_over_socket_bio.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+                return result;
+            }
+
             res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
             if (res != (int)size)
             {
@@ -1378,13 +3398,26 @@ void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
     {
         TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
 
+        collect_handshake_step(tls_io_instance);
+
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+            (tls_io_instance->early_data_state == EARLY_DATA_WRITING) &&
+            (tls_io_instance->early_data_size == 0))
+        {
+            /* Codes_SRS_TLSIO_OPENSSL_11_044: [ If nothing was sent as early data, tlsio_openssl_dowork shall finish the handshake as an ordinary resumption. ]*/
+            finish_early_data_handshake(tls_io_instance);
+        }
+
         switch (tls_io_instance->tlsio_state)
         {
         case TLSIO_STATE_OPENING_UNDERLYING_IO:
         case TLSIO_STATE_IN_HANDSHAKE:
         case TLSIO_STATE_OPEN:
             /* this is needed in order to pump out bytes produces by OpenSSL for things like renegotiation */
-            write_outgoing_bytes(tls_io_instance, NULL, NULL);
+            if (!is_handshake_step_in_flight(tls_io_instance))
+            {
+                write_outgoing_bytes(tls_io_instance, NULL, NULL);
+            }
             break;
         case TLSIO_STATE_NOT_OPEN:
         case TLSIO_STATE_HANDSHAKE_FAILED:
@@ -1399,6 +3432,11 @@ void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
             /* Same behavior as schannel */
             xio_dowork(tls_io_instance->underlying_io);
 
+            if (tls_io_instance->socket_bio_mode)
+            {
+                pump_socket_bio(tls_io_instance);
+            }
+
             if (tls_io_instance->tlsio_state == TLSIO_STATE_HANDSHAKE_FAILED)
             {
                 // The handshake failed so we need to close. The tlsio becomes aware of the
@@ -1454,11 +3492,8 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 result = 0;
             }
 
-            // If we're previously connected then add the cert to the context
-            if (tls_io_instance->ssl_context != NULL)
-            {
-                result = add_certificate_to_store(tls_io_instance, cert);
-            }
+            // The SSL context of an open connection may be shared with other connections,
+            // so the certificate is only used from the next open on.
         }
         else if (strcmp(SU_OPTION_X509_CERT, optionName) == 0)
         {
@@ -1561,22 +3596,12 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             tls_io_instance->tls_validation_callback = (TLS_CERTIFICATE_VALIDATION_CALLBACK)value;
 #pragma warning(pop)
 
-            if (tls_io_instance->ssl_context != NULL)
-            {
-                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
-            }
-
             result = 0;
         }
         else if (strcmp("tls_validation_callback_data", optionName) == 0)
         {
             tls_io_instance->tls_validation_callback_data = (void*)value;
 
-            if (tls_io_instance->ssl_context != NULL)
-            {
-                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
-            }
-
             result = 0;
         }
         else if (strcmp(OPTION_TLS_VERSION, optionName) == 0)
@@ -1601,6 +3626,12 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 {
                     tls_io_instance->tls_version = VERSION_1_2;
                 }
+#ifdef TLS1_3_VERSION
+                else if (version_option == 13)
+                {
+                    tls_io_instance->tls_version = VERSION_1_3;
+                }
+#endif
                 else
                 {
                     LogInfo("Value of TLS version option %d is not found shall default to version 1.2", version_option);
@@ -1609,6 +3640,73 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
                 result = 0;
             }
         }
+        else if (strcmp(OPTION_TLS_SESSION_RESUMPTION, optionName) == 0)
+        {
+            tls_io_instance->tls_session_resumption = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_SOCKET_FAST_PATH, optionName) == 0)
+        {
+            tls_io_instance->socket_fast_path = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_KERNEL_TLS, optionName) == 0)
+        {
+            tls_io_instance->kernel_tls = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_EARLY_DATA, optionName) == 0)
+        {
+#ifndef TLSIO_OPENSSL_EARLY_DATA
+            if (*(const bool*)value)
+            {
+                LogInfo("This OpenSSL build has no TLS 1.3 early data support, the first bytes wait for the handshake.");
+            }
+#endif
+            tls_io_instance->early_data = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(OPTION_TLS_RECEIVE_BUFFER_SIZE, optionName) == 0)
+        {
+            size_t receive_buffer_size = *(const size_t*)value;
+
+            if ((receive_buffer_size == 0) || (receive_buffer_size > INT_MAX))
+            {
+                LogError("Invalid tls_receive_buffer_size %lu.", (unsigned long)receive_buffer_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* the buffer is (re)allocated with the new size on the next decode */
+                if (receive_buffer_size != tls_io_instance->receive_buffer_size)
+                {
+                    free(tls_io_instance->receive_buffer);
+                    tls_io_instance->receive_buffer = NULL;
+                    tls_io_instance->receive_buffer_size = receive_buffer_size;
+                }
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_TLS_HANDSHAKE_WORKER_THREADS, optionName) == 0)
+        {
+            size_t handshake_worker_threads = *(const size_t*)value;
+
+            if (handshake_worker_threads > TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS)
+            {
+                LogError("Invalid tls_handshake_worker_threads %lu, at most %d workers are supported.", (unsigned long)handshake_worker_threads, TLSIO_OPENSSL_MAX_HANDSHAKE_WORKERS);
+                result = __FAILURE__;
+            }
+            else if (is_handshake_step_in_flight(tls_io_instance))
+            {
+                LogError("tls_handshake_worker_threads cannot be changed while a handshake step runs on a worker.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->handshake_worker_threads = handshake_worker_threads;
+                result = 0;
+            }
+        }
         else if (strcmp(optionName, OPTION_UNDERLYING_IO_OPTIONS) == 0)
         {
             if (OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)value, (void*)tls_io_instance->underlying_io) != OPTIONHANDLER_OK)
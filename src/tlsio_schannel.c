@@ -206,7 +206,8 @@ static const IO_INTERFACE_DESCRIPTION tlsio_schannel_interface_description =
     tlsio_schannel_close,
     tlsio_schannel_send,
     tlsio_schannel_dowork,
-    tlsio_schannel_setoption
+    tlsio_schannel_setoption,
+    tlsio_schannel_wait
 };
 
 static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
@@ -1282,6 +1283,40 @@ void tlsio_schannel_dowork(CONCRETE_IO_HANDLE tls_io)
     }
 }
 
+/* received records are decrypted as soon as they are complete, so there is never buffered plaintext and waiting is left to the socket */
+int tlsio_schannel_wait(CONCRETE_IO_HANDLE tls_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_NOT_OPEN) ||
+            (tls_io_instance->tlsio_state == TLSIO_STATE_ERROR))
+        {
+            LogError("Wait called while not open.");
+            result = __FAILURE__;
+        }
+        else if (xio_wait(tls_io_instance->socket_io, timeout_ms, interest) != 0)
+        {
+            LogError("Failed waiting on the underlying I/O.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 int tlsio_schannel_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, const void* value)
 {
     int result;
@@ -25,6 +25,11 @@ typedef enum TLSIO_STATE_ENUM_TAG
     TLSIO_STATE_ERROR
 } TLSIO_STATE_ENUM;
 
+/* Plaintext is read in chunks of up to one TLS record and handed to the upper layer in a single callback per batch */
+#ifndef TLSIO_WOLFSSL_RECEIVE_BUFFER_SIZE
+#define TLSIO_WOLFSSL_RECEIVE_BUFFER_SIZE 16384
+#endif
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE socket_io;
@@ -46,6 +51,7 @@ typedef struct TLS_IO_INSTANCE_TAG
     char* certificate;
     char* x509certificate;
     char* x509privatekey;
+    unsigned char receive_buffer[TLSIO_WOLFSSL_RECEIVE_BUFFER_SIZE];
 } TLS_IO_INSTANCE;
 
 /*this function will clone an option given by name and value*/
@@ -194,7 +200,8 @@ static const IO_INTERFACE_DESCRIPTION tlsio_wolfssl_interface_description =
     tlsio_wolfssl_close,
     tlsio_wolfssl_send,
     tlsio_wolfssl_dowork,
-    tlsio_wolfssl_setoption
+    tlsio_wolfssl_setoption,
+    tlsio_wolfssl_wait
 };
 
 static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
@@ -216,18 +223,28 @@ static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RES
 static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result = 0;
-    unsigned char buffer[64];
-
     int rcv_bytes = 1;
+
     while (rcv_bytes > 0)
     {
-        rcv_bytes = wolfSSL_read(tls_io_instance->ssl, buffer, sizeof(buffer));
-        if (rcv_bytes > 0)
+        size_t batch_size = 0;
+
+        /* gather as many decrypted records as fit in the buffer so that the upper layer sees one callback per batch */
+        while (batch_size < sizeof(tls_io_instance->receive_buffer))
         {
-            if (tls_io_instance->on_bytes_received != NULL)
+            rcv_bytes = wolfSSL_read(tls_io_instance->ssl, tls_io_instance->receive_buffer + batch_size, (int)(sizeof(tls_io_instance->receive_buffer) - batch_size));
+            if (rcv_bytes <= 0)
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                break;
             }
+
+            batch_size += rcv_bytes;
+        }
+
+        if ((batch_size > 0) &&
+            (tls_io_instance->on_bytes_received != NULL))
+        {
+            tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->receive_buffer, batch_size);
         }
     }
 
@@ -820,6 +837,45 @@ void tlsio_wolfssl_dowork(CONCRETE_IO_HANDLE tls_io)
     }
 }
 
+int tlsio_wolfssl_wait(CONCRETE_IO_HANDLE tls_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state == TLSIO_STATE_NOT_OPEN) ||
+            (tls_io_instance->tlsio_state == TLSIO_STATE_ERROR))
+        {
+            LogError("Wait called while not open.");
+            result = __FAILURE__;
+        }
+        else if ((tls_io_instance->socket_io_read_byte_count > 0) ||
+            ((tls_io_instance->ssl != NULL) && (wolfSSL_pending(tls_io_instance->ssl) > 0)))
+        {
+            /* received bytes are only decoded by dowork, which has work to do regardless of the state of the socket */
+            result = 0;
+        }
+        else if (xio_wait(tls_io_instance->socket_io, timeout_ms, interest) != 0)
+        {
+            LogError("Failed waiting on the underlying I/O.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 const IO_INTERFACE_DESCRIPTION* tlsio_wolfssl_get_interface_description(void)
 {
     return &tlsio_wolfssl_interface_description;
@@ -0,0 +1,766 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tracingio.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+typedef struct TRACINGIO_STATS_INSTANCE_TAG
+{
+    LOCK_HANDLE lock;
+    TRACINGIO_GET_TIME_US get_time_us;
+    TICK_COUNTER_HANDLE tick_counter;
+    TRACINGIO_STATS_SNAPSHOT data;
+} TRACINGIO_STATS_INSTANCE;
+
+typedef struct TRACINGIO_INSTANCE_TAG
+{
+    XIO_HANDLE underlying_io;
+    TRACINGIO_STATS_INSTANCE* stats;
+    SINGLYLINKEDLIST_HANDLE pending_sends;
+    struct TRACED_SEND_TAG* send_in_progress;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    void* on_io_close_complete_context;
+} TRACINGIO_INSTANCE;
+
+typedef struct TRACED_SEND_TAG
+{
+    TRACINGIO_INSTANCE* tracingio_instance;
+    LIST_ITEM_HANDLE list_item;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+    uint64_t start_us;
+} TRACED_SEND;
+
+static size_t get_bucket_index(uint64_t value)
+{
+    size_t result;
+
+    if (value < TRACINGIO_HISTOGRAM_LINEAR_BUCKETS)
+    {
+        result = (size_t)value;
+    }
+    else
+    {
+        size_t exponent = 4;
+
+        while ((exponent < TRACINGIO_HISTOGRAM_MAX_EXPONENT) && ((value >> (exponent + 1)) != 0))
+        {
+            exponent++;
+        }
+
+        if (exponent == TRACINGIO_HISTOGRAM_MAX_EXPONENT)
+        {
+            result = TRACINGIO_HISTOGRAM_BUCKET_COUNT - 1;
+        }
+        else
+        {
+            result = TRACINGIO_HISTOGRAM_LINEAR_BUCKETS + ((exponent - 4) * TRACINGIO_HISTOGRAM_SUB_BUCKETS) +
+                (size_t)((value >> (exponent - 3)) & (TRACINGIO_HISTOGRAM_SUB_BUCKETS - 1));
+        }
+    }
+
+    return result;
+}
+
+static uint64_t get_bucket_upper_bound(size_t index)
+{
+    uint64_t result;
+
+    if (index < TRACINGIO_HISTOGRAM_LINEAR_BUCKETS)
+    {
+        result = index;
+    }
+    else
+    {
+        size_t exponent = 4 + ((index - TRACINGIO_HISTOGRAM_LINEAR_BUCKETS) / TRACINGIO_HISTOGRAM_SUB_BUCKETS);
+        uint64_t sub_bucket = (index - TRACINGIO_HISTOGRAM_LINEAR_BUCKETS) % TRACINGIO_HISTOGRAM_SUB_BUCKETS;
+        result = ((TRACINGIO_HISTOGRAM_SUB_BUCKETS + sub_bucket + 1) << (exponent - 3)) - 1;
+    }
+
+    return result;
+}
+
+static void add_to_histogram(TRACINGIO_HISTOGRAM* histogram, uint64_t value)
+{
+    if ((histogram->count == 0) || (value < histogram->min))
+    {
+        histogram->min = value;
+    }
+
+    if (value > histogram->max)
+    {
+        histogram->max = value;
+    }
+
+    histogram->count++;
+    histogram->sum += value;
+    histogram->buckets[get_bucket_index(value)]++;
+}
+
+static void record_sample(TRACINGIO_STATS_INSTANCE* stats, TRACINGIO_HISTOGRAM* histogram, uint64_t value, uint64_t* total, uint64_t total_increment)
+{
+    if (Lock(stats->lock) != LOCK_OK)
+    {
+        LogError("Failed locking the tracing stats, sample dropped.");
+    }
+    else
+    {
+        add_to_histogram(histogram, value);
+        if (total != NULL)
+        {
+            *total += total_increment;
+        }
+
+        (void)Unlock(stats->lock);
+    }
+}
+
+static uint64_t get_time_us(TRACINGIO_STATS_INSTANCE* stats)
+{
+    uint64_t result;
+
+    if (stats->get_time_us != NULL)
+    {
+        result = stats->get_time_us();
+    }
+    else
+    {
+        tickcounter_ms_t now_ms;
+
+        if (tickcounter_get_current_ms(stats->tick_counter, &now_ms) != 0)
+        {
+            LogError("Failed getting the current time.");
+            result = 0;
+        }
+        else
+        {
+            result = (uint64_t)now_ms * 1000;
+        }
+    }
+
+    return result;
+}
+
+static uint64_t get_elapsed_us(TRACINGIO_STATS_INSTANCE* stats, uint64_t start_us)
+{
+    uint64_t now_us = get_time_us(stats);
+    return (now_us > start_us) ? (now_us - start_us) : 0;
+}
+
+TRACINGIO_STATS_HANDLE tracingio_stats_create(TRACINGIO_GET_TIME_US get_time_us)
+{
+    /* Codes_SRS_TRACINGIO_11_001: [ `tracingio_stats_create` shall allocate a new stats instance with all counters and histograms set to 0. ]*/
+    TRACINGIO_STATS_INSTANCE* result = (TRACINGIO_STATS_INSTANCE*)malloc(sizeof(TRACINGIO_STATS_INSTANCE));
+    if (result == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_002: [ If any error occurs, `tracingio_stats_create` shall fail and return NULL. ]*/
+        LogError("Failed allocating tracing stats.");
+    }
+    else
+    {
+        (void)memset(&result->data, 0, sizeof(result->data));
+        result->get_time_us = get_time_us;
+        result->tick_counter = NULL;
+
+        /* Codes_SRS_TRACINGIO_11_003: [ `tracingio_stats_create` shall create a lock by calling `Lock_Init`, so that snapshots can be taken from any thread. ]*/
+        result->lock = Lock_Init();
+        if (result->lock == NULL)
+        {
+            /* Codes_SRS_TRACINGIO_11_002: [ If any error occurs, `tracingio_stats_create` shall fail and return NULL. ]*/
+            LogError("Failed creating the tracing stats lock.");
+            free(result);
+            result = NULL;
+        }
+        /* Codes_SRS_TRACINGIO_11_004: [ If `get_time_us` is NULL, `tracingio_stats_create` shall create a tick counter and time all samples with millisecond resolution. ]*/
+        else if ((get_time_us == NULL) &&
+            ((result->tick_counter = tickcounter_create()) == NULL))
+        {
+            /* Codes_SRS_TRACINGIO_11_002: [ If any error occurs, `tracingio_stats_create` shall fail and return NULL. ]*/
+            LogError("Failed creating the tracing stats tick counter.");
+            (void)Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void tracingio_stats_destroy(TRACINGIO_STATS_HANDLE stats)
+{
+    if (stats == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_006: [ If `stats` is NULL, `tracingio_stats_destroy` shall do nothing. ]*/
+        LogError("NULL stats.");
+    }
+    else
+    {
+        /* Codes_SRS_TRACINGIO_11_005: [ `tracingio_stats_destroy` shall free the lock, the tick counter (if any) and the stats instance. ]*/
+        if (stats->tick_counter != NULL)
+        {
+            tickcounter_destroy(stats->tick_counter);
+        }
+
+        (void)Lock_Deinit(stats->lock);
+        free(stats);
+    }
+}
+
+int tracingio_stats_get_snapshot(TRACINGIO_STATS_HANDLE stats, TRACINGIO_STATS_SNAPSHOT* snapshot)
+{
+    int result;
+
+    if ((stats == NULL) || (snapshot == NULL))
+    {
+        /* Codes_SRS_TRACINGIO_11_011: [ If `stats` or `snapshot` is NULL, `tracingio_stats_get_snapshot` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: stats = %p, snapshot = %p", stats, snapshot);
+        result = __FAILURE__;
+    }
+    else if (Lock(stats->lock) != LOCK_OK)
+    {
+        /* Codes_SRS_TRACINGIO_11_012: [ If `Lock` fails, `tracingio_stats_get_snapshot` shall fail and return a non-zero value. ]*/
+        LogError("Failed locking the tracing stats.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_TRACINGIO_11_010: [ `tracingio_stats_get_snapshot` shall copy all counters and histograms into `snapshot` while holding the stats lock and return 0. ]*/
+        *snapshot = stats->data;
+        (void)Unlock(stats->lock);
+        result = 0;
+    }
+
+    return result;
+}
+
+int tracingio_stats_reset(TRACINGIO_STATS_HANDLE stats)
+{
+    int result;
+
+    if (stats == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_016: [ If `stats` is NULL, `tracingio_stats_reset` shall fail and return a non-zero value. ]*/
+        LogError("NULL stats.");
+        result = __FAILURE__;
+    }
+    else if (Lock(stats->lock) != LOCK_OK)
+    {
+        /* Codes_SRS_TRACINGIO_11_017: [ If `Lock` fails, `tracingio_stats_reset` shall fail and return a non-zero value. ]*/
+        LogError("Failed locking the tracing stats.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_TRACINGIO_11_015: [ `tracingio_stats_reset` shall set all counters and histograms to 0 while holding the stats lock and return 0. ]*/
+        (void)memset(&stats->data, 0, sizeof(stats->data));
+        (void)Unlock(stats->lock);
+        result = 0;
+    }
+
+    return result;
+}
+
+uint64_t tracingio_histogram_get_percentile(const TRACINGIO_HISTOGRAM* histogram, double percentile)
+{
+    uint64_t result;
+
+    if ((histogram == NULL) || (histogram->count == 0))
+    {
+        /* Codes_SRS_TRACINGIO_11_021: [ If `histogram` is NULL or empty, `tracingio_histogram_get_percentile` shall return 0. ]*/
+        result = 0;
+    }
+    else
+    {
+        uint64_t rank;
+        uint64_t cumulative = 0;
+        size_t i;
+
+        /* Codes_SRS_TRACINGIO_11_022: [ `percentile` shall be clamped to the range [0, 100]. ]*/
+        if (percentile < 0.0)
+        {
+            percentile = 0.0;
+        }
+        else if (percentile > 100.0)
+        {
+            percentile = 100.0;
+        }
+
+        rank = (uint64_t)((percentile / 100.0) * (double)histogram->count);
+        if (rank == 0)
+        {
+            rank = 1;
+        }
+        else if (rank > histogram->count)
+        {
+            rank = histogram->count;
+        }
+
+        /* Codes_SRS_TRACINGIO_11_020: [ `tracingio_histogram_get_percentile` shall return the upper bound of the bucket that contains the sample of rank `percentile`, capped to the largest recorded value. ]*/
+        result = histogram->max;
+        for (i = 0; i < TRACINGIO_HISTOGRAM_BUCKET_COUNT; i++)
+        {
+            cumulative += histogram->buckets[i];
+            if (cumulative >= rank)
+            {
+                uint64_t upper_bound = get_bucket_upper_bound(i);
+                if (upper_bound < result)
+                {
+                    result = upper_bound;
+                }
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)context;
+
+    /* Codes_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+    if (tracingio_instance->on_io_open_complete != NULL)
+    {
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+        tracingio_instance->on_io_open_complete(tracingio_instance->on_io_open_complete_context, open_result);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.callback_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+}
+
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)context;
+
+    /* Codes_SRS_TRACINGIO_11_041: [ For every indication of received bytes, `size` shall be added to `bytes_received` and recorded in the `receive_size` histogram. ]*/
+    record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.receive_size, size, &tracingio_instance->stats->data.bytes_received, size);
+
+    /* Codes_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+    if (tracingio_instance->on_bytes_received != NULL)
+    {
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+        tracingio_instance->on_bytes_received(tracingio_instance->on_bytes_received_context, buffer, size);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.callback_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)context;
+
+    /* Codes_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+    if (tracingio_instance->on_io_error != NULL)
+    {
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+        tracingio_instance->on_io_error(tracingio_instance->on_io_error_context);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.callback_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)context;
+
+    /* Codes_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+    if (tracingio_instance->on_io_close_complete != NULL)
+    {
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+        tracingio_instance->on_io_close_complete(tracingio_instance->on_io_close_complete_context);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.callback_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+}
+
+static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    TRACED_SEND* traced_send = (TRACED_SEND*)context;
+    TRACINGIO_INSTANCE* tracingio_instance = traced_send->tracingio_instance;
+
+    (void)singlylinkedlist_remove(tracingio_instance->pending_sends, traced_send->list_item);
+
+    /* Codes_SRS_TRACINGIO_11_042: [ When the underlying IO completes a send, the time elapsed since the send was issued shall be recorded in `send_complete_latency_us`. ]*/
+    record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.send_complete_latency_us, get_elapsed_us(tracingio_instance->stats, traced_send->start_us),
+        /* Codes_SRS_TRACINGIO_11_043: [ If the send result is not `IO_SEND_OK`, `send_errors` shall be incremented. ]*/
+        &tracingio_instance->stats->data.send_errors, (send_result == IO_SEND_OK) ? 0 : 1);
+
+    /* Codes_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+    if (traced_send->on_send_complete != NULL)
+    {
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+        traced_send->on_send_complete(traced_send->on_send_complete_context, send_result);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.callback_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+
+    if (tracingio_instance->send_in_progress == traced_send)
+    {
+        /* Codes_SRS_TRACINGIO_11_044: [ If the send completes from within the `xio_send` call that issued it, the traced send shall be freed by `tracingio_send` once `xio_send` returns. ]*/
+        tracingio_instance->send_in_progress = NULL;
+    }
+    else
+    {
+        free(traced_send);
+    }
+}
+
+static CONCRETE_IO_HANDLE tracingio_create(void* io_create_parameters)
+{
+    TRACINGIO_INSTANCE* result;
+    TRACINGIO_CONFIG* tracingio_config = (TRACINGIO_CONFIG*)io_create_parameters;
+
+    if (tracingio_config == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_031: [ If `io_create_parameters` is NULL, `tracingio_create` shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else if ((tracingio_config->underlying_io_interface == NULL) ||
+        (tracingio_config->stats == NULL))
+    {
+        /* Codes_SRS_TRACINGIO_11_032: [ If the `underlying_io_interface` or `stats` member is NULL, `tracingio_create` shall fail and return NULL. ]*/
+        LogError("Bad arguments: underlying_io_interface = %p, stats = %p", tracingio_config->underlying_io_interface, tracingio_config->stats);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_TRACINGIO_11_030: [ `tracingio_create` shall create a new tracing IO that records its samples into the `stats` member of the `TRACINGIO_CONFIG*` passed as `io_create_parameters`. ]*/
+        result = (TRACINGIO_INSTANCE*)malloc(sizeof(TRACINGIO_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_TRACINGIO_11_033: [ If any error occurs, `tracingio_create` shall fail and return NULL. ]*/
+            LogError("Failed allocating tracing IO instance.");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(TRACINGIO_INSTANCE));
+            result->stats = tracingio_config->stats;
+
+            /* Codes_SRS_TRACINGIO_11_034: [ `tracingio_create` shall create the list of traced sends by calling `singlylinkedlist_create`. ]*/
+            result->pending_sends = singlylinkedlist_create();
+            if (result->pending_sends == NULL)
+            {
+                /* Codes_SRS_TRACINGIO_11_033: [ If any error occurs, `tracingio_create` shall fail and return NULL. ]*/
+                LogError("Failed creating the traced sends list.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_TRACINGIO_11_035: [ `tracingio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+                result->underlying_io = xio_create(tracingio_config->underlying_io_interface, tracingio_config->underlying_io_parameters);
+                if (result->underlying_io == NULL)
+                {
+                    /* Codes_SRS_TRACINGIO_11_033: [ If any error occurs, `tracingio_create` shall fail and return NULL. ]*/
+                    LogError("Failed creating the underlying IO.");
+                    singlylinkedlist_destroy(result->pending_sends);
+                    free(result);
+                    result = NULL;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void tracingio_destroy(CONCRETE_IO_HANDLE tracingio)
+{
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_037: [ If `tracingio` is NULL, `tracingio_destroy` shall do nothing. ]*/
+        LogError("NULL tracingio.");
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+        LIST_ITEM_HANDLE list_item;
+
+        /* Codes_SRS_TRACINGIO_11_036: [ `tracingio_destroy` shall destroy the underlying IO, free the sends that were never completed by it and free the tracing IO instance. ]*/
+        xio_destroy(tracingio_instance->underlying_io);
+
+        while ((list_item = singlylinkedlist_get_head_item(tracingio_instance->pending_sends)) != NULL)
+        {
+            TRACED_SEND* traced_send = (TRACED_SEND*)singlylinkedlist_item_get_value(list_item);
+            (void)singlylinkedlist_remove(tracingio_instance->pending_sends, list_item);
+            free(traced_send);
+        }
+
+        singlylinkedlist_destroy(tracingio_instance->pending_sends);
+        free(tracingio_instance);
+    }
+}
+
+static int tracingio_open(CONCRETE_IO_HANDLE tracingio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_051: [ If `tracingio` is NULL, `tracingio_open` shall fail and return a non-zero value. ]*/
+        LogError("NULL tracingio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+
+        tracingio_instance->on_io_open_complete = on_io_open_complete;
+        tracingio_instance->on_io_open_complete_context = on_io_open_complete_context;
+        tracingio_instance->on_bytes_received = on_bytes_received;
+        tracingio_instance->on_bytes_received_context = on_bytes_received_context;
+        tracingio_instance->on_io_error = on_io_error;
+        tracingio_instance->on_io_error_context = on_io_error_context;
+
+        /* Codes_SRS_TRACINGIO_11_050: [ `tracingio_open` shall open the underlying IO by calling `xio_open`, passing its own callbacks so that they can be traced. ]*/
+        if (xio_open(tracingio_instance->underlying_io, on_underlying_io_open_complete, tracingio_instance, on_underlying_io_bytes_received, tracingio_instance, on_underlying_io_error, tracingio_instance) != 0)
+        {
+            /* Codes_SRS_TRACINGIO_11_052: [ If `xio_open` fails, `tracingio_open` shall fail and return a non-zero value. ]*/
+            LogError("Failed opening the underlying IO.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int tracingio_close(CONCRETE_IO_HANDLE tracingio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_056: [ If `tracingio` is NULL, `tracingio_close` shall fail and return a non-zero value. ]*/
+        LogError("NULL tracingio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+
+        tracingio_instance->on_io_close_complete = on_io_close_complete;
+        tracingio_instance->on_io_close_complete_context = on_io_close_complete_context;
+
+        /* Codes_SRS_TRACINGIO_11_055: [ `tracingio_close` shall close the underlying IO by calling `xio_close`. ]*/
+        if (xio_close(tracingio_instance->underlying_io, on_underlying_io_close_complete, tracingio_instance) != 0)
+        {
+            /* Codes_SRS_TRACINGIO_11_057: [ If `xio_close` fails, `tracingio_close` shall fail and return a non-zero value. ]*/
+            LogError("Failed closing the underlying IO.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int tracingio_send(CONCRETE_IO_HANDLE tracingio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_061: [ If `tracingio` is NULL, `tracingio_send` shall fail and return a non-zero value. ]*/
+        LogError("NULL tracingio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+        TRACED_SEND* traced_send = (TRACED_SEND*)malloc(sizeof(TRACED_SEND));
+
+        if (traced_send == NULL)
+        {
+            /* Codes_SRS_TRACINGIO_11_062: [ If tracking the send fails, `tracingio_send` shall fail and return a non-zero value. ]*/
+            LogError("Failed allocating traced send.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            traced_send->tracingio_instance = tracingio_instance;
+            traced_send->on_send_complete = on_send_complete;
+            traced_send->on_send_complete_context = on_send_complete_context;
+            traced_send->list_item = singlylinkedlist_add(tracingio_instance->pending_sends, traced_send);
+            if (traced_send->list_item == NULL)
+            {
+                /* Codes_SRS_TRACINGIO_11_062: [ If tracking the send fails, `tracingio_send` shall fail and return a non-zero value. ]*/
+                LogError("Failed tracking the send.");
+                free(traced_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                TRACED_SEND* previous_send_in_progress = tracingio_instance->send_in_progress;
+                bool is_completed;
+                int send_result;
+
+                traced_send->start_us = get_time_us(tracingio_instance->stats);
+                tracingio_instance->send_in_progress = traced_send;
+
+                /* Codes_SRS_TRACINGIO_11_060: [ `tracingio_send` shall send the bytes by calling `xio_send` on the underlying IO, passing its own send complete callback so that the completion latency can be traced. ]*/
+                send_result = xio_send(tracingio_instance->underlying_io, buffer, size, on_underlying_io_send_complete, traced_send);
+                is_completed = (tracingio_instance->send_in_progress != traced_send);
+                tracingio_instance->send_in_progress = previous_send_in_progress;
+
+                if (is_completed)
+                {
+                    /* Codes_SRS_TRACINGIO_11_044: [ If the send completes from within the `xio_send` call that issued it, the traced send shall be freed by `tracingio_send` once `xio_send` returns. ]*/
+                    free(traced_send);
+                }
+
+                if (send_result != 0)
+                {
+                    /* Codes_SRS_TRACINGIO_11_063: [ If `xio_send` fails, `tracingio_send` shall fail and return a non-zero value. ]*/
+                    LogError("Failed sending on the underlying IO.");
+                    if (!is_completed)
+                    {
+                        (void)singlylinkedlist_remove(tracingio_instance->pending_sends, traced_send->list_item);
+                        free(traced_send);
+                    }
+
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_TRACINGIO_11_064: [ On success, `size` shall be added to `bytes_sent` and recorded in the `send_size` histogram. ]*/
+                    record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.send_size, size, &tracingio_instance->stats->data.bytes_sent, size);
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void tracingio_dowork(CONCRETE_IO_HANDLE tracingio)
+{
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_066: [ If `tracingio` is NULL, `tracingio_dowork` shall do nothing. ]*/
+        LogError("NULL tracingio.");
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+        uint64_t start_us = get_time_us(tracingio_instance->stats);
+
+        /* Codes_SRS_TRACINGIO_11_065: [ `tracingio_dowork` shall call `xio_dowork` on the underlying IO and record the time it took (including the callbacks triggered by it) in `dowork_duration_us`. ]*/
+        xio_dowork(tracingio_instance->underlying_io);
+        record_sample(tracingio_instance->stats, &tracingio_instance->stats->data.dowork_duration_us, get_elapsed_us(tracingio_instance->stats, start_us), NULL, 0);
+    }
+}
+
+static int tracingio_setoption(CONCRETE_IO_HANDLE tracingio, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((tracingio == NULL) || (option_name == NULL))
+    {
+        /* Codes_SRS_TRACINGIO_11_071: [ If `tracingio` or `option_name` is NULL, `tracingio_setoption` shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: tracingio = %p, option_name = %p", tracingio, option_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+
+        /* Codes_SRS_TRACINGIO_11_070: [ `tracingio_setoption` shall pass all options to the underlying IO by calling `xio_setoption` and return its result. ]*/
+        if (xio_setoption(tracingio_instance->underlying_io, option_name, value) != 0)
+        {
+            LogError("Unrecognized option %s", option_name);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE tracingio_retrieveoptions(CONCRETE_IO_HANDLE tracingio)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_076: [ If `tracingio` is NULL, `tracingio_retrieveoptions` shall fail and return NULL. ]*/
+        LogError("NULL tracingio.");
+        result = NULL;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+
+        /* Codes_SRS_TRACINGIO_11_075: [ `tracingio_retrieveoptions` shall return the result of calling `xio_retrieveoptions` on the underlying IO. ]*/
+        result = xio_retrieveoptions(tracingio_instance->underlying_io);
+        if (result == NULL)
+        {
+            LogError("unable to retrieve the underlying IO options");
+        }
+    }
+
+    return result;
+}
+
+static int tracingio_wait(CONCRETE_IO_HANDLE tracingio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (tracingio == NULL)
+    {
+        /* Codes_SRS_TRACINGIO_11_081: [ If `tracingio` is NULL, `tracingio_wait` shall fail and return a non-zero value. ]*/
+        LogError("NULL tracingio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TRACINGIO_INSTANCE* tracingio_instance = (TRACINGIO_INSTANCE*)tracingio;
+
+        /* Codes_SRS_TRACINGIO_11_080: [ `tracingio_wait` shall call `xio_wait` on the underlying IO and return its result. ]*/
+        result = xio_wait(tracingio_instance->underlying_io, timeout_ms, interest);
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION tracingio_interface_description =
+{
+    tracingio_retrieveoptions,
+    tracingio_create,
+    tracingio_destroy,
+    tracingio_open,
+    tracingio_close,
+    tracingio_send,
+    tracingio_dowork,
+    tracingio_setoption,
+    tracingio_wait
+};
+
+const IO_INTERFACE_DESCRIPTION* tracingio_get_interface_description(void)
+{
+    /* Codes_SRS_TRACINGIO_11_090: [ `tracingio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `tracingio_retrieveoptions`, `tracingio_create`, `tracingio_destroy`, `tracingio_open`, `tracingio_close`, `tracingio_send`, `tracingio_dowork`, `tracingio_setoption` and `tracingio_wait`. ]*/
+    return &tracingio_interface_description;
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <limits.h>
 #include <ctype.h>
 #include <limits.h>
@@ -18,14 +19,36 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/uws_deflate.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/utf8_checker.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/sha.h"
 
 static const char* UWS_CLIENT_OPTIONS = "uWSClientOptions";
 
+/* frames whose header and payload do not fit in this many bytes are masked into a per instance scratch buffer of this size,
+   one piece at a time, instead of being copied whole into a newly allocated frame buffer */
+#define UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE 65536
+
+/* when send coalescing is on, frames that fit in this buffer are encoded back to back in it and sent together from uws_client_dowork;
+   this is the largest payload of a TLS record, so that a coalesced send can go out as a single record */
+#define UWS_CLIENT_COALESCE_BUFFER_SIZE 16384
+
+/* length of the base64 encoded SHA-1 expected in the Sec-WebSocket-Accept header of the upgrade response */
+#define SEC_WEBSOCKET_ACCEPT_LENGTH 28
+
+/* completed pending send records (and their list nodes) kept per instance for reuse, so that a steady stream of sends does not allocate */
+#define UWS_CLIENT_MAX_POOLED_PENDING_SENDS 16
+
+/* keepalive PINGs carry a big endian sequence number, so that late PONGs to earlier PINGs are not mistaken for the last one */
+#define KEEPALIVE_PING_PAYLOAD_SIZE 8
+
 /* Requirements not needed as they are optional:
 Codes_SRS_UWS_CLIENT_01_254: [ If an endpoint receives a Ping frame and has not yet sent Pong frame(s) in response to previous Ping frame(s), the endpoint MAY elect to send a Pong frame for only the most recently processed Ping frame. ]
 Codes_SRS_UWS_CLIENT_01_255: [ A Pong frame MAY be sent unsolicited. ]
@@ -73,11 +96,36 @@ typedef struct WS_PENDING_SEND_TAG
     ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete;
     void* context;
     UWS_CLIENT_HANDLE uws_client;
+    /* NULL once the pending send was removed from the pending sends */
+    LIST_ITEM_HANDLE list_item;
+    /* only used for coalesced frames, which are completed together when the coalesce buffer has been sent */
+    bool is_coalesced;
+    struct WS_PENDING_SEND_TAG* next_coalesced_send;
+    /* set once the frame went to xio_send with a completion callback, from then on only that completion releases the pending send */
+    bool is_held_by_underlying_io;
+    /* set when a close removed the pending send while the underlying IO held it */
+    bool is_detached;
+    struct WS_PENDING_SEND_TAG* next_detached_send;
+    struct WS_PENDING_SEND_TAG* next_pooled_send;
 } WS_PENDING_SEND;
 
+/* the permessage-deflate parameters a server accepted in its "Sec-WebSocket-Extensions" response header */
+typedef struct PERMESSAGE_DEFLATE_RESPONSE_TAG
+{
+    bool is_accepted;
+    int client_max_window_bits;
+    int server_max_window_bits;
+    bool client_no_context_takeover;
+    bool server_no_context_takeover;
+} PERMESSAGE_DEFLATE_RESPONSE;
+
 typedef struct UWS_CLIENT_INSTANCE_TAG
 {
     SINGLYLINKEDLIST_HANDLE pending_sends;
+    WS_PENDING_SEND* pooled_sends;
+    size_t pooled_send_count;
+    /* pending sends removed by a close before the underlying IO completed them */
+    WS_PENDING_SEND* detached_sends;
     XIO_HANDLE underlying_io;
     char* hostname;
     char* resource_name;
@@ -96,8 +144,58 @@ typedef struct UWS_CLIENT_INSTANCE_TAG
     ON_WS_CLOSE_COMPLETE on_ws_close_complete;
     void* on_ws_close_complete_context;
     unsigned char* received_bytes;
+    size_t received_bytes_offset;
     size_t received_bytes_count;
+    size_t received_bytes_size;
     UWS_FRAME_DECODER_STATE frame_decoder_state;
+    unsigned char* send_scratch_buffer;
+    ON_WS_FRAME_FRAGMENT_RECEIVED on_ws_frame_fragment_received;
+    void* on_ws_frame_fragment_received_context;
+    /* type of the fragmented message being received, 0 if none */
+    unsigned char fragmented_message_type;
+    bool fragmented_message_is_streamed;
+    unsigned char* fragmented_message;
+    size_t fragmented_message_length;
+    size_t fragmented_message_size;
+    size_t max_message_size;
+    bool fragmented_message_is_compressed;
+    bool offer_permessage_deflate;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options;
+    /* non-NULL when permessage-deflate was negotiated for the current connection */
+    UWS_DEFLATE_HANDLE deflate;
+    UWS_CLIENT_COMPRESSION_STATISTICS compression_statistics;
+    /* keepalive PINGs, the tick counter is only created once a ping interval is set */
+    TICK_COUNTER_HANDLE tick_counter;
+    unsigned int ping_interval_ms;
+    unsigned int pong_timeout_ms;
+    bool is_ping_timer_started;
+    tickcounter_ms_t last_ping_time_ms;
+    /* carried by the last PING sent, the PONG echoing it completes a round trip */
+    uint64_t ping_sequence_number;
+    tickcounter_ms_t ping_sent_ms;
+    bool is_ping_outstanding;
+    tickcounter_ms_t ping_unanswered_since_ms;
+    UWS_CLIENT_PING_STATISTICS ping_statistics;
+    uint64_t rtt_total_ms;
+    bool coalesce_sends;
+    unsigned char* coalesce_buffer;
+    size_t coalesce_buffer_length;
+    /* pending sends of the frames in the coalesce buffer, in the order they were queued */
+    WS_PENDING_SEND* first_coalesced_send;
+    WS_PENDING_SEND* last_coalesced_send;
+    /* frames handed to xio_send, cleared by their completion so that a failed xio_send knows whether they were already completed */
+    WS_PENDING_SEND* coalesced_send_in_progress;
+    /* frame handed to xio_send, cleared by its completion so that the sender knows the completion already happened and releases the frame itself */
+    WS_PENDING_SEND* send_in_progress;
+    /* the upgrade response is parsed one line at a time as the lines complete, positions are relative to the read offset */
+    size_t upgrade_response_line_start;
+    size_t upgrade_response_scanned_length;
+    bool is_upgrade_status_line_received;
+    bool is_upgrade_accept_received;
+    char expected_accept[SEC_WEBSOCKET_ACCEPT_LENGTH + 1];
+    PERMESSAGE_DEFLATE_RESPONSE permessage_deflate_response;
+    ON_WS_UPGRADE_RESPONSE_HEADER on_ws_upgrade_response_header;
+    void* on_ws_upgrade_response_header_context;
 } UWS_CLIENT_INSTANCE;
 
 /* Codes_SRS_UWS_CLIENT_01_360: [ Connection confidentiality and integrity is provided by running the WebSocket Protocol over TLS (wss URIs). ]*/
@@ -176,6 +274,17 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                             free(result);
                             result = NULL;
                         }
+                        /* Codes_SRS_UWS_CLIENT_02_137: [ `uws_client_create` shall let the pending sends list keep its removed nodes for reuse by calling `singlylinkedlist_set_item_cache_size`. ]*/
+                        else if (singlylinkedlist_set_item_cache_size(result->pending_sends, UWS_CLIENT_MAX_POOLED_PENDING_SENDS) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_02_138: [ If `singlylinkedlist_set_item_cache_size` fails then `uws_client_create` shall fail and return NULL. ]*/
+                            LogError("Could not set the item cache size of the pending send frames list");
+                            singlylinkedlist_destroy(result->pending_sends);
+                            free(result->resource_name);
+                            free(result->hostname);
+                            free(result);
+                            result = NULL;
+                        }
                         else
                         {
                             if (use_ssl == true)
@@ -266,7 +375,47 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                                 result->on_ws_close_complete = NULL;
                                 result->on_ws_close_complete_context = NULL;
                                 result->received_bytes = NULL;
+                                result->received_bytes_offset = 0;
                                 result->received_bytes_count = 0;
+                                result->received_bytes_size = 0;
+                                result->pooled_sends = NULL;
+                                result->pooled_send_count = 0;
+                                result->send_scratch_buffer = NULL;
+                                result->on_ws_frame_fragment_received = NULL;
+                                result->on_ws_frame_fragment_received_context = NULL;
+                                result->fragmented_message_type = 0;
+                                result->fragmented_message_is_streamed = false;
+                                result->fragmented_message = NULL;
+                                result->fragmented_message_length = 0;
+                                result->fragmented_message_size = 0;
+                                result->max_message_size = SIZE_MAX;
+                                result->fragmented_message_is_compressed = false;
+                                result->offer_permessage_deflate = false;
+                                result->deflate = NULL;
+                                (void)memset(&result->compression_statistics, 0, sizeof(result->compression_statistics));
+                                result->tick_counter = NULL;
+                                result->ping_interval_ms = 0;
+                                result->pong_timeout_ms = 0;
+                                result->is_ping_timer_started = false;
+                                result->ping_sequence_number = 0;
+                                result->is_ping_outstanding = false;
+                                (void)memset(&result->ping_statistics, 0, sizeof(result->ping_statistics));
+                                result->rtt_total_ms = 0;
+                                result->coalesce_sends = false;
+                                result->coalesce_buffer = NULL;
+                                result->coalesce_buffer_length = 0;
+                                result->first_coalesced_send = NULL;
+                                result->last_coalesced_send = NULL;
+                                result->coalesced_send_in_progress = NULL;
+                                result->send_in_progress = NULL;
+                                result->detached_sends = NULL;
+                                result->upgrade_response_line_start = 0;
+                                result->upgrade_response_scanned_length = 0;
+                                result->is_upgrade_status_line_received = false;
+                                result->is_upgrade_accept_received = false;
+                                result->expected_accept[0] = '\0';
+                                result->on_ws_upgrade_response_header = NULL;
+                                result->on_ws_upgrade_response_header_context = NULL;
 
                                 result->protocol_count = protocol_count;
 
@@ -410,6 +559,17 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                             free(result);
                             result = NULL;
                         }
+                        /* Codes_SRS_UWS_CLIENT_02_139: [ `uws_client_create_with_io` shall let the pending sends list keep its removed nodes for reuse by calling `singlylinkedlist_set_item_cache_size`. ]*/
+                        else if (singlylinkedlist_set_item_cache_size(result->pending_sends, UWS_CLIENT_MAX_POOLED_PENDING_SENDS) != 0)
+                        {
+                            /* Codes_SRS_UWS_CLIENT_02_140: [ If `singlylinkedlist_set_item_cache_size` fails then `uws_client_create_with_io` shall fail and return NULL. ]*/
+                            LogError("Could not set the item cache size of the pending send frames list");
+                            singlylinkedlist_destroy(result->pending_sends);
+                            free(result->resource_name);
+                            free(result->hostname);
+                            free(result);
+                            result = NULL;
+                        }
                         else
                         {
                             /* Codes_SRS_UWS_CLIENT_01_521: [ The underlying IO shall be created by calling `xio_create`, while passing as arguments the `io_interface` and `io_create_parameters` argument values. ]*/
@@ -440,7 +600,47 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                                 result->on_ws_close_complete = NULL;
                                 result->on_ws_close_complete_context = NULL;
                                 result->received_bytes = NULL;
+                                result->received_bytes_offset = 0;
                                 result->received_bytes_count = 0;
+                                result->received_bytes_size = 0;
+                                result->pooled_sends = NULL;
+                                result->pooled_send_count = 0;
+                                result->send_scratch_buffer = NULL;
+                                result->on_ws_frame_fragment_received = NULL;
+                                result->on_ws_frame_fragment_received_context = NULL;
+                                result->fragmented_message_type = 0;
+                                result->fragmented_message_is_streamed = false;
+                                result->fragmented_message = NULL;
+                                result->fragmented_message_length = 0;
+                                result->fragmented_message_size = 0;
+                                result->max_message_size = SIZE_MAX;
+                                result->fragmented_message_is_compressed = false;
+                                result->offer_permessage_deflate = false;
+                                result->deflate = NULL;
+                                (void)memset(&result->compression_statistics, 0, sizeof(result->compression_statistics));
+                                result->tick_counter = NULL;
+                                result->ping_interval_ms = 0;
+                                result->pong_timeout_ms = 0;
+                                result->is_ping_timer_started = false;
+                                result->ping_sequence_number = 0;
+                                result->is_ping_outstanding = false;
+                                (void)memset(&result->ping_statistics, 0, sizeof(result->ping_statistics));
+                                result->rtt_total_ms = 0;
+                                result->coalesce_sends = false;
+                                result->coalesce_buffer = NULL;
+                                result->coalesce_buffer_length = 0;
+                                result->first_coalesced_send = NULL;
+                                result->last_coalesced_send = NULL;
+                                result->coalesced_send_in_progress = NULL;
+                                result->send_in_progress = NULL;
+                                result->detached_sends = NULL;
+                                result->upgrade_response_line_start = 0;
+                                result->upgrade_response_scanned_length = 0;
+                                result->is_upgrade_status_line_received = false;
+                                result->is_upgrade_accept_received = false;
+                                result->expected_accept[0] = '\0';
+                                result->on_ws_upgrade_response_header = NULL;
+                                result->on_ws_upgrade_response_header_context = NULL;
 
                                 result->protocol_count = protocol_count;
 
@@ -556,6 +756,48 @@ void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
 
         /* Codes_SRS_UWS_CLIENT_01_024: [ `uws_client_destroy` shall free the list used to track the pending sends by calling `singlylinkedlist_destroy`. ]*/
         singlylinkedlist_destroy(uws_client->pending_sends);
+
+        /* Codes_SRS_UWS_CLIENT_02_141: [ `uws_client_destroy` shall free the pending send records kept for reuse. ]*/
+        while (uws_client->pooled_sends != NULL)
+        {
+            WS_PENDING_SEND* pooled_send = uws_client->pooled_sends;
+            uws_client->pooled_sends = pooled_send->next_pooled_send;
+            free(pooled_send);
+        }
+
+        /* Codes_SRS_UWS_CLIENT_02_161: [ `uws_client_destroy` shall free the pending sends removed by a close that the underlying IO did not complete. ]*/
+        while (uws_client->detached_sends != NULL)
+        {
+            WS_PENDING_SEND* detached_send = uws_client->detached_sends;
+            uws_client->detached_sends = detached_send->next_detached_send;
+            free(detached_send);
+        }
+
+        if (uws_client->send_scratch_buffer != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_008: [ `uws_client_destroy` shall free the send scratch buffer, if one was allocated. ]*/
+            free(uws_client->send_scratch_buffer);
+        }
+        if (uws_client->fragmented_message != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_028: [ `uws_client_destroy` shall free the buffer used for reassembling fragmented messages, if one was allocated. ]*/
+            free(uws_client->fragmented_message);
+        }
+        if (uws_client->deflate != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_047: [ `uws_client_destroy` shall destroy the permessage-deflate compressor by calling `uws_deflate_destroy`, if one was created. ]*/
+            uws_deflate_destroy(uws_client->deflate);
+        }
+        if (uws_client->coalesce_buffer != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_095: [ `uws_client_destroy` shall free the coalesce buffer, if one was allocated. ]*/
+            free(uws_client->coalesce_buffer);
+        }
+        if (uws_client->tick_counter != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_072: [ `uws_client_destroy` shall destroy the tick counter used for keepalive PINGs by calling `tickcounter_destroy`, if one was created. ]*/
+            tickcounter_destroy(uws_client->tick_counter);
+        }
         free(uws_client->resource_name);
         free(uws_client->hostname);
         free(uws_client);
@@ -642,6 +884,268 @@ static void indicate_ws_error_and_close(UWS_CLIENT_INSTANCE* uws_client, WS_ERRO
     uws_client->on_ws_error(uws_client->on_ws_error_context, error_code);
 }
 
+static int append_message_fragment(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (size > uws_client->fragmented_message_size - uws_client->fragmented_message_length)
+    {
+        /* the reassembly buffer grows the same way the received bytes buffer does, so that long messages are not reallocated for every fragment */
+        size_t needed_size = uws_client->fragmented_message_length + size;
+        size_t new_size = (uws_client->fragmented_message_size > (SIZE_MAX / 2)) ? needed_size : (uws_client->fragmented_message_size * 2);
+        unsigned char* new_fragmented_message;
+
+        if (new_size < needed_size)
+        {
+            new_size = needed_size;
+        }
+
+        new_fragmented_message = (unsigned char*)realloc(uws_client->fragmented_message, new_size);
+        if (new_fragmented_message == NULL)
+        {
+            LogError("Cannot grow the fragmented message buffer to %lu bytes", (unsigned long)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->fragmented_message = new_fragmented_message;
+            uws_client->fragmented_message_size = new_size;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if ((result == 0) &&
+        (size > 0))
+    {
+        (void)memcpy(uws_client->fragmented_message + uws_client->fragmented_message_length, buffer, size);
+        uws_client->fragmented_message_length += size;
+    }
+
+    return result;
+}
+
+/* the processor time is that of the calling thread, so that work done concurrently by other threads of the process is not counted */
+static bool get_thread_cpu_time(uint64_t* cpu_time_us)
+{
+    /* Codes_SRS_UWS_CLIENT_02_153: [ The processor time spent compressing and decompressing shall be measured by calling `ThreadAPI_GetCurrentThreadCpuTime` before and after each call into the compressor. ]*/
+    return ThreadAPI_GetCurrentThreadCpuTime(cpu_time_us) == THREADAPI_OK;
+}
+
+static void add_thread_cpu_time(uint64_t* total_cpu_time_us, uint64_t start_us)
+{
+    uint64_t now_us;
+
+    /* Codes_SRS_UWS_CLIENT_02_154: [ If `ThreadAPI_GetCurrentThreadCpuTime` fails, the processor time of that call into the compressor shall not be counted. ]*/
+    if (get_thread_cpu_time(&now_us) &&
+        (now_us > start_us))
+    {
+        *total_cpu_time_us += now_us - start_us;
+    }
+}
+
+/* replaces buffer and size with the decompressed payload, which stays valid until the next call into the decompressor */
+static int decompress_message_fragment(UWS_CLIENT_INSTANCE* uws_client, const unsigned char** buffer, size_t* size, bool is_final, size_t max_size)
+{
+    int result;
+    const unsigned char* decompressed_payload;
+    size_t decompressed_size;
+    uint64_t start_us;
+    bool is_cpu_time_measured = get_thread_cpu_time(&start_us);
+
+    /* Codes_SRS_UWS_CLIENT_02_050: [ The payload of each frame of a message received with the RSV1 bit set shall be decompressed by calling `uws_deflate_decompress`, passing whether the frame is the final one of the message and the number of bytes the message may still grow by. ]*/
+    if (uws_deflate_decompress(uws_client->deflate, *buffer, *size, is_final, max_size, &decompressed_payload, &decompressed_size) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_051: [ If `uws_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1007 shall be sent. ]*/
+        LogError("Cannot decompress the received message");
+        indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, CLOSE_INCONSISTENT_DATA_IN_MESSAGE);
+        result = __FAILURE__;
+    }
+    else if (decompressed_size > max_size)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_052: [ If the decompressed message exceeds the maximum message size, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_MESSAGE_TOO_BIG` and a CLOSE frame with status code 1009 shall be sent. ]*/
+        LogError("Decompressed message exceeds the maximum message size of %lu bytes", (unsigned long)uws_client->max_message_size);
+        indicate_ws_error_and_close(uws_client, WS_ERROR_MESSAGE_TOO_BIG, CLOSE_MESSAGE_TOO_BIG);
+        result = __FAILURE__;
+    }
+    else
+    {
+        uws_client->compression_statistics.compressed_bytes_received += *size;
+        uws_client->compression_statistics.uncompressed_bytes_received += decompressed_size;
+        if (is_final)
+        {
+            uws_client->compression_statistics.messages_decompressed++;
+        }
+
+        *buffer = decompressed_payload;
+        *size = decompressed_size;
+        result = 0;
+    }
+
+    if (is_cpu_time_measured)
+    {
+        add_thread_cpu_time(&uws_client->compression_statistics.decompress_cpu_time_us, start_us);
+    }
+
+    return result;
+}
+
+static void indicate_message_fragment(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* buffer, size_t size, bool is_final)
+{
+    unsigned char frame_type = uws_client->fragmented_message_type;
+
+    if (is_final)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_285: [ Subsequent data frames MUST be interpreted as belonging to a new WebSocket message. ]*/
+        uws_client->fragmented_message_type = 0;
+    }
+
+    if (uws_client->fragmented_message_is_compressed &&
+        (decompress_message_fragment(uws_client, &buffer, &size, is_final,
+            uws_client->fragmented_message_is_streamed ? uws_client->max_message_size : (uws_client->max_message_size - uws_client->fragmented_message_length)) != 0))
+    {
+        /* the error has already been indicated */
+    }
+    else if (uws_client->fragmented_message_is_streamed)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_039: [ If an `on_ws_frame_fragment_received` callback was set when the first fragment of a message was received, each fragment of that message shall be passed to it, together with the type of the message and whether the fragment is the final one. ]*/
+        uws_client->on_ws_frame_fragment_received(uws_client->on_ws_frame_fragment_received_context, frame_type, buffer, size, is_final);
+    }
+    /* Codes_SRS_UWS_CLIENT_02_036: [ Otherwise the payload of each fragment shall be appended to the message being reassembled. ]*/
+    else if (append_message_fragment(uws_client, buffer, size) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_038: [ If growing the buffer for the message being reassembled fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+        LogError("Cannot reassemble fragmented message");
+        indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+    }
+    else if (is_final)
+    {
+        size_t message_length = uws_client->fragmented_message_length;
+
+        /* Codes_SRS_UWS_CLIENT_01_284: [ When the last fragment is received as indicated by the FIN bit (frame-fin), it is said that _A WebSocket Message Has Been Received_ with data /data/ (comprised of the concatenation of the "Application data" of the fragments) and type /type/ (noted from the first frame of the fragmented message). ]*/
+        /* Codes_SRS_UWS_CLIENT_02_037: [ When the final fragment has been appended, the reassembled message shall be indicated via the callback `on_ws_frame_received`, with the type of the first fragment. ]*/
+        uws_client->fragmented_message_length = 0;
+        uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, frame_type, uws_client->fragmented_message, message_length);
+    }
+}
+
+static void on_data_frame_received(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, bool is_final, bool is_compressed, const unsigned char* buffer, size_t size)
+{
+    if (uws_client->fragmented_message_type != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_034: [ If a text or binary frame is received while a fragmented message is being received, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+        LogError("Data frame received in the middle of a fragmented message");
+        indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, CLOSE_PROTOCOL_ERROR);
+    }
+    else if (is_final)
+    {
+        if ((!is_compressed) ||
+            (decompress_message_fragment(uws_client, &buffer, &size, true, uws_client->max_message_size) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_032: [ A text or binary frame that has the FIN bit set and is received while no fragmented message is being received shall be indicated via the callback `on_ws_frame_received`. ]*/
+            uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, frame_type, buffer, size);
+        }
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
+        /* Codes_SRS_UWS_CLIENT_02_033: [ A text or binary frame that does not have the FIN bit set shall start a fragmented message of that type. ]*/
+        uws_client->fragmented_message_type = frame_type;
+        uws_client->fragmented_message_is_streamed = (uws_client->on_ws_frame_fragment_received != NULL);
+        uws_client->fragmented_message_is_compressed = is_compressed;
+        uws_client->fragmented_message_length = 0;
+        indicate_message_fragment(uws_client, buffer, size, false);
+    }
+}
+
+static void on_continuation_frame_received(UWS_CLIENT_INSTANCE* uws_client, bool is_final, const unsigned char* buffer, size_t size)
+{
+    if (uws_client->fragmented_message_type == 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_035: [ If a continuation frame is received while no fragmented message is being received, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+        LogError("Continuation frame received without a fragmented message");
+        indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, CLOSE_PROTOCOL_ERROR);
+    }
+    else
+    {
+        indicate_message_fragment(uws_client, buffer, size, is_final);
+    }
+}
+
+/* "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits=NN; server_max_window_bits=NN; client_no_context_takeover; server_no_context_takeover\r\n" */
+#define PERMESSAGE_DEFLATE_OFFER_MAX_LENGTH 192
+
+static void build_permessage_deflate_offer(const UWS_CLIENT_INSTANCE* uws_client, char* offer)
+{
+    const WS_PERMESSAGE_DEFLATE_OPTIONS* options = &uws_client->permessage_deflate_options;
+    int length;
+
+    /* Codes_SRS_UWS_CLIENT_02_049: [ The offer shall always include `client_max_window_bits`, with a value only when the configured client window is below 15 bits, `server_max_window_bits` only when the requested server window is below 15 bits, and `client_no_context_takeover` and `server_no_context_takeover` when they were requested. ]*/
+    length = sprintf(offer, "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits");
+    if (options->client_max_window_bits < 15)
+    {
+        length += sprintf(offer + length, "=%d", options->client_max_window_bits);
+    }
+    if (options->server_max_window_bits < 15)
+    {
+        length += sprintf(offer + length, "; server_max_window_bits=%d", options->server_max_window_bits);
+    }
+    if (options->client_no_context_takeover)
+    {
+        length += sprintf(offer + length, "; client_no_context_takeover");
+    }
+    if (options->server_no_context_takeover)
+    {
+        length += sprintf(offer + length, "; server_no_context_takeover");
+    }
+    (void)sprintf(offer + length, "\r\n");
+}
+
+/* computes the base64 encoded SHA-1 of the key concatenated with the WebSocket GUID, which is what the server has to send back in Sec-WebSocket-Accept */
+static int compute_expected_accept(UWS_CLIENT_INSTANCE* uws_client, const char* base64_nonce)
+{
+    static const char websocket_guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    int result;
+    SHA1Context sha1_context;
+    uint8_t digest[SHA1HashSize];
+
+    if ((SHA1Reset(&sha1_context) != shaSuccess) ||
+        (SHA1Input(&sha1_context, (const uint8_t*)base64_nonce, (unsigned int)strlen(base64_nonce)) != shaSuccess) ||
+        (SHA1Input(&sha1_context, (const uint8_t*)websocket_guid, sizeof(websocket_guid) - 1) != shaSuccess) ||
+        (SHA1Result(&sha1_context, digest) != shaSuccess))
+    {
+        LogError("Cannot compute the SHA-1 of the WebSocket key");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+        size_t length = 0;
+
+        /* 20 bytes make 6 full groups of 3 bytes and a last group of 2 bytes, padded with one '=' */
+        for (i = 0; i < SHA1HashSize; i += 3)
+        {
+            uint32_t group = ((uint32_t)digest[i] << 16) |
+                ((i + 1 < SHA1HashSize) ? ((uint32_t)digest[i + 1] << 8) : 0) |
+                ((i + 2 < SHA1HashSize) ? (uint32_t)digest[i + 2] : 0);
+
+            uws_client->expected_accept[length++] = base64_chars[(group >> 18) & 0x3F];
+            uws_client->expected_accept[length++] = base64_chars[(group >> 12) & 0x3F];
+            uws_client->expected_accept[length++] = (i + 1 < SHA1HashSize) ? base64_chars[(group >> 6) & 0x3F] : '=';
+            uws_client->expected_accept[length++] = (i + 2 < SHA1HashSize) ? base64_chars[group & 0x3F] : '=';
+        }
+
+        uws_client->expected_accept[length] = '\0';
+        result = 0;
+    }
+
+    return result;
+}
+
 static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
 {
     UWS_CLIENT_HANDLE uws_client = (UWS_CLIENT_HANDLE)context;
@@ -681,6 +1185,7 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
                 size_t i;
                 unsigned char nonce[16];
                 STRING_HANDLE base64_nonce;
+                char permessage_deflate_offer[PERMESSAGE_DEFLATE_OFFER_MAX_LENGTH];
 
                 /* Codes_SRS_UWS_CLIENT_01_089: [ The value of this header field MUST be a nonce consisting of a randomly selected 16-byte value that has been base64-encoded (see Section 4 of [RFC4648]). ]*/
                 /* Codes_SRS_UWS_CLIENT_01_090: [ The nonce MUST be selected randomly for each connection. ]*/
@@ -719,11 +1224,28 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
                         "Sec-WebSocket-Key: %s\r\n"
                         "Sec-WebSocket-Protocol: %s\r\n"
                         "Sec-WebSocket-Version: 13\r\n"
+                        "%s"
                         "\r\n";
                     const char* base64_nonce_chars = STRING_c_str(base64_nonce);
 
-                    upgrade_request_length = (int)(strlen(upgrade_request_format) + strlen(uws_client->resource_name)+strlen(uws_client->hostname) + strlen(base64_nonce_chars) + strlen(uws_client->protocols[0].protocol)+5);
-                    if (upgrade_request_length < 0)
+                    if (uws_client->offer_permessage_deflate)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_02_048: [ If the `ws_permessage_deflate` option was set, the upgrade request shall offer the permessage-deflate extension in a `Sec-WebSocket-Extensions` header. ]*/
+                        build_permessage_deflate_offer(uws_client, permessage_deflate_offer);
+                    }
+                    else
+                    {
+                        permessage_deflate_offer[0] = '\0';
+                    }
+
+                    upgrade_request_length = (int)(strlen(upgrade_request_format) + strlen(uws_client->resource_name)+strlen(uws_client->hostname) + strlen(base64_nonce_chars) + strlen(uws_client->protocols[0].protocol) + strlen(permessage_deflate_offer) + 5);
+
+                    /* Codes_SRS_UWS_CLIENT_02_126: [ Before sending the upgrade request, the value expected in the `Sec-WebSocket-Accept` header of the response shall be computed as the base64 encoded SHA-1 of the nonce concatenated with "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", so that the response can be validated without keeping the nonce. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_482: [ The value of this header field is constructed by concatenating /key/, defined above in step 4 in Section 4.2.2, with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_483: [ taking the SHA-1 hash of this concatenated value to obtain a 20-byte value ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_484: [ and base64-encoding (see Section 4 of [RFC4648]) this 20-byte hash. ]*/
+                    if ((upgrade_request_length < 0) ||
+                        (compute_expected_accept(uws_client, base64_nonce_chars) != 0))
                     {
                         /* Codes_SRS_UWS_CLIENT_01_408: [ If constructing of the WebSocket upgrade request fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST`. ]*/
                         LogError("Cannot construct the WebSocket upgrade request");
@@ -746,7 +1268,8 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
                                 uws_client->hostname,
                                 uws_client->port,
                                 base64_nonce_chars,
-                                uws_client->protocols[0].protocol);
+                                uws_client->protocols[0].protocol,
+                                permessage_deflate_offer);
 
                             /* No need to have any send complete here, as we are monitoring the received bytes */
                             /* Codes_SRS_UWS_CLIENT_01_372: [ Once prepared the WebSocket upgrade request shall be sent by calling `xio_send`. ]*/
@@ -779,12 +1302,87 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
 
 static void consume_received_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t consumed_bytes)
 {
-    if (consumed_bytes < uws_client->received_bytes_count)
+    /* Codes_SRS_UWS_CLIENT_02_026: [ Consuming decoded bytes shall only advance the read offset into the received bytes buffer, without moving the remaining bytes. ]*/
+    uws_client->received_bytes_count -= consumed_bytes;
+
+    if (uws_client->received_bytes_count == 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_027: [ When all the received bytes have been consumed the read offset shall be reset to the start of the buffer. ]*/
+        uws_client->received_bytes_offset = 0;
+    }
+    else
+    {
+        uws_client->received_bytes_offset += consumed_bytes;
+    }
+}
+
+static int append_received_bytes(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (size > SIZE_MAX - uws_client->received_bytes_count)
     {
-        (void)memmove(uws_client->received_bytes, uws_client->received_bytes + consumed_bytes, uws_client->received_bytes_count - consumed_bytes);
+        LogError("Too many bytes received: %lu", (unsigned long)size);
+        result = __FAILURE__;
     }
+    else
+    {
+        size_t needed_size = uws_client->received_bytes_count + size;
 
-    uws_client->received_bytes_count -= consumed_bytes;
+        if (needed_size <= uws_client->received_bytes_size - uws_client->received_bytes_offset)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_022: [ If the new bytes fit after the unconsumed bytes in the received bytes buffer, they shall be copied there without reallocating the buffer. ]*/
+            result = 0;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_02_023: [ Otherwise the unconsumed bytes shall be moved to the start of the buffer. ]*/
+            if ((uws_client->received_bytes_offset > 0) &&
+                (uws_client->received_bytes_count > 0))
+            {
+                (void)memmove(uws_client->received_bytes, uws_client->received_bytes + uws_client->received_bytes_offset, uws_client->received_bytes_count);
+            }
+
+            uws_client->received_bytes_offset = 0;
+
+            if (needed_size <= uws_client->received_bytes_size)
+            {
+                result = 0;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_024: [ If the bytes still do not fit, the buffer shall be grown with `realloc` to the larger of twice its current size and the size needed. ]*/
+                size_t new_size = (uws_client->received_bytes_size > (SIZE_MAX / 2)) ? needed_size : (uws_client->received_bytes_size * 2);
+                unsigned char* new_received_bytes;
+
+                if (new_size < needed_size)
+                {
+                    new_size = needed_size;
+                }
+
+                new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, new_size);
+                if (new_received_bytes == NULL)
+                {
+                    LogError("Cannot grow the received bytes buffer to %lu bytes", (unsigned long)new_size);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    uws_client->received_bytes = new_received_bytes;
+                    uws_client->received_bytes_size = new_size;
+                    result = 0;
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_offset + uws_client->received_bytes_count, buffer, size);
+            uws_client->received_bytes_count += size;
+        }
+    }
+
+    return result;
 }
 
 static void on_underlying_io_close_complete(void* context)
@@ -839,101 +1437,421 @@ static void on_underlying_io_close_sent(void* context, IO_SEND_RESULT io_send_re
     }
 }
 
-/*the following function does the same as sscanf(pos2, "%d", &sec)*/
-/*this function only exists because some of platforms do not have sscanf. */
-static int ParseStringToDecimal(const char *src, int* dst)
+static const char* skip_linear_whitespace(const char* pos, const char* end)
 {
-    int result;
-    char* next;
+    while ((pos < end) && ((*pos == ' ') || (*pos == '\t')))
+    {
+        pos++;
+    }
 
-    (*dst) = (int)strtol(src, &next, 0);
-    if ((src == next) || ((((*dst) == INT_MAX) || ((*dst) == INT_MIN)) && (errno != 0)))
+    return pos;
+}
+
+static size_t get_token_length(const char* pos, const char* end)
+{
+    size_t length = 0;
+
+    while ((pos + length < end) && (strchr(" \t,;=\"", pos[length]) == NULL))
     {
-        result = __FAILURE__;
+        length++;
     }
-    else
+
+    return length;
+}
+
+static bool token_equals(const char* token, size_t length, const char* expected)
+{
+    return (strlen(expected) == length) && (memcmp(token, expected, length) == 0);
+}
+
+static bool header_name_equals(const char* name, size_t length, const char* expected)
+{
+    bool result = (strlen(expected) == length);
+    size_t i;
+
+    for (i = 0; result && (i < length); i++)
     {
-        result = 0;
+        result = (tolower((unsigned char)name[i]) == tolower((unsigned char)expected[i]));
     }
 
     return result;
 }
 
-/*the following function does the same as sscanf(buf, "HTTP/%*d.%*d %d %*[^\r\n]", &ret) */
-/*this function only exists because some of platforms do not have sscanf. This is not a full implementation; it only works with well-defined HTTP response. */
-static int ParseHttpResponse(const char* src, int* dst)
+static int parse_window_bits(const char* value, size_t length, int* window_bits)
 {
     int result;
-    static const char HTTPPrefix[] = "HTTP/";
-    bool fail;
-    const char* runPrefix;
 
-    if ((src == NULL) || (dst == NULL))
+    if ((length < 1) ||
+        (length > 2) ||
+        (!isdigit((unsigned char)value[0])) ||
+        ((length == 2) && !isdigit((unsigned char)value[1])))
     {
         result = __FAILURE__;
     }
     else
     {
-        fail = false;
-        runPrefix = HTTPPrefix;
+        int bits = (length == 1) ? (value[0] - '0') : (((value[0] - '0') * 10) + (value[1] - '0'));
 
-        while ((*runPrefix) != '\0')
+        if ((bits < 8) ||
+            (bits > 15))
         {
-            if ((*runPrefix) != (*src))
-            {
-                fail = true;
-                break;
-            }
-            src++;
-            runPrefix++;
+            result = __FAILURE__;
         }
-
-        if (!fail)
+        else
         {
-            while ((*src) != '.')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
-            }
+            *window_bits = bits;
+            result = 0;
         }
+    }
 
-        if (!fail)
-        {
-            while ((*src) != ' ')
-            {
-                if ((*src) == '\0')
-                {
-                    fail = true;
-                    break;
-                }
-                src++;
+    return result;
+}
+
+/* parses the extension parameters following "permessage-deflate", up to the next extension or the end of the header value */
+static const char* parse_permessage_deflate_parameters(const UWS_CLIENT_INSTANCE* uws_client, const char* pos, const char* end, PERMESSAGE_DEFLATE_RESPONSE* response)
+{
+    bool seen_client_max_window_bits = false;
+    bool seen_server_max_window_bits = false;
+
+    while ((pos != NULL) && (pos < end) && (*pos == ';'))
+    {
+        const char* name = skip_linear_whitespace(pos + 1, end);
+        size_t name_length = get_token_length(name, end);
+        const char* value = NULL;
+        size_t value_length = 0;
+
+        pos = skip_linear_whitespace(name + name_length, end);
+        if ((pos < end) && (*pos == '='))
+        {
+            value = skip_linear_whitespace(pos + 1, end);
+            if ((value < end) && (*value == '"'))
+            {
+                value++;
+                value_length = get_token_length(value, end);
+                pos = ((value + value_length < end) && (value[value_length] == '"')) ? skip_linear_whitespace(value + value_length + 1, end) : NULL;
+            }
+            else
+            {
+                value_length = get_token_length(value, end);
+                pos = skip_linear_whitespace(value + value_length, end);
             }
         }
 
-        if (fail)
+        if (pos == NULL)
+        {
+            LogError("Unterminated quoted value in permessage-deflate response");
+        }
+        else if (token_equals(name, name_length, "server_no_context_takeover") && (value == NULL) && !response->server_no_context_takeover)
+        {
+            response->server_no_context_takeover = true;
+        }
+        else if (token_equals(name, name_length, "client_no_context_takeover") && (value == NULL) && !response->client_no_context_takeover)
+        {
+            response->client_no_context_takeover = true;
+        }
+        else if (token_equals(name, name_length, "server_max_window_bits") && (value != NULL) && !seen_server_max_window_bits &&
+            (parse_window_bits(value, value_length, &response->server_max_window_bits) == 0) &&
+            (response->server_max_window_bits <= uws_client->permessage_deflate_options.server_max_window_bits))
+        {
+            seen_server_max_window_bits = true;
+        }
+        else if (token_equals(name, name_length, "client_max_window_bits") && (value != NULL) && !seen_client_max_window_bits &&
+            (parse_window_bits(value, value_length, &response->client_max_window_bits) == 0))
+        {
+            seen_client_max_window_bits = true;
+        }
+        else
+        {
+            LogError("Invalid or duplicate parameter %.*s in permessage-deflate response", (int)name_length, name);
+            pos = NULL;
+        }
+    }
+
+    return pos;
+}
+
+static int parse_extensions_header(const UWS_CLIENT_INSTANCE* uws_client, const char* pos, const char* end, PERMESSAGE_DEFLATE_RESPONSE* response)
+{
+    int result = 0;
+
+    do
+    {
+        size_t length;
+
+        pos = skip_linear_whitespace(pos, end);
+        length = get_token_length(pos, end);
+
+        if (length == 0)
+        {
+            LogError("Empty extension in Sec-WebSocket-Extensions response header");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_UWS_CLIENT_01_111: [ If the response includes a |Sec-WebSocket-Extensions| header field and this header field indicates the use of an extension that was not present in the client's handshake (the server has indicated an extension not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+        else if ((!uws_client->offer_permessage_deflate) ||
+            (!token_equals(pos, length, "permessage-deflate")))
+        {
+            LogError("Server indicated the extension %.*s that was not offered", (int)length, pos);
+            result = __FAILURE__;
+        }
+        else if (response->is_accepted)
         {
+            LogError("Server accepted permessage-deflate more than once");
             result = __FAILURE__;
         }
         else
         {
-            if (ParseStringToDecimal(src, dst) != 0)
+            response->is_accepted = true;
+            pos = parse_permessage_deflate_parameters(uws_client, skip_linear_whitespace(pos + length, end), end, response);
+            if (pos == NULL)
             {
                 result = __FAILURE__;
             }
+            else if (pos < end)
+            {
+                if ((*pos != ',') ||
+                    (skip_linear_whitespace(pos + 1, end) == end))
+                {
+                    LogError("Unexpected character in Sec-WebSocket-Extensions response header");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    pos++;
+                }
+            }
+        }
+    } while ((result == 0) && (pos < end));
+
+    return result;
+}
+
+static WS_OPEN_RESULT negotiate_permessage_deflate(UWS_CLIENT_INSTANCE* uws_client)
+{
+    WS_OPEN_RESULT result = WS_OPEN_OK;
+    const PERMESSAGE_DEFLATE_RESPONSE* response = &uws_client->permessage_deflate_response;
+
+    if (response->is_accepted)
+    {
+        if (response->client_max_window_bits < 9)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_057: [ If the server limits the client window to 8 bits the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`, as the compressor cannot produce such a stream. ]*/
+            LogError("A client window of %d bits is not supported", response->client_max_window_bits);
+            result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+        }
+        else
+        {
+            int compress_window_bits = (response->client_max_window_bits < uws_client->permessage_deflate_options.client_max_window_bits) ? response->client_max_window_bits : uws_client->permessage_deflate_options.client_max_window_bits;
+
+            /* Codes_SRS_UWS_CLIENT_02_058: [ If the server accepted permessage-deflate, a compressor shall be created by calling `uws_deflate_create` with the smaller of the configured and accepted client windows, the configured compression level, and whether either side requested `client_no_context_takeover`. ]*/
+            uws_client->deflate = uws_deflate_create(compress_window_bits, uws_client->permessage_deflate_options.compression_level,
+                uws_client->permessage_deflate_options.client_no_context_takeover || response->client_no_context_takeover);
+            if (uws_client->deflate == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_059: [ If `uws_deflate_create` fails, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+                LogError("Cannot create the permessage-deflate compressor");
+                result = WS_OPEN_ERROR_NOT_ENOUGH_MEMORY;
+            }
             else
             {
-                result = 0;
+                uws_client->compression_statistics.is_negotiated = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* returns the position after 1 or more digits, NULL if there are none */
+static const char* skip_digits(const char* pos, const char* end)
+{
+    const char* digits_end = pos;
+
+    while ((digits_end < end) && isdigit((unsigned char)*digits_end))
+    {
+        digits_end++;
+    }
+
+    return (digits_end == pos) ? NULL : digits_end;
+}
+
+/* parses "HTTP/<major>.<minor> <3 digit status>[ <reason>]", line does not include the line terminator */
+static WS_OPEN_RESULT parse_upgrade_status_line(const char* line, const char* end)
+{
+    static const char http_prefix[] = "HTTP/";
+    WS_OPEN_RESULT result;
+    const char* pos = (((size_t)(end - line) >= sizeof(http_prefix) - 1) && (memcmp(line, http_prefix, sizeof(http_prefix) - 1) == 0)) ? skip_digits(line + sizeof(http_prefix) - 1, end) : NULL;
+    const char* status = NULL;
+    const char* status_end = NULL;
+
+    if ((pos != NULL) && (pos < end) && (*pos == '.'))
+    {
+        pos = skip_digits(pos + 1, end);
+        if ((pos != NULL) && (pos < end) && (*pos == ' '))
+        {
+            status = skip_linear_whitespace(pos, end);
+            status_end = skip_digits(status, end);
+        }
+    }
+
+    if ((status_end == NULL) ||
+        (status_end - status != 3) ||
+        ((status_end < end) && (*status_end != ' ') && (*status_end != '\t')))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_383: [ If the WebSocket upgrade request cannot be decoded an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+        LogError("Cannot decode the status line of the WebSocket upgrade response");
+        result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+    }
+    else
+    {
+        int status_code = ((status[0] - '0') * 100) + ((status[1] - '0') * 10) + (status[2] - '0');
+
+        if (status_code != 101)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
+            LogError("Bad status (%d) received in WebSocket Upgrade response", status_code);
+            result = WS_OPEN_ERROR_BAD_RESPONSE_STATUS;
+        }
+        else
+        {
+            result = WS_OPEN_OK;
+        }
+    }
+
+    return result;
+}
+
+/* parses one "name: value" header line of the upgrade response, line does not include the line terminator */
+static WS_OPEN_RESULT parse_upgrade_response_header(UWS_CLIENT_INSTANCE* uws_client, const char* line, const char* end)
+{
+    WS_OPEN_RESULT result;
+    const char* colon = (const char*)memchr(line, ':', end - line);
+
+    if ((colon == NULL) ||
+        (colon == line))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_129: [ If a header line has no name or no colon, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+        LogError("Malformed header line in WebSocket upgrade response");
+        result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+    }
+    else
+    {
+        size_t name_length = colon - line;
+        const char* value = skip_linear_whitespace(colon + 1, end);
+        const char* value_end = end;
+
+        while ((value_end > value) && ((value_end[-1] == ' ') || (value_end[-1] == '\t')))
+        {
+            value_end--;
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_114: [ Please note that according to [RFC2616], all header field names in both HTTP requests and HTTP responses are case-insensitive. ]*/
+        if (header_name_equals(line, name_length, "Sec-WebSocket-Accept"))
+        {
+            if (uws_client->is_upgrade_accept_received ||
+                !token_equals(value, value_end - value, uws_client->expected_accept))
+            {
+                /* Codes_SRS_UWS_CLIENT_02_130: [ If the `Sec-WebSocket-Accept` header value, ignoring leading and trailing whitespace, is not the value computed when the upgrade request was sent, or the header is present more than once, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_110: [ If the response lacks a |Sec-WebSocket-Accept| header field or the |Sec-WebSocket-Accept| contains a value other than the base64-encoded SHA-1 of the concatenation of the |Sec-WebSocket-Key| (as a string, not base64-decoded) with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" but ignoring     any leading and trailing whitespace, the client MUST _Fail the WebSocket Connection_. ]*/
+                LogError("Invalid or duplicate Sec-WebSocket-Accept in WebSocket upgrade response: %.*s", (int)(value_end - value), value);
+                result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+            }
+            else
+            {
+                uws_client->is_upgrade_accept_received = true;
+                result = WS_OPEN_OK;
             }
         }
+        else if (header_name_equals(line, name_length, "Sec-WebSocket-Protocol") &&
+            ((uws_client->protocols == NULL) || !token_equals(value, value_end - value, uws_client->protocols[0].protocol)))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_131: [ If the `Sec-WebSocket-Protocol` header value is not the protocol sent in the upgrade request, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_112: [ If the response includes a |Sec-WebSocket-Protocol| header field and this header field indicates the use of a subprotocol that was not present in the client's handshake (the server has indicated a subprotocol not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+            LogError("Server selected the subprotocol %.*s that was not requested", (int)(value_end - value), value);
+            result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+        }
+        /* Codes_SRS_UWS_CLIENT_02_055: [ All `Sec-WebSocket-Extensions` header fields of the upgrade response shall be parsed as a comma separated list of extensions with semicolon separated parameters. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_487: [ If multiple extensions are to be used, they can all be listed in a single |Sec-WebSocket-Extensions| header field or split between multiple instances of the |Sec-WebSocket-Extensions| header field. ]*/
+        else if (header_name_equals(line, name_length, "Sec-WebSocket-Extensions") &&
+            (parse_extensions_header(uws_client, value, value_end, &uws_client->permessage_deflate_response) != 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_056: [ If the server indicates an extension that was not offered, an extension more than once, or a permessage-deflate parameter that is unknown, duplicated, malformed or outside of what was offered, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+            result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+        }
+        else
+        {
+            result = WS_OPEN_OK;
+        }
+
+        if ((result == WS_OPEN_OK) &&
+            (uws_client->on_ws_upgrade_response_header != NULL))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_132: [ Each header that was parsed successfully shall be indicated by calling the callback set with `uws_client_set_on_ws_upgrade_response_header`, if any, with the header name and the value stripped of leading and trailing whitespace. ]*/
+            uws_client->on_ws_upgrade_response_header(uws_client->on_ws_upgrade_response_header_context, line, name_length, value, value_end - value);
+        }
     }
 
     return result;
 }
 
+static void encode_keepalive_ping_payload(unsigned char* payload, uint64_t sequence_number)
+{
+    size_t i;
+
+    for (i = 0; i < KEEPALIVE_PING_PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (unsigned char)(sequence_number >> ((KEEPALIVE_PING_PAYLOAD_SIZE - 1 - i) * 8));
+    }
+}
+
+static void on_keepalive_pong_received(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* payload, size_t length)
+{
+    unsigned char expected_payload[KEEPALIVE_PING_PAYLOAD_SIZE];
+
+    encode_keepalive_ping_payload(expected_payload, uws_client->ping_sequence_number);
+
+    /* Codes_SRS_UWS_CLIENT_02_084: [ A PONG frame that does not echo the payload of the last keepalive PING sent shall be ignored. ]*/
+    if (uws_client->is_ping_outstanding &&
+        (length == KEEPALIVE_PING_PAYLOAD_SIZE) &&
+        (memcmp(payload, expected_payload, KEEPALIVE_PING_PAYLOAD_SIZE) == 0))
+    {
+        tickcounter_ms_t now;
+
+        /* Codes_SRS_UWS_CLIENT_02_085: [ When a PONG frame echoing the payload of the last keepalive PING is received, no PING shall be considered unanswered anymore. ]*/
+        uws_client->is_ping_outstanding = false;
+
+        /* Codes_SRS_UWS_CLIENT_02_086: [ The round trip time shall be measured by calling `tickcounter_get_current_ms` and added to the round trip time statistics. ]*/
+        if (tickcounter_get_current_ms(uws_client->tick_counter, &now) != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_087: [ If `tickcounter_get_current_ms` fails, the round trip time shall not be recorded. ]*/
+            LogError("Cannot get the current time, the round trip time of the PING is not recorded");
+        }
+        else
+        {
+            uint64_t rtt_ms = (uint64_t)(now - uws_client->ping_sent_ms);
+            size_t bucket = 0;
+
+            while ((bucket < UWS_CLIENT_RTT_HISTOGRAM_BUCKET_COUNT - 1) &&
+                ((rtt_ms >> bucket) != 0))
+            {
+                bucket++;
+            }
+
+            if ((uws_client->ping_statistics.pongs_received == 0) ||
+                (rtt_ms < uws_client->ping_statistics.rtt_min_ms))
+            {
+                uws_client->ping_statistics.rtt_min_ms = rtt_ms;
+            }
+            if (rtt_ms > uws_client->ping_statistics.rtt_max_ms)
+            {
+                uws_client->ping_statistics.rtt_max_ms = rtt_ms;
+            }
+            uws_client->ping_statistics.rtt_histogram[bucket]++;
+            uws_client->ping_statistics.pongs_received++;
+            uws_client->rtt_total_ms += rtt_ms;
+        }
+    }
+}
+
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     /* Codes_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
@@ -967,8 +1885,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, uws_client->received_bytes_count + size + 1);
-                if (new_received_bytes == NULL)
+                if (append_received_bytes(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
                     indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
@@ -976,10 +1893,6 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 else
                 {
-                    uws_client->received_bytes = new_received_bytes;
-                    (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
-                    uws_client->received_bytes_count += size;
-
                     decode_stream = 1;
                 }
 
@@ -990,8 +1903,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->received_bytes, uws_client->received_bytes_count + size + 1);
-                if (new_received_bytes == NULL)
+                if (append_received_bytes(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
                     LogError("Cannot allocate memory for received data");
@@ -1001,10 +1913,6 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 else
                 {
-                    uws_client->received_bytes = new_received_bytes;
-                    (void)memcpy(uws_client->received_bytes + uws_client->received_bytes_count, buffer, size);
-                    uws_client->received_bytes_count += size;
-                
                     decode_stream = 1;
                 }
 
@@ -1029,49 +1937,77 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
 
                 case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
                 {
-                    const char* request_end_ptr;
-
-                    /* Make sure it is zero terminated */
-                    uws_client->received_bytes[uws_client->received_bytes_count] = '\0';
-
-                    /* Codes_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
-                    if ((uws_client->received_bytes_count >= 4) &&
-                        ((request_end_ptr = strstr((const char*)uws_client->received_bytes, "\r\n\r\n")) != NULL))
+                    const char* upgrade_response = (const char*)uws_client->received_bytes + uws_client->received_bytes_offset;
+                    const char* line_end;
+                    WS_OPEN_RESULT open_result = WS_OPEN_OK;
+                    bool is_upgrade_response_complete = false;
+
+                    /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
+                    as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
+
+                    /* Codes_SRS_UWS_CLIENT_02_127: [ Only the bytes accumulated since the previous call shall be searched for the end of a line, and each line of the upgrade response shall be parsed once, as soon as it is complete. ]*/
+                    /* Codes_SRS_UWS_CLIENT_02_128: [ Lines shall be terminated by LF, optionally preceded by CR. ]*/
+                    while ((open_result == WS_OPEN_OK) &&
+                        (!is_upgrade_response_complete) &&
+                        ((line_end = (const char*)memchr(upgrade_response + uws_client->upgrade_response_scanned_length, '\n', uws_client->received_bytes_count - uws_client->upgrade_response_scanned_length)) != NULL))
                     {
-                        int status_code;
+                        const char* line = upgrade_response + uws_client->upgrade_response_line_start;
+                        const char* line_content_end = ((line_end > line) && (line_end[-1] == '\r')) ? (line_end - 1) : line_end;
 
-                        /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
-                        as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
+                        uws_client->upgrade_response_line_start = (line_end - upgrade_response) + 1;
+                        uws_client->upgrade_response_scanned_length = uws_client->upgrade_response_line_start;
 
-                        /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
-                        /* Codes_SRS_UWS_CLIENT_01_478: [ A Status-Line with a 101 response code as per RFC 2616 [RFC2616]. ]*/
-                        if (ParseHttpResponse((const char*)uws_client->received_bytes, &status_code) != 0)
+                        if (!uws_client->is_upgrade_status_line_received)
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_383: [ If the WebSocket upgrade request cannot be decoded an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
-                            LogError("Cannot decode HTTP response");
-                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE);
+                            /* Codes_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
+                            /* Codes_SRS_UWS_CLIENT_01_478: [ A Status-Line with a 101 response code as per RFC 2616 [RFC2616]. ]*/
+                            uws_client->is_upgrade_status_line_received = true;
+                            open_result = parse_upgrade_status_line(line, line_content_end);
                         }
-                        else if (status_code != 101)
+                        else if (line_content_end == line)
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_382: [ If a negative status is decoded from the WebSocket upgrade request, an error shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BAD_RESPONSE_STATUS`. ]*/
-                            LogError("Bad status (%d) received in WebSocket Upgrade response", status_code);
-                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_RESPONSE_STATUS);
+                            is_upgrade_response_complete = true;
+
+                            if (!uws_client->is_upgrade_accept_received)
+                            {
+                                /* Codes_SRS_UWS_CLIENT_02_133: [ If the upgrade response ends without a `Sec-WebSocket-Accept` header, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_110: [ If the response lacks a |Sec-WebSocket-Accept| header field or the |Sec-WebSocket-Accept| contains a value other than the base64-encoded SHA-1 of the concatenation of the |Sec-WebSocket-Key| (as a string, not base64-decoded) with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" but ignoring     any leading and trailing whitespace, the client MUST _Fail the WebSocket Connection_. ]*/
+                                LogError("No Sec-WebSocket-Accept header in WebSocket upgrade response");
+                                open_result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+                            }
+                            else
+                            {
+                                open_result = negotiate_permessage_deflate(uws_client);
+                            }
                         }
                         else
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-                            consume_received_bytes(uws_client, request_end_ptr - (char*)uws_client->received_bytes + 4);
+                            open_result = parse_upgrade_response_header(uws_client, line, line_content_end);
+                        }
+                    }
 
-                            /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
-                            uws_client->uws_state = UWS_STATE_OPEN;
+                    if (open_result != WS_OPEN_OK)
+                    {
+                        indicate_ws_open_complete_error_and_close(uws_client, open_result);
+                    }
+                    else if (!is_upgrade_response_complete)
+                    {
+                        /* the partial line is not scanned again when more bytes arrive */
+                        uws_client->upgrade_response_scanned_length = uws_client->received_bytes_count;
+                    }
+                    else
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+                        consume_received_bytes(uws_client, uws_client->upgrade_response_line_start);
 
-                            /* Codes_SRS_UWS_CLIENT_01_065: [ When the client is to _Establish a WebSocket Connection_ given a set of (/host/, /port/, /resource name/, and /secure/ flag), along with a list of /protocols/ and /extensions/ to be used, and an /origin/ in the case of web browsers, it MUST open a connection, send an opening handshake, and read the server's handshake in response. ]*/
-                            /* Codes_SRS_UWS_CLIENT_01_115: [ If the server's response is validated as provided for above, it is said that _The WebSocket Connection is Established_ and that the WebSocket Connection is in the OPEN state. ]*/
-                            uws_client->on_ws_open_complete(uws_client->on_ws_open_complete_context, WS_OPEN_OK);
+                        /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `IO_OPEN_OK`. ]*/
+                        uws_client->uws_state = UWS_STATE_OPEN;
 
-                            decode_stream = 1;
-                        }
+                        /* Codes_SRS_UWS_CLIENT_01_065: [ When the client is to _Establish a WebSocket Connection_ given a set of (/host/, /port/, /resource name/, and /secure/ flag), along with a list of /protocols/ and /extensions/ to be used, and an /origin/ in the case of web browsers, it MUST open a connection, send an opening handshake, and read the server's handshake in response. ]*/
+                        /* Codes_SRS_UWS_CLIENT_01_115: [ If the server's response is validated as provided for above, it is said that _The WebSocket Connection is Established_ and that the WebSocket Connection is in the OPEN state. ]*/
+                        uws_client->on_ws_open_complete(uws_client->on_ws_open_complete_context, WS_OPEN_OK);
+
+                        decode_stream = 1;
                     }
 
                     break;
@@ -1080,6 +2016,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 case UWS_STATE_OPEN:
                 case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
                 {
+                    /* Codes_SRS_UWS_CLIENT_02_025: [ Frames shall be decoded in place, starting at the read offset in the received bytes buffer. ]*/
+                    const unsigned char* frame_bytes = uws_client->received_bytes + uws_client->received_bytes_offset;
                     size_t needed_bytes = 2;
                     size_t length;
 
@@ -1088,19 +2026,33 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                     if (uws_client->received_bytes_count >= needed_bytes)
                     {
                         unsigned char has_error = 0;
+                        unsigned char length_decoded = 0;
 
                         /* Codes_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-                        if ((uws_client->received_bytes[1] & 0x80) != 0)
+                        if ((frame_bytes[1] & 0x80) != 0)
                         {
                             /* Codes_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
                             /* Codes_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
                             LogError("Masked frame detected by WebSocket client");
                             indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
                         }
+                        else if (((frame_bytes[0] & 0x70) != 0) &&
+                            (((frame_bytes[0] & 0x70) != (RESERVED_1 << 4)) ||
+                             (uws_client->deflate == NULL) ||
+                             ((frame_bytes[0] & 0xF) == (unsigned char)WS_CONTINUATION_FRAME) ||
+                             ((frame_bytes[0] & 0xF) > (unsigned char)WS_BINARY_FRAME)))
+                        {
+                            /* Codes_SRS_UWS_CLIENT_01_149: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+                            /* Codes_SRS_UWS_CLIENT_01_150: [ If a nonzero value is received and none of the negotiated extensions defines the meaning of such a nonzero value, the receiving endpoint MUST _Fail the WebSocket Connection_. ]*/
+                            /* Codes_SRS_UWS_CLIENT_02_053: [ If a frame is received with RSV2 or RSV3 set, or with RSV1 set while permessage-deflate was not negotiated or on a frame that is not the first frame of a text or binary message, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+                            LogError("Frame received with unexpected reserved bits 0x%02x", (unsigned int)((frame_bytes[0] & 0x70) >> 4));
+                            indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, CLOSE_PROTOCOL_ERROR);
+                            has_error = 1;
+                        }
 
                         /* Codes_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
                         /* Codes_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-                        length = uws_client->received_bytes[1];
+                        length = frame_bytes[1];
 
                         if (length == 126)
                         {
@@ -1109,7 +2061,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             if (uws_client->received_bytes_count >= needed_bytes)
                             {
                                 /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                length = ((uint64_t)(uws_client->received_bytes[2]) << 8) + uws_client->received_bytes[3];
+                                length = ((uint64_t)(frame_bytes[2]) << 8) + frame_bytes[3];
 
                                 if (length < 126)
                                 {
@@ -1123,6 +2075,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 else
                                 {
                                     needed_bytes += (size_t)length;
+                                    length_decoded = 1;
                                 }
                             }
                         }
@@ -1132,7 +2085,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             needed_bytes += 8;
                             if (uws_client->received_bytes_count >= needed_bytes)
                             {
-                                if ((uws_client->received_bytes[2] & 0x80) != 0)
+                                if ((frame_bytes[2] & 0x80) != 0)
                                 {
                                     LogError("Bad frame: received a 64 bit length frame with the highest bit set");
 
@@ -1143,14 +2096,14 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 else
                                 {
                                     /* Codes_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-                                    length = (size_t)(((uint64_t)(uws_client->received_bytes[2]) << 56) +
-                                        (((uint64_t)uws_client->received_bytes[3]) << 48) +
-                                        (((uint64_t)uws_client->received_bytes[4]) << 40) +
-                                        (((uint64_t)uws_client->received_bytes[5]) << 32) +
-                                        (((uint64_t)uws_client->received_bytes[6]) << 24) +
-                                        (((uint64_t)uws_client->received_bytes[7]) << 16) +
-                                        (((uint64_t)uws_client->received_bytes[8]) << 8) +
-                                        (uint64_t)(uws_client->received_bytes[9]));
+                                    length = (size_t)(((uint64_t)(frame_bytes[2]) << 56) +
+                                        (((uint64_t)frame_bytes[3]) << 48) +
+                                        (((uint64_t)frame_bytes[4]) << 40) +
+                                        (((uint64_t)frame_bytes[5]) << 32) +
+                                        (((uint64_t)frame_bytes[6]) << 24) +
+                                        (((uint64_t)frame_bytes[7]) << 16) +
+                                        (((uint64_t)frame_bytes[8]) << 8) +
+                                        (uint64_t)(frame_bytes[9]));
 
                                     if (length < 65536)
                                     {
@@ -1164,6 +2117,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     else
                                     {
                                         needed_bytes += length;
+                                        length_decoded = 1;
                                     }
                                 }
                             }
@@ -1171,18 +2125,49 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         else
                         {
                             needed_bytes += length;
+                            length_decoded = 1;
+                        }
+
+                        if ((has_error == 0) &&
+                            (length_decoded != 0) &&
+                            ((frame_bytes[0] & 0xF) <= (unsigned char)WS_BINARY_FRAME))
+                        {
+                            /* only the fragments that are kept for reassembly count towards the size of the message */
+                            size_t message_length = (((frame_bytes[0] & 0xF) == (unsigned char)WS_CONTINUATION_FRAME) &&
+                                (uws_client->fragmented_message_type != 0) &&
+                                !uws_client->fragmented_message_is_streamed) ? uws_client->fragmented_message_length : 0;
+
+                            if (length > uws_client->max_message_size - message_length)
+                            {
+                                /* Codes_SRS_UWS_CLIENT_01_359: [ Implementations that have implementation- and/or platform-specific limitations regarding the frame size or total message size after reassembly from multiple frames MUST protect themselves against exceeding those limits. ]*/
+                                /* Codes_SRS_UWS_CLIENT_02_042: [ As soon as the length of a data frame is decoded, if the frame payload together with the bytes already accumulated for the message it belongs to exceeds the maximum message size, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_MESSAGE_TOO_BIG` and a CLOSE frame with status code 1009 shall be sent. ]*/
+                                LogError("Message too big: %lu bytes, the maximum is %lu", (unsigned long)(message_length + length), (unsigned long)uws_client->max_message_size);
+                                indicate_ws_error_and_close(uws_client, WS_ERROR_MESSAGE_TOO_BIG, CLOSE_MESSAGE_TOO_BIG);
+                                has_error = 1;
+                            }
                         }
 
                         if ((has_error == 0) &&
                             (uws_client->received_bytes_count >= needed_bytes))
                         {
-                            unsigned char opcode = uws_client->received_bytes[0] & 0xF;
+                            unsigned char opcode = frame_bytes[0] & 0xF;
+                            /* Codes_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
+                            bool is_final = ((frame_bytes[0] & 0x80) != 0);
+                            /* Codes_SRS_UWS_CLIENT_02_054: [ A text or binary frame with the RSV1 bit set shall start a compressed message. ]*/
+                            bool is_compressed = ((frame_bytes[0] & (RESERVED_1 << 4)) != 0);
 
                             switch (opcode)
                             {
                             default:
                                 break;
 
+                                /* Codes_SRS_UWS_CLIENT_01_152: [ *  %x0 denotes a continuation frame ]*/
+                            case (unsigned char)WS_CONTINUATION_FRAME:
+                                /* Codes_SRS_UWS_CLIENT_01_283: [ If the frame is part of a fragmented message, the "Application data" of the subsequent data frames is concatenated to form the /data/. ]*/
+                                on_continuation_frame_received(uws_client, is_final, frame_bytes + needed_bytes - length, length);
+                                decode_stream = 1;
+                                break;
+
                                 /* Codes_SRS_UWS_CLIENT_01_153: [ *  %x1 denotes a text frame ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_258: [** Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
                             case (unsigned char)WS_TEXT_FRAME:
@@ -1192,7 +2177,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-                                uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, uws_client->received_bytes + needed_bytes - length, length);
+                                on_data_frame_received(uws_client, WS_FRAME_TYPE_TEXT, is_final, is_compressed, frame_bytes + needed_bytes - length, length);
                                 decode_stream = 1;
                                 break;
 
@@ -1205,7 +2190,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-                                uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, uws_client->received_bytes + needed_bytes - length, length);
+                                on_data_frame_received(uws_client, WS_FRAME_TYPE_BINARY, is_final, is_compressed, frame_bytes + needed_bytes - length, length);
                                 decode_stream = 1;
                                 break;
 
@@ -1215,7 +2200,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             {
                                 uint16_t close_code;
                                 uint16_t* close_code_ptr;
-                                const unsigned char* data_ptr = uws_client->received_bytes + needed_bytes - length;
+                                const unsigned char* data_ptr = frame_bytes + needed_bytes - length;
                                 const unsigned char* extra_data_ptr;
                                 size_t extra_data_length;
                                 unsigned char* close_frame_bytes;
@@ -1346,10 +2331,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 size_t pong_frame_length;
                                 BUFFER_HANDLE pong_frame_buffer;
 
-                                uws_client->uws_state = UWS_STATE_ERROR;
-
                                 /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-                                pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, uws_client->received_bytes + needed_bytes - length, length, true, true, 0);
+                                pong_frame_buffer = uws_frame_encoder_encode(WS_PONG_FRAME, frame_bytes + needed_bytes - length, length, true, true, 0);
                                 if (pong_frame_buffer == NULL)
                                 {
                                     LogError("Encoding of PONG failed.");
@@ -1367,10 +2350,16 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     BUFFER_delete(pong_frame_buffer);
                                 }
 
+                                /* Codes_SRS_UWS_CLIENT_01_218: [ An endpoint MUST be capable of handling control frames in the middle of a fragmented message. ]*/
+                                decode_stream = 1;
                                 break;
                             }
                             /* Codes_SRS_UWS_CLIENT_01_252: [ The Pong frame contains an opcode of 0xA. ]*/
                             case (unsigned char)WS_PONG_FRAME:
+                                on_keepalive_pong_received(uws_client, frame_bytes + needed_bytes - length, length);
+
+                                /* Codes_SRS_UWS_CLIENT_02_155: [ After a PONG frame, the frames that follow it in the received bytes shall be decoded. ]*/
+                                decode_stream = 1;
                                 break;
                             }
 
@@ -1451,7 +2440,38 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
         {
             uws_client->uws_state = UWS_STATE_OPENING_UNDERLYING_IO;
 
+            uws_client->received_bytes_offset = 0;
             uws_client->received_bytes_count = 0;
+            uws_client->upgrade_response_line_start = 0;
+            uws_client->upgrade_response_scanned_length = 0;
+            uws_client->is_upgrade_status_line_received = false;
+            uws_client->is_upgrade_accept_received = false;
+            uws_client->permessage_deflate_response.is_accepted = false;
+            uws_client->permessage_deflate_response.client_max_window_bits = 15;
+            uws_client->permessage_deflate_response.server_max_window_bits = 15;
+            uws_client->permessage_deflate_response.client_no_context_takeover = false;
+            uws_client->permessage_deflate_response.server_no_context_takeover = false;
+            uws_client->fragmented_message_type = 0;
+            uws_client->fragmented_message_length = 0;
+            uws_client->fragmented_message_is_compressed = false;
+
+            if (uws_client->deflate != NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_060: [ `uws_client_open_async` shall destroy the compressor negotiated for a previous connection, if any, and reset the compression statistics. ]*/
+                uws_deflate_destroy(uws_client->deflate);
+                uws_client->deflate = NULL;
+            }
+            (void)memset(&uws_client->compression_statistics, 0, sizeof(uws_client->compression_statistics));
+
+            /* Codes_SRS_UWS_CLIENT_02_073: [ `uws_client_open_async` shall reset the keepalive PING state and the round trip time statistics. ]*/
+            uws_client->is_ping_timer_started = false;
+            uws_client->is_ping_outstanding = false;
+            (void)memset(&uws_client->ping_statistics, 0, sizeof(uws_client->ping_statistics));
+            uws_client->rtt_total_ms = 0;
+
+            uws_client->coalesce_buffer_length = 0;
+            uws_client->first_coalesced_send = NULL;
+            uws_client->last_coalesced_send = NULL;
 
             uws_client->on_ws_open_complete = on_ws_open_complete;
             uws_client->on_ws_open_complete_context = on_ws_open_complete_context;
@@ -1484,27 +2504,103 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
     return result;
 }
 
-static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, LIST_ITEM_HANDLE pending_send_frame_item, WS_SEND_FRAME_RESULT ws_send_frame_result)
+static WS_PENDING_SEND* get_pending_send(UWS_CLIENT_INSTANCE* uws_client)
+{
+    WS_PENDING_SEND* result = uws_client->pooled_sends;
+
+    if (result != NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_142: [ If a pending send record kept from an earlier send is available, it shall be reused instead of allocating memory for the newly queued item. ]*/
+        uws_client->pooled_sends = result->next_pooled_send;
+        uws_client->pooled_send_count--;
+    }
+    else
+    {
+        result = (WS_PENDING_SEND*)malloc(sizeof(WS_PENDING_SEND));
+    }
+
+    if (result != NULL)
+    {
+        result->list_item = NULL;
+        result->is_coalesced = false;
+        result->is_held_by_underlying_io = false;
+        result->is_detached = false;
+    }
+
+    return result;
+}
+
+static void release_pending_send(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send)
+{
+    if (uws_client->pooled_send_count < UWS_CLIENT_MAX_POOLED_PENDING_SENDS)
+    {
+        ws_pending_send->next_pooled_send = uws_client->pooled_sends;
+        uws_client->pooled_sends = ws_pending_send;
+        uws_client->pooled_send_count++;
+    }
+    else
+    {
+        free(ws_pending_send);
+    }
+}
+
+static void unlink_detached_send(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send)
+{
+    WS_PENDING_SEND** detached_send = &uws_client->detached_sends;
+
+    while (*detached_send != NULL)
+    {
+        if (*detached_send == ws_pending_send)
+        {
+            *detached_send = ws_pending_send->next_detached_send;
+            break;
+        }
+
+        detached_send = &(*detached_send)->next_detached_send;
+    }
+
+    ws_pending_send->is_detached = false;
+}
+
+static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
 {
     int result;
     UWS_CLIENT_INSTANCE* uws_client = ws_pending_send->uws_client;
 
     /* Codes_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling `singlylinkedlist_remove`. ]*/
-    if (singlylinkedlist_remove(uws_client->pending_sends, pending_send_frame_item) != 0)
+    if ((ws_pending_send->list_item != NULL) &&
+        (singlylinkedlist_remove(uws_client->pending_sends, ws_pending_send->list_item) != 0))
     {
         LogError("Failed removing item from list");
         result = __FAILURE__;
     }
     else
     {
-        if (ws_pending_send->on_ws_send_frame_complete != NULL)
+        ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete = ws_pending_send->on_ws_send_frame_complete;
+        void* context = ws_pending_send->context;
+
+        ws_pending_send->list_item = NULL;
+        if (ws_pending_send->is_detached)
         {
-            /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the `on_ws_send_frame_complete` callback shall be the context given to `uws_client_send_frame_async`. ]*/
-            ws_pending_send->on_ws_send_frame_complete(ws_pending_send->context, ws_send_frame_result);
+            unlink_detached_send(uws_client, ws_pending_send);
         }
 
-        /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
-        free(ws_pending_send);
+        if (uws_client->send_in_progress == ws_pending_send)
+        {
+            /* completed from within its own xio_send, the sender releases it once xio_send returns */
+            uws_client->send_in_progress = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed, unless fewer than `UWS_CLIENT_MAX_POOLED_PENDING_SENDS` records are kept for reuse, in which case it shall be kept for reuse by a later send. ]*/
+            release_pending_send(uws_client, ws_pending_send);
+        }
+
+        if (on_ws_send_frame_complete != NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the `on_ws_send_frame_complete` callback shall be the context given to `uws_client_send_frame_async`. ]*/
+            on_ws_send_frame_complete(context, ws_send_frame_result);
+        }
 
         result = 0;
     }
@@ -1512,24 +2608,67 @@ static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, LIST_ITEM_HANDL
     return result;
 }
 
-/* Codes_SRS_UWS_CLIENT_01_029: [ `uws_client_close_async` shall close the uws instance connection if an open action is either pending or has completed successfully (if the IO is open). ]*/
-/* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
-int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
+/* cancels a pending send when the uws instance is closed, a frame the underlying IO holds is kept until its send completes */
+static int cancel_pending_send(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send)
 {
     int result;
 
-    /* Codes_SRS_UWS_CLIENT_01_397: [ The `on_ws_close_complete` argument shall be allowed to be NULL, in which case no callback shall be called when the close is complete. ]*/
-    /* Codes_SRS_UWS_CLIENT_01_398: [ `on_ws_close_complete_context` shall also be allows to be NULL. ]*/
-    if (uws_client == NULL)
+    if (!ws_pending_send->is_held_by_underlying_io)
     {
-        /* Codes_SRS_UWS_CLIENT_01_030: [ if `uws_client` is NULL, `uws_client_close_async` shall return a non-zero value. ]*/
-        LogError("NULL uWS handle.");
+        /* Codes_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with `UWS_SEND_FRAME_CANCELLED`. ]*/
+        result = complete_send_frame(ws_pending_send, WS_SEND_FRAME_CANCELLED);
+    }
+    /* Codes_SRS_UWS_CLIENT_02_158: [ When the pending sends are cancelled, frames already passed to `xio_send` shall only be removed from the pending sends by calling `singlylinkedlist_remove`, and shall not be reused before the underlying IO completes their send. ]*/
+    else if (singlylinkedlist_remove(uws_client->pending_sends, ws_pending_send->list_item) != 0)
+    {
+        LogError("Failed removing item from list");
         result = __FAILURE__;
     }
     else
     {
-        if ((uws_client->uws_state == UWS_STATE_CLOSED) ||
-            (uws_client->uws_state == UWS_STATE_CLOSING_SENDING_CLOSE) ||
+        ws_pending_send->list_item = NULL;
+        ws_pending_send->is_detached = true;
+        ws_pending_send->next_detached_send = uws_client->detached_sends;
+        uws_client->detached_sends = ws_pending_send;
+
+        if (!ws_pending_send->is_coalesced)
+        {
+            ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete = ws_pending_send->on_ws_send_frame_complete;
+
+            /* Codes_SRS_UWS_CLIENT_02_159: [ Such a frame that was not coalesced shall be indicated as cancelled right away, and its send completion shall only release it. ]*/
+            ws_pending_send->on_ws_send_frame_complete = NULL;
+            if (on_ws_send_frame_complete != NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with `UWS_SEND_FRAME_CANCELLED`. ]*/
+                on_ws_send_frame_complete(ws_pending_send->context, WS_SEND_FRAME_CANCELLED);
+            }
+        }
+
+        /* Codes_SRS_UWS_CLIENT_02_160: [ Coalesced frames shall be completed and released by `on_underlying_io_coalesced_send_complete`. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Codes_SRS_UWS_CLIENT_01_029: [ `uws_client_close_async` shall close the uws instance connection if an open action is either pending or has completed successfully (if the IO is open). ]*/
+/* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
+int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
+{
+    int result;
+
+    /* Codes_SRS_UWS_CLIENT_01_397: [ The `on_ws_close_complete` argument shall be allowed to be NULL, in which case no callback shall be called when the close is complete. ]*/
+    /* Codes_SRS_UWS_CLIENT_01_398: [ `on_ws_close_complete_context` shall also be allows to be NULL. ]*/
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_030: [ if `uws_client` is NULL, `uws_client_close_async` shall return a non-zero value. ]*/
+        LogError("NULL uWS handle.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((uws_client->uws_state == UWS_STATE_CLOSED) ||
+            (uws_client->uws_state == UWS_STATE_CLOSING_SENDING_CLOSE) ||
             (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE) ||
             (uws_client->uws_state == UWS_STATE_CLOSING_UNDERLYING_IO))
         {
@@ -1563,10 +2702,17 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
                 {
                     WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
 
-                    /* Codes_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with `UWS_SEND_FRAME_CANCELLED`. ]*/
-                    complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
+                    if (cancel_pending_send(uws_client, ws_pending_send) != 0)
+                    {
+                        break;
+                    }
                 }
 
+                /* Codes_SRS_UWS_CLIENT_02_096: [ The frames in the coalesce buffer shall be discarded, as their pending sends were cancelled. ]*/
+                uws_client->coalesce_buffer_length = 0;
+                uws_client->first_coalesced_send = NULL;
+                uws_client->last_coalesced_send = NULL;
+
                 /* Codes_SRS_UWS_CLIENT_01_396: [ On success `uws_client_close_async` shall return 0. ]*/
                 result = 0;
             }
@@ -1577,6 +2723,173 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
 }
 
 /* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
+static WS_SEND_FRAME_RESULT get_ws_send_frame_result(IO_SEND_RESULT send_result)
+{
+    WS_SEND_FRAME_RESULT ws_send_frame_result;
+
+    switch (send_result)
+    {
+    /* Codes_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+    default:
+    case IO_SEND_ERROR:
+        /* Codes_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+        ws_send_frame_result = WS_SEND_FRAME_ERROR;
+        break;
+
+    case IO_SEND_OK:
+        /* Codes_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
+        ws_send_frame_result = WS_SEND_FRAME_OK;
+        break;
+
+    case IO_SEND_CANCELLED:
+        /* Codes_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
+        ws_send_frame_result = WS_SEND_FRAME_CANCELLED;
+        break;
+    }
+
+    return ws_send_frame_result;
+}
+
+static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    if (context == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_435: [ When `on_underlying_io_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
+        LogError("on_underlying_io_send_complete called with NULL context");
+    }
+    else
+    {
+        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)context;
+        UWS_CLIENT_HANDLE uws_client = ws_pending_send->uws_client;
+
+        ws_pending_send->is_held_by_underlying_io = false;
+        if (complete_send_frame(ws_pending_send, get_ws_send_frame_result(send_result)) != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
+            indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+        }
+    }
+}
+
+static void complete_coalesced_sends(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* first_coalesced_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    WS_PENDING_SEND* ws_pending_send;
+    bool is_remove_failed = false;
+
+    /* Codes_SRS_UWS_CLIENT_02_098: [ All the coalesced frames shall be removed from the pending sends by calling `singlylinkedlist_remove` before any of their callbacks is called. ]*/
+    for (ws_pending_send = first_coalesced_send; ws_pending_send != NULL; ws_pending_send = ws_pending_send->next_coalesced_send)
+    {
+        if (ws_pending_send->list_item == NULL)
+        {
+            /* already removed when the pending sends were cancelled by a close */
+        }
+        else if (singlylinkedlist_remove(uws_client->pending_sends, ws_pending_send->list_item) != 0)
+        {
+            LogError("Failed removing item from list");
+            is_remove_failed = true;
+        }
+        else
+        {
+            ws_pending_send->list_item = NULL;
+        }
+    }
+
+    ws_pending_send = first_coalesced_send;
+    while (ws_pending_send != NULL)
+    {
+        WS_PENDING_SEND* next_coalesced_send = ws_pending_send->next_coalesced_send;
+
+        if (ws_pending_send->list_item == NULL)
+        {
+            ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete = ws_pending_send->on_ws_send_frame_complete;
+            void* context = ws_pending_send->context;
+
+            if (ws_pending_send->is_detached)
+            {
+                unlink_detached_send(uws_client, ws_pending_send);
+            }
+
+            /* Codes_SRS_UWS_CLIENT_02_099: [ Then, in the order the frames were queued, `on_ws_send_frame_complete` of each removed frame shall be called with its own context and the result of the send, and the memory associated with the frame shall be released like for `on_underlying_io_send_complete`. ]*/
+            release_pending_send(uws_client, ws_pending_send);
+
+            if (on_ws_send_frame_complete != NULL)
+            {
+                on_ws_send_frame_complete(context, ws_send_frame_result);
+            }
+        }
+
+        ws_pending_send = next_coalesced_send;
+    }
+
+    if (is_remove_failed)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_100: [ If `singlylinkedlist_remove` fails for any of the frames an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
+        indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+    }
+}
+
+static void on_underlying_io_coalesced_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    if (context == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_101: [ When `on_underlying_io_coalesced_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
+        LogError("on_underlying_io_coalesced_send_complete called with NULL context");
+    }
+    else
+    {
+        WS_PENDING_SEND* first_coalesced_send = (WS_PENDING_SEND*)context;
+        UWS_CLIENT_INSTANCE* uws_client = first_coalesced_send->uws_client;
+
+        if (uws_client->coalesced_send_in_progress == first_coalesced_send)
+        {
+            uws_client->coalesced_send_in_progress = NULL;
+        }
+
+        /* Codes_SRS_UWS_CLIENT_02_102: [ When `on_underlying_io_coalesced_send_complete` is called, every frame that was part of the coalesced send shall be completed with the `IO_SEND_RESULT` mapped the same way as for `on_underlying_io_send_complete`. ]*/
+        complete_coalesced_sends(uws_client, first_coalesced_send, get_ws_send_frame_result(send_result));
+    }
+}
+
+/* sends the coalesce buffer with a single xio_send, the frames in it complete together */
+static int send_coalesced_frames(UWS_CLIENT_INSTANCE* uws_client)
+{
+    int result;
+    WS_PENDING_SEND* first_coalesced_send = uws_client->first_coalesced_send;
+    WS_PENDING_SEND* ws_pending_send;
+    size_t coalesce_buffer_length = uws_client->coalesce_buffer_length;
+
+    /* the buffer is emptied before xio_send, so that frames queued from a callback fired by xio_send start a new batch */
+    uws_client->coalesce_buffer_length = 0;
+    uws_client->first_coalesced_send = NULL;
+    uws_client->last_coalesced_send = NULL;
+    uws_client->coalesced_send_in_progress = first_coalesced_send;
+    for (ws_pending_send = first_coalesced_send; ws_pending_send != NULL; ws_pending_send = ws_pending_send->next_coalesced_send)
+    {
+        ws_pending_send->is_held_by_underlying_io = true;
+    }
+
+    /* Codes_SRS_UWS_CLIENT_02_103: [ Sending the coalesced frames shall be done by calling `xio_send` once with the coalesce buffer, its used length, `on_underlying_io_coalesced_send_complete` as callback and the first coalesced frame as context. ]*/
+    if (xio_send(uws_client->underlying_io, uws_client->coalesce_buffer, coalesce_buffer_length, on_underlying_io_coalesced_send_complete, first_coalesced_send) != 0)
+    {
+        LogError("Could not send the coalesced frames");
+
+        /* Codes_SRS_UWS_CLIENT_02_104: [ If `xio_send` fails and did not complete the send, all the coalesced frames shall be completed with `WS_SEND_FRAME_ERROR`. ]*/
+        if (uws_client->coalesced_send_in_progress == first_coalesced_send)
+        {
+            uws_client->coalesced_send_in_progress = NULL;
+            complete_coalesced_sends(uws_client, first_coalesced_send, WS_SEND_FRAME_ERROR);
+        }
+
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
 int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t close_code, const char* close_reason, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
 {
     int result;
@@ -1609,6 +2922,13 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
             uws_client->on_ws_close_complete = on_ws_close_complete;
             uws_client->on_ws_close_complete_context = on_ws_close_complete_context;
 
+            /* Codes_SRS_UWS_CLIENT_02_097: [ If frames were coalesced and the uws instance is OPEN, `uws_client_close_handshake_async` shall send them before the CLOSE frame, so that they reach the peer ahead of it. ]*/
+            if ((uws_client->first_coalesced_send != NULL) &&
+                (uws_client->uws_state == UWS_STATE_OPEN))
+            {
+                (void)send_coalesced_frames(uws_client);
+            }
+
             uws_client->uws_state = UWS_STATE_CLOSING_WAITING_FOR_CLOSE;
 
             /* Codes_SRS_UWS_CLIENT_01_465: [ `uws_client_close_handshake_async` shall initiate the close handshake by sending a close frame to the peer. ]*/
@@ -1626,9 +2946,17 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
                 {
                     WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
 
-                    complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
+                    if (cancel_pending_send(uws_client, ws_pending_send) != 0)
+                    {
+                        break;
+                    }
                 }
 
+                /* Codes_SRS_UWS_CLIENT_02_157: [ Frames still in the coalesce buffer shall be discarded, as their pending sends were cancelled. ]*/
+                uws_client->coalesce_buffer_length = 0;
+                uws_client->first_coalesced_send = NULL;
+                uws_client->last_coalesced_send = NULL;
+
                 /* Codes_SRS_UWS_CLIENT_01_466: [ On success `uws_client_close_handshake_async` shall return 0. ]*/
                 result = 0;
             }
@@ -1638,51 +2966,412 @@ int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t clos
     return result;
 }
 
-static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+/* encodes a frame at the end of the coalesce buffer, it is sent with the other coalesced frames from uws_client_dowork */
+static int coalesce_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, const unsigned char* payload, size_t size, bool is_final, unsigned char reserved, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
 {
-    if (context == NULL)
+    int result;
+    WS_PENDING_SEND* ws_pending_send;
+
+    if ((uws_client->first_coalesced_send != NULL) &&
+        (uws_client->coalesce_buffer_length + UWS_FRAME_ENCODER_MAX_HEADER_SIZE + size > UWS_CLIENT_COALESCE_BUFFER_SIZE) &&
+        /* Codes_SRS_UWS_CLIENT_02_107: [ If the frame does not fit in the space left in the coalesce buffer, the frames already coalesced shall be sent first. ]*/
+        (send_coalesced_frames(uws_client) != 0))
     {
-        /* Codes_SRS_UWS_CLIENT_01_435: [ When `on_underlying_io_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
-        LogError("on_underlying_io_send_complete called with NULL context");
+        /* Codes_SRS_UWS_CLIENT_02_108: [ If sending the frames already coalesced fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not make room in the coalesce buffer");
+        result = __FAILURE__;
+    }
+    else if ((uws_client->coalesce_buffer == NULL) &&
+        /* Codes_SRS_UWS_CLIENT_02_109: [ The first time a frame is coalesced a buffer of `UWS_CLIENT_COALESCE_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+        ((uws_client->coalesce_buffer = (unsigned char*)malloc(UWS_CLIENT_COALESCE_BUFFER_SIZE)) == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_110: [ If allocating the coalesce buffer fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Cannot allocate the coalesce buffer");
+        result = __FAILURE__;
+    }
+    else if ((ws_pending_send = get_pending_send(uws_client)) == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_111: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Cannot allocate memory for frame to be sent.");
+        result = __FAILURE__;
     }
     else
     {
-        LIST_ITEM_HANDLE ws_pending_send_list_item = (LIST_ITEM_HANDLE)context;
-        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(ws_pending_send_list_item);
-        UWS_CLIENT_HANDLE uws_client = ws_pending_send->uws_client;
-        WS_SEND_FRAME_RESULT ws_send_frame_result;
+        unsigned char* frame = uws_client->coalesce_buffer + uws_client->coalesce_buffer_length;
+        size_t header_length;
 
-        switch (send_result)
+        /* Codes_SRS_UWS_CLIENT_02_112: [ The frame header shall be encoded at the end of the coalesce buffer by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and the reserved bits. ]*/
+        if (uws_frame_encoder_encode_header(frame, UWS_CLIENT_COALESCE_BUFFER_SIZE - uws_client->coalesce_buffer_length, (WS_FRAME_TYPE)frame_type, size, true, is_final, reserved, &header_length) != 0)
         {
-        /* Codes_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-        default:
-        case IO_SEND_ERROR:
-            /* Codes_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_ERROR;
-            break;
+            /* Codes_SRS_UWS_CLIENT_02_113: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+            LogError("Failed encoding WebSocket frame header");
+            release_pending_send(uws_client, ws_pending_send);
+            result = __FAILURE__;
+        }
+        else
+        {
+            ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
+            ws_pending_send->context = on_ws_send_frame_complete_context;
+            ws_pending_send->uws_client = uws_client;
+            ws_pending_send->is_coalesced = true;
+            ws_pending_send->next_coalesced_send = NULL;
+
+            /* Codes_SRS_UWS_CLIENT_02_114: [ The frame shall be queued in the pending sends by calling `singlylinkedlist_add`. ]*/
+            ws_pending_send->list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
+            if (ws_pending_send->list_item == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_115: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                LogError("Could not allocate memory for pending frames");
+                release_pending_send(uws_client, ws_pending_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_116: [ The payload shall be masked into the coalesce buffer right after the header by calling `uws_frame_encoder_mask` with the mask written in the header and a mask offset of 0. ]*/
+                uws_frame_encoder_mask(frame + header_length, payload, size, frame + header_length - 4, 0);
+                uws_client->coalesce_buffer_length += header_length + size;
 
-        case IO_SEND_OK:
-            /* Codes_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_OK;
-            break;
+                if (uws_client->last_coalesced_send == NULL)
+                {
+                    uws_client->first_coalesced_send = ws_pending_send;
+                }
+                else
+                {
+                    uws_client->last_coalesced_send->next_coalesced_send = ws_pending_send;
+                }
+                uws_client->last_coalesced_send = ws_pending_send;
 
-        case IO_SEND_CANCELLED:
-            /* Codes_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
-            ws_send_frame_result = WS_SEND_FRAME_CANCELLED;
-            break;
+                /* Codes_SRS_UWS_CLIENT_02_117: [ On success, `uws_client_send_frame_async` shall return 0 without calling `xio_send`. ]*/
+                result = 0;
+            }
         }
+    }
 
-        if (complete_send_frame(ws_pending_send, ws_pending_send_list_item, ws_send_frame_result) != 0)
+    return result;
+}
+
+/* sends a frame without building it in a new buffer: the header is encoded on the stack and the payload is either masked
+   in place (in_place is true, payload is then in_place_payload) or masked into the scratch buffer one piece at a time */
+static int send_frame_in_pieces(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, const unsigned char* payload, unsigned char* in_place_payload, bool in_place, size_t size, bool is_final, unsigned char reserved, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
+{
+    int result;
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+
+    if ((!in_place) &&
+        (uws_client->send_scratch_buffer == NULL) &&
+        /* Codes_SRS_UWS_CLIENT_02_003: [ The first time such a frame is sent a scratch buffer of `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+        ((uws_client->send_scratch_buffer = (unsigned char*)malloc(UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE)) == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_004: [ If allocating the scratch buffer fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Cannot allocate the send scratch buffer");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_UWS_CLIENT_02_001: [ If the header and payload of the frame do not fit in `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes, `uws_client_send_frame_async` shall not call `uws_frame_encoder_encode` and shall instead encode only the header in a stack buffer of `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and no reserved bits. ]*/
+    /* Codes_SRS_UWS_CLIENT_02_010: [ The header shall be encoded in a stack buffer of `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and no reserved bits. ]*/
+    else if (uws_frame_encoder_encode_header(header, sizeof(header), (WS_FRAME_TYPE)frame_type, size, true, is_final, reserved, &header_length) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_002: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        /* Codes_SRS_UWS_CLIENT_02_016: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+        LogError("Failed encoding WebSocket frame header");
+        result = __FAILURE__;
+    }
+    else
+    {
+        WS_PENDING_SEND* ws_pending_send = get_pending_send(uws_client);
+        if (ws_pending_send == NULL)
         {
-            /* Codes_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
-            indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+            /* Codes_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+            /* Codes_SRS_UWS_CLIENT_02_017: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate memory for frame to be sent.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            LIST_ITEM_HANDLE new_pending_send_list_item;
+
+            ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
+            ws_pending_send->context = on_ws_send_frame_complete_context;
+            ws_pending_send->uws_client = uws_client;
+
+            new_pending_send_list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
+            if (new_pending_send_list_item == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                /* Codes_SRS_UWS_CLIENT_02_018: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+                LogError("Could not allocate memory for pending frames");
+                release_pending_send(uws_client, ws_pending_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                const unsigned char* mask_key = header + header_length - 4;
+                WS_PENDING_SEND* previous_send_in_progress = uws_client->send_in_progress;
+                bool is_completed;
+                bool is_partially_sent = false;
+                int send_result;
+
+                ws_pending_send->list_item = new_pending_send_list_item;
+                ws_pending_send->is_held_by_underlying_io = true;
+                uws_client->send_in_progress = ws_pending_send;
+
+                if (in_place)
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_011: [ The payload shall be masked in place by calling `uws_frame_encoder_mask` with `buffer` as both destination and source and the masking key found in the last 4 bytes of the header. ]*/
+                    uws_frame_encoder_mask(in_place_payload, in_place_payload, size, mask_key, 0);
+
+                    if (size == 0)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_02_013: [ If `size` is 0 only the header shall be sent, with `on_underlying_io_send_complete` and the pending send as callback and context. ]*/
+                        send_result = xio_send(uws_client->underlying_io, header, header_length, on_underlying_io_send_complete, ws_pending_send);
+                    }
+                    /* Codes_SRS_UWS_CLIENT_02_012: [ The header shall be sent by calling `xio_send` with a NULL callback, followed by `buffer` sent by calling `xio_send` with `on_underlying_io_send_complete` and the pending send as callback and context. ]*/
+                    else if (xio_send(uws_client->underlying_io, header, header_length, NULL, NULL) != 0)
+                    {
+                        send_result = __FAILURE__;
+                    }
+                    else
+                    {
+                        is_partially_sent = true;
+                        send_result = xio_send(uws_client->underlying_io, in_place_payload, size, on_underlying_io_send_complete, ws_pending_send);
+                    }
+                }
+                else
+                {
+                    size_t masked_bytes = ((UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE - header_length) < size) ? (UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE - header_length) : size;
+
+                    /* Codes_SRS_UWS_CLIENT_02_005: [ The header followed by as many payload bytes as fit, masked by calling `uws_frame_encoder_mask`, shall be sent from the scratch buffer with one `xio_send` call; the rest of the payload shall be masked into the scratch buffer and sent in pieces of at most `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes, passing to `uws_frame_encoder_mask` the position of each piece in the payload as offset. ]*/
+                    /* Codes_SRS_UWS_CLIENT_02_006: [ Only the `xio_send` call carrying the last bytes of the frame shall be given `on_underlying_io_send_complete` and the pending send as callback and context, the others shall be given a NULL callback. ]*/
+                    (void)memcpy(uws_client->send_scratch_buffer, header, header_length);
+                    uws_frame_encoder_mask(uws_client->send_scratch_buffer + header_length, payload, masked_bytes, mask_key, 0);
+                    send_result = xio_send(uws_client->underlying_io, uws_client->send_scratch_buffer, header_length + masked_bytes,
+                        (masked_bytes == size) ? on_underlying_io_send_complete : NULL, (masked_bytes == size) ? ws_pending_send : NULL);
+
+                    while ((send_result == 0) &&
+                        (masked_bytes < size))
+                    {
+                        size_t piece_length = ((size - masked_bytes) < UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE) ? (size - masked_bytes) : UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE;
+
+                        is_partially_sent = true;
+                        uws_frame_encoder_mask(uws_client->send_scratch_buffer, payload + masked_bytes, piece_length, mask_key, masked_bytes);
+                        masked_bytes += piece_length;
+                        send_result = xio_send(uws_client->underlying_io, uws_client->send_scratch_buffer, piece_length,
+                            (masked_bytes == size) ? on_underlying_io_send_complete : NULL, (masked_bytes == size) ? ws_pending_send : NULL);
+                    }
+                }
+
+                is_completed = (uws_client->send_in_progress != ws_pending_send);
+                uws_client->send_in_progress = previous_send_in_progress;
+
+                if (is_completed)
+                {
+                    /* the underlying IO completed the frame from within xio_send, which left releasing it to this function */
+                    release_pending_send(uws_client, ws_pending_send);
+                }
+
+                if (send_result != 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_007: [ If any of the `xio_send` calls fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                    /* Codes_SRS_UWS_CLIENT_02_019: [ If any of the `xio_send` calls fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+                    LogError("Could not send bytes through the underlying IO, the frame may have been partially sent");
+
+                    /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+                    if (!is_completed)
+                    {
+                        (void)singlylinkedlist_remove(uws_client->pending_sends, new_pending_send_list_item);
+                        release_pending_send(uws_client, ws_pending_send);
+                    }
+
+                    if (is_partially_sent)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_02_151: [ If an `xio_send` call fails after an earlier `xio_send` call for the same frame succeeded, the uws client shall also indicate an error by calling `on_ws_error` with `WS_ERROR_UNDERLYING_IO_ERROR`, as the peer has received part of a frame and the connection cannot be used anymore. ]*/
+                        /* Codes_SRS_UWS_CLIENT_02_152: [ If sending `buffer` fails after the header was sent, the uws client shall also indicate an error by calling `on_ws_error` with `WS_ERROR_UNDERLYING_IO_ERROR`. ]*/
+                        indicate_ws_error(uws_client, WS_ERROR_UNDERLYING_IO_ERROR);
+                    }
+
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/* queues and sends a frame whose payload is copied, either encoded in a new buffer or masked through the scratch buffer */
+static int send_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final, unsigned char reserved, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
+{
+    int result;
+
+    if ((uws_client->coalesce_sends) &&
+        (size <= UWS_CLIENT_COALESCE_BUFFER_SIZE - UWS_FRAME_ENCODER_MAX_HEADER_SIZE))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_105: [ When send coalescing is on and the header and payload of the frame fit in `UWS_CLIENT_COALESCE_BUFFER_SIZE` bytes, `uws_client_send_frame_async` shall encode the frame in the coalesce buffer instead of sending it. ]*/
+        result = coalesce_frame(uws_client, frame_type, buffer, size, is_final, reserved, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+    else if ((uws_client->first_coalesced_send != NULL) &&
+        /* Codes_SRS_UWS_CLIENT_02_106: [ Before a frame that is not coalesced is sent, the frames already coalesced shall be sent, so that frames go out in the order they were queued. ]*/
+        (send_coalesced_frames(uws_client) != 0))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_108: [ If sending the frames already coalesced fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not send the coalesced frames ahead of the frame");
+        result = __FAILURE__;
+    }
+    else if (size > UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE - UWS_FRAME_ENCODER_MAX_HEADER_SIZE)
+    {
+        result = send_frame_in_pieces(uws_client, frame_type, buffer, NULL, false, size, is_final, reserved, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+    else
+    {
+        WS_PENDING_SEND* ws_pending_send = get_pending_send(uws_client);
+        if (ws_pending_send == NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+            LogError("Cannot allocate memory for frame to be sent.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            BUFFER_HANDLE non_control_frame_buffer;
+
+            /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
+            non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, buffer, size, true, is_final, reserved);
+            if (non_control_frame_buffer == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                LogError("Failed encoding WebSocket frame");
+                release_pending_send(uws_client, ws_pending_send);
+                result = __FAILURE__;
+            }
+            else
+            {
+                const unsigned char* encoded_frame;
+                size_t encoded_frame_length;
+                LIST_ITEM_HANDLE new_pending_send_list_item;
+
+                /* Codes_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
+                encoded_frame = BUFFER_u_char(non_control_frame_buffer);
+                /* Codes_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
+                encoded_frame_length = BUFFER_length(non_control_frame_buffer);
+
+                /* Codes_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
+                /* Codes_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
+                /* Codes_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
+                ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
+                ws_pending_send->context = on_ws_send_frame_complete_context;
+                ws_pending_send->uws_client = uws_client;
+
+                /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
+                new_pending_send_list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
+                if (new_pending_send_list_item == NULL)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                    LogError("Could not allocate memory for pending frames");
+                    release_pending_send(uws_client, ws_pending_send);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_431: [ Once encoded the frame shall be sent by using `xio_send` with the following arguments: ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_053: [ - the io handle shall be the underlyiong IO handle created in `uws_client_create`. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_054: [ - the `buffer` argument shall point to the complete websocket frame to be sent. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_055: [ - the `size` argument shall indicate the websocket frame length. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_057: [ - the `send_complete_context` argument shall identify the pending send. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
+                    WS_PENDING_SEND* previous_send_in_progress = uws_client->send_in_progress;
+                    bool is_completed;
+                    int send_result;
+
+                    ws_pending_send->list_item = new_pending_send_list_item;
+                    ws_pending_send->is_held_by_underlying_io = true;
+                    uws_client->send_in_progress = ws_pending_send;
+                    send_result = xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, ws_pending_send);
+                    is_completed = (uws_client->send_in_progress != ws_pending_send);
+                    uws_client->send_in_progress = previous_send_in_progress;
+
+                    if (is_completed)
+                    {
+                        /* the underlying IO completed the frame from within xio_send, which left releasing it to this function */
+                        release_pending_send(uws_client, ws_pending_send);
+                    }
+
+                    if (send_result != 0)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+                        LogError("Could not send bytes through the underlying IO");
+
+                        /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+                        if (!is_completed)
+                        {
+                            (void)singlylinkedlist_remove(uws_client->pending_sends, new_pending_send_list_item);
+                            release_pending_send(uws_client, ws_pending_send);
+                        }
+
+			            result = __FAILURE__;
+                    }
+                    else
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
+                        result = 0;
+                    }
+                }
+
+                BUFFER_delete(non_control_frame_buffer);
+            }
         }
     }
+
+    return result;
 }
 
-static bool find_list_node(LIST_ITEM_HANDLE list_item, const void* match_context)
+static bool is_compressed_frame(const UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, bool is_final)
 {
-    return list_item == (LIST_ITEM_HANDLE)match_context;
+    /* fragmented messages are sent uncompressed, as compressing them would need the whole message */
+    return (uws_client->deflate != NULL) &&
+        is_final &&
+        ((frame_type == WS_FRAME_TYPE_TEXT) || (frame_type == WS_FRAME_TYPE_BINARY));
+}
+
+static int send_compressed_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
+{
+    int result;
+    const unsigned char* compressed_payload;
+    size_t compressed_size;
+    uint64_t start_us;
+    bool is_cpu_time_measured = get_thread_cpu_time(&start_us);
+
+    /* Codes_SRS_UWS_CLIENT_02_061: [ When permessage-deflate was negotiated, the payload of a text or binary frame that has `is_final` set shall be compressed by calling `uws_deflate_compress`. ]*/
+    if (uws_deflate_compress(uws_client->deflate, buffer, size, &compressed_payload, &compressed_size) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_062: [ If `uws_deflate_compress` fails, sending the frame shall fail and return a non-zero value. ]*/
+        LogError("Cannot compress the frame payload");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uws_client->compression_statistics.messages_compressed++;
+        uws_client->compression_statistics.uncompressed_bytes_sent += size;
+        uws_client->compression_statistics.compressed_bytes_sent += compressed_size;
+
+        /* Codes_SRS_UWS_CLIENT_02_063: [ The compressed payload shall be sent as the frame payload, with the RSV1 bit set by passing `RESERVED_1` as the reserved bits to the frame encoder. ]*/
+        result = send_frame(uws_client, frame_type, compressed_payload, compressed_size, true, RESERVED_1, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+
+    if (is_cpu_time_measured)
+    {
+        add_thread_cpu_time(&uws_client->compression_statistics.compress_cpu_time_us, start_us);
+    }
+
+    return result;
 }
 
 int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
@@ -1706,95 +3395,299 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
     /* Codes_SRS_UWS_CLIENT_01_268: [ The endpoint MUST ensure the WebSocket connection is in the OPEN state ]*/
     else if (uws_client->uws_state != UWS_STATE_OPEN)
     {
-        /* Codes_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-        LogError("uws not in OPEN state.");
-        result = __FAILURE__;
+        /* Codes_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+        LogError("uws not in OPEN state.");
+        result = __FAILURE__;
+    }
+    else if (is_compressed_frame(uws_client, frame_type, is_final))
+    {
+        result = send_compressed_frame(uws_client, frame_type, buffer, size, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+    else
+    {
+        result = send_frame(uws_client, frame_type, buffer, size, is_final, 0, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+
+    return result;
+}
+
+int uws_client_send_frame_in_place_async(UWS_CLIENT_HANDLE uws_client, unsigned char frame_type, unsigned char* buffer, size_t size, bool is_final, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
+{
+    int result;
+
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_014: [ If the argument `uws_client` is NULL, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+        LogError("NULL uws handle.");
+        result = __FAILURE__;
+    }
+    else if ((buffer == NULL) &&
+        (size > 0))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_015: [ If `size` is non-zero and `buffer` is NULL then `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+        LogError("NULL buffer with %u size.", (unsigned int)size);
+        result = __FAILURE__;
+    }
+    else if (uws_client->uws_state != UWS_STATE_OPEN)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_020: [ If the uws instance is not OPEN then `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+        LogError("uws not in OPEN state.");
+        result = __FAILURE__;
+    }
+    else if (is_compressed_frame(uws_client, frame_type, is_final))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_064: [ When the frame is to be compressed, `uws_client_send_frame_in_place_async` shall send the compressed payload as `uws_client_send_frame_async` does and leave `buffer` unchanged. ]*/
+        result = send_compressed_frame(uws_client, frame_type, buffer, size, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+    else if ((uws_client->first_coalesced_send != NULL) &&
+        /* Codes_SRS_UWS_CLIENT_02_118: [ `uws_client_send_frame_in_place_async` shall not coalesce the frame, it shall send the frames already coalesced first. ]*/
+        (send_coalesced_frames(uws_client) != 0))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_119: [ If sending the frames already coalesced fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+        LogError("Could not send the coalesced frames ahead of the frame");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_02_009: [ `uws_client_send_frame_in_place_async` shall queue and send a frame like `uws_client_send_frame_async` does, except that the payload is masked in place in `buffer` instead of being copied. ]*/
+        /* Codes_SRS_UWS_CLIENT_02_021: [ On success, `uws_client_send_frame_in_place_async` shall return 0. ]*/
+        result = send_frame_in_pieces(uws_client, frame_type, buffer, buffer, true, size, is_final, 0, on_ws_send_frame_complete, on_ws_send_frame_complete_context);
+    }
+
+    return result;
+}
+
+int uws_client_set_on_ws_frame_fragment_received(UWS_CLIENT_HANDLE uws_client, ON_WS_FRAME_FRAGMENT_RECEIVED on_ws_frame_fragment_received, void* on_ws_frame_fragment_received_context)
+{
+    int result;
+
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_029: [ If `uws_client` is NULL, `uws_client_set_on_ws_frame_fragment_received` shall fail and return a non-zero value. ]*/
+        LogError("NULL uws handle.");
+        result = __FAILURE__;
+    }
+    else if (uws_client->uws_state != UWS_STATE_CLOSED)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_030: [ If the uws instance is not CLOSED, `uws_client_set_on_ws_frame_fragment_received` shall fail and return a non-zero value. ]*/
+        LogError("Cannot set the fragment callback in state %d", (int)uws_client->uws_state);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_02_031: [ Otherwise `uws_client_set_on_ws_frame_fragment_received` shall store `on_ws_frame_fragment_received` and `on_ws_frame_fragment_received_context` and return 0. A NULL `on_ws_frame_fragment_received` turns streaming off. ]*/
+        uws_client->on_ws_frame_fragment_received = on_ws_frame_fragment_received;
+        uws_client->on_ws_frame_fragment_received_context = on_ws_frame_fragment_received_context;
+        result = 0;
+    }
+
+    return result;
+}
+
+int uws_client_set_on_ws_upgrade_response_header(UWS_CLIENT_HANDLE uws_client, ON_WS_UPGRADE_RESPONSE_HEADER on_ws_upgrade_response_header, void* on_ws_upgrade_response_header_context)
+{
+    int result;
+
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_134: [ If `uws_client` is NULL, `uws_client_set_on_ws_upgrade_response_header` shall fail and return a non-zero value. ]*/
+        LogError("NULL uws handle.");
+        result = __FAILURE__;
+    }
+    else if (uws_client->uws_state != UWS_STATE_CLOSED)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_135: [ If the uws instance is not CLOSED, `uws_client_set_on_ws_upgrade_response_header` shall fail and return a non-zero value. ]*/
+        LogError("Cannot set the upgrade response header callback in state %d", (int)uws_client->uws_state);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_02_136: [ Otherwise `uws_client_set_on_ws_upgrade_response_header` shall store `on_ws_upgrade_response_header` and `on_ws_upgrade_response_header_context` and return 0. A NULL `on_ws_upgrade_response_header` stops the headers from being indicated. ]*/
+        uws_client->on_ws_upgrade_response_header = on_ws_upgrade_response_header;
+        uws_client->on_ws_upgrade_response_header_context = on_ws_upgrade_response_header_context;
+        result = 0;
+    }
+
+    return result;
+}
+
+int uws_client_get_compression_statistics(UWS_CLIENT_HANDLE uws_client, UWS_CLIENT_COMPRESSION_STATISTICS* statistics)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_070: [ If `uws_client` or `statistics` is NULL, `uws_client_get_compression_statistics` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, statistics=%p", uws_client, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_02_071: [ Otherwise `uws_client_get_compression_statistics` shall fill `statistics` with the counters and the processor times of the current connection and return 0. ]*/
+        *statistics = uws_client->compression_statistics;
+        result = 0;
+    }
+
+    return result;
+}
+
+int uws_client_get_ping_statistics(UWS_CLIENT_HANDLE uws_client, UWS_CLIENT_PING_STATISTICS* statistics)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (statistics == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_074: [ If `uws_client` or `statistics` is NULL, `uws_client_get_ping_statistics` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, statistics=%p", uws_client, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_02_075: [ Otherwise `uws_client_get_ping_statistics` shall fill `statistics` with the PING counters and round trip times of the current connection, the average being 0 while no round trip was measured, and return 0. ]*/
+        *statistics = uws_client->ping_statistics;
+        statistics->rtt_avg_ms = (uws_client->ping_statistics.pongs_received == 0) ? 0 : (uws_client->rtt_total_ms / uws_client->ping_statistics.pongs_received);
+        result = 0;
+    }
+
+    return result;
+}
+
+static void send_keepalive_ping(UWS_CLIENT_INSTANCE* uws_client, tickcounter_ms_t now)
+{
+    unsigned char ping_payload[KEEPALIVE_PING_PAYLOAD_SIZE];
+    BUFFER_HANDLE ping_frame_buffer;
+
+    /* Codes_SRS_UWS_CLIENT_02_081: [ The PING frame shall be encoded by calling `uws_frame_encoder_encode` with a payload made of the next 8 byte big endian sequence number. ]*/
+    encode_keepalive_ping_payload(ping_payload, uws_client->ping_sequence_number + 1);
+
+    /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+    ping_frame_buffer = uws_frame_encoder_encode(WS_PING_FRAME, ping_payload, sizeof(ping_payload), true, true, 0);
+    if (ping_frame_buffer == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_083: [ If encoding or sending the PING frame fails, no error shall be indicated and the PING shall be attempted again after the next ping interval. ]*/
+        LogError("Encoding of PING failed.");
     }
     else
     {
-        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)malloc(sizeof(WS_PENDING_SEND));
-        if (ws_pending_send == NULL)
+        /* Codes_SRS_UWS_CLIENT_02_082: [ The encoded PING frame shall be sent by calling `xio_send` with a NULL callback. ]*/
+        if (xio_send(uws_client->underlying_io, BUFFER_u_char(ping_frame_buffer), BUFFER_length(ping_frame_buffer), NULL, NULL) != 0)
         {
-            /* Codes_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-            LogError("Cannot allocate memory for frame to be sent.");
-            result = __FAILURE__;
+            /* Codes_SRS_UWS_CLIENT_02_083: [ If encoding or sending the PING frame fails, no error shall be indicated and the PING shall be attempted again after the next ping interval. ]*/
+            LogError("Sending PING frame failed.");
         }
         else
         {
-            BUFFER_HANDLE non_control_frame_buffer;
-
-            /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
-            non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, buffer, size, true, is_final, 0);
-            if (non_control_frame_buffer == NULL)
+            uws_client->ping_sequence_number++;
+            uws_client->ping_sent_ms = now;
+            if (!uws_client->is_ping_outstanding)
             {
-                /* Codes_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-                LogError("Failed encoding WebSocket frame");
-                free(ws_pending_send);
-                result = __FAILURE__;
+                uws_client->is_ping_outstanding = true;
+                uws_client->ping_unanswered_since_ms = now;
             }
-            else
-            {
-                const unsigned char* encoded_frame;
-                size_t encoded_frame_length;
-                LIST_ITEM_HANDLE new_pending_send_list_item;
+            uws_client->ping_statistics.pings_sent++;
+        }
 
-                /* Codes_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
-                encoded_frame = BUFFER_u_char(non_control_frame_buffer);
-                /* Codes_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
-                encoded_frame_length = BUFFER_length(non_control_frame_buffer);
+        BUFFER_delete(ping_frame_buffer);
+    }
+}
 
-                /* Codes_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
-                /* Codes_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
-                /* Codes_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
-                /* Codes_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
-                ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
-                ws_pending_send->context = on_ws_send_frame_complete_context;
-                ws_pending_send->uws_client = uws_client;
+void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
+{
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_059: [ If the `uws_client` argument is NULL, `uws_client_dowork` shall do nothing. ]*/
+        LogError("NULL uws handle.");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, `uws_client_dowork` shall do nothing. ]*/
+        if (uws_client->uws_state != UWS_STATE_CLOSED)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_430: [ `uws_client_dowork` shall call `xio_dowork` with the IO handle argument set to the underlying IO created in `uws_client_create`. ]*/
+            xio_dowork(uws_client->underlying_io);
 
-                /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
-                new_pending_send_list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
-                if (new_pending_send_list_item == NULL)
+            /* Codes_SRS_UWS_CLIENT_02_120: [ After `xio_dowork`, if frames were coalesced and the uws instance is OPEN, `uws_client_dowork` shall send them, so that the frames queued before and during the call go out together. ]*/
+            if ((uws_client->first_coalesced_send != NULL) &&
+                (uws_client->uws_state == UWS_STATE_OPEN))
+            {
+                (void)send_coalesced_frames(uws_client);
+            }
+
+            /* Codes_SRS_UWS_CLIENT_02_076: [ If a ping interval was set and the uws instance is OPEN, `uws_client_dowork` shall get the current time by calling `tickcounter_get_current_ms`. ]*/
+            if ((uws_client->ping_interval_ms != 0) &&
+                (uws_client->uws_state == UWS_STATE_OPEN))
+            {
+                tickcounter_ms_t now;
+
+                if (tickcounter_get_current_ms(uws_client->tick_counter, &now) != 0)
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-                    LogError("Could not allocate memory for pending frames");
-                    free(ws_pending_send);
-                    result = __FAILURE__;
+                    /* Codes_SRS_UWS_CLIENT_02_077: [ If `tickcounter_get_current_ms` fails, `uws_client_dowork` shall not send a PING nor check the pong timeout. ]*/
+                    LogError("Cannot get the current time for the keepalive PING");
                 }
-                else
+                else if (!uws_client->is_ping_timer_started)
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_431: [ Once encoded the frame shall be sent by using `xio_send` with the following arguments: ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_053: [ - the io handle shall be the underlyiong IO handle created in `uws_client_create`. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_054: [ - the `buffer` argument shall point to the complete websocket frame to be sent. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_055: [ - the `size` argument shall indicate the websocket frame length. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_057: [ - the `send_complete_context` argument shall identify the pending send. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
-                    if (xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, new_pending_send_list_item) != 0)
-                    {
-                        /* Codes_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-                        LogError("Could not send bytes through the underlying IO");
-                        
-                        /* Codes_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
-                        if (singlylinkedlist_find(uws_client->pending_sends, find_list_node, new_pending_send_list_item) != NULL)
-                        {    
-                            // Guards against double free in case the underlying I/O invoked 'on_underlying_io_send_complete' within xio_send.
-                            (void)singlylinkedlist_remove(uws_client->pending_sends, new_pending_send_list_item);
-                            free(ws_pending_send);
-                        }
+                    /* Codes_SRS_UWS_CLIENT_02_078: [ The first keepalive PING shall be sent one ping interval after the first `uws_client_dowork` call that finds the uws instance OPEN. ]*/
+                    uws_client->last_ping_time_ms = now;
+                    uws_client->is_ping_timer_started = true;
+                }
+                else if (uws_client->is_ping_outstanding &&
+                    (uws_client->pong_timeout_ms != 0) &&
+                    (now - uws_client->ping_unanswered_since_ms >= uws_client->pong_timeout_ms))
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_079: [ If a pong timeout was set and no PONG echoing a keepalive PING was received for that long since the oldest unanswered PING was sent, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_PONG_TIMEOUT`. ]*/
+                    LogError("No PONG received for %u ms", (unsigned int)(now - uws_client->ping_unanswered_since_ms));
 
-			            result = __FAILURE__;
-                    }
-                    else
-                    {
-                        /* Codes_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
-                        result = 0;
-                    }
+                    /* Codes_SRS_UWS_CLIENT_02_156: [ When the pong timeout is indicated, the uws instance shall move to the ERROR state and no PING shall be considered unanswered anymore, so that the timeout is indicated only once. ]*/
+                    uws_client->is_ping_outstanding = false;
+                    indicate_ws_error(uws_client, WS_ERROR_PONG_TIMEOUT);
                 }
+                else if (now - uws_client->last_ping_time_ms >= uws_client->ping_interval_ms)
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_080: [ Otherwise, when at least one ping interval has elapsed since the previous PING, a PING frame shall be sent, whether or not the previous one was answered. ]*/
+                    uws_client->last_ping_time_ms = now;
+                    send_keepalive_ping(uws_client, now);
+                }
+            }
+        }
+    }
+}
 
-                BUFFER_delete(non_control_frame_buffer);
+/* the next keepalive action is due at the next ping interval or, while a PING is unanswered, at the pong timeout if that comes first */
+static unsigned int get_keepalive_wait_ms(UWS_CLIENT_INSTANCE* uws_client, unsigned int timeout_ms)
+{
+    unsigned int result = timeout_ms;
+
+    if ((uws_client->ping_interval_ms != 0) &&
+        (uws_client->uws_state == UWS_STATE_OPEN) &&
+        uws_client->is_ping_timer_started)
+    {
+        tickcounter_ms_t now;
+
+        if (tickcounter_get_current_ms(uws_client->tick_counter, &now) != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_147: [ If `tickcounter_get_current_ms` fails, `timeout_ms` shall not be shortened. ]*/
+            LogError("Cannot get the current time for the keepalive PING");
+        }
+        else
+        {
+            tickcounter_ms_t due_ms = uws_client->last_ping_time_ms + uws_client->ping_interval_ms;
+
+            if (uws_client->is_ping_outstanding &&
+                (uws_client->pong_timeout_ms != 0) &&
+                (uws_client->ping_unanswered_since_ms + uws_client->pong_timeout_ms < due_ms))
+            {
+                due_ms = uws_client->ping_unanswered_since_ms + uws_client->pong_timeout_ms;
+            }
+
+            if (due_ms <= now)
+            {
+                result = 0;
+            }
+            else if (due_ms - now < result)
+            {
+                result = (unsigned int)(due_ms - now);
             }
         }
     }
@@ -1802,22 +3695,43 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
     return result;
 }
 
-void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
+int uws_client_wait(UWS_CLIENT_HANDLE uws_client, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
 {
+    int result;
+
     if (uws_client == NULL)
     {
-        /* Codes_SRS_UWS_CLIENT_01_059: [ If the `uws_client` argument is NULL, `uws_client_dowork` shall do nothing. ]*/
+        /* Codes_SRS_UWS_CLIENT_02_143: [ If the `uws_client` argument is NULL, `uws_client_wait` shall fail and return a non-zero value. ]*/
         LogError("NULL uws handle.");
+        result = __FAILURE__;
+    }
+    else if (uws_client->uws_state == UWS_STATE_CLOSED)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_144: [ If the IO is not yet open, `uws_client_wait` shall fail and return a non-zero value. ]*/
+        LogError("uws_client_wait called while closed.");
+        result = __FAILURE__;
+    }
+    else if ((uws_client->first_coalesced_send != NULL) &&
+        (uws_client->uws_state == UWS_STATE_OPEN))
+    {
+        /* Codes_SRS_UWS_CLIENT_02_145: [ If frames were coalesced and the uws instance is OPEN, `uws_client_wait` shall return 0 without waiting, as the next `uws_client_dowork` sends them. ]*/
+        result = 0;
+    }
+    /* Codes_SRS_UWS_CLIENT_02_146: [ If a ping interval was set and the uws instance is OPEN, `timeout_ms` shall be shortened to the time left until the next keepalive PING or pong timeout check, obtained by calling `tickcounter_get_current_ms`. ]*/
+    /* Codes_SRS_UWS_CLIENT_02_148: [ `uws_client_wait` shall call `xio_wait` on the underlying IO created in `uws_client_create`, passing the `timeout_ms` and `interest` arguments to it. ]*/
+    else if (xio_wait(uws_client->underlying_io, get_keepalive_wait_ms(uws_client, timeout_ms), interest) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_02_149: [ If `xio_wait` fails, `uws_client_wait` shall fail and return a non-zero value. ]*/
+        LogError("Failed waiting on the underlying IO.");
+        result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, `uws_client_dowork` shall do nothing. ]*/
-        if (uws_client->uws_state != UWS_STATE_CLOSED)
-        {
-            /* Codes_SRS_UWS_CLIENT_01_430: [ `uws_client_dowork` shall call `xio_dowork` with the IO handle argument set to the underlying IO created in `uws_client_create`. ]*/
-            xio_dowork(uws_client->underlying_io);
-        }
+        /* Codes_SRS_UWS_CLIENT_02_150: [ On success, `uws_client_wait` shall return 0. ]*/
+        result = 0;
     }
+
+    return result;
 }
 
 int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name, const void* value)
@@ -1835,7 +3749,124 @@ int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name,
     }
     else
     {
-        if (strcmp(UWS_CLIENT_OPTIONS, option_name) == 0)
+        if (strcmp(OPTION_WS_MAX_MESSAGE_SIZE, option_name) == 0)
+        {
+            if ((value == NULL) ||
+                (*(const size_t*)value == 0))
+            {
+                /* Codes_SRS_UWS_CLIENT_02_041: [ If the option name is `ws_max_message_size` and `value` is NULL or points to 0, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("Invalid maximum message size");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_040: [ If the option name is `ws_max_message_size`, `value` shall be treated as a pointer to a `size_t` holding the maximum size of a received message and `uws_client_set_option` shall return 0. ]*/
+                uws_client->max_message_size = *(const size_t*)value;
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_PING_INTERVAL_MS, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_088: [ If the option name is `ws_ping_interval_ms` or `ws_pong_timeout_ms` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("NULL ping interval");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if ((*(const unsigned int*)value != 0) &&
+                    (uws_client->tick_counter == NULL))
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_089: [ When a non-zero ping interval is set for the first time, a tick counter shall be created by calling `tickcounter_create`. ]*/
+                    uws_client->tick_counter = tickcounter_create();
+                }
+
+                if ((*(const unsigned int*)value != 0) &&
+                    (uws_client->tick_counter == NULL))
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_090: [ If `tickcounter_create` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                    LogError("Cannot create the tick counter for the keepalive PINGs");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_091: [ If the option name is `ws_ping_interval_ms`, `value` shall be treated as a pointer to an `unsigned int` holding the interval in milliseconds at which `uws_client_dowork` sends keepalive PINGs, 0 turning them off, and `uws_client_set_option` shall return 0. ]*/
+                    uws_client->ping_interval_ms = *(const unsigned int*)value;
+                    result = 0;
+                }
+            }
+        }
+        else if (strcmp(OPTION_WS_PONG_TIMEOUT_MS, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_088: [ If the option name is `ws_ping_interval_ms` or `ws_pong_timeout_ms` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("NULL pong timeout");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_092: [ If the option name is `ws_pong_timeout_ms`, `value` shall be treated as a pointer to an `unsigned int` holding how many milliseconds a keepalive PING may stay unanswered, 0 turning the check off, and `uws_client_set_option` shall return 0. ]*/
+                uws_client->pong_timeout_ms = *(const unsigned int*)value;
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_COALESCE_SENDS, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_121: [ If the option name is `ws_coalesce_sends` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("NULL coalesce sends value");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_122: [ If the option name is `ws_coalesce_sends`, `value` shall be treated as a pointer to a `bool` turning send coalescing on or off and `uws_client_set_option` shall return 0. ]*/
+                uws_client->coalesce_sends = *(const bool*)value;
+
+                if ((!uws_client->coalesce_sends) &&
+                    (uws_client->first_coalesced_send != NULL) &&
+                    (uws_client->uws_state == UWS_STATE_OPEN))
+                {
+                    /* Codes_SRS_UWS_CLIENT_02_123: [ When send coalescing is turned off while the uws instance is OPEN, the frames already coalesced shall be sent. ]*/
+                    (void)send_coalesced_frames(uws_client);
+                }
+
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_PERMESSAGE_DEFLATE, option_name) == 0)
+        {
+#ifdef USE_WS_DEFLATE
+            const WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options = (const WS_PERMESSAGE_DEFLATE_OPTIONS*)value;
+
+            if ((permessage_deflate_options == NULL) ||
+                (permessage_deflate_options->client_max_window_bits < 9) ||
+                (permessage_deflate_options->client_max_window_bits > 15) ||
+                (permessage_deflate_options->server_max_window_bits < 8) ||
+                (permessage_deflate_options->server_max_window_bits > 15) ||
+                (permessage_deflate_options->compression_level < -1) ||
+                (permessage_deflate_options->compression_level > 9))
+            {
+                /* Codes_SRS_UWS_CLIENT_02_066: [ If the option name is `ws_permessage_deflate` and `value` is NULL or holds a client window outside 9..15 bits, a server window outside 8..15 bits or a compression level outside -1..9, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+                LogError("Invalid permessage-deflate options");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_02_065: [ If the option name is `ws_permessage_deflate`, `value` shall be treated as a pointer to a `WS_PERMESSAGE_DEFLATE_OPTIONS`, which shall be copied and offered in the upgrade request of every following open, and `uws_client_set_option` shall return 0. ]*/
+                uws_client->permessage_deflate_options = *permessage_deflate_options;
+                uws_client->offer_permessage_deflate = true;
+                result = 0;
+            }
+#else
+            /* Codes_SRS_UWS_CLIENT_02_067: [ If the library was built without permessage-deflate support, setting the option `ws_permessage_deflate` shall fail and return a non-zero value. ]*/
+            LogError("permessage-deflate is not supported, build with use_ws_deflate set to ON");
+            result = __FAILURE__;
+#endif
+        }
+        else if (strcmp(UWS_CLIENT_OPTIONS, option_name) == 0)
         {
             /* Codes_SRS_UWS_CLIENT_01_510: [ If the option name is `uWSClientOptions` then `uws_client_set_option` shall call `OptionHandler_FeedOptions` and pass to it the underlying IO handle and the `value` argument. ]*/
             if (OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)value, uws_client->underlying_io) != OPTIONHANDLER_OK)
@@ -1890,6 +3921,71 @@ static void* uws_client_clone_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_507: [ `uws_client_clone_option` called with `name` being `uWSClientOptions` shall return the same value. ]*/
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_WS_MAX_MESSAGE_SIZE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_044: [ `uws_client_clone_option` called with `name` being `ws_max_message_size` shall return a newly allocated copy of the `size_t` pointed to by `value`. ]*/
+            size_t* max_message_size = (size_t*)malloc(sizeof(size_t));
+            if (max_message_size == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_045: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("unable to clone the maximum message size");
+            }
+            else
+            {
+                *max_message_size = *(const size_t*)value;
+            }
+
+            result = max_message_size;
+        }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_068: [ `uws_client_clone_option` called with `name` being `ws_permessage_deflate` shall return a newly allocated copy of the `WS_PERMESSAGE_DEFLATE_OPTIONS` pointed to by `value`. ]*/
+            WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options = (WS_PERMESSAGE_DEFLATE_OPTIONS*)malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS));
+            if (permessage_deflate_options == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_045: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("unable to clone the permessage-deflate options");
+            }
+            else
+            {
+                *permessage_deflate_options = *(const WS_PERMESSAGE_DEFLATE_OPTIONS*)value;
+            }
+
+            result = permessage_deflate_options;
+        }
+        else if ((strcmp(name, OPTION_WS_PING_INTERVAL_MS) == 0) ||
+            (strcmp(name, OPTION_WS_PONG_TIMEOUT_MS) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_093: [ `uws_client_clone_option` called with `name` being `ws_ping_interval_ms` or `ws_pong_timeout_ms` shall return a newly allocated copy of the `unsigned int` pointed to by `value`. ]*/
+            unsigned int* milliseconds = (unsigned int*)malloc(sizeof(unsigned int));
+            if (milliseconds == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_045: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("unable to clone the option %s", name);
+            }
+            else
+            {
+                *milliseconds = *(const unsigned int*)value;
+            }
+
+            result = milliseconds;
+        }
+        else if (strcmp(name, OPTION_WS_COALESCE_SENDS) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_02_124: [ `uws_client_clone_option` called with `name` being `ws_coalesce_sends` shall return a newly allocated copy of the `bool` pointed to by `value`. ]*/
+            bool* coalesce_sends = (bool*)malloc(sizeof(bool));
+            if (coalesce_sends == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_02_045: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+                LogError("unable to clone the option %s", name);
+            }
+            else
+            {
+                *coalesce_sends = *(const bool*)value;
+            }
+
+            result = coalesce_sends;
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_512: [ `uws_client_clone_option` called with any other option name than `uWSClientOptions` shall return NULL. ]*/
@@ -1918,6 +4014,15 @@ static void uws_client_destroy_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_508: [ `uws_client_destroy_option` called with the option `name` being `uWSClientOptions` shall destroy the value by calling `OptionHandler_Destroy`. ]*/
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if ((strcmp(name, OPTION_WS_MAX_MESSAGE_SIZE) == 0) ||
+            (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0) ||
+            (strcmp(name, OPTION_WS_PING_INTERVAL_MS) == 0) ||
+            (strcmp(name, OPTION_WS_PONG_TIMEOUT_MS) == 0) ||
+            (strcmp(name, OPTION_WS_COALESCE_SENDS) == 0))
+        {
+            /* Codes_SRS_UWS_CLIENT_02_046: [ `uws_client_destroy_option` called with the option `name` being `ws_max_message_size`, `ws_permessage_deflate`, `ws_ping_interval_ms`, `ws_pong_timeout_ms` or `ws_coalesce_sends` shall free the value. ]*/
+            free((void*)value);
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_513: [ If `uws_client_destroy_option` is called with any other `name` it shall do nothing. ]*/
@@ -1968,6 +4073,50 @@ OPTIONHANDLER_HANDLE uws_client_retrieve_options(UWS_CLIENT_HANDLE uws_client)
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                /* Codes_SRS_UWS_CLIENT_02_043: [ If a maximum message size was set, `uws_client_retrieve_options` shall also add the option `ws_max_message_size` with the current maximum message size. ]*/
+                else if ((uws_client->max_message_size != SIZE_MAX) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_MAX_MESSAGE_SIZE, &uws_client->max_message_size) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_UWS_CLIENT_02_069: [ If permessage-deflate is offered, `uws_client_retrieve_options` shall also add the option `ws_permessage_deflate` with the offered parameters. ]*/
+                else if (uws_client->offer_permessage_deflate &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PERMESSAGE_DEFLATE, &uws_client->permessage_deflate_options) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_UWS_CLIENT_02_094: [ If a ping interval or a pong timeout was set to a non-zero value, `uws_client_retrieve_options` shall also add the option `ws_ping_interval_ms` or `ws_pong_timeout_ms`. ]*/
+                else if ((uws_client->ping_interval_ms != 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PING_INTERVAL_MS, &uws_client->ping_interval_ms) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                else if ((uws_client->pong_timeout_ms != 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PONG_TIMEOUT_MS, &uws_client->pong_timeout_ms) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+                /* Codes_SRS_UWS_CLIENT_02_125: [ If send coalescing is on, `uws_client_retrieve_options` shall also add the option `ws_coalesce_sends`. ]*/
+                else if (uws_client->coalesce_sends &&
+                    (OptionHandler_AddOption(result, OPTION_WS_COALESCE_SENDS, &uws_client->coalesce_sends) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
             }
         }
        
@@ -0,0 +1,391 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/uws_deflate.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifdef USE_WS_DEFLATE
+
+#include "zlib.h"
+
+/* the output buffer never starts smaller than this, so short messages do not need several passes */
+#define UWS_DEFLATE_MIN_OUTPUT_SIZE 256
+
+/* Codes_SRS_UWS_DEFLATE_02_013: [ The 4 octets 0x00 0x00 0xff 0xff that end a sync flushed deflate stream shall be removed from the compressed payload. ]*/
+static const unsigned char deflate_tail[] = { 0x00, 0x00, 0xFF, 0xFF };
+
+typedef struct UWS_DEFLATE_INSTANCE_TAG
+{
+    z_stream deflate_stream;
+    z_stream inflate_stream;
+    bool no_compress_context_takeover;
+    unsigned char* output;
+    size_t output_size;
+    size_t output_length;
+} UWS_DEFLATE_INSTANCE;
+
+static int grow_output(UWS_DEFLATE_INSTANCE* uws_deflate, size_t hint)
+{
+    int result;
+    size_t new_size;
+    unsigned char* new_output;
+
+    if (uws_deflate->output_size > (SIZE_MAX / 2))
+    {
+        LogError("Cannot grow the output buffer past %lu bytes", (unsigned long)uws_deflate->output_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        new_size = uws_deflate->output_size * 2;
+        if (new_size < hint)
+        {
+            new_size = hint;
+        }
+
+        if (new_size < UWS_DEFLATE_MIN_OUTPUT_SIZE)
+        {
+            new_size = UWS_DEFLATE_MIN_OUTPUT_SIZE;
+        }
+
+        new_output = (unsigned char*)realloc(uws_deflate->output, new_size);
+        if (new_output == NULL)
+        {
+            LogError("Cannot grow the output buffer to %lu bytes", (unsigned long)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_deflate->output = new_output;
+            uws_deflate->output_size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void set_next_output(z_stream* stream, UWS_DEFLATE_INSTANCE* uws_deflate)
+{
+    size_t available = uws_deflate->output_size - uws_deflate->output_length;
+
+    stream->next_out = uws_deflate->output + uws_deflate->output_length;
+    stream->avail_out = (available > UINT_MAX) ? UINT_MAX : (uInt)available;
+}
+
+UWS_DEFLATE_HANDLE uws_deflate_create(int compress_window_bits, int compression_level, bool no_compress_context_takeover)
+{
+    UWS_DEFLATE_INSTANCE* result;
+
+    if ((compress_window_bits < 9) ||
+        (compress_window_bits > 15) ||
+        (compression_level < -1) ||
+        (compression_level > 9))
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_002: [ If `compress_window_bits` is not between 9 and 15 or `compression_level` is not between -1 and 9, `uws_deflate_create` shall fail and return NULL. ]*/
+        LogError("Invalid arguments: compress_window_bits = %d, compression_level = %d", compress_window_bits, compression_level);
+        result = NULL;
+    }
+    else
+    {
+        result = (UWS_DEFLATE_INSTANCE*)malloc(sizeof(UWS_DEFLATE_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_UWS_DEFLATE_02_003: [ If allocating memory for the instance fails, `uws_deflate_create` shall fail and return NULL. ]*/
+            LogError("Could not allocate uws_deflate instance");
+        }
+        else
+        {
+            (void)memset(result, 0, sizeof(UWS_DEFLATE_INSTANCE));
+
+            /* Codes_SRS_UWS_DEFLATE_02_001: [ `uws_deflate_create` shall create a raw deflate compressor with a window of `compress_window_bits` bits and `compression_level`, and a raw inflate decompressor with a window of 15 bits, which accepts data compressed with any window size. ]*/
+            if (deflateInit2(&result->deflate_stream, compression_level, Z_DEFLATED, -compress_window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_004: [ If initializing the compressor or the decompressor fails, `uws_deflate_create` shall fail and return NULL. ]*/
+                LogError("deflateInit2 failed");
+                free(result);
+                result = NULL;
+            }
+            else if (inflateInit2(&result->inflate_stream, -15) != Z_OK)
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_004: [ If initializing the compressor or the decompressor fails, `uws_deflate_create` shall fail and return NULL. ]*/
+                LogError("inflateInit2 failed");
+                (void)deflateEnd(&result->deflate_stream);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->no_compress_context_takeover = no_compress_context_takeover;
+            }
+        }
+    }
+
+    return result;
+}
+
+void uws_deflate_destroy(UWS_DEFLATE_HANDLE uws_deflate)
+{
+    if (uws_deflate == NULL)
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_006: [ If `uws_deflate` is NULL, `uws_deflate_destroy` shall do nothing. ]*/
+        LogError("NULL uws_deflate");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_005: [ `uws_deflate_destroy` shall free the compressor, the decompressor and the output buffer. ]*/
+        (void)deflateEnd(&uws_deflate->deflate_stream);
+        (void)inflateEnd(&uws_deflate->inflate_stream);
+        free(uws_deflate->output);
+        free(uws_deflate);
+    }
+}
+
+int uws_deflate_compress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, const unsigned char** compressed_payload, size_t* compressed_size)
+{
+    int result;
+
+    if ((uws_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (compressed_payload == NULL) ||
+        (compressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_007: [ If `uws_deflate`, `compressed_payload` or `compressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_deflate = %p, payload = %p, size = %lu, compressed_payload = %p, compressed_size = %p",
+            uws_deflate, payload, (unsigned long)size, compressed_payload, compressed_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        z_stream* stream = &uws_deflate->deflate_stream;
+        size_t consumed = 0;
+
+        /* Codes_SRS_UWS_DEFLATE_02_008: [ The output buffer shall be reused between calls and only grown when it is too small, starting from `size` plus a small margin. ]*/
+        uws_deflate->output_length = 0;
+        result = (uws_deflate->output_size < size + 64) ? grow_output(uws_deflate, size + 64) : 0;
+
+        /* Codes_SRS_UWS_DEFLATE_02_009: [ `uws_deflate_compress` shall compress `payload` and end the output with a sync flush, feeding the payload in chunks the compressor can take. ]*/
+        while (result == 0)
+        {
+            size_t chunk = ((size - consumed) > UINT_MAX) ? UINT_MAX : (size - consumed);
+            bool is_last_chunk = (consumed + chunk == size);
+            int deflate_result;
+
+            stream->next_in = (Bytef*)(payload + consumed);
+            stream->avail_in = (uInt)chunk;
+
+            do
+            {
+                if ((uws_deflate->output_length == uws_deflate->output_size) &&
+                    (grow_output(uws_deflate, 0) != 0))
+                {
+                    /* Codes_SRS_UWS_DEFLATE_02_010: [ If growing the output buffer fails, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+                    result = __FAILURE__;
+                    break;
+                }
+
+                set_next_output(stream, uws_deflate);
+                deflate_result = deflate(stream, is_last_chunk ? Z_SYNC_FLUSH : Z_NO_FLUSH);
+                uws_deflate->output_length = (size_t)(stream->next_out - uws_deflate->output);
+
+                if (deflate_result == Z_STREAM_ERROR)
+                {
+                    /* Codes_SRS_UWS_DEFLATE_02_011: [ If the compressor fails, `uws_deflate_compress` shall fail and return a non-zero value. ]*/
+                    LogError("deflate failed");
+                    result = __FAILURE__;
+                    break;
+                }
+            } while ((stream->avail_in > 0) || (stream->avail_out == 0));
+
+            consumed += chunk;
+            if (is_last_chunk)
+            {
+                break;
+            }
+        }
+
+        if (result == 0)
+        {
+            if ((uws_deflate->output_length >= sizeof(deflate_tail)) &&
+                (memcmp(uws_deflate->output + uws_deflate->output_length - sizeof(deflate_tail), deflate_tail, sizeof(deflate_tail)) == 0))
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_013: [ The 4 octets 0x00 0x00 0xff 0xff that end a sync flushed deflate stream shall be removed from the compressed payload. ]*/
+                uws_deflate->output_length -= sizeof(deflate_tail);
+            }
+
+            if (uws_deflate->no_compress_context_takeover)
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_014: [ If `no_compress_context_takeover` was true, the compressor shall be reset after each message so that no message refers to data of a previous one. ]*/
+                (void)deflateReset(stream);
+            }
+
+            /* Codes_SRS_UWS_DEFLATE_02_012: [ On success, `uws_deflate_compress` shall set `compressed_payload` and `compressed_size` to the compressed bytes, owned by the instance, and return 0. ]*/
+            *compressed_payload = uws_deflate->output;
+            *compressed_size = uws_deflate->output_length;
+        }
+        else
+        {
+            /* the compressor state is unknown, start the next message from scratch */
+            (void)deflateReset(stream);
+        }
+    }
+
+    return result;
+}
+
+static int inflate_bytes(UWS_DEFLATE_INSTANCE* uws_deflate, const unsigned char* bytes, size_t size, size_t max_size)
+{
+    int result = 0;
+    z_stream* stream = &uws_deflate->inflate_stream;
+    size_t consumed = 0;
+
+    while ((result == 0) &&
+        (consumed < size) &&
+        (uws_deflate->output_length <= max_size))
+    {
+        size_t chunk = ((size - consumed) > UINT_MAX) ? UINT_MAX : (size - consumed);
+        int inflate_result;
+
+        stream->next_in = (Bytef*)(bytes + consumed);
+        stream->avail_in = (uInt)chunk;
+
+        do
+        {
+            if ((uws_deflate->output_length == uws_deflate->output_size) &&
+                (grow_output(uws_deflate, 0) != 0))
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_019: [ If growing the output buffer fails, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+                result = __FAILURE__;
+                break;
+            }
+
+            set_next_output(stream, uws_deflate);
+            inflate_result = inflate(stream, Z_SYNC_FLUSH);
+            uws_deflate->output_length = (size_t)(stream->next_out - uws_deflate->output);
+
+            if (inflate_result == Z_STREAM_END)
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_020: [ A deflate block with the BFINAL bit set shall end the stream and the decompressor shall be reset for the data that follows. ]*/
+                (void)inflateReset(stream);
+            }
+            else if ((inflate_result == Z_BUF_ERROR) &&
+                (stream->avail_out > 0))
+            {
+                /* no progress is possible, all the pending output was produced */
+                break;
+            }
+            else if ((inflate_result != Z_OK) &&
+                (inflate_result != Z_BUF_ERROR))
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_018: [ If the decompressor fails, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+                LogError("inflate failed: %d", inflate_result);
+                result = __FAILURE__;
+                break;
+            }
+
+            if (uws_deflate->output_length > max_size)
+            {
+                /* Codes_SRS_UWS_DEFLATE_02_017: [ Decompression shall stop as soon as more than `max_size` bytes were produced, in which case `decompressed_size` shall be greater than `max_size`. ]*/
+                break;
+            }
+        } while ((stream->avail_in > 0) || (stream->avail_out == 0));
+
+        consumed += chunk - stream->avail_in;
+        if (stream->avail_in > 0)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+int uws_deflate_decompress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, bool is_final, size_t max_size, const unsigned char** decompressed_payload, size_t* decompressed_size)
+{
+    int result;
+
+    if ((uws_deflate == NULL) ||
+        ((payload == NULL) && (size > 0)) ||
+        (decompressed_payload == NULL) ||
+        (decompressed_size == NULL))
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_015: [ If `uws_deflate`, `decompressed_payload` or `decompressed_size` is NULL, or `payload` is NULL while `size` is not 0, `uws_deflate_decompress` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_deflate = %p, payload = %p, size = %lu, decompressed_payload = %p, decompressed_size = %p",
+            uws_deflate, payload, (unsigned long)size, decompressed_payload, decompressed_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_DEFLATE_02_016: [ `uws_deflate_decompress` shall decompress `payload` and, if `is_final` is true, the 4 octets 0x00 0x00 0xff 0xff removed by the sender. ]*/
+        uws_deflate->output_length = 0;
+        result = inflate_bytes(uws_deflate, payload, size, max_size);
+        if ((result == 0) &&
+            is_final &&
+            (uws_deflate->output_length <= max_size))
+        {
+            result = inflate_bytes(uws_deflate, deflate_tail, sizeof(deflate_tail), max_size);
+        }
+
+        if (result != 0)
+        {
+            (void)inflateReset(&uws_deflate->inflate_stream);
+        }
+        else
+        {
+            /* Codes_SRS_UWS_DEFLATE_02_021: [ On success, `uws_deflate_decompress` shall set `decompressed_payload` and `decompressed_size` to the decompressed bytes, owned by the instance, and return 0. ]*/
+            *decompressed_payload = uws_deflate->output;
+            *decompressed_size = uws_deflate->output_length;
+        }
+    }
+
+    return result;
+}
+
+#else /* USE_WS_DEFLATE */
+
+UWS_DEFLATE_HANDLE uws_deflate_create(int compress_window_bits, int compression_level, bool no_compress_context_takeover)
+{
+    /* Codes_SRS_UWS_DEFLATE_02_022: [ When the library is built without zlib (`use_ws_deflate` is OFF), `uws_deflate_create` shall fail and return NULL. ]*/
+    (void)compress_window_bits;
+    (void)compression_level;
+    (void)no_compress_context_takeover;
+    LogError("permessage-deflate is not supported by this build, set use_ws_deflate to ON");
+    return NULL;
+}
+
+void uws_deflate_destroy(UWS_DEFLATE_HANDLE uws_deflate)
+{
+    (void)uws_deflate;
+}
+
+int uws_deflate_compress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, const unsigned char** compressed_payload, size_t* compressed_size)
+{
+    (void)uws_deflate;
+    (void)payload;
+    (void)size;
+    (void)compressed_payload;
+    (void)compressed_size;
+    return __FAILURE__;
+}
+
+int uws_deflate_decompress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, bool is_final, size_t max_size, const unsigned char** decompressed_payload, size_t* decompressed_size)
+{
+    (void)uws_deflate;
+    (void)payload;
+    (void)size;
+    (void)is_final;
+    (void)max_size;
+    (void)decompressed_payload;
+    (void)decompressed_size;
+    return __FAILURE__;
+}
+
+#endif /* USE_WS_DEFLATE */
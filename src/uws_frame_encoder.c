@@ -5,13 +5,200 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/uniqueid.h"
 
+/* SSE2 is part of every x64 CPU and NEON of every AArch64 one, so neither needs a runtime check */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define UWS_FRAME_ENCODER_MASK_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define UWS_FRAME_ENCODER_MASK_NEON
+#endif
+
+void uws_frame_encoder_mask(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* mask_key, size_t offset)
+{
+    if ((length > 0) &&
+        ((destination == NULL) || (source == NULL) || (mask_key == NULL)))
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_002: [ If `length` is greater than 0 and any of `destination`, `source` or `mask_key` is NULL, `uws_frame_encoder_mask` shall do nothing. ]*/
+        LogError("Invalid arguments: destination=%p, source=%p, mask_key=%p, length=%u", destination, source, mask_key, (unsigned int)length);
+    }
+    else
+    {
+        /* the key repeated from the octet that lines up with source[0], so that any block starting at a multiple of 4 uses it as is */
+        unsigned char pattern[16];
+        size_t i;
+
+        for (i = 0; i < 4; i++)
+        {
+            pattern[i] = mask_key[(offset + i) % 4];
+        }
+        (void)memcpy(pattern + 4, pattern, 4);
+        (void)memcpy(pattern + 8, pattern, 8);
+
+        i = 0;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_001: [ `uws_frame_encoder_mask` shall XOR each of the `length` octets of `source` with octet (`offset` + i) modulo 4 of `mask_key` and write the result to `destination`. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_003: [ `destination` may be the same as `source`, in which case the bytes shall be masked in place. ]*/
+#if defined(UWS_FRAME_ENCODER_MASK_SSE2)
+        {
+            __m128i mask_block = _mm_loadu_si128((const __m128i*)pattern);
+
+            for (; i + 64 <= length; i += 64)
+            {
+                __m128i block_0 = _mm_loadu_si128((const __m128i*)(source + i));
+                __m128i block_1 = _mm_loadu_si128((const __m128i*)(source + i + 16));
+                __m128i block_2 = _mm_loadu_si128((const __m128i*)(source + i + 32));
+                __m128i block_3 = _mm_loadu_si128((const __m128i*)(source + i + 48));
+                _mm_storeu_si128((__m128i*)(destination + i), _mm_xor_si128(block_0, mask_block));
+                _mm_storeu_si128((__m128i*)(destination + i + 16), _mm_xor_si128(block_1, mask_block));
+                _mm_storeu_si128((__m128i*)(destination + i + 32), _mm_xor_si128(block_2, mask_block));
+                _mm_storeu_si128((__m128i*)(destination + i + 48), _mm_xor_si128(block_3, mask_block));
+            }
+
+            for (; i + 16 <= length; i += 16)
+            {
+                _mm_storeu_si128((__m128i*)(destination + i), _mm_xor_si128(_mm_loadu_si128((const __m128i*)(source + i)), mask_block));
+            }
+        }
+#elif defined(UWS_FRAME_ENCODER_MASK_NEON)
+        {
+            uint8x16_t mask_block = vld1q_u8(pattern);
+
+            for (; i + 16 <= length; i += 16)
+            {
+                vst1q_u8(destination + i, veorq_u8(vld1q_u8(source + i), mask_block));
+            }
+        }
+#endif
+
+        /* 64 bits at a time, memcpy keeps the unaligned loads and stores portable and compiles to plain moves */
+        {
+            uint64_t mask_word;
+            (void)memcpy(&mask_word, pattern, sizeof(mask_word));
+
+            for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                (void)memcpy(&word, source + i, sizeof(word));
+                word ^= mask_word;
+                (void)memcpy(destination + i, &word, sizeof(word));
+            }
+        }
+
+        for (; i < length; i++)
+        {
+            destination[i] = source[i] ^ pattern[i % 4];
+        }
+    }
+}
+
+static size_t get_header_length(size_t length, bool is_masked)
+{
+    size_t result = 2;
+
+    if (length > 65535)
+    {
+        result += 8;
+    }
+    else if (length > 125)
+    {
+        result += 2;
+    }
+
+    if (is_masked)
+    {
+        result += 4;
+    }
+
+    return result;
+}
+
+/* writes the header_length bytes of the frame header, including a fresh masking key when is_masked is true */
+static void write_header(unsigned char* buffer, size_t header_length, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved)
+{
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_007: [ *  %x0 denotes a continuation frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_008: [ *  %x1 denotes a text frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_009: [ *  %x2 denotes a binary frame ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_010: [ *  %x3-7 are reserved for further non-control frames ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_011: [ *  %x8 denotes a connection close ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_012: [ *  %x9 denotes a ping ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_013: [ *  %xA denotes a pong ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_014: [ *  %xB-F are reserved for further control frames ]*/
+    buffer[0] = (unsigned char)opcode;
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_002: [ Indicates that this is the final fragment in a message. ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_003: [ The first fragment MAY also be the final fragment. ]*/
+    if (is_final)
+    {
+        buffer[0] |= 0x80;
+    }
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_004: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+    buffer[0] |= reserved << 4;
+
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_022: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_018: [ The length of the "Payload data", in bytes: ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_023: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
+    /* Codes_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
+    if (length > 65535)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_020: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+        buffer[1] = 127;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
+        buffer[2] = (unsigned char)((uint64_t)length >> 56) & 0xFF;
+        buffer[3] = (unsigned char)((uint64_t)length >> 48) & 0xFF;
+        buffer[4] = (unsigned char)((uint64_t)length >> 40) & 0xFF;
+        buffer[5] = (unsigned char)((uint64_t)length >> 32) & 0xFF;
+        buffer[6] = (unsigned char)((uint64_t)length >> 24) & 0xFF;
+        buffer[7] = (unsigned char)((uint64_t)length >> 16) & 0xFF;
+        buffer[8] = (unsigned char)((uint64_t)length >> 8) & 0xFF;
+        buffer[9] = (unsigned char)(length & 0xFF);
+    }
+    else if (length > 125)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_019: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+        buffer[1] = 126;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
+        buffer[2] = (unsigned char)(length >> 8);
+        buffer[3] = (unsigned char)(length & 0xFF);
+    }
+    else
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_043: [ if 0-125, that is the payload length. ]*/
+        buffer[1] = (unsigned char)length;
+    }
+
+    if (is_masked)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_033: [ A masked frame MUST have the field frame-masked set to 1, as defined in Section 5.2. ]*/
+        buffer[1] |= 0x80;
+
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_034: [ The masking key is contained completely within the frame, as defined in Section 5.2 as frame-masking-key. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_036: [ The masking key is a 32-bit value chosen at random by the client. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_037: [ When preparing a masked frame, the client MUST pick a fresh masking key from the set of allowed 32-bit values. ]*/
+        /* Codes_SRS_UWS_FRAME_ENCODER_01_038: [ The masking key needs to be unpredictable; thus, the masking key MUST be derived from a strong source of entropy, and the masking key for a given frame MUST NOT make it simple for a server/proxy to predict the masking key for a subsequent frame. ]*/
+        buffer[header_length - 4] = (unsigned char)gb_rand();
+        buffer[header_length - 3] = (unsigned char)gb_rand();
+        buffer[header_length - 2] = (unsigned char)gb_rand();
+        buffer[header_length - 1] = (unsigned char)gb_rand();
+    }
+}
+
 BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char* payload, size_t length, bool is_masked, bool is_final, unsigned char reserved)
 {
     BUFFER_HANDLE result;
@@ -37,7 +224,6 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
     }
     else
     {
-        size_t needed_bytes = 2;
         size_t header_bytes;
 
         /* Codes_SRS_UWS_FRAME_ENCODER_01_044: [ On success `uws_frame_encoder_encode` shall return a non-NULL handle to the result buffer. ]*/
@@ -51,25 +237,10 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
         else
         {
             /* Codes_SRS_UWS_FRAME_ENCODER_01_001: [ `uws_frame_encoder_encode` shall encode the information given in `opcode`, `payload`, `length`, `is_masked`, `is_final` and `reserved` according to the RFC6455 into a new buffer.]*/
-            if (length > 65535)
-            {
-                needed_bytes += 8;
-            }
-            else if (length > 125)
-            {
-                needed_bytes += 2;
-            }
-
-            if (is_masked)
-            {
-                needed_bytes += 4;
-            }
-
-            header_bytes = needed_bytes;
-            needed_bytes += length;
+            header_bytes = get_header_length(length, is_masked);
 
             /* Codes_SRS_UWS_FRAME_ENCODER_01_046: [ The result buffer shall be resized accordingly using `BUFFER_enlarge`. ]*/
-            if (BUFFER_enlarge(result, needed_bytes) != 0)
+            if (BUFFER_enlarge(result, header_bytes + length) != 0)
             {
                 /* Codes_SRS_UWS_FRAME_ENCODER_01_047: [ If `BUFFER_enlarge` fails then `uws_frame_encoder_encode` shall fail and return NULL. ]*/
                 LogError("Cannot allocate memory for encoded frame");
@@ -89,93 +260,17 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
                 }
                 else
                 {
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_007: [ *  %x0 denotes a continuation frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_008: [ *  %x1 denotes a text frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_009: [ *  %x2 denotes a binary frame ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_010: [ *  %x3-7 are reserved for further non-control frames ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_011: [ *  %x8 denotes a connection close ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_012: [ *  %x9 denotes a ping ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_013: [ *  %xA denotes a pong ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_014: [ *  %xB-F are reserved for further control frames ]*/
-                    buffer[0] = (unsigned char)opcode;
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_002: [ Indicates that this is the final fragment in a message. ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_003: [ The first fragment MAY also be the final fragment. ]*/
-                    if (is_final)
-                    {
-                        buffer[0] |= 0x80;
-                    }
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_004: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
-                    buffer[0] |= reserved << 4;
-
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_022: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_018: [ The length of the "Payload data", in bytes: ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_023: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
-                    /* Codes_SRS_UWS_FRAME_ENCODER_01_042: [ The payload length, indicated in the framing as frame-payload-length, does NOT include the length of the masking key. ]*/
-                    if (length > 65535)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_020: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-                        buffer[1] = 127;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
-                        buffer[2] = (unsigned char)((uint64_t)length >> 56) & 0xFF;
-                        buffer[3] = (unsigned char)((uint64_t)length >> 48) & 0xFF;
-                        buffer[4] = (unsigned char)((uint64_t)length >> 40) & 0xFF;
-                        buffer[5] = (unsigned char)((uint64_t)length >> 32) & 0xFF;
-                        buffer[6] = (unsigned char)((uint64_t)length >> 24) & 0xFF;
-                        buffer[7] = (unsigned char)((uint64_t)length >> 16) & 0xFF;
-                        buffer[8] = (unsigned char)((uint64_t)length >> 8) & 0xFF;
-                        buffer[9] = (unsigned char)(length & 0xFF);
-                    }
-                    else if (length > 125)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_019: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-                        buffer[1] = 126;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_021: [ Multibyte length quantities are expressed in network byte order. ]*/
-                        buffer[2] = (unsigned char)(length >> 8);
-                        buffer[3] = (unsigned char)(length & 0xFF);
-                    }
-                    else
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_043: [ if 0-125, that is the payload length. ]*/
-                        buffer[1] = (unsigned char)length;
-                    }
-
-                    if (is_masked)
-                    {
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_015: [ Defines whether the "Payload data" is masked. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_033: [ A masked frame MUST have the field frame-masked set to 1, as defined in Section 5.2. ]*/
-                        buffer[1] |= 0x80;
-
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, `gb_rand` shall be used 4 times (for each byte). ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_016: [ If set to 1, a masking key is present in masking-key, and this is used to unmask the "Payload data" as per Section 5.3. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_026: [ This field is present if the mask bit is set to 1 and is absent if the mask bit is set to 0. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_034: [ The masking key is contained completely within the frame, as defined in Section 5.2 as frame-masking-key. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_036: [ The masking key is a 32-bit value chosen at random by the client. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_037: [ When preparing a masked frame, the client MUST pick a fresh masking key from the set of allowed 32-bit values. ]*/
-                        /* Codes_SRS_UWS_FRAME_ENCODER_01_038: [ The masking key needs to be unpredictable; thus, the masking key MUST be derived from a strong source of entropy, and the masking key for a given frame MUST NOT make it simple for a server/proxy to predict the masking key for a subsequent frame. ]*/
-                        buffer[header_bytes - 4] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 3] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 2] = (unsigned char)gb_rand();
-                        buffer[header_bytes - 1] = (unsigned char)gb_rand();
-                    }
+                    write_header(buffer, header_bytes, opcode, length, is_masked, is_final, reserved);
 
                     if (length > 0)
                     {
                         if (is_masked)
                         {
-                            size_t i;
-
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_035: [ It is used to mask the "Payload data" defined in the same section as frame-payload-data, which includes "Extension data" and "Application data". ]*/
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_039: [ To convert masked data into unmasked data, or vice versa, the following algorithm is applied. ]*/
                             /* Codes_SRS_UWS_FRAME_ENCODER_01_040: [ The same algorithm applies regardless of the direction of the translation, e.g., the same steps are applied to mask the data as to unmask the data. ]*/
-                            for (i = 0; i < length; i++)
-                            {
-                                /* Codes_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
-                                buffer[header_bytes + i] = ((unsigned char*)payload)[i] ^ buffer[header_bytes - 4 + (i % 4)];
-                            }
+                            /* Codes_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
+                            uws_frame_encoder_mask(buffer + header_bytes, payload, length, buffer + header_bytes - 4, 0);
                         }
                         else
                         {
@@ -189,3 +284,51 @@ BUFFER_HANDLE uws_frame_encoder_encode(WS_FRAME_TYPE opcode, const unsigned char
 
     return result;
 }
+
+int uws_frame_encoder_encode_header(unsigned char* header, size_t header_size, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved, size_t* header_length)
+{
+    int result;
+
+    if ((header == NULL) ||
+        (header_length == NULL))
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_005: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: header=%p, header_length=%p", header, header_length);
+        result = __FAILURE__;
+    }
+    else if (reserved > 7)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_006: [ If `reserved` has any bits set except the lowest 3 then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Bad reserved value: 0x%02x", reserved);
+        result = __FAILURE__;
+    }
+    else if (opcode > 0x0F)
+    {
+        /* Codes_SRS_UWS_FRAME_ENCODER_02_007: [ If `opcode` is greater than 0x0F then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+        LogError("Invalid opcode: 0x%02x", opcode);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t needed_bytes = get_header_length(length, is_masked);
+
+        if (needed_bytes > header_size)
+        {
+            /* Codes_SRS_UWS_FRAME_ENCODER_02_008: [ If `header_size` is smaller than the header needed for `length` and `is_masked`, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+            LogError("Header needs %u bytes, only %u available", (unsigned int)needed_bytes, (unsigned int)header_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_FRAME_ENCODER_02_004: [ `uws_frame_encoder_encode_header` shall write into `header` the frame header that `uws_frame_encoder_encode` would produce for the same `opcode`, `length`, `is_masked`, `is_final` and `reserved`, without any payload bytes. ]*/
+            /* Codes_SRS_UWS_FRAME_ENCODER_02_009: [ When `is_masked` is true the masking key shall be the last 4 bytes of the header. ]*/
+            write_header(header, needed_bytes, opcode, length, is_masked, is_final, reserved);
+
+            /* Codes_SRS_UWS_FRAME_ENCODER_02_010: [ On success `uws_frame_encoder_encode_header` shall store the number of header bytes in `header_length` and return 0. ]*/
+            *header_length = needed_bytes;
+            result = 0;
+        }
+    }
+
+    return result;
+}
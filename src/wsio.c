@@ -19,6 +19,9 @@
 
 static const char* WSIO_OPTIONS = "WSIOOptions";
 
+/* completed pending IO records (and their list nodes) kept per instance for reuse, so that a steady stream of sends does not allocate */
+#define WSIO_MAX_POOLED_PENDING_IOS 16
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_NOT_OPEN,
@@ -33,6 +36,12 @@ typedef struct PENDING_IO_TAG
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
     void* wsio;
+    /* NULL once the pending IO was removed from the pending IO list */
+    LIST_ITEM_HANDLE list_item;
+    /* set when a close removed the pending IO while the uws instance still held it, only its send completion releases it then */
+    bool is_detached;
+    struct PENDING_IO_TAG* next_detached_pending_io;
+    struct PENDING_IO_TAG* next_pooled_pending_io;
 } PENDING_IO;
 
 typedef struct WSIO_INSTANCE_TAG
@@ -47,6 +56,12 @@ typedef struct WSIO_INSTANCE_TAG
     void* on_io_close_complete_context;
     IO_STATE io_state;
     SINGLYLINKEDLIST_HANDLE pending_io_list;
+    PENDING_IO* pooled_pending_ios;
+    size_t pooled_pending_io_count;
+    /* pending IO handed to uws_client_send_frame_async, cleared by its completion so that wsio_send knows the completion already happened */
+    PENDING_IO* send_in_progress;
+    /* pending IOs cancelled by a close before the uws instance completed them */
+    PENDING_IO* detached_pending_ios;
     UWS_CLIENT_HANDLE uws;
 } WSIO_INSTANCE;
 
@@ -61,25 +76,95 @@ static void indicate_open_complete(WSIO_INSTANCE* ws_io_instance, IO_OPEN_RESULT
     ws_io_instance->on_io_open_complete(ws_io_instance->on_io_open_complete_context, open_result);
 }
 
-static void complete_send_item(LIST_ITEM_HANDLE pending_io_list_item, IO_SEND_RESULT io_send_result)
+static PENDING_IO* get_pending_io(WSIO_INSTANCE* wsio_instance)
+{
+    PENDING_IO* result = wsio_instance->pooled_pending_ios;
+
+    if (result != NULL)
+    {
+        /* Codes_SRS_WSIO_01_189: [ If a pending IO record kept from an earlier send is available, `wsio_send` shall reuse it instead of allocating memory for the pending IO data. ]*/
+        wsio_instance->pooled_pending_ios = result->next_pooled_pending_io;
+        wsio_instance->pooled_pending_io_count--;
+    }
+    else
+    {
+        result = (PENDING_IO*)malloc(sizeof(PENDING_IO));
+    }
+
+    return result;
+}
+
+static void release_pending_io(WSIO_INSTANCE* wsio_instance, PENDING_IO* pending_io)
+{
+    if (wsio_instance->pooled_pending_io_count < WSIO_MAX_POOLED_PENDING_IOS)
+    {
+        pending_io->next_pooled_pending_io = wsio_instance->pooled_pending_ios;
+        wsio_instance->pooled_pending_ios = pending_io;
+        wsio_instance->pooled_pending_io_count++;
+    }
+    else
+    {
+        free(pending_io);
+    }
+}
+
+static void unlink_detached_pending_io(WSIO_INSTANCE* wsio_instance, PENDING_IO* pending_io)
+{
+    PENDING_IO** detached_pending_io = &wsio_instance->detached_pending_ios;
+
+    while (*detached_pending_io != NULL)
+    {
+        if (*detached_pending_io == pending_io)
+        {
+            *detached_pending_io = pending_io->next_detached_pending_io;
+            break;
+        }
+
+        detached_pending_io = &(*detached_pending_io)->next_detached_pending_io;
+    }
+
+    pending_io->is_detached = false;
+}
+
+static void complete_send_item(PENDING_IO* pending_io, IO_SEND_RESULT io_send_result)
 {
-    PENDING_IO* pending_io = (PENDING_IO*)singlylinkedlist_item_get_value(pending_io_list_item);
     WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)pending_io->wsio;
+    ON_SEND_COMPLETE on_send_complete = pending_io->on_send_complete;
+    void* callback_context = pending_io->callback_context;
 
-    /* Codes_SRS_WSIO_01_145: [ Removing it from the list shall be done by calling `singlylinkedlist_remove`. ]*/
-    if (singlylinkedlist_remove(wsio_instance->pending_io_list, pending_io_list_item) != 0)
+    if (pending_io->list_item != NULL)
     {
-        LogError("Failed removing pending IO from linked list.");
+        /* Codes_SRS_WSIO_01_145: [ Removing it from the list shall be done by calling `singlylinkedlist_remove`. ]*/
+        if (singlylinkedlist_remove(wsio_instance->pending_io_list, pending_io->list_item) != 0)
+        {
+            LogError("Failed removing pending IO from linked list.");
+        }
+
+        pending_io->list_item = NULL;
     }
 
-    /* Codes_SRS_WSIO_01_105: [ The argument `on_send_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
-    if (pending_io->on_send_complete != NULL)
+    if (pending_io->is_detached)
+    {
+        /* Codes_SRS_WSIO_01_192: [ When the uws instance completes a pending IO that was cancelled by `wsio_close`, the pending IO shall be released without calling `on_send_complete` again. ]*/
+        unlink_detached_pending_io(wsio_instance, pending_io);
+    }
+
+    if (wsio_instance->send_in_progress == pending_io)
+    {
+        /* completed from within its own send, wsio_send releases it once uws_client_send_frame_async returns */
+        wsio_instance->send_in_progress = NULL;
+    }
+    else
     {
-        pending_io->on_send_complete(pending_io->callback_context, io_send_result);
+        /* Codes_SRS_WSIO_01_144: [ Also the pending IO data shall be freed, unless fewer than the maximum number of pooled pending IO records are kept, in which case it shall be kept for reuse by a later `wsio_send`. ]*/
+        release_pending_io(wsio_instance, pending_io);
     }
 
-    /* Codes_SRS_WSIO_01_144: [ Also the pending IO data shall be freed. ]*/
-    free(pending_io);
+    /* Codes_SRS_WSIO_01_105: [ The argument `on_send_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
+    if (on_send_complete != NULL)
+    {
+        on_send_complete(callback_context, io_send_result);
+    }
 }
 
 static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result)
@@ -91,7 +176,7 @@ static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RE
     else
     {
         IO_SEND_RESULT io_send_result;
-        LIST_ITEM_HANDLE list_item_handle = (LIST_ITEM_HANDLE)context;
+        PENDING_IO* pending_io = (PENDING_IO*)context;
 
         /* Codes_SRS_WSIO_01_143: [ When `on_underlying_ws_send_frame_complete` is called after sending a WebSocket frame, the pending IO shall be removed from the list. ]*/
         switch (ws_send_frame_result)
@@ -113,7 +198,7 @@ static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RE
             break;
         }
 
-        complete_send_item(list_item_handle, io_send_result);
+        complete_send_item(pending_io, io_send_result);
     }
 }
 
@@ -190,7 +275,27 @@ static int internal_close(WSIO_INSTANCE* wsio_instance, ON_IO_CLOSE_COMPLETE on_
                 /* Codes_SRS_WSIO_01_092: [ Obtaining the head of the pending IO list shall be done by calling `singlylinkedlist_get_head_item`. ]*/
                 while ((first_pending_io = singlylinkedlist_get_head_item(wsio_instance->pending_io_list)) != NULL)
                 {
-                    complete_send_item(first_pending_io, IO_SEND_CANCELLED);
+                    PENDING_IO* pending_io = (PENDING_IO*)singlylinkedlist_item_get_value(first_pending_io);
+                    ON_SEND_COMPLETE on_send_complete = pending_io->on_send_complete;
+
+                    if (singlylinkedlist_remove(wsio_instance->pending_io_list, first_pending_io) != 0)
+                    {
+                        LogError("Failed removing pending IO from linked list.");
+                        break;
+                    }
+
+                    /* Codes_SRS_WSIO_01_191: [ The uws instance still holds the pending IOs left in the list, so each of them shall be kept until its send completes instead of being reused by a later `wsio_send`. ]*/
+                    pending_io->list_item = NULL;
+                    pending_io->on_send_complete = NULL;
+                    pending_io->is_detached = true;
+                    pending_io->next_detached_pending_io = wsio_instance->detached_pending_ios;
+                    wsio_instance->detached_pending_ios = pending_io;
+
+                    if (on_send_complete != NULL)
+                    {
+                        /* Codes_SRS_WSIO_01_093: [ For each pending item the send complete callback shall be called with `IO_SEND_CANCELLED`.]*/
+                        on_send_complete(pending_io->callback_context, IO_SEND_CANCELLED);
+                    }
                 }
 
                 /* Codes_SRS_WSIO_01_133: [ On success `wsio_close` shall return 0. ]*/
@@ -270,8 +375,22 @@ CONCRETE_IO_HANDLE wsio_create(void* io_create_parameters)
                     free(result);
                     result = NULL;
                 }
+                /* Codes_SRS_WSIO_01_187: [ `wsio_create` shall let the pending IO list keep its removed nodes for reuse by calling `singlylinkedlist_set_item_cache_size`. ]*/
+                else if (singlylinkedlist_set_item_cache_size(result->pending_io_list, WSIO_MAX_POOLED_PENDING_IOS) != 0)
+                {
+                    /* Codes_SRS_WSIO_01_188: [ If `singlylinkedlist_set_item_cache_size` fails then `wsio_create` shall fail and return NULL. ]*/
+                    LogError("Cannot set the item cache size of the pending IO list.");
+                    singlylinkedlist_destroy(result->pending_io_list);
+                    uws_client_destroy(result->uws);
+                    free(result);
+                    result = NULL;
+                }
                 else
                 {
+                    result->pooled_pending_ios = NULL;
+                    result->pooled_pending_io_count = 0;
+                    result->send_in_progress = NULL;
+                    result->detached_pending_ios = NULL;
                     result->io_state = IO_STATE_NOT_OPEN;
                 }
             }
@@ -302,6 +421,23 @@ void wsio_destroy(CONCRETE_IO_HANDLE ws_io)
         uws_client_destroy(wsio_instance->uws);
         /* Codes_SRS_WSIO_01_081: [ `wsio_destroy` shall free the list used to track the pending send IOs by calling `singlylinkedlist_destroy`. ]*/
         singlylinkedlist_destroy(wsio_instance->pending_io_list);
+
+        /* Codes_SRS_WSIO_01_190: [ `wsio_destroy` shall free the pending IO records kept for reuse. ]*/
+        while (wsio_instance->pooled_pending_ios != NULL)
+        {
+            PENDING_IO* pooled_pending_io = wsio_instance->pooled_pending_ios;
+            wsio_instance->pooled_pending_ios = pooled_pending_io->next_pooled_pending_io;
+            free(pooled_pending_io);
+        }
+
+        /* Codes_SRS_WSIO_01_193: [ `wsio_destroy` shall free the pending IOs cancelled by `wsio_close` that the uws instance did not complete. ]*/
+        while (wsio_instance->detached_pending_ios != NULL)
+        {
+            PENDING_IO* detached_pending_io = wsio_instance->detached_pending_ios;
+            wsio_instance->detached_pending_ios = detached_pending_io->next_detached_pending_io;
+            free(detached_pending_io);
+        }
+
         free(ws_io);
     }
 }
@@ -579,7 +715,7 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
         else
         {
             LIST_ITEM_HANDLE new_item;
-            PENDING_IO* pending_socket_io = (PENDING_IO*)malloc(sizeof(PENDING_IO));
+            PENDING_IO* pending_socket_io = get_pending_io(wsio_instance);
             if (pending_socket_io == NULL)
             {
                 /* Codes_SRS_WSIO_01_134: [ If allocating memory for the pending IO data fails, `wsio_send` shall fail and return a non-zero value. ]*/
@@ -591,27 +727,49 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
                 pending_socket_io->on_send_complete = on_send_complete;
                 pending_socket_io->callback_context = callback_context;
                 pending_socket_io->wsio = wsio_instance;
+                pending_socket_io->is_detached = false;
 
                 /* Codes_SRS_WSIO_01_102: [ An entry shall be queued in the singly linked list by calling `singlylinkedlist_add`. ]*/
                 if ((new_item = singlylinkedlist_add(wsio_instance->pending_io_list, pending_socket_io)) == NULL)
                 {
                     /* Codes_SRS_WSIO_01_104: [ If `singlylinkedlist_add` fails, `wsio_send` shall fail and return a non-zero value. ]*/
-                    free(pending_socket_io);
+                    release_pending_io(wsio_instance, pending_socket_io);
                     result = __FAILURE__;
                 }
                 else
                 {
+                    PENDING_IO* previous_send_in_progress = wsio_instance->send_in_progress;
+                    bool is_completed;
+                    int send_result;
+
+                    pending_socket_io->list_item = new_item;
+                    wsio_instance->send_in_progress = pending_socket_io;
+
                     /* Codes_SRS_WSIO_01_095: [ `wsio_send` shall call `uws_client_send_frame_async`, passing the `buffer` and `size` arguments as they are: ]*/
                     /* Codes_SRS_WSIO_01_097: [ The `is_final` argument shall be set to true. ]*/
                     /* Codes_SRS_WSIO_01_096: [ The frame type used shall be `WS_FRAME_TYPE_BINARY`. ]*/
-                    if (uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, new_item) != 0)
+                    send_result = uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, pending_socket_io);
+                    is_completed = (wsio_instance->send_in_progress != pending_socket_io);
+                    wsio_instance->send_in_progress = previous_send_in_progress;
+
+                    if (is_completed)
+                    {
+                        /* the send completed from within uws_client_send_frame_async, which left releasing the pending IO to wsio_send */
+                        release_pending_io(wsio_instance, pending_socket_io);
+                    }
+
+                    if (send_result != 0)
                     {
-                        if (singlylinkedlist_remove(wsio_instance->pending_io_list, new_item) != 0)
+                        if (!is_completed)
                         {
-                            LogError("Failed removing pending IO from linked list.");
+                            if (singlylinkedlist_remove(wsio_instance->pending_io_list, new_item) != 0)
+                            {
+                                LogError("Failed removing pending IO from linked list.");
+                            }
+
+                            release_pending_io(wsio_instance, pending_socket_io);
                         }
 
-                        free(pending_socket_io);
                         result = __FAILURE__;
                     }
                     else
@@ -647,6 +805,43 @@ void wsio_dowork(CONCRETE_IO_HANDLE ws_io)
     }
 }
 
+int wsio_wait(CONCRETE_IO_HANDLE ws_io, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (ws_io == NULL)
+    {
+        /* Codes_SRS_WSIO_11_002: [ If the `ws_io` argument is NULL, `wsio_wait` shall return a non-zero value. ]*/
+        LogError("NULL handle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)ws_io;
+
+        if (wsio_instance->io_state == IO_STATE_NOT_OPEN)
+        {
+            /* Codes_SRS_WSIO_11_003: [ If the IO is not yet open, `wsio_wait` shall return a non-zero value. ]*/
+            LogError("wsio_wait called while not open.");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_WSIO_11_001: [ `wsio_wait` shall call `uws_client_wait` with the uws handle created in `wsio_create`, passing `timeout_ms` and `interest` to it. ]*/
+        else if (uws_client_wait(wsio_instance->uws, timeout_ms, interest) != 0)
+        {
+            /* Codes_SRS_WSIO_11_004: [ If `uws_client_wait` fails, `wsio_wait` shall return a non-zero value. ]*/
+            LogError("Failed waiting on the uws instance.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_WSIO_11_005: [ On success, `wsio_wait` shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 int wsio_setoption(CONCRETE_IO_HANDLE ws_io, const char* optionName, const void* value)
 {
     int result;
@@ -814,10 +1009,12 @@ static const IO_INTERFACE_DESCRIPTION ws_io_interface_description =
     wsio_close,
     wsio_send,
     wsio_dowork,
-    wsio_setoption
+    wsio_setoption,
+    wsio_wait
 };
 
 const IO_INTERFACE_DESCRIPTION* wsio_get_interface_description(void)
 {
+    /* Codes_SRS_WSIO_11_006: [ The `concrete_io_wait` member of the structure shall point to `wsio_wait`. ]*/
     return &ws_io_interface_description;
 }
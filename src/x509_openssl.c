@@ -1,9 +1,14 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/x509_openssl.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/lock.h"
 #include "openssl/bio.h"
 #include "openssl/rsa.h"
 #include "openssl/x509.h"
@@ -30,6 +35,471 @@ void log_ERR_get_error(const char* message)
     }
 }
 
+static void clear_extra_chain_certs(SSL_CTX* ssl_ctx)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+    SSL_CTX_clear_extra_chain_certs(ssl_ctx);
+#else 
+    if (ssl_ctx->extra_certs != NULL)
+    {
+        sk_X509_pop_free(ssl_ctx->extra_certs, X509_free); 
+        ssl_ctx->extra_certs = NULL; 
+    }
+#endif 
+}
+
+/* Parsed certificates and keys, keyed by their PEM text, so that many SSL contexts built from the same strings parse them once (x509_openssl_cache_init) */
+#ifndef X509_OPENSSL_CACHE_MAX_ENTRIES
+#define X509_OPENSSL_CACHE_MAX_ENTRIES  64
+#endif
+
+/* a whole X509_STORE can only be handed to a context with SSL_CTX_set1_cert_store, which came with OpenSSL 1.1.1 */
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L) && !defined(LIBRESSL_VERSION_NUMBER)
+#define X509_OPENSSL_SHARED_STORE
+#endif
+
+typedef enum X509_OPENSSL_PEM_TYPE_TAG
+{
+    X509_OPENSSL_PEM_CERTIFICATE_CHAIN,
+    X509_OPENSSL_PEM_RSA_PRIVATE_KEY,
+    X509_OPENSSL_PEM_PRIVATE_KEY,
+    X509_OPENSSL_PEM_TRUSTED_CERTIFICATES
+} X509_OPENSSL_PEM_TYPE;
+
+typedef struct X509_OPENSSL_CACHE_ENTRY_TAG
+{
+    struct X509_OPENSSL_CACHE_ENTRY_TAG* next;
+    X509_OPENSSL_PEM_TYPE pem_type;
+    uint32_t hash;
+    char* pem;
+    /* for a certificate chain the first one is the leaf certificate */
+    X509** certificates;
+    size_t certificate_count;
+    RSA* rsa_private_key;
+    EVP_PKEY* private_key;
+    X509_STORE* certificate_store;
+} X509_OPENSSL_CACHE_ENTRY;
+
+static LOCK_HANDLE x509_cache_lock = NULL;
+static size_t x509_cache_init_count = 0;
+/* most recently used first */
+static X509_OPENSSL_CACHE_ENTRY* x509_cache_entries = NULL;
+static size_t x509_cache_count = 0;
+
+static uint32_t hash_pem(X509_OPENSSL_PEM_TYPE pem_type, const char* pem)
+{
+    /* FNV-1a */
+    uint32_t hash = 2166136261u ^ (uint32_t)pem_type;
+
+    while (*pem != '\0')
+    {
+        hash ^= (unsigned char)*pem++;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void x509_up_ref(X509* certificate)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    (void)X509_up_ref(certificate);
+#else
+    (void)CRYPTO_add(&certificate->references, 1, CRYPTO_LOCK_X509);
+#endif
+}
+
+static void free_cache_entry(X509_OPENSSL_CACHE_ENTRY* entry)
+{
+    size_t i;
+
+    for (i = 0; i < entry->certificate_count; i++)
+    {
+        X509_free(entry->certificates[i]);
+    }
+    free(entry->certificates);
+    if (entry->rsa_private_key != NULL)
+    {
+        RSA_free(entry->rsa_private_key);
+    }
+    if (entry->private_key != NULL)
+    {
+        EVP_PKEY_free(entry->private_key);
+    }
+#ifdef X509_OPENSSL_SHARED_STORE
+    if (entry->certificate_store != NULL)
+    {
+        X509_STORE_free(entry->certificate_store);
+    }
+#endif
+    free(entry->pem);
+    free(entry);
+}
+
+static int add_certificate_to_cache_entry(X509_OPENSSL_CACHE_ENTRY* entry, X509* certificate)
+{
+    int result;
+    X509** new_certificates = (X509**)realloc(entry->certificates, (entry->certificate_count + 1) * sizeof(X509*));
+
+    if (new_certificates == NULL)
+    {
+        LogError("Failed allocating memory for a cached certificate.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        entry->certificates = new_certificates;
+        entry->certificates[entry->certificate_count++] = certificate;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int read_cached_certificates(X509_OPENSSL_CACHE_ENTRY* entry, BIO* bio)
+{
+    int result = 0;
+    X509* certificate;
+
+    /* the leaf of a chain carries the trust settings, the same way load_certificate_chain reads it */
+    certificate = (entry->pem_type == X509_OPENSSL_PEM_CERTIFICATE_CHAIN) ?
+        PEM_read_bio_X509_AUX(bio, NULL, NULL, NULL) :
+        PEM_read_bio_X509(bio, NULL, NULL, NULL);
+
+    while ((result == 0) && (certificate != NULL))
+    {
+        if (add_certificate_to_cache_entry(entry, certificate) != 0)
+        {
+            X509_free(certificate);
+            result = __FAILURE__;
+        }
+        else
+        {
+            certificate = PEM_read_bio_X509(bio, NULL, NULL, NULL);
+        }
+    }
+
+    if ((result == 0) &&
+        (entry->pem_type == X509_OPENSSL_PEM_CERTIFICATE_CHAIN) &&
+        (entry->certificate_count == 0))
+    {
+        log_ERR_get_error("Failure PEM_read_bio_X509_AUX");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* running out of certificates ends the loop with a PEM_R_NO_START_LINE error, which is not one */
+        unsigned long err_value = ERR_peek_last_error();
+        if ((ERR_GET_LIB(err_value) == ERR_LIB_PEM) && (ERR_GET_REASON(err_value) == PEM_R_NO_START_LINE))
+        {
+            ERR_clear_error();
+        }
+    }
+
+    return result;
+}
+
+static X509_OPENSSL_CACHE_ENTRY* create_cache_entry(X509_OPENSSL_PEM_TYPE pem_type, const char* pem, uint32_t hash)
+{
+    X509_OPENSSL_CACHE_ENTRY* result = (X509_OPENSSL_CACHE_ENTRY*)malloc(sizeof(X509_OPENSSL_CACHE_ENTRY));
+    size_t pem_length = strlen(pem);
+
+    if (result == NULL)
+    {
+        LogError("Failed allocating a certificate cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(X509_OPENSSL_CACHE_ENTRY));
+        result->pem_type = pem_type;
+        result->hash = hash;
+
+        if ((result->pem = (char*)malloc(pem_length + 1)) == NULL)
+        {
+            LogError("Failed allocating the PEM copy of a certificate cache entry.");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            BIO* bio;
+            int parse_result;
+
+            (void)memcpy(result->pem, pem, pem_length + 1);
+
+            if ((bio = BIO_new_mem_buf((char*)pem, -1)) == NULL)
+            {
+                log_ERR_get_error("cannot create BIO");
+                parse_result = __FAILURE__;
+            }
+            else
+            {
+                switch (pem_type)
+                {
+                default:
+                case X509_OPENSSL_PEM_CERTIFICATE_CHAIN:
+                case X509_OPENSSL_PEM_TRUSTED_CERTIFICATES:
+                    parse_result = read_cached_certificates(result, bio);
+                    break;
+
+                case X509_OPENSSL_PEM_RSA_PRIVATE_KEY:
+                    if ((result->rsa_private_key = PEM_read_bio_RSAPrivateKey(bio, NULL, 0, NULL)) == NULL)
+                    {
+                        log_ERR_get_error("cannot create RSA* privatekey");
+                        parse_result = __FAILURE__;
+                    }
+                    else
+                    {
+                        parse_result = 0;
+                    }
+                    break;
+
+                case X509_OPENSSL_PEM_PRIVATE_KEY:
+                    if ((result->private_key = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL)) == NULL)
+                    {
+                        log_ERR_get_error("Failed PEM_read_bio_PrivateKey");
+                        parse_result = __FAILURE__;
+                    }
+                    else
+                    {
+                        parse_result = 0;
+                    }
+                    break;
+                }
+
+                BIO_free(bio);
+            }
+
+#ifdef X509_OPENSSL_SHARED_STORE
+            if ((parse_result == 0) &&
+                (pem_type == X509_OPENSSL_PEM_TRUSTED_CERTIFICATES))
+            {
+                if ((result->certificate_store = X509_STORE_new()) == NULL)
+                {
+                    log_ERR_get_error("failure in X509_STORE_new");
+                    parse_result = __FAILURE__;
+                }
+                else
+                {
+                    size_t i;
+
+                    for (i = 0; i < result->certificate_count; i++)
+                    {
+                        if ((!X509_STORE_add_cert(result->certificate_store, result->certificates[i])) &&
+                            (ERR_GET_REASON(ERR_peek_error()) != X509_R_CERT_ALREADY_IN_HASH_TABLE))
+                        {
+                            log_ERR_get_error("failure in X509_STORE_add_cert");
+                            parse_result = __FAILURE__;
+                            break;
+                        }
+                    }
+
+                    /*Codes_SRS_X509_OPENSSL_02_029: [ When the shared X509_STORE is created, the default locations for CA certificates shall be loaded into it once. ]*/
+                    if ((parse_result == 0) &&
+                        (X509_STORE_set_default_paths(result->certificate_store) != 1))
+                    {
+                        /* This is only a warning to the user, the trusted certificates are in the store. */
+                        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+                    }
+                }
+            }
+#endif
+
+            if (parse_result != 0)
+            {
+                free_cache_entry(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Must be called with x509_cache_lock held. The entry stays valid until the lock is released. */
+static X509_OPENSSL_CACHE_ENTRY* get_cache_entry(X509_OPENSSL_PEM_TYPE pem_type, const char* pem)
+{
+    X509_OPENSSL_CACHE_ENTRY* result = x509_cache_entries;
+    X509_OPENSSL_CACHE_ENTRY* previous = NULL;
+    uint32_t hash = hash_pem(pem_type, pem);
+
+    while ((result != NULL) &&
+        ((result->hash != hash) || (result->pem_type != pem_type) || (strcmp(result->pem, pem) != 0)))
+    {
+        previous = result;
+        result = result->next;
+    }
+
+    if (result != NULL)
+    {
+        if (previous != NULL)
+        {
+            previous->next = result->next;
+            result->next = x509_cache_entries;
+            x509_cache_entries = result;
+        }
+    }
+    else if ((result = create_cache_entry(pem_type, pem, hash)) != NULL)
+    {
+        result->next = x509_cache_entries;
+        x509_cache_entries = result;
+        x509_cache_count++;
+
+        if (x509_cache_count > X509_OPENSSL_CACHE_MAX_ENTRIES)
+        {
+            /* drop the least recently used entry, the contexts that use its objects hold their own references */
+            X509_OPENSSL_CACHE_ENTRY* last = x509_cache_entries;
+            while (last->next->next != NULL)
+            {
+                last = last->next;
+            }
+            free_cache_entry(last->next);
+            last->next = NULL;
+            x509_cache_count--;
+        }
+    }
+
+    return result;
+}
+
+static int add_cached_certificates_to_store(X509_STORE* cert_store, const X509_OPENSSL_CACHE_ENTRY* entry)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < entry->certificate_count; i++)
+    {
+        /* X509_STORE_add_cert takes its own reference */
+        if ((!X509_STORE_add_cert(cert_store, entry->certificates[i])) &&
+            (ERR_GET_REASON(ERR_peek_error()) != X509_R_CERT_ALREADY_IN_HASH_TABLE))
+        {
+            log_ERR_get_error("failure in X509_STORE_add_cert");
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int use_cached_certificate_chain(SSL_CTX* ssl_ctx, const X509_OPENSSL_CACHE_ENTRY* entry)
+{
+    int result;
+
+    if (SSL_CTX_use_certificate(ssl_ctx, entry->certificates[0]) != 1)
+    {
+        log_ERR_get_error("Failure SSL_CTX_use_certificate");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        result = 0;
+
+        clear_extra_chain_certs(ssl_ctx);
+        for (i = 1; i < entry->certificate_count; i++)
+        {
+            /* the context takes ownership of extra chain certificates, it gets a reference of its own */
+            x509_up_ref(entry->certificates[i]);
+            if (SSL_CTX_add_extra_chain_cert(ssl_ctx, entry->certificates[i]) != 1)
+            {
+                X509_free(entry->certificates[i]);
+                log_ERR_get_error("Failure SSL_CTX_add_extra_chain_cert");
+                result = __FAILURE__;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int use_cached_pem(SSL_CTX* ssl_ctx, X509_OPENSSL_PEM_TYPE pem_type, const char* pem, bool share_store)
+{
+    int result;
+
+    if (Lock(x509_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the certificate cache.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        X509_OPENSSL_CACHE_ENTRY* entry = get_cache_entry(pem_type, pem);
+        if (entry == NULL)
+        {
+            LogError("Failed getting the parsed certificates from the cache.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            switch (pem_type)
+            {
+            default:
+            case X509_OPENSSL_PEM_CERTIFICATE_CHAIN:
+                result = use_cached_certificate_chain(ssl_ctx, entry);
+                break;
+
+            case X509_OPENSSL_PEM_RSA_PRIVATE_KEY:
+                /* both take their own reference to the key */
+                if (SSL_CTX_use_RSAPrivateKey(ssl_ctx, entry->rsa_private_key) != 1)
+                {
+                    log_ERR_get_error("cannot SSL_CTX_use_RSAPrivateKey");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+                break;
+
+            case X509_OPENSSL_PEM_PRIVATE_KEY:
+                if (SSL_CTX_use_PrivateKey(ssl_ctx, entry->private_key) != 1)
+                {
+                    LogError("Failed SSL_CTX_use_PrivateKey");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+                break;
+
+            case X509_OPENSSL_PEM_TRUSTED_CERTIFICATES:
+#ifdef X509_OPENSSL_SHARED_STORE
+                if (share_store)
+                {
+                    /* the context takes a reference to the store, every context built from the same trusted certificates shares it */
+                    SSL_CTX_set1_cert_store(ssl_ctx, entry->certificate_store);
+                    result = 0;
+                }
+                else
+#else
+                (void)share_store;
+#endif
+                {
+                    X509_STORE* cert_store = SSL_CTX_get_cert_store(ssl_ctx);
+                    if (cert_store == NULL)
+                    {
+                        log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        result = add_cached_certificates_to_store(cert_store, entry);
+                    }
+                }
+                break;
+            }
+        }
+
+        (void)Unlock(x509_cache_lock);
+    }
+
+    return result;
+}
+
 static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* ecc_cert)
 {
     int result;
@@ -67,15 +537,7 @@ static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* ecc_cert)
                 // certificates.
                 
                 /* Codes_SRS_X509_OPENSSL_07_006: [ If successful x509_openssl_add_ecc_credentials shall to import each certificate in the cert chain. ] */
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-                SSL_CTX_clear_extra_chain_certs(ssl_ctx);
-#else 
-                if (ssl_ctx->extra_certs != NULL)
-                {
-                    sk_X509_pop_free(ssl_ctx->extra_certs, X509_free); 
-                    ssl_ctx->extra_certs = NULL; 
-                }
-#endif 
+                clear_extra_chain_certs(ssl_ctx);
                 while ((ca_chain = PEM_read_bio_X509(bio_cert, NULL, NULL, NULL)) != NULL)
                 {
                     if (SSL_CTX_add_extra_chain_cert(ssl_ctx, ca_chain) != 1)
@@ -204,6 +666,24 @@ int x509_openssl_add_ecc_credentials(SSL_CTX* ssl_ctx, const char* ecc_alias_cer
         LogError("invalid parameter detected: SSL_CTX* ssl_ctx=%p, const char* ecc_alias_key=%p, const char* ecc_alias_cert=%p", ssl_ctx, ecc_alias_key, ecc_alias_cert);
         result = __FAILURE__;
     }
+    else if (x509_cache_lock != NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_07_008: [ If the cache is initialized, x509_openssl_add_ecc_credentials shall parse ecc_alias_key and ecc_alias_cert only if they are not in the cache yet and load the cached objects into ssl_ctx. ] */
+        if (use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_PRIVATE_KEY, ecc_alias_key, false) != 0)
+        {
+            LogError("failure loading private key cert");
+            result = __FAILURE__;
+        }
+        else if (use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_CERTIFICATE_CHAIN, ecc_alias_cert, false) != 0)
+        {
+            LogError("failure loading private key cert");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
     else
     {
         if (load_alias_key_cert(ssl_ctx, ecc_alias_key) != 0)
@@ -241,6 +721,24 @@ int x509_openssl_add_credentials(SSL_CTX* ssl_ctx, const char* x509certificate,
         LogError("invalid parameter detected: SSL_CTX* ssl_ctx=%p, const char* x509certificate=%p, const char* x509privatekey=%p", ssl_ctx, x509certificate, x509privatekey);
         result = __FAILURE__;
     }
+    else if (x509_cache_lock != NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_020: [ If the cache is initialized, x509_openssl_add_credentials shall parse x509certificate and x509privatekey only if they are not in the cache yet and load the cached objects into ssl_ctx. ]*/
+        if (use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_RSA_PRIVATE_KEY, x509privatekey, false) != 0)
+        {
+            LogError("failure loading private key cert");
+            result = __FAILURE__;
+        }
+        else if (use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_CERTIFICATE_CHAIN, x509certificate, false) != 0)
+        {
+            LogError("failure loading private key cert");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
     else
     { 
         if (load_private_key_RSA(ssl_ctx, x509privatekey) != 0)
@@ -274,6 +772,11 @@ int x509_openssl_add_certificates(SSL_CTX* ssl_ctx, const char* certificates)
         LogError("invalid argument SSL_CTX* ssl_ctx=%p, const char* certificates=%s", ssl_ctx, P_OR_NULL(certificates));
         result = __FAILURE__;
     }
+    else if (x509_cache_lock != NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_021: [ If the cache is initialized, x509_openssl_add_certificates shall parse certificates only if they are not in the cache yet and add the cached certificates to the store of ssl_ctx. ]*/
+        result = use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_TRUSTED_CERTIFICATES, certificates, false);
+    }
     else
     {
         X509_STORE* cert_store = SSL_CTX_get_cert_store(ssl_ctx);
@@ -368,3 +871,95 @@ int x509_openssl_add_certificates(SSL_CTX* ssl_ctx, const char* certificates)
 
 }
 
+static void set_default_verify_paths(SSL_CTX* ssl_ctx)
+{
+    if (SSL_CTX_set_default_verify_paths(ssl_ctx) != 1)
+    {
+        // This is only a warning to the user. They can still specify the certificate via SetOption.
+        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+    }
+}
+
+int x509_openssl_use_shared_certificates(SSL_CTX* ssl_ctx, const char* certificates)
+{
+    int result;
+
+    /*Codes_SRS_X509_OPENSSL_02_022: [ If ssl_ctx or certificates is NULL then x509_openssl_use_shared_certificates shall fail and return a non-zero value. ]*/
+    if ((certificates == NULL) || (ssl_ctx == NULL))
+    {
+        LogError("invalid argument SSL_CTX* ssl_ctx=%p, const char* certificates=%s", ssl_ctx, P_OR_NULL(certificates));
+        result = __FAILURE__;
+    }
+    else if (x509_cache_lock == NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_023: [ If the cache is not initialized, x509_openssl_use_shared_certificates shall behave like x509_openssl_add_certificates. ]*/
+        result = x509_openssl_add_certificates(ssl_ctx, certificates);
+        /*Codes_SRS_X509_OPENSSL_02_030: [ When the store of ssl_ctx is not shared, x509_openssl_use_shared_certificates shall load the default locations for CA certificates into it with SSL_CTX_set_default_verify_paths. ]*/
+        if (result == 0)
+        {
+            set_default_verify_paths(ssl_ctx);
+        }
+    }
+    else
+    {
+        /*Codes_SRS_X509_OPENSSL_02_024: [ Otherwise x509_openssl_use_shared_certificates shall replace the certificate store of ssl_ctx with the X509_STORE cached for certificates, creating it on first use. ]*/
+        /*Codes_SRS_X509_OPENSSL_02_025: [ If the OpenSSL in use cannot share a certificate store between contexts, x509_openssl_use_shared_certificates shall add the cached certificates to the store of ssl_ctx instead. ]*/
+        result = use_cached_pem(ssl_ctx, X509_OPENSSL_PEM_TRUSTED_CERTIFICATES, certificates, true);
+#ifndef X509_OPENSSL_SHARED_STORE
+        /*Codes_SRS_X509_OPENSSL_02_030: [ When the store of ssl_ctx is not shared, x509_openssl_use_shared_certificates shall load the default locations for CA certificates into it with SSL_CTX_set_default_verify_paths. ]*/
+        if (result == 0)
+        {
+            set_default_verify_paths(ssl_ctx);
+        }
+#endif
+    }
+
+    return result;
+}
+
+int x509_openssl_cache_init(void)
+{
+    int result;
+
+    /*Codes_SRS_X509_OPENSSL_02_026: [ x509_openssl_cache_init shall create the lock guarding the cache the first time it is called and count the calls after that. ]*/
+    if (x509_cache_init_count > 0)
+    {
+        x509_cache_init_count++;
+        result = 0;
+    }
+    else if ((x509_cache_lock = Lock_Init()) == NULL)
+    {
+        /*Codes_SRS_X509_OPENSSL_02_027: [ If creating the lock fails, x509_openssl_cache_init shall fail and return a non-zero value. ]*/
+        LogError("Failed creating the certificate cache lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        x509_cache_init_count = 1;
+        result = 0;
+    }
+
+    return result;
+}
+
+void x509_openssl_cache_deinit(void)
+{
+    /*Codes_SRS_X509_OPENSSL_02_028: [ When called as many times as x509_openssl_cache_init succeeded, x509_openssl_cache_deinit shall release every cached object and the lock. ]*/
+    if (x509_cache_init_count > 0)
+    {
+        x509_cache_init_count--;
+        if (x509_cache_init_count == 0)
+        {
+            while (x509_cache_entries != NULL)
+            {
+                X509_OPENSSL_CACHE_ENTRY* entry = x509_cache_entries;
+                x509_cache_entries = entry->next;
+                free_cache_entry(entry);
+            }
+            x509_cache_count = 0;
+
+            (void)Lock_Deinit(x509_cache_lock);
+            x509_cache_lock = NULL;
+        }
+    }
+}
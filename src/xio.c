@@ -166,6 +166,38 @@ void xio_dowork(XIO_HANDLE xio)
     }
 }
 
+int xio_wait(XIO_HANDLE xio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    int result;
+
+    if (xio == NULL)
+    {
+        /* Codes_SRS_XIO_11_001: [If the xio argument is NULL, xio_wait shall return a non-zero value.] */
+        LogError("invalid argument detected: XIO_HANDLE xio=%p", xio);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        if (xio_instance->io_interface_description->concrete_io_wait == NULL)
+        {
+            /* Codes_SRS_XIO_11_002: [If the concrete IO implementation does not provide concrete_io_wait, xio_wait shall return a non-zero value.] */
+            LogError("concrete IO does not support waiting");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_11_003: [xio_wait shall call the concrete_io_wait function specified in xio_create, passing the timeout_ms and interest arguments.] */
+            /* Codes_SRS_XIO_11_004: [On success, xio_wait shall return 0.] */
+            /* Codes_SRS_XIO_11_005: [If the underlying concrete_io_wait fails, xio_wait shall return a non-zero value.] */
+            result = xio_instance->io_interface_description->concrete_io_wait(xio_instance->concrete_xio_handle, timeout_ms, interest);
+        }
+    }
+
+    return result;
+}
+
 int xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
 {
     int result;
@@ -336,6 +336,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SOCKETIO_CONFIG*, const SOCKETIO_CONFIG*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
@@ -1439,6 +1440,97 @@ TEST_FUNCTION(http_proxy_io_dowork_when_closed_does_nothing)
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* http_proxy_io_wait */
+
+/* Tests_SRS_HTTP_PROXY_IO_11_001: [ `http_proxy_io_wait` shall call `xio_wait` on the underlying IO created in `http_proxy_io_create`, passing `timeout_ms` and `interest` to it. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_11_005: [ On success, `http_proxy_io_wait` shall return 0. ]*/
+TEST_FUNCTION(http_proxy_io_wait_calls_the_underlying_IO_wait)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_io_open_complete_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ));
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_wait(http_io, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_11_002: [ If the `http_proxy_io` argument is NULL, `http_proxy_io_wait` shall return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_wait_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_wait(NULL, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_11_003: [ If the IO is not open (no open has been called or the IO has been closed) then `http_proxy_io_wait` shall return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_wait_when_not_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_wait(http_io, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_11_004: [ If `xio_wait` fails, `http_proxy_io_wait` shall return a non-zero value. ]*/
+TEST_FUNCTION(when_the_underlying_xio_wait_fails_http_proxy_io_wait_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_io_open_complete_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ_WRITE))
+        .SetReturn(1);
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_wait(http_io, 100, IO_WAIT_READ_WRITE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
 /* http_proxy_io_set_option */
 
 /* Tests_SRS_HTTP_PROXY_IO_01_040: [ If any of the arguments `http_proxy_io` or `option_name` is NULL, `http_proxy_io_set_option` shall return a non-zero value. ]*/
@@ -1635,6 +1727,20 @@ TEST_FUNCTION(http_proxy_io_get_interface_description_returns_a_structure_with_n
     ASSERT_IS_NOT_NULL(io_interface->concrete_io_retrieveoptions);
 }
 
+/* Tests_SRS_HTTP_PROXY_IO_11_006: [ The `concrete_io_wait` member of the structure shall point to `http_proxy_io_wait`. ]*/
+TEST_FUNCTION(http_proxy_io_get_interface_description_provides_a_wait_function)
+{
+    // arrange
+    const IO_INTERFACE_DESCRIPTION* io_interface;
+
+    // act
+    io_interface = http_proxy_io_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(io_interface);
+    ASSERT_IS_NOT_NULL(io_interface->concrete_io_wait);
+}
+
 /* on_underlying_io_open_complete */
 
 /* Tests_SRS_HTTP_PROXY_IO_01_081: [ `on_underlying_io_open_complete` called with NULL context shall do nothing. ]*/
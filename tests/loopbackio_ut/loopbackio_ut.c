@@ -0,0 +1,1269 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/optionhandler.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/loopbackio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_TICK_COUNTER_HANDLE    (TICK_COUNTER_HANDLE)0x4242
+#define TEST_OPTION_HANDLER         (OPTIONHANDLER_HANDLE)0x4244
+
+static tickcounter_ms_t g_current_ms;
+
+static tickcounter_ms_t g_current_ms;
+static int g_tickcounter_result;
+static bool g_fail_malloc;
+static size_t g_sleep_count;
+static unsigned int g_sleep_ms;
+
+static const IO_INTERFACE_DESCRIPTION* g_loopbackio;
+static LOOPBACKIO_PAIR_HANDLE g_pair;
+static CONCRETE_IO_HANDLE g_endpoint_a;
+static CONCRETE_IO_HANDLE g_endpoint_b;
+
+static size_t g_open_complete_count;
+static IO_OPEN_RESULT g_open_result;
+static size_t g_close_complete_count;
+static size_t g_io_error_count;
+static size_t g_send_complete_count;
+static IO_SEND_RESULT g_send_result;
+static size_t g_bytes_received_count;
+static unsigned char g_received_bytes[1024];
+static size_t g_received_size;
+static size_t g_last_received_chunk_size;
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return g_fail_malloc ? NULL : real_malloc(size);
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return g_tickcounter_result;
+}
+
+static void my_ThreadAPI_Sleep(unsigned int milliseconds)
+{
+    g_sleep_count++;
+    g_sleep_ms = milliseconds;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_open_complete_count++;
+    g_open_result = open_result;
+}
+
+static void test_on_io_close_complete(void* context)
+{
+    (void)context;
+    g_close_complete_count++;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    g_io_error_count++;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_send_complete_count++;
+    g_send_result = send_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    g_bytes_received_count++;
+    g_last_received_chunk_size = size;
+    if (g_received_size + size <= sizeof(g_received_bytes))
+    {
+        (void)memcpy(g_received_bytes + g_received_size, buffer, size);
+        g_received_size += size;
+    }
+}
+
+static CONCRETE_IO_HANDLE create_endpoint(LOOPBACKIO_PAIR_HANDLE pair, LOOPBACKIO_ENDPOINT endpoint)
+{
+    LOOPBACKIO_CONFIG config;
+    config.pair = pair;
+    config.endpoint = endpoint;
+    return g_loopbackio->concrete_io_create(&config);
+}
+
+static int open_endpoint(CONCRETE_IO_HANDLE endpoint)
+{
+    return g_loopbackio->concrete_io_open(endpoint, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+}
+
+/* creates g_pair and its two endpoints (opening them if requested); whatever is left is destroyed by the test cleanup */
+static void create_test_pair(unsigned int latency_ms, size_t bytes_per_second, size_t max_chunk_size, bool open_endpoints)
+{
+    LOOPBACKIO_LINK_OPTIONS link_options;
+    link_options.latency_ms = latency_ms;
+    link_options.bytes_per_second = bytes_per_second;
+    link_options.max_chunk_size = max_chunk_size;
+    g_pair = loopbackio_pair_create(&link_options);
+    g_endpoint_a = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+    g_endpoint_b = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_B);
+    if (open_endpoints)
+    {
+        (void)open_endpoint(g_endpoint_a);
+        (void)open_endpoint(g_endpoint_b);
+        g_open_complete_count = 0;
+    }
+
+    umock_c_reset_all_calls();
+}
+
+static void send_bytes(CONCRETE_IO_HANDLE endpoint, const unsigned char* bytes, size_t size)
+{
+    (void)g_loopbackio->concrete_io_send(endpoint, bytes, size, test_on_send_complete, NULL);
+}
+
+/* transmits what A has pending and delivers what is deliverable to B */
+static void transfer_a_to_b(void)
+{
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(loopbackio_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Sleep, my_ThreadAPI_Sleep);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTION_HANDLER);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
+
+    g_loopbackio = loopbackio_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+
+    g_current_ms = 1000;
+    g_tickcounter_result = 0;
+    g_fail_malloc = false;
+    g_sleep_count = 0;
+    g_sleep_ms = 0;
+    g_pair = NULL;
+    g_endpoint_a = NULL;
+    g_endpoint_b = NULL;
+    g_open_complete_count = 0;
+    g_open_result = IO_OPEN_ERROR;
+    g_close_complete_count = 0;
+    g_io_error_count = 0;
+    g_send_complete_count = 0;
+    g_send_result = IO_SEND_ERROR;
+    g_bytes_received_count = 0;
+    g_received_size = 0;
+    g_last_received_chunk_size = 0;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    umock_c_negative_tests_deinit();
+
+    g_fail_malloc = false;
+    g_tickcounter_result = 0;
+    g_loopbackio->concrete_io_destroy(g_endpoint_a);
+    g_loopbackio->concrete_io_destroy(g_endpoint_b);
+    loopbackio_pair_destroy(g_pair);
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* loopbackio_pair_create */
+
+/* Tests_SRS_LOOPBACKIO_11_001: [ `loopbackio_pair_create` shall create a new loopback pair whose two directions both use the characteristics in `link_options`. ]*/
+/* Tests_SRS_LOOPBACKIO_11_004: [ `loopbackio_pair_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+/* Tests_SRS_LOOPBACKIO_11_005: [ `loopbackio_pair_create` shall create one in flight list per direction by calling `singlylinkedlist_create`. ]*/
+TEST_FUNCTION(loopbackio_pair_create_succeeds)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 0, 0, 0 };
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+
+    // act
+    g_pair = loopbackio_pair_create(&link_options);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_pair);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_002: [ If `link_options` is NULL, `loopbackio_pair_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(loopbackio_pair_create_with_NULL_link_options_fails)
+{
+    // arrange
+
+    // act
+    LOOPBACKIO_PAIR_HANDLE pair = loopbackio_pair_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(pair);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_003: [ If any error occurs, `loopbackio_pair_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_loopbackio_pair_create_fails_then_loopbackio_pair_create_fails)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 0, 0, 0 };
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        LOOPBACKIO_PAIR_HANDLE pair;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        pair = loopbackio_pair_create(&link_options);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(pair, temp_str);
+    }
+}
+
+/* loopbackio_pair_destroy */
+
+/* Tests_SRS_LOOPBACKIO_11_007: [ If `pair` is NULL, `loopbackio_pair_destroy` shall do nothing. ]*/
+TEST_FUNCTION(loopbackio_pair_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    loopbackio_pair_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_006: [ `loopbackio_pair_destroy` shall free all data in flight, the in flight lists, the tick counter and the pair. ]*/
+TEST_FUNCTION(loopbackio_pair_destroy_frees_the_data_in_flight)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 50, 0, 0 };
+    unsigned char bytes[] = { 0x42, 0x43 };
+    CONCRETE_IO_HANDLE endpoint_a;
+    g_pair = loopbackio_pair_create(&link_options);
+    endpoint_a = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+    (void)open_endpoint(endpoint_a);
+    send_bytes(endpoint_a, bytes, sizeof(bytes));
+    g_loopbackio->concrete_io_dowork(endpoint_a);
+    g_loopbackio->concrete_io_destroy(endpoint_a);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    loopbackio_pair_destroy(g_pair);
+    g_pair = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_008: [ Endpoints that still exist shall be detached from the pair; afterwards they can only be closed and destroyed. ]*/
+/* Tests_SRS_LOOPBACKIO_11_023: [ If the pair has been destroyed, `loopbackio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(endpoints_outliving_the_pair_can_only_be_closed_and_destroyed)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int send_result;
+    int close_result;
+    int open_result;
+    create_test_pair(0, 0, 0, true);
+
+    // act
+    loopbackio_pair_destroy(g_pair);
+    g_pair = NULL;
+    send_result = g_loopbackio->concrete_io_send(g_endpoint_a, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+    close_result = g_loopbackio->concrete_io_close(g_endpoint_a, test_on_io_close_complete, NULL);
+    open_result = open_endpoint(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, send_result);
+    ASSERT_ARE_EQUAL(int, 0, close_result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_close_complete_count);
+    ASSERT_ARE_NOT_EQUAL(int, 0, open_result);
+}
+
+/* loopbackio_create */
+
+/* Tests_SRS_LOOPBACKIO_11_010: [ `loopbackio_create` shall create a new IO bound to the `endpoint` of `pair` given in the `LOOPBACKIO_CONFIG*` passed as `io_create_parameters`. ]*/
+/* Tests_SRS_LOOPBACKIO_11_015: [ `loopbackio_create` shall create the list of pending sends by calling `singlylinkedlist_create`. ]*/
+TEST_FUNCTION(loopbackio_create_succeeds)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 0, 0, 0 };
+    g_pair = loopbackio_pair_create(&link_options);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+
+    // act
+    g_endpoint_a = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_endpoint_a);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_011: [ If `io_create_parameters` is NULL, `loopbackio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(loopbackio_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+
+    // act
+    CONCRETE_IO_HANDLE result = g_loopbackio->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_012: [ If the `pair` member is NULL or `endpoint` is neither `LOOPBACKIO_ENDPOINT_A` nor `LOOPBACKIO_ENDPOINT_B`, `loopbackio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(loopbackio_create_with_invalid_config_fails)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 0, 0, 0 };
+    CONCRETE_IO_HANDLE result_1;
+    CONCRETE_IO_HANDLE result_2;
+    g_pair = loopbackio_pair_create(&link_options);
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = create_endpoint(NULL, LOOPBACKIO_ENDPOINT_A);
+    result_2 = create_endpoint(g_pair, (LOOPBACKIO_ENDPOINT)2);
+
+    // assert
+    ASSERT_IS_NULL(result_1);
+    ASSERT_IS_NULL(result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_013: [ If an IO already exists for the requested endpoint of the pair, `loopbackio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(loopbackio_create_for_an_endpoint_already_in_use_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE result;
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    result = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_014: [ If any error occurs, `loopbackio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_loopbackio_create_fails_then_loopbackio_create_fails)
+{
+    // arrange
+    LOOPBACKIO_LINK_OPTIONS link_options = { 0, 0, 0 };
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    g_pair = loopbackio_pair_create(&link_options);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        CONCRETE_IO_HANDLE result;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        result = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(result, temp_str);
+    }
+}
+
+/* loopbackio_destroy */
+
+/* Tests_SRS_LOOPBACKIO_11_016: [ `loopbackio_destroy` shall release the endpoint of the pair and free all resources associated with the IO. ]*/
+TEST_FUNCTION(loopbackio_destroy_releases_the_endpoint)
+{
+    // arrange
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    g_loopbackio->concrete_io_destroy(g_endpoint_a);
+    g_endpoint_a = create_endpoint(g_pair, LOOPBACKIO_ENDPOINT_A);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_endpoint_a);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_017: [ If `loopbackio` is NULL, `loopbackio_destroy` shall do nothing. ]*/
+TEST_FUNCTION(loopbackio_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    g_loopbackio->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_018: [ If the IO is not closed, `loopbackio_destroy` shall close it without calling `on_io_close_complete`. ]*/
+TEST_FUNCTION(loopbackio_destroy_on_an_open_io_cancels_the_pending_sends)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_pair(0, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    g_loopbackio->concrete_io_destroy(g_endpoint_a);
+    g_endpoint_a = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_CANCELLED, g_send_result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_close_complete_count);
+}
+
+/* loopbackio_open */
+
+/* Tests_SRS_LOOPBACKIO_11_020: [ `loopbackio_open` shall open the IO synchronously, call `on_io_open_complete` with `IO_OPEN_OK` and return 0. ]*/
+TEST_FUNCTION(loopbackio_open_succeeds)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, false);
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    result = open_endpoint(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_open_result);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_021: [ If `loopbackio` is NULL, `loopbackio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_open_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = open_endpoint(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_022: [ If the IO is not closed, `loopbackio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_open_when_already_open_fails)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, true);
+
+    // act
+    result = open_endpoint(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_024: [ If `tickcounter_get_current_ms` fails, `loopbackio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_loopbackio_open_fails)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, false);
+    g_tickcounter_result = 1;
+
+    // act
+    result = open_endpoint(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+}
+
+/* loopbackio_close */
+
+/* Tests_SRS_LOOPBACKIO_11_030: [ `loopbackio_close` shall close the IO synchronously, call `on_io_close_complete` and return 0. ]*/
+/* Tests_SRS_LOOPBACKIO_11_032: [ `loopbackio_close` shall complete all pending sends with `IO_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(loopbackio_close_cancels_pending_sends_and_completes)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_pair(0, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    result = g_loopbackio->concrete_io_close(g_endpoint_a, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_close_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_CANCELLED, g_send_result);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_031: [ If `loopbackio` is NULL, `loopbackio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_close_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_loopbackio->concrete_io_close(NULL, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_close_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_035: [ If the IO is already closed, `loopbackio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_close_when_not_open_fails)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    result = g_loopbackio->concrete_io_close(g_endpoint_a, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_close_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_033: [ `loopbackio_close` shall discard all data that is in flight towards the endpoint. ]*/
+TEST_FUNCTION(loopbackio_close_discards_the_data_in_flight_towards_the_endpoint)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_pair(0, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // act
+    (void)g_loopbackio->concrete_io_close(g_endpoint_b, test_on_io_close_complete, NULL);
+    (void)open_endpoint(g_endpoint_b);
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_bytes_received_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_034: [ If the peer endpoint is open, it shall be marked as having lost its peer. ]*/
+/* Tests_SRS_LOOPBACKIO_11_064: [ Once the peer has closed and all data in flight towards the endpoint has been delivered, the endpoint shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+TEST_FUNCTION(when_the_peer_closes_the_endpoint_indicates_an_error_after_draining_the_data_in_flight)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_pair(10, 0, 0, true);
+    (void)g_loopbackio->concrete_io_send(g_endpoint_a, bytes, sizeof(bytes), NULL, NULL);
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+    (void)g_loopbackio->concrete_io_close(g_endpoint_a, test_on_io_close_complete, NULL);
+    send_bytes(g_endpoint_b, bytes, sizeof(bytes));
+
+    // act
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+    g_current_ms += 10;
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_send_result);
+}
+
+/* loopbackio_send */
+
+/* Tests_SRS_LOOPBACKIO_11_040: [ `loopbackio_send` shall copy the bytes into the pending sends of the endpoint and return 0; transmission happens in `loopbackio_dowork`. ]*/
+TEST_FUNCTION(loopbackio_send_queues_the_bytes)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42, 0x43 };
+    int result;
+    create_test_pair(0, 0, 0, true);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_loopbackio->concrete_io_send(g_endpoint_a, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_041: [ If `loopbackio` or `buffer` is NULL or `size` is 0, `loopbackio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_send_with_invalid_arguments_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result_1;
+    int result_2;
+    int result_3;
+    create_test_pair(0, 0, 0, true);
+
+    // act
+    result_1 = g_loopbackio->concrete_io_send(NULL, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    result_2 = g_loopbackio->concrete_io_send(g_endpoint_a, NULL, sizeof(bytes), test_on_send_complete, NULL);
+    result_3 = g_loopbackio->concrete_io_send(g_endpoint_a, bytes, 0, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_042: [ If the IO is not open or the pair has been destroyed, `loopbackio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_send_when_not_open_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    result = g_loopbackio->concrete_io_send(g_endpoint_a, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_051: [ If queueing the send fails, `loopbackio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_a_call_made_by_loopbackio_send_fails_then_loopbackio_send_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    create_test_pair(0, 0, 0, true);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        int result;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        result = g_loopbackio->concrete_io_send(g_endpoint_a, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, temp_str);
+    }
+}
+
+/* loopbackio_dowork */
+
+/* Tests_SRS_LOOPBACKIO_11_060: [ `loopbackio_dowork` shall first transmit the pending sends of the endpoint towards its peer and then deliver the data in flight towards the endpoint. ]*/
+/* Tests_SRS_LOOPBACKIO_11_048: [ When all the bytes of a send have been transmitted, its `on_send_complete` shall be called with `IO_SEND_OK`. ]*/
+/* Tests_SRS_LOOPBACKIO_11_049: [ `loopbackio_dowork` shall call `on_bytes_received` once for each deliverable chunk in flight towards the endpoint, in the order the chunks were transmitted. ]*/
+TEST_FUNCTION(bytes_sent_on_one_endpoint_are_received_on_the_other)
+{
+    // arrange
+    unsigned char bytes_1[] = { 0x42, 0x43 };
+    unsigned char bytes_2[] = { 0x44 };
+    unsigned char expected_bytes[] = { 0x42, 0x43, 0x44 };
+    create_test_pair(0, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes_1, sizeof(bytes_1));
+    send_bytes(g_endpoint_a, bytes_2, sizeof(bytes_2));
+
+    // act
+    transfer_a_to_b();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_result);
+    ASSERT_ARE_EQUAL(size_t, 2, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), g_received_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_bytes, g_received_bytes, sizeof(expected_bytes)));
+}
+
+/* Tests_SRS_LOOPBACKIO_11_043: [ Each chunk shall become deliverable to the peer `latency_ms` milliseconds after it was transmitted. ]*/
+/* Tests_SRS_LOOPBACKIO_11_050: [ Chunks that are not yet deliverable shall be left in flight. ]*/
+TEST_FUNCTION(bytes_are_delivered_after_the_link_latency)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_pair(20, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // act
+    g_current_ms += 19;
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+    ASSERT_ARE_EQUAL(size_t, 0, g_bytes_received_count);
+    g_current_ms += 1;
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_bytes_received_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_043: [ Each chunk shall become deliverable to the peer `latency_ms` milliseconds after it was transmitted. ]*/
+/* Tests_SRS_LOOPBACKIO_11_050: [ Chunks that are not yet deliverable shall be left in flight. ]*/
+TEST_FUNCTION(bytes_sent_just_before_the_tick_counter_wraps_are_delivered_after_the_link_latency)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    g_current_ms = (tickcounter_ms_t)0 - 10;
+    create_test_pair(20, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // act
+    g_current_ms += 19;
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+    ASSERT_ARE_EQUAL(size_t, 0, g_bytes_received_count);
+    g_current_ms += 1;
+    g_loopbackio->concrete_io_dowork(g_endpoint_b);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_bytes_received_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_044: [ If `max_chunk_size` is not 0, no chunk shall be larger than `max_chunk_size` bytes. ]*/
+TEST_FUNCTION(bytes_are_split_in_chunks_of_at_most_max_chunk_size)
+{
+    // arrange
+    unsigned char bytes[] = { 1, 2, 3, 4, 5, 6, 7 };
+    create_test_pair(0, 0, 3, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    transfer_a_to_b();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_last_received_chunk_size);
+    ASSERT_ARE_EQUAL(size_t, sizeof(bytes), g_received_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(bytes, g_received_bytes, sizeof(bytes)));
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_045: [ If `bytes_per_second` is not 0, the endpoint shall accumulate a send budget of `bytes_per_second` bytes per second of elapsed time, capped at 100 ms worth of data (but never less than one byte). ]*/
+/* Tests_SRS_LOOPBACKIO_11_046: [ Transmission shall stop once the send budget is exhausted and resume on a later call to `loopbackio_dowork`. ]*/
+TEST_FUNCTION(bytes_are_transmitted_at_the_link_bandwidth)
+{
+    // arrange
+    unsigned char bytes[200] = { 0 };
+    create_test_pair(0, 1000, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    transfer_a_to_b();
+    ASSERT_ARE_EQUAL(size_t, 0, g_received_size);
+
+    g_current_ms += 10;
+    transfer_a_to_b();
+    ASSERT_ARE_EQUAL(size_t, 10, g_received_size);
+
+    /* a long pause only accumulates 100 ms worth of budget */
+    g_current_ms += 500;
+    transfer_a_to_b();
+    ASSERT_ARE_EQUAL(size_t, 110, g_received_size);
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+
+    g_current_ms += 90;
+    transfer_a_to_b();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 200, g_received_size);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_send_result);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_047: [ If allocating a chunk fails, the endpoint shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+TEST_FUNCTION(when_allocating_a_chunk_fails_loopbackio_dowork_indicates_an_error)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_pair(0, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+    g_fail_malloc = true;
+
+    // act
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_send_result);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_061: [ If `loopbackio` is NULL, `loopbackio_dowork` shall do nothing. ]*/
+TEST_FUNCTION(loopbackio_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    g_loopbackio->concrete_io_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_062: [ If the IO is not open or the pair has been destroyed, `loopbackio_dowork` shall do nothing. ]*/
+TEST_FUNCTION(loopbackio_dowork_when_not_open_does_nothing)
+{
+    // arrange
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_063: [ If `tickcounter_get_current_ms` fails, the endpoint shall go to the error state and call `on_io_error`. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_loopbackio_dowork_indicates_an_error)
+{
+    // arrange
+    create_test_pair(0, 0, 0, true);
+    g_tickcounter_result = 1;
+
+    // act
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+}
+
+/* loopbackio_setoption */
+
+/* Tests_SRS_LOOPBACKIO_11_070: [ `loopbackio_setoption` shall fail and return a non-zero value for any option, as there are no options supported. ]*/
+TEST_FUNCTION(loopbackio_setoption_fails_for_any_option)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    result = g_loopbackio->concrete_io_setoption(g_endpoint_a, "some_option", "some_value");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_071: [ If `loopbackio` or `option_name` is NULL, `loopbackio_setoption` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_setoption_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_loopbackio->concrete_io_setoption(NULL, "some_option", "some_value");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* loopbackio_retrieveoptions */
+
+/* Tests_SRS_LOOPBACKIO_11_072: [ `loopbackio_retrieveoptions` shall return an empty option handler created by calling `OptionHandler_Create`. ]*/
+TEST_FUNCTION(loopbackio_retrieveoptions_returns_an_empty_option_handler)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    create_test_pair(0, 0, 0, false);
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_loopbackio->concrete_io_retrieveoptions(g_endpoint_a);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_073: [ If `loopbackio` is NULL, `loopbackio_retrieveoptions` shall fail and return NULL. ]*/
+TEST_FUNCTION(loopbackio_retrieveoptions_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    OPTIONHANDLER_HANDLE result = g_loopbackio->concrete_io_retrieveoptions(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_074: [ If `OptionHandler_Create` fails, `loopbackio_retrieveoptions` shall return NULL. ]*/
+TEST_FUNCTION(when_OptionHandler_Create_fails_loopbackio_retrieveoptions_fails)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    create_test_pair(0, 0, 0, false);
+
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = g_loopbackio->concrete_io_retrieveoptions(g_endpoint_a);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* loopbackio_wait */
+
+/* Tests_SRS_LOOPBACKIO_11_080: [ `loopbackio_wait` shall sleep by calling `ThreadAPI_Sleep` until the next call to `loopbackio_dowork` on either endpoint of the pair has work to do, or for at most `timeout_ms`, and return 0. ]*/
+TEST_FUNCTION(loopbackio_wait_sleeps_until_the_next_chunk_is_deliverable)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_pair(20, 0, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+    g_loopbackio->concrete_io_dowork(g_endpoint_a);
+    g_current_ms += 5;
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_b, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sleep_count);
+    ASSERT_ARE_EQUAL(int, 15, (int)g_sleep_ms);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_080: [ `loopbackio_wait` shall sleep by calling `ThreadAPI_Sleep` until the next call to `loopbackio_dowork` on either endpoint of the pair has work to do, or for at most `timeout_ms`, and return 0. ]*/
+TEST_FUNCTION(loopbackio_wait_with_nothing_to_do_sleeps_for_the_timeout)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, true);
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_a, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sleep_count);
+    ASSERT_ARE_EQUAL(int, 100, (int)g_sleep_ms);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_080: [ `loopbackio_wait` shall sleep by calling `ThreadAPI_Sleep` until the next call to `loopbackio_dowork` on either endpoint of the pair has work to do, or for at most `timeout_ms`, and return 0. ]*/
+TEST_FUNCTION(loopbackio_wait_sleeps_until_the_bandwidth_allows_transmitting)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_pair(0, 100, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_a, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sleep_count);
+    ASSERT_ARE_EQUAL(int, 10, (int)g_sleep_ms);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_080: [ `loopbackio_wait` shall sleep by calling `ThreadAPI_Sleep` until the next call to `loopbackio_dowork` on either endpoint of the pair has work to do, or for at most `timeout_ms`, and return 0. ]*/
+TEST_FUNCTION(loopbackio_wait_wakes_up_for_the_pending_sends_of_the_peer)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_pair(0, 100, 0, true);
+    send_bytes(g_endpoint_a, bytes, sizeof(bytes));
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_b, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_sleep_count);
+    ASSERT_ARE_EQUAL(int, 10, (int)g_sleep_ms);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_081: [ If `loopbackio` is NULL, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_wait_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_loopbackio->concrete_io_wait(NULL, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_082: [ If the IO is not open or the pair has been destroyed, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(loopbackio_wait_when_not_open_fails)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, false);
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_a, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LOOPBACKIO_11_083: [ If `tickcounter_get_current_ms` fails, `loopbackio_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_loopbackio_wait_fails)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, true);
+    g_tickcounter_result = 1;
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_a, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_sleep_count);
+}
+
+/* Tests_SRS_LOOPBACKIO_11_084: [ Since sends are queued without limit, an `interest` including `IO_WAIT_WRITE` shall be satisfied immediately. ]*/
+TEST_FUNCTION(loopbackio_wait_for_write_does_not_sleep)
+{
+    // arrange
+    int result;
+    create_test_pair(0, 0, 0, true);
+
+    // act
+    result = g_loopbackio->concrete_io_wait(g_endpoint_a, 100, IO_WAIT_READ_WRITE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_sleep_count);
+}
+
+/* loopbackio_get_interface_description */
+
+/* Tests_SRS_LOOPBACKIO_11_090: [ `loopbackio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `loopbackio_retrieveoptions`, `loopbackio_create`, `loopbackio_destroy`, `loopbackio_open`, `loopbackio_close`, `loopbackio_send`, `loopbackio_dowork`, `loopbackio_setoption` and `loopbackio_wait`. ]*/
+TEST_FUNCTION(loopbackio_get_interface_description_returns_the_interface_functions)
+{
+    // arrange
+
+    // act
+    const IO_INTERFACE_DESCRIPTION* result = loopbackio_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_NOT_NULL(result->concrete_io_retrieveoptions);
+    ASSERT_IS_NOT_NULL(result->concrete_io_create);
+    ASSERT_IS_NOT_NULL(result->concrete_io_destroy);
+    ASSERT_IS_NOT_NULL(result->concrete_io_open);
+    ASSERT_IS_NOT_NULL(result->concrete_io_close);
+    ASSERT_IS_NOT_NULL(result->concrete_io_send);
+    ASSERT_IS_NOT_NULL(result->concrete_io_dowork);
+    ASSERT_IS_NOT_NULL(result->concrete_io_setoption);
+    ASSERT_IS_NOT_NULL(result->concrete_io_wait);
+}
+
+END_TEST_SUITE(loopbackio_unittests)
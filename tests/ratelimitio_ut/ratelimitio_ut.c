@@ -0,0 +1,1382 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/ratelimitio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_IO_HANDLE                      (XIO_HANDLE)0x4243
+#define TEST_OPTION_HANDLER                 (OPTIONHANDLER_HANDLE)0x4244
+#define TEST_TICK_COUNTER_HANDLE            (TICK_COUNTER_HANDLE)0x4245
+#define TEST_UNDERLYING_IO_INTERFACE        (const IO_INTERFACE_DESCRIPTION*)0x4246
+#define TEST_UNDERLYING_IO_PARAMETERS       (void*)0x4247
+
+/* 1 byte per millisecond, so that the tests can reason in bytes */
+#define TEST_BYTES_PER_SECOND               1000
+#define TEST_BURST_SIZE                     100
+
+static tickcounter_ms_t g_current_ms;
+
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_ERROR g_on_io_error;
+static void* g_on_io_error_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+
+static size_t g_xio_send_count;
+static size_t g_xio_send_bytes;
+static ON_SEND_COMPLETE g_last_on_send_complete;
+static void* g_last_on_send_complete_context;
+static bool g_complete_sends_synchronously;
+
+static size_t g_user_send_complete_count;
+static IO_SEND_RESULT g_user_send_result;
+static size_t g_user_bytes_received;
+static size_t g_user_io_error_count;
+static size_t g_user_close_complete_count;
+
+static const IO_INTERFACE_DESCRIPTION* g_ratelimitio_interface;
+static RATELIMITIO_LINK_HANDLE g_link;
+static CONCRETE_IO_HANDLE g_ratelimitio;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    g_on_io_error = on_io_error;
+    g_on_io_error_context = on_io_error_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)xio;
+    (void)buffer;
+    g_xio_send_count++;
+    g_xio_send_bytes += size;
+    g_last_on_send_complete = on_send_complete;
+    g_last_on_send_complete_context = callback_context;
+    if (g_complete_sends_synchronously && (on_send_complete != NULL))
+    {
+        on_send_complete(callback_context, IO_SEND_OK);
+    }
+    return 0;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    (void)open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    g_user_bytes_received += size;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    g_user_io_error_count++;
+}
+
+static void test_on_io_close_complete(void* context)
+{
+    (void)context;
+    g_user_close_complete_count++;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_user_send_complete_count++;
+    g_user_send_result = send_result;
+}
+
+static void test_on_send_complete_send_again(void* context, IO_SEND_RESULT send_result)
+{
+    unsigned char bytes[TEST_BURST_SIZE] = { 0 };
+    (void)send_result;
+    g_user_send_complete_count++;
+    (void)g_ratelimitio_interface->concrete_io_send((CONCRETE_IO_HANDLE)context, bytes, sizeof(bytes), test_on_send_complete, NULL);
+}
+
+static RATELIMITIO_LINK_HANDLE create_link(void)
+{
+    RATELIMITIO_LINK_OPTIONS link_options;
+    link_options.bytes_per_second = TEST_BYTES_PER_SECOND;
+    link_options.burst_size = TEST_BURST_SIZE;
+    return ratelimitio_link_create(&link_options);
+}
+
+static CONCRETE_IO_HANDLE create_ratelimitio(RATELIMITIO_LINK_HANDLE link, RATELIMITIO_PRIORITY priority)
+{
+    RATELIMITIO_CONFIG config;
+    config.underlying_io_interface = TEST_UNDERLYING_IO_INTERFACE;
+    config.underlying_io_parameters = TEST_UNDERLYING_IO_PARAMETERS;
+    config.link = link;
+    config.priority = priority;
+    return g_ratelimitio_interface->concrete_io_create(&config);
+}
+
+static CONCRETE_IO_HANDLE create_open_ratelimitio(RATELIMITIO_PRIORITY priority)
+{
+    CONCRETE_IO_HANDLE result = create_ratelimitio(g_link, priority);
+    (void)g_ratelimitio_interface->concrete_io_open(result, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    return result;
+}
+
+static void create_test_ratelimitio(RATELIMITIO_PRIORITY priority, bool open)
+{
+    g_link = create_link();
+    if (open)
+    {
+        g_ratelimitio = create_open_ratelimitio(priority);
+    }
+    else
+    {
+        g_ratelimitio = create_ratelimitio(g_link, priority);
+    }
+    umock_c_reset_all_calls();
+}
+
+static void drain_tokens(void)
+{
+    unsigned char bytes[TEST_BURST_SIZE] = { 0 };
+    (void)g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), NULL, NULL);
+    g_xio_send_count = 0;
+    g_xio_send_bytes = 0;
+    umock_c_reset_all_calls();
+}
+
+static void send_bytes(size_t size)
+{
+    unsigned char bytes[TEST_BURST_SIZE] = { 0 };
+    (void)g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, size, test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(ratelimitio_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_OPTION_HANDLER);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+
+    g_ratelimitio_interface = ratelimitio_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+
+    g_current_ms = 1000;
+    g_on_io_open_complete = NULL;
+    g_on_bytes_received = NULL;
+    g_on_io_error = NULL;
+    g_on_io_close_complete = NULL;
+    g_xio_send_count = 0;
+    g_xio_send_bytes = 0;
+    g_last_on_send_complete = NULL;
+    g_last_on_send_complete_context = NULL;
+    g_complete_sends_synchronously = false;
+    g_user_send_complete_count = 0;
+    g_user_send_result = IO_SEND_OK;
+    g_user_bytes_received = 0;
+    g_user_io_error_count = 0;
+    g_user_close_complete_count = 0;
+    g_link = NULL;
+    g_ratelimitio = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    umock_c_negative_tests_deinit();
+
+    if (g_ratelimitio != NULL)
+    {
+        g_ratelimitio_interface->concrete_io_destroy(g_ratelimitio);
+    }
+    ratelimitio_link_destroy(g_link);
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* ratelimitio_link_create */
+
+/* Tests_SRS_RATELIMITIO_11_001: [ `ratelimitio_link_create` shall create a new token bucket that is refilled with `bytes_per_second` bytes per second and holds at most `burst_size` bytes. ]*/
+/* Tests_SRS_RATELIMITIO_11_004: [ `ratelimitio_link_create` shall create a tick counter by calling `tickcounter_create`. ]*/
+/* Tests_SRS_RATELIMITIO_11_005: [ The token bucket shall start full, at the time obtained by calling `tickcounter_get_current_ms`. ]*/
+TEST_FUNCTION(ratelimitio_link_create_succeeds)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    g_link = create_link();
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_link);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_002: [ If `link_options` is NULL, `ratelimitio_link_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(ratelimitio_link_create_with_NULL_link_options_fails)
+{
+    // arrange
+
+    // act
+    RATELIMITIO_LINK_HANDLE link = ratelimitio_link_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(link);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_003: [ If `bytes_per_second` or `burst_size` is 0, `ratelimitio_link_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(ratelimitio_link_create_with_0_bytes_per_second_or_burst_size_fails)
+{
+    // arrange
+    RATELIMITIO_LINK_OPTIONS no_rate_options;
+    RATELIMITIO_LINK_OPTIONS no_burst_options;
+    RATELIMITIO_LINK_HANDLE result_1;
+    RATELIMITIO_LINK_HANDLE result_2;
+    no_rate_options.bytes_per_second = 0;
+    no_rate_options.burst_size = TEST_BURST_SIZE;
+    no_burst_options.bytes_per_second = TEST_BYTES_PER_SECOND;
+    no_burst_options.burst_size = 0;
+
+    // act
+    result_1 = ratelimitio_link_create(&no_rate_options);
+    result_2 = ratelimitio_link_create(&no_burst_options);
+
+    // assert
+    ASSERT_IS_NULL(result_1);
+    ASSERT_IS_NULL(result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_006: [ If any error occurs, `ratelimitio_link_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_ratelimitio_link_create_fails_then_ratelimitio_link_create_fails)
+{
+    // arrange
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetFailReturn(1);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        RATELIMITIO_LINK_HANDLE link;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        link = create_link();
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(link, temp_str);
+    }
+}
+
+/* ratelimitio_link_destroy */
+
+/* Tests_SRS_RATELIMITIO_11_007: [ If no IO uses the link, `ratelimitio_link_destroy` shall free the tick counter and the link. ]*/
+TEST_FUNCTION(ratelimitio_link_destroy_frees_the_link)
+{
+    // arrange
+    RATELIMITIO_LINK_HANDLE link = create_link();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    ratelimitio_link_destroy(link);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_008: [ If `link` is NULL, `ratelimitio_link_destroy` shall do nothing. ]*/
+TEST_FUNCTION(ratelimitio_link_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    ratelimitio_link_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_009: [ Otherwise the link shall be freed when the last IO using it is destroyed, and no new IO shall be created on it. ]*/
+/* Tests_SRS_RATELIMITIO_11_019: [ If `ratelimitio_link_destroy` was already called and this was the last IO using the link, `ratelimitio_destroy` shall free the link. ]*/
+TEST_FUNCTION(ratelimitio_link_destroy_with_an_io_using_it_defers_the_free)
+{
+    // arrange
+    CONCRETE_IO_HANDLE second_ratelimitio;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    // act
+    ratelimitio_link_destroy(g_link);
+    second_ratelimitio = create_ratelimitio(g_link, RATELIMITIO_PRIORITY_NORMAL);
+    g_link = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(second_ratelimitio);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    g_ratelimitio_interface->concrete_io_destroy(g_ratelimitio);
+    g_ratelimitio = NULL;
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_create */
+
+/* Tests_SRS_RATELIMITIO_11_010: [ `ratelimitio_create` shall create a new rate limiting IO that draws its tokens from the `link` member of the `RATELIMITIO_CONFIG*` passed as `io_create_parameters`, in the lane given by `priority`. ]*/
+/* Tests_SRS_RATELIMITIO_11_014: [ `ratelimitio_create` shall create the list of pending sends by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_RATELIMITIO_11_015: [ `ratelimitio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+TEST_FUNCTION(ratelimitio_create_succeeds)
+{
+    // arrange
+    g_link = create_link();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS));
+
+    // act
+    g_ratelimitio = create_ratelimitio(g_link, RATELIMITIO_PRIORITY_NORMAL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_ratelimitio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_011: [ If `io_create_parameters` is NULL, `ratelimitio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(ratelimitio_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+
+    // act
+    CONCRETE_IO_HANDLE ratelimitio = g_ratelimitio_interface->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(ratelimitio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_012: [ If the `underlying_io_interface` or `link` member is NULL or `priority` is not a valid `RATELIMITIO_PRIORITY`, `ratelimitio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(ratelimitio_create_with_invalid_config_fails)
+{
+    // arrange
+    RATELIMITIO_CONFIG config;
+    CONCRETE_IO_HANDLE result_1;
+    CONCRETE_IO_HANDLE result_2;
+    CONCRETE_IO_HANDLE result_3;
+    g_link = create_link();
+    config.underlying_io_interface = NULL;
+    config.underlying_io_parameters = TEST_UNDERLYING_IO_PARAMETERS;
+    config.link = g_link;
+    config.priority = RATELIMITIO_PRIORITY_NORMAL;
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = create_ratelimitio(NULL, RATELIMITIO_PRIORITY_NORMAL);
+    result_2 = g_ratelimitio_interface->concrete_io_create(&config);
+    result_3 = create_ratelimitio(g_link, (RATELIMITIO_PRIORITY)RATELIMITIO_PRIORITY_COUNT);
+
+    // assert
+    ASSERT_IS_NULL(result_1);
+    ASSERT_IS_NULL(result_2);
+    ASSERT_IS_NULL(result_3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_013: [ If any error occurs, `ratelimitio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_ratelimitio_create_fails_then_ratelimitio_create_fails)
+{
+    // arrange
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    g_link = create_link();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS))
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        CONCRETE_IO_HANDLE ratelimitio;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        ratelimitio = create_ratelimitio(g_link, RATELIMITIO_PRIORITY_NORMAL);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(ratelimitio, temp_str);
+    }
+}
+
+/* ratelimitio_destroy */
+
+/* Tests_SRS_RATELIMITIO_11_016: [ `ratelimitio_destroy` shall destroy the underlying IO by calling `xio_destroy` and free all resources associated with the IO. ]*/
+/* Tests_SRS_RATELIMITIO_11_018: [ `ratelimitio_destroy` shall complete all pending sends with `IO_SEND_CANCELLED`. ]*/
+TEST_FUNCTION(ratelimitio_destroy_cancels_the_pending_sends)
+{
+    // arrange
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(1);
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    g_ratelimitio_interface->concrete_io_destroy(g_ratelimitio);
+    g_ratelimitio = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_CANCELLED, g_user_send_result);
+}
+
+/* Tests_SRS_RATELIMITIO_11_017: [ If `ratelimitio` is NULL, `ratelimitio_destroy` shall do nothing. ]*/
+TEST_FUNCTION(ratelimitio_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    g_ratelimitio_interface->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_open */
+
+/* Tests_SRS_RATELIMITIO_11_020: [ `ratelimitio_open` shall open the underlying IO by calling `xio_open`, passing its own callbacks. ]*/
+TEST_FUNCTION(ratelimitio_open_opens_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_open(g_ratelimitio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_021: [ If `ratelimitio` is NULL, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_open_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_ratelimitio_interface->concrete_io_open(NULL, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_022: [ If the IO is not closed, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_open_when_already_open_fails)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_open(g_ratelimitio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_023: [ If `xio_open` fails, `ratelimitio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_open_fails_ratelimitio_open_fails)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_open(g_ratelimitio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_025: [ When the underlying IO completes the open, the rate limiting IO shall be open if `open_result` is `IO_OPEN_OK` and `on_io_open_complete` shall be called with `open_result`. ]*/
+TEST_FUNCTION(when_the_underlying_open_fails_sends_are_refused)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+    (void)g_ratelimitio_interface->concrete_io_open(g_ratelimitio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_ERROR);
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_RATELIMITIO_11_026: [ Bytes received from the underlying IO shall be passed unchanged to `on_bytes_received`. ]*/
+TEST_FUNCTION(received_bytes_are_passed_to_the_user)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42, 0x43 };
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_user_bytes_received);
+}
+
+/* Tests_SRS_RATELIMITIO_11_027: [ When the underlying IO indicates an error, the IO shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+TEST_FUNCTION(an_underlying_io_error_fails_the_pending_sends)
+{
+    // arrange
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(1);
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_user_send_result);
+}
+
+/* ratelimitio_close */
+
+/* Tests_SRS_RATELIMITIO_11_030: [ `ratelimitio_close` shall complete all pending sends with `IO_SEND_CANCELLED` and close the underlying IO by calling `xio_close`. ]*/
+/* Tests_SRS_RATELIMITIO_11_028: [ When the underlying IO completes the close, the rate limiting IO shall be closed and `on_io_close_complete` shall be called. ]*/
+TEST_FUNCTION(ratelimitio_close_cancels_the_pending_sends_and_closes_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(1);
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_close(g_ratelimitio, test_on_io_close_complete, NULL);
+    g_on_io_close_complete(g_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_CANCELLED, g_user_send_result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_close_complete_count);
+}
+
+/* Tests_SRS_RATELIMITIO_11_031: [ If `ratelimitio` is NULL, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_close_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_ratelimitio_interface->concrete_io_close(NULL, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_032: [ If the IO is already closed or closing, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_close_when_closed_fails)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_close(g_ratelimitio, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_033: [ If `xio_close` fails, `ratelimitio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_close_fails_ratelimitio_close_fails)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_close(g_ratelimitio, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_send */
+
+/* Tests_SRS_RATELIMITIO_11_040: [ If no bytes are queued in the lane of the IO or a higher priority lane, `size` is at most `burst_size` and the link holds enough tokens, `ratelimitio_send` shall consume the tokens and send the bytes immediately by calling `xio_send` with `on_send_complete` and `on_send_complete_context`. ]*/
+TEST_FUNCTION(ratelimitio_send_within_the_burst_sends_immediately)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42, 0x43 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_043: [ Otherwise `ratelimitio_send` shall copy the bytes into the pending sends of the IO and return 0; they are released by `ratelimitio_dowork`. ]*/
+TEST_FUNCTION(ratelimitio_send_without_enough_tokens_queues_the_bytes)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42, 0x43 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+}
+
+/* Tests_SRS_RATELIMITIO_11_043: [ Otherwise `ratelimitio_send` shall copy the bytes into the pending sends of the IO and return 0; they are released by `ratelimitio_dowork`. ]*/
+TEST_FUNCTION(ratelimitio_send_larger_than_the_burst_queues_the_bytes)
+{
+    // arrange
+    unsigned char bytes[TEST_BURST_SIZE + 1] = { 0 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+}
+
+/* Tests_SRS_RATELIMITIO_11_041: [ If `ratelimitio` or `buffer` is NULL or `size` is 0, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_send_with_invalid_arguments_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result_1;
+    int result_2;
+    int result_3;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    // act
+    result_1 = g_ratelimitio_interface->concrete_io_send(NULL, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    result_2 = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, NULL, sizeof(bytes), test_on_send_complete, NULL);
+    result_3 = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, 0, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_3);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_042: [ If the IO is not open, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_send_when_not_open_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_044: [ If queueing the send fails, `ratelimitio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_queueing_fails_ratelimitio_send_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        int result;
+
+        /* a failure to read the time only delays the refill */
+        if (i == 0) continue;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, temp_str);
+    }
+}
+
+/* Tests_SRS_RATELIMITIO_11_045: [ If `xio_send` fails, `ratelimitio_send` shall give the tokens back to the link, fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_send_fails_ratelimitio_send_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, NULL))
+        .SetReturn(1);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_045: [ If `xio_send` fails, `ratelimitio_send` shall give the tokens back to the link, fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_send_fails_ratelimitio_send_gives_the_tokens_back)
+{
+    // arrange
+    unsigned char bytes[TEST_BURST_SIZE] = { 0 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, NULL))
+        .SetReturn(1);
+    (void)g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, NULL));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_040: [ If no bytes are queued in the lane of the IO or a higher priority lane, `size` is at most `burst_size` and the link holds enough tokens, `ratelimitio_send` shall consume the tokens and send the bytes immediately by calling `xio_send` with `on_send_complete` and `on_send_complete_context`. ]*/
+TEST_FUNCTION(a_send_made_from_a_synchronous_completion_does_not_reuse_the_tokens)
+{
+    // arrange
+    unsigned char bytes[TEST_BURST_SIZE] = { 0 };
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    g_complete_sends_synchronously = true;
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete_send_again, g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_send_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_BURST_SIZE, g_xio_send_bytes);
+}
+
+/* ratelimitio_dowork */
+
+/* Tests_SRS_RATELIMITIO_11_050: [ `ratelimitio_dowork` shall add `bytes_per_second` tokens per second of elapsed time to the link, capped at `burst_size`. ]*/
+/* Tests_SRS_RATELIMITIO_11_055: [ `ratelimitio_dowork` shall call `xio_dowork` on the underlying IO. ]*/
+TEST_FUNCTION(ratelimitio_dowork_releases_the_queued_bytes_as_tokens_accumulate)
+{
+    // arrange
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(10);
+    g_current_ms += 9;
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+
+    g_current_ms += 1;
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, 10, g_xio_send_bytes);
+}
+
+/* Tests_SRS_RATELIMITIO_11_050: [ `ratelimitio_dowork` shall add `bytes_per_second` tokens per second of elapsed time to the link, capped at `burst_size`. ]*/
+TEST_FUNCTION(tokens_do_not_accumulate_beyond_the_burst_size)
+{
+    // arrange
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    g_current_ms += 10000;
+    send_bytes(TEST_BURST_SIZE);
+    send_bytes(1);
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_BURST_SIZE, g_xio_send_bytes);
+}
+
+/* Tests_SRS_RATELIMITIO_11_051: [ `ratelimitio_dowork` shall release the queued bytes in order, in chunks of at most `burst_size` bytes, each chunk only once the link holds enough tokens for all of it. ]*/
+/* Tests_SRS_RATELIMITIO_11_053: [ The `on_send_complete` callback of the user shall be passed to `xio_send` together with the last chunk of the send. ]*/
+TEST_FUNCTION(ratelimitio_dowork_splits_sends_larger_than_the_burst)
+{
+    // arrange
+    unsigned char bytes[(2 * TEST_BURST_SIZE) + 50] = { 0 };
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    (void)g_ratelimitio_interface->concrete_io_send(g_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, (void*)0x4242);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, TEST_BURST_SIZE, g_xio_send_bytes);
+    ASSERT_IS_NULL(g_last_on_send_complete);
+
+    g_current_ms += 1000;
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    ASSERT_ARE_EQUAL(size_t, 2, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, 2 * TEST_BURST_SIZE, g_xio_send_bytes);
+    ASSERT_IS_NULL(g_last_on_send_complete);
+
+    g_current_ms += 50;
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    ASSERT_ARE_EQUAL(size_t, 3, g_xio_send_count);
+    ASSERT_ARE_EQUAL(size_t, sizeof(bytes), g_xio_send_bytes);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)test_on_send_complete, (void*)g_last_on_send_complete);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, g_last_on_send_complete_context);
+}
+
+/* Tests_SRS_RATELIMITIO_11_052: [ Bytes shall only be released while no IO sharing the link with a higher priority has queued bytes. ]*/
+TEST_FUNCTION(a_higher_priority_lane_is_released_first)
+{
+    // arrange
+    unsigned char bytes[10] = { 0 };
+    CONCRETE_IO_HANDLE low_ratelimitio;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_HIGH, true);
+    low_ratelimitio = create_open_ratelimitio(RATELIMITIO_PRIORITY_LOW);
+    drain_tokens();
+    (void)g_ratelimitio_interface->concrete_io_send(low_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    send_bytes(sizeof(bytes));
+    g_current_ms += 10;
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(low_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_send_count);
+
+    g_current_ms += 10;
+    g_ratelimitio_interface->concrete_io_dowork(low_ratelimitio);
+    ASSERT_ARE_EQUAL(size_t, 2, g_xio_send_count);
+
+    // cleanup
+    g_ratelimitio_interface->concrete_io_destroy(low_ratelimitio);
+}
+
+/* Tests_SRS_RATELIMITIO_11_040: [ If no bytes are queued in the lane of the IO or a higher priority lane, `size` is at most `burst_size` and the link holds enough tokens, `ratelimitio_send` shall consume the tokens and send the bytes immediately by calling `xio_send` with `on_send_complete` and `on_send_complete_context`. ]*/
+TEST_FUNCTION(a_send_does_not_overtake_bytes_queued_in_a_higher_priority_lane)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    CONCRETE_IO_HANDLE low_ratelimitio;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_HIGH, true);
+    low_ratelimitio = create_open_ratelimitio(RATELIMITIO_PRIORITY_LOW);
+    drain_tokens();
+    send_bytes(10);
+    g_current_ms += 50;
+
+    // act
+    (void)g_ratelimitio_interface->concrete_io_send(low_ratelimitio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_send_count);
+
+    // cleanup
+    g_ratelimitio_interface->concrete_io_destroy(low_ratelimitio);
+}
+
+/* Tests_SRS_RATELIMITIO_11_054: [ If `xio_send` fails, the IO shall go to the error state, complete all pending sends with `IO_SEND_ERROR` and call `on_io_error`. ]*/
+TEST_FUNCTION(when_releasing_a_chunk_fails_the_io_indicates_an_error)
+{
+    // arrange
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(10);
+    g_current_ms += 10;
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 10, test_on_send_complete, NULL))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_user_send_result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_io_error_count);
+}
+
+/* Tests_SRS_RATELIMITIO_11_056: [ If `ratelimitio` is NULL, `ratelimitio_dowork` shall do nothing. ]*/
+TEST_FUNCTION(ratelimitio_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    g_ratelimitio_interface->concrete_io_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_setoption */
+
+/* Tests_SRS_RATELIMITIO_11_060: [ `ratelimitio_setoption` shall pass all options to the underlying IO by calling `xio_setoption` and return its result. ]*/
+TEST_FUNCTION(ratelimitio_setoption_passes_the_option_to_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "some_option", (void*)0x42));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_setoption(g_ratelimitio, "some_option", (void*)0x42);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_061: [ If `ratelimitio` or `option_name` is NULL, `ratelimitio_setoption` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_setoption_with_NULL_arguments_fails)
+{
+    // arrange
+    int result_1;
+    int result_2;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    // act
+    result_1 = g_ratelimitio_interface->concrete_io_setoption(NULL, "some_option", (void*)0x42);
+    result_2 = g_ratelimitio_interface->concrete_io_setoption(g_ratelimitio, NULL, (void*)0x42);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_retrieveoptions */
+
+/* Tests_SRS_RATELIMITIO_11_065: [ `ratelimitio_retrieveoptions` shall return the result of calling `xio_retrieveoptions` on the underlying IO. ]*/
+TEST_FUNCTION(ratelimitio_retrieveoptions_returns_the_underlying_io_options)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, false);
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_retrieveoptions(g_ratelimitio);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_066: [ If `ratelimitio` is NULL, `ratelimitio_retrieveoptions` shall fail and return NULL. ]*/
+TEST_FUNCTION(ratelimitio_retrieveoptions_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    OPTIONHANDLER_HANDLE result = g_ratelimitio_interface->concrete_io_retrieveoptions(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_wait */
+
+/* Tests_SRS_RATELIMITIO_11_070: [ `ratelimitio_wait` shall call `xio_wait` on the underlying IO, with `timeout_ms` shortened to the time until the next queued chunk can be released, and return its result. ]*/
+TEST_FUNCTION(ratelimitio_wait_with_nothing_queued_waits_on_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 1000, IO_WAIT_READ));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_wait(g_ratelimitio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_070: [ `ratelimitio_wait` shall call `xio_wait` on the underlying IO, with `timeout_ms` shortened to the time until the next queued chunk can be released, and return its result. ]*/
+TEST_FUNCTION(ratelimitio_wait_wakes_up_when_the_queued_bytes_can_be_released)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+    drain_tokens();
+    send_bytes(30);
+    g_current_ms += 10;
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 20, IO_WAIT_READ));
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_wait(g_ratelimitio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_072: [ Since sends are queued without limit while the IO is open, an `interest` including `IO_WAIT_WRITE` shall then be satisfied immediately. ]*/
+TEST_FUNCTION(ratelimitio_wait_for_write_returns_immediately)
+{
+    // arrange
+    int result;
+    create_test_ratelimitio(RATELIMITIO_PRIORITY_NORMAL, true);
+
+    // act
+    result = g_ratelimitio_interface->concrete_io_wait(g_ratelimitio, 1000, IO_WAIT_WRITE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_RATELIMITIO_11_071: [ If `ratelimitio` is NULL, `ratelimitio_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(ratelimitio_wait_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_ratelimitio_interface->concrete_io_wait(NULL, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* ratelimitio_get_interface_description */
+
+/* Tests_SRS_RATELIMITIO_11_080: [ `ratelimitio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `ratelimitio_retrieveoptions`, `ratelimitio_create`, `ratelimitio_destroy`, `ratelimitio_open`, `ratelimitio_close`, `ratelimitio_send`, `ratelimitio_dowork`, `ratelimitio_setoption` and `ratelimitio_wait`. ]*/
+TEST_FUNCTION(ratelimitio_get_interface_description_returns_the_interface_functions)
+{
+    // arrange
+
+    // act
+    const IO_INTERFACE_DESCRIPTION* result = ratelimitio_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_NOT_NULL(result->concrete_io_retrieveoptions);
+    ASSERT_IS_NOT_NULL(result->concrete_io_create);
+    ASSERT_IS_NOT_NULL(result->concrete_io_destroy);
+    ASSERT_IS_NOT_NULL(result->concrete_io_open);
+    ASSERT_IS_NOT_NULL(result->concrete_io_close);
+    ASSERT_IS_NOT_NULL(result->concrete_io_send);
+    ASSERT_IS_NOT_NULL(result->concrete_io_dowork);
+    ASSERT_IS_NOT_NULL(result->concrete_io_setoption);
+    ASSERT_IS_NOT_NULL(result->concrete_io_wait);
+}
+
+END_TEST_SUITE(ratelimitio_unittests)
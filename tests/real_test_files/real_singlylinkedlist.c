@@ -11,6 +11,7 @@
 #define singlylinkedlist_item_get_value real_singlylinkedlist_item_get_value
 #define singlylinkedlist_remove_if real_singlylinkedlist_remove_if
 #define singlylinkedlist_foreach real_singlylinkedlist_foreach
+#define singlylinkedlist_set_item_cache_size real_singlylinkedlist_set_item_cache_size
 
 #define GBALLOC_H
 
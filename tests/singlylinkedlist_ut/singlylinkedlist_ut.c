@@ -1228,4 +1228,196 @@ TEST_FUNCTION(singlylinkedlist_remove_if_removes_the_only_item_in_the_list)
     singlylinkedlist_destroy(list);
 }
 
+/* singlylinkedlist_set_item_cache_size */
+
+/* Tests_SRS_LIST_01_027: [If the list argument is NULL, singlylinkedlist_set_item_cache_size shall fail and return a non-zero value.] */
+TEST_FUNCTION(singlylinkedlist_set_item_cache_size_with_NULL_list_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = singlylinkedlist_set_item_cache_size(NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_LIST_01_028: [singlylinkedlist_set_item_cache_size shall set the number of removed nodes the list keeps for reuse to max_cached_items and on success it shall return 0.] */
+TEST_FUNCTION(singlylinkedlist_set_item_cache_size_succeeds)
+{
+    // arrange
+    int result;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    umock_c_reset_all_calls();
+
+    // act
+    result = singlylinkedlist_set_item_cache_size(list, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_031: [singlylinkedlist_remove and singlylinkedlist_remove_if shall cache the removed node as long as fewer than max_cached_items nodes are cached, and free it otherwise.] */
+TEST_FUNCTION(singlylinkedlist_remove_with_item_cache_does_not_free_the_node)
+{
+    // arrange
+    int x1 = 0x42;
+    int result;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item;
+    (void)singlylinkedlist_set_item_cache_size(list, 1);
+    item = singlylinkedlist_add(list, &x1);
+    umock_c_reset_all_calls();
+
+    // act
+    result = singlylinkedlist_remove(list, item);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(singlylinkedlist_get_head_item(list));
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_031: [singlylinkedlist_remove and singlylinkedlist_remove_if shall cache the removed node as long as fewer than max_cached_items nodes are cached, and free it otherwise.] */
+TEST_FUNCTION(singlylinkedlist_remove_when_the_item_cache_is_full_frees_the_node)
+{
+    // arrange
+    int x1 = 0x42;
+    int x2 = 0x43;
+    int result;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item1;
+    LIST_ITEM_HANDLE item2;
+    (void)singlylinkedlist_set_item_cache_size(list, 1);
+    item1 = singlylinkedlist_add(list, &x1);
+    item2 = singlylinkedlist_add(list, &x2);
+    (void)singlylinkedlist_remove(list, item1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = singlylinkedlist_remove(list, item2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_030: [If the list has cached nodes, singlylinkedlist_add shall reuse one of them instead of allocating a new node.] */
+TEST_FUNCTION(singlylinkedlist_add_reuses_a_cached_node)
+{
+    // arrange
+    int x1 = 0x42;
+    int x2 = 0x43;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item;
+    LIST_ITEM_HANDLE result;
+    (void)singlylinkedlist_set_item_cache_size(list, 1);
+    item = singlylinkedlist_add(list, &x1);
+    (void)singlylinkedlist_remove(list, item);
+    umock_c_reset_all_calls();
+
+    // act
+    result = singlylinkedlist_add(list, &x2);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, x2, *(const int*)singlylinkedlist_item_get_value(singlylinkedlist_get_head_item(list)));
+    ASSERT_IS_NULL(singlylinkedlist_get_next_item(result));
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_026: [A newly created list shall not cache any removed nodes.] */
+TEST_FUNCTION(singlylinkedlist_add_after_remove_without_item_cache_allocates)
+{
+    // arrange
+    int x1 = 0x42;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item;
+    LIST_ITEM_HANDLE result;
+    item = singlylinkedlist_add(list, &x1);
+    (void)singlylinkedlist_remove(list, item);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = singlylinkedlist_add(list, &x1);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_029: [Nodes already cached beyond max_cached_items shall be freed.] */
+TEST_FUNCTION(singlylinkedlist_set_item_cache_size_frees_the_nodes_beyond_the_new_size)
+{
+    // arrange
+    int x1 = 0x42;
+    int x2 = 0x43;
+    int result;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item1;
+    LIST_ITEM_HANDLE item2;
+    (void)singlylinkedlist_set_item_cache_size(list, 2);
+    item1 = singlylinkedlist_add(list, &x1);
+    item2 = singlylinkedlist_add(list, &x2);
+    (void)singlylinkedlist_remove(list, item1);
+    (void)singlylinkedlist_remove(list, item2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = singlylinkedlist_set_item_cache_size(list, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    singlylinkedlist_destroy(list);
+}
+
+/* Tests_SRS_LIST_01_003: [singlylinkedlist_destroy shall free all resources associated with the list identified by the handle argument.] */
+TEST_FUNCTION(singlylinkedlist_destroy_frees_the_cached_nodes)
+{
+    // arrange
+    int x1 = 0x42;
+    SINGLYLINKEDLIST_HANDLE list = singlylinkedlist_create();
+    LIST_ITEM_HANDLE item;
+    (void)singlylinkedlist_set_item_cache_size(list, 1);
+    item = singlylinkedlist_add(list, &x1);
+    (void)singlylinkedlist_remove(list, item);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    singlylinkedlist_destroy(list);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(singlylinkedlist_unittests)
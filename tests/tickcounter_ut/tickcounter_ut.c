@@ -27,6 +27,30 @@ void my_gballoc_free(void* ptr)
 
 #include "azure_c_shared_utility/tickcounter.h"
 
+#ifndef _WIN32
+#include <time.h>
+
+/* tickcounter_linux reads the clock through linux_time; these fakes let the tests set the time */
+static struct timespec g_time_value;
+static int g_get_time_ns_result;
+
+void set_time_basis(void)
+{
+}
+
+int get_time_ns(struct timespec* ts)
+{
+    *ts = g_time_value;
+    return g_get_time_ns_result;
+}
+
+static void set_time(time_t seconds, long nanoseconds)
+{
+    g_time_value.tv_sec = seconds;
+    g_time_value.tv_nsec = nanoseconds;
+}
+#endif
+
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/gballoc.h"
@@ -74,6 +98,10 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     }
 
     umock_c_reset_all_calls();
+#ifndef _WIN32
+    set_time(0, 0);
+    g_get_time_ns_result = 0;
+#endif
 }
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -193,6 +221,130 @@ TEST_FUNCTION(tickcounter_get_current_ms_succeed)
     tickcounter_destroy(tickHandle);
 }
 
+#ifndef _WIN32
+/* Tests_SRS_TICKCOUNTER_LINUX_11_003: [ If `get_time_ns` fails, `tickcounter_create` shall free the instance and return NULL. ]*/
+TEST_FUNCTION(when_getting_the_time_fails_tickcounter_create_fails)
+{
+    ///arrange
+    TICK_COUNTER_HANDLE tickHandle;
+    g_get_time_ns_result = 1;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    tickHandle = tickcounter_create();
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(tickHandle);
+}
+
+/* Tests_SRS_TICKCOUNTER_LINUX_11_008: [ If `get_time_ns` fails, `tickcounter_get_current_ms` shall return a non-zero value. ]*/
+TEST_FUNCTION(when_getting_the_time_fails_tickcounter_get_current_ms_fails)
+{
+    ///arrange
+    int result;
+    tickcounter_ms_t current_ms;
+    TICK_COUNTER_HANDLE tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+    g_get_time_ns_result = 1;
+
+    ///act
+    result = tickcounter_get_current_ms(tickHandle, &current_ms);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// clean
+    tickcounter_destroy(tickHandle);
+}
+
+/* Tests_SRS_TICKCOUNTER_LINUX_11_009: [ `tickcounter_get_current_ms` shall set `*current_ms` to the number of whole milliseconds elapsed since `tickcounter_create`, computed from both the seconds and the nanoseconds of the two times, and return 0. ]*/
+TEST_FUNCTION(tickcounter_get_current_ms_has_millisecond_resolution)
+{
+    ///arrange
+    int result1;
+    int result2;
+    tickcounter_ms_t first_ms;
+    tickcounter_ms_t next_ms;
+    TICK_COUNTER_HANDLE tickHandle;
+    set_time(10, 0);
+    tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    set_time(10, 250000000);
+    result1 = tickcounter_get_current_ms(tickHandle, &first_ms);
+    set_time(11, 999999);
+    result2 = tickcounter_get_current_ms(tickHandle, &next_ms);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_ARE_EQUAL(uint64_t, 250, (uint64_t)first_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 1000, (uint64_t)next_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// clean
+    tickcounter_destroy(tickHandle);
+}
+
+/* Tests_SRS_TICKCOUNTER_LINUX_11_010: [ The elapsed time shall be correct when the nanoseconds of the current time are smaller than those recorded by `tickcounter_create`. ]*/
+TEST_FUNCTION(tickcounter_get_current_ms_borrows_from_the_seconds)
+{
+    ///arrange
+    int result;
+    tickcounter_ms_t current_ms;
+    TICK_COUNTER_HANDLE tickHandle;
+    set_time(10, 900000000);
+    tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+    set_time(12, 100000000);
+
+    ///act
+    result = tickcounter_get_current_ms(tickHandle, &current_ms);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 1200, (uint64_t)current_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// clean
+    tickcounter_destroy(tickHandle);
+}
+
+/* Tests_SRS_TICKCOUNTER_LINUX_11_011: [ The elapsed milliseconds shall be truncated to `tickcounter_ms_t`, so that the counter wraps around to 0 and the unsigned difference of two readings stays correct across a wrap. ]*/
+TEST_FUNCTION(tickcounter_get_current_ms_difference_is_correct_across_a_wrap)
+{
+    ///arrange
+    int result1;
+    int result2;
+    tickcounter_ms_t first_ms;
+    tickcounter_ms_t next_ms;
+    TICK_COUNTER_HANDLE tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    /* 4294967295 ms is the last value before a 32 bit counter wraps */
+    set_time(4294967, 295000000);
+    result1 = tickcounter_get_current_ms(tickHandle, &first_ms);
+    set_time(4294967, 297000000);
+    result2 = tickcounter_get_current_ms(tickHandle, &next_ms);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result1);
+    ASSERT_ARE_EQUAL(int, 0, result2);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(tickcounter_ms_t)4294967295ULL, (uint64_t)first_ms);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)(tickcounter_ms_t)4294967297ULL, (uint64_t)next_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 2, (uint64_t)(tickcounter_ms_t)(next_ms - first_ms));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// clean
+    tickcounter_destroy(tickHandle);
+}
+#endif
+
 //TEST_FUNCTION(tickcounter_get_current_ms_validate_tick_succeed)
 //{
 //    ///arrange
@@ -1046,7 +1046,7 @@ TEST_FUNCTION(tlsio_cyclonessl_dowork_when_no_bytes_are_available_does_not_trigg
     (void)tlsio_cyclonessl_get_interface_description()->concrete_io_open(tlsio_handle, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, 64, IGNORED_PTR_ARG, 0))
+    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_data()
         .CopyOutArgumentBuffer_received(&received, sizeof(received));
 
@@ -1061,7 +1061,7 @@ TEST_FUNCTION(tlsio_cyclonessl_dowork_when_no_bytes_are_available_does_not_trigg
 }
 
 /* Tests_SRS_TLSIO_CYCLONESSL_01_080: [ If any bytes are read from CycloneSSL they should be indicated via the on_bytes_received callback passed to tlsio_cyclonessl_open. ]*/
-/* Tests_SRS_TLSIO_CYCLONESSL_01_053: [ If the IO is open, tlsio_cyclonessl_dowork shall attempt to read 64 bytes from the TLS library by calling tlsRead. ]*/
+/* Tests_SRS_TLSIO_CYCLONESSL_01_053: [ If the IO is open, tlsio_cyclonessl_dowork shall attempt to read up to TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE bytes from the TLS library by calling tlsRead. ]*/
 TEST_FUNCTION(tlsio_cyclonessl_dowork_when_2_bytes_are_available_they_are_indicated_as_received)
 {
     ///arrange
@@ -1075,7 +1075,7 @@ TEST_FUNCTION(tlsio_cyclonessl_dowork_when_2_bytes_are_available_they_are_indica
     (void)tlsio_cyclonessl_get_interface_description()->concrete_io_open(tlsio_handle, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, 64, IGNORED_PTR_ARG, 0))
+    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE, IGNORED_PTR_ARG, 0))
         .CopyOutArgumentBuffer_data(test_buffer, sizeof(test_buffer))
         .CopyOutArgumentBuffer_received(&received, sizeof(received));
     STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(test_buffer)))
@@ -1161,7 +1161,7 @@ TEST_FUNCTION(when_tlsRead_fails_then_tlsio_cyclonessl_dowork_indicates_an_error
     (void)tlsio_cyclonessl_get_interface_description()->concrete_io_open(tlsio_handle, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, 64, IGNORED_PTR_ARG, 0))
+    STRICT_EXPECTED_CALL(tlsRead(TEST_TLS_CONTEXT, IGNORED_PTR_ARG, TLSIO_CYCLONESSL_RECEIVE_BUFFER_SIZE, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_data()
         .IgnoreArgument_received()
         .SetReturn(ERROR_INVALID_PARAMETER);
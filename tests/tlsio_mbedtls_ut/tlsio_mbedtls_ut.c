@@ -0,0 +1,865 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+#include "mbedtls/config.h"
+#include "mbedtls/debug.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    int real_mallocAndStrcpy_s(char** destination, const char* source);
+#ifdef __cplusplus
+}
+#endif
+
+typedef int(*TEST_RNG_CALLBACK)(void*, unsigned char*, size_t);
+typedef void(*TEST_DEBUG_CALLBACK)(void*, int, const char*, int, const char*);
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/*from mbedtls/entropy.h and mbedtls/ctr_drbg.h*/
+MOCKABLE_FUNCTION(, void, mbedtls_entropy_init, mbedtls_entropy_context*, ctx);
+MOCKABLE_FUNCTION(, void, mbedtls_entropy_free, mbedtls_entropy_context*, ctx);
+MOCKABLE_FUNCTION(, int, mbedtls_entropy_add_source, mbedtls_entropy_context*, ctx, mbedtls_entropy_f_source_ptr, f_source, void*, p_source, size_t, threshold, int, strong);
+MOCKABLE_FUNCTION(, int, mbedtls_entropy_func, void*, data, unsigned char*, output, size_t, len);
+MOCKABLE_FUNCTION(, void, mbedtls_ctr_drbg_init, mbedtls_ctr_drbg_context*, ctx);
+MOCKABLE_FUNCTION(, void, mbedtls_ctr_drbg_free, mbedtls_ctr_drbg_context*, ctx);
+MOCKABLE_FUNCTION(, int, mbedtls_ctr_drbg_seed, mbedtls_ctr_drbg_context*, ctx, TEST_RNG_CALLBACK, f_entropy, void*, p_entropy, const unsigned char*, custom, size_t, len);
+MOCKABLE_FUNCTION(, int, mbedtls_ctr_drbg_random, void*, p_rng, unsigned char*, output, size_t, output_len);
+
+/*from mbedtls/x509_crt.h*/
+MOCKABLE_FUNCTION(, void, mbedtls_x509_crt_init, mbedtls_x509_crt*, crt);
+MOCKABLE_FUNCTION(, void, mbedtls_x509_crt_free, mbedtls_x509_crt*, crt);
+MOCKABLE_FUNCTION(, int, mbedtls_x509_crt_parse, mbedtls_x509_crt*, chain, const unsigned char*, buf, size_t, buflen);
+
+/*from mbedtls/debug.h*/
+MOCKABLE_FUNCTION(, void, mbedtls_debug_set_threshold, int, threshold);
+
+/*from mbedtls/ssl.h*/
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_init, mbedtls_ssl_context*, ssl);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_free, mbedtls_ssl_context*, ssl);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_session_init, mbedtls_ssl_session*, session);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_session_free, mbedtls_ssl_session*, session);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_config_init, mbedtls_ssl_config*, conf);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_config_free, mbedtls_ssl_config*, conf);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_config_defaults, mbedtls_ssl_config*, conf, int, endpoint, int, transport, int, preset);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_conf_rng, mbedtls_ssl_config*, conf, TEST_RNG_CALLBACK, f_rng, void*, p_rng);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_conf_authmode, mbedtls_ssl_config*, conf, int, authmode);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_conf_min_version, mbedtls_ssl_config*, conf, int, major, int, minor);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_conf_ca_chain, mbedtls_ssl_config*, conf, mbedtls_x509_crt*, ca_chain, mbedtls_x509_crl*, ca_crl);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_conf_dbg, mbedtls_ssl_config*, conf, TEST_DEBUG_CALLBACK, f_dbg, void*, p_dbg);
+MOCKABLE_FUNCTION(, void, mbedtls_ssl_set_bio, mbedtls_ssl_context*, ssl, void*, p_bio, mbedtls_ssl_send_t*, f_send, mbedtls_ssl_recv_t*, f_recv, mbedtls_ssl_recv_timeout_t*, f_recv_timeout);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_set_hostname, mbedtls_ssl_context*, ssl, const char*, hostname);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_setup, mbedtls_ssl_context*, ssl, const mbedtls_ssl_config*, conf);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_set_session, mbedtls_ssl_context*, ssl, const mbedtls_ssl_session*, session);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_get_session, const mbedtls_ssl_context*, ssl, mbedtls_ssl_session*, session);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_session_reset, mbedtls_ssl_context*, ssl);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_handshake, mbedtls_ssl_context*, ssl);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_read, mbedtls_ssl_context*, ssl, unsigned char*, buf, size_t, len);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_write, mbedtls_ssl_context*, ssl, const unsigned char*, buf, size_t, len);
+MOCKABLE_FUNCTION(, int, mbedtls_ssl_close_notify, mbedtls_ssl_context*, ssl);
+MOCKABLE_FUNCTION(, size_t, mbedtls_ssl_get_bytes_avail, const mbedtls_ssl_context*, ssl);
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_mbedtls.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FUNCTION match_function, const void* match_context);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#define TEST_IO_HANDLE                      (XIO_HANDLE)0x4243
+#define TEST_SOCKETIO_INTERFACE             (const IO_INTERFACE_DESCRIPTION*)0x4245
+#define TEST_LOCK_HANDLE                    (LOCK_HANDLE)0x4246
+
+#define TEST_HOSTNAME                       "test.azure-devices.net"
+#define TEST_PORT                           443
+#define TEST_TRUSTED_CERTIFICATES_1         "test certificates 1"
+#define TEST_TRUSTED_CERTIFICATES_2         "test certificates 2"
+#define TEST_SESSION_CACHE_MAX_ENTRIES      16
+#define TEST_MAX_SESSIONS                   (TEST_SESSION_CACHE_MAX_ENTRIES + 4)
+#define TEST_RECORD_SIZE                    100
+
+static const IO_INTERFACE_DESCRIPTION* g_tlsio_interface;
+static bool g_is_initialized;
+static CONCRETE_IO_HANDLE g_tlsio;
+static CONCRETE_IO_HANDLE g_tlsio_2;
+
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+static mbedtls_ssl_recv_t* g_bio_recv;
+static void* g_bio_context;
+
+/* behavior of the mocks */
+static LOCK_RESULT g_lock_result;
+static int g_handshake_result;
+static int g_server_session_id;
+static size_t g_plaintext_available;
+
+/* the sessions the mocks filled, a session is known by its address */
+static const mbedtls_ssl_session* g_sessions[TEST_MAX_SESSIONS];
+static int g_session_ids[TEST_MAX_SESSIONS];
+
+/* what the mocks saw */
+static int g_restored_session_id;
+static size_t g_set_session_count;
+static size_t g_x509_crt_free_count;
+static size_t g_xio_wait_count;
+static unsigned int g_xio_wait_timeout;
+static IO_WAIT_INTEREST g_xio_wait_interest;
+
+static size_t g_open_complete_count;
+static IO_OPEN_RESULT g_last_open_result;
+static size_t g_bytes_received_count;
+static size_t g_bytes_received_sizes[4];
+static size_t g_close_complete_count;
+
+static size_t get_live_session_count(void)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < TEST_MAX_SESSIONS; i++)
+    {
+        if (g_sessions[i] != NULL)
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static void forget_session(const mbedtls_ssl_session* session)
+{
+    size_t i;
+
+    for (i = 0; i < TEST_MAX_SESSIONS; i++)
+    {
+        if (g_sessions[i] == session)
+        {
+            g_sessions[i] = NULL;
+            g_session_ids[i] = 0;
+        }
+    }
+}
+
+static LOCK_RESULT my_Lock(LOCK_HANDLE handle)
+{
+    (void)handle;
+    return g_lock_result;
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_wait(XIO_HANDLE xio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    (void)xio;
+    g_xio_wait_count++;
+    g_xio_wait_timeout = timeout_ms;
+    g_xio_wait_interest = interest;
+    return 0;
+}
+
+static void my_mbedtls_x509_crt_free(mbedtls_x509_crt* crt)
+{
+    (void)crt;
+    g_x509_crt_free_count++;
+}
+
+static void my_mbedtls_ssl_set_bio(mbedtls_ssl_context* ssl, void* p_bio, mbedtls_ssl_send_t* f_send, mbedtls_ssl_recv_t* f_recv, mbedtls_ssl_recv_timeout_t* f_recv_timeout)
+{
+    (void)ssl;
+    (void)f_send;
+    (void)f_recv_timeout;
+    g_bio_recv = f_recv;
+    g_bio_context = p_bio;
+}
+
+static void my_mbedtls_ssl_session_free(mbedtls_ssl_session* session)
+{
+    forget_session(session);
+}
+
+static int my_mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session)
+{
+    size_t i;
+    (void)ssl;
+
+    forget_session(session);
+    for (i = 0; i < TEST_MAX_SESSIONS; i++)
+    {
+        if (g_sessions[i] == NULL)
+        {
+            g_sessions[i] = session;
+            g_session_ids[i] = g_server_session_id;
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static int my_mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session)
+{
+    size_t i;
+    (void)ssl;
+
+    g_set_session_count++;
+    for (i = 0; i < TEST_MAX_SESSIONS; i++)
+    {
+        if (g_sessions[i] == session)
+        {
+            g_restored_session_id = g_session_ids[i];
+        }
+    }
+
+    return 0;
+}
+
+static int my_mbedtls_ssl_handshake(mbedtls_ssl_context* ssl)
+{
+    (void)ssl;
+    return g_handshake_result;
+}
+
+static int my_mbedtls_ssl_read(mbedtls_ssl_context* ssl, unsigned char* buf, size_t len)
+{
+    int result;
+    (void)ssl;
+
+    if (g_plaintext_available == 0)
+    {
+        result = MBEDTLS_ERR_SSL_WANT_READ;
+    }
+    else
+    {
+        /* one record at most per read, like mbedTLS */
+        size_t size = (g_plaintext_available < TEST_RECORD_SIZE) ? g_plaintext_available : TEST_RECORD_SIZE;
+        if (size > len)
+        {
+            size = len;
+        }
+        (void)memset(buf, 'x', size);
+        g_plaintext_available -= size;
+        result = (int)size;
+    }
+
+    return result;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_open_complete_count++;
+    g_last_open_result = open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    if (g_bytes_received_count < sizeof(g_bytes_received_sizes) / sizeof(g_bytes_received_sizes[0]))
+    {
+        g_bytes_received_sizes[g_bytes_received_count] = size;
+    }
+    g_bytes_received_count++;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+}
+
+static void test_on_io_close_complete(void* context)
+{
+    (void)context;
+    g_close_complete_count++;
+}
+
+static CONCRETE_IO_HANDLE create_tlsio_with_port(int port)
+{
+    TLSIO_CONFIG config;
+    config.hostname = TEST_HOSTNAME;
+    config.port = port;
+    config.underlying_io_interface = NULL;
+    config.underlying_io_parameters = NULL;
+    return g_tlsio_interface->concrete_io_create(&config);
+}
+
+/* a tlsio with OPTION_TLS_SESSION_RESUMPTION set */
+static CONCRETE_IO_HANDLE create_resuming_tlsio(int port, const char* trusted_certificates)
+{
+    CONCRETE_IO_HANDLE result = create_tlsio_with_port(port);
+    bool value = true;
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(result, OPTION_TLS_SESSION_RESUMPTION, &value));
+    if (trusted_certificates != NULL)
+    {
+        ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(result, OPTION_TRUSTED_CERT, trusted_certificates));
+    }
+    return result;
+}
+
+static int open_tlsio(CONCRETE_IO_HANDLE tlsio)
+{
+    return g_tlsio_interface->concrete_io_open(tlsio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+}
+
+/* opens tlsio and lets the server issue the session server_session_id */
+static void open_and_finish_handshake(CONCRETE_IO_HANDLE tlsio, int server_session_id)
+{
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(tlsio));
+    g_server_session_id = server_session_id;
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_last_open_result);
+}
+
+static void close_tlsio(CONCRETE_IO_HANDLE tlsio)
+{
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_close(tlsio, test_on_io_close_complete, NULL));
+    g_on_io_close_complete(g_on_io_close_complete_context);
+}
+
+static void receive_server_bytes(const char* bytes)
+{
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)bytes, strlen(bytes));
+}
+
+static void reset_test_counters(void)
+{
+    g_restored_session_id = 0;
+    g_set_session_count = 0;
+    g_x509_crt_free_count = 0;
+    g_xio_wait_count = 0;
+    g_xio_wait_timeout = 0;
+    g_xio_wait_interest = IO_WAIT_READ;
+    g_open_complete_count = 0;
+    g_last_open_result = IO_OPEN_ERROR;
+    g_bytes_received_count = 0;
+    g_close_complete_count = 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(tlsio_mbedtls_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, real_singlylinkedlist_find);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(Lock, my_Lock);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_wait, my_xio_wait);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_x509_crt_free, my_mbedtls_x509_crt_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_set_bio, my_mbedtls_ssl_set_bio);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_session_free, my_mbedtls_ssl_session_free);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_get_session, my_mbedtls_ssl_get_session);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_set_session, my_mbedtls_ssl_set_session);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_handshake, my_mbedtls_ssl_handshake);
+    REGISTER_GLOBAL_MOCK_HOOK(mbedtls_ssl_read, my_mbedtls_ssl_read);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_get_interface_description, TEST_SOCKETIO_INTERFACE);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(mbedtls_entropy_f_source_ptr, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_RNG_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_DEBUG_CALLBACK, void*);
+
+    g_tlsio_interface = tlsio_mbedtls_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    g_tlsio = NULL;
+    g_tlsio_2 = NULL;
+    g_on_io_open_complete = NULL;
+    g_on_bytes_received = NULL;
+    g_on_io_close_complete = NULL;
+    g_bio_recv = NULL;
+    g_bio_context = NULL;
+    g_lock_result = LOCK_OK;
+    g_handshake_result = 0;
+    g_server_session_id = 0;
+    g_plaintext_available = 0;
+    (void)memset(g_sessions, 0, sizeof(g_sessions));
+    (void)memset(g_session_ids, 0, sizeof(g_session_ids));
+    reset_test_counters();
+
+    ASSERT_ARE_EQUAL(int, 0, tlsio_mbedtls_init());
+    g_is_initialized = true;
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    g_lock_result = LOCK_OK;
+
+    if (g_tlsio != NULL)
+    {
+        g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    }
+    if (g_tlsio_2 != NULL)
+    {
+        g_tlsio_interface->concrete_io_destroy(g_tlsio_2);
+    }
+    if (g_is_initialized)
+    {
+        tlsio_mbedtls_deinit();
+    }
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* TLS session resumption */
+
+TEST_FUNCTION(a_reopened_tlsio_restores_its_own_session)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, NULL);
+    open_and_finish_handshake(g_tlsio, 1);
+    close_tlsio(g_tlsio);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_set_session_count);
+    ASSERT_ARE_EQUAL(int, 1, g_restored_session_id);
+}
+
+TEST_FUNCTION(without_session_resumption_no_session_is_restored)
+{
+    // arrange
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 1);
+    close_tlsio(g_tlsio);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+    ASSERT_ARE_EQUAL(size_t, 0, get_live_session_count());
+}
+
+TEST_FUNCTION(a_new_tlsio_restores_the_session_cached_by_another_one)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_1);
+    open_and_finish_handshake(g_tlsio, 1);
+    g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    g_tlsio = NULL;
+    g_tlsio_2 = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_1);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_set_session_count);
+    ASSERT_ARE_EQUAL(int, 1, g_restored_session_id);
+}
+
+TEST_FUNCTION(without_tlsio_mbedtls_init_a_new_tlsio_does_a_full_handshake)
+{
+    // arrange
+    tlsio_mbedtls_deinit();
+    g_is_initialized = false;
+    g_tlsio = create_resuming_tlsio(TEST_PORT, NULL);
+    open_and_finish_handshake(g_tlsio, 1);
+    g_tlsio_2 = create_resuming_tlsio(TEST_PORT, NULL);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+}
+
+TEST_FUNCTION(a_cached_session_is_not_restored_with_other_trusted_certificates)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_1);
+    open_and_finish_handshake(g_tlsio, 1);
+    g_tlsio_2 = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_2);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+}
+
+TEST_FUNCTION(changing_the_trusted_certificates_drops_the_session_of_the_tlsio)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_1);
+    open_and_finish_handshake(g_tlsio, 1);
+    close_tlsio(g_tlsio);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TRUSTED_CERT, TEST_TRUSTED_CERTIFICATES_2));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+    /* the new certificates replace the parsed ones instead of being added to them */
+    ASSERT_ARE_EQUAL(size_t, 1, g_x509_crt_free_count);
+}
+
+TEST_FUNCTION(setting_the_same_trusted_certificates_again_keeps_the_session_of_the_tlsio)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, TEST_TRUSTED_CERTIFICATES_1);
+    open_and_finish_handshake(g_tlsio, 1);
+    close_tlsio(g_tlsio);
+    reset_test_counters();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TRUSTED_CERT, TEST_TRUSTED_CERTIFICATES_1));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_set_session_count);
+    ASSERT_ARE_EQUAL(int, 1, g_restored_session_id);
+}
+
+TEST_FUNCTION(a_failed_handshake_removes_the_saved_and_the_cached_session)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, NULL);
+    open_and_finish_handshake(g_tlsio, 1);
+    close_tlsio(g_tlsio);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    g_handshake_result = MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE;
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, get_live_session_count());
+
+    g_tlsio_2 = create_resuming_tlsio(TEST_PORT, NULL);
+    reset_test_counters();
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+}
+
+TEST_FUNCTION(the_session_cache_drops_the_oldest_session_when_it_is_full)
+{
+    // arrange
+    int port;
+    for (port = 1; port <= TEST_SESSION_CACHE_MAX_ENTRIES + 1; port++)
+    {
+        g_tlsio = create_resuming_tlsio(port, NULL);
+        open_and_finish_handshake(g_tlsio, port);
+        g_tlsio_interface->concrete_io_destroy(g_tlsio);
+        g_tlsio = NULL;
+    }
+    ASSERT_ARE_EQUAL(size_t, TEST_SESSION_CACHE_MAX_ENTRIES, get_live_session_count());
+
+    // act
+    g_tlsio = create_resuming_tlsio(1, NULL);
+    g_tlsio_2 = create_resuming_tlsio(TEST_SESSION_CACHE_MAX_ENTRIES + 1, NULL);
+    reset_test_counters();
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    ASSERT_ARE_EQUAL(size_t, 0, g_set_session_count);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_set_session_count);
+    ASSERT_ARE_EQUAL(int, TEST_SESSION_CACHE_MAX_ENTRIES + 1, g_restored_session_id);
+}
+
+TEST_FUNCTION(tlsio_mbedtls_deinit_frees_the_cached_sessions)
+{
+    // arrange
+    g_tlsio = create_resuming_tlsio(TEST_PORT, NULL);
+    open_and_finish_handshake(g_tlsio, 1);
+    g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    g_tlsio = NULL;
+    ASSERT_ARE_EQUAL(size_t, 1, get_live_session_count());
+
+    // act
+    tlsio_mbedtls_deinit();
+    g_is_initialized = false;
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, get_live_session_count());
+}
+
+/* received bytes */
+
+TEST_FUNCTION(bytes_received_in_pieces_are_read_by_mbedtls_in_order)
+{
+    // arrange
+    unsigned char buffer[16];
+    int result_1;
+    int result_2;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 0);
+    receive_server_bytes("abc");
+    receive_server_bytes("defgh");
+    receive_server_bytes("ij");
+
+    // act
+    result_1 = g_bio_recv(g_bio_context, buffer, 4);
+    result_2 = g_bio_recv(g_bio_context, buffer + 4, sizeof(buffer) - 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 4, result_1);
+    ASSERT_ARE_EQUAL(int, 6, result_2);
+    ASSERT_IS_TRUE(memcmp(buffer, "abcdefghij", 10) == 0);
+}
+
+TEST_FUNCTION(bytes_received_after_a_partial_read_follow_the_unread_ones)
+{
+    // arrange
+    unsigned char buffer[16];
+    int result_1;
+    int result_2;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 0);
+    receive_server_bytes("abcdef");
+    result_1 = g_bio_recv(g_bio_context, buffer, 2);
+
+    // act
+    receive_server_bytes("ghijklmnop");
+    result_2 = g_bio_recv(g_bio_context, buffer + 2, sizeof(buffer) - 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, result_1);
+    ASSERT_ARE_EQUAL(int, 14, result_2);
+    ASSERT_IS_TRUE(memcmp(buffer, "abcdefghijklmnop", 16) == 0);
+}
+
+TEST_FUNCTION(dowork_hands_up_the_records_read_in_one_callback)
+{
+    // arrange
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 0);
+    g_plaintext_available = 3 * TEST_RECORD_SIZE;
+
+    // act
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, 3 * TEST_RECORD_SIZE, g_bytes_received_sizes[0]);
+}
+
+TEST_FUNCTION(dowork_hands_up_at_most_tls_receive_buffer_size_bytes_per_callback)
+{
+    // arrange
+    size_t receive_buffer_size = (5 * TEST_RECORD_SIZE) / 2;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size));
+    open_and_finish_handshake(g_tlsio, 0);
+    g_plaintext_available = 3 * TEST_RECORD_SIZE;
+
+    // act
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_bytes_received_count);
+    ASSERT_ARE_EQUAL(size_t, receive_buffer_size, g_bytes_received_sizes[0]);
+    ASSERT_ARE_EQUAL(size_t, 3 * TEST_RECORD_SIZE - receive_buffer_size, g_bytes_received_sizes[1]);
+}
+
+TEST_FUNCTION(tlsio_mbedtls_setoption_with_a_zero_tls_receive_buffer_size_fails)
+{
+    // arrange
+    int result;
+    size_t receive_buffer_size = 0;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+
+    // act
+    result = g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TLS_RECEIVE_BUFFER_SIZE, &receive_buffer_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* xio_wait */
+
+TEST_FUNCTION(tlsio_mbedtls_wait_returns_at_once_when_received_bytes_are_pending)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 0);
+    receive_server_bytes("abc");
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_wait_count);
+}
+
+TEST_FUNCTION(tlsio_mbedtls_wait_waits_on_the_underlying_io)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+    open_and_finish_handshake(g_tlsio, 0);
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 1000, IO_WAIT_READ_WRITE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_wait_count);
+    ASSERT_ARE_EQUAL(int, 1000, (int)g_xio_wait_timeout);
+    ASSERT_ARE_EQUAL(int, (int)IO_WAIT_READ_WRITE, (int)g_xio_wait_interest);
+}
+
+TEST_FUNCTION(tlsio_mbedtls_wait_on_a_tlsio_that_is_not_open_fails)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio_with_port(TEST_PORT);
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_wait_count);
+}
+
+END_TEST_SUITE(tlsio_mbedtls_unittests)
@@ -0,0 +1,1664 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+#else
+#include <stdlib.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umock_c_negative_tests.h"
+
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/crypto.h"
+#include "openssl/opensslv.h"
+#ifndef WIN32
+#include <sys/socket.h>
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    int real_mallocAndStrcpy_s(char** destination, const char* source);
+#ifdef __cplusplus
+}
+#endif
+
+typedef int(*TEST_CERT_VERIFY_CALLBACK)(X509_STORE_CTX*, void*);
+typedef int(*TEST_NEW_SESSION_CALLBACK)(SSL*, SSL_SESSION*);
+typedef int(*TEST_BIO_WRITE_CALLBACK)(BIO*, const char*, int);
+typedef int(*TEST_BIO_READ_CALLBACK)(BIO*, char*, int);
+typedef long(*TEST_BIO_CTRL_CALLBACK)(BIO*, int, long, void*);
+typedef int(*TEST_BIO_CREATE_CALLBACK)(BIO*);
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/x509_openssl.h"
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+/* these tests are written against OpenSSL 1.1.0 and later, where the library initialization and the locking callbacks are macros */
+
+/*from openssl/ssl.h*/
+MOCKABLE_FUNCTION(, int, OPENSSL_init_ssl, uint64_t, opts, const OPENSSL_INIT_SETTINGS*, settings);
+MOCKABLE_FUNCTION(, const SSL_METHOD*, TLS_method);
+MOCKABLE_FUNCTION(, const SSL_METHOD*, TLSv1_method);
+MOCKABLE_FUNCTION(, const SSL_METHOD*, TLSv1_1_method);
+MOCKABLE_FUNCTION(, const SSL_METHOD*, TLSv1_2_method);
+MOCKABLE_FUNCTION(, SSL_CTX*, SSL_CTX_new, const SSL_METHOD*, meth);
+MOCKABLE_FUNCTION(, void, SSL_CTX_free, SSL_CTX*, ctx);
+MOCKABLE_FUNCTION(, long, SSL_CTX_ctrl, SSL_CTX*, ctx, int, cmd, long, larg, void*, parg);
+MOCKABLE_FUNCTION(, void, SSL_CTX_set_cert_verify_callback, SSL_CTX*, ctx, TEST_CERT_VERIFY_CALLBACK, cb, void*, arg);
+MOCKABLE_FUNCTION(, void, SSL_CTX_set_verify, SSL_CTX*, ctx, int, mode, SSL_verify_cb, callback);
+MOCKABLE_FUNCTION(, void, SSL_CTX_sess_set_new_cb, SSL_CTX*, ctx, TEST_NEW_SESSION_CALLBACK, new_session_cb);
+MOCKABLE_FUNCTION(, int, SSL_CTX_set_default_verify_paths, SSL_CTX*, ctx);
+MOCKABLE_FUNCTION(, SSL*, SSL_new, SSL_CTX*, ctx);
+MOCKABLE_FUNCTION(, void, SSL_free, SSL*, ssl);
+MOCKABLE_FUNCTION(, void, SSL_set_bio, SSL*, s, BIO*, rbio, BIO*, wbio);
+MOCKABLE_FUNCTION(, long, SSL_ctrl, SSL*, ssl, int, cmd, long, larg, void*, parg);
+MOCKABLE_FUNCTION(, int, SSL_set_ex_data, SSL*, ssl, int, idx, void*, data);
+MOCKABLE_FUNCTION(, void*, SSL_get_ex_data, const SSL*, ssl, int, idx);
+MOCKABLE_FUNCTION(, void, SSL_set_connect_state, SSL*, s);
+MOCKABLE_FUNCTION(, int, SSL_set_session, SSL*, to, SSL_SESSION*, session);
+MOCKABLE_FUNCTION(, void, SSL_SESSION_free, SSL_SESSION*, ses);
+MOCKABLE_FUNCTION(, int, SSL_do_handshake, SSL*, s);
+MOCKABLE_FUNCTION(, int, SSL_get_error, const SSL*, s, int, ret_code);
+MOCKABLE_FUNCTION(, int, SSL_read, SSL*, ssl, void*, buf, int, num);
+MOCKABLE_FUNCTION(, int, SSL_write, SSL*, ssl, const void*, buf, int, num);
+MOCKABLE_FUNCTION(, int, SSL_pending, const SSL*, s);
+MOCKABLE_FUNCTION(, int, SSL_is_init_finished, const SSL*, s);
+MOCKABLE_FUNCTION(, void, SSL_set_shutdown, SSL*, ssl, int, mode);
+MOCKABLE_FUNCTION(, BIO*, SSL_get_rbio, const SSL*, s);
+MOCKABLE_FUNCTION(, BIO*, SSL_get_wbio, const SSL*, s);
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+MOCKABLE_FUNCTION(, SSL_SESSION*, SSL_get_session, const SSL*, ssl);
+MOCKABLE_FUNCTION(, uint32_t, SSL_SESSION_get_max_early_data, const SSL_SESSION*, s);
+MOCKABLE_FUNCTION(, int, SSL_write_early_data, SSL*, s, const void*, buf, size_t, num, size_t*, written);
+MOCKABLE_FUNCTION(, int, SSL_get_early_data_status, const SSL*, s);
+#endif
+#ifdef SSL_OP_ENABLE_KTLS
+MOCKABLE_FUNCTION(, uint64_t, SSL_set_options, SSL*, s, uint64_t, op);
+#endif
+
+/*from openssl/bio.h*/
+MOCKABLE_FUNCTION(, const BIO_METHOD*, BIO_s_mem);
+MOCKABLE_FUNCTION(, const BIO_METHOD*, BIO_s_socket);
+MOCKABLE_FUNCTION(, BIO*, BIO_new, const BIO_METHOD*, type);
+MOCKABLE_FUNCTION(, int, BIO_free, BIO*, a);
+MOCKABLE_FUNCTION(, int, BIO_read, BIO*, b, void*, data, int, dlen);
+MOCKABLE_FUNCTION(, int, BIO_write, BIO*, b, const void*, data, int, dlen);
+MOCKABLE_FUNCTION(, long, BIO_ctrl, BIO*, bp, int, cmd, long, larg, void*, parg);
+MOCKABLE_FUNCTION(, long, BIO_int_ctrl, BIO*, bp, int, cmd, long, larg, int, iarg);
+MOCKABLE_FUNCTION(, size_t, BIO_ctrl_pending, BIO*, b);
+MOCKABLE_FUNCTION(, void, BIO_set_flags, BIO*, b, int, flags);
+MOCKABLE_FUNCTION(, void, BIO_clear_flags, BIO*, b, int, flags);
+MOCKABLE_FUNCTION(, int, BIO_sock_should_retry, int, i);
+MOCKABLE_FUNCTION(, BIO_METHOD*, BIO_meth_new, int, type, const char*, name);
+MOCKABLE_FUNCTION(, void, BIO_meth_free, BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, TEST_BIO_WRITE_CALLBACK, BIO_meth_get_write, const BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, int, BIO_meth_set_write, BIO_METHOD*, biom, TEST_BIO_WRITE_CALLBACK, write);
+MOCKABLE_FUNCTION(, TEST_BIO_READ_CALLBACK, BIO_meth_get_read, const BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, int, BIO_meth_set_read, BIO_METHOD*, biom, TEST_BIO_READ_CALLBACK, read);
+MOCKABLE_FUNCTION(, TEST_BIO_CTRL_CALLBACK, BIO_meth_get_ctrl, const BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, int, BIO_meth_set_ctrl, BIO_METHOD*, biom, TEST_BIO_CTRL_CALLBACK, ctrl);
+MOCKABLE_FUNCTION(, TEST_BIO_CREATE_CALLBACK, BIO_meth_get_create, const BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, int, BIO_meth_set_create, BIO_METHOD*, biom, TEST_BIO_CREATE_CALLBACK, create);
+MOCKABLE_FUNCTION(, TEST_BIO_CREATE_CALLBACK, BIO_meth_get_destroy, const BIO_METHOD*, biom);
+MOCKABLE_FUNCTION(, int, BIO_meth_set_destroy, BIO_METHOD*, biom, TEST_BIO_CREATE_CALLBACK, destroy);
+
+/*from openssl/err.h and openssl/crypto.h*/
+MOCKABLE_FUNCTION(, int, OPENSSL_init_crypto, uint64_t, opts, const OPENSSL_INIT_SETTINGS*, settings);
+MOCKABLE_FUNCTION(, unsigned long, ERR_get_error);
+MOCKABLE_FUNCTION(, char*, ERR_error_string, unsigned long, e, char*, buf);
+MOCKABLE_FUNCTION(, void, ERR_clear_error);
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+MOCKABLE_FUNCTION(, int, ERR_load_BIO_strings);
+#endif
+#if (OPENSSL_VERSION_NUMBER >= 0x20000000L)
+MOCKABLE_FUNCTION(, void, ERR_remove_thread_state, void*, tid);
+#else
+MOCKABLE_FUNCTION(, int, FIPS_mode_set, int, r);
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/tlsio_openssl.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE list, LIST_MATCH_FUNCTION match_function, const void* match_context);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(COND_RESULT, COND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
+#define TEST_IO_HANDLE                      (XIO_HANDLE)0x4243
+#define TEST_OPTION_HANDLER                 (OPTIONHANDLER_HANDLE)0x4244
+#define TEST_SOCKETIO_INTERFACE             (const IO_INTERFACE_DESCRIPTION*)0x4245
+#define TEST_LOCK_HANDLE                    (LOCK_HANDLE)0x4246
+#define TEST_COND_HANDLE                    (COND_HANDLE)0x4247
+#define TEST_THREAD_HANDLE                  (THREAD_HANDLE)0x4248
+#define TEST_SSL_METHOD                     (const SSL_METHOD*)0x4249
+#define TEST_BIO_METHOD                     (const BIO_METHOD*)0x424A
+#define TEST_NOSIGNAL_BIO_METHOD            (BIO_METHOD*)0x424C
+
+#define TEST_HOSTNAME                       "test.azure-devices.net"
+#define TEST_PORT                           443
+#define TEST_SOCKET                         42
+#define TEST_MAX_EARLY_DATA                 100
+#define TEST_MAX_SSL_WRITES                 8
+
+/* what the tests need to know about an SSL object */
+typedef struct TEST_SSL_TAG
+{
+    BIO* rbio;
+    BIO* wbio;
+    void* app_data;
+    SSL_SESSION* session;
+    SSL_SESSION* session_at_connect_state;
+} TEST_SSL;
+
+static const IO_INTERFACE_DESCRIPTION* g_tlsio_interface;
+static bool g_is_initialized;
+static CONCRETE_IO_HANDLE g_tlsio;
+static CONCRETE_IO_HANDLE g_tlsio_2;
+
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+
+static TEST_NEW_SESSION_CALLBACK g_new_session_cb;
+static THREAD_START_FUNC g_worker_func;
+static void* g_worker_arg;
+
+/* behavior of the mocks */
+static LOCK_RESULT g_lock_result;
+static THREADAPI_RESULT g_thread_create_result;
+static COND_RESULT g_condition_wait_result;
+static size_t g_fail_list_add_at;
+static int g_socket_handoff_result;
+static BIO_METHOD* g_bio_meth_new_result;
+static int g_bio_meth_new_type;
+static TEST_BIO_WRITE_CALLBACK g_bio_meth_write;
+static int g_handshake_result;
+static int g_ssl_error;
+static bool g_limit_socket_capacity;
+static size_t g_socket_capacity;
+static uint32_t g_max_early_data;
+static int g_early_data_status;
+
+/* what the mocks saw */
+static SSL* g_last_ssl;
+static SSL_CTX* g_ssl_ctx_of_ssl[2];
+static size_t g_ssl_new_count;
+static size_t g_ssl_ctx_new_count;
+static size_t g_ssl_ctx_free_count;
+static size_t g_session_free_count;
+static SSL_SESSION* g_last_freed_session;
+static size_t g_list_add_count;
+static size_t g_thread_create_count;
+static size_t g_condition_wait_count;
+static int g_condition_waited_ms;
+static size_t g_xio_wait_count;
+static size_t g_handshake_count;
+static size_t g_bio_write_count;
+static int g_bio_write_size;
+static int g_socket_bio_fd;
+static uint64_t g_ssl_options;
+static size_t g_early_data_written;
+static size_t g_ssl_write_count;
+static int g_ssl_write_sizes[TEST_MAX_SSL_WRITES];
+static unsigned char g_written[256];
+static size_t g_written_size;
+
+static size_t g_open_complete_count;
+static IO_OPEN_RESULT g_last_open_result;
+static size_t g_io_error_count;
+static size_t g_send_complete_count;
+static IO_SEND_RESULT g_last_send_result;
+static size_t g_close_complete_count;
+
+static LOCK_RESULT my_Lock(LOCK_HANDLE handle)
+{
+    (void)handle;
+    return g_lock_result;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    g_thread_create_count++;
+    if (g_thread_create_result == THREADAPI_OK)
+    {
+        /* the tests run the worker themselves, on the test thread */
+        *threadHandle = TEST_THREAD_HANDLE;
+        g_worker_func = func;
+        g_worker_arg = arg;
+    }
+    return g_thread_create_result;
+}
+
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    (void)handle;
+    (void)lock;
+    g_condition_wait_count++;
+    g_condition_waited_ms += timeout_milliseconds;
+    return g_condition_wait_result;
+}
+
+static int my_xio_wait(XIO_HANDLE xio, unsigned int timeout_ms, IO_WAIT_INTEREST interest)
+{
+    (void)xio;
+    (void)timeout_ms;
+    (void)interest;
+    g_xio_wait_count++;
+    return 0;
+}
+
+static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
+{
+    g_list_add_count++;
+    return (g_list_add_count == g_fail_list_add_at) ? NULL : real_singlylinkedlist_add(list, item);
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
+{
+    (void)xio;
+    if ((strcmp(optionName, OPTION_SOCKET_DESCRIPTOR_HANDOFF) == 0) &&
+        (g_socket_handoff_result == 0))
+    {
+        *(int*)value = TEST_SOCKET;
+    }
+    return (strcmp(optionName, OPTION_SOCKET_DESCRIPTOR_HANDOFF) == 0) ? g_socket_handoff_result : 0;
+}
+
+static SSL_CTX* my_SSL_CTX_new(const SSL_METHOD* meth)
+{
+    (void)meth;
+    g_ssl_ctx_new_count++;
+    return (SSL_CTX*)malloc(1);
+}
+
+static void my_SSL_CTX_free(SSL_CTX* ctx)
+{
+    g_ssl_ctx_free_count++;
+    free(ctx);
+}
+
+static void my_SSL_CTX_sess_set_new_cb(SSL_CTX* ctx, TEST_NEW_SESSION_CALLBACK new_session_cb)
+{
+    (void)ctx;
+    g_new_session_cb = new_session_cb;
+}
+
+static SSL* my_SSL_new(SSL_CTX* ctx)
+{
+    TEST_SSL* test_ssl = (TEST_SSL*)malloc(sizeof(TEST_SSL));
+    (void)memset(test_ssl, 0, sizeof(TEST_SSL));
+    if (g_ssl_new_count < 2)
+    {
+        g_ssl_ctx_of_ssl[g_ssl_new_count] = ctx;
+    }
+    g_ssl_new_count++;
+    g_last_ssl = (SSL*)test_ssl;
+    return g_last_ssl;
+}
+
+/* like OpenSSL, the SSL object owns its BIOs */
+static void my_SSL_free(SSL* ssl)
+{
+    TEST_SSL* test_ssl = (TEST_SSL*)ssl;
+    if (test_ssl->wbio != test_ssl->rbio)
+    {
+        free(test_ssl->wbio);
+    }
+    free(test_ssl->rbio);
+    free(test_ssl);
+}
+
+static void my_SSL_set_bio(SSL* s, BIO* rbio, BIO* wbio)
+{
+    TEST_SSL* test_ssl = (TEST_SSL*)s;
+    if ((test_ssl->wbio != NULL) && (test_ssl->wbio != test_ssl->rbio) && (test_ssl->wbio != wbio))
+    {
+        free(test_ssl->wbio);
+    }
+    if ((test_ssl->rbio != NULL) && (test_ssl->rbio != rbio))
+    {
+        free(test_ssl->rbio);
+    }
+    test_ssl->rbio = rbio;
+    test_ssl->wbio = wbio;
+}
+
+static int my_SSL_set_ex_data(SSL* ssl, int idx, void* data)
+{
+    (void)idx;
+    ((TEST_SSL*)ssl)->app_data = data;
+    return 1;
+}
+
+static void* my_SSL_get_ex_data(const SSL* ssl, int idx)
+{
+    (void)idx;
+    return ((const TEST_SSL*)ssl)->app_data;
+}
+
+static void my_SSL_set_connect_state(SSL* s)
+{
+    TEST_SSL* test_ssl = (TEST_SSL*)s;
+    test_ssl->session_at_connect_state = test_ssl->session;
+}
+
+static int my_SSL_set_session(SSL* to, SSL_SESSION* session)
+{
+    ((TEST_SSL*)to)->session = session;
+    return 1;
+}
+
+static void my_SSL_SESSION_free(SSL_SESSION* ses)
+{
+    g_session_free_count++;
+    g_last_freed_session = ses;
+    free(ses);
+}
+
+static int my_SSL_do_handshake(SSL* s)
+{
+    (void)s;
+    g_handshake_count++;
+    return g_handshake_result;
+}
+
+static int my_SSL_get_error(const SSL* s, int ret_code)
+{
+    (void)s;
+    (void)ret_code;
+    return g_ssl_error;
+}
+
+/* with g_limit_socket_capacity set, SSL_write takes at most g_socket_capacity bytes, like a socket BIO on a full socket */
+static int my_SSL_write(SSL* ssl, const void* buf, int num)
+{
+    int result;
+    (void)ssl;
+
+    if (g_limit_socket_capacity && (g_socket_capacity == 0))
+    {
+        result = -1;
+    }
+    else
+    {
+        result = (g_limit_socket_capacity && ((size_t)num > g_socket_capacity)) ? (int)g_socket_capacity : num;
+        if (g_limit_socket_capacity)
+        {
+            g_socket_capacity -= result;
+        }
+
+        if (g_ssl_write_count < TEST_MAX_SSL_WRITES)
+        {
+            g_ssl_write_sizes[g_ssl_write_count] = result;
+        }
+        g_ssl_write_count++;
+
+        if (g_written_size + result <= sizeof(g_written))
+        {
+            (void)memcpy(g_written + g_written_size, buf, result);
+            g_written_size += result;
+        }
+    }
+
+    return result;
+}
+
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+static SSL_SESSION* my_SSL_get_session(const SSL* ssl)
+{
+    return ((const TEST_SSL*)ssl)->session;
+}
+
+static uint32_t my_SSL_SESSION_get_max_early_data(const SSL_SESSION* s)
+{
+    (void)s;
+    return g_max_early_data;
+}
+
+static int my_SSL_write_early_data(SSL* s, const void* buf, size_t num, size_t* written)
+{
+    (void)s;
+    (void)buf;
+    g_early_data_written += num;
+    *written = num;
+    return 1;
+}
+
+static int my_SSL_get_early_data_status(const SSL* s)
+{
+    (void)s;
+    return g_early_data_status;
+}
+#endif
+
+#ifdef SSL_OP_ENABLE_KTLS
+static uint64_t my_SSL_set_options(SSL* s, uint64_t op)
+{
+    (void)s;
+    g_ssl_options |= op;
+    return g_ssl_options;
+}
+#endif
+
+static BIO* my_BIO_new(const BIO_METHOD* type)
+{
+    (void)type;
+    return (BIO*)malloc(1);
+}
+
+static BIO_METHOD* my_BIO_meth_new(int type, const char* name)
+{
+    (void)name;
+    g_bio_meth_new_type = type;
+    return g_bio_meth_new_result;
+}
+
+static int my_BIO_meth_set_write(BIO_METHOD* biom, TEST_BIO_WRITE_CALLBACK write)
+{
+    (void)biom;
+    g_bio_meth_write = write;
+    return 1;
+}
+
+static int my_BIO_free(BIO* a)
+{
+    free(a);
+    return 1;
+}
+
+static int my_BIO_write(BIO* b, const void* data, int dlen)
+{
+    (void)b;
+    (void)data;
+    g_bio_write_count++;
+    g_bio_write_size = dlen;
+    return dlen;
+}
+
+static long my_BIO_int_ctrl(BIO* bp, int cmd, long larg, int iarg)
+{
+    (void)bp;
+    (void)larg;
+    if (cmd == BIO_C_SET_FD)
+    {
+        g_socket_bio_fd = iarg;
+    }
+    return 1;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    g_open_complete_count++;
+    g_last_open_result = open_result;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    (void)size;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    g_io_error_count++;
+}
+
+static void test_on_io_close_complete(void* context)
+{
+    (void)context;
+    g_close_complete_count++;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_send_complete_count++;
+    g_last_send_result = send_result;
+}
+
+static void reset_test_counters(void)
+{
+    g_ssl_new_count = 0;
+    g_ssl_ctx_of_ssl[0] = NULL;
+    g_ssl_ctx_of_ssl[1] = NULL;
+    g_ssl_ctx_new_count = 0;
+    g_ssl_ctx_free_count = 0;
+    g_session_free_count = 0;
+    g_last_freed_session = NULL;
+    g_condition_wait_count = 0;
+    g_condition_waited_ms = 0;
+    g_xio_wait_count = 0;
+    g_list_add_count = 0;
+    g_thread_create_count = 0;
+    g_handshake_count = 0;
+    g_bio_write_count = 0;
+    g_bio_write_size = 0;
+    g_socket_bio_fd = -1;
+    g_ssl_options = 0;
+    g_early_data_written = 0;
+    g_ssl_write_count = 0;
+    g_written_size = 0;
+    g_open_complete_count = 0;
+    g_last_open_result = IO_OPEN_ERROR;
+    g_io_error_count = 0;
+    g_send_complete_count = 0;
+    g_last_send_result = IO_SEND_ERROR;
+    g_close_complete_count = 0;
+}
+
+static CONCRETE_IO_HANDLE create_tlsio(void)
+{
+    TLSIO_CONFIG config;
+    config.hostname = TEST_HOSTNAME;
+    config.port = TEST_PORT;
+    config.underlying_io_interface = NULL;
+    config.underlying_io_parameters = NULL;
+    return g_tlsio_interface->concrete_io_create(&config);
+}
+
+static void set_bool_option(CONCRETE_IO_HANDLE tlsio, const char* option_name)
+{
+    bool value = true;
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(tlsio, option_name, &value));
+}
+
+static void set_handshake_worker_threads(CONCRETE_IO_HANDLE tlsio, size_t worker_threads)
+{
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(tlsio, OPTION_TLS_HANDSHAKE_WORKER_THREADS, &worker_threads));
+}
+
+static int open_tlsio(CONCRETE_IO_HANDLE tlsio)
+{
+    return g_tlsio_interface->concrete_io_open(tlsio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+}
+
+static void open_underlying_io(void)
+{
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+}
+
+static void receive_server_bytes(size_t size)
+{
+    unsigned char bytes[16] = { 0 };
+    g_on_bytes_received(g_on_bytes_received_context, bytes, size);
+}
+
+static void open_and_finish_handshake(CONCRETE_IO_HANDLE tlsio)
+{
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(tlsio));
+    open_underlying_io();
+    g_handshake_result = 1;
+    receive_server_bytes(5);
+    g_handshake_result = -1;
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_last_open_result);
+}
+
+static void close_tlsio(CONCRETE_IO_HANDLE tlsio)
+{
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_close(tlsio, test_on_io_close_complete, NULL));
+    g_on_io_close_complete(g_on_io_close_complete_context);
+}
+
+/* g_tlsio does a full handshake and the server issues a session, so that the next open of g_tlsio resumes it */
+static SSL_SESSION* establish_resumable_session(bool early_data)
+{
+    SSL_SESSION* result = (SSL_SESSION*)malloc(1);
+
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SESSION_RESUMPTION);
+    if (early_data)
+    {
+        set_bool_option(g_tlsio, OPTION_TLS_EARLY_DATA);
+    }
+    open_and_finish_handshake(g_tlsio);
+    ASSERT_ARE_EQUAL(int, 1, g_new_session_cb(g_last_ssl, result));
+    close_tlsio(g_tlsio);
+
+    reset_test_counters();
+    umock_c_reset_all_calls();
+    return result;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(tlsio_openssl_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, real_singlylinkedlist_find);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(Lock, my_Lock);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_wait, my_xio_wait);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_setoption, my_xio_setoption);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_CTX_new, my_SSL_CTX_new);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_CTX_free, my_SSL_CTX_free);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_CTX_sess_set_new_cb, my_SSL_CTX_sess_set_new_cb);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_new, my_SSL_new);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_free, my_SSL_free);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_set_bio, my_SSL_set_bio);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_set_ex_data, my_SSL_set_ex_data);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_get_ex_data, my_SSL_get_ex_data);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_set_connect_state, my_SSL_set_connect_state);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_set_session, my_SSL_set_session);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_SESSION_free, my_SSL_SESSION_free);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_do_handshake, my_SSL_do_handshake);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_get_error, my_SSL_get_error);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_write, my_SSL_write);
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_get_session, my_SSL_get_session);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_SESSION_get_max_early_data, my_SSL_SESSION_get_max_early_data);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_write_early_data, my_SSL_write_early_data);
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_get_early_data_status, my_SSL_get_early_data_status);
+#endif
+#ifdef SSL_OP_ENABLE_KTLS
+    REGISTER_GLOBAL_MOCK_HOOK(SSL_set_options, my_SSL_set_options);
+#endif
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_new, my_BIO_new);
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_free, my_BIO_free);
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_write, my_BIO_write);
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_int_ctrl, my_BIO_int_ctrl);
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_meth_new, my_BIO_meth_new);
+    REGISTER_GLOBAL_MOCK_HOOK(BIO_meth_set_write, my_BIO_meth_set_write);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_meth_set_read, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_meth_set_ctrl, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_meth_set_create, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_meth_set_destroy, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_OPTION_HANDLER);
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_get_interface_description, TEST_SOCKETIO_INTERFACE);
+    REGISTER_GLOBAL_MOCK_RETURN(OPENSSL_init_ssl, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(OPENSSL_init_crypto, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(TLS_method, TEST_SSL_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(TLSv1_method, TEST_SSL_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(TLSv1_1_method, TEST_SSL_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(TLSv1_2_method, TEST_SSL_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(SSL_CTX_ctrl, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(SSL_CTX_set_default_verify_paths, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(SSL_is_init_finished, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_s_mem, TEST_BIO_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_s_socket, TEST_BIO_METHOD);
+    REGISTER_GLOBAL_MOCK_RETURN(BIO_ctrl, 1);
+    REGISTER_GLOBAL_MOCK_RETURN(ERR_error_string, (char*)"test error");
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_TYPE(COND_RESULT, COND_RESULT);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SSL_verify_cb, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_CERT_VERIFY_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_NEW_SESSION_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_BIO_WRITE_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_BIO_READ_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_BIO_CTRL_CALLBACK, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TEST_BIO_CREATE_CALLBACK, void*);
+
+    g_tlsio_interface = tlsio_openssl_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    g_tlsio = NULL;
+    g_tlsio_2 = NULL;
+    g_on_io_open_complete = NULL;
+    g_on_bytes_received = NULL;
+    g_on_io_close_complete = NULL;
+    g_new_session_cb = NULL;
+    g_worker_func = NULL;
+    g_worker_arg = NULL;
+    g_last_ssl = NULL;
+    g_lock_result = LOCK_OK;
+    g_thread_create_result = THREADAPI_OK;
+    /* lets a worker run on the test thread return once the job queue is empty */
+    g_condition_wait_result = COND_ERROR;
+    g_fail_list_add_at = 0;
+    g_socket_handoff_result = 0;
+    g_bio_meth_new_result = TEST_NOSIGNAL_BIO_METHOD;
+    g_handshake_result = -1;
+    g_ssl_error = SSL_ERROR_WANT_READ;
+    g_limit_socket_capacity = false;
+    g_socket_capacity = 0;
+    g_max_early_data = 0;
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+    g_early_data_status = SSL_EARLY_DATA_ACCEPTED;
+#endif
+    reset_test_counters();
+
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_init());
+    g_is_initialized = true;
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    g_lock_result = LOCK_OK;
+
+    if (g_tlsio != NULL)
+    {
+        g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    }
+    if (g_tlsio_2 != NULL)
+    {
+        g_tlsio_interface->concrete_io_destroy(g_tlsio_2);
+    }
+    if (g_is_initialized)
+    {
+        tlsio_openssl_deinit();
+    }
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* SSL context cache */
+
+/* Tests_SRS_TLSIO_OPENSSL_11_010: [ When a connection is opened, the trusted certificates, the x509 certificate and key, the ECC certificate and key, the TLS version and the certificate validation callback and its data shall be combined into a key hashed with FNV-1a. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_011: [ If the cache holds an SSL_CTX with an equal key, the connection shall take a reference on it and no new SSL_CTX shall be created. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_012: [ Keys shall be compared field by field, the hash only saves the string compares. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_017: [ When a connection is closed or destroyed it shall release its reference. When the last reference is released, the SSL_CTX shall be kept in the cache for the next connection with an equal key. ]*/
+TEST_FUNCTION(connections_with_equal_configurations_share_one_SSL_CTX)
+{
+    // arrange
+    char certificates_1[] = "test certificates";
+    char certificates_2[] = "test certificates";
+    g_tlsio = create_tlsio();
+    g_tlsio_2 = create_tlsio();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TRUSTED_CERT, certificates_1));
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio_2, OPTION_TRUSTED_CERT, certificates_2));
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_new_count);
+    ASSERT_ARE_EQUAL(size_t, 2, g_ssl_new_count);
+    ASSERT_ARE_EQUAL(void_ptr, g_ssl_ctx_of_ssl[0], g_ssl_ctx_of_ssl[1]);
+
+    g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    g_tlsio = NULL;
+    g_tlsio_interface->concrete_io_destroy(g_tlsio_2);
+    g_tlsio_2 = NULL;
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_ctx_free_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_013: [ Otherwise a new SSL_CTX shall be created for the key and added to the cache with one reference. ]*/
+TEST_FUNCTION(connections_with_different_configurations_get_their_own_SSL_CTX)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    g_tlsio_2 = create_tlsio();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio_2, OPTION_TRUSTED_CERT, "test certificates"));
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_ssl_ctx_new_count);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, g_ssl_ctx_of_ssl[0], g_ssl_ctx_of_ssl[1]);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_017: [ When a connection is closed or destroyed it shall release its reference. When the last reference is released, the SSL_CTX shall be kept in the cache for the next connection with an equal key. ]*/
+TEST_FUNCTION(closing_the_last_connection_keeps_the_SSL_CTX_for_the_next_connection)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    open_and_finish_handshake(g_tlsio);
+
+    // act
+    close_tlsio(g_tlsio);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_close_complete_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_ctx_free_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_new_count);
+    ASSERT_ARE_EQUAL(size_t, 2, g_ssl_new_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_019: [ The cache shall keep at most 16 SSL contexts that no connection uses. When there are more, the one that has been unused the longest shall be freed. ]*/
+TEST_FUNCTION(the_SSL_CTX_unused_the_longest_is_freed_when_more_than_16_are_unused)
+{
+    // arrange
+    char certificates[32];
+    int i;
+
+    for (i = 0; i < 17; i++)
+    {
+        (void)sprintf(certificates, "test certificates %d", i);
+        g_tlsio = create_tlsio();
+        ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TRUSTED_CERT, certificates));
+        ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+        g_tlsio_interface->concrete_io_destroy(g_tlsio);
+        g_tlsio = NULL;
+    }
+    ASSERT_ARE_EQUAL(size_t, 17, g_ssl_ctx_new_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_free_count);
+
+    // act
+    g_tlsio = create_tlsio();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TRUSTED_CERT, "test certificates 1"));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    g_tlsio_2 = create_tlsio();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_setoption(g_tlsio_2, OPTION_TRUSTED_CERT, "test certificates 0"));
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 18, g_ssl_ctx_new_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_014: [ If the new SSL_CTX cannot be added to the cache, it shall be freed and tlsio_openssl_open shall fail. ]*/
+TEST_FUNCTION(when_adding_the_SSL_CTX_to_the_cache_fails_tlsio_openssl_open_fails)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio();
+    g_list_add_count = 0;
+    g_fail_list_add_at = 1;
+
+    // act
+    result = open_tlsio(g_tlsio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_new_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_free_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_new_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_015: [ If locking the cache fails, tlsio_openssl_open shall fail. ]*/
+TEST_FUNCTION(when_locking_the_cache_fails_tlsio_openssl_open_fails)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio();
+    g_lock_result = LOCK_ERROR;
+
+    // act
+    result = open_tlsio(g_tlsio);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_ctx_new_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_018: [ If locking the cache fails while releasing a reference, the reference shall be kept, so that an SSL_CTX that another connection may still use is never freed. The SSL_CTX shall then be freed by tlsio_openssl_deinit. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_003: [ tlsio_openssl_deinit shall stop the handshake workers, join them, and free the cached TLS sessions and the cached SSL contexts. ]*/
+TEST_FUNCTION(when_locking_the_cache_fails_on_release_the_SSL_CTX_is_kept_until_deinit)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    g_lock_result = LOCK_ERROR;
+
+    // act
+    g_tlsio_interface->concrete_io_destroy(g_tlsio);
+    g_tlsio = NULL;
+    g_lock_result = LOCK_OK;
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_ctx_free_count);
+    tlsio_openssl_deinit();
+    g_is_initialized = false;
+    ASSERT_ARE_EQUAL(size_t, 1, g_ssl_ctx_free_count);
+}
+
+/* TLS session cache */
+
+/* Tests_SRS_TLSIO_OPENSSL_11_020: [ When the server issues a session on a connection with OPTION_TLS_SESSION_RESUMPTION set, the session shall be cached under the hostname, the port and the SSL context key of the connection, and the cache shall take ownership of it. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_025: [ When a connection is opened, a cached session with the same hostname, port and key shall be set on the SSL object with SSL_set_session, before SSL_set_connect_state. ]*/
+TEST_FUNCTION(a_cached_session_is_restored_on_the_next_open)
+{
+    // arrange
+    SSL_SESSION* session = establish_resumable_session(false);
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, session, ((TEST_SSL*)g_last_ssl)->session_at_connect_state);
+    ASSERT_ARE_EQUAL(size_t, 0, g_session_free_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_021: [ A session issued for a hostname, port and key that already have a cached session shall replace it, and the replaced session shall be freed. ]*/
+TEST_FUNCTION(a_new_session_replaces_the_cached_one)
+{
+    // arrange
+    SSL_SESSION* session_1 = (SSL_SESSION*)malloc(1);
+    SSL_SESSION* session_2 = (SSL_SESSION*)malloc(1);
+    int result_1;
+    int result_2;
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SESSION_RESUMPTION);
+    open_and_finish_handshake(g_tlsio);
+
+    // act
+    result_1 = g_new_session_cb(g_last_ssl, session_1);
+    result_2 = g_new_session_cb(g_last_ssl, session_2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 1, result_1);
+    ASSERT_ARE_EQUAL(int, 1, result_2);
+    ASSERT_ARE_EQUAL(size_t, 1, g_session_free_count);
+    ASSERT_ARE_EQUAL(void_ptr, session_1, g_last_freed_session);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_023: [ Sessions issued on a connection without OPTION_TLS_SESSION_RESUMPTION or without a hostname shall not be cached, and their ownership shall stay with OpenSSL. ]*/
+TEST_FUNCTION(a_session_issued_without_session_resumption_is_not_cached)
+{
+    // arrange
+    SSL_SESSION* session = (SSL_SESSION*)malloc(1);
+    int result;
+    g_tlsio = create_tlsio();
+    open_and_finish_handshake(g_tlsio);
+
+    // act
+    result = g_new_session_cb(g_last_ssl, session);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_session_free_count);
+
+    // cleanup
+    free(session);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_024: [ If the session cannot be added to the cache, ownership of the session shall stay with OpenSSL. ]*/
+TEST_FUNCTION(when_adding_the_session_to_the_cache_fails_OpenSSL_keeps_the_session)
+{
+    // arrange
+    SSL_SESSION* session = (SSL_SESSION*)malloc(1);
+    int result;
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SESSION_RESUMPTION);
+    open_and_finish_handshake(g_tlsio);
+    g_list_add_count = 0;
+    g_fail_list_add_at = 1;
+
+    // act
+    result = g_new_session_cb(g_last_ssl, session);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_session_free_count);
+
+    // cleanup
+    free(session);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_026: [ When a handshake fails, the cached session of the connection shall be removed, so that the next attempt does a full handshake. ]*/
+TEST_FUNCTION(a_failed_handshake_removes_the_cached_session)
+{
+    // arrange
+    SSL_SESSION* session = establish_resumable_session(false);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    g_ssl_error = SSL_ERROR_SSL;
+
+    // act
+    receive_server_bytes(5);
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_session_free_count);
+    ASSERT_ARE_EQUAL(void_ptr, session, g_last_freed_session);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_ERROR, g_last_open_result);
+
+    g_ssl_error = SSL_ERROR_WANT_READ;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    ASSERT_IS_NULL(((TEST_SSL*)g_last_ssl)->session_at_connect_state);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_027: [ When a connection with OPTION_TLS_SESSION_RESUMPTION set is closed after a finished handshake, it shall be marked as shut down before SSL_free, so that its session stays resumable. ]*/
+TEST_FUNCTION(closing_a_resumable_connection_marks_it_as_shut_down_before_SSL_free)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SESSION_RESUMPTION);
+    open_and_finish_handshake(g_tlsio);
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_close(g_tlsio, test_on_io_close_complete, NULL));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(SSL_is_init_finished(g_last_ssl));
+    STRICT_EXPECTED_CALL(SSL_set_shutdown(g_last_ssl, SSL_SENT_SHUTDOWN | SSL_RECEIVED_SHUTDOWN));
+    STRICT_EXPECTED_CALL(SSL_free(g_last_ssl));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    g_on_io_close_complete(g_on_io_close_complete_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_close_complete_count);
+}
+
+/* Socket BIO and kernel TLS */
+
+/* Tests_SRS_TLSIO_OPENSSL_11_030: [ When OPTION_TLS_SOCKET_FAST_PATH or OPTION_TLS_KERNEL_TLS is set and the underlying IO is socketio, once the underlying IO is open the adapter shall get the socket with OPTION_SOCKET_DESCRIPTOR_HANDOFF and replace the memory BIOs with a socket BIO that does not close the socket. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_031: [ The socket BIO shall be used with partial writes and moving write buffers enabled. ]*/
+TEST_FUNCTION(with_the_socket_fast_path_the_memory_BIOs_are_replaced_by_a_socket_BIO)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SOCKET_FAST_PATH);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    umock_c_reset_all_calls();
+
+#ifdef MSG_NOSIGNAL
+    STRICT_EXPECTED_CALL(BIO_new(TEST_NOSIGNAL_BIO_METHOD));
+#else
+    STRICT_EXPECTED_CALL(BIO_s_socket());
+    STRICT_EXPECTED_CALL(BIO_new(TEST_BIO_METHOD));
+#endif
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, OPTION_SOCKET_DESCRIPTOR_HANDOFF, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BIO_int_ctrl(IGNORED_PTR_ARG, BIO_C_SET_FD, BIO_NOCLOSE, TEST_SOCKET));
+    STRICT_EXPECTED_CALL(SSL_set_bio(g_last_ssl, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(SSL_ctrl(g_last_ssl, SSL_CTRL_MODE, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER, NULL));
+    STRICT_EXPECTED_CALL(ERR_clear_error());
+    STRICT_EXPECTED_CALL(SSL_do_handshake(g_last_ssl));
+    STRICT_EXPECTED_CALL(SSL_get_error(g_last_ssl, -1));
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, TEST_SOCKET, g_socket_bio_fd);
+    ASSERT_ARE_EQUAL(void_ptr, ((TEST_SSL*)g_last_ssl)->rbio, ((TEST_SSL*)g_last_ssl)->wbio);
+}
+
+#ifdef MSG_NOSIGNAL
+/* Tests_SRS_TLSIO_OPENSSL_11_036: [ Where MSG_NOSIGNAL is available the socket BIO shall write with send and MSG_NOSIGNAL, so that writing to a socket the peer has closed fails instead of raising SIGPIPE. ]*/
+TEST_FUNCTION(tlsio_openssl_init_sets_up_a_socket_BIO_method_that_writes_with_MSG_NOSIGNAL)
+{
+    // arrange
+    tlsio_openssl_deinit();
+    g_is_initialized = false;
+    g_bio_meth_new_type = 0;
+    g_bio_meth_write = NULL;
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_init());
+    g_is_initialized = true;
+
+    // assert
+    ASSERT_ARE_EQUAL(int, BIO_TYPE_SOCKET, g_bio_meth_new_type);
+    ASSERT_IS_NOT_NULL((void*)g_bio_meth_write);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_036: [ Where MSG_NOSIGNAL is available the socket BIO shall write with send and MSG_NOSIGNAL, so that writing to a socket the peer has closed fails instead of raising SIGPIPE. ]*/
+TEST_FUNCTION(when_the_socket_BIO_method_cannot_be_created_the_socket_BIO_of_OpenSSL_is_used)
+{
+    // arrange
+    tlsio_openssl_deinit();
+    g_bio_meth_new_result = NULL;
+    ASSERT_ARE_EQUAL(int, 0, tlsio_openssl_init());
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SOCKET_FAST_PATH);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BIO_s_socket());
+    STRICT_EXPECTED_CALL(BIO_new(TEST_BIO_METHOD));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, OPTION_SOCKET_DESCRIPTOR_HANDOFF, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BIO_int_ctrl(IGNORED_PTR_ARG, BIO_C_SET_FD, BIO_NOCLOSE, TEST_SOCKET));
+    STRICT_EXPECTED_CALL(SSL_set_bio(g_last_ssl, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(SSL_ctrl(g_last_ssl, SSL_CTRL_MODE, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER, NULL));
+    STRICT_EXPECTED_CALL(ERR_clear_error());
+    STRICT_EXPECTED_CALL(SSL_do_handshake(g_last_ssl));
+    STRICT_EXPECTED_CALL(SSL_get_error(g_last_ssl, -1));
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+#endif
+
+/* Tests_SRS_TLSIO_OPENSSL_11_032: [ If the socket BIO cannot be created or the underlying IO does not hand off its socket, the adapter shall keep using the memory BIOs. ]*/
+TEST_FUNCTION(when_the_socket_is_not_handed_off_the_memory_BIOs_are_kept)
+{
+    // arrange
+    BIO* memory_rbio;
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SOCKET_FAST_PATH);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    memory_rbio = ((TEST_SSL*)g_last_ssl)->rbio;
+    g_socket_handoff_result = 1;
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, -1, g_socket_bio_fd);
+    ASSERT_ARE_EQUAL(void_ptr, memory_rbio, ((TEST_SSL*)g_last_ssl)->rbio);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, ((TEST_SSL*)g_last_ssl)->rbio, ((TEST_SSL*)g_last_ssl)->wbio);
+}
+
+#ifdef SSL_OP_ENABLE_KTLS
+/* Tests_SRS_TLSIO_OPENSSL_11_033: [ With OPTION_TLS_KERNEL_TLS set, SSL_OP_ENABLE_KTLS shall be set on the SSL object when OpenSSL supports it. ]*/
+TEST_FUNCTION(with_kernel_tls_the_socket_BIO_is_used_with_SSL_OP_ENABLE_KTLS)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_KERNEL_TLS);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, TEST_SOCKET, g_socket_bio_fd);
+    ASSERT_IS_TRUE((g_ssl_options & SSL_OP_ENABLE_KTLS) != 0);
+}
+#endif
+
+/* Tests_SRS_TLSIO_OPENSSL_11_034: [ On the socket BIO, tlsio_openssl_send shall write to OpenSSL directly. Bytes the socket does not take shall be queued, and written by tlsio_openssl_dowork before on_send_complete is called. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_035: [ On the socket BIO, tlsio_openssl_dowork shall drive the handshake and read from OpenSSL after calling xio_dowork. ]*/
+TEST_FUNCTION(on_the_socket_BIO_bytes_the_socket_does_not_take_are_written_by_dowork)
+{
+    // arrange
+    unsigned char bytes[10] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    int result;
+    g_tlsio = create_tlsio();
+    set_bool_option(g_tlsio, OPTION_TLS_SOCKET_FAST_PATH);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    g_handshake_result = 1;
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_last_open_result);
+    g_limit_socket_capacity = true;
+    g_socket_capacity = 4;
+
+    // act
+    result = g_tlsio_interface->concrete_io_send(g_tlsio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 4, g_written_size);
+    ASSERT_ARE_EQUAL(size_t, 0, g_send_complete_count);
+
+    g_socket_capacity = sizeof(bytes);
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+    ASSERT_ARE_EQUAL(size_t, sizeof(bytes), g_written_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(bytes, g_written, sizeof(bytes)));
+    ASSERT_ARE_EQUAL(size_t, 1, g_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_last_send_result);
+}
+
+/* Early data */
+
+#ifdef SSL_READ_EARLY_DATA_SUCCESS
+/* Tests_SRS_TLSIO_OPENSSL_11_040: [ When OPTION_TLS_EARLY_DATA is set on memory BIOs and the restored session allows early data, the open shall complete as soon as the underlying IO is open. ]*/
+TEST_FUNCTION(with_early_data_the_open_completes_before_the_handshake)
+{
+    // arrange
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_last_open_result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_handshake_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_041: [ Sends that fit in the early data budget of the session shall be written with SSL_write_early_data, and a copy of the bytes shall be kept until the handshake is done. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_042: [ Sends that do not fit in the early data budget, and every send after them, shall be queued and written once the handshake is done, in order. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_043: [ When the server answers, the handshake shall be finished. If the server did not accept the early data, the copied bytes shall be written again with SSL_write before the queued sends. ]*/
+TEST_FUNCTION(rejected_early_data_is_sent_again_before_the_queued_sends)
+{
+    // arrange
+    unsigned char bytes[TEST_MAX_EARLY_DATA + 5];
+    size_t i;
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        bytes[i] = (unsigned char)i;
+    }
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_send(g_tlsio, bytes, 10, test_on_send_complete, NULL));
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_send(g_tlsio, bytes + 10, 95, test_on_send_complete, NULL));
+    g_early_data_status = SSL_EARLY_DATA_REJECTED;
+    g_handshake_result = 1;
+
+    // act
+    receive_server_bytes(5);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 10, g_early_data_written);
+    ASSERT_ARE_EQUAL(size_t, 2, g_ssl_write_count);
+    ASSERT_ARE_EQUAL(int, 10, g_ssl_write_sizes[0]);
+    ASSERT_ARE_EQUAL(int, 95, g_ssl_write_sizes[1]);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(bytes, g_written, 105));
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_043: [ When the server answers, the handshake shall be finished. If the server did not accept the early data, the copied bytes shall be written again with SSL_write before the queued sends. ]*/
+TEST_FUNCTION(accepted_early_data_is_not_sent_again)
+{
+    // arrange
+    unsigned char bytes[10] = { 0 };
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_send(g_tlsio, bytes, sizeof(bytes), test_on_send_complete, NULL));
+    g_handshake_result = 1;
+
+    // act
+    receive_server_bytes(5);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(bytes), g_early_data_written);
+    ASSERT_ARE_EQUAL(size_t, 0, g_ssl_write_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_044: [ If nothing was sent as early data, tlsio_openssl_dowork shall finish the handshake as an ordinary resumption. ]*/
+TEST_FUNCTION(without_early_data_sends_dowork_finishes_the_handshake)
+{
+    // arrange
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+
+    // act
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_handshake_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_io_error_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_046: [ While the open is complete but nothing has been sent as early data, tlsio_openssl_wait shall return 0 without waiting, since the ClientHello has not been generated yet and the next tlsio_openssl_dowork sends it. ]*/
+TEST_FUNCTION(tlsio_openssl_wait_before_the_first_early_data_send_does_not_wait)
+{
+    // arrange
+    int result;
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_wait_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_046: [ While the open is complete but nothing has been sent as early data, tlsio_openssl_wait shall return 0 without waiting, since the ClientHello has not been generated yet and the next tlsio_openssl_dowork sends it. ]*/
+TEST_FUNCTION(tlsio_openssl_wait_after_an_early_data_send_waits_on_the_underlying_io)
+{
+    // arrange
+    unsigned char bytes[10] = { 0 };
+    int result;
+    (void)establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_send(g_tlsio, bytes, sizeof(bytes), test_on_send_complete, NULL));
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 1000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_xio_wait_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_045: [ If finishing the handshake fails, the cached session shall be removed and the adapter shall indicate an error. ]*/
+TEST_FUNCTION(when_the_handshake_fails_after_early_data_the_session_is_removed_and_an_error_is_indicated)
+{
+    // arrange
+    unsigned char bytes[10] = { 0 };
+    SSL_SESSION* session = establish_resumable_session(true);
+    g_max_early_data = TEST_MAX_EARLY_DATA;
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_send(g_tlsio, bytes, sizeof(bytes), test_on_send_complete, NULL));
+    g_ssl_error = SSL_ERROR_SSL;
+
+    // act
+    receive_server_bytes(5);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_io_error_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_session_free_count);
+    ASSERT_ARE_EQUAL(void_ptr, session, g_last_freed_session);
+}
+#endif
+
+/* Handshake worker pool */
+
+/* Tests_SRS_TLSIO_OPENSSL_11_050: [ When OPTION_TLS_HANDSHAKE_WORKER_THREADS is not 0, each handshake step shall be queued to a pool of worker threads, and a worker shall be woken with Condition_Post. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_051: [ Workers shall be started when first needed. The pool shall only grow, up to the largest worker count any connection asked for, and never beyond the number of online processors. ]*/
+TEST_FUNCTION(with_handshake_workers_the_handshake_step_is_queued_to_the_pool)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    g_tlsio_2 = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    set_handshake_worker_threads(g_tlsio_2, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio_2));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, g_tlsio_2));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_thread_create_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_handshake_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_052: [ If OPTION_TLS_HANDSHAKE_WORKER_THREADS is greater than 64, tlsio_openssl_setoption shall fail. ]*/
+TEST_FUNCTION(tlsio_openssl_setoption_with_more_than_64_handshake_workers_fails)
+{
+    // arrange
+    size_t worker_threads = 65;
+    int result;
+    g_tlsio = create_tlsio();
+
+    // act
+    result = g_tlsio_interface->concrete_io_setoption(g_tlsio, OPTION_TLS_HANDSHAKE_WORKER_THREADS, &worker_threads);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_053: [ If no worker can be started or the step cannot be queued, the step shall run on the calling thread. ]*/
+TEST_FUNCTION(when_no_handshake_worker_can_be_started_the_step_runs_inline)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    g_thread_create_result = THREADAPI_ERROR;
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_thread_create_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_handshake_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_053: [ If no worker can be started or the step cannot be queued, the step shall run on the calling thread. ]*/
+TEST_FUNCTION(when_queueing_the_handshake_step_fails_the_step_runs_inline)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    g_list_add_count = 0;
+    g_fail_list_add_at = 1;
+
+    // act
+    open_underlying_io();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_handshake_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_055: [ tlsio_openssl_dowork shall collect a finished step and act on its outcome on the calling thread, so that all callbacks are made from tlsio_openssl_dowork. ]*/
+/* Tests_SRS_TLSIO_OPENSSL_11_057: [ If waiting for work fails, the worker shall log an error and exit. ]*/
+TEST_FUNCTION(a_step_finished_by_a_worker_is_reported_by_dowork)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    g_handshake_result = 1;
+
+    // act
+    (void)g_worker_func(g_worker_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_handshake_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_open_complete_count);
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+    ASSERT_ARE_EQUAL(size_t, 1, g_open_complete_count);
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_OK, g_last_open_result);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_054: [ Bytes received while a worker runs a step shall be kept, and written to the input BIO when the step is collected. ]*/
+TEST_FUNCTION(bytes_received_while_a_step_is_queued_are_written_when_the_step_is_collected)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+
+    // act
+    receive_server_bytes(5);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, g_bio_write_count);
+    (void)g_worker_func(g_worker_arg);
+    g_tlsio_interface->concrete_io_dowork(g_tlsio);
+    ASSERT_ARE_EQUAL(size_t, 1, g_bio_write_count);
+    ASSERT_ARE_EQUAL(int, 5, g_bio_write_size);
+    /* the step that reads the new bytes goes back to the pool */
+    ASSERT_ARE_EQUAL(size_t, 1, g_handshake_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_059: [ While a worker runs a step of the connection, tlsio_openssl_wait shall wait for the step to finish, for at most timeout_ms, instead of waiting on the underlying IO. ]*/
+TEST_FUNCTION(tlsio_openssl_wait_while_a_step_is_queued_waits_for_the_step)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    g_condition_wait_result = COND_TIMEOUT;
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 25, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, g_condition_wait_count);
+    ASSERT_ARE_EQUAL(int, 25, g_condition_waited_ms);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_wait_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_059: [ While a worker runs a step of the connection, tlsio_openssl_wait shall wait for the step to finish, for at most timeout_ms, instead of waiting on the underlying IO. ]*/
+TEST_FUNCTION(tlsio_openssl_wait_returns_once_the_step_is_done)
+{
+    // arrange
+    int result;
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+    (void)g_worker_func(g_worker_arg);
+    g_condition_wait_count = 0;
+    g_condition_waited_ms = 0;
+
+    // act
+    result = g_tlsio_interface->concrete_io_wait(g_tlsio, 25, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_condition_wait_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_xio_wait_count);
+}
+
+/* Tests_SRS_TLSIO_OPENSSL_11_056: [ Closing or destroying a connection shall take it back from the pool: a queued step shall be removed from the queue, and a running step shall be waited for. ]*/
+TEST_FUNCTION(closing_a_connection_removes_its_queued_step)
+{
+    // arrange
+    g_tlsio = create_tlsio();
+    set_handshake_worker_threads(g_tlsio, 1);
+    ASSERT_ARE_EQUAL(int, 0, open_tlsio(g_tlsio));
+    open_underlying_io();
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, g_tlsio_interface->concrete_io_close(g_tlsio, test_on_io_close_complete, NULL));
+
+    // assert
+    ASSERT_ARE_EQUAL(IO_OPEN_RESULT, IO_OPEN_CANCELLED, g_last_open_result);
+    (void)g_worker_func(g_worker_arg);
+    ASSERT_ARE_EQUAL(size_t, 0, g_handshake_count);
+}
+
+END_TEST_SUITE(tlsio_openssl_unittests)
@@ -0,0 +1,1216 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+static TEST_MUTEX_HANDLE g_dllByDll;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/lock.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/tracingio.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    SINGLYLINKEDLIST_HANDLE real_singlylinkedlist_create(void);
+    void real_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list);
+    LIST_ITEM_HANDLE real_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item);
+    int real_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item_handle);
+    LIST_ITEM_HANDLE real_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list);
+    const void* real_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle);
+#ifdef __cplusplus
+}
+#endif
+
+TEST_DEFINE_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#define TEST_IO_HANDLE                      (XIO_HANDLE)0x4243
+#define TEST_OPTION_HANDLER                 (OPTIONHANDLER_HANDLE)0x4244
+#define TEST_LOCK_HANDLE                    (LOCK_HANDLE)0x4245
+#define TEST_TICK_COUNTER_HANDLE            (TICK_COUNTER_HANDLE)0x4246
+#define TEST_UNDERLYING_IO_INTERFACE        (const IO_INTERFACE_DESCRIPTION*)0x4247
+#define TEST_UNDERLYING_IO_PARAMETERS       (void*)0x4248
+
+static uint64_t g_time_us;
+static uint64_t g_callback_duration_us;
+static uint64_t g_dowork_duration_us;
+
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_ERROR g_on_io_error;
+static void* g_on_io_error_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+static ON_SEND_COMPLETE g_on_send_complete;
+static void* g_on_send_complete_context;
+static bool g_complete_send_in_xio_send;
+static int g_xio_send_result;
+
+static size_t g_user_send_complete_count;
+static IO_SEND_RESULT g_user_send_result;
+static size_t g_user_bytes_received_count;
+
+static const IO_INTERFACE_DESCRIPTION* g_tracingio_interface;
+static TRACINGIO_STATS_HANDLE g_stats;
+static CONCRETE_IO_HANDLE g_tracingio;
+
+static uint64_t test_get_time_us(void)
+{
+    return g_time_us;
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    g_on_io_error = on_io_error;
+    g_on_io_error_context = on_io_error_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)xio;
+    (void)buffer;
+    (void)size;
+    g_on_send_complete = on_send_complete;
+    g_on_send_complete_context = callback_context;
+    if (g_complete_send_in_xio_send)
+    {
+        on_send_complete(callback_context, IO_SEND_ERROR);
+    }
+
+    return g_xio_send_result;
+}
+
+static void my_xio_dowork(XIO_HANDLE xio)
+{
+    (void)xio;
+    g_time_us += g_dowork_duration_us;
+}
+
+static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    (void)open_result;
+    g_time_us += g_callback_duration_us;
+}
+
+static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)context;
+    (void)buffer;
+    (void)size;
+    g_user_bytes_received_count++;
+    g_time_us += g_callback_duration_us;
+}
+
+static void test_on_io_error(void* context)
+{
+    (void)context;
+    g_time_us += g_callback_duration_us;
+}
+
+static void test_on_io_close_complete(void* context)
+{
+    (void)context;
+    g_time_us += g_callback_duration_us;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    g_user_send_complete_count++;
+    g_user_send_result = send_result;
+    g_time_us += g_callback_duration_us;
+}
+
+static CONCRETE_IO_HANDLE create_tracingio(TRACINGIO_STATS_HANDLE stats)
+{
+    TRACINGIO_CONFIG config;
+    config.underlying_io_interface = TEST_UNDERLYING_IO_INTERFACE;
+    config.underlying_io_parameters = TEST_UNDERLYING_IO_PARAMETERS;
+    config.stats = stats;
+    return g_tracingio_interface->concrete_io_create(&config);
+}
+
+static void create_test_tracingio(bool open)
+{
+    g_stats = tracingio_stats_create(test_get_time_us);
+    g_tracingio = create_tracingio(g_stats);
+    if (open)
+    {
+        (void)g_tracingio_interface->concrete_io_open(g_tracingio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+    }
+    umock_c_reset_all_calls();
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    char temp_str[256];
+    (void)snprintf(temp_str, sizeof(temp_str), "umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+    ASSERT_FAIL(temp_str);
+}
+
+BEGIN_TEST_SUITE(tracingio_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    TEST_INITIALIZE_MEMORY_DEBUG(g_dllByDll);
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_create, real_singlylinkedlist_create);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, real_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, real_singlylinkedlist_add);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, real_singlylinkedlist_remove);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, real_singlylinkedlist_get_head_item);
+    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, real_singlylinkedlist_item_get_value);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_dowork, my_xio_dowork);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_OPTION_HANDLER);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+
+    g_tracingio_interface = tracingio_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+    TEST_DEINITIALIZE_MEMORY_DEBUG(g_dllByDll);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+
+    g_time_us = 1000000;
+    g_callback_duration_us = 0;
+    g_dowork_duration_us = 0;
+    g_on_io_open_complete = NULL;
+    g_on_bytes_received = NULL;
+    g_on_io_error = NULL;
+    g_on_io_close_complete = NULL;
+    g_on_send_complete = NULL;
+    g_complete_send_in_xio_send = false;
+    g_xio_send_result = 0;
+    g_user_send_complete_count = 0;
+    g_user_send_result = IO_SEND_ERROR;
+    g_user_bytes_received_count = 0;
+    g_stats = NULL;
+    g_tracingio = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    umock_c_negative_tests_deinit();
+
+    if (g_tracingio != NULL)
+    {
+        g_tracingio_interface->concrete_io_destroy(g_tracingio);
+    }
+    tracingio_stats_destroy(g_stats);
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* tracingio_stats_create */
+
+/* Tests_SRS_TRACINGIO_11_001: [ `tracingio_stats_create` shall allocate a new g_stats instance with all counters and histograms set to 0. ]*/
+/* Tests_SRS_TRACINGIO_11_003: [ `tracingio_stats_create` shall create a lock by calling `Lock_Init`, so that snapshots can be taken from any thread. ]*/
+TEST_FUNCTION(tracingio_stats_create_succeeds)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    g_stats = tracingio_stats_create(test_get_time_us);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_stats);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.bytes_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.send_size.count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.dowork_duration_us.count);
+}
+
+/* Tests_SRS_TRACINGIO_11_004: [ If `get_time_us` is NULL, `tracingio_stats_create` shall create a tick counter and time all samples with millisecond resolution. ]*/
+TEST_FUNCTION(tracingio_stats_create_without_a_time_function_creates_a_tick_counter)
+{
+    // arrange
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    // act
+    g_stats = tracingio_stats_create(NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_stats);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_002: [ If any error occurs, `tracingio_stats_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_tracingio_stats_create_fails_then_tracingio_stats_create_fails)
+{
+    // arrange
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        TRACINGIO_STATS_HANDLE stats;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        stats = tracingio_stats_create(NULL);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(stats, temp_str);
+    }
+}
+
+/* tracingio_stats_destroy */
+
+/* Tests_SRS_TRACINGIO_11_005: [ `tracingio_stats_destroy` shall free the lock, the tick counter (if any) and the stats instance. ]*/
+TEST_FUNCTION(tracingio_stats_destroy_frees_the_resources)
+{
+    // arrange
+    TRACINGIO_STATS_HANDLE stats = tracingio_stats_create(NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    tracingio_stats_destroy(stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_006: [ If `stats` is NULL, `tracingio_stats_destroy` shall do nothing. ]*/
+TEST_FUNCTION(tracingio_stats_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    tracingio_stats_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_stats_get_snapshot */
+
+/* Tests_SRS_TRACINGIO_11_010: [ `tracingio_stats_get_snapshot` shall copy all counters and histograms into `snapshot` while holding the stats lock and return 0. ]*/
+TEST_FUNCTION(tracingio_stats_get_snapshot_copies_the_stats_under_the_lock)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    int result;
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = tracingio_stats_get_snapshot(g_stats, &snapshot);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_011: [ If `stats` or `snapshot` is NULL, `tracingio_stats_get_snapshot` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_stats_get_snapshot_with_NULL_arguments_fails)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    int result_1;
+    int result_2;
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = tracingio_stats_get_snapshot(NULL, &snapshot);
+    result_2 = tracingio_stats_get_snapshot(g_stats, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_1);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_012: [ If `Lock` fails, `tracingio_stats_get_snapshot` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_tracingio_stats_get_snapshot_fails)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    int result;
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = tracingio_stats_get_snapshot(g_stats, &snapshot);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_stats_reset */
+
+/* Tests_SRS_TRACINGIO_11_015: [ `tracingio_stats_reset` shall set all counters and histograms to 0 while holding the stats lock and return 0. ]*/
+TEST_FUNCTION(tracingio_stats_reset_clears_the_stats)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    int result;
+    create_test_tracingio(true);
+    (void)g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = tracingio_stats_reset(g_stats);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.send_size.count);
+}
+
+/* Tests_SRS_TRACINGIO_11_016: [ If `stats` is NULL, `tracingio_stats_reset` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_stats_reset_with_NULL_stats_fails)
+{
+    // arrange
+
+    // act
+    int result = tracingio_stats_reset(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_017: [ If `Lock` fails, `tracingio_stats_reset` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_tracingio_stats_reset_fails)
+{
+    // arrange
+    int result;
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = tracingio_stats_reset(g_stats);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_histogram_get_percentile */
+
+/* Tests_SRS_TRACINGIO_11_021: [ If `histogram` is NULL or empty, `tracingio_histogram_get_percentile` shall return 0. ]*/
+TEST_FUNCTION(tracingio_histogram_get_percentile_of_an_empty_histogram_returns_0)
+{
+    // arrange
+    TRACINGIO_HISTOGRAM histogram;
+    (void)memset(&histogram, 0, sizeof(histogram));
+
+    // act
+    uint64_t result_1 = tracingio_histogram_get_percentile(&histogram, 50.0);
+    uint64_t result_2 = tracingio_histogram_get_percentile(NULL, 50.0);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, result_1);
+    ASSERT_ARE_EQUAL(uint64_t, 0, result_2);
+}
+
+/* Tests_SRS_TRACINGIO_11_020: [ `tracingio_histogram_get_percentile` shall return the upper bound of the bucket that contains the sample of rank `percentile`, capped to the largest recorded value. ]*/
+TEST_FUNCTION(tracingio_histogram_get_percentile_returns_exact_values_for_small_samples)
+{
+    // arrange
+    TRACINGIO_HISTOGRAM histogram;
+    (void)memset(&histogram, 0, sizeof(histogram));
+    histogram.count = 4;
+    histogram.min = 1;
+    histogram.max = 4;
+    histogram.buckets[1] = 1;
+    histogram.buckets[2] = 1;
+    histogram.buckets[3] = 1;
+    histogram.buckets[4] = 1;
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 2, tracingio_histogram_get_percentile(&histogram, 50.0));
+    ASSERT_ARE_EQUAL(uint64_t, 4, tracingio_histogram_get_percentile(&histogram, 100.0));
+}
+
+/* Tests_SRS_TRACINGIO_11_022: [ `percentile` shall be clamped to the range [0, 100]. ]*/
+TEST_FUNCTION(tracingio_histogram_get_percentile_clamps_the_percentile)
+{
+    // arrange
+    TRACINGIO_HISTOGRAM histogram;
+    (void)memset(&histogram, 0, sizeof(histogram));
+    histogram.count = 2;
+    histogram.min = 1;
+    histogram.max = 4;
+    histogram.buckets[1] = 1;
+    histogram.buckets[4] = 1;
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, tracingio_histogram_get_percentile(&histogram, -5.0));
+    ASSERT_ARE_EQUAL(uint64_t, 4, tracingio_histogram_get_percentile(&histogram, 250.0));
+}
+
+/* Tests_SRS_TRACINGIO_11_020: [ `tracingio_histogram_get_percentile` shall return the upper bound of the bucket that contains the sample of rank `percentile`, capped to the largest recorded value. ]*/
+TEST_FUNCTION(tracingio_histogram_get_percentile_returns_the_bucket_upper_bound_for_large_values)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    create_test_tracingio(true);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)"x", 1000);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)"x", 1010);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)"x", 5000);
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+
+    // act
+    // assert
+    /* 1000 and 1010 share the [960, 1023] bucket */
+    ASSERT_ARE_EQUAL(uint64_t, 1023, tracingio_histogram_get_percentile(&snapshot.receive_size, 50.0));
+    ASSERT_ARE_EQUAL(uint64_t, 5000, tracingio_histogram_get_percentile(&snapshot.receive_size, 100.0));
+    ASSERT_ARE_EQUAL(uint64_t, 1000, snapshot.receive_size.min);
+    ASSERT_ARE_EQUAL(uint64_t, 7010, snapshot.receive_size.sum);
+}
+
+/* tracingio_create */
+
+/* Tests_SRS_TRACINGIO_11_030: [ `tracingio_create` shall create a new tracing IO that records its samples into the `stats` member of the `TRACINGIO_CONFIG*` passed as `io_create_parameters`. ]*/
+/* Tests_SRS_TRACINGIO_11_034: [ `tracingio_create` shall create the list of traced sends by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_TRACINGIO_11_035: [ `tracingio_create` shall create the underlying IO by calling `xio_create` with `underlying_io_interface` and `underlying_io_parameters`. ]*/
+TEST_FUNCTION(tracingio_create_succeeds)
+{
+    // arrange
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS));
+
+    // act
+    g_tracingio = create_tracingio(g_stats);
+
+    // assert
+    ASSERT_IS_NOT_NULL(g_tracingio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_031: [ If `io_create_parameters` is NULL, `tracingio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(tracingio_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+
+    // act
+    CONCRETE_IO_HANDLE tracingio = g_tracingio_interface->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(tracingio);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_032: [ If the `underlying_io_interface` or `stats` member is NULL, `tracingio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(tracingio_create_with_NULL_stats_or_underlying_io_interface_fails)
+{
+    // arrange
+    TRACINGIO_CONFIG config;
+    CONCRETE_IO_HANDLE result_1;
+    CONCRETE_IO_HANDLE result_2;
+    g_stats = tracingio_stats_create(test_get_time_us);
+    config.underlying_io_interface = NULL;
+    config.underlying_io_parameters = TEST_UNDERLYING_IO_PARAMETERS;
+    config.stats = g_stats;
+    umock_c_reset_all_calls();
+
+    // act
+    result_1 = create_tracingio(NULL);
+    result_2 = g_tracingio_interface->concrete_io_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result_1);
+    ASSERT_IS_NULL(result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_033: [ If any error occurs, `tracingio_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_a_call_made_by_tracingio_create_fails_then_tracingio_create_fails)
+{
+    // arrange
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    g_stats = tracingio_stats_create(test_get_time_us);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_create())
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS))
+        .SetFailReturn(NULL);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        CONCRETE_IO_HANDLE tracingio;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        tracingio = create_tracingio(g_stats);
+
+        // assert
+        ASSERT_IS_NULL_WITH_MSG(tracingio, temp_str);
+    }
+}
+
+/* tracingio_destroy */
+
+/* Tests_SRS_TRACINGIO_11_036: [ `tracingio_destroy` shall destroy the underlying IO, free the sends that were never completed by it and free the tracing IO instance. ]*/
+TEST_FUNCTION(tracingio_destroy_frees_the_uncompleted_sends)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    create_test_tracingio(true);
+    (void)g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    g_tracingio_interface->concrete_io_destroy(g_tracingio);
+    g_tracingio = NULL;
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_user_send_complete_count);
+}
+
+/* Tests_SRS_TRACINGIO_11_037: [ If `tracingio` is NULL, `tracingio_destroy` shall do nothing. ]*/
+TEST_FUNCTION(tracingio_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    g_tracingio_interface->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_open */
+
+/* Tests_SRS_TRACINGIO_11_050: [ `tracingio_open` shall open the underlying IO by calling `xio_open`, passing its own callbacks so that they can be traced. ]*/
+TEST_FUNCTION(tracingio_open_opens_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_tracingio(false);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_tracingio_interface->concrete_io_open(g_tracingio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_on_io_open_complete);
+    ASSERT_IS_NOT_NULL(g_on_bytes_received);
+    ASSERT_IS_NOT_NULL(g_on_io_error);
+}
+
+/* Tests_SRS_TRACINGIO_11_051: [ If `tracingio` is NULL, `tracingio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_open_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_tracingio_interface->concrete_io_open(NULL, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_052: [ If `xio_open` fails, `tracingio_open` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_open_fails_tracingio_open_fails)
+{
+    // arrange
+    int result;
+    create_test_tracingio(false);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = g_tracingio_interface->concrete_io_open(g_tracingio, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_040: [ Every callback received from the underlying IO shall be forwarded to the corresponding callback of the tracing IO user and the time spent in the user callback shall be recorded in `callback_duration_us`. ]*/
+TEST_FUNCTION(the_time_spent_in_user_callbacks_is_recorded)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    create_test_tracingio(true);
+    g_callback_duration_us = 7;
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_callback_duration_us = 30;
+    g_on_io_error(g_on_io_error_context);
+    (void)g_tracingio_interface->concrete_io_close(g_tracingio, test_on_io_close_complete, NULL);
+    g_callback_duration_us = 11;
+    g_on_io_close_complete(g_on_io_close_complete_context);
+
+    // assert
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 3, snapshot.callback_duration_us.count);
+    ASSERT_ARE_EQUAL(uint64_t, 7, snapshot.callback_duration_us.min);
+    ASSERT_ARE_EQUAL(uint64_t, 30, snapshot.callback_duration_us.max);
+    ASSERT_ARE_EQUAL(uint64_t, 48, snapshot.callback_duration_us.sum);
+}
+
+/* Tests_SRS_TRACINGIO_11_041: [ For every indication of received bytes, `size` shall be added to `bytes_received` and recorded in the `receive_size` histogram. ]*/
+TEST_FUNCTION(received_bytes_are_recorded_and_forwarded)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    unsigned char bytes[] = { 0x42, 0x43, 0x44 };
+    create_test_tracingio(true);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, bytes, sizeof(bytes));
+    g_on_bytes_received(g_on_bytes_received_context, bytes, 1);
+
+    // assert
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(size_t, 2, g_user_bytes_received_count);
+    ASSERT_ARE_EQUAL(uint64_t, 4, snapshot.bytes_received);
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.receive_size.count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.receive_size.buckets[1]);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.receive_size.buckets[3]);
+}
+
+/* tracingio_close */
+
+/* Tests_SRS_TRACINGIO_11_055: [ `tracingio_close` shall close the underlying IO by calling `xio_close`. ]*/
+TEST_FUNCTION(tracingio_close_closes_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_tracingio(true);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = g_tracingio_interface->concrete_io_close(g_tracingio, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_056: [ If `tracingio` is NULL, `tracingio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_close_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_tracingio_interface->concrete_io_close(NULL, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_057: [ If `xio_close` fails, `tracingio_close` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_close_fails_tracingio_close_fails)
+{
+    // arrange
+    int result;
+    create_test_tracingio(true);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = g_tracingio_interface->concrete_io_close(g_tracingio, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_send */
+
+/* Tests_SRS_TRACINGIO_11_060: [ `tracingio_send` shall send the bytes by calling `xio_send` on the underlying IO, passing its own send complete callback so that the completion latency can be traced. ]*/
+/* Tests_SRS_TRACINGIO_11_064: [ On success, `size` shall be added to `bytes_sent` and recorded in the `send_size` histogram. ]*/
+TEST_FUNCTION(tracingio_send_sends_on_the_underlying_io_and_records_the_size)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42, 0x43 };
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    int result;
+    create_test_tracingio(true);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.send_size.buckets[2]);
+}
+
+/* Tests_SRS_TRACINGIO_11_042: [ When the underlying IO completes a send, the time elapsed since the send was issued shall be recorded in `send_complete_latency_us`. ]*/
+/* Tests_SRS_TRACINGIO_11_043: [ If the send result is not `IO_SEND_OK`, `send_errors` shall be incremented. ]*/
+TEST_FUNCTION(send_complete_latency_and_errors_are_recorded)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    create_test_tracingio(true);
+
+    // act
+    (void)g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    g_time_us += 250;
+    g_on_send_complete(g_on_send_complete_context, IO_SEND_OK);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_user_send_result);
+    (void)g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    g_time_us += 4;
+    g_on_send_complete(g_on_send_complete_context, IO_SEND_ERROR);
+
+    // assert
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(size_t, 2, g_user_send_complete_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_user_send_result);
+    ASSERT_ARE_EQUAL(uint64_t, 2, snapshot.send_complete_latency_us.count);
+    ASSERT_ARE_EQUAL(uint64_t, 4, snapshot.send_complete_latency_us.min);
+    ASSERT_ARE_EQUAL(uint64_t, 250, snapshot.send_complete_latency_us.max);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.send_errors);
+}
+
+/* Tests_SRS_TRACINGIO_11_061: [ If `tracingio` is NULL, `tracingio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_send_with_NULL_handle_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+
+    // act
+    int result = g_tracingio_interface->concrete_io_send(NULL, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_062: [ If tracking the send fails, `tracingio_send` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_TRACINGIO_11_063: [ If `xio_send` fails, `tracingio_send` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_a_call_made_by_tracingio_send_fails_then_tracingio_send_fails)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    create_test_tracingio(true);
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetFailReturn(1);
+
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        int result;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        (void)sprintf(temp_str, "On failed call %zu", i);
+
+        // act
+        result = g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+        // assert
+        ASSERT_ARE_NOT_EQUAL_WITH_MSG(int, 0, result, temp_str);
+    }
+
+    // assert
+    umock_c_negative_tests_deinit();
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 0, snapshot.bytes_sent);
+}
+
+/* Tests_SRS_TRACINGIO_11_044: [ If the send completes from within the `xio_send` call that issued it, the traced send shall be freed by `tracingio_send` once `xio_send` returns. ]*/
+TEST_FUNCTION(when_xio_send_completes_the_send_and_then_fails_the_traced_send_is_freed_once)
+{
+    // arrange
+    unsigned char bytes[] = { 0x42 };
+    int result;
+    create_test_tracingio(true);
+    g_complete_send_in_xio_send = true;
+    g_xio_send_result = 1;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = g_tracingio_interface->concrete_io_send(g_tracingio, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_user_send_complete_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_dowork */
+
+/* Tests_SRS_TRACINGIO_11_065: [ `tracingio_dowork` shall call `xio_dowork` on the underlying IO and record the time it took (including the callbacks triggered by it) in `dowork_duration_us`. ]*/
+TEST_FUNCTION(tracingio_dowork_records_the_underlying_dowork_duration)
+{
+    // arrange
+    TRACINGIO_STATS_SNAPSHOT snapshot;
+    create_test_tracingio(true);
+    g_dowork_duration_us = 30;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    g_tracingio_interface->concrete_io_dowork(g_tracingio);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)tracingio_stats_get_snapshot(g_stats, &snapshot);
+    ASSERT_ARE_EQUAL(uint64_t, 1, snapshot.dowork_duration_us.count);
+    ASSERT_ARE_EQUAL(uint64_t, 30, snapshot.dowork_duration_us.max);
+}
+
+/* Tests_SRS_TRACINGIO_11_066: [ If `tracingio` is NULL, `tracingio_dowork` shall do nothing. ]*/
+TEST_FUNCTION(tracingio_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    g_tracingio_interface->concrete_io_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_setoption */
+
+/* Tests_SRS_TRACINGIO_11_070: [ `tracingio_setoption` shall pass all options to the underlying IO by calling `xio_setoption` and return its result. ]*/
+TEST_FUNCTION(tracingio_setoption_passes_the_option_to_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_tracingio(false);
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "some_option", (void*)0x42));
+
+    // act
+    result = g_tracingio_interface->concrete_io_setoption(g_tracingio, "some_option", (void*)0x42);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_071: [ If `tracingio` or `option_name` is NULL, `tracingio_setoption` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_setoption_with_NULL_option_name_fails)
+{
+    // arrange
+    int result;
+    create_test_tracingio(false);
+
+    // act
+    result = g_tracingio_interface->concrete_io_setoption(g_tracingio, NULL, (void*)0x42);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_retrieveoptions */
+
+/* Tests_SRS_TRACINGIO_11_075: [ `tracingio_retrieveoptions` shall return the result of calling `xio_retrieveoptions` on the underlying IO. ]*/
+TEST_FUNCTION(tracingio_retrieveoptions_returns_the_underlying_io_options)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    create_test_tracingio(false);
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+
+    // act
+    result = g_tracingio_interface->concrete_io_retrieveoptions(g_tracingio);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_076: [ If `tracingio` is NULL, `tracingio_retrieveoptions` shall fail and return NULL. ]*/
+TEST_FUNCTION(tracingio_retrieveoptions_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    OPTIONHANDLER_HANDLE result = g_tracingio_interface->concrete_io_retrieveoptions(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_wait */
+
+/* Tests_SRS_TRACINGIO_11_080: [ `tracingio_wait` shall call `xio_wait` on the underlying IO and return its result. ]*/
+TEST_FUNCTION(tracingio_wait_waits_on_the_underlying_io)
+{
+    // arrange
+    int result;
+    create_test_tracingio(true);
+
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ));
+
+    // act
+    result = g_tracingio_interface->concrete_io_wait(g_tracingio, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TRACINGIO_11_081: [ If `tracingio` is NULL, `tracingio_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(tracingio_wait_with_NULL_handle_fails)
+{
+    // arrange
+
+    // act
+    int result = g_tracingio_interface->concrete_io_wait(NULL, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* tracingio_get_interface_description */
+
+/* Tests_SRS_TRACINGIO_11_090: [ `tracingio_get_interface_description` shall return a pointer to an `IO_INTERFACE_DESCRIPTION` structure that contains pointers to the functions: `tracingio_retrieveoptions`, `tracingio_create`, `tracingio_destroy`, `tracingio_open`, `tracingio_close`, `tracingio_send`, `tracingio_dowork`, `tracingio_setoption` and `tracingio_wait`. ]*/
+TEST_FUNCTION(tracingio_get_interface_description_returns_the_interface_functions)
+{
+    // arrange
+
+    // act
+    const IO_INTERFACE_DESCRIPTION* result = tracingio_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_NOT_NULL(result->concrete_io_retrieveoptions);
+    ASSERT_IS_NOT_NULL(result->concrete_io_create);
+    ASSERT_IS_NOT_NULL(result->concrete_io_destroy);
+    ASSERT_IS_NOT_NULL(result->concrete_io_open);
+    ASSERT_IS_NOT_NULL(result->concrete_io_close);
+    ASSERT_IS_NOT_NULL(result->concrete_io_send);
+    ASSERT_IS_NOT_NULL(result->concrete_io_dowork);
+    ASSERT_IS_NOT_NULL(result->concrete_io_setoption);
+    ASSERT_IS_NOT_NULL(result->concrete_io_wait);
+}
+
+END_TEST_SUITE(tracingio_unittests)
@@ -5,11 +5,13 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -58,6 +60,9 @@ Tests_SRS_UWS_CLIENT_01_211: [ One implication of this is that in absence of ext
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/uws_deflate.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/base64.h"
 
@@ -69,6 +74,8 @@ TEST_DEFINE_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
+TEST_DEFINE_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
 
 static const void** list_items = NULL;
 static size_t list_item_count = 0;
@@ -156,13 +163,18 @@ static int singlylinkedlist_remove_result;
 static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
 {
     size_t index = (size_t)item - 1;
+    size_t i;
     (void)list;
-    (void)memmove((void*)&list_items[index], &list_items[index + 1], sizeof(const void*) * (list_item_count - index - 1));
-    list_item_count--;
-    if (list_item_count == 0)
+    /* the slot is only cleared, so that the handles of the other items stay valid */
+    list_items[index] = NULL;
+    for (i = 0; (i < list_item_count) && (list_items[i] == NULL); i++)
+    {
+    }
+    if (i == list_item_count)
     {
         free((void*)list_items);
         list_items = NULL;
+        list_item_count = 0;
     }
     return singlylinkedlist_remove_result;
 }
@@ -170,14 +182,15 @@ static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HA
 static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
 {
     LIST_ITEM_HANDLE list_item_handle = NULL;
+    size_t i;
     (void)list;
-    if (list_item_count > 0)
-    {
-        list_item_handle = (LIST_ITEM_HANDLE)1;
-    }
-    else
+    for (i = 0; i < list_item_count; i++)
     {
-        list_item_handle = NULL;
+        if (list_items[i] != NULL)
+        {
+            list_item_handle = (LIST_ITEM_HANDLE)(i + 1);
+            break;
+        }
     }
     return list_item_handle;
 }
@@ -200,7 +213,8 @@ static LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle,
     (void)handle;
     for (i = 0; i < list_item_count; i++)
     {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
+        if ((list_items[i] != NULL) &&
+            match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
         {
             found_item = list_items[i];
             break;
@@ -330,6 +344,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_open_complete, void*, context, WS_OPE
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_frame_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_frame_fragment_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size, bool, is_final)
+MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_peer_closed, void*, context, uint16_t*, close_code, const unsigned char*, extra_data, size_t, extra_data_length)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_error, void*, context, WS_ERROR, error_code);
@@ -339,11 +355,24 @@ MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_send_frame_complete, void*, context, WS_SEND_FRAME_RESULT, ws_send_frame_result)
 MOCK_FUNCTION_END()
 
+/* not a mock, as name and value are not zero terminated */
+static char upgrade_response_headers[256];
+static void* upgrade_response_header_context;
+static void test_on_ws_upgrade_response_header(void* context, const char* name, size_t name_length, const char* value, size_t value_length)
+{
+    upgrade_response_header_context = context;
+    (void)sprintf(upgrade_response_headers + strlen(upgrade_response_headers), "[%.*s=%.*s]", (int)name_length, name, (int)value_length, value);
+}
+
 static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
 static void* g_on_io_open_complete_context;
 static ON_SEND_COMPLETE g_on_io_send_complete;
 static void* g_on_io_send_complete_context;
 static int g_xio_send_result;
+static bool g_xio_send_completes_synchronously;
+/* the last send that asked for a completion, later sends without a callback do not overwrite it */
+static ON_SEND_COMPLETE g_pending_on_io_send_complete;
+static void* g_pending_on_io_send_complete_context;
 static ON_BYTES_RECEIVED g_on_bytes_received;
 static void* g_on_bytes_received_context;
 static ON_IO_ERROR g_on_io_error;
@@ -378,9 +407,64 @@ static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_
     (void)size;
     g_on_io_send_complete = on_send_complete;
     g_on_io_send_complete_context = callback_context;
+    if (on_send_complete != NULL)
+    {
+        g_pending_on_io_send_complete = on_send_complete;
+        g_pending_on_io_send_complete_context = callback_context;
+    }
+    if (g_xio_send_completes_synchronously && (on_send_complete != NULL))
+    {
+        on_send_complete(callback_context, (g_xio_send_result == 0) ? IO_SEND_OK : IO_SEND_ERROR);
+    }
     return g_xio_send_result;
 }
 
+static const UWS_DEFLATE_HANDLE TEST_DEFLATE_HANDLE = (UWS_DEFLATE_HANDLE)0x4448;
+static const unsigned char test_deflate_output[] = { 'x', 'y', 'z' };
+
+static int my_uws_deflate_compress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, const unsigned char** compressed_payload, size_t* compressed_size)
+{
+    (void)uws_deflate;
+    (void)payload;
+    (void)size;
+    *compressed_payload = test_deflate_output;
+    *compressed_size = sizeof(test_deflate_output);
+    return 0;
+}
+
+static int my_uws_deflate_decompress(UWS_DEFLATE_HANDLE uws_deflate, const unsigned char* payload, size_t size, bool is_final, size_t max_size, const unsigned char** decompressed_payload, size_t* decompressed_size)
+{
+    (void)uws_deflate;
+    (void)payload;
+    (void)size;
+    (void)is_final;
+    (void)max_size;
+    *decompressed_payload = test_deflate_output;
+    *decompressed_size = sizeof(test_deflate_output);
+    return 0;
+}
+
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4449;
+static tickcounter_ms_t g_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
+/* each call advances the thread processor time, so that a measured call into the compressor takes TEST_THREAD_CPU_TIME_STEP_US */
+#define TEST_THREAD_CPU_TIME_STEP_US 250
+static uint64_t g_thread_cpu_time_us;
+
+static THREADAPI_RESULT my_ThreadAPI_GetCurrentThreadCpuTime(uint64_t* cpu_time_us)
+{
+    *cpu_time_us = g_thread_cpu_time_us;
+    g_thread_cpu_time_us += TEST_THREAD_CPU_TIME_STEP_US;
+    return THREADAPI_OK;
+}
+
 static pfCloneOption g_clone_option;
 static pfDestroyOption g_destroy_option;
 static pfSetOption g_set_option;
@@ -424,6 +508,30 @@ extern "C" {
 }
 #endif
 
+/* header of a masked 65636 byte binary frame */
+static const unsigned char test_large_frame_header[] = { 0x82, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x64, 0x12, 0x34, 0x56, 0x78 };
+#define TEST_LARGE_FRAME_PAYLOAD_SIZE   65636
+#define TEST_SEND_SCRATCH_BUFFER_SIZE   65536
+#define TEST_COALESCE_BUFFER_SIZE       16384
+static unsigned char test_large_frame_payload[TEST_LARGE_FRAME_PAYLOAD_SIZE];
+
+/* base64 of the SHA-1 of "test_str" (the nonce returned by the STRING_c_str mock) followed by "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" */
+#define TEST_SEC_WEBSOCKET_ACCEPT       "V/oWHVlb+T6SFoppqc4QPSxQbH0="
+#define TEST_SEC_WEBSOCKET_ACCEPT_HEADER "Sec-WebSocket-Accept: " TEST_SEC_WEBSOCKET_ACCEPT "\r\n"
+
+static int my_uws_frame_encoder_encode_header(unsigned char* header, size_t header_size, WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved, size_t* header_length)
+{
+    (void)header_size;
+    (void)opcode;
+    (void)length;
+    (void)is_masked;
+    (void)is_final;
+    (void)reserved;
+    (void)memcpy(header, test_large_frame_header, sizeof(test_large_frame_header));
+    *header_length = sizeof(test_large_frame_header);
+    return 0;
+}
+
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
@@ -433,6 +541,41 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
     ASSERT_FAIL(temp_str);
 }
 
+/* creates an OPEN uws instance with keepalive PINGs, whose ping timer was started at g_current_ms by a first uws_client_dowork */
+static UWS_CLIENT_HANDLE create_open_uws_client_with_keepalive(unsigned int ping_interval_ms, unsigned int pong_timeout_ms)
+{
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    UWS_CLIENT_HANDLE uws_client;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
+    (void)uws_client_set_option(uws_client, "ws_pong_timeout_ms", &pong_timeout_ms);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    return uws_client;
+}
+
+/* creates an OPEN uws instance with send coalescing on */
+static UWS_CLIENT_HANDLE create_open_uws_client_with_coalescing(void)
+{
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    UWS_CLIENT_HANDLE uws_client;
+    bool coalesce_sends = true;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_coalesce_sends", &coalesce_sends);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    return uws_client;
+}
+
 BEGIN_TEST_SUITE(uws_client_ut)
 
 TEST_SUITE_INITIALIZE(suite_init)
@@ -477,7 +620,14 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
     REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode, my_uws_frame_encoder_encode);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode_header, my_uws_frame_encoder_encode_header);
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, "test_str");
+    REGISTER_GLOBAL_MOCK_RETURN(uws_deflate_create, TEST_DEFLATE_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_deflate_compress, my_uws_deflate_compress);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_deflate_decompress, my_uws_deflate_decompress);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_GetCurrentThreadCpuTime, my_ThreadAPI_GetCurrentThreadCpuTime);
     REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
     REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
     REGISTER_TYPE(WS_OPEN_RESULT, WS_OPEN_RESULT);
@@ -485,6 +635,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_TYPE(WS_ERROR, WS_ERROR);
     REGISTER_TYPE(WS_SEND_FRAME_RESULT, WS_SEND_FRAME_RESULT);
     REGISTER_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
     REGISTER_TYPE(const SOCKETIO_CONFIG*, const_SOCKETIO_CONFIG_ptr);
 
     REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
@@ -492,6 +643,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
     REGISTER_UMOCK_ALIAS_TYPE(UWS_CLIENT_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
@@ -505,6 +657,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(UWS_DEFLATE_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -530,6 +684,11 @@ TEST_FUNCTION_INITIALIZE(method_init)
     whenShallrealloc_fail = 0;
     singlylinkedlist_remove_result = 0;
     g_xio_send_result = 0;
+    g_xio_send_completes_synchronously = false;
+    g_pending_on_io_send_complete = NULL;
+    g_pending_on_io_send_complete_context = NULL;
+    g_current_ms = 0;
+    g_thread_cpu_time_us = 1000;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -543,6 +702,7 @@ TEST_FUNCTION_CLEANUP(method_cleanup)
 
 /* Tests_SRS_UWS_CLIENT_01_001: [`uws_client_create` shall create an instance of uws and return a non-NULL handle to it.]*/
 /* Tests_SRS_UWS_CLIENT_01_017: [ `uws_client_create` shall create a pending send IO list that is to be used to queue send packets by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_137: [ `uws_client_create` shall let the pending sends list keep its removed nodes for reuse by calling `singlylinkedlist_set_item_cache_size`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_005: [ If `use_ssl` is false then `uws_client_create` shall obtain the interface used to create a socketio instance by calling `socketio_get_interface_description`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_008: [ The obtained interface shall be used to create the IO used as underlying IO by the newly created uws instance. ]*/
 /* Tests_SRS_UWS_CLIENT_01_009: [ The underlying IO shall be created by calling `xio_create`. ]*/
@@ -571,6 +731,7 @@ TEST_FUNCTION(uws_client_create_with_valid_args_no_ssl_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -632,6 +793,7 @@ TEST_FUNCTION(uws_client_create_with_valid_args_no_ssl_port_different_than_80_su
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "333"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -667,6 +829,7 @@ TEST_FUNCTION(uws_client_create_with_NULL_protocols_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "333"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -831,6 +994,33 @@ TEST_FUNCTION(when_creating_the_pending_sends_list_fails_then_uws_client_create_
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* Tests_SRS_UWS_CLIENT_02_138: [ If `singlylinkedlist_set_item_cache_size` fails then `uws_client_create` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_setting_the_item_cache_size_of_the_pending_sends_list_fails_then_uws_client_create_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client = uws_client_create("test_host", 80, "test_resource/1", false, protocols, sizeof(protocols) / sizeof(protocols[0]));
+
+    // assert
+    ASSERT_IS_NULL(uws_client);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* Tests_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then `uws_client_create` shall fail and return NULL. ]*/
 TEST_FUNCTION(when_getting_the_socket_interface_description_fails_then_uws_client_create_fails)
 {
@@ -848,6 +1038,7 @@ TEST_FUNCTION(when_getting_the_socket_interface_description_fails_then_uws_clien
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description())
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
@@ -880,6 +1071,7 @@ TEST_FUNCTION(when_creating_the_io_handle_fails_then_uws_client_create_fails)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters()
@@ -914,6 +1106,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_protocols_array_fails_then_uws_clie
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -950,6 +1143,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_first_proitocol_name_fails_then_uws
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -990,6 +1184,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_second_protocol_name_fails_then_uws
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -1043,6 +1238,7 @@ TEST_FUNCTION(uws_client_create_with_valid_args_ssl_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(platform_get_default_tlsio());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_TLS_IO_INTERFACE_DESCRIPTION, &tlsio_config))
@@ -1088,6 +1284,7 @@ TEST_FUNCTION(uws_client_create_with_valid_args_ssl_port_different_than_443_succ
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(platform_get_default_tlsio());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_TLS_IO_INTERFACE_DESCRIPTION, &tlsio_config))
@@ -1123,6 +1320,7 @@ TEST_FUNCTION(when_getting_the_tlsio_interface_fails_then_uws_client_create_fail
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(platform_get_default_tlsio())
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
@@ -1146,6 +1344,7 @@ TEST_FUNCTION(when_getting_the_tlsio_interface_fails_then_uws_client_create_fail
 /* Tests_SRS_UWS_CLIENT_01_521: [ The underlying IO shall be created by calling `xio_create`, while passing as arguments the `io_interface` and `io_create_parameters` argument values. ]*/
 /* Tests_SRS_UWS_CLIENT_01_523: [ The argument `resource_name` shall be copied for later use. ]*/
 /* Tests_SRS_UWS_CLIENT_01_530: [ `uws_client_create_with_io` shall create a pending send IO list that is to be used to queue send packets by calling `singlylinkedlist_create`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_139: [ `uws_client_create_with_io` shall let the pending sends list keep its removed nodes for reuse by calling `singlylinkedlist_set_item_cache_size`. ]*/
 /* Tests_SRS_UWS_CLIENT_01_527: [ The protocol information indicated by `protocols` and `protocol_count` shall be copied for later use (for constructing the upgrade request). ]*/
 TEST_FUNCTION(uws_client_create_with_io_valid_args_succeeds)
 {
@@ -1163,6 +1362,7 @@ TEST_FUNCTION(uws_client_create_with_io_valid_args_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
@@ -1242,6 +1442,7 @@ TEST_FUNCTION(uws_client_create_with_io_with_NULL_resource_name_fails)
 /* Tests_SRS_UWS_CLIENT_01_522: [ If `xio_create` fails, then `uws_client_create_with_io` shall fail and return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_529: [ If allocating memory for the copy of the `resource_name` argument fails, then `uws_client_create_with_io` shall return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_531: [ If `singlylinkedlist_create` fails then `uws_client_create_with_io` shall fail and return NULL. ]*/
+/* Tests_SRS_UWS_CLIENT_02_140: [ If `singlylinkedlist_set_item_cache_size` fails then `uws_client_create_with_io` shall fail and return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_528: [ If allocating memory for the copied protocol information fails then `uws_client_create_with_io` shall fail and return NULL. ]*/
 TEST_FUNCTION(when_any_call_fails_uws_client_create_with_io_fails)
 {
@@ -1268,6 +1469,8 @@ TEST_FUNCTION(when_any_call_fails_uws_client_create_with_io_fails)
         .SetFailReturn(1);
     STRICT_EXPECTED_CALL(singlylinkedlist_create())
         .SetFailReturn(NULL);
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG))
+        .SetFailReturn(1);
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters()
         .SetFailReturn(NULL);
@@ -1316,6 +1519,7 @@ TEST_FUNCTION(uws_client_create_with_io_with_NULL_protocols_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(singlylinkedlist_create());
+    STRICT_EXPECTED_CALL(singlylinkedlist_set_item_cache_size(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
 
@@ -1424,6 +1628,83 @@ TEST_FUNCTION(uws_client_destroy_fress_the_resources)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/* Tests_SRS_UWS_CLIENT_02_141: [ `uws_client_destroy` shall free the pending send records kept for reuse. ]*/
+TEST_FUNCTION(uws_client_destroy_frees_the_pooled_pending_sends)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    void* pending_send;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .CaptureReturn(&pending_send);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    (void)uws_client_close_async(uws_client, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_ptr(&pending_send);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_161: [ `uws_client_destroy` shall free the pending sends removed by a close that the underlying IO did not complete. ]*/
+TEST_FUNCTION(uws_client_destroy_frees_the_pending_sends_the_underlying_io_did_not_complete)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    void* pending_send;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .CaptureReturn(&pending_send);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    (void)uws_client_close_async(uws_client, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_ptr(&pending_send);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* Tests_SRS_UWS_CLIENT_01_437: [ `uws_client_destroy` shall free the protocols array allocated in `uws_client_create`. ]*/
 TEST_FUNCTION(uws_client_destroy_with_2_protocols_fress_both_protocols)
 {
@@ -1501,7 +1782,7 @@ TEST_FUNCTION(uws_client_destroy_also_performs_a_close)
 {
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -1909,7 +2190,7 @@ TEST_FUNCTION(uws_client_open_async_while_waiting_for_CLOSE_frame_fails)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -1946,7 +2227,7 @@ TEST_FUNCTION(uws_client_close_async_closes_the_underlying_IO)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -1994,7 +2275,7 @@ TEST_FUNCTION(uws_client_close_async_with_NULL_close_complete_callback_is_allowe
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2028,7 +2309,7 @@ TEST_FUNCTION(uws_client_close_async_with_NULL_close_context_succeeds)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2062,7 +2343,7 @@ TEST_FUNCTION(when_the_underlying_xio_close_fails_then_uws_client_close_async_fa
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2148,7 +2429,7 @@ TEST_FUNCTION(uws_client_close_async_while_WAITING_for_close_frame_fails)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2209,7 +2490,7 @@ TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_fr
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     LIST_ITEM_HANDLE list_item;
 
     tlsio_config.hostname = "test_host";
@@ -2231,7 +2512,6 @@ TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_fr
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .ValidateArgumentValue_item_handle(&list_item);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
@@ -2255,7 +2535,7 @@ TEST_FUNCTION(uws_client_close_async_with_2_pending_send_frames_indicates_the_fr
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     const unsigned char test_frame_1[] = { 0x42 };
     const unsigned char test_frame_2[] = { 0x43, 0x44 };
     LIST_ITEM_HANDLE list_item_1;
@@ -2281,14 +2561,12 @@ TEST_FUNCTION(uws_client_close_async_with_2_pending_send_frames_indicates_the_fr
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .ValidateArgumentValue_item_handle(&list_item_1);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE))
         .CaptureReturn(&list_item_2);
     EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .ValidateArgumentValue_item_handle(&list_item_2);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_CANCELLED));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
@@ -2314,7 +2592,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_sends_the_close_frame)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame_payload[] = { 0x03, 0xEA };
     unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
@@ -2376,7 +2654,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_close_complete_callback
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame_payload[] = { 0x03, 0xEA };
     unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
@@ -2422,7 +2700,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_context_is_allowed)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame_payload[] = { 0x03, 0xEA };
     unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
@@ -2469,7 +2747,7 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_close_handshake_async_fails)
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame_payload[] = { 0x03, 0xEA };
     unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
@@ -2541,7 +2819,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_when_already_SENDING_CLOSE_frame_
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
 
     tlsio_config.hostname = "test_host";
@@ -2572,7 +2850,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_when_already_CLOSING_underlying_I
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
 
     tlsio_config.hostname = "test_host";
@@ -2604,7 +2882,7 @@ TEST_FUNCTION(uws_client_close_handshake_async_while_WAITING_for_close_frame_fai
     TLSIO_CONFIG tlsio_config;
     int result;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3154,7 +3432,7 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_full_reply_after_the_upgrad
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3293,7 +3571,7 @@ TEST_FUNCTION(after_a_bad_status_code_a_subsequent_open_completes)
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_bad_upgrade_response[] = "HTTP/1.1 403 \r\n\r\n";
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3423,7 +3701,7 @@ TEST_FUNCTION(open_completes_when_response_has_more_spaces_in_it)
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1  101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1  101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3453,7 +3731,7 @@ TEST_FUNCTION(open_completes_when_response_has_more_spaces_in_it_after_the_statu
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101  Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101  Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3483,7 +3761,7 @@ TEST_FUNCTION(open_completes_when_a_header_is_present_in_the_response)
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\nSomeHeader:x\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "SomeHeader:x\r\n\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3507,27 +3785,24 @@ TEST_FUNCTION(open_completes_when_a_header_is_present_in_the_response)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-TEST_FUNCTION(when_allocating_memory_for_the_received_bytes_fails_on_underlying_io_bytes_received_indicates_open_complete_with_error)
+/* Tests_SRS_UWS_CLIENT_02_130: [ If the `Sec-WebSocket-Accept` header value, ignoring leading and trailing whitespace, is not the value computed when the upgrade request was sent, or the header is present more than once, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_110: [ If the response lacks a |Sec-WebSocket-Accept| header field or the |Sec-WebSocket-Accept| contains a value other than the base64-encoded SHA-1 of the concatenation of the |Sec-WebSocket-Key| (as a string, not base64-decoded) with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" but ignoring     any leading and trailing whitespace, the client MUST _Fail the WebSocket Connection_. ]*/
+TEST_FUNCTION(when_the_Sec_WebSocket_Accept_header_does_not_match_the_key_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
@@ -3539,25 +3814,24 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_bytes_fails_on_underlying_
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
-/* Tests_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
-TEST_FUNCTION(when_only_a_byte_is_received_no_open_complete_is_indicated)
+/* Tests_SRS_UWS_CLIENT_02_130: [ If the `Sec-WebSocket-Accept` header value, ignoring leading and trailing whitespace, is not the value computed when the upgrade request was sent, or the header is present more than once, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_the_Sec_WebSocket_Accept_header_is_present_twice_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "H";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
@@ -3569,23 +3843,27 @@ TEST_FUNCTION(when_only_a_byte_is_received_no_open_complete_is_indicated)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
-TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_context_does_nothing)
+/* Tests_SRS_UWS_CLIENT_02_130: [ If the `Sec-WebSocket-Accept` header value, ignoring leading and trailing whitespace, is not the value computed when the upgrade request was sent, or the header is present more than once, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_110: [ If the response lacks a |Sec-WebSocket-Accept| header field or the |Sec-WebSocket-Accept| contains a value other than the base64-encoded SHA-1 of the concatenation of the |Sec-WebSocket-Key| (as a string, not base64-decoded) with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" but ignoring     any leading and trailing whitespace, the client MUST _Fail the WebSocket Connection_. ]*/
+/* Tests_SRS_UWS_CLIENT_01_114: [ Please note that according to [RFC2616], all header field names in both HTTP requests and HTTP responses are case-insensitive. ]*/
+TEST_FUNCTION(when_the_Sec_WebSocket_Accept_header_has_whitespace_around_the_value_the_open_completes)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "sec-websocket-accept: \t " TEST_SEC_WEBSOCKET_ACCEPT " \t\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
     // act
-    g_on_bytes_received(NULL, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3594,27 +3872,27 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_context_does_nothing)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
-TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_buffer_indicates_an_open_complete_with_error)
+/* Tests_SRS_UWS_CLIENT_02_133: [ If the upgrade response ends without a `Sec-WebSocket-Accept` header, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_110: [ If the response lacks a |Sec-WebSocket-Accept| header field or the |Sec-WebSocket-Accept| contains a value other than the base64-encoded SHA-1 of the concatenation of the |Sec-WebSocket-Key| (as a string, not base64-decoded) with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" but ignoring     any leading and trailing whitespace, the client MUST _Fail the WebSocket Connection_. ]*/
+TEST_FUNCTION(when_the_response_has_no_Sec_WebSocket_Accept_header_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade: websocket\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, NULL, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3623,27 +3901,28 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_buffer_indicates_an_open
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
-TEST_FUNCTION(on_underlying_io_bytes_received_with_zero_size_indicates_an_open_complete_with_error)
+/* Tests_SRS_UWS_CLIENT_02_131: [ If the `Sec-WebSocket-Protocol` header value is not the protocol sent in the upgrade request, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_112: [ If the response includes a |Sec-WebSocket-Protocol| header field and this header field indicates the use of a subprotocol that was not present in the client's handshake (the server has indicated a subprotocol not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+TEST_FUNCTION(when_the_Sec_WebSocket_Protocol_header_is_not_the_requested_protocol_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Protocol: other_protocol\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, 0);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3652,23 +3931,24 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_zero_size_indicates_an_open_c
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_417: [ When `on_underlying_io_bytes_received` is called while OPENING but before the `on_underlying_io_open_complete` has been called, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN`. ]*/
-TEST_FUNCTION(on_underlying_io_bytes_received_before_underlying_io_open_complete_indicates_an_open_complete_with_error)
+/* Tests_SRS_UWS_CLIENT_02_131: [ If the `Sec-WebSocket-Protocol` header value is not the protocol sent in the upgrade request, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_112: [ If the response includes a |Sec-WebSocket-Protocol| header field and this header field indicates the use of a subprotocol that was not present in the client's handshake (the server has indicated a subprotocol not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+TEST_FUNCTION(when_the_Sec_WebSocket_Protocol_header_is_the_requested_protocol_the_open_completes)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "Sec-WebSocket-Protocol: test_protocol\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
@@ -3680,30 +3960,27 @@ TEST_FUNCTION(on_underlying_io_bytes_received_before_underlying_io_open_complete
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-TEST_FUNCTION(when_allocating_memory_for_a_second_byte_fails_open_complete_is_indicated_with_error)
+/* Tests_SRS_UWS_CLIENT_02_129: [ If a header line has no name or no colon, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_a_header_line_has_no_colon_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "SomeHeader\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response + 1, 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3712,15 +3989,15 @@ TEST_FUNCTION(when_allocating_memory_for_a_second_byte_fails_open_complete_is_in
     uws_client_destroy(uws_client);
 }
 
-void when_only_n_bytes_are_received_from_the_response_no_open_complete_is_indicated(const char* test_upgrade_response, size_t n)
+/* Tests_SRS_UWS_CLIENT_02_129: [ If a header line has no name or no colon, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_a_header_line_has_no_name_the_open_fails_with_WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    char temp_str[32];
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        ": x\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
@@ -3728,40 +4005,27 @@ void when_only_n_bytes_are_received_from_the_response_no_open_complete_is_indica
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, n);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
-    (void)sprintf(temp_str, "Bytes = %u", (unsigned int)n);
-    ASSERT_ARE_EQUAL_WITH_MSG(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls(), temp_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
-TEST_FUNCTION(when_all_but_1_bytes_are_received_from_the_response_no_open_complete_is_indicated)
+/* Tests_SRS_UWS_CLIENT_02_128: [ Lines shall be terminated by LF, optionally preceded by CR. ]*/
+TEST_FUNCTION(when_lines_are_terminated_only_by_LF_the_open_completes)
 {
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r";
-    size_t i;
-
-    for (i = 1; i < sizeof(test_upgrade_response); i++)
-    {
-        when_only_n_bytes_are_received_from_the_response_no_open_complete_is_indicated(test_upgrade_response, i);
-    }
-}
-
-/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames by passing them to `uws_frame_decoder_decode`. ]*/
-TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indicated_and_the_extra_byte_is_saved_for_decoding_frames)
-{
-    // arrange
-    TLSIO_CONFIG tlsio_config;
-    UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n\0";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\n"
+        "Sec-WebSocket-Accept: " TEST_SEC_WEBSOCKET_ACCEPT "\n"
+        "\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
@@ -3772,7 +4036,7 @@ TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indica
     STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3781,81 +4045,57 @@ TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indica
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
-/* Tests_SRS_UWS_CLIENT_01_154: [ *  %x2 denotes a binary frame ]*/
-/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
-/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
-/* Tests_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
-/* Tests_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
-/* Tests_SRS_UWS_CLIENT_01_148: [ The first fragment MAY also be the final fragment. ]*/
-/* Tests_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
-/* Tests_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
-/* Tests_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
-/* Tests_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
-/* Tests_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_02_132: [ Each header that was parsed successfully shall be indicated by calling the callback set with `uws_client_set_on_ws_upgrade_response_header`, if any, with the header name and the value stripped of leading and trailing whitespace. ]*/
+TEST_FUNCTION(upgrade_response_headers_are_indicated_to_the_header_callback)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char test_frame[] = { 0x82, 0x01, 0x42 };
-    const unsigned char expected_payload[] = { 0x42 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "Upgrade:websocket\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "X-Empty:\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    upgrade_response_headers[0] = '\0';
+    (void)uws_client_set_on_ws_upgrade_response_header(uws_client, test_on_ws_upgrade_response_header, (void*)0x4246);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "[Upgrade=websocket][Sec-WebSocket-Accept=" TEST_SEC_WEBSOCKET_ACCEPT "][X-Empty=]", upgrade_response_headers);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4246, upgrade_response_header_context);
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_153: [ *  %x1 denotes a text frame ]*/
-/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
-/* Tests_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
-/* Tests_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
-/* Tests_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
-TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_02_127: [ Only the bytes accumulated since the previous call shall be searched for the end of a line, and each line of the upgrade response shall be parsed once, as soon as it is complete. ]*/
+TEST_FUNCTION(a_bad_status_is_indicated_as_soon_as_the_status_line_is_received)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char test_frame[] = { 0x81, 0x01, 'a' };
-    const unsigned char expected_payload[] = { 'a' };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 404 Not Found\r\nContent-Le";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_RESPONSE_STATUS));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3864,32 +4104,27 @@ TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
-/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
-TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_02_127: [ Only the bytes accumulated since the previous call shall be searched for the end of a line, and each line of the upgrade response shall be parsed once, as soon as it is complete. ]*/
+TEST_FUNCTION(when_the_upgrade_response_is_received_in_pieces_split_inside_lines_the_open_completes_once_the_empty_line_is_received)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char test_frame[] = { 0x82, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const size_t first_piece_length = 20;
+    const size_t second_piece_length = 40;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, first_piece_length);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response + first_piece_length, second_piece_length);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
-        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response + first_piece_length + second_piece_length, sizeof(test_upgrade_response) - 1 - first_piece_length - second_piece_length);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3898,32 +4133,30 @@ TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_t
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
-/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
-TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_02_126: [ Before sending the upgrade request, the value expected in the `Sec-WebSocket-Accept` header of the response shall be computed as the base64 encoded SHA-1 of the nonce concatenated with "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", so that the response can be validated without keeping the nonce. ]*/
+/* Tests_SRS_UWS_CLIENT_01_482: [ The value of this header field is constructed by concatenating /key/, defined above in step 4 in Section 4.2.2, with the string "258EAFA5-E914-47DA-95CA-C5AB0DC85B11" ]*/
+/* Tests_SRS_UWS_CLIENT_01_483: [ taking the SHA-1 hash of this concatenated value to obtain a 20-byte value ]*/
+/* Tests_SRS_UWS_CLIENT_01_484: [ and base64-encoding (see Section 4 of [RFC4648]) this 20-byte hash. ]*/
+TEST_FUNCTION(the_Sec_WebSocket_Accept_header_is_validated_against_the_nonce_sent_in_the_upgrade_request)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char test_frame[] = { 0x81, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        "Sec-WebSocket-Accept: uvk30FhWryCkX6I0l6UDlbmbjN8=\r\n"
+        "\r\n";
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0))
-        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3932,23 +4165,13 @@ TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
-/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
-TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_received_bytes_fails_on_underlying_io_bytes_received_indicates_open_complete_with_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[125 + 2] = { 0x82, 0x7D };
-    size_t i;
-
-    for (i = 0; i < 125; i++)
-    {
-        test_frame[2 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3956,15 +4179,16 @@ TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 125))
-        .ValidateArgumentBuffer(3, &test_frame[2], 125);
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -3973,21 +4197,14 @@ TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_378: [ When `on_underlying_io_bytes_received` is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
+/* Tests_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
+TEST_FUNCTION(when_only_a_byte_is_received_no_open_complete_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[126 + 4] = { 0x82, 0x7E, 0x00, 0x7E };
-    size_t i;
-
-    for (i = 0; i < 126; i++)
-    {
-        test_frame[4 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "H";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -3995,15 +4212,13 @@ TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 126))
-        .ValidateArgumentBuffer(3, &test_frame[4], 126);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4012,37 +4227,23 @@ TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-TEST_FUNCTION(when_a_127_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_415: [ If called with a NULL `context` argument, `on_underlying_io_bytes_received` shall do nothing. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_context_does_nothing)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[127 + 4] = { 0x82, 0x7E, 0x00, 0x7F };
-    size_t i;
-
-    for (i = 0; i < 127; i++)
-    {
-        test_frame[4 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 127))
-        .ValidateArgumentBuffer(3, &test_frame[4], 127);
-
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(NULL, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4051,25 +4252,13 @@ TEST_FUNCTION(when_a_127_bytes_binary_frame_is_received_it_shall_be_indicated_to
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-TEST_FUNCTION(when_a_65535_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_NULL_buffer_indicates_an_open_complete_with_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* test_frame = (unsigned char*)malloc(65535 + 4);
-    size_t i;
-    test_frame[0] = 0x82;
-    test_frame[1] = 0x7E;
-    test_frame[2] = 0xFF;
-    test_frame[3] = 0xFF;
-
-    for (i = 0; i < 65535; i++)
-    {
-        test_frame[4 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4077,49 +4266,28 @@ TEST_FUNCTION(when_a_65535_bytes_binary_frame_is_received_it_shall_be_indicated_
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65535))
-        .ValidateArgumentBuffer(3, &test_frame[4], 65535);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65535 + 4);
+    g_on_bytes_received(g_on_bytes_received_context, NULL, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    free(test_frame);
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-TEST_FUNCTION(when_a_65536_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_416: [ If called with NULL `buffer` or zero `size` and the state of the iws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS`. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_zero_size_indicates_an_open_complete_with_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* test_frame = (unsigned char*)malloc(65536 + 10);
-    size_t i;
-    test_frame[0] = 0x82;
-    test_frame[1] = 0x7F;
-    test_frame[2] = 0x00;
-    test_frame[3] = 0x00;
-    test_frame[4] = 0x00;
-    test_frame[5] = 0x00;
-    test_frame[6] = 0x00;
-    test_frame[7] = 0x01;
-    test_frame[8] = 0x00;
-    test_frame[9] = 0x00;
-
-    for (i = 0; i < 65536; i++)
-    {
-        test_frame[10 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4127,83 +4295,56 @@ TEST_FUNCTION(when_a_65536_bytes_binary_frame_is_received_it_shall_be_indicated_
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65536))
-        .ValidateArgumentBuffer(3, &test_frame[10], 65536);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_INVALID_BYTES_RECEIVED_ARGUMENTS));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65536 + 10);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, 0);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    free(test_frame);
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
-TEST_FUNCTION(when_a_65537_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_417: [ When `on_underlying_io_bytes_received` is called while OPENING but before the `on_underlying_io_open_complete` has been called, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN`. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_before_underlying_io_open_complete_indicates_an_open_complete_with_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* test_frame = (unsigned char*)malloc(65537 + 10);
-    size_t i;
-    test_frame[0] = 0x82;
-    test_frame[1] = 0x7F;
-    test_frame[2] = 0x00;
-    test_frame[3] = 0x00;
-    test_frame[4] = 0x00;
-    test_frame[5] = 0x00;
-    test_frame[6] = 0x00;
-    test_frame[7] = 0x01;
-    test_frame[8] = 0x00;
-    test_frame[9] = 0x01;
-
-    for (i = 0; i < 65537; i++)
-    {
-        test_frame[10 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65537))
-        .ValidateArgumentBuffer(3, &test_frame[10], 65537);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BYTES_RECEIVED_BEFORE_UNDERLYING_OPEN));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65537 + 10);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
-    free(test_frame);
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_allocating_memory_for_a_second_byte_fails_open_complete_is_indicated_with_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x7E, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4211,14 +4352,16 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response + 1, 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4227,21 +4370,12 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(when_a_125_byte_binary_frame_is_received_with_16_bit_length_an_error_is_indicated)
+void when_only_n_bytes_are_received_from_the_response_no_open_complete_is_indicated(const char* test_upgrade_response, size_t n)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[125 + 4] = { 0x82, 0x7E, 0x00, 0x7D };
-    size_t i;
-
-    for (i = 0; i < 125; i++)
-    {
-        test_frame[4 + i] = (unsigned char)i;
-    }
+    char temp_str[32];
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4249,31 +4383,40 @@ TEST_FUNCTION(when_a_125_byte_binary_frame_is_received_with_16_bit_length_an_err
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, n);
 
     // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)sprintf(temp_str, "Bytes = %u", (unsigned int)n);
+    ASSERT_ARE_EQUAL_WITH_MSG(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls(), temp_str);
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_380: [ If an WebSocket Upgrade request can be parsed from the accumulated bytes, the status shall be read from the WebSocket upgrade response. ]*/
+TEST_FUNCTION(when_all_but_1_bytes_are_received_from_the_response_no_open_complete_is_indicated)
+{
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r";
+    size_t i;
+
+    for (i = 1; i < sizeof(test_upgrade_response); i++)
+    {
+        when_only_n_bytes_are_received_from_the_response_no_open_complete_is_indicated(test_upgrade_response, i);
+    }
+}
+
+/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames by passing them to `uws_frame_decoder_decode`. ]*/
+TEST_FUNCTION(when_1_extra_byte_is_received_the_open_complete_is_properly_indicated_and_the_extra_byte_is_saved_for_decoding_frames)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n\0";
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4281,14 +4424,13 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4297,31 +4439,28 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(when_a_65535_byte_binary_frame_is_received_with_64_bit_length_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_386: [ When a WebSocket data frame is decoded succesfully it shall be indicated via the callback `on_ws_frame_received`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
+/* Tests_SRS_UWS_CLIENT_01_154: [ *  %x2 denotes a binary frame ]*/
+/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
+/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_169: [ The payload length is the length of the "Extension data" + the length of the "Application data". ]*/
+/* Tests_SRS_UWS_CLIENT_01_173: [ The "Payload data" is defined as "Extension data" concatenated with "Application data". ]*/
+/* Tests_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_148: [ The first fragment MAY also be the final fragment. ]*/
+/* Tests_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
+/* Tests_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
+/* Tests_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
+/* Tests_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* test_frame = (unsigned char*)malloc(65535 + 10);
-    size_t i;
-    test_frame[0] = 0x82;
-    test_frame[1] = 0x7F;
-    test_frame[2] = 0x00;
-    test_frame[3] = 0x00;
-    test_frame[4] = 0x00;
-    test_frame[5] = 0x00;
-    test_frame[6] = 0x00;
-    test_frame[7] = 0x00;
-    test_frame[8] = 0xFF;
-    test_frame[9] = 0xFF;
-
-    for (i = 0; i < 65535; i++)
-    {
-        test_frame[10 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x01, 0x42 };
+    const unsigned char expected_payload[] = { 0x42 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4332,29 +4471,32 @@ TEST_FUNCTION(when_a_65535_byte_binary_frame_is_received_with_64_bit_length_an_e
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65535 + 10);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
-    free(test_frame);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_received)
+/* Tests_SRS_UWS_CLIENT_01_153: [ *  %x1 denotes a text frame ]*/
+/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
+/* Tests_SRS_UWS_CLIENT_01_280: [ Upon receiving a data frame (Section 5.6), the endpoint MUST note the /type/ of the data as defined by the opcode (frame-opcode) from Section 5.2. ]*/
+/* Tests_SRS_UWS_CLIENT_01_281: [ The "Application data" from this frame is defined as the /data/ of the message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
+TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x7E, 0x00, 0x7D };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x81, 0x01, 'a' };
+    const unsigned char expected_payload[] = { 'a' };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4365,8 +4507,8 @@ TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
@@ -4378,15 +4520,16 @@ TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_recei
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_received)
+/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
+/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
+TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4397,8 +4540,8 @@ TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
@@ -4410,31 +4553,16 @@ TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_recei
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
-/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
-TEST_FUNCTION(when_the_highest_bit_is_set_in_a_64_bit_length_frame_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
+/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
+TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* test_frame = (unsigned char*)malloc(65536 + 10);
-    size_t i;
-    test_frame[0] = 0x82;
-    test_frame[1] = 0x7F;
-    test_frame[2] = 0x80;
-    test_frame[3] = 0x00;
-    test_frame[4] = 0x00;
-    test_frame[5] = 0x00;
-    test_frame[6] = 0x00;
-    test_frame[7] = 0x01;
-    test_frame[8] = 0x00;
-    test_frame[9] = 0x00;
-
-    for (i = 0; i < 65536; i++)
-    {
-        test_frame[10 + i] = (unsigned char)i;
-    }
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x81, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4445,28 +4573,36 @@ TEST_FUNCTION(when_the_highest_bit_is_set_in_a_64_bit_length_frame_an_error_is_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65536 + 10);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
-    free(test_frame);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
-TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
+/* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
+/* Tests_SRS_UWS_CLIENT_01_258: [ Currently defined opcodes for data frames include 0x1 (Text), 0x2 (Binary). ]*/
+TEST_FUNCTION(when_a_125_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[125 + 2] = { 0x82, 0x7D };
+    size_t i;
+
+    for (i = 0; i < 125; i++)
+    {
+        test_frame[2 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4477,9 +4613,9 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_NOT_ENOUGH_MEMORY));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 125))
+        .ValidateArgumentBuffer(3, &test_frame[2], 125);
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
@@ -4491,18 +4627,21 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_byte_with_a_separate_call_decoding_frame_succeeds)
+/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+TEST_FUNCTION(when_a_126_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char* upgrade_response_frame = (unsigned char*)malloc(sizeof(test_upgrade_response));
-    unsigned char test_frame[] = { 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[126 + 4] = { 0x82, 0x7E, 0x00, 0x7E };
+    size_t i;
 
-    (void)memcpy(upgrade_response_frame, test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    upgrade_response_frame[sizeof(test_upgrade_response) - 1] = 0x82;
+    for (i = 0; i < 126; i++)
+    {
+        test_frame[4 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4510,12 +4649,12 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)upgrade_response_frame, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
-        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 126))
+        .ValidateArgumentBuffer(3, &test_frame[4], 126);
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
@@ -4525,22 +4664,23 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
 
     // cleanup
     uws_client_destroy(uws_client);
-    free(upgrade_response_frame);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-TEST_FUNCTION(when_a_complete_frame_is_received_together_with_the_upgrade_request_the_frame_is_indicated_as_received)
+/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+TEST_FUNCTION(when_a_127_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    size_t received_data_length = sizeof(test_upgrade_response) + 1;
-    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[127 + 4] = { 0x82, 0x7E, 0x00, 0x7F };
+    size_t i;
 
-    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    received_data[received_data_length - 2] = 0x82;
-    received_data[received_data_length - 1] = 0x00;
+    for (i = 0; i < 127; i++)
+    {
+        test_frame[4 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4548,39 +4688,42 @@ TEST_FUNCTION(when_a_complete_frame_is_received_together_with_the_upgrade_reques
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
-        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 127))
+        .ValidateArgumentBuffer(3, &test_frame[4], 127);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
-    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-TEST_FUNCTION(when_a_1_byte_complete_frame_is_received_together_with_the_upgrade_request_the_frame_is_indicated_as_received)
+/* Tests_SRS_UWS_CLIENT_01_165: [ If 126, the following 2 bytes interpreted as a 16-bit unsigned integer are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+TEST_FUNCTION(when_a_65535_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    size_t received_data_length = sizeof(test_upgrade_response) + 2;
-    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
-    unsigned char expected_frame_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65535 + 4);
+    size_t i;
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7E;
+    test_frame[2] = 0xFF;
+    test_frame[3] = 0xFF;
 
-    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    received_data[received_data_length - 1] = 0x42;
-    received_data[received_data_length - 2] = 0x01;
-    received_data[received_data_length - 3] = 0x82;
+    for (i = 0; i < 65535; i++)
+    {
+        test_frame[4 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4588,40 +4731,49 @@ TEST_FUNCTION(when_a_1_byte_complete_frame_is_received_together_with_the_upgrade
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, expected_frame_payload, sizeof(expected_frame_payload)))
-        .ValidateArgumentBuffer(3, expected_frame_payload, sizeof(expected_frame_payload));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65535))
+        .ValidateArgumentBuffer(3, &test_frame[4], 65535);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65535 + 4);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    free(test_frame);
     uws_client_destroy(uws_client);
-    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
-TEST_FUNCTION(when_2_complete_frames_are_received_together_with_the_upgrade_request_the_frames_are_indicated_as_received)
+/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+TEST_FUNCTION(when_a_65536_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    size_t received_data_length = sizeof(test_upgrade_response) + 4;
-    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65536 + 10);
+    size_t i;
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7F;
+    test_frame[2] = 0x00;
+    test_frame[3] = 0x00;
+    test_frame[4] = 0x00;
+    test_frame[5] = 0x00;
+    test_frame[6] = 0x00;
+    test_frame[7] = 0x01;
+    test_frame[8] = 0x00;
+    test_frame[9] = 0x00;
 
-    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    received_data[received_data_length - 5] = 0x81;
-    received_data[received_data_length - 4] = 0x01;
-    received_data[received_data_length - 3] = 'a';
-    received_data[received_data_length - 2] = 0x82;
-    received_data[received_data_length - 1] = 0x00;
+    for (i = 0; i < 65536; i++)
+    {
+        test_frame[10 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4629,40 +4781,49 @@ TEST_FUNCTION(when_2_complete_frames_are_received_together_with_the_upgrade_requ
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(3, "a", 1);
-    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
-        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65536))
+        .ValidateArgumentBuffer(3, &test_frame[10], 65536);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65536 + 10);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    free(test_frame);
     uws_client_destroy(uws_client);
-    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
-/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
-/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connection_is_closed)
+/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_167: [ Multibyte length quantities are expressed in network byte order. ]*/
+TEST_FUNCTION(when_a_65537_bytes_binary_frame_is_received_it_shall_be_indicated_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x80 };
-    unsigned char close_frame_payload[] = { 0x03, 0xEA };
-    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
-    BUFFER_HANDLE buffer_handle;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65537 + 10);
+    size_t i;
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7F;
+    test_frame[2] = 0x00;
+    test_frame[3] = 0x00;
+    test_frame[4] = 0x00;
+    test_frame[5] = 0x00;
+    test_frame[6] = 0x00;
+    test_frame[7] = 0x01;
+    test_frame[8] = 0x00;
+    test_frame[9] = 0x01;
+
+    for (i = 0; i < 65537; i++)
+    {
+        test_frame[10 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4670,65 +4831,43 @@ TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connecti
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
-        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
-        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 65537))
+        .ValidateArgumentBuffer(3, &test_frame[10], 65537);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65537 + 10);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
+    free(test_frame);
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
-/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
-/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails_an_error_is_indicated_anyhow)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x80 };
-    unsigned char close_frame_payload[] = { 0x03, 0xEA };
-    BUFFER_HANDLE buffer_handle;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x7E, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
-        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
-        .SetReturn(NULL);
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4741,20 +4880,21 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
-/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
-/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_frame_fails_an_error_is_indicated_anyhow)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_a_125_byte_binary_frame_is_received_with_16_bit_length_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x80 };
-    unsigned char close_frame_payload[] = { 0x03, 0xEA };
-    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
-    BUFFER_HANDLE buffer_handle;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[125 + 4] = { 0x82, 0x7E, 0x00, 0x7D };
+    size_t i;
+
+    for (i = 0; i < 125; i++)
+    {
+        test_frame[4 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4762,24 +4902,10 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_fram
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
-        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
-        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4792,27 +4918,15 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_fram
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
-/* Tests_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
-/* Tests_SRS_UWS_CLIENT_01_235: [ The Close frame MAY contain a body (the "Application data" portion of the frame) that indicates a reason for closing, such as an endpoint shutting down, an endpoint having received a frame too large, or an endpoint having received a frame that does not conform to the format expected by the endpoint. ]*/
-/* Tests_SRS_UWS_CLIENT_01_236: [ If there is a body, the first two bytes of the body MUST be a 2-byte unsigned integer (in network byte order) representing a status code with value /code/ defined in Section 7.4. ]*/
-/* Tests_SRS_UWS_CLIENT_01_461: [ The argument `close_code` shall be set to point to the code extracted from the CLOSE frame. ]*/
-/* Tests_SRS_UWS_CLIENT_01_296: [ Upon either sending or receiving a Close control frame, it is said that _The WebSocket Closing Handshake is Started_ and that the WebSocket connection is in the CLOSING state. ]*/
-/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
-/* Tests_SRS_UWS_CLIENT_01_242: [ It SHOULD do so as soon as practical. ]*/
-/* Tests_SRS_UWS_CLIENT_01_239: [ Close frames sent from client to server must be masked as per Section 5.3. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_to_the_user)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
-    BUFFER_HANDLE buffer_handle;
-    uint16_t expected_close_code = 1002;
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4823,26 +4937,10 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
-        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4851,21 +4949,31 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
-/* Tests_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
-/* Tests_SRS_UWS_CLIENT_01_462: [ If no code can be extracted then `close_code` shall be NULL. ]*/
-/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_the_callback_is_triggered)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_a_65535_byte_binary_frame_is_received_with_64_bit_length_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x00 };
-    BUFFER_HANDLE buffer_handle;
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65535 + 10);
+    size_t i;
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7F;
+    test_frame[2] = 0x00;
+    test_frame[3] = 0x00;
+    test_frame[4] = 0x00;
+    test_frame[5] = 0x00;
+    test_frame[6] = 0x00;
+    test_frame[7] = 0x00;
+    test_frame[8] = 0xFF;
+    test_frame[9] = 0xFF;
+
+    for (i = 0; i < 65535; i++)
+    {
+        test_frame[10 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4877,46 +4985,28 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, NULL, NULL, 0));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65535 + 10);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(test_frame);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_463: [ The extra bytes (besides the close code) shall be passed to the `on_ws_peer_closed` callback by using `extra_data` and `extra_data_length`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_passed_to_the_callback)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_received)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x04, 0x03, 0xEA, 0x42, 0x43 };
-    BUFFER_HANDLE buffer_handle;
-    uint16_t expected_close_code = 1002;
-    unsigned char expected_extra_data[] = { 0x42, 0x43 };
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x7E, 0x00, 0x7D };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4927,29 +5017,10 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_pass
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 2))
-        .ValidateArgumentBuffer(1, &close_frame[4], 2);
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, IGNORED_PTR_ARG, sizeof(expected_extra_data)))
-        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code))
-        .ValidateArgumentBuffer(3, &expected_extra_data, sizeof(expected_extra_data));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4958,15 +5029,15 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_pass
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_237: [ Following the 2-byte integer, the body MAY contain UTF-8-encoded data with value /reason/, the interpretation of which is not defined by this specification. ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_connection_is_closed)
+/* Tests_SRS_UWS_CLIENT_01_168: [ Note that in all cases, the minimal number of bytes MUST be used to encode the length, for example, the length of a 124-byte-long string can't be encoded as the sequence 126, 0, 124. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_received)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x03, 0x03, 0xEA, 0xDF };
-    uint16_t expected_close_code = 1002;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4977,18 +5048,10 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_conn
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 1))
-        .ValidateArgumentBuffer(1, &close_frame[4], 1)
-        .SetReturn(false);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_io_close_complete();
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0))
-        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -4997,17 +5060,31 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_conn
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
-/* Tests_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outgoing_CLOSE_fails_the_connection_is_closed)
+/* Tests_SRS_UWS_CLIENT_01_166: [ If 127, the following 8 bytes interpreted as a 64-bit unsigned integer (the most significant bit MUST be 0) are the payload length. ]*/
+/* Tests_SRS_UWS_CLIENT_01_419: [ If there is an error decoding the WebSocket frame, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED`. ]*/
+TEST_FUNCTION(when_the_highest_bit_is_set_in_a_64_bit_length_frame_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
-    uint16_t expected_close_code = 1002;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_frame = (unsigned char*)malloc(65536 + 10);
+    size_t i;
+    test_frame[0] = 0x82;
+    test_frame[1] = 0x7F;
+    test_frame[2] = 0x80;
+    test_frame[3] = 0x00;
+    test_frame[4] = 0x00;
+    test_frame[5] = 0x00;
+    test_frame[6] = 0x00;
+    test_frame[7] = 0x01;
+    test_frame[8] = 0x00;
+    test_frame[9] = 0x00;
+
+    for (i = 0; i < 65536; i++)
+    {
+        test_frame[10 + i] = (unsigned char)i;
+    }
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5019,37 +5096,27 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outg
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_io_close_complete();
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
-        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, 65536 + 10);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(test_frame);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
-/* Tests_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgoing_CLOSE_fails_the_connection_is_closed)
+/* Tests_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error_is_indicated)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
-    BUFFER_HANDLE buffer_handle;
-    uint16_t expected_close_code = 1002;
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[125 + 2] = { 0x82, 0x7D };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5060,30 +5127,12 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgo
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete()
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_io_close_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
-        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_NOT_ENOUGH_MEMORY));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5092,16 +5141,18 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgo
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ] */
-TEST_FUNCTION(sending_after_a_close_is_received_does_not_send_anything)
+/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_byte_with_a_separate_call_decoding_frame_succeeds)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
-    int result;
-    unsigned char test_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* upgrade_response_frame = (unsigned char*)malloc(sizeof(test_upgrade_response));
+    unsigned char test_frame[] = { 0x00 };
+
+    (void)memcpy(upgrade_response_frame, test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    upgrade_response_frame[sizeof(test_upgrade_response) - 1] = 0x82;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5109,46 +5160,36 @@ TEST_FUNCTION(sending_after_a_close_is_received_does_not_send_anything)
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)upgrade_response_frame, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(upgrade_response_frame);
 }
 
-/* uws_client_send_frame_async */
-
-/* Tests_SRS_UWS_CLIENT_01_044: [ If any the arguments `uws_client` is NULL, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(uws_client_send_frame_async_with_NULL_handle_fails)
-{
-    // arrange
-    unsigned char test_payload[] = { 0x42 };
-    int result;
-
-    // act
-    result = uws_client_send_frame_async(NULL, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
-
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
-
-/* Tests_SRS_UWS_CLIENT_01_045: [ If `size` is non-zero and `buffer` is NULL then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(uws_client_send_frame_async_with_NULL_buffer_and_non_zero_size_fails)
+/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+TEST_FUNCTION(when_a_complete_frame_is_received_together_with_the_upgrade_request_the_frame_is_indicated_as_received)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    size_t received_data_length = sizeof(test_upgrade_response) + 1;
+    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
+
+    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    received_data[received_data_length - 2] = 0x82;
+    received_data[received_data_length - 1] = 0x00;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5156,85 +5197,118 @@ TEST_FUNCTION(uws_client_send_frame_async_with_NULL_buffer_and_non_zero_size_fai
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 1, true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
-/* Tests_SRS_UWS_CLIENT_01_268: [ The endpoint MUST ensure the WebSocket connection is in the OPEN state ]*/
-TEST_FUNCTION(uws_client_send_frame_async_when_not_open_fails)
+/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+TEST_FUNCTION(when_a_1_byte_complete_frame_is_received_together_with_the_upgrade_request_the_frame_is_indicated_as_received)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
-    unsigned char test_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    size_t received_data_length = sizeof(test_upgrade_response) + 2;
+    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
+    unsigned char expected_frame_payload[] = { 0x42 };
+
+    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    received_data[received_data_length - 1] = 0x42;
+    received_data[received_data_length - 2] = 0x01;
+    received_data[received_data_length - 3] = 0x82;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, expected_frame_payload, sizeof(expected_frame_payload)))
+        .ValidateArgumentBuffer(3, expected_frame_payload, sizeof(expected_frame_payload));
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
-TEST_FUNCTION(uws_client_send_frame_async_when_opening_underlying_io_fails)
+/* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
+TEST_FUNCTION(when_2_complete_frames_are_received_together_with_the_upgrade_request_the_frames_are_indicated_as_received)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
-    unsigned char test_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    size_t received_data_length = sizeof(test_upgrade_response) + 4;
+    unsigned char* received_data = (unsigned char*)malloc(received_data_length);
+
+    (void)memcpy(received_data, test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    received_data[received_data_length - 5] = 0x81;
+    received_data[received_data_length - 4] = 0x01;
+    received_data[received_data_length - 3] = 'a';
+    received_data[received_data_length - 2] = 0x82;
+    received_data[received_data_length - 1] = 0x00;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, "a", 1);
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
+        .IgnoreArgument_buffer();
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, received_data_length);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
+    free(received_data);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
-TEST_FUNCTION(uws_client_send_frame_async_when_waiting_for_upgrade_response_fails)
+/* Tests_SRS_UWS_CLIENT_02_026: [ Consuming decoded bytes shall only advance the read offset into the received bytes buffer, without moving the remaining bytes. ]*/
+/* Tests_SRS_UWS_CLIENT_02_023: [ Otherwise the unconsumed bytes shall be moved to the start of the buffer. ]*/
+/* Tests_SRS_UWS_CLIENT_02_025: [ Frames shall be decoded in place, starting at the read offset in the received bytes buffer. ]*/
+TEST_FUNCTION(when_a_partial_frame_is_left_after_decoding_the_rest_of_it_is_decoded_without_reallocating_the_received_bytes)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
-    unsigned char test_payload[] = { 0x42 };
+    const char received_data[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n\x82\x01\x42\x82";
+    const unsigned char test_frame[] = { 0x01, 0x43 };
+    const unsigned char expected_payload[] = { 0x43 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5242,46 +5316,32 @@ TEST_FUNCTION(uws_client_send_frame_async_when_waiting_for_upgrade_response_fail
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)received_data, sizeof(received_data) - 1);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
-/* Tests_SRS_UWS_CLIENT_01_039: [ - the encoded websocket frame, so that the frame can be later sent when `uws_client_dowork` is called ]*/
-/* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
-/* Tests_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
-/* Tests_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
-/* Tests_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
-/* Tests_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
-/* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
-/* Tests_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
-/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
-/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
-/* Tests_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
-/* Tests_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
-/* Tests_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
-TEST_FUNCTION(uws_client_send_frame_async_succeeds)
+/* Tests_SRS_UWS_CLIENT_02_027: [ When all the received bytes have been consumed the read offset shall be reset to the start of the buffer. ]*/
+/* Tests_SRS_UWS_CLIENT_02_022: [ If the new bytes fit after the unconsumed bytes in the received bytes buffer, they shall be copied there without reallocating the buffer. ]*/
+TEST_FUNCTION(when_a_frame_fits_in_the_received_bytes_buffer_it_is_decoded_without_reallocating_the_buffer)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
-    int result;
-    BUFFER_HANDLE buffer_handle;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char empty_frame[] = { 0x82, 0x00 };
+    unsigned char test_frame[34 + 2] = { 0x82, 0x22 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5289,49 +5349,32 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, empty_frame, sizeof(empty_frame));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 34))
+        .ValidateArgumentBuffer(3, &test_frame[2], 34);
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
-TEST_FUNCTION(uws_send_text_frame_succeeds)
+/* Tests_SRS_UWS_CLIENT_02_024: [ If the bytes still do not fit, the buffer shall be grown with `realloc` to the larger of twice its current size and the size needed. ]*/
+TEST_FUNCTION(when_a_frame_does_not_fit_in_the_received_bytes_buffer_the_buffer_is_doubled)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 'a' };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 'a' };
-    int result;
-    BUFFER_HANDLE buffer_handle;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    /* the received bytes buffer is as big as the upgrade response, the frame is 1 byte bigger */
+    unsigned char test_frame[sizeof(test_upgrade_response) + 1] = { 0x82, sizeof(test_upgrade_response) - 1 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5339,47 +5382,37 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_TEXT_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, (sizeof(test_upgrade_response) - 1) * 2));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_upgrade_response) - 1))
+        .ValidateArgumentBuffer(3, &test_frame[2], sizeof(test_upgrade_response) - 1);
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
+/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connection_is_closed)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x80 };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5390,195 +5423,195 @@ TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
+/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails_an_error_is_indicated_anyhow)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x80 };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_144: [ A client MUST close a connection if it detects a masked frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_145: [ In this case, it MAY use the status code 1002 (protocol error) as defined in Section 7.4.1. (These rules might be relaxed in a future specification.) ]*/
+/* Tests_SRS_UWS_CLIENT_01_160: [ Defines whether the "Payload data" is masked. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_frame_fails_an_error_is_indicated_anyhow)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_frame[] = { 0x82, 0x80 };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
-    LIST_ITEM_HANDLE new_item_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
+        .SetReturn(close_frame);
     STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .CaptureReturn(&new_item_handle);
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame))
         .SetReturn(1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn((LIST_ITEM_HANDLE)0x1234);
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&new_item_handle);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
+/* Tests_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
+/* Tests_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
+/* Tests_SRS_UWS_CLIENT_01_235: [ The Close frame MAY contain a body (the "Application data" portion of the frame) that indicates a reason for closing, such as an endpoint shutting down, an endpoint having received a frame too large, or an endpoint having received a frame that does not conform to the format expected by the endpoint. ]*/
+/* Tests_SRS_UWS_CLIENT_01_236: [ If there is a body, the first two bytes of the body MUST be a 2-byte unsigned integer (in network byte order) representing a status code with value /code/ defined in Section 7.4. ]*/
+/* Tests_SRS_UWS_CLIENT_01_461: [ The argument `close_code` shall be set to point to the code extracted from the CLOSE frame. ]*/
+/* Tests_SRS_UWS_CLIENT_01_296: [ Upon either sending or receiving a Close control frame, it is said that _The WebSocket Closing Handshake is Started_ and that the WebSocket connection is in the CLOSING state. ]*/
+/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
+/* Tests_SRS_UWS_CLIENT_01_242: [ It SHOULD do so as soon as practical. ]*/
+/* Tests_SRS_UWS_CLIENT_01_239: [ Close frames sent from client to server must be masked as per Section 5.3. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_to_the_user)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
     BUFFER_HANDLE buffer_handle;
-    LIST_ITEM_HANDLE new_item_handle;
+    uint16_t expected_close_code = 1002;
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
+        .SetReturn(sent_close_frame);
     STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .CaptureReturn(&new_item_handle);
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
         .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn(NULL);
+        .IgnoreArgument_on_send_complete();
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-
-    // section for on_io_send_complete()
-    g_xio_send_result = 1;
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete(IGNORED_PTR_ARG, WS_SEND_FRAME_ERROR));
-    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
+        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_ERROR);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_460: [ When a CLOSE frame is received the callback `on_ws_peer_closed` passed to `uws_client_open_async` shall be called, while passing to it the argument `on_ws_peer_closed_context`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_156: [ *  %x8 denotes a connection close ]*/
+/* Tests_SRS_UWS_CLIENT_01_234: [ The Close frame contains an opcode of 0x8. ]*/
+/* Tests_SRS_UWS_CLIENT_01_462: [ If no code can be extracted then `close_code` shall be NULL. ]*/
+/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_the_callback_is_triggered)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x00 };
     BUFFER_HANDLE buffer_handle;
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5586,47 +5619,49 @@ TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
+        .SetReturn(sent_close_frame);
     STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_send_complete();
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, NULL, NULL, 0));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
-TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
+/* Tests_SRS_UWS_CLIENT_01_463: [ The extra bytes (besides the close code) shall be passed to the `on_ws_peer_closed` callback by using `extra_data` and `extra_data_length`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_241: [ If an endpoint receives a Close frame and did not previously send a Close frame, the endpoint MUST send a Close frame in response. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_passed_to_the_callback)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
-    int result;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x04, 0x03, 0xEA, 0x42, 0x43 };
     BUFFER_HANDLE buffer_handle;
+    uint16_t expected_close_code = 1002;
+    unsigned char expected_extra_data[] = { 0x42, 0x43 };
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5634,50 +5669,88 @@ TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+    STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(1, &close_frame[4], 2);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
+        .SetReturn(sent_close_frame);
     STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
         .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+        .IgnoreArgument_on_send_complete();
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, IGNORED_PTR_ARG, sizeof(expected_extra_data)))
+        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code))
+        .ValidateArgumentBuffer(3, &expected_extra_data, sizeof(expected_extra_data));
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, NULL, NULL);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_send_complete */
+/* Tests_SRS_UWS_CLIENT_01_237: [ Following the 2-byte integer, the body MAY contain UTF-8-encoded data with value /reason/, the interpretation of which is not defined by this specification. ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_connection_is_closed)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x03, 0x03, 0xEA, 0xDF };
+    uint16_t expected_close_code = 1002;
 
-/* Tests_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling `singlylinkedlist_remove`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent_OK)
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(1, &close_frame[4], 1)
+        .SetReturn(false);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_io_close_complete();
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
+/* Tests_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outgoing_CLOSE_fails_the_connection_is_closed)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
+    uint16_t expected_close_code = 1002;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5685,18 +5758,19 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_OK));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_io_close_complete();
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
+        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5705,14 +5779,19 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
-TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_indicated)
+/* Tests_SRS_UWS_CLIENT_01_288: [ To _Close the WebSocket Connection_, an endpoint closes the underlying TCP connection. ]*/
+/* Tests_SRS_UWS_CLIENT_01_290: [ An endpoint MAY close the connection via any means available when necessary, such as when under attack. ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgoing_CLOSE_fails_the_connection_is_closed)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+    uint16_t expected_close_code = 1002;
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5720,18 +5799,32 @@ TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_i
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle()
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sent_close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_send_complete()
         .SetReturn(1);
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_io_close_complete();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_peer_closed((void*)0x4301, IGNORED_PTR_ARG, NULL, 0))
+        .ValidateArgumentBuffer(2, &expected_close_code, sizeof(expected_close_code));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5740,14 +5833,63 @@ TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_i
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_ERROR_indicates_the_frame_with_WS_SEND_ERROR)
+/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ] */
+TEST_FUNCTION(sending_after_a_close_is_received_does_not_send_anything)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
+    int result;
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_send_frame_async */
+
+/* Tests_SRS_UWS_CLIENT_01_044: [ If any the arguments `uws_client` is NULL, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_NULL_handle_fails)
+{
+    // arrange
     unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    // act
+    result = uws_client_send_frame_async(NULL, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_045: [ If `size` is non-zero and `buffer` is NULL then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5756,32 +5898,83 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_ERROR_indicates_the_frame_with
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 1, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
+/* Tests_SRS_UWS_CLIENT_01_268: [ The endpoint MUST ensure the WebSocket connection is in the OPEN state ]*/
+TEST_FUNCTION(uws_client_send_frame_async_when_not_open_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_ERROR);
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_CANCELLED_indicates_the_frame_with_WS_SEND_CANCELLED)
+/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
+TEST_FUNCTION(uws_client_send_frame_async_when_opening_underlying_io_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_043: [ If the uws instance is not OPEN (open has not been called or is still in progress) then `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
+TEST_FUNCTION(uws_client_send_frame_async_when_waiting_for_upgrade_response_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    int result;
     unsigned char test_payload[] = { 0x42 };
 
     tlsio_config.hostname = "test_host";
@@ -5790,18 +5983,4064 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_CANCELLED_indicates_the_frame_
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
+/* Tests_SRS_UWS_CLIENT_01_039: [ - the encoded websocket frame, so that the frame can be later sent when `uws_client_dowork` is called ]*/
+/* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
+/* Tests_SRS_UWS_CLIENT_01_056: [ - the `send_complete` callback shall be the `on_underlying_io_send_complete` function. ]*/
+/* Tests_SRS_UWS_CLIENT_01_042: [ On success, `uws_client_send_frame_async` shall return 0. ]*/
+/* Tests_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling `uws_frame_encoder_encode` and passing to it the `buffer` and `size` argument for payload, the `is_final` flag and setting `is_masked` to true. ]*/
+/* Tests_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling `BUFFER_u_char` on the encode buffer. ]*/
+/* Tests_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling `BUFFER_length` on the encode buffer. ]*/
+/* Tests_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling `singlylinkedlist_add`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_038: [ `uws_client_send_frame_async` shall create and queue a structure that contains: ]*/
+/* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback `on_ws_send_frame_complete` ]*/
+/* Tests_SRS_UWS_CLIENT_01_041: [ - the send complete callback context `on_ws_send_frame_complete_context` ]*/
+/* Tests_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+/* Tests_SRS_UWS_CLIENT_01_146: [ A data frame MAY be transmitted by either the client or the server at any time after opening handshake completion and before that endpoint has sent a Close frame (Section 5.5.1). ]*/
+/* Tests_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
+/* Tests_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
+/* Tests_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_142: [ If a pending send record kept from an earlier send is available, it shall be reused instead of allocating memory for the newly queued item. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_after_a_completed_send_reuses_the_pending_send_record)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
+TEST_FUNCTION(uws_send_text_frame_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 'a' };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 'a' };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_TEXT_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_047: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_426: [ If `uws_frame_encoder_encode` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_058: [ If `xio_send` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+    LIST_ITEM_HANDLE new_item_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+    LIST_ITEM_HANDLE new_item_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    // section for on_io_send_complete(), called from within xio_send
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    g_xio_send_result = 1;
+    g_xio_send_completes_synchronously = true;
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_049: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_050: [ The argument `on_ws_send_frame_complete` shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_001: [ If the header and payload of the frame do not fit in `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes, `uws_client_send_frame_async` shall not call `uws_frame_encoder_encode` and shall instead encode only the header in a stack buffer of `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and no reserved bits. ]*/
+/* Tests_SRS_UWS_CLIENT_02_003: [ The first time such a frame is sent a scratch buffer of `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+/* Tests_SRS_UWS_CLIENT_02_005: [ The header followed by as many payload bytes as fit, masked by calling `uws_frame_encoder_mask`, shall be sent from the scratch buffer with one `xio_send` call; the rest of the payload shall be masked into the scratch buffer and sent in pieces of at most `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes, passing to `uws_frame_encoder_mask` the position of each piece in the payload as offset. ]*/
+/* Tests_SRS_UWS_CLIENT_02_006: [ Only the `xio_send` call carrying the last bytes of the frame shall be given `on_underlying_io_send_complete` and the pending send as callback and context, the others shall be given a NULL callback. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_a_large_frame_masks_it_through_the_scratch_buffer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    void* pending_send;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .CaptureReturn(&pending_send);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(4, test_large_frame_header + sizeof(test_large_frame_header) - 4, 4);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE, NULL, NULL))
+        .ValidateArgumentBuffer(2, test_large_frame_header, sizeof(test_large_frame_header));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload + TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)))
+        .ValidateArgumentBuffer(4, test_large_frame_header + sizeof(test_large_frame_header) - 4, 4);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .ValidateArgumentValue_callback_context(&pending_send);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_on_io_send_complete);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_003: [ The first time such a frame is sent a scratch buffer of `UWS_CLIENT_SEND_SCRATCH_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_a_second_large_frame_reuses_the_scratch_buffer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, false, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE, NULL, NULL));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload + TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, false, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_004: [ If allocating the scratch buffer fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_scratch_buffer_fails_uws_client_send_frame_async_with_a_large_frame_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_002: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_encoding_the_header_fails_uws_client_send_frame_async_with_a_large_frame_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, true, 0, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_007: [ If any of the `xio_send` calls fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_09_001: [ If `xio_send` fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_the_first_xio_send_fails_uws_client_send_frame_async_with_a_large_frame_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    LIST_ITEM_HANDLE new_item_handle;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE, NULL, NULL))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_007: [ If any of the `xio_send` calls fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_02_151: [ If an `xio_send` call fails after an earlier `xio_send` call for the same frame succeeded, the uws client shall also indicate an error by calling `on_ws_error` with `WS_ERROR_UNDERLYING_IO_ERROR`, as the peer has received part of a frame and the connection cannot be used anymore. ]*/
+TEST_FUNCTION(when_the_second_xio_send_fails_uws_client_send_frame_async_with_a_large_frame_fails_and_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    LIST_ITEM_HANDLE new_item_handle;
+    int result;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE, NULL, NULL));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload + TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, 1, true, test_on_ws_send_frame_complete, (void*)0x4249));
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_008: [ `uws_client_destroy` shall free the send scratch buffer, if one was allocated. ]*/
+TEST_FUNCTION(uws_client_destroy_frees_the_send_scratch_buffer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char* test_payload = test_large_frame_payload;
+    void* scratch_buffer;
+
+    (void)memset(test_payload, 0x42, TEST_LARGE_FRAME_PAYLOAD_SIZE);
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE))
+        .CaptureReturn(&scratch_buffer);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, NULL, NULL);
+    (void)uws_client_close_async(uws_client, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_ptr(&scratch_buffer);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_client_send_frame_in_place_async */
+
+/* Tests_SRS_UWS_CLIENT_02_009: [ `uws_client_send_frame_in_place_async` shall queue and send a frame like `uws_client_send_frame_async` does, except that the payload is masked in place in `buffer` instead of being copied. ]*/
+/* Tests_SRS_UWS_CLIENT_02_010: [ The header shall be encoded in a stack buffer of `UWS_FRAME_ENCODER_MAX_HEADER_SIZE` bytes by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and no reserved bits. ]*/
+/* Tests_SRS_UWS_CLIENT_02_011: [ The payload shall be masked in place by calling `uws_frame_encoder_mask` with `buffer` as both destination and source and the masking key found in the last 4 bytes of the header. ]*/
+/* Tests_SRS_UWS_CLIENT_02_012: [ The header shall be sent by calling `xio_send` with a NULL callback, followed by `buffer` sent by calling `xio_send` with `on_underlying_io_send_complete` and the pending send as callback and context. ]*/
+/* Tests_SRS_UWS_CLIENT_02_021: [ On success, `uws_client_send_frame_in_place_async` shall return 0. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_masks_the_payload_in_place_and_sends_it_after_the_header)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42, 0x43, 0x44 };
+    void* pending_send;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_TEXT_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .CaptureReturn(&pending_send);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(test_payload, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(4, test_large_frame_header + sizeof(test_large_frame_header) - 4, 4);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header), NULL, NULL))
+        .ValidateArgumentBuffer(2, test_large_frame_header, sizeof(test_large_frame_header));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .ValidateArgumentValue_callback_context(&pending_send);
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_on_io_send_complete);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_013: [ If `size` is 0 only the header shall be sent, with `on_underlying_io_send_complete` and the pending send as callback and context. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_with_0_size_sends_only_the_header)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    void* pending_send;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, 0, true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .CaptureReturn(&pending_send);
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(NULL, NULL, 0, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .ValidateArgumentValue_callback_context(&pending_send);
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 0, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_on_io_send_complete);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_014: [ If the argument `uws_client` is NULL, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_with_NULL_handle_fails)
+{
+    // arrange
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    // act
+    result = uws_client_send_frame_in_place_async(NULL, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_015: [ If `size` is non-zero and `buffer` is NULL then `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 1, true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_020: [ If the uws instance is not OPEN then `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_when_not_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_016: [ If `uws_frame_encoder_encode_header` fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_encoding_the_header_fails_uws_client_send_frame_in_place_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_017: [ If allocating memory for the newly queued item fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_pending_send_fails_uws_client_send_frame_in_place_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_018: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_adding_the_pending_send_to_the_list_fails_uws_client_send_frame_in_place_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_019: [ If any of the `xio_send` calls fails, `uws_client_send_frame_in_place_async` shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_02_152: [ If sending `buffer` fails after the header was sent, the uws client shall also indicate an error by calling `on_ws_error` with `WS_ERROR_UNDERLYING_IO_ERROR`. ]*/
+TEST_FUNCTION(when_sending_the_payload_fails_uws_client_send_frame_in_place_async_fails_and_indicates_an_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    LIST_ITEM_HANDLE new_item_handle;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .CaptureReturn(&new_item_handle);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(test_payload, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header), NULL, NULL));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .ValidateArgumentValue_item_handle(&new_item_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* on_underlying_io_send_complete */
+
+/* Tests_SRS_UWS_CLIENT_01_389: [ When `on_underlying_io_send_complete` is called with `IO_SEND_OK` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_OK`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling `singlylinkedlist_remove`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed, unless fewer than `UWS_CLIENT_MAX_POOLED_PENDING_SENDS` records are kept for reuse, in which case it shall be kept for reuse by a later send. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent_OK)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_OK));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_433: [ If `singlylinkedlist_remove` fails an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
+TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_indicated)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_390: [ When `on_underlying_io_send_complete` is called with `IO_SEND_ERROR` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_ERROR_indicates_the_frame_with_WS_SEND_ERROR)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_ERROR);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_391: [ When `on_underlying_io_send_complete` is called with `IO_SEND_CANCELLED` as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_CANCELLED`. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_CANCELLED_indicates_the_frame_with_WS_SEND_CANCELLED)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_CANCELLED));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_CANCELLED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_435: [ When `on_underlying_io_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_NULL_context_does_nothing)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_io_send_complete(NULL, IO_SEND_CANCELLED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_an_unknown_result_indicates_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, (IO_SEND_RESULT)0x42);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_set_on_ws_frame_fragment_received */
+
+/* Tests_SRS_UWS_CLIENT_02_029: [ If `uws_client` is NULL, `uws_client_set_on_ws_frame_fragment_received` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_frame_fragment_received_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_client_set_on_ws_frame_fragment_received(NULL, test_on_ws_frame_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_030: [ If the uws instance is not CLOSED, `uws_client_set_on_ws_frame_fragment_received` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_frame_fragment_received_after_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_031: [ Otherwise `uws_client_set_on_ws_frame_fragment_received` shall store `on_ws_frame_fragment_received` and `on_ws_frame_fragment_received_context` and return 0. A NULL `on_ws_frame_fragment_received` turns streaming off. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_frame_fragment_received_succeeds)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_031: [ Otherwise `uws_client_set_on_ws_frame_fragment_received` shall store `on_ws_frame_fragment_received` and `on_ws_frame_fragment_received_context` and return 0. A NULL `on_ws_frame_fragment_received` turns streaming off. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_frame_fragment_received_with_NULL_callback_turns_streaming_off)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x02, 0x01, 'a', 0x80, 0x01, 'b' };
+    const unsigned char expected_payload[] = { 'a', 'b' };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+    result = uws_client_set_on_ws_frame_fragment_received(uws_client, NULL, NULL);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_set_on_ws_upgrade_response_header */
+
+/* Tests_SRS_UWS_CLIENT_02_134: [ If `uws_client` is NULL, `uws_client_set_on_ws_upgrade_response_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_upgrade_response_header_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_client_set_on_ws_upgrade_response_header(NULL, test_on_ws_upgrade_response_header, (void*)0x4246);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_135: [ If the uws instance is not CLOSED, `uws_client_set_on_ws_upgrade_response_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_upgrade_response_header_after_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_on_ws_upgrade_response_header(uws_client, test_on_ws_upgrade_response_header, (void*)0x4246);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_136: [ Otherwise `uws_client_set_on_ws_upgrade_response_header` shall store `on_ws_upgrade_response_header` and `on_ws_upgrade_response_header_context` and return 0. A NULL `on_ws_upgrade_response_header` stops the headers from being indicated. ]*/
+TEST_FUNCTION(uws_client_set_on_ws_upgrade_response_header_with_NULL_callback_stops_indicating_headers)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    upgrade_response_headers[0] = '\0';
+    (void)uws_client_set_on_ws_upgrade_response_header(uws_client, test_on_ws_upgrade_response_header, (void*)0x4246);
+    result = uws_client_set_on_ws_upgrade_response_header(uws_client, NULL, NULL);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "", upgrade_response_headers);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_dowork */
+
+/* Tests_SRS_UWS_CLIENT_01_059: [ If the `uws_client` argument is NULL, `uws_client_dowork` shall do nothing. ]*/
+TEST_FUNCTION(uws_client_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    uws_client_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_430: [ `uws_client_dowork` shall call `xio_dowork` with the IO handle argument set to the underlying IO created in `uws_client_create`. ]*/
+TEST_FUNCTION(uws_client_dowork_calls_the_underlying_io_dowork)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, `uws_client_dowork` shall do nothing. ]*/
+TEST_FUNCTION(uws_client_dowork_when_closed_does_nothing)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* on_underlying_io_error */
+
+/* Tests_SRS_UWS_CLIENT_01_375: [ When `on_underlying_io_error` is called while uws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_UNDERLYING_IO_ERROR`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_077: [ If this fails (e.g., the server's certificate could not be verified), then the client MUST _Fail the WebSocket Connection_ and abort the connection. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_opening_underlying_io_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_375: [ When `on_underlying_io_error` is called while uws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_UNDERLYING_IO_ERROR`. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_waiting_for_upgrade_response_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_376: [ When `on_underlying_io_error` is called while the uws instance is OPEN, an error shall be reported to the user by calling the `on_ws_error` callback that was passed to `uws_client_open_async` with the argument `WS_ERROR_UNDERLYING_IO_ERROR`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_318: [ Servers MAY close the WebSocket connection whenever desired. ]*/
+/* Tests_SRS_UWS_CLIENT_01_269: [ If at any point the state of the WebSocket connection changes, the endpoint MUST abort the following steps. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_OPEN_indicates_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_indicates_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
+TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_error(g_on_io_error_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_499: [ If the CLOSE was due to the peer closing, the callback `on_ws_close_complete` shall not be called. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_underlying_io_indicates_the_close)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_io_close_complete();
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
+TEST_FUNCTION(open_after_error_during_closing_underlying_io_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    g_on_io_error(g_on_io_error_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_500: [ If `xio_close` fails then the callback `on_ws_close_complete` shall be called, while passing the `on_ws_close_complete_context` argument to it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_500: [ The callback `on_ws_close_complete` shall be called, while passing the `on_ws_close_complete_context` argument to it. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_due_to_local_initiated_close)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    (void)uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x6666);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_on_ws_close_complete((void*)0x6666));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* on_underlying_io_close_sent */
+
+/* Tests_SRS_UWS_CLIENT_01_489: [ When `on_underlying_io_close_sent` is called with NULL context, it shall do nothing. ]*/
+TEST_FUNCTION(on_underlying_io_close_sent_with_NULL_context_does_nothing)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_io_send_complete(NULL, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_490: [ When `on_underlying_io_close_sent` is called while the uws client is CLOSING, `on_underlying_io_close_sent` shall close the underlying IO by calling `xio_close`. ]*/
+TEST_FUNCTION(on_underlying_io_close_sent_when_a_CLOSE_was_sent_closes_the_underlying_IO)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_493: [ If calling `xio_close` fails, the state of the uws client shall be considered CLOSED and the `on_ws_close_complete` shall be called if it was specified. ]*/
+/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no `on_ws_close_complete` shall be called. ]*/
+TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_493: [ If calling `xio_close` fails, the state of the uws client shall be considered CLOSED and the `on_ws_close_complete` shall be called if it was specified. ]*/
+/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no `on_ws_close_complete` shall be called. ]*/
+TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered_and_next_open_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Ping frame */
+
+/* Tests_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
+/* Tests_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
+/* Tests_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
+/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
+/* Tests_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
+/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
+TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char ping_frame[] = { 0x89, 0x00 };
+    unsigned char pong_frame[] = { 0x8A, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
+        .IgnoreArgument_payload()
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(pong_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
+/* Tests_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
+TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_sent_with_the_Same_payload)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char ping_frame[] = { 0x89, 0x02, 0x42, 0x43 };
+    unsigned char pong_frame_payload[] = { 0x42, 0x43 };
+    unsigned char pong_frame[] = { 0x8A, 0x02, 0x00, 0x00, 0x00, 0x00, 0x42, 0x43 };
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(pong_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
+/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
+TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char close_and_ping_frames[] = { 0x88, 0x00, 0x89, 0x02, 0x42, 0x43 };
+    BUFFER_HANDLE buffer_handle;
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sent_close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_send_complete();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    EXPECTED_CALL(test_on_ws_peer_closed(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)close_and_ping_frames, sizeof(close_and_ping_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Fragmented messages */
+
+/* Tests_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
+/* Tests_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
+/* Tests_SRS_UWS_CLIENT_01_152: [ *  %x0 denotes a continuation frame ]*/
+/* Tests_SRS_UWS_CLIENT_01_283: [ If the frame is part of a fragmented message, the "Application data" of the subsequent data frames is concatenated to form the /data/. ]*/
+/* Tests_SRS_UWS_CLIENT_01_284: [ When the last fragment is received as indicated by the FIN bit (frame-fin), it is said that _A WebSocket Message Has Been Received_ with data /data/ (comprised of the concatenation of the "Application data" of the fragments) and type /type/ (noted from the first frame of the fragmented message). ]*/
+/* Tests_SRS_UWS_CLIENT_02_033: [ A text or binary frame that does not have the FIN bit set shall start a fragmented message of that type. ]*/
+/* Tests_SRS_UWS_CLIENT_02_036: [ Otherwise the payload of each fragment shall be appended to the message being reassembled. ]*/
+/* Tests_SRS_UWS_CLIENT_02_037: [ When the final fragment has been appended, the reassembled message shall be indicated via the callback `on_ws_frame_received`, with the type of the first fragment. ]*/
+TEST_FUNCTION(when_a_fragmented_text_message_is_received_it_is_reassembled_and_indicated_to_the_user)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x01, 'a', 0x00, 0x01, 'b', 0x80, 0x01, 'c' };
+    const unsigned char expected_payload[] = { 'a', 'b', 'c' };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 4));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_285: [ Subsequent data frames MUST be interpreted as belonging to a new WebSocket message. ]*/
+/* Tests_SRS_UWS_CLIENT_02_032: [ A text or binary frame that has the FIN bit set and is received while no fragmented message is being received shall be indicated via the callback `on_ws_frame_received`. ]*/
+TEST_FUNCTION(a_binary_frame_received_after_a_reassembled_message_is_indicated_as_a_new_message)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x02, 0x01, 'a', 0x80, 0x01, 'b', 0x82, 0x01, 'c' };
+    const unsigned char expected_message[] = { 'a', 'b' };
+    const unsigned char expected_payload[] = { 'c' };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_message)))
+        .ValidateArgumentBuffer(3, expected_message, sizeof(expected_message));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_218: [ An endpoint MUST be capable of handling control frames in the middle of a fragmented message. ]*/
+TEST_FUNCTION(a_PING_frame_in_the_middle_of_a_fragmented_message_is_answered_and_the_message_is_still_reassembled)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x01, 'a', 0x89, 0x00, 0x80, 0x01, 'b' };
+    const unsigned char expected_payload[] = { 'a', 'b' };
+    unsigned char pong_frame[] = { 0x8A, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
+        .IgnoreArgument_payload()
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(pong_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_034: [ If a text or binary frame is received while a fragmented message is being received, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(when_a_binary_frame_is_received_in_the_middle_of_a_fragmented_message_an_error_is_indicated_and_the_connection_is_closed)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x01, 'a', 0x82, 0x01, 'b' };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_035: [ If a continuation frame is received while no fragmented message is being received, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(when_a_continuation_frame_is_received_without_a_fragmented_message_an_error_is_indicated_and_the_connection_is_closed)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x80, 0x01, 'a' };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_038: [ If growing the buffer for the message being reassembled fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_growing_the_reassembly_buffer_fails_an_error_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x01, 0x01, 'a' };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_NOT_ENOUGH_MEMORY));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_039: [ If an `on_ws_frame_fragment_received` callback was set when the first fragment of a message was received, each fragment of that message shall be passed to it, together with the type of the message and whether the fragment is the final one. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_the_fragments_are_passed_to_it_without_being_reassembled)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x02, 0x02, 'a', 'b', 0x80, 0x01, 'c' };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 2, false))
+        .ValidateArgumentBuffer(3, &test_frames[2], 2);
+    STRICT_EXPECTED_CALL(test_on_ws_frame_fragment_received((void*)0x4245, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1, true))
+        .ValidateArgumentBuffer(3, &test_frames[6], 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_032: [ A text or binary frame that has the FIN bit set and is received while no fragmented message is being received shall be indicated via the callback `on_ws_frame_received`. ]*/
+TEST_FUNCTION(when_a_fragment_callback_is_set_an_unfragmented_frame_is_still_indicated_via_on_ws_frame_received)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x81, 0x01, 'a' };
+    const unsigned char expected_payload[] = { 'a' };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_359: [ Implementations that have implementation- and/or platform-specific limitations regarding the frame size or total message size after reassembly from multiple frames MUST protect themselves against exceeding those limits. ]*/
+/* Tests_SRS_UWS_CLIENT_02_042: [ As soon as the length of a data frame is decoded, if the frame payload together with the bytes already accumulated for the message it belongs to exceeds the maximum message size, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_MESSAGE_TOO_BIG` and a CLOSE frame with status code 1009 shall be sent. ]*/
+TEST_FUNCTION(when_a_frame_bigger_than_the_maximum_message_size_is_received_an_error_is_indicated_before_its_payload_arrives)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame_header[] = { 0x82, 0x7E, 0x00, 0x7E };
+    size_t max_message_size = 125;
+    unsigned char close_frame_payload[] = { 0x03, 0xF1 };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xF1 };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_MESSAGE_TOO_BIG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_header, sizeof(test_frame_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_042: [ As soon as the length of a data frame is decoded, if the frame payload together with the bytes already accumulated for the message it belongs to exceeds the maximum message size, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_MESSAGE_TOO_BIG` and a CLOSE frame with status code 1009 shall be sent. ]*/
+TEST_FUNCTION(when_the_reassembled_message_would_exceed_the_maximum_message_size_an_error_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x02, 'a', 'b', 0x80, 0x02, 'c', 'd' };
+    size_t max_message_size = 3;
+    unsigned char close_frame_payload[] = { 0x03, 0xF1 };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xF1 };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 2));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_MESSAGE_TOO_BIG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_042: [ As soon as the length of a data frame is decoded, if the frame payload together with the bytes already accumulated for the message it belongs to exceeds the maximum message size, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_MESSAGE_TOO_BIG` and a CLOSE frame with status code 1009 shall be sent. ]*/
+TEST_FUNCTION(fragments_passed_to_the_fragment_callback_do_not_count_towards_the_maximum_message_size)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frames[] = { 0x01, 0x02, 'a', 'b', 0x80, 0x02, 'c', 'd' };
+    size_t max_message_size = 3;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
+    (void)uws_client_set_on_ws_frame_fragment_received(uws_client, test_on_ws_frame_fragment_received, (void*)0x4245);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 2, false))
+        .ValidateArgumentBuffer(3, &test_frames[2], 2);
+    STRICT_EXPECTED_CALL(test_on_ws_frame_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 2, true))
+        .ValidateArgumentBuffer(3, &test_frames[6], 2);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, sizeof(test_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_028: [ `uws_client_destroy` shall free the buffer used for reassembling fragmented messages, if one was allocated. ]*/
+TEST_FUNCTION(uws_client_destroy_frees_the_reassembly_buffer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0x01, 0x01, 'a' };
+    void* fragmented_message;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 1))
+        .CaptureReturn(&fragmented_message);
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+    (void)uws_client_close_async(uws_client, NULL, NULL);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_ptr(&fragmented_message);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_100: [ The request MAY include a header field with the name |Sec-WebSocket-Extensions|. ]*/
+/* Tests_SRS_UWS_CLIENT_02_048: [ If the `ws_permessage_deflate` option was set, the upgrade request shall offer the permessage-deflate extension in a `Sec-WebSocket-Extensions` header. ]*/
+/* Tests_SRS_UWS_CLIENT_02_049: [ The offer shall always include `client_max_window_bits`, with a value only when the configured client window is below 15 bits, `server_max_window_bits` only when the requested server window is below 15 bits, and `client_no_context_takeover` and `server_no_context_takeover` when they were requested. ]*/
+TEST_FUNCTION(when_the_ws_permessage_deflate_option_is_set_the_upgrade_request_offers_permessage_deflate)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t i;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 12, 10, true, false, 6 };
+    const char expected_upgrade_request[] = "GET /aaa HTTP/1.1\r\n"
+        "Host: test_host:444\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: ZWRuYW1vZGU6bm9jYXBlcyE=\r\n"
+        "Sec-WebSocket-Protocol: test_protocol\r\n"
+        "Sec-WebSocket-Version: 13\r\n"
+        "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits=12; server_max_window_bits=10; client_no_context_takeover\r\n"
+        "\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    for (i = 0; i < 16; i++)
+    {
+        EXPECTED_CALL(gb_rand());
+    }
+    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16));
+    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(expected_upgrade_request) - 1, NULL, NULL))
+        .ValidateArgumentBuffer(2, expected_upgrade_request, sizeof(expected_upgrade_request) - 1);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_114: [ Please note that according to [RFC2616], all header field names in both HTTP requests and HTTP responses are case-insensitive. ]*/
+/* Tests_SRS_UWS_CLIENT_02_055: [ All `Sec-WebSocket-Extensions` header fields of the upgrade response shall be parsed as a comma separated list of extensions with semicolon separated parameters. ]*/
+/* Tests_SRS_UWS_CLIENT_02_058: [ If the server accepted permessage-deflate, a compressor shall be created by calling `uws_deflate_create` with the smaller of the configured and accepted client windows, the configured compression level, and whether either side requested `client_no_context_takeover`. ]*/
+TEST_FUNCTION(when_the_server_accepts_permessage_deflate_a_compressor_is_created)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 12, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "sec-websocket-extensions: permessage-deflate; client_max_window_bits=10; client_no_context_takeover\r\n"
+        "\r\n";
+    UWS_CLIENT_COMPRESSION_STATISTICS statistics;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_create(10, 6, true));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, uws_client_get_compression_statistics(uws_client, &statistics));
+    ASSERT_IS_TRUE(statistics.is_negotiated);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_111: [ If the response includes a |Sec-WebSocket-Extensions| header field and this header field indicates the use of an extension that was not present in the client's handshake (the server has indicated an extension not requested by the client), the client MUST _Fail the WebSocket Connection_. ]*/
+/* Tests_SRS_UWS_CLIENT_02_056: [ If the server indicates an extension that was not offered, an extension more than once, or a permessage-deflate parameter that is unknown, duplicated, malformed or outside of what was offered, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_the_server_indicates_an_extension_that_was_not_offered_the_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_056: [ If the server indicates an extension that was not offered, an extension more than once, or a permessage-deflate parameter that is unknown, duplicated, malformed or outside of what was offered, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE`. ]*/
+TEST_FUNCTION(when_the_server_answers_with_a_larger_server_window_than_requested_the_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 10, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate; server_max_window_bits=12\r\n"
+        "\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_059: [ If `uws_deflate_create` fails, the open shall fail by calling the `on_ws_open_complete` callback with `WS_OPEN_ERROR_NOT_ENOUGH_MEMORY`. ]*/
+TEST_FUNCTION(when_creating_the_compressor_fails_the_open_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_create(15, 6, false))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_050: [ The payload of each frame of a message received with the RSV1 bit set shall be decompressed by calling `uws_deflate_decompress`, passing whether the frame is the final one of the message and the number of bytes the message may still grow by. ]*/
+/* Tests_SRS_UWS_CLIENT_02_054: [ A text or binary frame with the RSV1 bit set shall start a compressed message. ]*/
+TEST_FUNCTION(a_compressed_frame_is_decompressed_and_indicated_to_the_user)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+    const unsigned char test_frame[] = { 0xC1, 0x02, 0xAB, 0xCD };
+    const unsigned char compressed_payload[] = { 0xAB, 0xCD };
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_DEFLATE_HANDLE, IGNORED_PTR_ARG, sizeof(compressed_payload), true, SIZE_MAX, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, compressed_payload, sizeof(compressed_payload));
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(test_deflate_output)))
+        .ValidateArgumentBuffer(3, test_deflate_output, sizeof(test_deflate_output));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_051: [ If `uws_deflate_decompress` fails, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1007 shall be sent. ]*/
+TEST_FUNCTION(when_decompressing_a_frame_fails_an_error_is_indicated_and_the_connection_is_closed)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+    const unsigned char test_frame[] = { 0xC2, 0x01, 0xAB };
+    unsigned char close_frame_payload[] = { 0x03, 0xEF };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEF };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_decompress(TEST_DEFLATE_HANDLE, IGNORED_PTR_ARG, 1, true, SIZE_MAX, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_149: [ MUST be 0 unless an extension is negotiated that defines meanings for non-zero values. ]*/
+/* Tests_SRS_UWS_CLIENT_01_150: [ If a nonzero value is received and none of the negotiated extensions defines the meaning of such a nonzero value, the receiving endpoint MUST _Fail the WebSocket Connection_. ]*/
+/* Tests_SRS_UWS_CLIENT_02_053: [ If a frame is received with RSV2 or RSV3 set, or with RSV1 set while permessage-deflate was not negotiated or on a frame that is not the first frame of a text or binary message, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_BAD_FRAME_RECEIVED` and a CLOSE frame with status code 1002 shall be sent. ]*/
+TEST_FUNCTION(when_a_frame_with_RSV1_set_is_received_without_permessage_deflate_an_error_is_indicated_and_the_connection_is_closed)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
+    const unsigned char test_frame[] = { 0xC1, 0x01, 'a' };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_061: [ When permessage-deflate was negotiated, the payload of a text or binary frame that has `is_final` set shall be compressed by calling `uws_deflate_compress`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_063: [ The compressed payload shall be sent as the frame payload, with the RSV1 bit set by passing `RESERVED_1` as the reserved bits to the frame encoder. ]*/
+/* Tests_SRS_UWS_CLIENT_02_153: [ The processor time spent compressing and decompressing shall be measured by calling `ThreadAPI_GetCurrentThreadCpuTime` before and after each call into the compressor. ]*/
+TEST_FUNCTION(when_permessage_deflate_was_negotiated_uws_client_send_frame_async_sends_the_compressed_payload_with_RSV1)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+    unsigned char test_payload[] = { 0x42, 0x42, 0x42, 0x42 };
+    unsigned char encoded_frame[] = { 0xC2, 0x83, 0x00, 0x00, 0x00, 0x00, 'x', 'y', 'z' };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+    UWS_CLIENT_COMPRESSION_STATISTICS statistics;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_DEFLATE_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, IGNORED_PTR_ARG, sizeof(test_deflate_output), true, true, RESERVED_1))
+        .ValidateArgumentBuffer(2, test_deflate_output, sizeof(test_deflate_output))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, uws_client_get_compression_statistics(uws_client, &statistics));
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.messages_compressed);
+    ASSERT_ARE_EQUAL(uint64_t, sizeof(test_payload), statistics.uncompressed_bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, sizeof(test_deflate_output), statistics.compressed_bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, TEST_THREAD_CPU_TIME_STEP_US, statistics.compress_cpu_time_us);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.decompress_cpu_time_us);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_062: [ If `uws_deflate_compress` fails, sending the frame shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_compressing_the_payload_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_DEFLATE_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_154: [ If `ThreadAPI_GetCurrentThreadCpuTime` fails, the processor time of that call into the compressor shall not be counted. ]*/
+TEST_FUNCTION(when_getting_the_thread_cpu_time_fails_the_compression_time_is_not_counted)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n"
+        TEST_SEC_WEBSOCKET_ACCEPT_HEADER
+        "Sec-WebSocket-Extensions: permessage-deflate\r\n"
+        "\r\n";
+    unsigned char test_payload[] = { 0x42, 0x42, 0x42, 0x42 };
+    unsigned char encoded_frame[] = { 0xC2, 0x83, 0x00, 0x00, 0x00, 0x00, 'x', 'y', 'z' };
+    int result;
+    BUFFER_HANDLE buffer_handle;
+    UWS_CLIENT_COMPRESSION_STATISTICS statistics;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(ThreadAPI_GetCurrentThreadCpuTime(IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(uws_deflate_compress(TEST_DEFLATE_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, IGNORED_PTR_ARG, sizeof(test_deflate_output), true, true, RESERVED_1))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(encoded_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(encoded_frame));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, uws_client_get_compression_statistics(uws_client, &statistics));
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.messages_compressed);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.compress_cpu_time_us);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_070: [ If `uws_client` or `statistics` is NULL, `uws_client_get_compression_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_compression_statistics_with_NULL_handle_fails)
+{
+    // arrange
+    UWS_CLIENT_COMPRESSION_STATISTICS statistics;
+    int result;
+
+    // act
+    result = uws_client_get_compression_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_070: [ If `uws_client` or `statistics` is NULL, `uws_client_get_compression_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_compression_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_compression_statistics(uws_client, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_071: [ Otherwise `uws_client_get_compression_statistics` shall fill `statistics` with the counters and the processor times of the current connection and return 0. ]*/
+TEST_FUNCTION(uws_client_get_compression_statistics_without_permessage_deflate_reports_nothing_negotiated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_COMPRESSION_STATISTICS statistics;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_compression_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(statistics.is_negotiated);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.messages_compressed);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.messages_decompressed);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* keepalive PINGs */
+
+/* Tests_SRS_UWS_CLIENT_02_076: [ If a ping interval was set and the uws instance is OPEN, `uws_client_dowork` shall get the current time by calling `tickcounter_get_current_ms`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_078: [ The first keepalive PING shall be sent one ping interval after the first `uws_client_dowork` call that finds the uws instance OPEN. ]*/
+TEST_FUNCTION(uws_client_dowork_before_the_ping_interval_elapsed_does_not_send_a_PING)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 1999;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_080: [ Otherwise, when at least one ping interval has elapsed since the previous PING, a PING frame shall be sent, whether or not the previous one was answered. ]*/
+/* Tests_SRS_UWS_CLIENT_02_081: [ The PING frame shall be encoded by calling `uws_frame_encoder_encode` with a payload made of the next 8 byte big endian sequence number. ]*/
+/* Tests_SRS_UWS_CLIENT_02_082: [ The encoded PING frame shall be sent by calling `xio_send` with a NULL callback. ]*/
+TEST_FUNCTION(uws_client_dowork_once_the_ping_interval_elapsed_sends_a_PING)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char expected_ping_payload[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 2000;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PING_FRAME, IGNORED_PTR_ARG, sizeof(expected_ping_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, expected_ping_payload, sizeof(expected_ping_payload));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_083: [ If encoding or sending the PING frame fails, no error shall be indicated and the PING shall be attempted again after the next ping interval. ]*/
+TEST_FUNCTION(when_sending_the_PING_fails_no_PING_is_counted_as_sent)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_PING_STATISTICS statistics;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    g_xio_send_result = 1;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PING_FRAME, IGNORED_PTR_ARG, 8, true, true, 0));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, NULL, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)uws_client_get_ping_statistics(uws_client, &statistics);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.pings_sent);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_077: [ If `tickcounter_get_current_ms` fails, `uws_client_dowork` shall not send a PING nor check the pong timeout. ]*/
+TEST_FUNCTION(when_getting_the_current_time_fails_uws_client_dowork_does_not_send_a_PING)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 2000;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_079: [ If a pong timeout was set and no PONG echoing a keepalive PING was received for that long since the oldest unanswered PING was sent, an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_PONG_TIMEOUT`. ]*/
+TEST_FUNCTION(when_no_PONG_is_received_within_the_pong_timeout_an_error_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_current_ms = 2500;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_PONG_TIMEOUT));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_156: [ When the pong timeout is indicated, the uws instance shall move to the ERROR state and no PING shall be considered unanswered anymore, so that the timeout is indicated only once. ]*/
+TEST_FUNCTION(the_pong_timeout_is_indicated_only_once)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_PONG_TIMEOUT));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    g_current_ms = 2500;
+    uws_client_dowork(uws_client);
+    g_current_ms = 3000;
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_085: [ When a PONG frame echoing the payload of the last keepalive PING is received, no PING shall be considered unanswered anymore. ]*/
+/* Tests_SRS_UWS_CLIENT_02_086: [ The round trip time shall be measured by calling `tickcounter_get_current_ms` and added to the round trip time statistics. ]*/
+TEST_FUNCTION(when_the_PONG_for_the_last_PING_is_received_the_round_trip_time_is_recorded)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_PING_STATISTICS statistics;
+    const unsigned char pong_frame[] = { 0x8A, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_current_ms = 2020;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)uws_client_get_ping_statistics(uws_client, &statistics);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.pings_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.pongs_received);
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.rtt_min_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.rtt_avg_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 20, statistics.rtt_max_ms);
+    ASSERT_ARE_EQUAL(uint64_t, 1, statistics.rtt_histogram[5]);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_155: [ After a PONG frame, the frames that follow it in the received bytes shall be decoded. ]*/
+TEST_FUNCTION(a_text_frame_received_together_with_a_PONG_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_bytes[] = { 0x8A, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x81, 0x01, 0x42 };
+    const unsigned char expected_payload[] = { 0x42 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_current_ms = 2020;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_085: [ When a PONG frame echoing the payload of the last keepalive PING is received, no PING shall be considered unanswered anymore. ]*/
+TEST_FUNCTION(after_the_PONG_for_the_last_PING_is_received_the_pong_timeout_does_not_fire)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char pong_frame[] = { 0x8A, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+    g_current_ms = 2600;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_084: [ A PONG frame that does not echo the payload of the last keepalive PING sent shall be ignored. ]*/
+TEST_FUNCTION(a_PONG_with_a_different_payload_than_the_last_PING_is_ignored)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_PING_STATISTICS statistics;
+    const unsigned char pong_frame[] = { 0x8A, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_current_ms = 2020;
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)uws_client_get_ping_statistics(uws_client, &statistics);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.pongs_received);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_087: [ If `tickcounter_get_current_ms` fails, the round trip time shall not be recorded. ]*/
+TEST_FUNCTION(when_getting_the_current_time_fails_the_round_trip_time_is_not_recorded)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_PING_STATISTICS statistics;
+    const unsigned char pong_frame[] = { 0x8A, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 500);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)uws_client_get_ping_statistics(uws_client, &statistics);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.pongs_received);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_072: [ `uws_client_destroy` shall destroy the tick counter used for keepalive PINGs by calling `tickcounter_destroy`, if one was created. ]*/
+TEST_FUNCTION(uws_client_destroy_destroys_the_tick_counter)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned int ping_interval_ms = 1000;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_client_wait */
+
+/* Tests_SRS_UWS_CLIENT_02_143: [ If the `uws_client` argument is NULL, `uws_client_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_wait_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = uws_client_wait(NULL, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_144: [ If the IO is not yet open, `uws_client_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_wait_when_closed_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_wait(uws_client, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_148: [ `uws_client_wait` shall call `xio_wait` on the underlying IO created in `uws_client_create`, passing the `timeout_ms` and `interest` arguments to it. ]*/
+/* Tests_SRS_UWS_CLIENT_02_150: [ On success, `uws_client_wait` shall return 0. ]*/
+TEST_FUNCTION(uws_client_wait_calls_the_underlying_io_wait)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ));
+
+    // act
+    result = uws_client_wait(uws_client, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_149: [ If `xio_wait` fails, `uws_client_wait` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_wait_fails_uws_client_wait_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ_WRITE))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_wait(uws_client, 100, IO_WAIT_READ_WRITE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_145: [ If frames were coalesced and the uws instance is OPEN, `uws_client_wait` shall return 0 without waiting, as the next `uws_client_dowork` sends them. ]*/
+TEST_FUNCTION(uws_client_wait_with_coalesced_frames_returns_without_waiting)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char test_payload[] = { 0x42 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_wait(uws_client, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_146: [ If a ping interval was set and the uws instance is OPEN, `timeout_ms` shall be shortened to the time left until the next keepalive PING or pong timeout check, obtained by calling `tickcounter_get_current_ms`. ]*/
+TEST_FUNCTION(uws_client_wait_does_not_wait_past_the_next_keepalive_PING)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 1700;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 300, IO_WAIT_READ));
+
+    // act
+    result = uws_client_wait(uws_client, 5000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_146: [ If a ping interval was set and the uws instance is OPEN, `timeout_ms` shall be shortened to the time left until the next keepalive PING or pong timeout check, obtained by calling `tickcounter_get_current_ms`. ]*/
+TEST_FUNCTION(uws_client_wait_does_not_wait_past_the_pong_timeout)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 200);
+    g_current_ms = 2000;
+    uws_client_dowork(uws_client);
+    g_current_ms = 2100;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 100, IO_WAIT_READ));
+
+    // act
+    result = uws_client_wait(uws_client, 5000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_146: [ If a ping interval was set and the uws instance is OPEN, `timeout_ms` shall be shortened to the time left until the next keepalive PING or pong timeout check, obtained by calling `tickcounter_get_current_ms`. ]*/
+TEST_FUNCTION(uws_client_wait_when_a_PING_is_due_does_not_block)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 2500;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 0, IO_WAIT_READ));
+
+    // act
+    result = uws_client_wait(uws_client, 5000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_147: [ If `tickcounter_get_current_ms` fails, `timeout_ms` shall not be shortened. ]*/
+TEST_FUNCTION(when_getting_the_current_time_fails_uws_client_wait_does_not_shorten_the_timeout)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    g_current_ms = 1000;
+    uws_client = create_open_uws_client_with_keepalive(1000, 0);
+    g_current_ms = 1700;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_wait(TEST_IO_HANDLE, 5000, IO_WAIT_READ));
+
+    // act
+    result = uws_client_wait(uws_client, 5000, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_get_ping_statistics */
+
+/* Tests_SRS_UWS_CLIENT_02_074: [ If `uws_client` or `statistics` is NULL, `uws_client_get_ping_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_ping_statistics_with_NULL_handle_fails)
+{
+    // arrange
+    UWS_CLIENT_PING_STATISTICS statistics;
+    int result;
+
+    // act
+    result = uws_client_get_ping_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_02_074: [ If `uws_client` or `statistics` is NULL, `uws_client_get_ping_statistics` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_get_ping_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_ping_statistics(uws_client, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_075: [ Otherwise `uws_client_get_ping_statistics` shall fill `statistics` with the PING counters and round trip times of the current connection, the average being 0 while no round trip was measured, and return 0. ]*/
+TEST_FUNCTION(uws_client_get_ping_statistics_without_any_PONG_reports_no_round_trip)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    UWS_CLIENT_PING_STATISTICS statistics;
+    int result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_get_ping_statistics(uws_client, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.pings_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.pongs_received);
+    ASSERT_ARE_EQUAL(uint64_t, 0, statistics.rtt_avg_ms);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* send coalescing */
+
+/* Tests_SRS_UWS_CLIENT_02_105: [ When send coalescing is on and the header and payload of the frame fit in `UWS_CLIENT_COALESCE_BUFFER_SIZE` bytes, `uws_client_send_frame_async` shall encode the frame in the coalesce buffer instead of sending it. ]*/
+/* Tests_SRS_UWS_CLIENT_02_109: [ The first time a frame is coalesced a buffer of `UWS_CLIENT_COALESCE_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+/* Tests_SRS_UWS_CLIENT_02_112: [ The frame header shall be encoded at the end of the coalesce buffer by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and the reserved bits. ]*/
+/* Tests_SRS_UWS_CLIENT_02_114: [ The frame shall be queued in the pending sends by calling `singlylinkedlist_add`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_116: [ The payload shall be masked into the coalesce buffer right after the header by calling `uws_frame_encoder_mask` with the mask written in the header and a mask offset of 0. ]*/
+/* Tests_SRS_UWS_CLIENT_02_117: [ On success, `uws_client_send_frame_async` shall return 0 without calling `xio_send`. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_coalescing_encodes_the_frame_in_the_coalesce_buffer)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COALESCE_BUFFER_SIZE));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, TEST_COALESCE_BUFFER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0))
+        .ValidateArgumentBuffer(4, test_large_frame_header + sizeof(test_large_frame_header) - 4, 4);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_109: [ The first time a frame is coalesced a buffer of `UWS_CLIENT_COALESCE_BUFFER_SIZE` bytes shall be allocated and kept until the instance is destroyed. ]*/
+/* Tests_SRS_UWS_CLIENT_02_112: [ The frame header shall be encoded at the end of the coalesce buffer by calling `uws_frame_encoder_encode_header` with the frame type, `size`, `is_masked` set to true, the `is_final` flag and the reserved bits. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_coalescing_encodes_a_second_frame_after_the_first_one)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, TEST_COALESCE_BUFFER_SIZE - (sizeof(test_large_frame_header) + sizeof(test_payload)), WS_TEXT_FRAME, sizeof(test_payload), true, false, 0, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), false, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_110: [ If allocating the coalesce buffer fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_coalesce_buffer_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COALESCE_BUFFER_SIZE))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_115: [ If `singlylinkedlist_add` fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_queueing_a_coalesced_frame_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COALESCE_BUFFER_SIZE));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, TEST_COALESCE_BUFFER_SIZE, WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item()
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_107: [ If the frame does not fit in the space left in the coalesce buffer, the frames already coalesced shall be sent first. ]*/
+/* Tests_SRS_UWS_CLIENT_02_103: [ Sending the coalesced frames shall be done by calling `xio_send` once with the coalesce buffer, its used length, `on_underlying_io_coalesced_send_complete` as callback and the first coalesced frame as context. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_a_frame_that_does_not_fit_the_space_left_sends_the_coalesced_frames_first)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned char* test_payload = test_large_frame_payload;
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, 10000, true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + 10000, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, TEST_COALESCE_BUFFER_SIZE, WS_BINARY_FRAME, 10000, true, true, 0, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, 10000, IGNORED_PTR_ARG, 0));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, 10000, true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_106: [ Before a frame that is not coalesced is sent, the frames already coalesced shall be sent, so that frames go out in the order they were queued. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_a_frame_too_large_to_coalesce_sends_the_coalesced_frames_first)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_small_payload[] = { 0x42, 0x43 };
+    unsigned char* test_payload = test_large_frame_payload;
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_small_payload, sizeof(test_small_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + sizeof(test_small_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_SEND_SCRATCH_BUFFER_SIZE));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE, NULL, NULL));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload + TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header), TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, TEST_LARGE_FRAME_PAYLOAD_SIZE - (TEST_SEND_SCRATCH_BUFFER_SIZE - sizeof(test_large_frame_header)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_104: [ If `xio_send` fails and did not complete the send, all the coalesced frames shall be completed with `WS_SEND_FRAME_ERROR`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_108: [ If sending the frames already coalesced fails, `uws_client_send_frame_async` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_sending_the_coalesced_frames_ahead_of_a_large_frame_fails_uws_client_send_frame_async_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_small_payload[] = { 0x42, 0x43 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_small_payload, sizeof(test_small_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+    g_xio_send_result = 1;
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + sizeof(test_small_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_large_frame_payload, TEST_LARGE_FRAME_PAYLOAD_SIZE, true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_118: [ `uws_client_send_frame_in_place_async` shall not coalesce the frame, it shall send the frames already coalesced first. ]*/
+TEST_FUNCTION(uws_client_send_frame_in_place_async_sends_the_coalesced_frames_first)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_small_payload[] = { 0x42, 0x43 };
+    unsigned char test_payload[] = { 0x42, 0x43, 0x44 };
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_small_payload, sizeof(test_small_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + sizeof(test_small_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(IGNORED_PTR_ARG, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_TEXT_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(test_payload, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header), NULL, NULL));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, test_payload, sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    result = uws_client_send_frame_in_place_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_120: [ After `xio_dowork`, if frames were coalesced and the uws instance is OPEN, `uws_client_dowork` shall send them, so that the frames queued before and during the call go out together. ]*/
+/* Tests_SRS_UWS_CLIENT_02_103: [ Sending the coalesced frames shall be done by calling `xio_send` once with the coalesce buffer, its used length, `on_underlying_io_coalesced_send_complete` as callback and the first coalesced frame as context. ]*/
+TEST_FUNCTION(uws_client_dowork_sends_the_coalesced_frames_with_one_xio_send)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2 * (sizeof(test_large_frame_header) + sizeof(test_payload)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_on_io_send_complete);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_120: [ After `xio_dowork`, if frames were coalesced and the uws instance is OPEN, `uws_client_dowork` shall send them, so that the frames queued before and during the call go out together. ]*/
+TEST_FUNCTION(uws_client_dowork_without_coalesced_frames_does_not_send)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_098: [ All the coalesced frames shall be removed from the pending sends by calling `singlylinkedlist_remove` before any of their callbacks is called. ]*/
+/* Tests_SRS_UWS_CLIENT_02_099: [ Then, in the order the frames were queued, `on_ws_send_frame_complete` of each removed frame shall be called with its own context and the result of the send, and the memory associated with the frame shall be released like for `on_underlying_io_send_complete`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_102: [ When `on_underlying_io_coalesced_send_complete` is called, every frame that was part of the coalesced send shall be completed with the `IO_SEND_RESULT` mapped the same way as for `on_underlying_io_send_complete`. ]*/
+TEST_FUNCTION(when_the_coalesced_send_completes_every_frame_is_indicated_as_sent_in_order)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_OK));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_102: [ When `on_underlying_io_coalesced_send_complete` is called, every frame that was part of the coalesced send shall be completed with the `IO_SEND_RESULT` mapped the same way as for `on_underlying_io_send_complete`. ]*/
+TEST_FUNCTION(when_the_coalesced_send_completes_with_error_every_frame_is_indicated_with_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_ERROR));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_ERROR);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_100: [ If `singlylinkedlist_remove` fails for any of the frames an error shall be indicated by calling the `on_ws_error` callback with `WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST`. ]*/
+TEST_FUNCTION(when_removing_the_coalesced_frames_from_the_list_fails_then_an_error_is_indicated)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+    singlylinkedlist_remove_result = 1;
+
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST));
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_101: [ When `on_underlying_io_coalesced_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
+TEST_FUNCTION(when_the_coalesced_send_completes_with_NULL_context_nothing_happens)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    uws_client_dowork(uws_client);
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_io_send_complete(NULL, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_104: [ If `xio_send` fails and did not complete the send, all the coalesced frames shall be completed with `WS_SEND_FRAME_ERROR`. ]*/
+TEST_FUNCTION(when_sending_the_coalesced_frames_fails_in_uws_client_dowork_every_frame_is_indicated_with_error)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+    g_xio_send_result = 1;
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2 * (sizeof(test_large_frame_header) + sizeof(test_payload)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item_handle();
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_CANCELLED));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_ERROR));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_CANCELLED);
+    uws_client_dowork(uws_client);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5810,27 +10049,22 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_CANCELLED_indicates_the_frame_
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_435: [ When `on_underlying_io_send_complete` is called with a NULL `context`, it shall do nothing. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_NULL_context_does_nothing)
+/* Tests_SRS_UWS_CLIENT_02_096: [ The frames in the coalesce buffer shall be discarded, as their pending sends were cancelled. ]*/
+TEST_FUNCTION(uws_client_close_async_discards_the_coalesced_frames)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
 
-    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_close_async(uws_client, test_on_ws_close_complete, NULL);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+
     // act
-    g_on_io_send_complete(NULL, IO_SEND_CANCELLED);
+    uws_client_dowork(uws_client);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5839,96 +10073,187 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_NULL_context_does_nothing)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_436: [ When `on_underlying_io_send_complete` is called with any other error code, the send shall be indicated to the uws user by calling `on_ws_send_frame_complete` with `WS_SEND_FRAME_ERROR`. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_an_unknown_result_indicates_an_error)
+/* Tests_SRS_UWS_CLIENT_02_097: [ If frames were coalesced and the uws instance is OPEN, `uws_client_close_handshake_async` shall send them before the CLOSE frame, so that they reach the peer ahead of it. ]*/
+TEST_FUNCTION(uws_client_close_handshake_async_sends_the_coalesced_frames_before_the_close_frame)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_payload[] = { 0x42 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+    int result;
 
-    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_xio_send_completes_synchronously = true;
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
     STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
         .IgnoreArgument_item_handle();
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, (IO_SEND_RESULT)0x42);
+    result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x4445);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_client_dowork */
-
-/* Tests_SRS_UWS_CLIENT_01_059: [ If the `uws_client` argument is NULL, `uws_client_dowork` shall do nothing. ]*/
-TEST_FUNCTION(uws_client_dowork_with_NULL_handle_does_nothing)
+/* Tests_SRS_UWS_CLIENT_02_158: [ When the pending sends are cancelled, frames already passed to `xio_send` shall only be removed from the pending sends by calling `singlylinkedlist_remove`, and shall not be reused before the underlying IO completes their send. ]*/
+/* Tests_SRS_UWS_CLIENT_02_160: [ Coalesced frames shall be completed and released by `on_underlying_io_coalesced_send_complete`. ]*/
+TEST_FUNCTION(uws_client_close_handshake_async_leaves_the_coalesced_frames_it_sent_to_their_send_completion)
 {
     // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    unsigned char close_frame_payload[] = { 0x03, 0xEA };
+    unsigned char close_frame[] = { 0x88, 0x82, 0x00, 0x00, 0x00, 0x00, 0x03, 0xEA };
+    BUFFER_HANDLE buffer_handle;
+    int result;
+
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, 2 * (sizeof(test_large_frame_header) + sizeof(test_payload)), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, close_frame, sizeof(close_frame), NULL, NULL))
+        .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
-    uws_client_dowork(NULL);
+    result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x4445);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_pending_on_io_send_complete);
+
+    // the coalesced send completes after the close call returned
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_OK));
+
+    g_pending_on_io_send_complete(g_pending_on_io_send_complete_context, IO_SEND_OK);
+
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_430: [ `uws_client_dowork` shall call `xio_dowork` with the IO handle argument set to the underlying IO created in `uws_client_create`. ]*/
-TEST_FUNCTION(uws_client_dowork_calls_the_underlying_io_dowork)
+/* Tests_SRS_UWS_CLIENT_02_158: [ When the pending sends are cancelled, frames already passed to `xio_send` shall only be removed from the pending sends by calling `singlylinkedlist_remove`, and shall not be reused before the underlying IO completes their send. ]*/
+/* Tests_SRS_UWS_CLIENT_02_160: [ Coalesced frames shall be completed and released by `on_underlying_io_coalesced_send_complete`. ]*/
+TEST_FUNCTION(uws_client_close_async_leaves_the_coalesced_frames_in_flight_to_their_send_completion)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-
-    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    uws_client_dowork(uws_client);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4249);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
+        .IgnoreArgument_item_handle();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_CANCELLED));
+    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
-    uws_client_dowork(uws_client);
+    result = uws_client_close_async(uws_client, test_on_ws_close_complete, (void*)0x4445);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // the coalesced send completes after the close call returned
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+
+    g_pending_on_io_send_complete(g_pending_on_io_send_complete_context, IO_SEND_CANCELLED);
+
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, `uws_client_dowork` shall do nothing. ]*/
-TEST_FUNCTION(uws_client_dowork_when_closed_does_nothing)
+/* Tests_SRS_UWS_CLIENT_02_158: [ When the pending sends are cancelled, frames already passed to `xio_send` shall only be removed from the pending sends by calling `singlylinkedlist_remove`, and shall not be reused before the underlying IO completes their send. ]*/
+/* Tests_SRS_UWS_CLIENT_02_159: [ Such a frame that was not coalesced shall be indicated as cancelled right away, and its send completion shall only release it. ]*/
+TEST_FUNCTION(a_send_completion_arriving_after_uws_client_close_async_does_not_indicate_the_frame_again)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     UWS_CLIENT_HANDLE uws_client;
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    unsigned char test_payload[] = { 0x42 };
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_close_async(uws_client, test_on_ws_close_complete, (void*)0x4445);
     umock_c_reset_all_calls();
 
     // act
-    uws_client_dowork(uws_client);
+    g_pending_on_io_send_complete(g_pending_on_io_send_complete_context, IO_SEND_OK);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -5937,157 +10262,118 @@ TEST_FUNCTION(uws_client_dowork_when_closed_does_nothing)
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_error */
+/* uws_setoption */
 
-/* Tests_SRS_UWS_CLIENT_01_375: [ When `on_underlying_io_error` is called while uws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_UNDERLYING_IO_ERROR`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_077: [ If this fails (e.g., the server's certificate could not be verified), then the client MUST _Fail the WebSocket Connection_ and abort the connection. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_opening_underlying_io_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments `uws_client` or `option_name` is NULL `uws_client_set_option` shall return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_NULL_uws_handle_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
-    UWS_CLIENT_HANDLE uws_client;
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-
-    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
+    int result;
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(NULL, "test_option", (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_375: [ When `on_underlying_io_error` is called while uws is OPENING, uws shall report that the open failed by calling the `on_ws_open_complete` callback passed to `uws_client_open_async` with `WS_OPEN_ERROR_UNDERLYING_IO_ERROR`. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_waiting_for_upgrade_response_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments `uws_client` or `option_name` is NULL `uws_client_set_option` shall return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_NULL_option_name_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
-
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(uws_client, NULL, (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_376: [ When `on_underlying_io_error` is called while the uws instance is OPEN, an error shall be reported to the user by calling the `on_ws_error` callback that was passed to `uws_client_open_async` with the argument `WS_ERROR_UNDERLYING_IO_ERROR`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_318: [ Servers MAY close the WebSocket connection whenever desired. ]*/
-/* Tests_SRS_UWS_CLIENT_01_269: [ If at any point the state of the WebSocket connection changes, the endpoint MUST abort the following steps. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_OPEN_indicates_an_error)
+/* Tests_SRS_UWS_CLIENT_01_510: [ If the option name is `uWSClientOptions` then `uws_client_set_option` shall call `OptionHandler_FeedOptions` and pass to it the underlying IO handle and the `value` argument. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_uws_client_options_calls_OptionHandler_FeedOptions)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE));
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_indicates_an_error)
+/* Tests_SRS_UWS_CLIENT_01_511: [ If `OptionHandler_FeedOptions` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_then_uws_set_option_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE))
+        .SetReturn(OPTIONHANDLER_ERROR);
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
-TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
+/* Tests_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling `xio_setoption`. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_passes_the_option_down)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
     int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_error(g_on_io_error_context);
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242));
 
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -6097,73 +10383,46 @@ TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_499: [ If the CLOSE was due to the peer closing, the callback `on_ws_close_complete` shall not be called. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_underlying_io_indicates_the_close)
+/* Tests_SRS_UWS_CLIENT_01_443: [ If `xio_setoption` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_setoption_fails_then_uws_set_option_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_io_close_complete();
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242))
+        .SetReturn(1);
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When `on_underlying_io_error` is called while the uws instance is CLOSING the underlying IO shall be closed by calling `xio_close`. ]*/
-TEST_FUNCTION(open_after_error_during_closing_underlying_io_succeeds)
+/* Tests_SRS_UWS_CLIENT_02_040: [ If the option name is `ws_max_message_size`, `value` shall be treated as a pointer to a `size_t` holding the maximum size of a received message and `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_max_message_size_does_not_pass_the_option_down)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    size_t max_message_size = 1024;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
-    g_on_io_error(g_on_io_error_context);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
-
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    result = uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -6173,479 +10432,317 @@ TEST_FUNCTION(open_after_error_during_closing_underlying_io_succeeds)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_500: [ If `xio_close` fails then the callback `on_ws_close_complete` shall be called, while passing the `on_ws_close_complete_context` argument to it. ]*/
-/* Tests_SRS_UWS_CLIENT_01_500: [ The callback `on_ws_close_complete` shall be called, while passing the `on_ws_close_complete_context` argument to it. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_due_to_local_initiated_close)
+/* Tests_SRS_UWS_CLIENT_02_041: [ If the option name is `ws_max_message_size` and `value` is NULL or points to 0, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_max_message_size_and_NULL_value_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    (void)uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x6666);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context()
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(test_on_ws_close_complete((void*)0x6666));
-
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_set_option(uws_client, "ws_max_message_size", NULL);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_close_sent */
-
-/* Tests_SRS_UWS_CLIENT_01_489: [ When `on_underlying_io_close_sent` is called with NULL context, it shall do nothing. ]*/
-TEST_FUNCTION(on_underlying_io_close_sent_with_NULL_context_does_nothing)
+/* Tests_SRS_UWS_CLIENT_02_041: [ If the option name is `ws_max_message_size` and `value` is NULL or points to 0, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_max_message_size_0_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    size_t max_message_size = 0;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
     // act
-    g_on_io_send_complete(NULL, IO_SEND_OK);
+    result = uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_490: [ When `on_underlying_io_close_sent` is called while the uws client is CLOSING, `on_underlying_io_close_sent` shall close the underlying IO by calling `xio_close`. ]*/
-TEST_FUNCTION(on_underlying_io_close_sent_when_a_CLOSE_was_sent_closes_the_underlying_IO)
+/* Tests_SRS_UWS_CLIENT_02_065: [ If the option name is `ws_permessage_deflate`, `value` shall be treated as a pointer to a `WS_PERMESSAGE_DEFLATE_OPTIONS`, which shall be copied and offered in the upgrade request of every following open, and `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_permessage_deflate_does_not_pass_the_option_down)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 15, 15, false, false, 6 };
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context();
-
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    result = uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_493: [ If calling `xio_close` fails, the state of the uws client shall be considered CLOSED and the `on_ws_close_complete` shall be called if it was specified. ]*/
-/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no `on_ws_close_complete` shall be called. ]*/
-TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered)
+/* Tests_SRS_UWS_CLIENT_02_066: [ If the option name is `ws_permessage_deflate` and `value` is NULL or holds a client window outside 9..15 bits, a server window outside 8..15 bits or a compression level outside -1..9, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_permessage_deflate_and_NULL_value_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context()
-        .SetReturn(1);
-
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    result = uws_client_set_option(uws_client, "ws_permessage_deflate", NULL);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_493: [ If calling `xio_close` fails, the state of the uws client shall be considered CLOSED and the `on_ws_close_complete` shall be called if it was specified. ]*/
-/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no `on_ws_close_complete` shall be called. ]*/
-TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered_and_next_open_succeeds)
+/* Tests_SRS_UWS_CLIENT_02_066: [ If the option name is `ws_permessage_deflate` and `value` is NULL or holds a client window outside 9..15 bits, a server window outside 8..15 bits or a compression level outside -1..9, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_permessage_deflate_and_a_client_window_of_8_bits_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 8, 15, false, false, 6 };
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context()
-        .SetReturn(1);
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
-
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    result = uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Ping frame */
-
-/* Tests_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
-/* Tests_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
-/* Tests_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
-/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
-/* Tests_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
-/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
-TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
+/* Tests_SRS_UWS_CLIENT_02_089: [ When a non-zero ping interval is set for the first time, a tick counter shall be created by calling `tickcounter_create`. ]*/
+/* Tests_SRS_UWS_CLIENT_02_091: [ If the option name is `ws_ping_interval_ms`, `value` shall be treated as a pointer to an `unsigned int` holding the interval in milliseconds at which `uws_client_dowork` sends keepalive PINGs, 0 turning them off, and `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_ping_interval_ms_creates_a_tick_counter)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char ping_frame[] = { 0x89, 0x00 };
-    unsigned char pong_frame[] = { 0x8A, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    BUFFER_HANDLE buffer_handle;
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    unsigned int ping_interval_ms = 1000;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
-        .IgnoreArgument_payload()
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(pong_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), NULL, NULL))
-        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(tickcounter_create());
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+    result = uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
-/* Tests_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
-TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_sent_with_the_Same_payload)
+/* Tests_SRS_UWS_CLIENT_02_089: [ When a non-zero ping interval is set for the first time, a tick counter shall be created by calling `tickcounter_create`. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_ping_interval_ms_a_second_time_reuses_the_tick_counter)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char ping_frame[] = { 0x89, 0x02, 0x42, 0x43 };
-    unsigned char pong_frame_payload[] = { 0x42, 0x43 };
-    unsigned char pong_frame[] = { 0x8A, 0x02, 0x00, 0x00, 0x00, 0x00, 0x42, 0x43 };
-    BUFFER_HANDLE buffer_handle;
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
+    unsigned int ping_interval_ms = 1000;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    (void)uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
     umock_c_reset_all_calls();
-
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
-        .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(pong_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), NULL, NULL))
-        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    ping_interval_ms = 2000;
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+    result = uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
-/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
-TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
+/* Tests_SRS_UWS_CLIENT_02_090: [ If `tickcounter_create` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_uws_set_option_with_ws_ping_interval_ms_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_and_ping_frames[] = { 0x88, 0x00, 0x89, 0x02, 0x42, 0x43 };
-    BUFFER_HANDLE buffer_handle;
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
-
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
+    unsigned int ping_interval_ms = 1000;
+    int result;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    EXPECTED_CALL(test_on_ws_peer_closed(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)close_and_ping_frames, sizeof(close_and_ping_frames));
+    result = uws_client_set_option(uws_client, "ws_ping_interval_ms", &ping_interval_ms);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_setoption */
-
-/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments `uws_client` or `option_name` is NULL `uws_client_set_option` shall return a non-zero value. ]*/
-TEST_FUNCTION(uws_set_option_with_NULL_uws_handle_fails)
+/* Tests_SRS_UWS_CLIENT_02_088: [ If the option name is `ws_ping_interval_ms` or `ws_pong_timeout_ms` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_ping_interval_ms_and_NULL_value_fails)
 {
     // arrange
+    UWS_CLIENT_HANDLE uws_client;
     int result;
 
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
     // act
-    result = uws_client_set_option(NULL, "test_option", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_ping_interval_ms", NULL);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments `uws_client` or `option_name` is NULL `uws_client_set_option` shall return a non-zero value. ]*/
-TEST_FUNCTION(uws_set_option_with_NULL_option_name_fails)
+/* Tests_SRS_UWS_CLIENT_02_092: [ If the option name is `ws_pong_timeout_ms`, `value` shall be treated as a pointer to an `unsigned int` holding how many milliseconds a keepalive PING may stay unanswered, 0 turning the check off, and `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_pong_timeout_ms_succeeds)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    unsigned int pong_timeout_ms = 500;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     umock_c_reset_all_calls();
 
     // act
-    result = uws_client_set_option(uws_client, NULL, (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_pong_timeout_ms", &pong_timeout_ms);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_510: [ If the option name is `uWSClientOptions` then `uws_client_set_option` shall call `OptionHandler_FeedOptions` and pass to it the underlying IO handle and the `value` argument. ]*/
-/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
-TEST_FUNCTION(uws_set_option_with_uws_client_options_calls_OptionHandler_FeedOptions)
+/* Tests_SRS_UWS_CLIENT_02_088: [ If the option name is `ws_ping_interval_ms` or `ws_pong_timeout_ms` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_pong_timeout_ms_and_NULL_value_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE));
-
     // act
-    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_pong_timeout_ms", NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_511: [ If `OptionHandler_FeedOptions` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_then_uws_set_option_fails)
+/* Tests_SRS_UWS_CLIENT_02_122: [ If the option name is `ws_coalesce_sends`, `value` shall be treated as a pointer to a `bool` turning send coalescing on or off and `uws_client_set_option` shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_coalesce_sends_succeeds)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    bool coalesce_sends = true;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE))
-        .SetReturn(OPTIONHANDLER_ERROR);
-
     // act
-    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_coalesce_sends", &coalesce_sends);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling `xio_setoption`. ]*/
-/* Tests_SRS_UWS_CLIENT_01_442: [ On success, `uws_client_set_option` shall return 0. ]*/
-TEST_FUNCTION(uws_set_option_passes_the_option_down)
+/* Tests_SRS_UWS_CLIENT_02_121: [ If the option name is `ws_coalesce_sends` and `value` is NULL, `uws_client_set_option` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_ws_coalesce_sends_and_NULL_value_fails)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242));
-
     // act
-    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_coalesce_sends", NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_443: [ If `xio_setoption` fails, `uws_client_set_option` shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_xio_setoption_fails_then_uws_set_option_fails)
+/* Tests_SRS_UWS_CLIENT_02_123: [ When send coalescing is turned off while the uws instance is OPEN, the frames already coalesced shall be sent. ]*/
+TEST_FUNCTION(uws_set_option_turning_ws_coalesce_sends_off_sends_the_coalesced_frames)
 {
     // arrange
-    TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    const unsigned char test_payload[] = { 0x42, 0x43 };
+    bool coalesce_sends = false;
     int result;
 
-    tlsio_config.hostname = "test_host";
-    tlsio_config.port = 444;
-    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    uws_client = create_open_uws_client_with_coalescing();
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242))
-        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_large_frame_header) + sizeof(test_payload), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context();
 
     // act
-    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_coalesce_sends", &coalesce_sends);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -6786,6 +10883,94 @@ TEST_FUNCTION(when_OptionHandler_AddOption_fails_then_uws_retrieve_options_fails
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_02_043: [ If a maximum message size was set, `uws_client_retrieve_options` shall also add the option `ws_max_message_size` with the current maximum message size. ]*/
+TEST_FUNCTION(uws_retrieve_options_adds_ws_max_message_size_when_it_was_set)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+    size_t max_message_size = 1024;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_max_message_size", IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, &max_message_size, sizeof(max_message_size));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_125: [ If send coalescing is on, `uws_client_retrieve_options` shall also add the option `ws_coalesce_sends`. ]*/
+TEST_FUNCTION(uws_retrieve_options_adds_ws_coalesce_sends_when_it_is_on)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+    bool coalesce_sends = true;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_coalesce_sends", &coalesce_sends);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_coalesce_sends", IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, &coalesce_sends, sizeof(coalesce_sends));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_505: [ If `OptionHandler_AddOption` fails, `uws_client_retrieve_options` shall fail and return NULL. ]*/
+TEST_FUNCTION(when_adding_ws_max_message_size_fails_then_uws_retrieve_options_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+    size_t max_message_size = 1024;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_max_message_size", &max_message_size);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_max_message_size", IGNORED_PTR_ARG))
+        .SetReturn(OPTIONHANDLER_ERROR);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* uws_client_clone_option */
 
 /* Tests_SRS_UWS_CLIENT_01_507: [ `uws_client_clone_option` called with `name` being `uWSClientOptions` shall return the same value. ]*/
@@ -6888,6 +11073,146 @@ TEST_FUNCTION(uws_client_clone_option_with_NULL_value_fails)
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_02_044: [ `uws_client_clone_option` called with `name` being `ws_max_message_size` shall return a newly allocated copy of the `size_t` pointed to by `value`. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_max_message_size_copies_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t max_message_size = 1024;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(size_t)));
+
+    // act
+    result = g_clone_option("ws_max_message_size", &max_message_size);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &max_message_size, result);
+    ASSERT_ARE_EQUAL(size_t, max_message_size, *(size_t*)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option("ws_max_message_size", result);
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_045: [ If allocating the copy fails, `uws_client_clone_option` shall return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_copy_fails_uws_client_clone_option_with_ws_max_message_size_fails)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t max_message_size = 1024;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(size_t)))
+        .SetReturn(NULL);
+
+    // act
+    result = g_clone_option("ws_max_message_size", &max_message_size);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_068: [ `uws_client_clone_option` called with `name` being `ws_permessage_deflate` shall return a newly allocated copy of the `WS_PERMESSAGE_DEFLATE_OPTIONS` pointed to by `value`. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_permessage_deflate_copies_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options = { 12, 10, true, false, 6 };
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS)));
+
+    // act
+    result = g_clone_option("ws_permessage_deflate", &permessage_deflate_options);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &permessage_deflate_options, result);
+    ASSERT_ARE_EQUAL(int, 12, ((WS_PERMESSAGE_DEFLATE_OPTIONS*)result)->client_max_window_bits);
+    ASSERT_ARE_EQUAL(int, 10, ((WS_PERMESSAGE_DEFLATE_OPTIONS*)result)->server_max_window_bits);
+    ASSERT_IS_TRUE(((WS_PERMESSAGE_DEFLATE_OPTIONS*)result)->client_no_context_takeover);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option("ws_permessage_deflate", result);
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_093: [ `uws_client_clone_option` called with `name` being `ws_ping_interval_ms` or `ws_pong_timeout_ms` shall return a newly allocated copy of the `unsigned int` pointed to by `value`. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_ping_interval_ms_copies_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    unsigned int ping_interval_ms = 1000;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(unsigned int)));
+
+    // act
+    result = g_clone_option("ws_ping_interval_ms", &ping_interval_ms);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &ping_interval_ms, result);
+    ASSERT_ARE_EQUAL(int, 1000, (int)*(unsigned int*)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option("ws_ping_interval_ms", result);
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_02_124: [ `uws_client_clone_option` called with `name` being `ws_coalesce_sends` shall return a newly allocated copy of the `bool` pointed to by `value`. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_coalesce_sends_copies_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    bool coalesce_sends = true;
+    void* result;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(bool)));
+
+    // act
+    result = g_clone_option("ws_coalesce_sends", &coalesce_sends);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &coalesce_sends, result);
+    ASSERT_IS_TRUE(*(bool*)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option("ws_coalesce_sends", result);
+    uws_client_destroy(uws_client);
+}
+
 /* uws_client_destroy_option */
 
 /* Tests_SRS_UWS_CLIENT_01_509: [ If `uws_client_destroy_option` is called with NULL `name` or `value` it shall do nothing. ]*/
@@ -6984,6 +11309,31 @@ TEST_FUNCTION(uws_client_destroy_option_with_uWSClientOptions_calls_OptionHandle
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_02_046: [ `uws_client_destroy_option` called with the option `name` being `ws_max_message_size` shall free the value. ]*/
+TEST_FUNCTION(uws_client_destroy_option_with_ws_max_message_size_frees_the_value)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    size_t max_message_size = 1024;
+    void* cloned_value;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    cloned_value = g_clone_option("ws_max_message_size", &max_message_size);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(cloned_value));
+
+    // act
+    g_destroy_option("ws_max_message_size", cloned_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* on_underlying_io_close_complete */
 
 /* Tests_SRS_UWS_CLIENT_01_475: [ When `on_underlying_io_close_complete` is called while closing the underlying IO a subsequent `uws_client_open_async` shall succeed. ]*/
@@ -6992,7 +11342,7 @@ TEST_FUNCTION(underlying_io_close_after_a_send_close_frame_failed_puts_the_uws_i
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
     uint16_t expected_close_code = 1002;
     int result;
@@ -7006,7 +11356,6 @@ TEST_FUNCTION(underlying_io_close_after_a_send_close_frame_failed_puts_the_uws_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7045,7 +11394,7 @@ TEST_FUNCTION(underlying_io_close_due_to_CLOSE_frame_being_received_doe_not_trig
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
     uint16_t expected_close_code = 1002;
 
@@ -7058,7 +11407,6 @@ TEST_FUNCTION(underlying_io_close_due_to_CLOSE_frame_being_received_doe_not_trig
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7087,7 +11435,7 @@ TEST_FUNCTION(underlying_io_close_complete_with_NULL_context_does_nothing)
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
     uint16_t expected_close_code = 1002;
     int result;
@@ -7101,7 +11449,6 @@ TEST_FUNCTION(underlying_io_close_complete_with_NULL_context_does_nothing)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7132,7 +11479,7 @@ TEST_FUNCTION(when_close_complete_is_called_the_user_callback_is_triggered)
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
 
     tlsio_config.hostname = "test_host";
@@ -7165,7 +11512,7 @@ TEST_FUNCTION(when_close_complete_is_called_and_the_user_callback_is_NULL_no_cal
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n" TEST_SEC_WEBSOCKET_ACCEPT_HEADER "\r\n";
     unsigned char close_frame[] = { 0x88, 0x02, 0x03, 0xEA };
 
     tlsio_config.hostname = "test_host";
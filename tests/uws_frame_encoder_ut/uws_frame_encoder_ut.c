@@ -5,11 +5,13 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -1420,4 +1422,293 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_
     real_BUFFER_delete(result);
 }
 
+/* Tests_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_masks_a_1000_byte_frame)
+{
+    // arrange
+    BUFFER_HANDLE result;
+    BUFFER_HANDLE newly_created_buffer;
+    unsigned char payload[1000];
+    const unsigned char* encoded;
+    size_t i;
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)(i * 7);
+    }
+
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_enlarge(IGNORED_PTR_ARG, 8 + sizeof(payload)))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x12);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x34);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x56);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x78);
+
+    // act
+    result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, 8 + sizeof(payload), real_BUFFER_length(result));
+    encoded = real_BUFFER_u_char(result);
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        ASSERT_ARE_EQUAL(int, (int)(unsigned char)(payload[i] ^ encoded[4 + (i % 4)]), (int)encoded[8 + i]);
+    }
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    real_BUFFER_delete(result);
+}
+
+/* uws_frame_encoder_encode_header */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_004: [ `uws_frame_encoder_encode_header` shall write into `header` the frame header that `uws_frame_encoder_encode` would produce for the same `opcode`, `length`, `is_masked`, `is_final` and `reserved`, without any payload bytes. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_02_009: [ When `is_masked` is true the masking key shall be the last 4 bytes of the header. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_02_010: [ On success `uws_frame_encoder_encode_header` shall store the number of header bytes in `header_length` and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_encodes_a_masked_65536_byte_binary_frame_header)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    const unsigned char expected_header[] = { 0x82, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x12, 0x34, 0x56, 0x78 };
+    size_t header_length = 0;
+    int result;
+
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x12);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x34);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x56);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x78);
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 65536, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_header), header_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_header, header, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_004: [ `uws_frame_encoder_encode_header` shall write into `header` the frame header that `uws_frame_encoder_encode` would produce for the same `opcode`, `length`, `is_masked`, `is_final` and `reserved`, without any payload bytes. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_02_010: [ On success `uws_frame_encoder_encode_header` shall store the number of header bytes in `header_length` and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_encodes_an_unmasked_126_byte_text_frame_header)
+{
+    // arrange
+    unsigned char header[4];
+    const unsigned char expected_header[] = { 0x51, 0x7E, 0x00, 0x7E };
+    size_t header_length = 0;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_TEXT_FRAME, 126, false, false, RESERVED_1 | RESERVED_3, &header_length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_header), header_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_header, header, sizeof(expected_header)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_005: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_fails)
+{
+    // arrange
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(NULL, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, WS_BINARY_FRAME, 1, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_005: [ If `header` or `header_length` is NULL, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_length_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 1, true, true, 0, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_006: [ If `reserved` has any bits set except the lowest 3 then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_bad_reserved_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), WS_BINARY_FRAME, 1, true, true, 0x08, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_007: [ If `opcode` is greater than 0x0F then `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_bad_opcode_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, sizeof(header), (WS_FRAME_TYPE)0x10, 1, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_008: [ If `header_size` is smaller than the header needed for `length` and `is_masked`, `uws_frame_encoder_encode_header` shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_too_small_header_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_length;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(header, 7, WS_BINARY_FRAME, 126, true, true, 0, &header_length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_encoder_mask */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_001: [ `uws_frame_encoder_mask` shall XOR each of the `length` octets of `source` with octet (`offset` + i) modulo 4 of `mask_key` and write the result to `destination`. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_masks_every_length_and_offset)
+{
+    // arrange
+    unsigned char mask_key[] = { 0x01, 0x80, 0xA5, 0xFF };
+    unsigned char source[150];
+    unsigned char destination[150];
+    size_t length;
+    size_t offset;
+    size_t i;
+
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 13);
+    }
+
+    for (offset = 0; offset < 8; offset++)
+    {
+        /* covers the vector, 64 bit and byte by byte parts and every way they can follow each other */
+        for (length = 0; length <= sizeof(source); length++)
+        {
+            (void)memset(destination, 0xCC, sizeof(destination));
+
+            // act
+            uws_frame_encoder_mask(destination, source, length, mask_key, offset);
+
+            // assert
+            for (i = 0; i < length; i++)
+            {
+                ASSERT_ARE_EQUAL(int, (int)(unsigned char)(source[i] ^ mask_key[(offset + i) % 4]), (int)destination[i]);
+            }
+            for (; i < sizeof(destination); i++)
+            {
+                ASSERT_ARE_EQUAL(int, 0xCC, (int)destination[i]);
+            }
+        }
+    }
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_001: [ `uws_frame_encoder_mask` shall XOR each of the `length` octets of `source` with octet (`offset` + i) modulo 4 of `mask_key` and write the result to `destination`. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_works_on_unaligned_buffers)
+{
+    // arrange
+    unsigned char mask_key[] = { 0x42, 0x43, 0x44, 0x45 };
+    unsigned char source[100];
+    unsigned char destination[100];
+    size_t i;
+
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)i;
+    }
+
+    // act
+    uws_frame_encoder_mask(destination + 3, source + 1, 90, mask_key, 0);
+
+    // assert
+    for (i = 0; i < 90; i++)
+    {
+        ASSERT_ARE_EQUAL(int, (int)(unsigned char)(source[1 + i] ^ mask_key[i % 4]), (int)destination[3 + i]);
+    }
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_003: [ `destination` may be the same as `source`, in which case the bytes shall be masked in place. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_040: [ The same algorithm applies regardless of the direction of the translation, e.g., the same steps are applied to mask the data as to unmask the data. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_in_place_twice_gives_back_the_original_bytes)
+{
+    // arrange
+    unsigned char mask_key[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    unsigned char original[77];
+    unsigned char bytes[77];
+    size_t i;
+
+    for (i = 0; i < sizeof(original); i++)
+    {
+        original[i] = (unsigned char)(0xFF - i);
+    }
+    (void)memcpy(bytes, original, sizeof(bytes));
+
+    // act
+    uws_frame_encoder_mask(bytes, bytes, sizeof(bytes), mask_key, 2);
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        ASSERT_ARE_EQUAL(int, (int)(unsigned char)(original[i] ^ mask_key[(2 + i) % 4]), (int)bytes[i]);
+    }
+    uws_frame_encoder_mask(bytes, bytes, sizeof(bytes), mask_key, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, memcmp(original, bytes, sizeof(bytes)));
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_02_002: [ If `length` is greater than 0 and any of `destination`, `source` or `mask_key` is NULL, `uws_frame_encoder_mask` shall do nothing. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_NULL_arguments_does_nothing)
+{
+    // arrange
+    unsigned char mask_key[] = { 0x01, 0x02, 0x03, 0x04 };
+    unsigned char source[] = { 0x10, 0x20, 0x30, 0x40 };
+    unsigned char destination[] = { 0xCC, 0xCC, 0xCC, 0xCC };
+
+    // act
+    uws_frame_encoder_mask(NULL, source, sizeof(source), mask_key, 0);
+    uws_frame_encoder_mask(destination, NULL, sizeof(source), mask_key, 0);
+    uws_frame_encoder_mask(destination, source, sizeof(source), NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0xCC, (int)destination[0]);
+    ASSERT_ARE_EQUAL(int, 0xCC, (int)destination[3]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(uws_frame_encoder_ut)
@@ -40,6 +40,7 @@ static void my_gballoc_free(void* s)
 
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -80,6 +81,7 @@ MOCKABLE_FUNCTION(,RSA *,PEM_read_bio_RSAPrivateKey, BIO *,bp, RSA **,x, pem_pas
 MOCKABLE_FUNCTION(,int, SSL_CTX_use_RSAPrivateKey, SSL_CTX *,ctx, RSA *,rsa);
 MOCKABLE_FUNCTION(,int, SSL_CTX_use_certificate, SSL_CTX *,ctx, X509*, x);
 MOCKABLE_FUNCTION(, X509_STORE *, SSL_CTX_get_cert_store, const SSL_CTX *, ssl_ctx);
+MOCKABLE_FUNCTION(, int, SSL_CTX_set_default_verify_paths, SSL_CTX *, ctx);
 
 /*from openssl/err.h*/
 MOCKABLE_FUNCTION(,unsigned long, ERR_get_error);
@@ -88,6 +90,7 @@ MOCKABLE_FUNCTION(, unsigned long, ERR_peek_error);
 
 /*from openssl/x509_vfy.h*/
 MOCKABLE_FUNCTION(,int, X509_STORE_add_cert, X509_STORE *, ctx, X509 *, x);
+MOCKABLE_FUNCTION(, int, X509_STORE_set_default_paths, X509_STORE *, ctx);
 
 typedef void (*x509_FREE_FUNC)(void*);
 MOCKABLE_FUNCTION(, void, sk_pop_free, _STACK*, st, x509_FREE_FUNC, free_func);
@@ -161,6 +164,9 @@ static RSA * my_PEM_read_bio_RSAPrivateKey(BIO * bp, RSA ** x, pem_password_cb *
     return (RSA*)my_gballoc_malloc(sizeof(RSA));
 }
 
+TEST_DEFINE_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -176,6 +182,7 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 #define TEST_X509_STORE (X509_STORE *)"le store"
 #define TEST_BIO_METHOD (BIO_METHOD*)"le method"
 #define TEST_BIO (BIO*)"le bio"
+#define TEST_LOCK_HANDLE (LOCK_HANDLE)0x4246
 
 static const char* TEST_PUBLIC_CERTIFICATE = "PUBLIC CERTIFICATE";
 static const char* TEST_PRIVATE_CERTIFICATE = "PRIVATE KEY";
@@ -218,6 +225,8 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         
         REGISTER_GLOBAL_MOCK_RETURNS(SSL_CTX_get_cert_store, TEST_X509_STORE, NULL);
         REGISTER_GLOBAL_MOCK_RETURNS(X509_STORE_add_cert, __LINE__, 0);
+        REGISTER_GLOBAL_MOCK_RETURNS(X509_STORE_set_default_paths, 1, 0);
+        REGISTER_GLOBAL_MOCK_RETURNS(SSL_CTX_set_default_verify_paths, 1, 0);
         
         REGISTER_GLOBAL_MOCK_RETURNS(SSL_CTX_use_RSAPrivateKey, 1, 0);
 
@@ -230,6 +239,13 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         REGISTER_GLOBAL_MOCK_HOOK(PEM_read_bio_X509_AUX, my_PEM_read_bio_X509_AUX);
         REGISTER_GLOBAL_MOCK_RETURNS(SSL_CTX_use_PrivateKey, 1, 0);
         REGISTER_GLOBAL_MOCK_HOOK(SSL_CTX_ctrl, my_SSL_CTX_ctrl);
+
+        REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -607,6 +623,144 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         //clean
     }
 
+    /*Tests_SRS_X509_OPENSSL_02_022: [ If ssl_ctx or certificates is NULL then x509_openssl_use_shared_certificates shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_use_shared_certificates_with_NULL_certificates_fails)
+    {
+        ///arrange
+        int result;
+
+        ///act
+        result = x509_openssl_use_shared_certificates(TEST_SSL_CTX, NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_023: [ If the cache is not initialized, x509_openssl_use_shared_certificates shall behave like x509_openssl_add_certificates. ]*/
+    /*Tests_SRS_X509_OPENSSL_02_030: [ When the store of ssl_ctx is not shared, x509_openssl_use_shared_certificates shall load the default locations for CA certificates into it with SSL_CTX_set_default_verify_paths. ]*/
+    TEST_FUNCTION(x509_openssl_use_shared_certificates_without_cache_adds_the_certificates)
+    {
+        ///arrange
+        int result;
+
+        x509_openssl_add_certificates_1_certificate_which_exists_inert_path();
+        STRICT_EXPECTED_CALL(SSL_CTX_set_default_verify_paths(TEST_SSL_CTX));
+
+        ///act
+        result = x509_openssl_use_shared_certificates(TEST_SSL_CTX, TEST_CERTIFICATE_1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+#if (OPENSSL_VERSION_NUMBER < 0x10101000L) || defined(LIBRESSL_VERSION_NUMBER)
+    /*Tests_SRS_X509_OPENSSL_02_025: [ If the OpenSSL in use cannot share a certificate store between contexts, x509_openssl_use_shared_certificates shall add the cached certificates to the store of ssl_ctx instead. ]*/
+    /*Tests_SRS_X509_OPENSSL_02_030: [ When the store of ssl_ctx is not shared, x509_openssl_use_shared_certificates shall load the default locations for CA certificates into it with SSL_CTX_set_default_verify_paths. ]*/
+    TEST_FUNCTION(x509_openssl_use_shared_certificates_with_cache_adds_the_cached_certificates_and_the_default_paths)
+    {
+        ///arrange
+        int result;
+
+        STRICT_EXPECTED_CALL(Lock_Init());
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_cache_init());
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((void*)TEST_CERTIFICATE_1, -1));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(ERR_peek_last_error());
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(SSL_CTX_get_cert_store(TEST_SSL_CTX));
+        STRICT_EXPECTED_CALL(X509_STORE_add_cert(TEST_X509_STORE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(SSL_CTX_set_default_verify_paths(TEST_SSL_CTX));
+
+        ///act
+        result = x509_openssl_use_shared_certificates(TEST_SSL_CTX, TEST_CERTIFICATE_1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+        x509_openssl_cache_deinit();
+    }
+#endif
+
+    /*Tests_SRS_X509_OPENSSL_02_027: [ If creating the lock fails, x509_openssl_cache_init shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_cache_init_when_Lock_Init_fails_fails)
+    {
+        ///arrange
+        int result;
+
+        STRICT_EXPECTED_CALL(Lock_Init())
+            .SetReturn(NULL);
+
+        ///act
+        result = x509_openssl_cache_init();
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
+    /*Tests_SRS_X509_OPENSSL_02_026: [ x509_openssl_cache_init shall create the lock guarding the cache the first time it is called and count the calls after that. ]*/
+    /*Tests_SRS_X509_OPENSSL_02_021: [ If the cache is initialized, x509_openssl_add_certificates shall parse certificates only if they are not in the cache yet and add the cached certificates to the store of ssl_ctx. ]*/
+    /*Tests_SRS_X509_OPENSSL_02_028: [ When called as many times as x509_openssl_cache_init succeeded, x509_openssl_cache_deinit shall release every cached object and the lock. ]*/
+    TEST_FUNCTION(x509_openssl_add_certificates_with_cache_parses_the_certificates_once)
+    {
+        ///arrange
+        int result1;
+        int result2;
+
+        STRICT_EXPECTED_CALL(Lock_Init());
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_cache_init());
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_cache_init());
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((void*)TEST_CERTIFICATE_1, -1));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(ERR_peek_last_error());
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(SSL_CTX_get_cert_store(TEST_SSL_CTX));
+        STRICT_EXPECTED_CALL(X509_STORE_add_cert(TEST_X509_STORE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(SSL_CTX_get_cert_store(TEST_SSL_CTX));
+        STRICT_EXPECTED_CALL(X509_STORE_add_cert(TEST_X509_STORE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        STRICT_EXPECTED_CALL(X509_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        ///act
+        result1 = x509_openssl_add_certificates(TEST_SSL_CTX, TEST_CERTIFICATE_1);
+        result2 = x509_openssl_add_certificates(TEST_SSL_CTX, TEST_CERTIFICATE_1);
+        x509_openssl_cache_deinit();
+        x509_openssl_cache_deinit();
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result1);
+        ASSERT_ARE_EQUAL(int, 0, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///clean
+    }
+
 END_TEST_SUITE(x509_openssl_unittests)
 
 
@@ -53,6 +53,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
 MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_wait, CONCRETE_IO_HANDLE, handle, unsigned int, timeout_ms, IO_WAIT_INTEREST, interest)
+MOCK_FUNCTION_END(0)
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 /*this function will clone an option given by name and value*/
@@ -110,7 +112,21 @@ const IO_INTERFACE_DESCRIPTION test_io_description =
     test_xio_close,
     test_xio_send,
     test_xio_dowork,
-    test_xio_setoption
+    test_xio_setoption,
+    test_xio_wait
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_without_wait =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL
 };
 
 static TEST_MUTEX_HANDLE g_testByTest;
@@ -174,6 +190,7 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(IO_WAIT_INTEREST, int);
 
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
@@ -899,6 +916,104 @@ TEST_FUNCTION(xio_setoption_fails_when_concrete_xio_setoption_fails)
     xio_destroy(handle);
 }
 
+/* xio_wait */
+
+/* Tests_SRS_XIO_11_001: [If the xio argument is NULL, xio_wait shall return a non-zero value.] */
+TEST_FUNCTION(xio_wait_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = xio_wait(NULL, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_11_002: [If the concrete IO implementation does not provide concrete_io_wait, xio_wait shall return a non-zero value.] */
+TEST_FUNCTION(xio_wait_when_the_concrete_io_has_no_wait_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_without_wait, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_wait(handle, 100, IO_WAIT_READ);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_004: [If any io_interface_description member is NULL, xio_create shall return NULL.] */
+TEST_FUNCTION(xio_create_with_NULL_concrete_io_wait_succeeds)
+{
+    // arrange
+    XIO_HANDLE result;
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_xio_create(NULL));
+
+    // act
+    result = xio_create(&test_io_description_without_wait, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(result);
+}
+
+/* Tests_SRS_XIO_11_003: [xio_wait shall call the concrete_io_wait function specified in xio_create, passing the timeout_ms and interest arguments.] */
+/* Tests_SRS_XIO_11_004: [On success, xio_wait shall return 0.] */
+TEST_FUNCTION(xio_wait_calls_the_concrete_wait_and_succeeds)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_wait(TEST_CONCRETE_IO_HANDLE, 250, IO_WAIT_READ_WRITE));
+
+    // act
+    result = xio_wait(handle, 250, IO_WAIT_READ_WRITE);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_11_005: [If the underlying concrete_io_wait fails, xio_wait shall return a non-zero value.] */
+TEST_FUNCTION(xio_wait_fails_when_concrete_wait_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_wait(TEST_CONCRETE_IO_HANDLE, 0, IO_WAIT_WRITE))
+        .SetReturn(42);
+
+    // act
+    result = xio_wait(handle, 0, IO_WAIT_WRITE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
 /*Tests_SRS_XIO_02_001: [ If argument xio is NULL then xio_retrieveoptions shall fail and return NULL. ]*/
 TEST_FUNCTION(xio_retrieveoptions_with_NULL_xio_fails)
 {